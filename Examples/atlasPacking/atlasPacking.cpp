@@ -0,0 +1,115 @@
+#include "Core/AtlasAllocator.hpp"
+
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace LWGC;
+
+// Packing efficiency benchmark: no window or GPU needed, only the CPU side of the atlas allocator is tested
+
+static const int	AtlasSize = 4096;
+
+static std::vector< glm::ivec2 >	GenerateSprites(size_t count, unsigned seed)
+{
+	std::mt19937						rng(seed);
+	std::uniform_int_distribution< int >	small(8, 64);
+	std::uniform_int_distribution< int >	large(64, 256);
+	std::uniform_int_distribution< int >	kind(0, 9);
+	std::vector< glm::ivec2 >			sizes;
+
+	// Mostly small sprites with a few big ones, like a typical UI / particle atlas
+	for (size_t i = 0; i < count; i++)
+	{
+		if (kind(rng) == 0)
+			sizes.push_back(glm::ivec2(large(rng), large(rng)));
+		else
+			sizes.push_back(glm::ivec2(small(rng), small(rng)));
+	}
+
+	return sizes;
+}
+
+static double		ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+static void			PrintResult(const char * name, const AtlasAllocator & allocator, size_t failed, double ms)
+{
+	glm::ivec2	extent = allocator.GetUsedExtent();
+	float		boundsOccupancy = allocator.GetOccupancy() * AtlasSize * AtlasSize / std::max(1.0f, static_cast< float >(extent.x) * extent.y);
+
+	printf("%-28s %6zu placed %5zu failed  occupancy %5.1f%%  bounds occupancy %5.1f%%  free rects %5zu  %8.2f ms\n",
+		name, allocator.GetAllocationCount(), failed, allocator.GetOccupancy() * 100.0f, boundsOccupancy * 100.0f, allocator.GetFreeRectCount(), ms);
+}
+
+static size_t		CountFailed(const std::vector< uint32_t > & ids)
+{
+	size_t failed = 0;
+
+	for (uint32_t id : ids)
+		failed += (id == AtlasAllocator::InvalidId);
+
+	return failed;
+}
+
+static void			BenchmarkHeuristic(const char * name, AtlasAllocator::Heuristic heuristic, const std::vector< glm::ivec2 > & sprites)
+{
+	AtlasAllocator			arrival(AtlasSize, AtlasSize, 1, heuristic);
+	AtlasAllocator			batch(AtlasSize, AtlasSize, 1, heuristic);
+	std::vector< uint32_t >	ids;
+	std::string				label;
+
+	auto start = std::chrono::steady_clock::now();
+	for (const auto & size : sprites)
+		ids.push_back(arrival.Allocate(size.x, size.y));
+	label = std::string(name) + " (arrival)";
+	PrintResult(label.c_str(), arrival, CountFailed(ids), ElapsedMs(start));
+
+	start = std::chrono::steady_clock::now();
+	ids = batch.AllocateBatch(sprites);
+	label = std::string(name) + " (batch)";
+	PrintResult(label.c_str(), batch, CountFailed(ids), ElapsedMs(start));
+}
+
+static void			BenchmarkFragmentation(const std::vector< glm::ivec2 > & sprites)
+{
+	AtlasAllocator			allocator(AtlasSize, AtlasSize, 1);
+	std::vector< uint32_t >	ids = allocator.AllocateBatch(sprites);
+	std::mt19937			rng(42);
+	size_t					moves = 0;
+
+	// Free half of the sprites at random, then compact and refill the atlas
+	for (size_t i = 0; i < ids.size(); i++)
+		if (rng() % 2 == 0)
+			allocator.Deallocate(ids[i]);
+	PrintResult("after random free", allocator, 0, 0);
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t count; (count = allocator.Defragment(256).size()) != 0; )
+		moves += count;
+	PrintResult("after defragmentation", allocator, 0, ElapsedMs(start));
+	printf("%zu rects moved\n", moves);
+
+	start = std::chrono::steady_clock::now();
+	ids = allocator.AllocateBatch(GenerateSprites(sprites.size(), 1337));
+	PrintResult("refill", allocator, CountFailed(ids), ElapsedMs(start));
+}
+
+int			main(int ac, char **av)
+{
+	size_t	count = (ac > 1) ? std::strtoul(av[1], nullptr, 10) : 3000;
+	auto	sprites = GenerateSprites(count, 0);
+
+	printf("Packing %zu random sprites in a %dx%d atlas\n", count, AtlasSize, AtlasSize);
+
+	BenchmarkHeuristic("best short side fit", AtlasAllocator::Heuristic::BestShortSideFit, sprites);
+	BenchmarkHeuristic("best area fit", AtlasAllocator::Heuristic::BestAreaFit, sprites);
+	BenchmarkHeuristic("bottom left", AtlasAllocator::Heuristic::BottomLeft, sprites);
+
+	BenchmarkFragmentation(sprites);
+
+	return 0;
+}
@@ -48,7 +48,7 @@ Material *	CreateBackgroundMaterial(void)
 	return fullScreenMaterial;
 }
 
-int			main(void)
+int			main(int ac, char **av)
 {
 	Application		app;
 	EventSystem *	es = app.GetEventSystem();
@@ -59,6 +59,9 @@ int			main(void)
 	//Initialize application
 	app.Init();
 
+	// --profiler-capture=<path> records the profiler frames to a file
+	ProfilerCapture::ParseArguments(ac, av);
+
 	// We must Open the window before doing anything related to vulkan
 	app.Open("Test Window", 1920, 1200, WindowFlag::Resizable | WindowFlag::Decorated | WindowFlag::Focused);
 
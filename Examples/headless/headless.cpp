@@ -0,0 +1,65 @@
+#include "LWGC.hpp"
+
+#include <cstdlib>
+
+using namespace LWGC;
+
+// Renders frames without a window and streams them to a directory: headless [frameCount] [outputDirectory]
+// It runs on a software device too, e.g. with VK_ICD_FILENAMES pointing to the lavapipe ICD json
+
+static const int	Width = 640;
+static const int	Height = 360;
+
+int			main(int ac, char **av)
+{
+	Application		app;
+	Hierarchy *		hierarchy = app.GetHierarchy();
+	RenderPipeline *	pipeline = RenderPipelineManager::currentRenderPipeline;
+	int				frameCount = (ac > 1) ? atoi(av[1]) : 60;
+
+	ShaderSource::AddIncludePath("../../");
+
+	app.Init(AppCapability::Headless);
+
+	ProfilerCapture::ParseArguments(ac, av);
+
+	// Must be set before the pipeline is initialized
+	pipeline->SetFramesInFlight(3);
+	if (ac > 2)
+		pipeline->GetHeadlessOutput()->SetOutputDirectory(av[2]);
+	pipeline->GetHeadlessOutput()->SetCallback([](const HeadlessFrame & frame)
+	{
+		uint64_t	sum = 0;
+
+		for (size_t i = 0; i < static_cast< size_t >(frame.width) * frame.height * 4; i++)
+			sum += frame.pixels[i];
+		std::cout << "Frame " << frame.index << ": mean value " << (sum / (frame.width * frame.height * 4.0)) << std::endl;
+	});
+
+	app.Open("Headless", Width, Height, WindowFlag::Resizable);
+
+	auto	material = Material::Create(BuiltinShaders::Standard);
+	auto	texture = Texture2D::Create("Images/656218.jpg", VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+	auto	cube = new GameObject(new MeshRenderer(PrimitiveType::Cube, material));
+	auto	cam = new GameObject(new Camera());
+
+	material->SetTexture(TextureBinding::Albedo, texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+
+	cam->GetTransform()->SetPosition(glm::vec3(0, 0, -5));
+
+	hierarchy->AddGameObject(cube);
+	hierarchy->AddGameObject(cam);
+
+	for (int i = 0; app.ShouldNotQuit(); i++)
+	{
+		// Fixed step so the frames don't depend on the speed of the device
+		cube->GetTransform()->RotateAxis(2.0f * Math::DegToRad, glm::vec3(0, 1, 0));
+
+		if (i + 1 == frameCount)
+			app.Quit();
+		app.Update();
+	}
+
+	std::cout << pipeline->GetHeadlessOutput()->GetFrameCount() << " frames rendered" << std::endl;
+	return (0);
+}
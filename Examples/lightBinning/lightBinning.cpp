@@ -0,0 +1,117 @@
+#include "Core/Rendering/LightClusterBinning.hpp"
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+
+using namespace LWGC;
+
+// Bins random lights in front of a 60 degree camera on the calling thread and on a thread pool, checks that
+// both give the same lists and that every point of a light is in the list of its cluster, like a pixel would.
+
+static const size_t		RunCount = 20;
+
+static LightClusterGrid	CreateGrid(void)
+{
+	float				tanHalfFov = std::tan(glm::radians(60.0f) / 2.0f);
+	LightClusterGrid	grid;
+
+	grid.nearPlane = 0.1f;
+	grid.farPlane = 500.0f;
+	// The y of the projections is flipped for Vulkan
+	grid.projectionScale = glm::vec2(1.0f / (tanHalfFov * 16.0f / 9.0f), -1.0f / tanHalfFov);
+
+	return grid;
+}
+
+static double		MeasureBinning(LightClusterBinning & binning, const LightClusterGrid & grid, const std::vector< glm::vec4 > & lights, ThreadPool * workers)
+{
+	uint64_t start = Profiler::GetTime();
+
+	for (size_t i = 0; i < RunCount; i++)
+		binning.Bin(grid, lights, 0, workers);
+
+	return static_cast< double >(Profiler::GetTime() - start) / (RunCount * 1000000.0);
+}
+
+// Cluster of a view space point, computed like Common/ClusteredLighting.hlsl does from the pixel
+static uint32_t		GetPointCluster(const LightClusterGrid & grid, const glm::vec3 & point)
+{
+	glm::vec2	ndc = glm::vec2(point.x, point.y) * grid.projectionScale / point.z;
+	float		slice = std::log(std::max(point.z, grid.nearPlane) / grid.nearPlane) * LightClusterBinning::GetSliceScale(grid);
+	uint32_t	x = std::min(static_cast< uint32_t >((ndc.x * 0.5f + 0.5f) * LightClusterBinning::TilesX), LightClusterBinning::TilesX - 1);
+	uint32_t	y = std::min(static_cast< uint32_t >((ndc.y * 0.5f + 0.5f) * LightClusterBinning::TilesY), LightClusterBinning::TilesY - 1);
+
+	return LightClusterBinning::GetClusterIndex(x, y, std::min(static_cast< uint32_t >(slice), LightClusterBinning::Slices - 1));
+}
+
+static size_t		CountMissingLights(const LightClusterBinning & binning, const LightClusterGrid & grid, const std::vector< glm::vec4 > & lights, std::mt19937 & random)
+{
+	std::uniform_real_distribution< float >	offset(-0.57f, 0.57f);	// Stays in the sphere
+	size_t									missing = 0;
+
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		for (int sample = 0; sample < 16; sample++)
+		{
+			glm::vec3	point = glm::vec3(lights[i]) + glm::vec3(offset(random), offset(random), offset(random)) * lights[i].w;
+			glm::vec2	ndc = glm::vec2(point.x, point.y) * grid.projectionScale / point.z;
+
+			if (point.z <= grid.nearPlane || std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f)
+				continue ;
+
+			const LightCluster &	cluster = binning.GetClusters()[GetPointCluster(grid, point)];
+			const uint32_t *		indices = binning.GetLightIndices().data() + cluster.offset;
+
+			// Full clusters drop the lights after the limit
+			if (cluster.count < LightClusterBinning::MaxLightsPerCluster && std::find(indices, indices + cluster.count, i) == indices + cluster.count)
+				missing++;
+		}
+	}
+
+	return missing;
+}
+
+int			main(int ac, char **av)
+{
+	size_t					lightCount = (ac > 1) ? std::stoul(av[1]) : 10000;
+	std::mt19937			random(42);
+	std::uniform_real_distribution< float >	unit(0.0f, 1.0f);
+	std::vector< glm::vec4 >	lights;
+	LightClusterGrid		grid = CreateGrid();
+	LightClusterBinning		singleThread;
+	LightClusterBinning		multiThread;
+	ThreadPool				workers;
+
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		float depth = 1.0f + unit(random) * 300.0f;
+
+		lights.push_back(glm::vec4((unit(random) * 2 - 1) * depth, (unit(random) * 2 - 1) * depth * 0.6f, depth, 0.5f + unit(random) * 4.0f));
+	}
+
+	printf("%zu lights, %u clusters\n", lightCount, LightClusterBinning::ClusterCount);
+	printf("Calling thread:        %6.3f ms\n", MeasureBinning(singleThread, grid, lights, nullptr));
+	printf("%2zu workers:            %6.3f ms\n", workers.GetThreadCount(), MeasureBinning(multiThread, grid, lights, &workers));
+	printf("%zu light indices, %zu dropped\n", singleThread.GetLightIndices().size(), singleThread.GetDroppedLightCount());
+
+	if (singleThread.GetLightIndices() != multiThread.GetLightIndices())
+	{
+		printf("The lists of the workers are different\n");
+		return 1;
+	}
+
+	size_t missing = CountMissingLights(singleThread, grid, lights, random);
+	if (missing != 0)
+	{
+		printf("%zu points are not in the list of their cluster\n", missing);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "Core/MeshSimplifier.hpp"
+#include "Core/Profiler.hpp"
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+
+using namespace LWGC;
+
+// Simplifies a bumpy height field and checks that the triangle count reaches the target and that no triangle
+// was folded over: every triangle faces the same side as the surface under its center.
+
+static float		GetHeight(float u, float v)
+{
+	return 0.05f * std::sin(u * 12.0f) * std::cos(v * 9.0f) + 0.02f * std::sin((u + v) * 31.0f);
+}
+
+static glm::vec3	GetSurfaceNormal(float u, float v)
+{
+	float	du = 0.05f * 12.0f * std::cos(u * 12.0f) * std::cos(v * 9.0f) + 0.02f * 31.0f * std::cos((u + v) * 31.0f);
+	float	dv = -0.05f * 9.0f * std::sin(u * 12.0f) * std::sin(v * 9.0f) + 0.02f * 31.0f * std::cos((u + v) * 31.0f);
+
+	return glm::vec3(-du, 1.0f, -dv);
+}
+
+static void			CreateHeightField(size_t resolution, std::vector< glm::vec3 > & positions, std::vector< int > & indices)
+{
+	for (size_t z = 0; z <= resolution; z++)
+		for (size_t x = 0; x <= resolution; x++)
+		{
+			float	u = static_cast< float >(x) / resolution;
+			float	v = static_cast< float >(z) / resolution;
+
+			positions.push_back(glm::vec3(u, GetHeight(u, v), v));
+		}
+
+	for (size_t z = 0; z < resolution; z++)
+		for (size_t x = 0; x < resolution; x++)
+		{
+			int	i0 = static_cast< int >(z * (resolution + 1) + x);
+			int	i1 = i0 + 1;
+			int	i2 = i0 + static_cast< int >(resolution + 1);
+			int	i3 = i2 + 1;
+
+			// The cross product of the edges points up
+			indices.insert(indices.end(), {i0, i2, i1, i1, i2, i3});
+		}
+}
+
+static size_t		CountFlippedTriangles(const std::vector< glm::vec3 > & positions, const std::vector< int > & indices)
+{
+	size_t	flipped = 0;
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const glm::vec3 &	p0 = positions[indices[i + 0]];
+		const glm::vec3 &	p1 = positions[indices[i + 1]];
+		const glm::vec3 &	p2 = positions[indices[i + 2]];
+		glm::vec3			center = (p0 + p1 + p2) * (1.0f / 3.0f);
+
+		if (glm::dot(glm::cross(p1 - p0, p2 - p0), GetSurfaceNormal(center.x, center.z)) <= 0)
+			flipped++;
+	}
+
+	return flipped;
+}
+
+int			main(int ac, char **av)
+{
+	size_t					resolution = (ac > 1) ? std::stoul(av[1]) : 256;
+	std::vector< glm::vec3 >	positions;
+	std::vector< int >		indices;
+
+	CreateHeightField(resolution, positions, indices);
+
+	if (CountFlippedTriangles(positions, indices) != 0)
+	{
+		printf("The height field has folded triangles\n");
+		return 1;
+	}
+
+	size_t		triangleCount = indices.size() / 3;
+	size_t		targetIndexCount = (triangleCount / 10) * 3;
+	float		error = 0;
+	uint64_t	start = Profiler::GetTime();
+	auto		simplified = MeshSimplifier::Simplify(positions, indices, targetIndexCount, 1.0f, &error);
+	double		milliseconds = static_cast< double >(Profiler::GetTime() - start) / 1000000.0;
+
+	printf("%zu -> %zu triangles (target %zu) in %.3f ms, error %f\n", triangleCount, simplified.size() / 3, targetIndexCount / 3, milliseconds, error);
+
+	// The border is locked, the last pass can't always reach the exact target
+	if (simplified.size() > targetIndexCount + targetIndexCount / 10)
+	{
+		printf("The simplified mesh is over the target triangle count\n");
+		return 1;
+	}
+
+	size_t flipped = CountFlippedTriangles(positions, simplified);
+	if (flipped != 0)
+	{
+		printf("%zu triangles were flipped\n", flipped);
+		return 1;
+	}
+
+	std::vector< float >	errors;
+	auto					lods = MeshSimplifier::GenerateLODChain(positions, indices, 6, 0.5f, &errors);
+
+	for (size_t i = 0; i < lods.size(); i++)
+	{
+		printf("LOD %zu: %zu triangles, error %f\n", i, lods[i].size() / 3, errors[i]);
+
+		if (i > 0 && (lods[i].size() >= lods[i - 1].size() || errors[i] < errors[i - 1]))
+		{
+			printf("The LOD chain doesn't decrease\n");
+			return 1;
+		}
+		if (CountFlippedTriangles(positions, lods[i]) != 0)
+		{
+			printf("LOD %zu has flipped triangles\n", i);
+			return 1;
+		}
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "Core/Profiler.hpp"
+#include "Core/ProfilerCapture.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+using namespace LWGC;
+
+// Record the same simulated frames in both capture formats and convert the binary one, or just convert
+// a binary capture with: profilerCapture convert <capture.lwgcprof> <trace.json>
+
+static const size_t		WorkerCount = 3;
+static const size_t		JobsPerFrame = 200;
+
+static volatile uint64_t	sink;
+
+static void			Work(size_t iterations)
+{
+	for (size_t i = 0; i < iterations; i++)
+		sink = sink + i;
+}
+
+static void			Worker(std::atomic< uint64_t > & frame, std::atomic< bool > & stop, size_t index)
+{
+	uint64_t	lastFrame = 0;
+
+	Profiler::SetThreadName("Worker " + std::to_string(index));
+
+	while (!stop)
+	{
+		if (frame == lastFrame)
+		{
+			std::this_thread::yield();
+			continue ;
+		}
+		lastFrame = frame;
+
+		for (size_t i = 0; i < JobsPerFrame / WorkerCount; i++)
+		{
+			LWGC_PROFILE_SCOPE("Job");
+			Work(2000);
+		}
+	}
+}
+
+static void			RunFrames(size_t frameCount)
+{
+	std::atomic< uint64_t >		frame(0);
+	std::atomic< bool >			stop(false);
+	std::vector< std::thread >	workers;
+	ProfilerNameId				allocationName = Profiler::InternName("Streaming buffer");
+
+	for (size_t i = 0; i < WorkerCount; i++)
+		workers.emplace_back(Worker, std::ref(frame), std::ref(stop), i);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Profiler::BeginFrame();
+		frame++;
+
+		{
+			LWGC_PROFILE_SCOPE("Update");
+			Work(20000);
+			if (i % 30 == 0)
+				Profiler::RecordAllocation(allocationName, (i % 60 == 0) ? 4 << 20 : -(4 << 20));
+		}
+		{
+			LWGC_PROFILE_SCOPE("Render");
+			LWGC_PROFILE_SCOPE("Record commands");
+			Work(40000);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	stop = true;
+	for (auto & worker : workers)
+		worker.join();
+
+	// The last frame closes with the next marker
+	Profiler::BeginFrame();
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+static long			GetFileSize(const std::string & path)
+{
+	std::ifstream	file(path, std::ios::binary | std::ios::ate);
+
+	return file.is_open() ? static_cast< long >(file.tellg()) : -1;
+}
+
+int			main(int ac, char **av)
+{
+	if (ac == 4 && strcmp(av[1], "convert") == 0)
+	{
+		ProfilerCapture::ConvertToChromeTrace(av[2], av[3]);
+		return 0;
+	}
+
+	size_t		frameCount = (ac > 1) ? std::stoul(av[1]) : 500;
+
+	Profiler::Start();
+
+	const std::pair< std::string, ProfilerCaptureFormat >	captures[] = {
+		{"capture.json", ProfilerCaptureFormat::ChromeTrace},
+		{std::string("capture") + ProfilerCapture::BinaryExtension, ProfilerCaptureFormat::Binary},
+	};
+
+	for (const auto & capture : captures)
+	{
+		if (!ProfilerCapture::Start(capture.first, capture.second))
+			return 1;
+
+		RunFrames(frameCount);
+		ProfilerCapture::Stop();
+
+		printf("%-20s %8ld bytes, %llu frames, %llu lost\n", capture.first.c_str(), GetFileSize(capture.first), static_cast< unsigned long long >(ProfilerCapture::GetWrittenFrameCount()), static_cast< unsigned long long >(ProfilerCapture::GetLostFrameCount()));
+	}
+
+	ProfilerCapture::ConvertToChromeTrace(captures[1].first, "capture_converted.json");
+	printf("%-20s %8ld bytes\n", "capture_converted.json", GetFileSize("capture_converted.json"));
+
+	Profiler::Stop();
+
+	return 0;
+}
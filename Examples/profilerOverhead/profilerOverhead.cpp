@@ -0,0 +1,146 @@
+#include "Core/Profiler.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdio>
+#include <sys/time.h>
+
+using namespace LWGC;
+
+// Cost of a profiling scope: the previous implementation (gettimeofday, string hierarchy and a multimap
+// insertion per sample) against LWGC_PROFILE_SCOPE with the profiler stopped and running, on one and
+// several threads. The scopes are run in batches small enough for the ring buffers, with a pause between
+// batches to let the aggregation thread drain them like a frame would.
+
+static const size_t		BatchSize = 2000;	// Nested pairs, so 4000 scopes and 8000 events per batch
+static const size_t		BatchCount = 200;
+
+static volatile uint64_t	sink;
+
+static double		GetMilliseconds(void)
+{
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_usec / 1000.0 + (double)tv.tv_sec * 1000.0;
+}
+
+// Equivalent of the old ProfilingSample constructor and End
+static std::string											legacyHierarchy;
+static std::unordered_multimap< std::string, double >		legacySamples;
+
+static void			LegacyScope(const std::string & name)
+{
+	double start = GetMilliseconds();
+	legacyHierarchy += "/" + name;
+	sink = sink + 1;
+	legacySamples.emplace(legacyHierarchy, GetMilliseconds() - start);
+	legacyHierarchy = legacyHierarchy.substr(0, legacyHierarchy.size() - name.size() - 1);
+}
+
+static void			RunLegacyBatch(void)
+{
+	for (size_t i = 0; i < BatchSize; i++)
+	{
+		LegacyScope("Outer");
+		LegacyScope("Inner");
+	}
+	legacySamples.clear();
+}
+
+static void			RunBatch(void)
+{
+	for (size_t i = 0; i < BatchSize; i++)
+	{
+		LWGC_PROFILE_SCOPE("Outer");
+		{
+			LWGC_PROFILE_SCOPE("Inner");
+			sink = sink + 1;
+		}
+	}
+}
+
+static void			RunEmptyBatch(void)
+{
+	for (size_t i = 0; i < BatchSize; i++)
+	{
+		sink = sink + 1;
+	}
+}
+
+// Average nanoseconds per scope, the loop cost measured with RunEmptyBatch is removed
+static double		MeasureBatches(void (*batch)(void), bool beginFrames)
+{
+	uint64_t	total = 0;
+
+	for (size_t i = 0; i < BatchCount; i++)
+	{
+		if (beginFrames)
+			Profiler::BeginFrame();
+
+		uint64_t start = Profiler::GetTime();
+		batch();
+		total += Profiler::GetTime() - start;
+
+		if (beginFrames)
+			std::this_thread::sleep_for(std::chrono::milliseconds(3));
+	}
+
+	return static_cast< double >(total) / (BatchCount * BatchSize * 2);
+}
+
+static double		MeasureClock(uint64_t (*clock)(void))
+{
+	const size_t	count = 1000000;
+	uint64_t		start = Profiler::GetTime();
+
+	for (size_t i = 0; i < count; i++)
+		sink = sink + clock();
+
+	return static_cast< double >(Profiler::GetTime() - start) / count;
+}
+
+int			main(int ac, char **av)
+{
+	size_t		threadCount = (ac > 1) ? std::stoul(av[1]) : std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+#ifdef LWGC_PROFILER_TSC
+	printf("Timestamp (TSC):       %6.1f ns\n", MeasureClock(Profiler::GetTimestamp));
+#endif
+	printf("steady_clock:          %6.1f ns\n", MeasureClock(Profiler::GetTime));
+
+	double loop = MeasureBatches(RunEmptyBatch, false);
+	printf("Legacy ProfilingSample:%6.1f ns/scope\n", MeasureBatches(RunLegacyBatch, false) - loop);
+	printf("Profiler stopped:      %6.1f ns/scope\n", MeasureBatches(RunBatch, false) - loop);
+
+	Profiler::Start();
+
+	printf("Profiler running:      %6.1f ns/scope\n", MeasureBatches(RunBatch, true) - loop);
+
+	std::vector< std::thread >	threads;
+	std::vector< double >		results(threadCount);
+
+	for (size_t i = 0; i < threadCount; i++)
+		threads.emplace_back([&results, i](){ results[i] = MeasureBatches(RunBatch, true); });
+	for (auto & thread : threads)
+		thread.join();
+
+	double average = 0;
+	for (double result : results)
+		average += result / threadCount;
+	printf("Profiler, %2zu threads:  %6.1f ns/scope\n", threadCount, average - loop);
+
+	// Let the last frames be aggregated
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	ProfilerFrame	frame;
+	if (Profiler::GetLastFrame(frame))
+		printf("Last frame: %zu scopes, %zu threads, %llu dropped events\n", frame.scopes.size(), Profiler::GetThreadCount(), static_cast< unsigned long long >(Profiler::GetDroppedEventCount()));
+
+	Profiler::Stop();
+
+	return 0;
+}
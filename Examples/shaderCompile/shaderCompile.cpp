@@ -0,0 +1,209 @@
+#include "Core/Shaders/ShaderCompiler.hpp"
+#include "Core/Shaders/SpirVCache.hpp"
+#include "Utils/ThreadPool.hpp"
+#include "Utils/Utils.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace LWGC;
+
+// Cold compile benchmark of every shader in Shaders/: glslangValidator processes (the old ShaderSource path)
+// against the in-process compiler, sequential and on a thread pool, then with an empty and a filled SpirVCache.
+// Must be run from the root of the repository.
+
+struct		ShaderFile
+{
+	std::string				path;
+	VkShaderStageFlagBits	stage;
+};
+
+static double		ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+// The stage is guessed from the entry point, files without one are includes
+static bool			GuessStage(const std::string & path, VkShaderStageFlagBits & stage)
+{
+	std::ifstream		file(path);
+	std::stringstream	stream;
+
+	stream << file.rdbuf();
+	std::string source = stream.str();
+
+	if (source.find(" main(") == std::string::npos)
+		return false;
+
+	if (GetExtension(path) == "glsl")
+		stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV;
+	else if (source.find("numthreads") != std::string::npos)
+		stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	else if (source.find("FragmentInput main(") != std::string::npos)
+		stage = VK_SHADER_STAGE_VERTEX_BIT;
+	else
+		stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	return true;
+}
+
+static void			ListShaders(const std::string & directory, std::vector< ShaderFile > & shaders)
+{
+	DIR *			dir = opendir(directory.c_str());
+	struct dirent *	entry;
+
+	if (dir == nullptr)
+		return ;
+
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		std::string				name = entry->d_name;
+		std::string				path = directory + "/" + name;
+		VkShaderStageFlagBits	stage;
+
+		if (name[0] == '.')
+			continue ;
+
+		if (entry->d_type == DT_DIR)
+			ListShaders(path, shaders);
+		else if ((GetExtension(name) == "hlsl" || GetExtension(name) == "glsl") && GuessStage(path, stage))
+			shaders.push_back({path, stage});
+	}
+
+	closedir(dir);
+}
+
+static const char *	StageToText(VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+		case VK_SHADER_STAGE_VERTEX_BIT:			return "vert";
+		case VK_SHADER_STAGE_COMPUTE_BIT:			return "comp";
+		case VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV:	return "rchit";
+		default:									return "frag";
+	}
+}
+
+static void			BenchmarkProcesses(const std::vector< ShaderFile > & shaders)
+{
+	size_t		failed = 0;
+	std::string	output = "/tmp/LWGC_shaderCompile_" + std::to_string(getpid());
+
+	if (system("glslangValidator --version > /dev/null 2>&1") != 0)
+	{
+		printf("%-32s glslangValidator not found, skipped\n", "glslangValidator processes");
+		return ;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (const auto & shader : shaders)
+	{
+		std::string hlsl = (GetExtension(shader.path) == "hlsl") ? " -D" : "";
+		std::string cmd = "glslangValidator -e main -V" + hlsl + " -S " + StageToText(shader.stage) + " -I. " + shader.path + " -o " + output + " > /dev/null 2>&1";
+
+		failed += (system(cmd.c_str()) != 0);
+	}
+	printf("%-32s %3zu shaders %3zu failed %10.2f ms\n", "glslangValidator processes", shaders.size(), failed, ElapsedMs(start));
+
+	unlink(output.c_str());
+}
+
+static void			BenchmarkInProcess(const std::vector< ShaderFile > & shaders, ThreadPool * pool, bool printDiagnostics)
+{
+	std::vector< ShaderCompiler::Result >	results(shaders.size());
+	std::vector< std::string >				includePaths;
+	size_t									failed = 0;
+	size_t									spirVSize = 0;
+
+	auto compile = [&](size_t i)
+	{
+		results[i] = ShaderCompiler::Compile(shaders[i].path, shaders[i].stage, includePaths);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	if (pool != nullptr)
+		pool->ParallelFor(shaders.size(), compile);
+	else
+		for (size_t i = 0; i < shaders.size(); i++)
+			compile(i);
+	double ms = ElapsedMs(start);
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		failed += !results[i].success;
+		spirVSize += results[i].spirV.size() * sizeof(uint32_t);
+
+		if (printDiagnostics && !results[i].diagnostics.empty())
+			printf("%s", ShaderCompiler::FormatDiagnostics(results[i].diagnostics).c_str());
+	}
+
+	std::string label = (pool != nullptr) ? "in-process, " + std::to_string(pool->GetThreadCount() + 1) + " threads" : "in-process, sequential";
+	printf("%-32s %3zu shaders %3zu failed %10.2f ms  (%zu KB of SPIR-V)\n", label.c_str(), shaders.size(), failed, ms, spirVSize / 1024);
+}
+
+// Same path as ShaderSource::CompileSpirV without the reflection: preprocess, look up the cache, compile on a miss
+static void			BenchmarkCache(const std::vector< ShaderFile > & shaders, ThreadPool & pool, const char * label)
+{
+	std::vector< std::string >	includePaths;
+	std::vector< int >			hits(shaders.size(), 0);
+	size_t						hitCount = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	pool.ParallelFor(shaders.size(), [&](size_t i)
+	{
+		auto				preprocessed = ShaderCompiler::Preprocess(shaders[i].path, shaders[i].stage, includePaths);
+		uint64_t			key = SpirVCache::ComputeKey(preprocessed.preprocessedSource, {}, shaders[i].stage, ShaderCompiler::EntryPoint);
+		SpirVCache::Entry	entry = {{}, {{}, {}, 1, 1, 1}, {}};
+
+		if (SpirVCache::Load(key, entry))
+		{
+			hits[i] = 1;
+			return ;
+		}
+
+		auto result = ShaderCompiler::Compile(shaders[i].path, shaders[i].stage, includePaths);
+		if (result.success)
+			SpirVCache::Store(key, {result.spirV, entry.reflection, result.includedFiles});
+	});
+	double ms = ElapsedMs(start);
+
+	for (int hit : hits)
+		hitCount += hit;
+	printf("%-32s %3zu shaders %3zu cache hits %6.2f ms\n", label, shaders.size(), hitCount, ms);
+}
+
+int			main(int ac, char **av)
+{
+	std::string					directory = (ac > 1) ? av[1] : "Shaders";
+	std::vector< ShaderFile >	shaders;
+	ThreadPool					pool;
+
+	ListShaders(directory, shaders);
+
+	if (shaders.empty())
+	{
+		printf("No shader found in %s, run the benchmark from the root of the repository\n", directory.c_str());
+		return 1;
+	}
+
+	printf("Compiling %zu shaders from %s\n", shaders.size(), directory.c_str());
+
+	BenchmarkProcesses(shaders);
+	// The first in-process run also pays the glslang initialization
+	BenchmarkInProcess(shaders, nullptr, true);
+	BenchmarkInProcess(shaders, nullptr, false);
+	BenchmarkInProcess(shaders, &pool, false);
+
+	SpirVCache::SetDirectory("/tmp/LWGC_shaderCompile_cache");
+	SpirVCache::Clear();
+	BenchmarkCache(shaders, pool, "cache, cold");
+	BenchmarkCache(shaders, pool, "cache, warm");
+	SpirVCache::Clear();
+
+	return 0;
+}
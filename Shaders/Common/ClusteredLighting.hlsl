@@ -0,0 +1,76 @@
+#ifndef CLUSTERED_LIGHTING
+# define CLUSTERED_LIGHTING
+
+# include "UniformStructs.hlsl"
+# include "Shadows.hlsl"
+
+// Bound by the forward pipeline for each camera, see ClusteredLighting
+[[vk::binding(0, 6)]]
+ConstantBuffer< LWGC_LightClusters >	lightClusters;
+[[vk::binding(1, 6)]]
+StructuredBuffer< LWGC_Light >			lights;
+[[vk::binding(2, 6)]]
+StructuredBuffer< uint2 >				clusterLightRanges;	// x: offset in clusterLightIndices, y: light count
+[[vk::binding(3, 6)]]
+StructuredBuffer< uint >				clusterLightIndices;
+
+// positionCS is SV_Position: pixel coordinates and the reverse Z depth
+uint	GetClusterIndex(float4 positionCS)
+{
+	uint3	gridSize = lightClusters.gridSize.xyz;
+	float2	viewportUV = (positionCS.xy - lightClusters.viewport.xy) * lightClusters.viewport.zw;
+	uint2	tile = min(uint2(saturate(viewportUV) * gridSize.xy), gridSize.xy - 1);
+
+	// The projection maps the view depth z to (projection[2][2] * z + projection[3][2]) / z
+	float	depth = lightClusters.depthSlicing.w / (positionCS.z - lightClusters.depthSlicing.z);
+	float	slice = log(max(depth, lightClusters.depthSlicing.x) / lightClusters.depthSlicing.x) * lightClusters.depthSlicing.y;
+
+	// The last slice extends to the infinite
+	return (uint(min(slice, float(gridSize.z - 1))) * gridSize.y + tile.y) * gridSize.x + tile.x;
+}
+
+// Lambert diffuse of a light, with a smooth falloff to zero at its range
+float3	EvaluateLight(LWGC_Light light, float3 positionWS, float3 normalWS)
+{
+	uint	type = uint(light.color.a);
+	float3	toLight = -light.directionWS.xyz;
+	float	attenuation = 1;
+
+	if (type != LWGC_LIGHT_DIRECTIONAL)
+	{
+		float3	offset = light.positionWS.xyz - positionWS;
+		float	distanceSquare = max(dot(offset, offset), 1e-4);
+		float	rangeFactor = saturate(1 - distanceSquare / (light.positionWS.w * light.positionWS.w));
+
+		toLight = offset * rsqrt(distanceSquare);
+		attenuation = rangeFactor * rangeFactor / distanceSquare;
+
+		if (type == LWGC_LIGHT_SPOT)
+		{
+			float	spot = saturate((dot(-toLight, light.directionWS.xyz) - light.spotAngles.x) * light.spotAngles.y);
+			attenuation *= spot * spot;
+		}
+	}
+
+	return light.color.rgb * saturate(dot(normalWS, toLight)) * attenuation;
+}
+
+// Sum of the directional lights and of the lights in the cluster of the pixel
+float3	ComputeClusteredLighting(float4 positionCS, float3 positionWS, float3 normalWS)
+{
+	float3	lighting = 0;
+	uint2	range = clusterLightRanges[GetClusterIndex(positionCS)];
+
+	for (uint i = 0; i < lightClusters.lightCounts.x; i++)
+	{
+		float	shadow = (lights[i].directionWS.w > 0) ? ComputeDirectionalShadow(positionWS, normalWS) : 1;
+		lighting += EvaluateLight(lights[i], positionWS, normalWS) * shadow;
+	}
+
+	for (uint j = 0; j < range.y; j++)
+		lighting += EvaluateLight(lights[clusterLightIndices[range.x + j]], positionWS, normalWS);
+
+	return lighting;
+}
+
+#endif
@@ -15,6 +15,8 @@ struct	FragmentInput
 	[[vk::location(0)]] float4	positionWS : SV_Position;
 	[[vk::location(1)]] float3	normalOS : NORMAL;
 	[[vk::location(2)]] float2	uv : TEXCOORD0;
+	[[vk::location(3)]] float3	worldPosition : TEXCOORD1;
+	[[vk::location(4)]] float3	normalWS : TEXCOORD2;
 };
 
 #endif
@@ -0,0 +1,34 @@
+#ifndef SHADOWS
+# define SHADOWS
+
+# include "UniformGraphic.hlsl"
+
+// Bound by the forward pipeline for each camera, see ShadowMaps
+[[vk::binding(0, 7)]]
+ConstantBuffer< LWGC_Shadows >	shadows;
+[[vk::binding(1, 7)]]
+uniform Texture2D				shadowAtlas;
+
+// Visibility of the shadowed directional light, from the first cascade containing the point. 1 past the last one
+float	ComputeDirectionalShadow(float3 positionWS, float3 normalWS)
+{
+	for (uint i = 0; i < shadows.counts.x; i++)
+	{
+		float3	offset = positionWS - shadows.cascadeSpheres[i].xyz;
+
+		if (dot(offset, offset) > shadows.cascadeSpheres[i].w)
+			continue ;
+
+		// The receiver is moved along its normal, by more than a texel of the cascade
+		float3	biasedWS = positionWS + normalWS * shadows.cascadeBiases[i].x;
+		float4	positionCS = mul(float4(biasedWS, 1), shadows.cascadeViewProjections[i]);
+		float2	uv = clamp(positionCS.xy * 0.5 + 0.5, shadows.cascadeBiases[i].y, 1 - shadows.cascadeBiases[i].y);
+		float4	rect = shadows.cascadeRects[i];
+
+		return shadowAtlas.SampleCmpLevelZero(depthCompare, rect.xy + uv * rect.zw, positionCS.z);
+	}
+
+	return 1;
+}
+
+#endif
@@ -26,7 +26,7 @@ uniform SamplerState nearestRepeat;
 [[vk::binding(5, 3)]]
 uniform SamplerState anisotropicTrilinearClamp;
 [[vk::binding(6, 3)]]
-uniform SamplerState depthCompare;
+uniform SamplerComparisonState depthCompare;
 
 [[vk::binding(7, 3)]] uniform Texture2D 	albedoMap;
 [[vk::binding(8, 3)]] uniform Texture2D 	normalMap;
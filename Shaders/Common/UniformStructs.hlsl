@@ -4,15 +4,25 @@
 struct LWGC_PerFrame
 {
 	float3		time; // x: time, y: sin(time), z: deltaTime
-	uint		frameIndex;
+	uint		frameIndex; // frame in flight
+	uint		frameCount; // number of the frame, doesn't wrap with the frames in flight
 };
 
-struct LWGC_PerCamera
+# define LWGC_MAX_VIEWS	4
+
+struct LWGC_PerView
 {
 	float4x4	projection;
 	float4x4	view;
-	float4		positionWS;
-	float4		screenSize; // xy: screen size in pixel, zw: 1 / screenSize
+};
+
+struct LWGC_PerCamera
+{
+	float4x4		projection; // Same as views[0]
+	float4x4		view;
+	float4			positionWS;
+	float4			screenSize; // xy: viewport size in pixel, zw: 1 / screenSize
+	LWGC_PerView	views[LWGC_MAX_VIEWS]; // Indexed by SV_ViewID in multiview passes
 };
 
 struct LWGC_PerObject
@@ -25,6 +35,41 @@ struct LWGC_PerMaterial
 	float4		albedo;
 };
 
+# define LWGC_LIGHT_DIRECTIONAL	0
+# define LWGC_LIGHT_POINT		1
+# define LWGC_LIGHT_SPOT		2
+
+struct LWGC_Light
+{
+	float4		positionWS;		// w: range
+	float4		color;			// rgb: color * intensity, a: LWGC_LIGHT_* type
+	float4		directionWS;	// xyz: direction the light travels in, w: 1 for the directional light with shadows
+	float4		spotAngles;		// x: cos of the half outer angle, y: 1 / (cos of the half inner angle - x)
+};
+
+// The clusters of a camera: tiles of the viewport by slices of the view depth, growing exponentially
+struct LWGC_LightClusters
+{
+	float4x4	view;			// World to view space of the binning
+	uint4		gridSize;		// xyz: tiles and slices, w: max lights per cluster
+	uint4		lightCounts;	// x: directional lights, stored first, y: all lights
+	float4		depthSlicing;	// x: near plane, y: slices / log(far / near), zw: projection[2][2] and [3][2]
+	float4		viewport;		// xy: offset in pixels, zw: 1 / size in pixels
+	float4		projection;		// xy: projection[0][0] and [1][1], z: padding of the light bounds for the other views
+};
+
+# define LWGC_MAX_SHADOW_CASCADES	4
+
+// Cascades of the directional light with shadows, pages of the shadow atlas
+struct LWGC_Shadows
+{
+	float4x4	cascadeViewProjections[LWGC_MAX_SHADOW_CASCADES];	// World to the clip space of the cascades
+	float4		cascadeSpheres[LWGC_MAX_SHADOW_CASCADES];			// xyz: center, w: squared radius
+	float4		cascadeRects[LWGC_MAX_SHADOW_CASCADES];				// xy: offset in the atlas, zw: size, in uv
+	float4		cascadeBiases[LWGC_MAX_SHADOW_CASCADES];			// x: normal offset, y: uv border of the page
+	uint4		counts;												// x: cascades
+};
+
 struct LWGC_GizmoData
 {
 	float4	color;
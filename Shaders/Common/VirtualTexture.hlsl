@@ -0,0 +1,88 @@
+#ifndef VIRTUAL_TEXTURE
+# define VIRTUAL_TEXTURE
+
+# include "UniformGraphic.hlsl"
+
+// Matches VirtualTextureInfo in Sources/Core/Textures/VirtualTexture.hpp
+struct VirtualTextureInfo
+{
+	float4	size;			// xy: virtual size in pixels, zw: 1 / size
+	float4	tileInfo;		// x: tile size, y: border, z: padded tile size, w: mip count
+	float4	cacheInfo;		// xy: physical cache size in tiles, zw: 1 / physical cache size in pixels
+	uint4	feedbackInfo;	// x: words per feedback segment, y: feedback sample rate, z: page count, w: feedback segment of this frame
+	uint4	mipOffsets[4];	// index of the first page of each mip
+};
+
+[[vk::binding(0, 4)]]
+ConstantBuffer< VirtualTextureInfo >	vtInfo;
+// Entry: bits 0-11 cache slot x, 12-23 slot y, 24-30 mip of the mapped page, 31 valid
+[[vk::binding(1, 4)]]
+StructuredBuffer< uint >				vtPageTable;
+// One bit per page, one segment per frame in flight. Each frame in flight has its own vtInfo with the index of its segment
+[[vk::binding(2, 4)]]
+RWStructuredBuffer< uint >				vtFeedback;
+[[vk::binding(3, 4)]]
+uniform Texture2D						vtPhysicalCache;
+
+uint2	VirtualTextureMipSize(uint mip)
+{
+	return max(uint2(vtInfo.size.xy) >> mip, 1);
+}
+
+float	VirtualTextureMip(float2 uv)
+{
+	float2 dx = ddx(uv * vtInfo.size.xy);
+	float2 dy = ddy(uv * vtInfo.size.xy);
+
+	return clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0, vtInfo.tileInfo.w - 1);
+}
+
+uint	VirtualTexturePageIndex(float2 uv, uint mip)
+{
+	uint	tileSize = (uint)vtInfo.tileInfo.x;
+	uint2	mipSize = VirtualTextureMipSize(mip);
+	uint2	pages = (mipSize + tileSize - 1) / tileSize;
+	uint2	page = min(uint2(uv * mipSize) / tileSize, pages - 1);
+
+	return vtInfo.mipOffsets[mip / 4][mip % 4] + page.y * pages.x + page.x;
+}
+
+// Only one pixel out of rate * rate writes its page, the pattern moves every frame to cover the screen
+void	WriteVirtualTextureFeedback(uint pageIndex, uint2 pixel)
+{
+	uint	rate = vtInfo.feedbackInfo.y;
+	uint2	pattern = uint2(frame.frameCount % rate, (frame.frameCount / rate) % rate);
+
+	if (any(pixel % rate != pattern))
+		return ;
+
+	uint word = vtInfo.feedbackInfo.w * vtInfo.feedbackInfo.x + pageIndex / 32;
+	InterlockedOr(vtFeedback[word], 1u << (pageIndex % 32));
+}
+
+float4	SampleVirtualTexture(float2 uv, uint2 pixel)
+{
+	uv = saturate(uv);
+
+	uint	mip = (uint)VirtualTextureMip(uv);
+	uint	pageIndex = VirtualTexturePageIndex(uv, mip);
+
+	WriteVirtualTextureFeedback(pageIndex, pixel);
+
+	uint entry = vtPageTable[pageIndex];
+	if ((entry & 0x80000000) == 0)
+		return float4(0, 0, 0, 1);
+
+	// The entry may point to a coarser resident mip, the tile is found again in this mip
+	uint2	slot = uint2(entry & 0xFFF, (entry >> 12) & 0xFFF);
+	uint	residentMip = (entry >> 24) & 0x7F;
+	float	tileSize = vtInfo.tileInfo.x;
+	uint2	mipSize = VirtualTextureMipSize(residentMip);
+	float2	texel = uv * mipSize;
+	float2	page = min(floor(texel / tileSize), float2((mipSize + (uint)tileSize - 1) / (uint)tileSize) - 1);
+	float2	cachePixel = slot * vtInfo.tileInfo.z + vtInfo.tileInfo.y + (texel - page * tileSize);
+
+	return vtPhysicalCache.SampleLevel(trilinearClamp, cachePixel * vtInfo.cacheInfo.zw, 0);
+}
+
+#endif
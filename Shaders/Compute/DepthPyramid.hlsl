@@ -0,0 +1,42 @@
+#include "Shaders/Common/InputCompute.hlsl"
+
+// One level of the depth pyramid of OcclusionCulling: each texel keeps the farthest depth of the 2x2 texels
+// of the previous level, the ones past the edge of an odd level are clamped. The level 0 is the copy of the
+// depth attachment, the levels follow each other in the buffer.
+[[vk::binding(0, 0)]]
+RWStructuredBuffer< float >	pyramid;
+
+struct DepthPyramidConstants
+{
+	uint4	source;			// xy: size, z: offset, w: 1 when the depths are 24 bit normalized values
+	uint4	destination;	// xy: size, z: offset
+};
+
+[[vk::push_constant]]
+DepthPyramidConstants	level;
+
+float	LoadDepth(uint2 texel)
+{
+	float	depth = pyramid[level.source.z + texel.y * level.source.x + texel.x];
+
+	if (level.source.w != 0)
+		depth = float(asuint(depth) & 0xFFFFFF) / 16777215.0;
+
+	return depth;
+}
+
+// Must match OcclusionCulling::GroupSize
+[numthreads(8, 8, 1)]
+void main(ComputeInput input)
+{
+	uint2	texel = input.dispatchThreadId.xy;
+
+	if (any(texel >= level.destination.xy))
+		return ;
+
+	uint2	first = texel * 2;
+	uint2	last = min(first + 1, level.source.xy - 1);
+	float	depth = min(min(LoadDepth(first), LoadDepth(uint2(last.x, first.y))), min(LoadDepth(uint2(first.x, last.y)), LoadDepth(last)));
+
+	pyramid[level.destination.z + texel.y * level.destination.x + texel.x] = depth;
+}
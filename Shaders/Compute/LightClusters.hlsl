@@ -0,0 +1,63 @@
+#include "Shaders/Common/InputCompute.hlsl"
+#include "Shaders/Common/UniformStructs.hlsl"
+
+// GPU version of LightClusterBinning: one thread per cluster tests all the lights against its view space
+// box. The lists have a fixed place of gridSize.w lights per cluster instead of being packed.
+[[vk::binding(0, 0)]]
+ConstantBuffer< LWGC_LightClusters >	lightClusters;
+[[vk::binding(1, 0)]]
+StructuredBuffer< LWGC_Light >			lights;
+[[vk::binding(2, 0)]]
+RWStructuredBuffer< uint2 >				clusterLightRanges;
+[[vk::binding(3, 0)]]
+RWStructuredBuffer< uint >				clusterLightIndices;
+
+float	GetSliceDepth(uint slice)
+{
+	return lightClusters.depthSlicing.x * exp(slice / lightClusters.depthSlicing.y);
+}
+
+// View space range of a tile boundary between the depths of the slice
+void	ExtendBounds(float ndc, float scale, float2 depths, inout float minValue, inout float maxValue)
+{
+	float2 values = ndc * depths / scale;
+
+	minValue = min(minValue, min(values.x, values.y));
+	maxValue = max(maxValue, max(values.x, values.y));
+}
+
+// Must match LightClusterBinning::TilesX and TilesY
+[numthreads(16, 9, 1)]
+void main(ComputeInput input)
+{
+	uint3	cluster = input.dispatchThreadId;
+	uint3	gridSize = lightClusters.gridSize.xyz;
+	uint	clusterIndex = (cluster.z * gridSize.y + cluster.y) * gridSize.x + cluster.x;
+	uint	offset = clusterIndex * lightClusters.gridSize.w;
+	uint	count = 0;
+
+	// The last slice extends to the infinite
+	float2	depths = float2(GetSliceDepth(cluster.z), (cluster.z + 1 == gridSize.z) ? 1e30 : GetSliceDepth(cluster.z + 1));
+	float2	ndcMin = (float2(cluster.xy) / gridSize.xy) * 2 - 1;
+	float2	ndcMax = (float2(cluster.xy + 1) / gridSize.xy) * 2 - 1;
+	float3	boxMin = float3(1e30, 1e30, depths.x);
+	float3	boxMax = float3(-1e30, -1e30, depths.y);
+
+	ExtendBounds(ndcMin.x, lightClusters.projection.x, depths, boxMin.x, boxMax.x);
+	ExtendBounds(ndcMax.x, lightClusters.projection.x, depths, boxMin.x, boxMax.x);
+	ExtendBounds(ndcMin.y, lightClusters.projection.y, depths, boxMin.y, boxMax.y);
+	ExtendBounds(ndcMax.y, lightClusters.projection.y, depths, boxMin.y, boxMax.y);
+
+	for (uint i = lightClusters.lightCounts.x; i < lightClusters.lightCounts.y && count < lightClusters.gridSize.w; i++)
+	{
+		float3	center = mul(float4(lights[i].positionWS.xyz, 1), lightClusters.view).xyz;
+		float	radius = lights[i].positionWS.w + lightClusters.projection.z;
+		float3	closest = clamp(center, boxMin, boxMax);
+		float3	offsetToBox = closest - center;
+
+		if (dot(offsetToBox, offsetToBox) <= radius * radius)
+			clusterLightIndices[offset + count++] = i;
+	}
+
+	clusterLightRanges[clusterIndex] = uint2(offset, count);
+}
@@ -1,6 +1,8 @@
 #include "Shaders/Common/UniformGraphic.hlsl"
 #include "Shaders/Common/InputGraphic.hlsl"
 
+#pragma keywords COLOR_UV
+
 struct FragmentOutput
 {
 	[[vk::location(0)]] float4	color : SV_Target0;
@@ -10,7 +12,11 @@ FragmentOutput main(FragmentInput i)
 {
 	FragmentOutput	o;
 
+#ifdef COLOR_UV
+	o.color = float4(i.uv, 0, 1);
+#else
 	o.color = float4(i.normalOS * 0.5 + 0.5, 1);
+#endif
 
 	return o;
 }
@@ -0,0 +1,36 @@
+#include "Shaders/Common/UniformGraphic.hlsl"
+#include "Shaders/Common/InputGraphic.hlsl"
+#include "Shaders/Common/Utils.hlsl"
+
+struct FragmentOutput
+{
+	[[vk::location(0)]] float4	color : SV_Target0;
+};
+
+// Matches AtlasEntryData in Sources/Core/Textures/MultiPageAtlas.hpp
+struct AtlasEntry
+{
+	float4	sizeOffset;
+	float4	page; // x: layer of the texture array
+};
+
+[vk::binding(0, 4)]
+StructuredBuffer< AtlasEntry >	atlasEntries;
+[vk::binding(1, 4)]
+uniform Texture2DArray			atlasTexture;
+
+FragmentOutput main(FragmentInput i)
+{
+	FragmentOutput	o;
+	uint			count;
+	uint			stride;
+
+	// Cycle through the atlas entries every second
+	atlasEntries.GetDimensions(count, stride);
+	AtlasEntry entry = atlasEntries[(uint)frame.time.x % count];
+
+	float2 atlasUVs = UvToAtlas(i.uv, entry.sizeOffset);
+	o.color = atlasTexture.Sample(trilinearClamp, float3(atlasUVs, entry.page.x));
+
+	return o;
+}
@@ -0,0 +1,17 @@
+#include "Shaders/Common/UniformGraphic.hlsl"
+#include "Shaders/Common/InputGraphic.hlsl"
+#include "Shaders/Common/VirtualTexture.hlsl"
+
+struct FragmentOutput
+{
+	[[vk::location(0)]] float4	color : SV_Target0;
+};
+
+FragmentOutput main(FragmentInput i)
+{
+	FragmentOutput	o;
+
+	o.color = SampleVirtualTexture(i.uv, uint2(i.positionWS.xy));
+
+	return o;
+}
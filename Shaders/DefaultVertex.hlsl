@@ -1,14 +1,19 @@
 #include "Shaders/Common/UniformGraphic.hlsl"
 #include "Shaders/Common/InputGraphic.hlsl"
 
-FragmentInput main(VertexInput i, int id : SV_VertexID, int elementID : SV_InstanceID)
+FragmentInput main(VertexInput i, int id : SV_VertexID, int elementID : SV_InstanceID, uint viewID : SV_ViewID)
 {
 	FragmentInput	o;
+	LWGC_PerView	cameraView = camera.views[viewID];
 
     o.uv = i.uv;
-	float4x4 mvp = camera.projection * camera.view * object.model;
-	o.positionWS = mul(float4(i.position.xyz, 1), mvp);
+	// Same operations as DepthPrepassVertex.hlsl, precise so the compiler can't reorder or fuse them differently
+	precise float4x4 mvp = cameraView.projection * cameraView.view * object.model;
+	precise float4 position = mul(float4(i.position.xyz, 1), mvp);
+	o.positionWS = position;
 	o.normalOS = i.normal;
+	o.worldPosition = mul(float4(i.position.xyz, 1), object.model).xyz;
+	o.normalWS = normalize(mul(float4(i.normal, 0), object.model).xyz);
 
 	return o;
 }
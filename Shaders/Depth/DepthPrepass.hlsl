@@ -0,0 +1,5 @@
+// The depth prepass only writes the depth
+
+void main()
+{
+}
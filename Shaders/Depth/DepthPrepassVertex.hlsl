@@ -0,0 +1,19 @@
+#include "Shaders/Common/UniformGraphic.hlsl"
+
+// Depth of the opaque renderers before they are shaded, see ForwardRenderPipeline::SetDepthPrepass. The
+// position is computed with the same precise operations as DefaultVertex.hlsl so the shaded pass finds the
+// exact same depth
+
+struct VertexInput
+{
+	[[vk::location(0)]] float3	position;
+};
+
+float4 main(VertexInput i, uint viewID : SV_ViewID) : SV_Position
+{
+	LWGC_PerView	cameraView = camera.views[viewID];
+
+	precise float4x4 mvp = cameraView.projection * cameraView.view * object.model;
+	precise float4 position = mul(float4(i.position.xyz, 1), mvp);
+	return position;
+}
@@ -0,0 +1,18 @@
+#include "Shaders/Common/UniformGraphic.hlsl"
+#include "Shaders/Common/InputGraphic.hlsl"
+#include "Shaders/Common/ClusteredLighting.hlsl"
+
+struct FragmentOutput
+{
+	[[vk::location(0)]] float4	color : SV_Target0;
+};
+
+FragmentOutput main(FragmentInput i)
+{
+	FragmentOutput	o;
+	float3			normalWS = normalize(i.normalWS);
+
+	o.color = float4(material.albedo.rgb * ComputeClusteredLighting(i.positionWS, i.worldPosition, normalWS), material.albedo.a);
+
+	return o;
+}
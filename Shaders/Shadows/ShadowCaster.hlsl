@@ -0,0 +1,5 @@
+// The shadow casters only write their depth
+
+void main()
+{
+}
@@ -0,0 +1,24 @@
+#include "Shaders/Common/UniformStructs.hlsl"
+
+// Depth of the shadow casters in a page of the shadow atlas, see ShadowMaps
+
+[[vk::binding(0, 2)]]
+ConstantBuffer< LWGC_PerObject > object;
+
+struct ShadowCasterConstants
+{
+	float4x4	lightViewProjection;
+};
+
+[[vk::push_constant]]
+ShadowCasterConstants	caster;
+
+struct VertexInput
+{
+	[[vk::location(0)]] float3	position;
+};
+
+float4 main(VertexInput i) : SV_Position
+{
+	return mul(mul(float4(i.position, 1), object.model), caster.lightViewProjection);
+}
@@ -1,4 +1,5 @@
 #include <memory>
+#include <algorithm>
 #include <unistd.h>
 
 #include "Core/Application.hpp"
@@ -9,6 +10,7 @@
 #include "IncludeDeps.hpp"
 #include "Core/Vulkan/ProfilingSample.hpp"
 #include "Core/Profiler.hpp"
+#include "Core/ProfilerCapture.hpp"
 
 // Volk function definitions + init
 #include VOLK_SOURCE
@@ -19,7 +21,7 @@ Application *				Application::_app = nullptr;
 Delegate< void(void) >		Application::update;
 Delegate< void(void) >		Application::lateUpdate;
 
-Application::Application(bool initDeafultRenderPipeline) : _window(nullptr), hierarchy(std::make_shared< Hierarchy >()), _shouldNotQuit(true)
+Application::Application(bool initDeafultRenderPipeline) : _window(nullptr), hierarchy(std::make_shared< Hierarchy >()), _shouldNotQuit(true), _headless(false)
 {
 	if (initDeafultRenderPipeline)
 	{
@@ -30,6 +32,10 @@ Application::Application(bool initDeafultRenderPipeline) : _window(nullptr), hie
 
 Application::~Application(void)
 {
+	// Writes the last frames before the profiler stops
+	ProfilerCapture::Stop();
+	Profiler::Stop();
+
 	_materialTable.DestroyObjects();
 	_textureTable.DestroyObjects();
 	Vk::Release();
@@ -52,17 +58,27 @@ void			ErrorCallback(int err, const char * description)
 
 void			Application::Init(const AppCapability capabilities) noexcept
 {
-	glfwSetErrorCallback(ErrorCallback);
-	glfwInit();
+	Profiler::Start();
+
+	_headless = (int)capabilities & (int)AppCapability::Headless;
+
+	// GLFW needs a display, a headless application doesn't use it at all
+	if (!_headless)
+	{
+		glfwSetErrorCallback(ErrorCallback);
+		glfwInit();
+	}
 
 	Vk::CheckResult(volkInitialize(), "Can't initialize volk");
 
 	std::vector< std::string > deviceExtensions = {
 		VK_EXT_DEBUG_MARKER_EXTENSION_NAME, // TODO: enable the extension in the vulkan layer
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME
 	};
 
+	if (!_headless)
+		deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
 	std::vector< std::string > instanceExtensions = {
 		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
 		// VK_EXT_DEBUG_REPORT_EXTENSION_NAME, // TODO
@@ -84,6 +100,7 @@ void			Application::Init(const AppCapability capabilities) noexcept
 	_instance.SetDeviceExtensions(deviceExtensions);
 	_instance.SetInstanceExtensions(instanceExtensions);
 	_instance.SetApplicationName("LWGC"); // This should be the application name but for the moment we'll keep it like this
+	_instance.SetHeadless(_headless);
 
 	_instance.Initialize();
 }
@@ -95,7 +112,10 @@ bool			Application::ShouldNotQuit(void) const noexcept
 
 void			Application::Quit(void) noexcept
 {
-	glfwSetWindowShouldClose(_window, true);
+	if (_headless)
+		_shouldNotQuit = false;
+	else
+		glfwSetWindowShouldClose(_window, true);
 }
 
 void		Application::FramebufferResizeCallback(GLFWwindow *window, int width, int height)
@@ -141,16 +161,45 @@ void			Application::UpdateRenderPipeline(void)
 				// _materialTable.RecreateAll();
 
 			// TODO: Recreate ImGUI materials too
-			_imGUI.UpdatePipelineDependentDatas();
+			if (!_headless)
+			{
+				_imGUI.UpdatePipelineDependentDatas();
+				glfwSetWindowUserPointer(_window, currentPipe);
+			}
 
-			glfwSetWindowUserPointer(_window, currentPipe);
 			lastFramePipeline = currentPipe;
 		}
 	}
 }
 
+void			Application::OpenHeadless(const int width, const int height) noexcept
+{
+	auto		pipeline = RenderPipelineManager::currentRenderPipeline;
+	uint32_t	imageCount = (pipeline != nullptr) ? pipeline->GetFramesInFlight() : RenderPipeline::DefaultFramesInFlight;
+
+	try {
+		_instance.InitializeHeadless();
+		// One image per frame in flight, so a frame never waits for another one to be read back
+		_swapChain.InitializeHeadless(width, height, std::max(imageCount, 1u));
+
+		Vk::Initialize();
+		Time::Initialize();
+
+		hierarchy->Initialize();
+	} catch (const std::runtime_error & e) {
+		std::cout << "Error while initializing the headless render pipeline:" << std::endl << e.what() << std::endl;
+		exit(-1);
+	}
+}
+
 void			Application::Open(const std::string & name, const int width, const int height, const WindowFlag flags) noexcept
 {
+	if (_headless)
+	{
+		OpenHeadless(width, height);
+		return ;
+	}
+
 	if (!glfwVulkanSupported())
 	{
 		std::cout << "Vulkan is not supported :(" << std::endl << "exiting..." << std::endl;
@@ -196,30 +245,43 @@ void			Application::Open(const std::string & name, const int width, const int he
 
 void				Application::Update(void) noexcept
 {
+	Profiler::BeginFrame();
+
 	UpdateRenderPipeline();
 
-	glfwPollEvents();
+	if (RenderPipelineManager::currentRenderPipeline != nullptr)
+		RenderPipelineManager::currentRenderPipeline->WaitForNextFrame();
+
+	if (!_headless)
+		glfwPollEvents();
+	if (RenderPipelineManager::currentRenderPipeline != nullptr)
+		RenderPipelineManager::currentRenderPipeline->_inputTime = Profiler::GetTime();
 	Time::BeginFrame();
-	Application::update.Invoke();
-	Application::lateUpdate.Invoke();
+	{
+		LWGC_PROFILE_SCOPE("Update");
+		_textureStreamer.Update();
+		Application::update.Invoke();
+		Application::lateUpdate.Invoke();
+	}
 
 	//TODO: hierarchy get cameras
 	const auto cameras = hierarchy->GetCameras();
 
 	auto currentPipe = RenderPipelineManager::currentRenderPipeline;
 
-	Profiler::Reset();
-
 	if (currentPipe != nullptr)
 	{
-		auto sample = ProfilingSample("Frame");
+		auto sample = ProfilingSample("Render");
 
 		// If rendering was successful, we can draw the GUI and present the frame
 		if (currentPipe->RenderInternal(cameras, hierarchy->GetRenderContext()))
 		{
-			_imGUI.BeginFrame();
-			currentPipe->RenderGUI(hierarchy->GetRenderContext());
-			_imGUI.EndFrame();
+			if (!_headless)
+			{
+				_imGUI.BeginFrame();
+				currentPipe->RenderGUI(hierarchy->GetRenderContext());
+				_imGUI.EndFrame();
+			}
 
 			currentPipe->PresentFrame();
 		}
@@ -227,7 +289,16 @@ void				Application::Update(void) noexcept
 	else // When there is no pipeline graphic, we limit the application framerate to 60
 		usleep((1.0f / 60.0f) * 1000000.0f);
 
-	_shouldNotQuit = !glfwWindowShouldClose(_window);
+	if (!_headless)
+		_shouldNotQuit = !glfwWindowShouldClose(_window);
+
+	// The last frames are still in flight, they're delivered before the application stops
+	if (!_shouldNotQuit && currentPipe != nullptr && currentPipe->IsInitialized())
+	{
+		currentPipe->GetReadbackManager()->Flush();
+		if (_headless)
+			currentPipe->GetHeadlessOutput()->Flush();
+	}
 }
 
 SwapChain *			Application::GetSwapChain(void) noexcept { return &this->_swapChain; }
@@ -235,6 +306,8 @@ EventSystem *		Application::GetEventSystem(void) noexcept { return &this->_event
 Hierarchy *			Application::GetHierarchy(void) noexcept { return this->hierarchy.get(); }
 MaterialTable *		Application::GetMaterialTable(void) noexcept { return &this->_materialTable; }
 TextureTable *		Application::GetTextureTable(void) noexcept { return &this->_textureTable; }
+TextureStreamer *	Application::GetTextureStreamer(void) noexcept { return &this->_textureStreamer; }
+bool				Application::IsHeadless(void) const noexcept { return this->_headless; }
 
 Application *	Application::Get(void) noexcept { return _app; }
 
@@ -20,6 +20,7 @@
 #include "Core/Textures/TextureTable.hpp"
 #include "Core/Textures/Texture2D.hpp"
 #include "Core/Textures/Texture2DArray.hpp"
+#include "Core/Textures/TextureStreamer.hpp"
 #include "Core/Rendering/RenderPipelineManager.hpp"
 
 #include VULKAN_INCLUDE
@@ -32,6 +33,7 @@ namespace LWGC
 		Default				= 0x000,
 		RayTracing			= 0x001,
 		CooperativeMatrices	= 0x002,
+		Headless			= 0x004,	// No window nor GLFW, the frames are read back from offscreen images, see RenderPipeline::GetHeadlessOutput
 	};
 
 	class		Application
@@ -49,9 +51,12 @@ namespace LWGC
 			ImGUIWrapper						_imGUI;
 			MaterialTable						_materialTable;
 			TextureTable						_textureTable;
+			TextureStreamer						_textureStreamer;
 			bool								_shouldNotQuit;
+			bool								_headless;
 
 			void		UpdateRenderPipeline(void);
+			void		OpenHeadless(const int width, const int height) noexcept;
 
 			static void	FramebufferResizeCallback(GLFWwindow *window, int width, int height);
 
@@ -65,14 +70,17 @@ namespace LWGC
 			void	Init(const AppCapability capabilities = AppCapability::Default) noexcept;
 			bool	ShouldNotQuit(void) const noexcept;
 			void	Quit(void) noexcept;
+			// When headless, only the size is used and the frames in flight of the current pipeline are the image count
 			void	Open(const std::string & name, const int width, const int height, const WindowFlag flags) noexcept;
 			void	Update(void) noexcept;
+			bool	IsHeadless(void) const noexcept;
 
 			SwapChain *			GetSwapChain(void) noexcept;
 			EventSystem *		GetEventSystem(void) noexcept;
 			Hierarchy *			GetHierarchy(void) noexcept;
 			MaterialTable *		GetMaterialTable(void) noexcept;
 			TextureTable *		GetTextureTable(void) noexcept;
+			TextureStreamer *	GetTextureStreamer(void) noexcept;
 
 			static Application *		Get(void) noexcept;
 
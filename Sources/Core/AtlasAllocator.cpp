@@ -0,0 +1,357 @@
+#include "AtlasAllocator.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+using namespace LWGC;
+
+static bool		Intersects(const AtlasRect & a, const AtlasRect & b) noexcept
+{
+	return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static bool		Contains(const AtlasRect & a, const AtlasRect & b) noexcept
+{
+	return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+}
+
+// Lower is better, the second score breaks ties
+static void		ScorePosition(const AtlasRect & freeRect, int width, int height, AtlasAllocator::Heuristic heuristic, int & score, int & secondScore) noexcept
+{
+	int leftoverX = freeRect.width - width;
+	int leftoverY = freeRect.height - height;
+
+	switch (heuristic)
+	{
+		case AtlasAllocator::Heuristic::BestAreaFit:
+			score = freeRect.width * freeRect.height - width * height;
+			secondScore = std::min(leftoverX, leftoverY);
+			break ;
+		case AtlasAllocator::Heuristic::BottomLeft:
+			score = freeRect.y + height;
+			secondScore = freeRect.x;
+			break ;
+		default:
+			score = std::min(leftoverX, leftoverY);
+			secondScore = std::max(leftoverX, leftoverY);
+			break ;
+	}
+}
+
+AtlasAllocator::AtlasAllocator(int width, int height, int padding, Heuristic heuristic) :
+	_width(width), _height(height), _padding(padding), _heuristic(heuristic), _allocationCount(0), _usedArea(0)
+{
+	if (width <= 0 || height <= 0 || padding < 0)
+		throw std::runtime_error("Invalid atlas size: " + std::to_string(width) + "x" + std::to_string(height));
+
+	Clear();
+}
+
+bool			AtlasAllocator::FindPosition(int width, int height, Heuristic heuristic, AtlasRect & result) const noexcept
+{
+	int		bestScore = std::numeric_limits< int >::max();
+	int		bestSecondScore = std::numeric_limits< int >::max();
+
+	for (const auto & freeRect : _freeRects)
+	{
+		int		score;
+		int		secondScore;
+
+		if (freeRect.width < width || freeRect.height < height)
+			continue ;
+
+		ScorePosition(freeRect, width, height, heuristic, score, secondScore);
+
+		if (score < bestScore || (score == bestScore && secondScore < bestSecondScore))
+		{
+			bestScore = score;
+			bestSecondScore = secondScore;
+			result = {freeRect.x, freeRect.y, width, height};
+		}
+	}
+
+	return bestScore != std::numeric_limits< int >::max();
+}
+
+void			AtlasAllocator::PlaceRect(const AtlasRect & used)
+{
+	size_t	count = _freeRects.size();
+	size_t	i = 0;
+
+	// Split every free rect intersecting the new one in up to 4 maximal rects, the new ones are appended
+	while (i < count)
+	{
+		AtlasRect	freeRect = _freeRects[i];
+
+		if (!Intersects(freeRect, used))
+		{
+			i++;
+			continue ;
+		}
+
+		if (used.y > freeRect.y)
+			_freeRects.push_back({freeRect.x, freeRect.y, freeRect.width, used.y - freeRect.y});
+		if (used.y + used.height < freeRect.y + freeRect.height)
+			_freeRects.push_back({freeRect.x, used.y + used.height, freeRect.width, freeRect.y + freeRect.height - used.y - used.height});
+		if (used.x > freeRect.x)
+			_freeRects.push_back({freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.height});
+		if (used.x + used.width < freeRect.x + freeRect.width)
+			_freeRects.push_back({used.x + used.width, freeRect.y, freeRect.x + freeRect.width - used.x - used.width, freeRect.height});
+
+		// Swap with the last old rect so the new ones stay at the end
+		_freeRects[i] = _freeRects[count - 1];
+		_freeRects[count - 1] = _freeRects.back();
+		_freeRects.pop_back();
+		count--;
+	}
+
+	PruneFreeRects(count);
+}
+
+// Remove the free rects contained in another one. The old rects can't contain each other and can't be
+// contained in a new rect (new rects are parts of removed rects), so only the new rects need to be tested.
+void			AtlasAllocator::PruneFreeRects(size_t firstNewRect)
+{
+	for (size_t i = firstNewRect; i < _freeRects.size(); i++)
+	{
+		bool	contained = false;
+
+		for (size_t j = 0; j < _freeRects.size() && !contained; j++)
+			if (i != j && Contains(_freeRects[j], _freeRects[i]))
+				contained = (j < firstNewRect || j < i || !Contains(_freeRects[i], _freeRects[j]));
+
+		if (contained)
+		{
+			_freeRects[i] = _freeRects.back();
+			_freeRects.pop_back();
+			i--;
+		}
+	}
+}
+
+void			AtlasAllocator::FreeRect(const AtlasRect & rect)
+{
+	AtlasRect	merged = rect;
+	bool		changed = true;
+
+	// Grow the freed rect with the free rects sharing a full edge with it
+	while (changed)
+	{
+		changed = false;
+		for (const auto & freeRect : _freeRects)
+		{
+			bool verticalNeighbour = freeRect.x == merged.x && freeRect.width == merged.width
+				&& freeRect.y <= merged.y + merged.height && merged.y <= freeRect.y + freeRect.height;
+			bool horizontalNeighbour = freeRect.y == merged.y && freeRect.height == merged.height
+				&& freeRect.x <= merged.x + merged.width && merged.x <= freeRect.x + freeRect.width;
+
+			if (Contains(merged, freeRect) || !(verticalNeighbour || horizontalNeighbour))
+				continue ;
+
+			int minX = std::min(merged.x, freeRect.x);
+			int minY = std::min(merged.y, freeRect.y);
+			merged = {
+				minX, minY,
+				std::max(merged.x + merged.width, freeRect.x + freeRect.width) - minX,
+				std::max(merged.y + merged.height, freeRect.y + freeRect.height) - minY
+			};
+			changed = true;
+		}
+	}
+
+	for (const auto & freeRect : _freeRects)
+		if (Contains(freeRect, merged))
+			return ;
+
+	_freeRects.erase(std::remove_if(_freeRects.begin(), _freeRects.end(), [&](const AtlasRect & r) { return Contains(merged, r); }), _freeRects.end());
+	_freeRects.push_back(merged);
+}
+
+uint32_t		AtlasAllocator::AddAllocation(const AtlasRect & rect)
+{
+	uint32_t	id;
+
+	PlaceRect(rect);
+
+	if (!_freeIds.empty())
+	{
+		id = _freeIds.back();
+		_freeIds.pop_back();
+		_allocations[id] = {rect, true};
+	}
+	else
+	{
+		id = static_cast< uint32_t >(_allocations.size());
+		_allocations.push_back({rect, true});
+	}
+
+	_allocationCount++;
+	_usedArea += static_cast< size_t >(rect.width - 2 * _padding) * (rect.height - 2 * _padding);
+
+	return id;
+}
+
+uint32_t		AtlasAllocator::Allocate(int width, int height)
+{
+	AtlasRect	rect;
+
+	if (width <= 0 || height <= 0)
+		return InvalidId;
+
+	if (!FindPosition(width + 2 * _padding, height + 2 * _padding, _heuristic, rect))
+		return InvalidId;
+
+	return AddAllocation(rect);
+}
+
+std::vector< uint32_t >	AtlasAllocator::AllocateBatch(const std::vector< glm::ivec2 > & sizes)
+{
+	std::vector< uint32_t >	ids(sizes.size(), InvalidId);
+	std::vector< size_t >	order(sizes.size());
+
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		int areaA = sizes[a].x * sizes[a].y;
+		int areaB = sizes[b].x * sizes[b].y;
+
+		if (areaA != areaB)
+			return areaA > areaB;
+		return std::max(sizes[a].x, sizes[a].y) > std::max(sizes[b].x, sizes[b].y);
+	});
+
+	for (size_t i : order)
+		ids[i] = Allocate(sizes[i].x, sizes[i].y);
+
+	return ids;
+}
+
+void			AtlasAllocator::Deallocate(uint32_t id)
+{
+	if (!IsAllocated(id))
+		return ;
+
+	const AtlasRect & rect = _allocations[id].rect;
+
+	_usedArea -= static_cast< size_t >(rect.width - 2 * _padding) * (rect.height - 2 * _padding);
+	_allocations[id].used = false;
+	_freeIds.push_back(id);
+	_allocationCount--;
+
+	// An empty atlas is reset to a single free rect, no need to merge
+	if (_allocationCount == 0)
+		Clear();
+	else
+		FreeRect(rect);
+}
+
+void			AtlasAllocator::Clear(void) noexcept
+{
+	_freeRects.clear();
+	_freeRects.push_back({0, 0, _width, _height});
+	_allocations.clear();
+	_freeIds.clear();
+	_allocationCount = 0;
+	_usedArea = 0;
+}
+
+std::vector< AtlasAllocator::Move >	AtlasAllocator::Defragment(size_t maxMoves)
+{
+	std::vector< Move >			moves;
+	std::vector< AtlasRect >	released;
+	std::vector< uint32_t >		order;
+
+	for (uint32_t id = 0; id < _allocations.size(); id++)
+		if (_allocations[id].used)
+			order.push_back(id);
+
+	// The allocations the furthest from the top left corner are moved first
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		const AtlasRect & ra = _allocations[a].rect;
+		const AtlasRect & rb = _allocations[b].rect;
+
+		if (ra.y + ra.height != rb.y + rb.height)
+			return ra.y + ra.height > rb.y + rb.height;
+		return ra.x + ra.width > rb.x + rb.width;
+	});
+
+	for (uint32_t id : order)
+	{
+		AtlasRect	current = _allocations[id].rect;
+		AtlasRect	from = GetRect(id);
+		AtlasRect	target;
+
+		if (moves.size() >= maxMoves)
+			break ;
+
+		if (!FindPosition(current.width, current.height, Heuristic::BottomLeft, target))
+			continue ;
+
+		if (target.y + target.height > current.y + current.height
+			|| (target.y + target.height == current.y + current.height && target.x >= current.x))
+			continue ;
+
+		// The source is released after all the moves so it can't be the destination of another move
+		PlaceRect(target);
+		released.push_back(current);
+		_allocations[id].rect = target;
+
+		moves.push_back({id, from, GetRect(id)});
+	}
+
+	for (const auto & rect : released)
+		FreeRect(rect);
+
+	return moves;
+}
+
+bool			AtlasAllocator::IsAllocated(uint32_t id) const noexcept
+{
+	return id < _allocations.size() && _allocations[id].used;
+}
+
+AtlasRect		AtlasAllocator::GetRect(uint32_t id) const
+{
+	if (!IsAllocated(id))
+		throw std::runtime_error("Invalid atlas allocation id: " + std::to_string(id));
+
+	const AtlasRect & rect = _allocations[id].rect;
+
+	return {rect.x + _padding, rect.y + _padding, rect.width - 2 * _padding, rect.height - 2 * _padding};
+}
+
+int				AtlasAllocator::GetWidth(void) const noexcept { return _width; }
+int				AtlasAllocator::GetHeight(void) const noexcept { return _height; }
+int				AtlasAllocator::GetPadding(void) const noexcept { return _padding; }
+size_t			AtlasAllocator::GetAllocationCount(void) const noexcept { return _allocationCount; }
+size_t			AtlasAllocator::GetFreeRectCount(void) const noexcept { return _freeRects.size(); }
+
+float			AtlasAllocator::GetOccupancy(void) const noexcept
+{
+	return static_cast< float >(_usedArea) / (static_cast< float >(_width) * _height);
+}
+
+glm::ivec2		AtlasAllocator::GetUsedExtent(void) const noexcept
+{
+	glm::ivec2	extent(0, 0);
+
+	for (const auto & allocation : _allocations)
+	{
+		if (!allocation.used)
+			continue ;
+		extent.x = std::max(extent.x, allocation.rect.x + allocation.rect.width);
+		extent.y = std::max(extent.y, allocation.rect.y + allocation.rect.height);
+	}
+
+	return extent;
+}
+
+std::ostream &	operator<<(std::ostream & o, AtlasAllocator const & r)
+{
+	o << "AtlasAllocator: " << r.GetWidth() << "x" << r.GetHeight() << ", " << r.GetAllocationCount() << " allocations, "
+		<< r.GetFreeRectCount() << " free rects, occupancy: " << r.GetOccupancy() << std::endl;
+	return o;
+}
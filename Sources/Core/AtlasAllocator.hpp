@@ -0,0 +1,101 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "IncludeDeps.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	struct		AtlasRect
+	{
+		int		x;
+		int		y;
+		int		width;
+		int		height;
+	};
+
+	// MaxRects rectangle packer: the free space is stored as a list of maximal (possibly overlapping) free
+	// rectangles, new rectangles are placed in the free rectangle chosen by the heuristic and the free
+	// rectangles they intersect are split. Allocations are referenced by id, so they can be freed and moved.
+	class		AtlasAllocator
+	{
+		public:
+			static const uint32_t	InvalidId = 0xFFFFFFFF;
+
+			enum class	Heuristic
+			{
+				BestShortSideFit,	// Minimize the smallest leftover side, best packing on mixed sizes
+				BestAreaFit,		// Minimize the leftover area
+				BottomLeft,			// Tetris like placement, used to compact the atlas
+			};
+
+			struct	Move
+			{
+				uint32_t	id;
+				AtlasRect	from;
+				AtlasRect	to;
+			};
+
+		private:
+			struct	Allocation
+			{
+				AtlasRect	rect;	// With padding
+				bool		used;
+			};
+
+			int							_width;
+			int							_height;
+			int							_padding;
+			Heuristic					_heuristic;
+			std::vector< AtlasRect >	_freeRects;
+			std::vector< Allocation >	_allocations;
+			std::vector< uint32_t >		_freeIds;
+			size_t						_allocationCount;
+			size_t						_usedArea;
+
+			bool		FindPosition(int width, int height, Heuristic heuristic, AtlasRect & result) const noexcept;
+			void		PlaceRect(const AtlasRect & rect);
+			void		FreeRect(const AtlasRect & rect);
+			void		PruneFreeRects(size_t firstNewRect);
+			uint32_t	AddAllocation(const AtlasRect & rect);
+
+		public:
+			AtlasAllocator(void) = delete;
+			AtlasAllocator(int width, int height, int padding = 0, Heuristic heuristic = Heuristic::BestShortSideFit);
+			AtlasAllocator(const AtlasAllocator &) = default;
+			virtual ~AtlasAllocator(void) = default;
+
+			AtlasAllocator &	operator=(AtlasAllocator const & src) = default;
+
+			// Returns InvalidId when there is no space left
+			uint32_t				Allocate(int width, int height);
+			// Allocate the biggest rects first, the result is in the same order than the sizes (InvalidId when it didn't fit)
+			std::vector< uint32_t >	AllocateBatch(const std::vector< glm::ivec2 > & sizes);
+			void					Deallocate(uint32_t id);
+			void					Clear(void) noexcept;
+
+			// Move at most maxMoves allocations toward the top left corner to grow the contiguous free space.
+			// The destinations of a call never overlap the sources so all the moves can be copied at once.
+			std::vector< Move >		Defragment(size_t maxMoves);
+
+			bool					IsAllocated(uint32_t id) const noexcept;
+			// Rect of the allocation without its padding
+			AtlasRect				GetRect(uint32_t id) const;
+			int						GetWidth(void) const noexcept;
+			int						GetHeight(void) const noexcept;
+			int						GetPadding(void) const noexcept;
+			size_t					GetAllocationCount(void) const noexcept;
+			size_t					GetFreeRectCount(void) const noexcept;
+			// Allocated area (without padding) over the atlas area
+			float					GetOccupancy(void) const noexcept;
+			// Bottom right corner of the allocated area
+			glm::ivec2				GetUsedExtent(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, AtlasAllocator const & r);
+}
@@ -8,12 +8,18 @@
 #include GLM_INCLUDE_QUATERNION
 #include GLM_INCLUDE_MATRIX_TRANSFORM
 
+#include <algorithm>
+
 using namespace LWGC;
 
 Camera::Camera(void)
 {
-	this->_target = new RenderTarget();
+	this->_target = nullptr;
+	this->_viewportRect = glm::vec4(0, 0, 1, 1);
 	this->_viewportSize = glm::vec2(0, 0);
+	this->_priority = 0;
+	this->_viewOffsets = {glm::mat4(1.0f)};
+	this->_perCamera = {};
 	this->_cameraType = CameraType::Perspective;
 	this->_fov = 60;
 	this->_nearPlane = 0.1f;
@@ -102,9 +108,9 @@ void					Camera::UpdateUniformData(void) noexcept
 	// World to camera is the inverse of local (camera) to world
 	_perCamera.view = glm::inverse(transform->GetLocalToWorldMatrix());
 
-	auto swapChainExtent = Application::Get()->GetSwapChain()->GetExtent();
-	_viewportSize.x = swapChainExtent.width;
-	_viewportSize.y = swapChainExtent.height;
+	auto rect = GetPixelRect();
+	_viewportSize.x = rect.extent.width;
+	_viewportSize.y = rect.extent.height;
 
 	float ratio = _viewportSize.x / _viewportSize.y;
 	_perCamera.projection = ReverseZPerspective(glm::radians(_fov), ratio, _nearPlane, _farPlane);
@@ -117,6 +123,13 @@ void					Camera::UpdateUniformData(void) noexcept
 	_perCamera.view = glm::transpose(_perCamera.view);
 	_perCamera.screenSize = glm::vec4(_viewportSize, 1.0f / _viewportSize);
 
+	// The views only differ by the position of their eye
+	for (size_t i = 0; i < _viewOffsets.size(); i++)
+	{
+		_perCamera.views[i].projection = _perCamera.projection;
+		_perCamera.views[i].view = glm::transpose(glm::inverse(transform->GetLocalToWorldMatrix() * _viewOffsets[i]));
+	}
+
 	Vk::UploadToMemory(_uniformCameraBuffer.memory, &_perCamera, sizeof(_perCamera));
 }
 
@@ -133,8 +146,67 @@ uint32_t	Camera::GetType(void) const noexcept
 RenderTarget *	Camera::GetTarget(void) const { return (this->_target); }
 void		Camera::SetTarget(RenderTarget * tmp) { this->_target = tmp; }
 
+// Without target the camera renders into the swap chain images
+VkExtent2D	Camera::GetTargetExtent(void) const noexcept
+{
+	return (_target != nullptr) ? _target->GetExtent() : Application::Get()->GetSwapChain()->GetExtent();
+}
+
+VkRect2D	Camera::GetPixelRect(void) const noexcept
+{
+	VkExtent2D	extent = GetTargetExtent();
+	glm::vec4	rect = glm::clamp(_viewportRect, glm::vec4(0.0f), glm::vec4(1.0f));
+	VkRect2D	pixelRect;
+
+	pixelRect.offset.x = static_cast< int32_t >(rect.x * extent.width);
+	pixelRect.offset.y = static_cast< int32_t >(rect.y * extent.height);
+	pixelRect.extent.width = std::min(static_cast< uint32_t >(rect.z * extent.width), extent.width - pixelRect.offset.x);
+	pixelRect.extent.height = std::min(static_cast< uint32_t >(rect.w * extent.height), extent.height - pixelRect.offset.y);
+
+	return pixelRect;
+}
+
 glm::vec2	Camera::GetViewportSize(void) const { return (this->_viewportSize); }
 
+glm::vec4	Camera::GetViewportRect(void) const { return (this->_viewportRect); }
+void		Camera::SetViewportRect(const glm::vec4 & rect) { this->_viewportRect = rect; }
+
+int			Camera::GetPriority(void) const { return (this->_priority); }
+void		Camera::SetPriority(int priority) { this->_priority = priority; }
+
+uint32_t	Camera::GetViewCount(void) const noexcept { return static_cast< uint32_t >(_viewOffsets.size()); }
+
+void		Camera::SetViewCount(uint32_t viewCount)
+{
+	if (viewCount == 0 || viewCount > MaxViews)
+		throw std::runtime_error("A camera can have between 1 and " + std::to_string(MaxViews) + " views");
+
+	_viewOffsets.resize(viewCount, glm::mat4(1.0f));
+}
+
+glm::mat4	Camera::GetViewOffset(uint32_t viewIndex) const
+{
+	if (viewIndex >= _viewOffsets.size())
+		throw std::runtime_error("Camera view index out of range");
+
+	return _viewOffsets[viewIndex];
+}
+
+void		Camera::SetViewOffset(uint32_t viewIndex, const glm::mat4 & offset)
+{
+	if (viewIndex >= _viewOffsets.size())
+		throw std::runtime_error("Camera view index out of range");
+
+	_viewOffsets[viewIndex] = offset;
+}
+
+void		Camera::SetStereo(float eyeSeparation)
+{
+	SetViewCount(2);
+	_viewOffsets[0] = glm::translate(glm::mat4(1.0f), glm::vec3(-eyeSeparation / 2.0f, 0, 0));
+	_viewOffsets[1] = glm::translate(glm::mat4(1.0f), glm::vec3(eyeSeparation / 2.0f, 0, 0));
+}
+
 CameraType	Camera::GetCameraType(void) const { return (this->_cameraType); }
 void		Camera::SetCameraType(CameraType tmp) { this->_cameraType = tmp; }
 
@@ -151,6 +223,13 @@ void		Camera::SetFarPlane(float tmp) { this->_farPlane = tmp; }
 glm::mat4	Camera::GetViewMatrix(void) const { return glm::transpose(_perCamera.view); }
 glm::mat4	Camera::GetProjectionMatrix(void) const { return glm::transpose(_perCamera.projection); }
 
+glm::mat4	Camera::GetViewProjectionMatrix(uint32_t viewIndex) const
+{
+	const auto & view = _perCamera.views[std::min(viewIndex, MaxViews - 1)];
+
+	return glm::transpose(view.projection) * glm::transpose(view.view);
+}
+
 std::ostream &	operator<<(std::ostream & o, Camera const & r)
 {
 	o << "tostring of the class" << std::endl;
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "Core/Object.hpp"
 #include "Core/Rendering/RenderTarget.hpp"
@@ -15,17 +16,32 @@ namespace LWGC
 {
 	class		Camera : public Object, public Component
 	{
+		public:
+			// Must match LWGC_MAX_VIEWS in the shaders
+			static const uint32_t	MaxViews = 4;
+
 		private:
-			struct LWGC_PerCamera
+			struct LWGC_PerView
 			{
 				glm::mat4	projection;
 				glm::mat4	view;
-				glm::vec4	positionWS;
-				glm::vec4	screenSize;
+			};
+
+			// projection and view are the ones of the first view, for the shaders that don't use SV_ViewID
+			struct LWGC_PerCamera
+			{
+				glm::mat4		projection;
+				glm::mat4		view;
+				glm::vec4		positionWS;
+				glm::vec4		screenSize;
+				LWGC_PerView	views[MaxViews];
 			};
 
 			RenderTarget *			_target;
+			glm::vec4				_viewportRect;
 			glm::vec2				_viewportSize;
+			int						_priority;
+			std::vector< glm::mat4 >	_viewOffsets;	// Eye to camera space, one per view
 			CameraType				_cameraType;
 			float					_fov;
 			float					_nearPlane;
@@ -35,6 +51,7 @@ namespace LWGC
 			DescriptorSet			_perCameraSet;
 
 			void							UpdateUniformData(void) noexcept;
+			VkExtent2D						GetTargetExtent(void) const noexcept;
 			virtual void					Update(void) noexcept override;
 
 		public:
@@ -53,10 +70,30 @@ namespace LWGC
 
 			glm::vec3	ScreenToWorldPoint(glm::vec3 screenPosition);
 
+			// nullptr when the camera renders into the swap chain. The target is not owned by the camera
 			RenderTarget *	GetTarget(void) const;
 			void			SetTarget(RenderTarget * tmp);
 
+			// Size in pixels of the part of the target the camera renders into
 			glm::vec2	GetViewportSize(void) const;
+			// Normalized x, y, width and height in the target, the cameras sharing a target (split screen,
+			// minimap) are rendered in the same pass, each one in its viewport
+			glm::vec4	GetViewportRect(void) const;
+			void		SetViewportRect(const glm::vec4 & rect);
+			VkRect2D	GetPixelRect(void) const noexcept;
+
+			// The cameras are rendered by increasing priority, the ones drawn over others have a higher one
+			int			GetPriority(void) const;
+			void		SetPriority(int priority);
+
+			// More than one view needs a target with as many views, they are all drawn in one multiview pass
+			uint32_t	GetViewCount(void) const noexcept;
+			void		SetViewCount(uint32_t viewCount);
+			// Transform of the eye of a view relative to the camera
+			glm::mat4	GetViewOffset(uint32_t viewIndex) const;
+			void		SetViewOffset(uint32_t viewIndex, const glm::mat4 & offset);
+			// Two views separated by eyeSeparation on the right axis of the camera
+			void		SetStereo(float eyeSeparation);
 
 			CameraType	GetCameraType(void) const;
 			void		SetCameraType(CameraType tmp);
@@ -73,6 +110,7 @@ namespace LWGC
 			glm::mat4 	ReverseZPerspective(float fovy, float aspect, float zNear, float zFar);
 			glm::mat4	GetViewMatrix(void) const;
 			glm::mat4	GetProjectionMatrix(void) const;
+			glm::mat4	GetViewProjectionMatrix(uint32_t viewIndex) const;
 
 			VkDescriptorSet		GetDescriptorSet(void);
 
@@ -28,6 +28,7 @@ namespace LWGC
 		Activator,
 		ImGUIPanel,
 		IndirectRenderer,
+		LODGroup,
 
  		// Note: this MUST be the last element of the enum
 		Count,
@@ -0,0 +1,124 @@
+#include "LODGroup.hpp"
+
+#include "Core/Hierarchy.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+
+using namespace LWGC;
+
+LODGroup::LODGroup(MeshRenderer * renderer) : _renderer(renderer), _hysteresis(0.1f), _screenCoverage(1), _currentLOD(0)
+{
+	// Each level covers half the screen height of the previous one
+	_screenHeights = {0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f, 0.015625f, 0.0078125f};
+
+	_beginCameraRendering = RenderPipelineManager::beginCameraRendering.AddListener([this](Camera * camera)
+	{
+		auto cameraLOD = _cameraLODs.find(camera);
+
+		if (_renderer != nullptr && cameraLOD != _cameraLODs.end())
+			_renderer->SetLOD(cameraLOD->second.lod);
+	});
+}
+
+LODGroup::~LODGroup(void)
+{
+	RenderPipelineManager::beginCameraRendering.RemoveListener(_beginCameraRendering);
+}
+
+void			LODGroup::Update(void) noexcept
+{
+	auto	cameras = hierarchy->GetCameras();
+
+	if (_renderer == nullptr || _renderer->GetMesh() == nullptr || cameras.size() == 0)
+		return ;
+
+	glm::mat4	localToWorld = transform->GetLocalToWorldMatrix();
+	Bounds		localBounds = _renderer->GetBounds();
+	glm::vec3	corners[2] = {localBounds.GetMin(), localBounds.GetMax()};
+	Bounds		worldBounds(glm::vec3(localToWorld * glm::vec4(corners[0], 1)), glm::vec3(localToWorld * glm::vec4(corners[0], 1)));
+
+	for (int i = 1; i < 8; i++)
+		worldBounds.Encapsulate(glm::vec3(localToWorld * glm::vec4(corners[i & 1].x, corners[(i >> 1) & 1].y, corners[(i >> 2) & 1].z, 1)));
+
+	// The hysteresis of each camera starts from its LOD of the last frame, the removed cameras are dropped
+	std::unordered_map< const Camera *, CameraLOD >	cameraLODs;
+
+	for (const auto camera : cameras)
+	{
+		auto		previous = _cameraLODs.find(camera);
+		int			previousLOD = (previous != _cameraLODs.end()) ? previous->second.lod : _currentLOD;
+		glm::vec3	cameraPosition = glm::vec3(camera->GetTransform()->GetLocalToWorldMatrix()[3]);
+		float		screenCoverage = ComputeScreenCoverage(worldBounds, cameraPosition, camera->GetFov(), camera->GetViewportSize());
+
+		cameraLODs[camera] = CameraLOD{SelectLOD(_screenHeights, screenCoverage, previousLOD, _hysteresis, _renderer->GetMesh()->GetLODCount()), screenCoverage};
+	}
+	_cameraLODs = std::move(cameraLODs);
+
+	_screenCoverage = _cameraLODs[cameras[0]].screenCoverage;
+	_currentLOD = _cameraLODs[cameras[0]].lod;
+	_renderer->SetLOD(_currentLOD);
+}
+
+float			LODGroup::ComputeScreenCoverage(const Bounds & worldBounds, const glm::vec3 & cameraPosition, float fovDegree, const glm::vec2 & viewportSize)
+{
+	glm::vec3	center = (worldBounds.GetMin() + worldBounds.GetMax()) * 0.5f;
+	float		radius = glm::length(worldBounds.GetSize()) * 0.5f;
+	float		distance = glm::length(center - cameraPosition);
+	float		halfFovTan = std::tan(glm::radians(fovDegree) * 0.5f);
+
+	// fov is vertical, on a portrait viewport the width is the limiting dimension
+	if (viewportSize.y > 0 && viewportSize.x < viewportSize.y)
+		halfFovTan *= viewportSize.x / viewportSize.y;
+
+	// Inside the bounding sphere, the object fills the screen
+	if (distance <= radius || halfFovTan <= 0)
+		return 1;
+
+	// Projected diameter over the frustum size at this distance
+	return (radius) / (distance * halfFovTan);
+}
+
+int				LODGroup::SelectLOD(const std::vector< float > & screenHeights, float screenCoverage, int currentLOD, float hysteresis, int lodCount)
+{
+	int		lod = 0;
+
+	// Going to a lower detail level requires to be under the threshold by the hysteresis margin,
+	// going back to a higher detail requires to be above it by the same margin
+	while (lod + 1 < lodCount && lod < static_cast< int >(screenHeights.size()))
+	{
+		float bias = (lod < currentLOD) ? 1 + hysteresis : 1 - hysteresis;
+
+		if (screenCoverage >= screenHeights[lod] * bias)
+			break ;
+		lod++;
+	}
+
+	return lod;
+}
+
+void			LODGroup::SetScreenHeights(const std::vector< float > & screenHeights) { _screenHeights = screenHeights; }
+std::vector< float >	LODGroup::GetScreenHeights(void) const { return _screenHeights; }
+
+void			LODGroup::SetHysteresis(float hysteresis) { _hysteresis = hysteresis; }
+float			LODGroup::GetHysteresis(void) const { return _hysteresis; }
+
+int				LODGroup::GetCurrentLOD(void) const { return _currentLOD; }
+float			LODGroup::GetScreenCoverage(void) const { return _screenCoverage; }
+
+int				LODGroup::GetCurrentLOD(const Camera * camera) const
+{
+	auto cameraLOD = _cameraLODs.find(camera);
+
+	return (cameraLOD != _cameraLODs.end()) ? cameraLOD->second.lod : -1;
+}
+
+uint32_t		LODGroup::GetType(void) const noexcept
+{
+	return static_cast< uint32_t >(ComponentType::LODGroup);
+}
+
+std::ostream &	operator<<(std::ostream & o, LODGroup const & r)
+{
+	o << "LODGroup" << std::endl;
+	(void)r;
+	return (o);
+}
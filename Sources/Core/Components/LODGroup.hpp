@@ -0,0 +1,67 @@
+#pragma once
+
+#include "IncludeDeps.hpp"
+#include "Core/Object.hpp"
+#include "Core/GameObject.hpp"
+#include "Core/Components/MeshRenderer.hpp"
+#include "Core/Components/Camera.hpp"
+#include "Core/Delegate.tpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace LWGC
+{
+	// Select the LOD of a MeshRenderer each frame from the screen height covered by it's bounds. Every camera
+	// has its own LOD (split screen, minimaps), it's set on the renderer when the camera starts rendering.
+	class		LODGroup : public Object, public Component
+	{
+		private:
+			struct	CameraLOD
+			{
+				int		lod;
+				float	screenCoverage;
+			};
+
+			MeshRenderer *			_renderer;
+			std::vector< float >	_screenHeights;
+			float					_hysteresis;
+			float					_screenCoverage;
+			int						_currentLOD;
+			std::unordered_map< const Camera *, CameraLOD >	_cameraLODs;
+			DelegateIndex< void(Camera *) >					_beginCameraRendering;
+
+		public:
+			LODGroup(void) = delete;
+			LODGroup(MeshRenderer * renderer);
+			LODGroup(const LODGroup &) = delete;
+			virtual ~LODGroup(void);
+
+			LODGroup &	operator=(LODGroup const & src) = delete;
+
+			void Update(void) noexcept override;
+
+			// screenHeights[i] is the screen coverage (0 to 1) under which LOD i is dropped for LOD i + 1
+			void					SetScreenHeights(const std::vector< float > & screenHeights);
+			std::vector< float >	GetScreenHeights(void) const;
+
+			// Relative margin around the thresholds to avoid switching every frame at the boundary
+			void		SetHysteresis(float hysteresis);
+			float		GetHysteresis(void) const;
+
+			// Of the first camera
+			int			GetCurrentLOD(void) const;
+			float		GetScreenCoverage(void) const;
+			// -1 when the camera was not seen by the last Update
+			int			GetCurrentLOD(const Camera * camera) const;
+
+			static float	ComputeScreenCoverage(const Bounds & worldBounds, const glm::vec3 & cameraPosition, float fovDegree, const glm::vec2 & viewportSize);
+			static int		SelectLOD(const std::vector< float > & screenHeights, float screenCoverage, int currentLOD, float hysteresis, int lodCount);
+
+			virtual uint32_t	GetType(void) const noexcept override;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, LODGroup const & r);
+}
@@ -1,20 +1,76 @@
 #include "Light.hpp"
 
+#include "Core/Hierarchy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
 using namespace LWGC;
 
-Light::Light(void)
+Light::Light(LightType lightType) : _lightType(lightType), _color(Color::White), _intensity(1.0f), _range(10.0f),
+	_innerSpotAngle(30.0f), _outerSpotAngle(45.0f), _castShadows(true)
 {
-	std::cout << "Default constructor of Light called" << std::endl;
 }
 
 Light::~Light(void)
 {
-	std::cout << "Destructor of Light called" << std::endl;
 }
 
-std::ostream &	operator<<(std::ostream & o, Light const & r)
+void			Light::OnEnable(void) noexcept
+{
+	Component::OnEnable();
+	_renderContextIndex = hierarchy->RegisterComponentInRenderContext(GetType(), this);
+}
+
+void			Light::OnDisable(void) noexcept
+{
+	Component::OnDisable();
+	hierarchy->UnregisterComponentInRenderContext(GetType(), _renderContextIndex);
+}
+
+LightType		Light::GetLightType(void) const noexcept { return _lightType; }
+void			Light::SetLightType(LightType lightType) noexcept { _lightType = lightType; }
+
+Color			Light::GetColor(void) const noexcept { return _color; }
+void			Light::SetColor(const Color & color) noexcept { _color = color; }
+
+float			Light::GetIntensity(void) const noexcept { return _intensity; }
+void			Light::SetIntensity(float intensity) noexcept { _intensity = intensity; }
+
+float			Light::GetRange(void) const noexcept { return _range; }
+
+void			Light::SetRange(float range)
+{
+	if (range <= 0.0f)
+		throw std::runtime_error("The range of a light must be positive");
+
+	_range = range;
+}
+
+float			Light::GetInnerSpotAngle(void) const noexcept { return _innerSpotAngle; }
+float			Light::GetOuterSpotAngle(void) const noexcept { return _outerSpotAngle; }
+
+void			Light::SetSpotAngles(float innerAngle, float outerAngle)
+{
+	if (outerAngle <= 0.0f || outerAngle >= 180.0f)
+		throw std::runtime_error("The outer angle of a spot light must be between 0 and 180 degrees");
+
+	_outerSpotAngle = outerAngle;
+	_innerSpotAngle = std::clamp(innerAngle, 0.0f, outerAngle);
+}
+
+bool			Light::GetCastShadows(void) const noexcept { return _castShadows; }
+void			Light::SetCastShadows(bool castShadows) noexcept { _castShadows = castShadows; }
+
+glm::vec3		Light::GetDirection(void) const { return transform->GetForward(); }
+
+uint32_t		Light::GetType(void) const noexcept
+{
+	return static_cast< uint32_t >(ComponentType::Light);
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, Light const & r)
 {
-	o << "tostring of the class" << std::endl;
-	(void)r;
+	o << "Light: range " << r.GetRange() << ", intensity " << r.GetIntensity() << std::endl;
 	return (o);
 }
@@ -4,21 +4,60 @@
 
 #include "Core/GameObject.hpp"
 #include "Core/Components/Component.hpp"
+#include "Core/LightType.hpp"
+#include "Utils/Color.hpp"
 
 namespace LWGC
 {
 	class		Light : public Component
 	{
 		private:
+			LightType		_lightType;
+			Color			_color;
+			float			_intensity;
+			float			_range;
+			float			_innerSpotAngle;
+			float			_outerSpotAngle;
+			bool			_castShadows;
+			ComponentIndex	_renderContextIndex;
 
+			void			OnEnable(void) noexcept override;
+			void			OnDisable(void) noexcept override;
 
 		public:
-			Light();
+			Light(LightType lightType = LightType::Point);
 			Light(const Light &) = delete;
 			virtual ~Light(void);
 
 			Light &	operator=(Light const & src) = delete;
 
+			LightType	GetLightType(void) const noexcept;
+			void		SetLightType(LightType lightType) noexcept;
+
+			Color		GetColor(void) const noexcept;
+			void		SetColor(const Color & color) noexcept;
+
+			float		GetIntensity(void) const noexcept;
+			void		SetIntensity(float intensity) noexcept;
+
+			// Distance at which the point and spot lights fade to zero, ignored by the directional lights
+			float		GetRange(void) const noexcept;
+			void		SetRange(float range);
+
+			// Angles of the full cone in degrees, the light fades between the inner and the outer one
+			float		GetInnerSpotAngle(void) const noexcept;
+			float		GetOuterSpotAngle(void) const noexcept;
+			void		SetSpotAngles(float innerAngle, float outerAngle);
+
+			// Only the brightest directional light casting shadows has shadow maps
+			bool		GetCastShadows(void) const noexcept;
+			void		SetCastShadows(bool castShadows) noexcept;
+
+			// Direction the light travels in, the forward of the transform
+			glm::vec3	GetDirection(void) const;
+
+			virtual uint32_t	GetType(void) const noexcept override;
+
 			static const uint32_t		type = 1;
 	};
 
@@ -6,18 +6,18 @@
 
 using namespace LWGC;
 
-MeshRenderer::MeshRenderer(const PrimitiveType prim, Material * material) : Renderer(material)
+MeshRenderer::MeshRenderer(const PrimitiveType prim, Material * material) : Renderer(material), _lod(0)
 {
 	_mesh = PrimitiveMeshFactory::CreateMesh(prim);
 }
 
-MeshRenderer::MeshRenderer(Mesh * mesh, Material * material) : Renderer(material), _mesh(mesh) {}
+MeshRenderer::MeshRenderer(Mesh * mesh, Material * material) : Renderer(material), _mesh(mesh), _lod(0) {}
 
-MeshRenderer::MeshRenderer(Material * material) : Renderer(material)
+MeshRenderer::MeshRenderer(Material * material) : Renderer(material), _lod(0)
 {
 }
 
-MeshRenderer::MeshRenderer(const PrimitiveType prim) : Renderer(Material::Create(BuiltinShaders::Pink))
+MeshRenderer::MeshRenderer(const PrimitiveType prim) : Renderer(Material::Create(BuiltinShaders::Pink)), _lod(0)
 {
 	_mesh = PrimitiveMeshFactory::CreateMesh(prim);
 }
@@ -37,7 +37,14 @@ void		MeshRenderer::RecordDrawCommand(VkCommandBuffer cmd) noexcept
 {
 	_mesh->BindBuffers(cmd);
 
-	_mesh->Draw(cmd);
+	_mesh->Draw(cmd, _lod);
+}
+
+void		MeshRenderer::RecordDepthDrawCommand(VkCommandBuffer cmd) noexcept
+{
+	_mesh->BindPositionBuffers(cmd);
+
+	_mesh->Draw(cmd, _lod);
 }
 
 void		MeshRenderer::SetModel(const Mesh & mesh, Material * material)
@@ -62,6 +69,9 @@ uint32_t					MeshRenderer::GetType(void) const noexcept { return static_cast< ui
 std::shared_ptr< Mesh >		MeshRenderer::GetMesh(void) const { return (this->_mesh); }
 void						MeshRenderer::SetMesh(std::shared_ptr< Mesh > tmp) { this->_mesh = tmp; }
 
+int							MeshRenderer::GetLOD(void) const { return (this->_lod); }
+void						MeshRenderer::SetLOD(int tmp) { this->_lod = tmp; }
+
 std::ostream &	operator<<(std::ostream & o, MeshRenderer const & r)
 {
 	o << "MeshRenderer" << std::endl;
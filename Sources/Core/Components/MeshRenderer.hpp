@@ -16,9 +16,11 @@ namespace LWGC
 	{
 		private:
 			std::shared_ptr< Mesh >		_mesh;
+			int							_lod;
 
 			void		Initialize(void) noexcept override;
 			void		RecordDrawCommand(VkCommandBuffer cmd) noexcept override;
+			void		RecordDepthDrawCommand(VkCommandBuffer cmd) noexcept override;
 
 		public:
 			MeshRenderer(void) = delete;
@@ -40,6 +42,9 @@ namespace LWGC
 			std::shared_ptr< Mesh >		GetMesh(void) const;
 			void						SetMesh(std::shared_ptr< Mesh > tmp);
 
+			int							GetLOD(void) const;
+			void						SetLOD(int tmp);
+
 			virtual uint32_t			GetType(void) const noexcept override;
 	};
 
@@ -1,31 +1,90 @@
 #include "ProfilerPanel.hpp"
 #include "IncludeDeps.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "Core/Application.hpp"
 #include "Core/Profiler.hpp"
+#include "Core/ProfilerCapture.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
 
 #include IMGUI_INCLUDE
 
 using namespace LWGC;
 
-ProfilerPanel::ProfilerPanel() : ImGUIPanel()
+ProfilerPanel::ProfilerPanel() : ImGUIPanel(), _frame{0, 0, 0, {}, {}}, _timelineEnd(0), _paused(false), _binaryCapture(false)
 {
 	_frameDurationHistory.resize(HISTORY_SIZE, 0);
 
 	// Get the last frame informations
-	Application::update.AddListener([&](){
-		_currentSample = Profiler::GetSamples();
+	_updateIndex = Application::update.AddListener([this](){ UpdateFrame(); });
+}
+
+ProfilerPanel::~ProfilerPanel(void)
+{
+	Application::update.RemoveListener(_updateIndex);
+}
+
+void		ProfilerPanel::UpdateFrame(void)
+{
+	// The GPU scopes are read back a few frames later, wait for them to show both side by side
+	if (_paused || !Profiler::GetLastFrame(_frame, true))
+		return ;
+
+	Profiler::GetFrameDurations(_frameDurationHistory);
+	_frameDurationHistory.resize(HISTORY_SIZE, 0);
+
+	std::unordered_map< ProfilerNameId, size_t >	summaryIndices;
+
+	_summary.clear();
+	_threadDepths.clear();
+	_timelineEnd = _frame.end;
+
+	for (const auto & scope : _frame.scopes)
+	{
+		auto		summaryIndex = summaryIndices.find(scope.name);
+		uint32_t &	depth = _threadDepths[scope.threadIndex];
 
-		_frameDurationHistory.insert(_frameDurationHistory.begin(), Profiler::GetLastSample().duration);
-		_frameDurationHistory.pop_back();
-	});
+		depth = std::max(depth, scope.depth);
+		_timelineEnd = std::max(_timelineEnd, scope.end);
+
+		if (summaryIndex == summaryIndices.end())
+		{
+			summaryIndex = summaryIndices.insert({scope.name, _summary.size()}).first;
+			_summary.push_back({scope.name, 0, 0});
+		}
+		_summary[summaryIndex->second].totalDuration += (scope.end - scope.start) / 1000000.0;
+		_summary[summaryIndex->second].count++;
+
+		if (_threadNames.find(scope.threadIndex) == _threadNames.end())
+			_threadNames[scope.threadIndex] = Profiler::GetThreadName(scope.threadIndex);
+	}
+
+	std::sort(_summary.begin(), _summary.end(), [](const SummaryEntry & a, const SummaryEntry & b){ return a.totalDuration > b.totalDuration; });
+}
+
+// The names are resolved once, Profiler::GetName locks
+const std::string &	ProfilerPanel::GetName(ProfilerNameId name)
+{
+	auto cached = _names.find(name);
+
+	if (cached == _names.end())
+		cached = _names.insert({name, Profiler::GetName(name)}).first;
+
+	return cached->second;
 }
 
 void		ProfilerPanel::DrawImGUI(void) noexcept
 {
-	ImGui::Begin("CPU Profiler");
+	ImGui::Begin("Profiler");
 
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	ImGui::Text("Frame %llu: %.3f ms, %zu scopes, %llu dropped events", static_cast< unsigned long long >(_frame.index), (_frame.end - _frame.start) / 1000000.0, _frame.scopes.size(), static_cast< unsigned long long >(Profiler::GetDroppedEventCount()));
+	ImGui::Text("%llu dropped GPU samples", static_cast< unsigned long long >(GpuProfiler::GetDroppedSampleCount()));
+	if (RenderPipelineManager::currentRenderPipeline != nullptr)
+		ImGui::Text("Input to GPU end latency: %.3f ms", RenderPipelineManager::currentRenderPipeline->GetLastLatency());
 
 	ImGui::PlotLines(
 		"Frame time history",
@@ -39,16 +98,104 @@ void		ProfilerPanel::DrawImGUI(void) noexcept
 		sizeof(float)
 	);
 
-	for (const auto sample : _currentSample)
+	ImGui::Checkbox("Pause", &_paused);
+
+	DrawCapture();
+
+	if (ImGui::CollapsingHeader("Timeline", ImGuiTreeNodeFlags_DefaultOpen))
+		DrawTimeline();
+
+	if (ImGui::CollapsingHeader("Summary"))
+		DrawSummary();
+
+	ImGui::End();
+}
+
+// Flame graph of each thread and GPU lane: one row per depth, the width of the panel is the duration of the frame
+// extended to the end of its last GPU scope. The end of the CPU frame is marked with a vertical line.
+void		ProfilerPanel::DrawTimeline(void) noexcept
+{
+	ImDrawList *	drawList = ImGui::GetWindowDrawList();
+	const float		rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float		width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+	const double	timelineDuration = std::max< double >(static_cast< double >(_timelineEnd - _frame.start), 1.0);
+	const float		frameEnd = static_cast< float >((_frame.end - _frame.start) / timelineDuration) * width;
+	const ImVec2	mouse = ImGui::GetIO().MousePos;
+
+	for (const auto & thread : _threadDepths)
 	{
-		const auto & sampleName = sample.first;
-		const auto & sampleData = sample.second;
+		ImGui::Text("%s", _threadNames[thread.first].c_str());
+
+		ImVec2	origin = ImGui::GetCursorScreenPos();
+		float	height = (thread.second + 1) * rowHeight;
+
+		ImGui::InvisibleButton(("##timeline" + std::to_string(thread.first)).c_str(), ImVec2(width, height));
+		bool	hovered = ImGui::IsItemHovered();
 
+		for (const auto & scope : _frame.scopes)
+		{
+			if (scope.threadIndex != thread.first)
+				continue ;
 
-		ImGui::Text("%s: %lf", sampleName.c_str(), sampleData.duration);
+			// Scopes of other threads can start before the frame marker of the main thread
+			double	start = std::min(std::max((static_cast< double >(scope.start) - _frame.start) / timelineDuration, 0.0), 1.0);
+			double	end = std::min(std::max((static_cast< double >(scope.end) - _frame.start) / timelineDuration, 0.0), 1.0);
+			ImVec2	min(origin.x + static_cast< float >(start) * width, origin.y + scope.depth * rowHeight);
+			ImVec2	max(std::max(origin.x + static_cast< float >(end) * width, min.x + 1), min.y + rowHeight - 1);
+
+			const std::string &	name = GetName(scope.name);
+			float				hue = std::fmod(scope.name * 0.618034f, 1.0f);
+
+			drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.6f, 0.7f));
+			if (ImGui::CalcTextSize(name.c_str()).x < max.x - min.x - 4)
+				drawList->AddText(ImVec2(min.x + 2, min.y), IM_COL32(255, 255, 255, 255), name.c_str());
+
+			if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+				ImGui::SetTooltip("%s: %.3f ms", name.c_str(), (scope.end - scope.start) / 1000000.0);
+		}
+
+		drawList->AddLine(ImVec2(origin.x + frameEnd, origin.y), ImVec2(origin.x + frameEnd, origin.y + height), IM_COL32(255, 255, 255, 160));
 	}
+}
 
-	ImGui::End();
+void		ProfilerPanel::DrawCapture(void) noexcept
+{
+	if (ProfilerCapture::IsCapturing())
+	{
+		if (ImGui::Button("Stop capture"))
+			ProfilerCapture::Stop();
+		ImGui::SameLine();
+		ImGui::Text("%llu frames captured, %llu lost", static_cast< unsigned long long >(ProfilerCapture::GetWrittenFrameCount()), static_cast< unsigned long long >(ProfilerCapture::GetLostFrameCount()));
+		return ;
+	}
+
+	if (ImGui::Button("Start capture"))
+	{
+		if (_binaryCapture)
+			ProfilerCapture::Start(std::string(CapturePath) + ProfilerCapture::BinaryExtension, ProfilerCaptureFormat::Binary);
+		else
+			ProfilerCapture::Start(std::string(CapturePath) + ".json", ProfilerCaptureFormat::ChromeTrace);
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Binary", &_binaryCapture);
+}
+
+void		ProfilerPanel::DrawSummary(void) noexcept
+{
+	ImGui::Columns(3, "ProfilerSummary");
+	ImGui::Text("Name"); ImGui::NextColumn();
+	ImGui::Text("Total (ms)"); ImGui::NextColumn();
+	ImGui::Text("Count"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (const auto & entry : _summary)
+	{
+		ImGui::Text("%s", GetName(entry.name).c_str()); ImGui::NextColumn();
+		ImGui::Text("%.3f", entry.totalDuration); ImGui::NextColumn();
+		ImGui::Text("%u", entry.count); ImGui::NextColumn();
+	}
+
+	ImGui::Columns(1);
 }
 
 std::ostream &	operator<<(std::ostream & o, ProfilerPanel const & r)
@@ -5,25 +5,50 @@
 #include "Core/GameObject.hpp"
 #include "Core/Components/ImGUIPanel.hpp"
 #include "Core/Profiler.hpp"
+#include "Core/Delegate.tpp"
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
 
 namespace LWGC
 {
 	class		ProfilerPanel : public ImGUIPanel
 	{
 		private:
-			ProfilingSamples		_currentSample;
-			std::vector< float >	_frameDurationHistory;
+			struct	SummaryEntry
+			{
+				ProfilerNameId	name;
+				double			totalDuration;	// in milliseconds
+				uint32_t		count;
+			};
+
+			ProfilerFrame										_frame;
+			uint64_t											_timelineEnd;	// GPU scopes end after the CPU frame
+			std::vector< float >								_frameDurationHistory;
+			std::vector< SummaryEntry >							_summary;
+			std::map< uint32_t, uint32_t >						_threadDepths;	// thread index -> deepest scope
+			std::unordered_map< ProfilerNameId, std::string >	_names;
+			std::unordered_map< uint32_t, std::string >			_threadNames;
+			DelegateIndex< void(void) >							_updateIndex;
+			bool												_paused;
+			bool												_binaryCapture;
 
 			const size_t		HISTORY_SIZE = 128;
+			const char *		CapturePath = "ProfilerCapture";
+
+			void				UpdateFrame(void);
+			const std::string &	GetName(ProfilerNameId name);
+			void				DrawTimeline(void) noexcept;
+			void				DrawSummary(void) noexcept;
+			void				DrawCapture(void) noexcept;
 
 		public:
 			ProfilerPanel(void);
 			ProfilerPanel(const ProfilerPanel &) = delete;
-			virtual ~ProfilerPanel(void) = default;
+			virtual ~ProfilerPanel(void);
 
 			ProfilerPanel &	operator=(ProfilerPanel const & src) = delete;
 
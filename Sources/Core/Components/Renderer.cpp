@@ -11,12 +11,12 @@
 
 using namespace LWGC;
 
-Renderer::Renderer(void)
+Renderer::Renderer(void) : _castShadows(true), _static(false)
 {
 	_material = Material::Create();
 }
 
-Renderer::Renderer(Material * material)
+Renderer::Renderer(Material * material) : _castShadows(true), _static(false)
 {
 	_material = material;
 }
@@ -82,11 +82,27 @@ void		Renderer::RecordCommands(VkCommandBuffer cmd)
 	RecordDrawCommand(cmd);
 }
 
+void		Renderer::RecordDepthCommands(VkCommandBuffer cmd)
+{
+	RecordDepthDrawCommand(cmd);
+}
+
+void		Renderer::RecordDepthDrawCommand(VkCommandBuffer cmd) noexcept
+{
+	(void)cmd;
+}
+
 Material *	Renderer::GetMaterial(void) { return (this->_material); }
 void						Renderer::SetMaterial(Material * tmp) { this->_material = tmp; }
 
 VkDescriptorSet				Renderer::GetDescriptorSet(void) { return _perRendererSet.GetDescriptorSet(); }
 
+bool						Renderer::GetCastShadows(void) const noexcept { return _castShadows; }
+void						Renderer::SetCastShadows(bool castShadows) noexcept { _castShadows = castShadows; }
+
+bool						Renderer::IsStatic(void) const noexcept { return _static; }
+void						Renderer::SetStatic(bool isStatic) noexcept { _static = isStatic; }
+
 std::ostream &	operator<<(std::ostream & o, Renderer const & r)
 {
 	o << "Renderer" << std::endl;
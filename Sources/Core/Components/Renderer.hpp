@@ -24,11 +24,15 @@ namespace LWGC
 			ComponentIndex		_renderContextIndex;
 			UniformBuffer		_uniformModelBuffer;
 			DescriptorSet		_perRendererSet;
+			bool				_castShadows;
+			bool				_static;
 
 		protected:
 
 			void			Initialize(void) noexcept override;
 			virtual void	RecordDrawCommand(VkCommandBuffer cmd) noexcept = 0;
+			// Draw with only the positions bound at the location 0, the renderers without it don't cast shadows
+			virtual void	RecordDepthDrawCommand(VkCommandBuffer cmd) noexcept;
 			virtual void	UpdateUniformData(void);
 			void			Update(void) noexcept override;
 
@@ -43,6 +47,7 @@ namespace LWGC
 
 			virtual Bounds	GetBounds(void) noexcept;
 			virtual void	RecordCommands(VkCommandBuffer cmd);
+			virtual void	RecordDepthCommands(VkCommandBuffer cmd);
 
 			void	OnEnable(void) noexcept override;
 			void	OnDisable(void) noexcept override;
@@ -52,6 +57,14 @@ namespace LWGC
 
 			VkDescriptorSet		GetDescriptorSet(void);
 
+			bool	GetCastShadows(void) const noexcept;
+			void	SetCastShadows(bool castShadows) noexcept;
+
+			// A static renderer never moves, its shadows are cached: call ShadowMaps::InvalidateStaticShadows
+			// if it's moved anyway
+			bool	IsStatic(void) const noexcept;
+			void	SetStatic(bool isStatic) noexcept;
+
 			virtual uint32_t	GetType(void) const noexcept override = 0;
 	};
 
@@ -114,6 +114,11 @@ void				EventSystem::UpdateMousePosition(void)
 {
 	double posX;
 	double posY;
+
+	// No window is bound when the application is headless
+	if (_window == nullptr)
+		return ;
+
 	glfwGetCursorPos(_window, &posX, &posY);
 
 	// If the cursor is lock, the only possible position is the middle of the screen
@@ -128,6 +133,8 @@ void				EventSystem::UpdateMousePosition(void)
 void				EventSystem::LockCursor(void)
 {
 #ifndef linux // does not work on linux
+	if (_window == nullptr)
+		return ;
 	glfwSetInputMode(_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	UpdateMousePosition();
 #endif
@@ -135,6 +142,8 @@ void				EventSystem::LockCursor(void)
 
 void				EventSystem::ReleaseCursor(void)
 {
+	if (_window == nullptr)
+		return ;
 	glfwSetInputMode(_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 	UpdateMousePosition();
 }
@@ -149,7 +158,7 @@ void				EventSystem::ToggleLockCursor(void)
 
 bool				EventSystem::IsCursorLocked(void)
 {
-	return glfwGetInputMode(_window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED;
+	return _window != nullptr && glfwGetInputMode(_window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED;
 }
 
 const glm::vec2		EventSystem::GetNormalizedCursorPosition(void) const
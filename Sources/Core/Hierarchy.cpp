@@ -35,6 +35,15 @@ void Hierarchy::AddGameObject(GameObject * gameObject)
 
 	if (_initialized)
 		gameObject->Initialize();
+
+	// Children added with GameObject::AddChild (ModelLoader for example) are not in the hierarchy yet
+	for (auto child : gameObject->GetTransform()->GetChilds())
+	{
+		GameObject * childGameObject = child->GetGameObject();
+
+		if (childGameObject != nullptr && childGameObject->GetHierarchy() != this)
+			AddGameObject(childGameObject);
+	}
 }
 
 void Hierarchy::RemoveGameObject(GameObject * gameObject)
@@ -20,6 +20,10 @@ ImGUIWrapper::ImGUIWrapper(void)
 
 ImGUIWrapper::~ImGUIWrapper(void)
 {
+	// Not initialized when the application is headless
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
 	// Cleanup
     const auto & err = vkDeviceWaitIdle(_device);
     Vk::CheckResult(err, "ImGUI Wait Idle failed");
@@ -268,6 +272,8 @@ void		ImGUIWrapper::EndFrame(void)
 		ImGui::RenderPlatformWindowsDefault();
 	}
 
+	// The GUI is drawn on top of the swap chain image acquired by the pipeline
+	_wd.FrameIndex = RenderPipelineManager::currentRenderPipeline->GetCurrentImageIndex();
 	ImGui_ImplVulkanH_Frame* fd = &_wd.Frames[_wd.FrameIndex];
 	{
 		err = vkResetCommandBuffer(fd->CommandBuffer, 0);
@@ -301,8 +307,6 @@ void		ImGUIWrapper::EndFrame(void)
 		Vk::CheckResult(err, "Error while rendering GUI");
 		RenderPipelineManager::currentRenderPipeline->EnqueueFrameCommandBuffer(fd->CommandBuffer);
 	}
-
-	_wd.FrameIndex = (_wd.FrameIndex + 1) % _swapChain->GetImageCount();
 }
 
 
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace LWGC
+{
+	// Must match the LWGC_LIGHT_* values in the shaders
+	enum class LightType
+	{
+		Directional,
+		Point,
+		Spot,
+	};
+}
@@ -1,5 +1,9 @@
 #include "MaterialTable.hpp"
 
+#include "Core/Application.hpp"
+
+#include <algorithm>
+
 using namespace LWGC;
 
 std::unordered_map<ShaderProgram *, std::vector< Material * > > MaterialTable::_shadersPrograms;
@@ -14,26 +18,65 @@ MaterialTable::MaterialTable(void) : _swapChain(nullptr), _renderPass(nullptr),
 
 MaterialTable::~MaterialTable(void)
 {
+	if (_initialized)
+		Application::update.RemoveListener(_hotReloadIndex);
 }
 
-void MaterialTable::UpdateMaterial(ShaderProgram *shaderProgram) noexcept
+bool	MaterialTable::UpdateMaterial(ShaderProgram * shaderProgram, ShaderProgram * reloadedProgram) noexcept
 {
-	auto materials = _shadersPrograms[shaderProgram];
+	std::vector< std::pair< Material *, Material::ProgramPipelines > >	pipelines;
+
+	try {
+		for (auto material : _shadersPrograms[shaderProgram])
+			if (material->IsInitialized())
+				pipelines.emplace_back(material, material->CreateProgramPipelines(reloadedProgram));
+	} catch (const std::runtime_error & e) {
+		std::cerr << e.what() << std::endl;
+		for (const auto & pipeline : pipelines)
+			pipeline.first->DestroyProgramPipelines(pipeline.second);
+		return false;
+	}
 
-	for (auto material: materials)
+	// The modules and layouts move to shaderProgram, which the materials keep using
+	shaderProgram->Swap(*reloadedProgram);
+
+	// The pipelines of the keyword variants cached by the materials are created again on the next switch
+	for (auto material : _objects)
+		if (material->IsInitialized())
+			material->ReleaseCachedVariants(shaderProgram);
+
+	for (auto & pipeline : pipelines)
 	{
-		try {
-			material->ReloadShaders();
-		} catch (const std::runtime_error & e) {
-			std::cout << e.what() << std::endl;
-		}
+		pipeline.second.program = shaderProgram;
+		pipeline.first->ApplyProgramPipelines(pipeline.second);
 	}
+
+	return true;
 }
 
 void	MaterialTable::RegsiterObject(Material * material)
 {
 	ObjectTable::RegsiterObject(material);
-	_shadersPrograms[material->GetShaderProgram()].push_back(material);
+	auto & materials = _shadersPrograms[material->GetShaderProgram()];
+
+	materials.push_back(material);
+	if (materials.size() == 1)
+		_hotReload.Register(material->GetShaderProgram());
+}
+
+void	MaterialTable::UpdateMaterialProgram(Material * material, ShaderProgram * oldProgram)
+{
+	auto & oldMaterials = _shadersPrograms[oldProgram];
+	auto & materials = _shadersPrograms[material->GetShaderProgram()];
+
+	oldMaterials.erase(std::remove(oldMaterials.begin(), oldMaterials.end(), material), oldMaterials.end());
+	// Unused programs are not precompiled by Initialize
+	if (oldMaterials.empty())
+		_shadersPrograms.erase(oldProgram);
+
+	materials.push_back(material);
+	if (materials.size() == 1)
+		_hotReload.Register(material->GetShaderProgram());
 }
 
 void 	MaterialTable::Initialize(LWGC::SwapChain *swapChain , LWGC::RenderPass *renderPipeline)
@@ -41,14 +84,43 @@ void 	MaterialTable::Initialize(LWGC::SwapChain *swapChain , LWGC::RenderPass *r
 	_swapChain = swapChain;
 	_renderPass = renderPipeline;
 
+	std::vector< ShaderProgram * >	programs;
+	for (const auto & program : _shadersPrograms)
+		programs.push_back(program.first);
+	ShaderProgram::Precompile(programs);
+
 	for (auto material : _objects)
 	{
 		material->Initialize(_swapChain, _renderPass);
 	}
 
+	_hotReload.Start();
+	_hotReloadIndex = Application::update.AddListener(std::bind(&MaterialTable::Update, this));
+
 	_initialized = true;
 }
 
+void	MaterialTable::UpdateKeywordVariant(Material * material)
+{
+	if (material->UpdateKeywordVariant())
+		_pendingVariants.erase(material);
+	else
+		_pendingVariants.insert(material);
+}
+
+void	MaterialTable::Update(void)
+{
+	_hotReload.Update();
+
+	for (auto material = _pendingVariants.begin(); material != _pendingVariants.end();)
+	{
+		if ((*material)->UpdateKeywordVariant())
+			material = _pendingVariants.erase(material);
+		else
+			++material;
+	}
+}
+
 void	MaterialTable::NotifyMaterialReady(Material * material)
 {
 	if (_renderPass && _swapChain)
@@ -67,6 +139,12 @@ void	MaterialTable::RecreateAll(void)
 	}
 }
 
+void	MaterialTable::NotifyTexturesChanged(const std::unordered_set< const Texture * > & textures)
+{
+	for (auto material : _objects)
+		material->RebindTextures(textures);
+}
+
 void	MaterialTable::SetRenderPass(RenderPass * renderPass) { _renderPass = renderPass; }
 bool	MaterialTable::IsInitialized(void) const noexcept { return _initialized; }
 
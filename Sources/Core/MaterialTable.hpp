@@ -5,6 +5,8 @@
 #include <vector>
 #include "Core/Vulkan/Material.hpp"
 #include "Core/ObjectTable.tpp"
+#include "Core/Delegate.tpp"
+#include "Core/Shaders/ShaderHotReload.hpp"
 
 namespace LWGC
 {
@@ -12,15 +14,28 @@ namespace LWGC
 	{
 		friend class Material;
 		friend class ShaderProgram;
+		friend class ShaderHotReload;
 
 		private:
 			LWGC::SwapChain *														_swapChain;
 			LWGC::RenderPass *														_renderPass;
 			static std::unordered_map<ShaderProgram *, std::vector< Material * > >	_shadersPrograms;
 			bool																	_initialized;
-
-			void 	UpdateMaterial(ShaderProgram *shaderProgram) noexcept;
+			ShaderHotReload															_hotReload;
+			DelegateIndex< void(void) >												_hotReloadIndex;
+			// Materials waiting for the compilation of their keyword variant
+			std::unordered_set< Material * >										_pendingVariants;
+
+			// Create the pipelines of the materials of the program with its recompiled version, then swap the
+			// program with it. Returns false and changes nothing if one of the pipelines can't be created
+			bool 	UpdateMaterial(ShaderProgram * shaderProgram, ShaderProgram * reloadedProgram) noexcept;
 			void 	NotifyMaterialReady(Material * material);
+			// Move the material to the materials of its new shader program (keyword change)
+			void	UpdateMaterialProgram(Material * material, ShaderProgram * oldProgram);
+			// Switch the material to its keyword variant, or wait for the variant to be compiled
+			void	UpdateKeywordVariant(Material * material);
+			// Shader hot reload and pending keyword variants, once per frame
+			void	Update(void);
 
 		public:
 			MaterialTable(void);
@@ -32,6 +47,7 @@ namespace LWGC
 			void	RecreateAll(void);
 			bool	IsInitialized(void) const noexcept;
 			void	SetRenderPass(RenderPass * renderPass);
+			void	NotifyTexturesChanged(const std::unordered_set< const Texture * > & textures);
 
 			MaterialTable &	operator=(MaterialTable const & src) = delete;
 
@@ -1,12 +1,14 @@
 #include "Mesh.hpp"
 
 #include "Core/Vulkan/Vk.hpp"
+#include "Core/MeshSimplifier.hpp"
 
 using namespace LWGC;
 
 Mesh::Mesh(void) :	_instance(nullptr), _device(VK_NULL_HANDLE),
 					_vertexBuffer(VK_NULL_HANDLE), _vertexBufferMemory(VK_NULL_HANDLE),
-					_indexBuffer(VK_NULL_HANDLE), _indexBufferMemory(VK_NULL_HANDLE)
+					_indexBuffer(VK_NULL_HANDLE), _indexBufferMemory(VK_NULL_HANDLE),
+					_positionBuffer(VK_NULL_HANDLE), _positionBufferMemory(VK_NULL_HANDLE)
 {
 }
 
@@ -28,6 +30,12 @@ Mesh::~Mesh(void)
 		vkDestroyBuffer(_device, _vertexBuffer, nullptr);
 		vkFreeMemory(_device, _vertexBufferMemory, nullptr);
 	}
+
+	if (_positionBuffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(_device, _positionBuffer, nullptr);
+		vkFreeMemory(_device, _positionBufferMemory, nullptr);
+	}
 }
 
 void	Mesh::AddVertexAttribute(const VertexAttributes & attrib)
@@ -55,6 +63,7 @@ void		Mesh::UploadDatas(void)
 	if (_attributes.size() <= 0)
 		throw std::runtime_error("Can't create a mesh with zero vertices");
 	CreateVertexBuffer();
+	CreatePositionBuffer();
 
 	if (_indices.size() > 0)
 		CreateIndexBuffer();
@@ -72,9 +81,39 @@ void		Mesh::Clear(void)
 {
 	_attributes.clear();
 	_indices.clear();
+	_lods.clear();
+	_lodIndices.clear();
 	_bounds = Bounds();
 }
 
+void		Mesh::GenerateLODs(int lodCount, float reduction)
+{
+	std::vector< glm::vec3 >	positions;
+	std::vector< float >		errors;
+
+	_lods.clear();
+	_lodIndices.clear();
+
+	if (_indices.size() == 0)
+		return ;
+
+	positions.reserve(_attributes.size());
+	for (const auto & a : _attributes)
+		positions.push_back(a.position);
+
+	auto chain = MeshSimplifier::GenerateLODChain(positions, _indices, lodCount, reduction, &errors);
+
+	// LOD 0 is _indices, the others are stored after it in the index buffer
+	uint32_t firstIndex = 0;
+	for (size_t i = 0; i < chain.size(); i++)
+	{
+		_lods.push_back(LOD{firstIndex, static_cast< uint32_t >(chain[i].size()), errors[i]});
+		if (i > 0)
+			_lodIndices.insert(_lodIndices.end(), chain[i].begin(), chain[i].end());
+		firstIndex += chain[i].size();
+	}
+}
+
 
 Mesh &	Mesh::operator=(Mesh const & src)
 {
@@ -85,9 +124,13 @@ Mesh &	Mesh::operator=(Mesh const & src)
 		this->_vertexBufferMemory = src._vertexBufferMemory;
 		this->_indexBuffer = src._indexBuffer;
 		this->_indexBufferMemory = src._indexBufferMemory;
+		this->_positionBuffer = src._positionBuffer;
+		this->_positionBufferMemory = src._positionBufferMemory;
 		this->_attributes = src._attributes;
 		this->_indices = src._indices;
 		this->_bounds = src._bounds;
+		this->_lods = src._lods;
+		this->_lodIndices = src._lodIndices;
 	}
 	return (*this);
 }
@@ -136,6 +179,29 @@ std::array< VkVertexInputBindingDescription, 1 >	Mesh::GetBindingDescription(voi
 	return bindingDescription;
 }
 
+std::array< VkVertexInputAttributeDescription, 1 >	Mesh::GetPositionAttributeDescriptions(void)
+{
+	std::array< VkVertexInputAttributeDescription, 1 > attributeDescriptions = {};
+
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+	attributeDescriptions[0].offset = 0;
+
+	return attributeDescriptions;
+}
+
+std::array< VkVertexInputBindingDescription, 1 >	Mesh::GetPositionBindingDescription(void)
+{
+	std::array< VkVertexInputBindingDescription, 1 > bindingDescription = {};
+
+	bindingDescription[0].binding = 0;
+	bindingDescription[0].stride = sizeof(glm::vec3);
+	bindingDescription[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	return bindingDescription;
+}
+
 void				Mesh::CreateVertexBuffer()
 {
 	VkDeviceSize bufferSize = sizeof(VertexAttributes) * _attributes.size();
@@ -153,15 +219,40 @@ void				Mesh::CreateVertexBuffer()
 	vkFreeMemory(_device, stagingBufferMemory, nullptr);
 }
 
+// The depth only passes fetch 12 bytes per vertex instead of the 56 of the interleaved attributes
+void				Mesh::CreatePositionBuffer()
+{
+	std::vector< glm::vec3 >	positions(_attributes.size());
+	VkDeviceSize				bufferSize = sizeof(glm::vec3) * positions.size();
+
+	for (size_t i = 0; i < _attributes.size(); i++)
+		positions[i] = _attributes[i].position;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	Vk::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	Vk::UploadToMemory(stagingBufferMemory, positions.data(), bufferSize);
+
+	Vk::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _positionBuffer, _positionBufferMemory);
+	Vk::CopyBuffer(stagingBuffer, _positionBuffer, bufferSize);
+
+	vkDestroyBuffer(_device, stagingBuffer, nullptr);
+	vkFreeMemory(_device, stagingBufferMemory, nullptr);
+}
+
 void				Mesh::CreateIndexBuffer()
 {
-	VkDeviceSize bufferSize = sizeof(uint32_t) * _indices.size();
+	VkDeviceSize baseSize = sizeof(uint32_t) * _indices.size();
+	VkDeviceSize bufferSize = baseSize + sizeof(uint32_t) * _lodIndices.size();
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
 	Vk::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 
-	Vk::UploadToMemory(stagingBufferMemory, _indices.data(), bufferSize);
+	Vk::UploadToMemory(stagingBufferMemory, _indices.data(), baseSize);
+	if (_lodIndices.size() > 0)
+		Vk::UploadToMemory(stagingBufferMemory, _lodIndices.data(), bufferSize - baseSize, baseSize);
 
 	Vk::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, _indexBufferMemory);
 	Vk::CopyBuffer(stagingBuffer, _indexBuffer, bufferSize);
@@ -179,6 +270,15 @@ void				Mesh::BindBuffers(VkCommandBuffer cmd)
 		vkCmdBindIndexBuffer(cmd, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 }
 
+void				Mesh::BindPositionBuffers(VkCommandBuffer cmd)
+{
+	VkBuffer vertexBuffers[] = {_positionBuffer};
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+	if (_indices.size() > 0)
+		vkCmdBindIndexBuffer(cmd, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
 void				Mesh::Draw(VkCommandBuffer cmd)
 {
 	if (_indices.size() > 0)
@@ -187,8 +287,45 @@ void				Mesh::Draw(VkCommandBuffer cmd)
 		vkCmdDraw(cmd, _attributes.size(), 1, 0, 0);
 }
 
+void				Mesh::SetRawData(const VertexAttributes * attributes, size_t vertexCount, const int * indices, size_t indexCount, const Bounds & bounds)
+{
+	_attributes.assign(attributes, attributes + vertexCount);
+	_indices.assign(indices, indices + indexCount);
+	_bounds = bounds;
+	_lods.clear();
+	_lodIndices.clear();
+}
+
+void				Mesh::SetRawLODs(const LOD * lods, size_t lodCount, const int * lodIndices, size_t lodIndexCount)
+{
+	_lods.assign(lods, lods + lodCount);
+	_lodIndices.assign(lodIndices, lodIndices + lodIndexCount);
+}
+
+const std::vector< Mesh::LOD > &	Mesh::GetLODs(void) const { return _lods; }
+const std::vector< int > &		Mesh::GetLODIndices(void) const { return _lodIndices; }
+
+Mesh::LOD			Mesh::GetLOD(int lod) const
+{
+	if (_lods.size() == 0)
+		return LOD{0, static_cast< uint32_t >(_indices.size()), 0};
+
+	// Same clamp as Draw, a bad index from a LODGroup must not throw while recording
+	return _lods[std::min(std::max(lod, 0), static_cast< int >(_lods.size()) - 1)];
+}
+
+void				Mesh::Draw(VkCommandBuffer cmd, int lod)
+{
+	if (_lods.size() == 0)
+		return Draw(cmd);
+
+	const LOD & l = _lods[std::min(std::max(lod, 0), static_cast< int >(_lods.size()) - 1)];
+	vkCmdDrawIndexed(cmd, l.indexCount, 1, l.firstIndex, 0, 0);
+}
+
 std::vector< int >				Mesh::GetIndices(void) const { return _indices; }
-void							Mesh::SetIndices(const std::vector< int > & tmp) { _indices = tmp; }
+void							Mesh::SetIndices(const std::vector< int > & tmp) { _indices = tmp; _lods.clear(); _lodIndices.clear(); }
+int								Mesh::GetLODCount(void) const { return std::max(static_cast< int >(_lods.size()), 1); }
 std::vector< Mesh::VertexAttributes >	Mesh::GetVertexAttributes(void) const { return _attributes; }
 void							Mesh::SetVertexAttributes(const std::vector< Mesh::VertexAttributes > & tmp) { _attributes = tmp; RecalculateBounds(); }
 
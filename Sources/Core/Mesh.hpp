@@ -37,6 +37,14 @@ namespace LWGC
 				static void EdgeVertexAttrib(const glm::vec3 & p0, const glm::vec3 & p1, Mesh::VertexAttributes * targetAttribs) noexcept;
 			};
 
+			// LODs share the vertex buffer, only the indices are different
+			struct LOD
+			{
+				uint32_t	firstIndex;
+				uint32_t	indexCount;
+				float		error;
+			};
+
 			Mesh(void);
 			Mesh(const Mesh &);
 			virtual ~Mesh(void);
@@ -51,13 +59,28 @@ namespace LWGC
 			void	RecalculateBounds(void);
 			void	UploadDatas(void);
 			void	BindBuffers(VkCommandBuffer cmd);
+			// Binds the position only stream instead of the interleaved vertices, for the depth only passes
+			void	BindPositionBuffers(VkCommandBuffer cmd);
 			void	Draw(VkCommandBuffer cmd);
+			void	Draw(VkCommandBuffer cmd, int lod);
 			void	Clear(void);
 
 			// transform operation on vertices
 			void	Translate(const glm::vec3 & translation);
 			void	Rotate(const glm::quat & rotation);
 
+			// Must be called before UploadDatas, reduction is the triangle ratio between two consecutive levels
+			void	GenerateLODs(int lodCount, float reduction = 0.5f);
+			int		GetLODCount(void) const;
+			LOD		GetLOD(int lod) const;
+
+			const std::vector< LOD > &	GetLODs(void) const;
+			const std::vector< int > &	GetLODIndices(void) const;
+
+			// Fill the mesh from already processed streams (binary cache), bounds are not recalculated
+			void	SetRawData(const VertexAttributes * attributes, size_t vertexCount, const int * indices, size_t indexCount, const Bounds & bounds);
+			void	SetRawLODs(const LOD * lods, size_t lodCount, const int * lodIndices, size_t lodIndexCount);
+
 			std::vector< int >			GetIndices(void) const;
 			void						SetIndices(const std::vector< int > & tmp);
 			std::vector< VertexAttributes >	GetVertexAttributes(void) const;
@@ -65,11 +88,16 @@ namespace LWGC
 
 			static std::array< VkVertexInputAttributeDescription, 5 >	GetAttributeDescriptions(void);
 			static std::array< VkVertexInputBindingDescription, 1 >		GetBindingDescription(void);
+			// Layout of the position only stream, the position is at the location 0 like in the interleaved one
+			static std::array< VkVertexInputAttributeDescription, 1 >	GetPositionAttributeDescriptions(void);
+			static std::array< VkVertexInputBindingDescription, 1 >		GetPositionBindingDescription(void);
 
 		private:
 			std::vector< int >			_indices;
 			std::vector< VertexAttributes >	_attributes;
 			Bounds						_bounds;
+			std::vector< LOD >			_lods;
+			std::vector< int >			_lodIndices;
 			VulkanInstance *			_instance;
 			VkDevice					_device;
 
@@ -77,9 +105,12 @@ namespace LWGC
 			VkDeviceMemory				_vertexBufferMemory;
 			VkBuffer					_indexBuffer;
 			VkDeviceMemory				_indexBufferMemory;
+			VkBuffer					_positionBuffer;
+			VkDeviceMemory				_positionBufferMemory;
 
 			void		CreateVertexBuffer();
 			void		CreateIndexBuffer();
+			void		CreatePositionBuffer();
 
 	};
 
@@ -0,0 +1,316 @@
+#include "MeshCache.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <thread>
+
+#include "Utils/MappedFile.hpp"
+#include "Utils/Utils.hpp"
+
+using namespace LWGC;
+
+const std::string	MeshCache::MeshExtension = ".lwgcmesh";
+const std::string	MeshCache::SceneExtension = ".lwgcscene";
+std::string			MeshCache::_directory = "Cache/Models/";
+std::mutex			MeshCache::_directoryMutex;
+
+static const size_t	StreamAlignment = 16;
+
+void				MeshCache::Writer::WriteBytes(const void * data, size_t size)
+{
+	const uint8_t * bytes = static_cast< const uint8_t * >(data);
+	_data.insert(_data.end(), bytes, bytes + size);
+}
+
+void				MeshCache::Writer::WriteString(const std::string & str)
+{
+	Write< uint32_t >(static_cast< uint32_t >(str.size()));
+	WriteBytes(str.data(), str.size());
+}
+
+void				MeshCache::Writer::Align(size_t alignment)
+{
+	_data.resize((_data.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+size_t				MeshCache::Writer::GetSize(void) const { return _data.size(); }
+
+bool				MeshCache::Writer::SaveToFile(const std::string & path) const
+{
+	// The thread id is needed too as the shader cache can write the same entry from several threads
+	std::string		tmpPath = path + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(std::hash< std::thread::id >()(std::this_thread::get_id()));
+	std::ofstream	file(tmpPath, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file.write(reinterpret_cast< const char * >(_data.data()), _data.size());
+	file.close();
+
+	if (!file || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+MeshCache::Reader::Reader(const uint8_t * data, size_t size) : _data(data), _size(size), _offset(0)
+{
+}
+
+const void *		MeshCache::Reader::ReadBytes(size_t size)
+{
+	if (size > _size - _offset)
+		throw std::runtime_error("Unexpected end of file in mesh cache");
+
+	const void * data = _data + _offset;
+	_offset += size;
+	return data;
+}
+
+std::string			MeshCache::Reader::ReadString(void)
+{
+	uint32_t size = Read< uint32_t >();
+	return std::string(static_cast< const char * >(ReadBytes(size)), size);
+}
+
+uint32_t			MeshCache::Reader::ReadCount(size_t minElementSize)
+{
+	uint32_t	count = Read< uint32_t >();
+
+	// A larger count can only come from a corrupted file, it must not reach a resize
+	if (count > GetRemainingSize() / minElementSize)
+		throw std::runtime_error("Element count larger than the file in mesh cache");
+
+	return count;
+}
+
+void				MeshCache::Reader::Align(size_t alignment)
+{
+	_offset = std::min(_size, (_offset + alignment - 1) / alignment * alignment);
+}
+
+size_t				MeshCache::Reader::GetRemainingSize(void) const noexcept
+{
+	return _size - _offset;
+}
+
+uint64_t			MeshCache::HashBytes(const void * data, size_t size, uint64_t hash)
+{
+	const uint8_t * bytes = static_cast< const uint8_t * >(data);
+
+	// FNV-1a
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+uint64_t			MeshCache::HashFile(const std::string & path)
+{
+	MappedFile	file;
+
+	if (!file.Open(path))
+		return 0;
+
+	return HashBytes(file.GetData(), file.GetSize());
+}
+
+bool				MeshCache::GetSourceFile(const std::string & path, SourceFile & source)
+{
+	struct stat	info;
+
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+
+	source.path = path;
+	source.size = static_cast< uint64_t >(info.st_size);
+	source.time = static_cast< int64_t >(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+	source.hash = 0;
+
+	return true;
+}
+
+uint64_t			MeshCache::GetSourceHash(SourceFile & source)
+{
+	if (source.hash == 0)
+		source.hash = HashFile(source.path);
+
+	return source.hash;
+}
+
+std::string			MeshCache::GetCachePath(const std::string & sourcePath, const std::string & extension)
+{
+	char	hash[17];
+
+	// The name keeps the cache readable, the hash of the path separates the files with the same name
+	snprintf(hash, sizeof(hash), "%016llx", static_cast< unsigned long long >(HashBytes(sourcePath.data(), sourcePath.size())));
+
+	return _directory + GetFileName(sourcePath) + "_" + hash + extension;
+}
+
+bool				MeshCache::CreateCacheDirectory(void)
+{
+	std::lock_guard< std::mutex >	lock(_directoryMutex);
+
+	return CreateDirectories(_directory);
+}
+
+void				MeshCache::WriteHeader(Writer & writer, uint32_t magic, SourceFile & source, uint64_t settingsHash)
+{
+	FileHeader	header = {};
+
+	header.magic = magic;
+	header.version = Version;
+	header.sourceHash = GetSourceHash(source);
+	header.sourceSize = source.size;
+	header.sourceTime = source.time;
+	header.settingsHash = settingsHash;
+	header.vertexStride = sizeof(Mesh::VertexAttributes);
+
+	writer.Write(header);
+	writer.Align(StreamAlignment);
+}
+
+bool				MeshCache::ReadHeader(Reader & reader, uint32_t magic, SourceFile & source, uint64_t settingsHash, bool * outdatedTime)
+{
+	FileHeader	header = reader.Read< FileHeader >();
+
+	reader.Align(StreamAlignment);
+
+	if (outdatedTime != nullptr)
+		*outdatedTime = false;
+
+	// The vertex layout is hardcoded, a cache from another build with a different layout is invalid
+	if (header.magic != magic
+		|| header.version != Version
+		|| header.settingsHash != settingsHash
+		|| header.vertexStride != sizeof(Mesh::VertexAttributes))
+		return false;
+
+	if (header.sourceSize == source.size && header.sourceTime == source.time)
+	{
+		source.hash = header.sourceHash;
+		return true;
+	}
+
+	// Only a file of the same size can have the same content
+	if (header.sourceSize != source.size || header.sourceHash != GetSourceHash(source))
+		return false;
+
+	if (outdatedTime != nullptr)
+		*outdatedTime = true;
+	return true;
+}
+
+void				MeshCache::WriteMesh(Writer & writer, const Mesh & mesh)
+{
+	MeshHeader	header = {};
+	auto		attributes = mesh.GetVertexAttributes();
+	auto		indices = mesh.GetIndices();
+	Bounds		bounds = mesh.GetBounds();
+
+	header.vertexCount = attributes.size();
+	header.indexCount = indices.size();
+	header.lodCount = mesh.GetLODs().size();
+	header.lodIndexCount = mesh.GetLODIndices().size();
+	header.boundsMin[0] = bounds.GetMinX(); header.boundsMin[1] = bounds.GetMinY(); header.boundsMin[2] = bounds.GetMinZ();
+	header.boundsMax[0] = bounds.GetMaxX(); header.boundsMax[1] = bounds.GetMaxY(); header.boundsMax[2] = bounds.GetMaxZ();
+
+	writer.Write(header);
+	writer.Align(StreamAlignment);
+	writer.WriteBytes(attributes.data(), attributes.size() * sizeof(Mesh::VertexAttributes));
+	writer.Align(StreamAlignment);
+	// LOD 0 and the other levels are contiguous, like in the index buffer
+	writer.WriteBytes(indices.data(), indices.size() * sizeof(int));
+	writer.WriteBytes(mesh.GetLODIndices().data(), mesh.GetLODIndices().size() * sizeof(int));
+	writer.Align(StreamAlignment);
+	writer.WriteBytes(mesh.GetLODs().data(), mesh.GetLODs().size() * sizeof(Mesh::LOD));
+	writer.Align(StreamAlignment);
+}
+
+static void			ValidateIndices(const int * indices, size_t indexCount, uint32_t vertexCount)
+{
+	for (size_t i = 0; i < indexCount; i++)
+		if (indices[i] < 0 || static_cast< uint32_t >(indices[i]) >= vertexCount)
+			throw std::runtime_error("Vertex index out of range in mesh cache");
+}
+
+std::shared_ptr< Mesh >	MeshCache::ReadMesh(Reader & reader)
+{
+	MeshHeader	header = reader.Read< MeshHeader >();
+	auto		mesh = std::make_shared< Mesh >();
+
+	reader.Align(StreamAlignment);
+	auto attributes = static_cast< const Mesh::VertexAttributes * >(reader.ReadBytes(header.vertexCount * sizeof(Mesh::VertexAttributes)));
+	reader.Align(StreamAlignment);
+	auto indices = static_cast< const int * >(reader.ReadBytes(header.indexCount * sizeof(int)));
+	auto lodIndices = static_cast< const int * >(reader.ReadBytes(header.lodIndexCount * sizeof(int)));
+	reader.Align(StreamAlignment);
+	auto lods = static_cast< const Mesh::LOD * >(reader.ReadBytes(header.lodCount * sizeof(Mesh::LOD)));
+	reader.Align(StreamAlignment);
+
+	// The indices and the LOD ranges end up in the index buffer and the draws
+	ValidateIndices(indices, header.indexCount, header.vertexCount);
+	ValidateIndices(lodIndices, header.lodIndexCount, header.vertexCount);
+	for (uint32_t i = 0; i < header.lodCount; i++)
+		if (static_cast< uint64_t >(lods[i].firstIndex) + lods[i].indexCount > static_cast< uint64_t >(header.indexCount) + header.lodIndexCount)
+			throw std::runtime_error("LOD range out of the index buffer in mesh cache");
+
+	Bounds bounds(
+		glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+		glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2])
+	);
+
+	mesh->SetRawData(attributes, header.vertexCount, indices, header.indexCount, bounds);
+	mesh->SetRawLODs(lods, header.lodCount, lodIndices, header.lodIndexCount);
+
+	return mesh;
+}
+
+bool				MeshCache::SaveMesh(const std::string & path, const Mesh & mesh, SourceFile & source, uint64_t settingsHash)
+{
+	Writer	writer;
+
+	WriteHeader(writer, MeshMagic, source, settingsHash);
+	WriteMesh(writer, mesh);
+
+	return writer.SaveToFile(path);
+}
+
+std::shared_ptr< Mesh >	MeshCache::LoadMesh(const std::string & path, SourceFile & source, uint64_t settingsHash)
+{
+	MappedFile	file;
+
+	if (!file.Open(path))
+		return nullptr;
+
+	try {
+		Reader	reader(file.GetData(), file.GetSize());
+
+		if (!ReadHeader(reader, MeshMagic, source, settingsHash))
+			return nullptr;
+
+		return ReadMesh(reader);
+	} catch (const std::exception & e) {
+		std::cerr << "Invalid mesh cache " << path << ": " << e.what() << std::endl;
+		return nullptr;
+	}
+}
+
+void				MeshCache::SetDirectory(const std::string & directory)
+{
+	_directory = directory;
+
+	if (!_directory.empty() && _directory.back() != '/')
+		_directory += '/';
+}
+
+const std::string &	MeshCache::GetDirectory(void) { return _directory; }
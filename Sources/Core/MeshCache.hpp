@@ -0,0 +1,132 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <stdexcept>
+#include <mutex>
+
+#include "Core/Mesh.hpp"
+
+namespace LWGC
+{
+	// Binary cache of processed meshes (.lwgcmesh) and scenes (.lwgcscene), written in Cache/Models/.
+	// Streams are stored with the same layout as the GPU buffers and 16 bytes aligned so a memory
+	// mapped file can be copied to the staging buffers without any parsing.
+	class		MeshCache
+	{
+		public:
+			static const uint32_t		Version = 2;
+			static const uint32_t		MeshMagic = 0x534D574C; // "LWMS"
+			static const uint32_t		SceneMagic = 0x4353574C; // "LWSC"
+			static const std::string	MeshExtension;
+			static const std::string	SceneExtension;
+
+			struct FileHeader
+			{
+				uint32_t	magic;
+				uint32_t	version;
+				uint64_t	sourceHash;
+				uint64_t	sourceSize;
+				int64_t		sourceTime;		// Modification time in nanoseconds
+				uint64_t	settingsHash;
+				uint32_t	vertexStride;
+				uint32_t	padding;
+			};
+
+			// Source file of a cache: it's identified by its size and modification time, the content is only
+			// hashed when they don't match the cache (a copy or a checkout of the same file) or to write one
+			struct SourceFile
+			{
+				std::string	path;
+				uint64_t	size = 0;
+				int64_t		time = 0;
+				uint64_t	hash = 0;	// 0 until GetSourceHash
+			};
+
+			struct MeshHeader
+			{
+				uint32_t	vertexCount;
+				uint32_t	indexCount;
+				uint32_t	lodCount;
+				uint32_t	lodIndexCount;
+				float		boundsMin[3];
+				float		boundsMax[3];
+			};
+
+			class Writer
+			{
+				private:
+					std::vector< uint8_t >	_data;
+
+				public:
+					template< typename T >
+					void	Write(const T & value) { WriteBytes(&value, sizeof(T)); }
+					void	WriteBytes(const void * data, size_t size);
+					void	WriteString(const std::string & str);
+					void	Align(size_t alignment);
+					size_t	GetSize(void) const;
+
+					// Write in a temporary file then rename it so a crash never leaves a truncated cache
+					bool	SaveToFile(const std::string & path) const;
+			};
+
+			class Reader
+			{
+				private:
+					const uint8_t *	_data;
+					size_t			_size;
+					size_t			_offset;
+
+				public:
+					Reader(const uint8_t * data, size_t size);
+
+					template< typename T >
+					T		Read(void) { T value; std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T)); return value; }
+					const void *	ReadBytes(size_t size);
+					std::string		ReadString(void);
+					// Count of the elements that follow, each one takes at least minElementSize bytes in the file
+					uint32_t		ReadCount(size_t minElementSize);
+					void			Align(size_t alignment);
+					size_t			GetRemainingSize(void) const noexcept;
+			};
+
+		private:
+			static std::string	_directory;
+			static std::mutex	_directoryMutex;
+
+		public:
+			MeshCache(void) = delete;
+			MeshCache(const MeshCache &) = delete;
+			virtual ~MeshCache(void) = delete;
+
+			MeshCache &	operator=(MeshCache const & src) = delete;
+
+			static uint64_t		HashFile(const std::string & path);
+			static uint64_t		HashBytes(const void * data, size_t size, uint64_t hash = 0xcbf29ce484222325);
+
+			// False when the source doesn't exist
+			static bool			GetSourceFile(const std::string & path, SourceFile & source);
+			static uint64_t		GetSourceHash(SourceFile & source);
+
+			// Path of the cache of a source file in the cache directory
+			static std::string	GetCachePath(const std::string & sourcePath, const std::string & extension);
+			// Creates the cache directory, false if it's not writable
+			static bool			CreateCacheDirectory(void);
+
+			static void						WriteHeader(Writer & writer, uint32_t magic, SourceFile & source, uint64_t settingsHash);
+			// outdatedTime is set when the content matches but the cache has another size or modification time
+			static bool						ReadHeader(Reader & reader, uint32_t magic, SourceFile & source, uint64_t settingsHash, bool * outdatedTime = nullptr);
+
+			static void						WriteMesh(Writer & writer, const Mesh & mesh);
+			static std::shared_ptr< Mesh >	ReadMesh(Reader & reader);
+
+			static bool						SaveMesh(const std::string & path, const Mesh & mesh, SourceFile & source, uint64_t settingsHash = 0);
+			static std::shared_ptr< Mesh >	LoadMesh(const std::string & path, SourceFile & source, uint64_t settingsHash = 0);
+
+			static void					SetDirectory(const std::string & directory);
+			static const std::string &	GetDirectory(void);
+	};
+}
@@ -0,0 +1,338 @@
+#include "MeshSimplifier.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+using namespace LWGC;
+
+// Symmetric 4x4 matrix of the plane equations, stored as the upper triangle
+struct Quadric
+{
+	double	a00, a01, a02, a03;
+	double	a11, a12, a13;
+	double	a22, a23;
+	double	a33;
+	double	weight;
+};
+
+struct Collapse
+{
+	int		source;
+	int		target;
+	double	error;
+};
+
+static void			QuadricAdd(Quadric & q, const Quadric & r)
+{
+	q.a00 += r.a00; q.a01 += r.a01; q.a02 += r.a02; q.a03 += r.a03;
+	q.a11 += r.a11; q.a12 += r.a12; q.a13 += r.a13;
+	q.a22 += r.a22; q.a23 += r.a23;
+	q.a33 += r.a33;
+	q.weight += r.weight;
+}
+
+static Quadric		QuadricFromPlane(double a, double b, double c, double d, double weight)
+{
+	Quadric q;
+
+	q.a00 = a * a * weight; q.a01 = a * b * weight; q.a02 = a * c * weight; q.a03 = a * d * weight;
+	q.a11 = b * b * weight; q.a12 = b * c * weight; q.a13 = b * d * weight;
+	q.a22 = c * c * weight; q.a23 = c * d * weight;
+	q.a33 = d * d * weight;
+	q.weight = weight;
+
+	return q;
+}
+
+static double		QuadricError(const Quadric & q, const glm::vec3 & p)
+{
+	double x = p.x, y = p.y, z = p.z;
+
+	double r = q.a00 * x * x + 2 * q.a01 * x * y + 2 * q.a02 * x * z + 2 * q.a03 * x
+			 + q.a11 * y * y + 2 * q.a12 * y * z + 2 * q.a13 * y
+			 + q.a22 * z * z + 2 * q.a23 * z
+			 + q.a33;
+
+	// divide by the total area so the error is a squared distance
+	return (q.weight > 0) ? std::fabs(r) / q.weight : 0;
+}
+
+// Vertices at the same position are welded so that uv / normal seams don't open cracks
+static void			BuildPositionRemap(const std::vector< glm::vec3 > & positions, std::vector< int > & remap)
+{
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3 & p) const noexcept
+		{
+			uint32_t h[3];
+			std::memcpy(h, &p, sizeof(h));
+			return (h[0] * 73856093) ^ (h[1] * 19349663) ^ (h[2] * 83492791);
+		}
+	};
+
+	std::unordered_map< glm::vec3, int, PositionHash >	unique;
+
+	remap.resize(positions.size());
+	unique.reserve(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		remap[i] = unique.emplace(positions[i], static_cast< int >(i)).first->second;
+}
+
+// sourceNormals are the normals of the source triangles the current ones come from: a pass only compares the
+// triangles with their last shape, they must also stay within 60 degrees of the source so they don't fold
+// over a few passes. Degenerated source triangles have no normal and are not checked.
+static bool			CollapseFlipsTriangles(const std::vector< glm::vec3 > & positions, const std::vector< int > & indices, const std::vector< glm::vec3 > & sourceNormals, const std::vector< int > & remap, const std::vector< int > & triangles, int source, int target)
+{
+	const glm::vec3 & newPosition = positions[target];
+
+	for (int t : triangles)
+	{
+		int	corners[3] = {indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2]};
+		int	k;
+
+		// triangles containing the collapsed edge disappear
+		if (remap[corners[0]] == remap[target] || remap[corners[1]] == remap[target] || remap[corners[2]] == remap[target])
+			continue ;
+
+		for (k = 0; k < 3; k++)
+			if (remap[corners[k]] == remap[source])
+				break ;
+		if (k == 3)
+			continue ;
+
+		const glm::vec3 & p0 = positions[corners[k]];
+		const glm::vec3 & p1 = positions[corners[(k + 1) % 3]];
+		const glm::vec3 & p2 = positions[corners[(k + 2) % 3]];
+
+		glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+		glm::vec3 after = glm::cross(p1 - newPosition, p2 - newPosition);
+
+		// reject flipped and very thin triangles
+		if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+			return true;
+		if (sourceNormals[t] != glm::vec3(0) && glm::dot(sourceNormals[t], after) <= 0.5f * glm::length(after))
+			return true;
+	}
+
+	return false;
+}
+
+std::vector< int >	MeshSimplifier::Simplify(const std::vector< glm::vec3 > & positions, const std::vector< int > & sourceIndices, size_t targetIndexCount, float targetError, float * resultError)
+{
+	std::vector< int >					indices = sourceIndices;
+	std::vector< int >					remap;
+	std::vector< glm::vec3 >			normalized(positions.size());
+	std::vector< glm::vec3 >			sourceNormals(sourceIndices.size() / 3);
+	std::vector< Quadric >				quadrics(positions.size(), Quadric{});
+	std::vector< int >					wedgeCount(positions.size(), 0);
+	std::vector< bool >					locked(positions.size(), false);
+	std::vector< std::vector< int > >	vertexTriangles;
+	std::vector< Collapse >				collapses;
+	std::vector< int >					collapseRemap(positions.size());
+	std::vector< bool >					touched(positions.size());
+	double								maxError = 0;
+
+	if (resultError != nullptr)
+		*resultError = 0;
+
+	if (indices.size() % 3 != 0)
+		throw std::runtime_error("Can't simplify a mesh which is not made of triangles");
+
+	if (indices.size() <= targetIndexCount || positions.size() == 0)
+		return indices;
+
+	BuildPositionRemap(positions, remap);
+
+	// Work in a normalized space so targetError doesn't depend on the mesh scale
+	glm::vec3	min = positions[0];
+	glm::vec3	max = positions[0];
+	for (const auto & p : positions)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	float		extent = glm::length(max - min);
+	float		scale = (extent > 0) ? 1.0f / extent : 1.0f;
+	double		targetErrorSquared = (double)targetError * targetError;
+
+	for (size_t i = 0; i < positions.size(); i++)
+		normalized[i] = (positions[i] - min) * scale;
+
+	for (size_t i = 0; i < positions.size(); i++)
+		wedgeCount[remap[i]]++;
+
+	// Plane quadrics, weighted by triangle area
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		glm::vec3	p0 = normalized[indices[i + 0]];
+		glm::vec3	p1 = normalized[indices[i + 1]];
+		glm::vec3	p2 = normalized[indices[i + 2]];
+		glm::vec3	normal = glm::cross(p1 - p0, p2 - p0);
+		double		area = glm::length(normal);
+
+		if (area <= 0)
+			continue ;
+
+		normal /= static_cast< float >(area);
+		sourceNormals[i / 3] = normal;
+		double d = -glm::dot(normal, p0);
+		Quadric q = QuadricFromPlane(normal.x, normal.y, normal.z, d, area);
+
+		for (int k = 0; k < 3; k++)
+			QuadricAdd(quadrics[remap[indices[i + k]]], q);
+	}
+
+	// Seam vertices (multiple attributes for one position) and border vertices are not allowed to move
+	{
+		std::unordered_map< uint64_t, int >	edgeUsage;
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t a = remap[indices[i + k]];
+				uint32_t b = remap[indices[i + (k + 1) % 3]];
+				uint64_t key = (a < b) ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+				edgeUsage[key]++;
+			}
+
+		for (const auto & edge : edgeUsage)
+			if (edge.second == 1)
+			{
+				locked[edge.first >> 32] = true;
+				locked[edge.first & 0xFFFFFFFF] = true;
+			}
+
+		for (size_t i = 0; i < positions.size(); i++)
+			if (wedgeCount[remap[i]] > 1)
+				locked[remap[i]] = true;
+	}
+
+	// Collapse passes: each pass collapses the cheapest independent edges, then the topology is rebuilt
+	while (indices.size() > targetIndexCount)
+	{
+		size_t	triangleCount = indices.size() / 3;
+
+		vertexTriangles.assign(positions.size(), std::vector< int >());
+		for (size_t t = 0; t < triangleCount; t++)
+			for (int k = 0; k < 3; k++)
+				vertexTriangles[remap[indices[t * 3 + k]]].push_back(static_cast< int >(t));
+
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+			for (int k = 0; k < 3; k++)
+			{
+				int a = indices[i + k];
+				int b = indices[i + (k + 1) % 3];
+
+				Quadric q = quadrics[remap[a]];
+				QuadricAdd(q, quadrics[remap[b]]);
+
+				if (!locked[remap[a]])
+					collapses.push_back(Collapse{a, b, QuadricError(q, normalized[b])});
+				if (!locked[remap[b]])
+					collapses.push_back(Collapse{b, a, QuadricError(q, normalized[a])});
+			}
+
+		if (collapses.size() == 0)
+			break ;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse & a, const Collapse & b) { return a.error < b.error; });
+
+		for (size_t i = 0; i < positions.size(); i++)
+			collapseRemap[i] = static_cast< int >(i);
+		std::fill(touched.begin(), touched.end(), false);
+
+		// each collapse removes about two triangles, don't overshoot the target in a single pass
+		size_t	collapseBudget = (indices.size() - targetIndexCount) / 6 + 1;
+		size_t	collapseCount = 0;
+
+		for (const auto & c : collapses)
+		{
+			if (collapseCount >= collapseBudget || c.error > targetErrorSquared)
+				break ;
+
+			int source = remap[c.source];
+			int target = remap[c.target];
+
+			// A collapse moves the triangles around its source, the other collapses of the pass must not see
+			// them: both 1-rings are frozen until the topology is rebuilt
+			if (source == target || touched[source] || touched[target])
+				continue ;
+
+			if (CollapseFlipsTriangles(normalized, indices, sourceNormals, remap, vertexTriangles[source], c.source, c.target))
+				continue ;
+
+			// source is not a seam so it's the only vertex at this position
+			collapseRemap[c.source] = c.target;
+
+			QuadricAdd(quadrics[target], quadrics[source]);
+			for (int endpoint : {source, target})
+				for (int t : vertexTriangles[endpoint])
+					for (int k = 0; k < 3; k++)
+						touched[remap[indices[t * 3 + k]]] = true;
+			maxError = std::max(maxError, c.error);
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+			break ;
+
+		// Apply the collapses and remove the degenerated triangles
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			int a = collapseRemap[indices[i + 0]];
+			int b = collapseRemap[indices[i + 1]];
+			int c = collapseRemap[indices[i + 2]];
+
+			if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+				continue ;
+
+			sourceNormals[writeIndex / 3] = sourceNormals[i / 3];
+			indices[writeIndex++] = a;
+			indices[writeIndex++] = b;
+			indices[writeIndex++] = c;
+		}
+		indices.resize(writeIndex);
+		sourceNormals.resize(writeIndex / 3);
+	}
+
+	if (resultError != nullptr)
+		*resultError = static_cast< float >(std::sqrt(maxError));
+
+	return indices;
+}
+
+std::vector< std::vector< int > >	MeshSimplifier::GenerateLODChain(const std::vector< glm::vec3 > & positions, const std::vector< int > & indices, int lodCount, float reduction, std::vector< float > * errors)
+{
+	std::vector< std::vector< int > >	lods;
+	float								error = 0;
+
+	if (errors != nullptr)
+		errors->clear();
+
+	lods.push_back(indices);
+	if (errors != nullptr)
+		errors->push_back(0);
+
+	for (int i = 1; i < lodCount; i++)
+	{
+		const auto &	previous = lods.back();
+		size_t			target = static_cast< size_t >(previous.size() / 3 * reduction) * 3;
+
+		// Simplify from the previous level, it's a lot faster than starting from the full mesh each time
+		auto lod = Simplify(positions, previous, target, 1.0f, &error);
+
+		if (lod.size() == 0 || lod.size() >= previous.size())
+			break ;
+
+		if (errors != nullptr)
+			errors->push_back(std::max(error, errors->back()));
+		lods.push_back(std::move(lod));
+	}
+
+	return lods;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IncludeDeps.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	// Quadric error metric (Garland-Heckbert) edge collapse simplifier.
+	// Only works on positions and indices so it can run (and be tested) without any vulkan context,
+	// the result indices reference the input vertices so all the attributes of the mesh are preserved.
+	class		MeshSimplifier
+	{
+		public:
+			MeshSimplifier(void) = delete;
+			MeshSimplifier(const MeshSimplifier &) = delete;
+			virtual ~MeshSimplifier(void) = delete;
+
+			MeshSimplifier &	operator=(MeshSimplifier const & src) = delete;
+
+			// targetError is relative to the mesh extent (0.01 = 1% of the bounding box diagonal)
+			static std::vector< int >	Simplify(const std::vector< glm::vec3 > & positions, const std::vector< int > & indices, size_t targetIndexCount, float targetError = 1.0f, float * resultError = nullptr);
+
+			// Generate up to lodCount levels, each level aims for reduction * the index count of the previous one.
+			// The first level is always the source indices. Stops early when a level can't be simplified anymore.
+			static std::vector< std::vector< int > >	GenerateLODChain(const std::vector< glm::vec3 > & positions, const std::vector< int > & indices, int lodCount, float reduction = 0.5f, std::vector< float > * errors = nullptr);
+	};
+}
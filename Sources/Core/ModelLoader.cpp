@@ -1,6 +1,14 @@
 #include "ModelLoader.hpp"
 
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+
 #include "Core/Textures/Texture2D.hpp"
+#include "Core/Application.hpp"
+#include "Core/MeshCache.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/ThreadPool.hpp"
 #include "Utils/Utils.hpp"
 
 #include "Core/Components/MeshRenderer.hpp"
@@ -11,13 +19,154 @@
 
 using namespace LWGC;
 
+struct		DecodedTexture
+{
+	std::string				path;
+	int						width;
+	int						height;
+	std::vector< uint8_t >	pixels; // RGBA8
+	std::vector< uint8_t >	encoded; // png, jpg, ... bytes of embedded textures
+};
+
+struct		DecodedMaterial
+{
+	std::string		name;
+	glm::vec4		albedo;
+	int				albedoTexture;
+	int				normalTexture;
+};
+
+struct		DecodedNode
+{
+	std::string					name;
+	glm::vec3					position;
+	glm::quat					rotation;
+	glm::vec3					scale;
+	std::vector< unsigned >		meshes;
+	std::vector< DecodedNode >	children;
+};
+
+struct		ModelLoader::ImportedScene
+{
+	std::string								name;
+	std::vector< std::shared_ptr< Mesh > >	meshes;
+	std::vector< unsigned >					meshMaterials;
+	std::vector< DecodedTexture >			textures;
+	std::vector< DecodedMaterial >			materials;
+	DecodedNode								root;
+	bool									fromCache = false;
+};
+
+std::mutex								ModelLoader::_pendingScenesMutex;
+std::vector< ModelLoader::PendingScene >	ModelLoader::_pendingScenes;
+bool									ModelLoader::_updateListenerRegistered = false;
+
 // Can't put this in the include file because we can't include assimp in the header
-static GameObject *	SceneToGameObject(const std::string & name, const aiScene * scene);
-static Mesh *		CreateMesh(aiMesh * mesh);
-static Texture *	CreateTexture(aiTexture * texture);
-static Material *	CreateMaterial(aiMaterial * material); // send textures too ?
+static std::shared_ptr< Mesh >	CreateMesh(aiMesh * mesh, int lodCount);
+static void						ExtractTexture(const aiScene * scene, DecodedTexture & texture);
+static void						DecodeTexture(const std::string & directory, DecodedTexture & texture);
+static DecodedMaterial			CreateMaterial(aiMaterial * material, std::unordered_map< std::string, int > & textureIndices);
+static void						CreateNode(const aiNode * node, DecodedNode & decoded);
+
+GameObject *		ModelLoader::Load(const std::string & path, bool optimize, int lodCount) noexcept
+{
+	try {
+		auto scene = Import(path, optimize, lodCount);
+
+		if (scene == nullptr)
+			return nullptr;
+
+		return Instantiate(*scene);
+	} catch (const std::exception & e) {
+		std::cerr << "Failed to load model " << path << ": " << e.what() << std::endl;
+		return nullptr;
+	}
+}
+
+std::future< GameObject * >	ModelLoader::LoadAsync(const std::string & path, bool optimize, int lodCount)
+{
+	auto	promise = std::make_shared< std::promise< GameObject * > >();
+
+	// Texture and material creation have to happen on the main thread
+	if (!_updateListenerRegistered)
+	{
+		Application::update.AddListener(FinalizePendingScenes);
+		_updateListenerRegistered = true;
+	}
+
+	// The imports share the engine workers, the pool drains them before joining at exit
+	ThreadPool::GetShared().Enqueue([path, optimize, lodCount, promise]()
+	{
+		std::shared_ptr< ImportedScene >	scene;
+
+		try {
+			scene = Import(path, optimize, lodCount);
+		} catch (const std::exception & e) {
+			std::cerr << "Failed to import model " << path << ": " << e.what() << std::endl;
+		}
+
+		std::lock_guard< std::mutex > lock(_pendingScenesMutex);
+		_pendingScenes.push_back(PendingScene{scene, promise});
+	});
+
+	return promise->get_future();
+}
+
+void				ModelLoader::FinalizePendingScenes(void) noexcept
+{
+	std::vector< PendingScene >	scenes;
+
+	{
+		std::lock_guard< std::mutex > lock(_pendingScenesMutex);
+		scenes.swap(_pendingScenes);
+	}
+
+	for (auto & pending : scenes)
+	{
+		try {
+			pending.promise->set_value((pending.scene == nullptr) ? nullptr : Instantiate(*pending.scene));
+		} catch (...) {
+			pending.promise->set_exception(std::current_exception());
+		}
+	}
+}
+
+std::shared_ptr< ModelLoader::ImportedScene >	ModelLoader::Import(const std::string & path, bool optimize, int lodCount)
+{
+	std::string				cachePath = MeshCache::GetCachePath(path, MeshCache::SceneExtension);
+	std::string				directory = path.substr(0, path.find_last_of('/') + 1);
+	MeshCache::SourceFile	source;
+	bool					hasSource = MeshCache::GetSourceFile(path, source);
+	bool					outdatedTime = false;
+	// The last value is the version of the import, the caches of the older ones are not valid anymore
+	int32_t					settings[3] = {optimize, lodCount, 2};
+	uint64_t				settingsHash = MeshCache::HashBytes(settings, sizeof(settings));
+
+	// Skip assimp entirely when the cache was generated from the same file with the same settings
+	auto imported = hasSource ? LoadCache(cachePath, source, settingsHash, outdatedTime) : nullptr;
+
+	if (imported == nullptr)
+	{
+		if ((imported = ImportWithAssimp(path, optimize, lodCount)) == nullptr)
+			return nullptr;
+	}
+
+	// The cache of a touched but identical file is written again so the next loads don't hash it
+	if (hasSource && (outdatedTime || !imported->fromCache))
+	{
+		if (!MeshCache::CreateCacheDirectory() || !SaveCache(cachePath, *imported, source, settingsHash))
+			std::cerr << "Can't write model cache " << cachePath << std::endl;
+	}
 
-GameObject *		ModelLoader::Load(const std::string & path, bool optimize) noexcept
+	ThreadPool::GetShared().ParallelFor(imported->textures.size(), [&](size_t index)
+	{
+		DecodeTexture(directory, imported->textures[index]);
+	});
+
+	return imported;
+}
+
+std::shared_ptr< ModelLoader::ImportedScene >	ModelLoader::ImportWithAssimp(const std::string & path, bool optimize, int lodCount)
 {
 	// Create an instance of the Importer class
 	Assimp::Importer importer;
@@ -41,54 +190,431 @@ GameObject *		ModelLoader::Load(const std::string & path, bool optimize) noexcep
 		return nullptr;
 	}
 
-	// Now we can access the file's contents and convert it to gameobjects
-	return SceneToGameObject(GetFileNameWithoutExtension(path), scene);
+	auto			imported = std::make_shared< ImportedScene >();
+	std::unordered_map< std::string, int >	textureIndices;
+
+	imported->name = GetFileNameWithoutExtension(path);
+
+	// Materials first, they reference the textures to decode
+	for (unsigned i = 0; i < scene->mNumMaterials; i++)
+		imported->materials.push_back(CreateMaterial(scene->mMaterials[i], textureIndices));
+
+	imported->textures.resize(textureIndices.size());
+	for (const auto & texture : textureIndices)
+	{
+		imported->textures[texture.second].path = texture.first;
+		ExtractTexture(scene, imported->textures[texture.second]);
+	}
+
+	imported->meshes.resize(scene->mNumMeshes);
+	imported->meshMaterials.resize(scene->mNumMeshes);
+	for (unsigned i = 0; i < scene->mNumMeshes; i++)
+		imported->meshMaterials[i] = scene->mMeshes[i]->mMaterialIndex;
+
+	// Convert meshes in parallel, the importer is only read from here
+	ThreadPool::GetShared().ParallelFor(scene->mNumMeshes, [&](size_t index)
+	{
+		imported->meshes[index] = CreateMesh(scene->mMeshes[index], lodCount);
+	});
+
+	CreateNode(scene->mRootNode, imported->root);
+	imported->root.name = imported->name;
+
+	return imported;
 }
 
-GameObject *	SceneToGameObject(const std::string & name, const aiScene * scene)
+static void		WriteNode(MeshCache::Writer & writer, const DecodedNode & node)
 {
-	std::vector< Material * > materials;
-	GameObject * root = new GameObject();
-	root->SetName(name);
+	writer.WriteString(node.name);
+	writer.Write(node.position);
+	writer.Write(node.rotation);
+	writer.Write(node.scale);
+	writer.Write< uint32_t >(node.meshes.size());
+	for (unsigned mesh : node.meshes)
+		writer.Write< uint32_t >(mesh);
+	writer.Write< uint32_t >(node.children.size());
+	for (const auto & child : node.children)
+		WriteNode(writer, child);
+}
+
+// Deeper hierarchies only come from a corrupted cache, the recursion must not overflow the stack
+static const size_t	MaxNodeDepth = 256;
+// Name, transform and the two counts
+static const size_t	MinNodeSize = sizeof(uint32_t) + sizeof(glm::vec3) + sizeof(glm::quat) + sizeof(glm::vec3) + 2 * sizeof(uint32_t);
+
+static void		ReadNode(MeshCache::Reader & reader, DecodedNode & node, size_t depth = 0)
+{
+	if (depth > MaxNodeDepth)
+		throw std::runtime_error("Node hierarchy too deep");
+
+	node.name = reader.ReadString();
+	node.position = reader.Read< glm::vec3 >();
+	node.rotation = reader.Read< glm::quat >();
+	node.scale = reader.Read< glm::vec3 >();
+	node.meshes.resize(reader.ReadCount(sizeof(uint32_t)));
+	for (auto & mesh : node.meshes)
+		mesh = reader.Read< uint32_t >();
+	node.children.resize(reader.ReadCount(MinNodeSize));
+	for (auto & child : node.children)
+		ReadNode(reader, child, depth + 1);
+}
+
+static void		ValidateNode(const DecodedNode & node, size_t meshCount)
+{
+	for (unsigned mesh : node.meshes)
+		if (mesh >= meshCount)
+			throw std::runtime_error("Mesh index out of range");
+	for (const auto & child : node.children)
+		ValidateNode(child, meshCount);
+}
+
+static bool		IsTextureIndexValid(int32_t index, size_t textureCount) noexcept
+{
+	return index >= -1 && (index < 0 || static_cast< size_t >(index) < textureCount);
+}
+
+bool				ModelLoader::SaveCache(const std::string & cachePath, const ImportedScene & scene, MeshCache::SourceFile & source, uint64_t settingsHash)
+{
+	MeshCache::Writer	writer;
+
+	MeshCache::WriteHeader(writer, MeshCache::SceneMagic, source, settingsHash);
 
-	// Load all textures
-	for (unsigned i = 0; i < scene->mNumTextures; i++)
+	writer.WriteString(scene.name);
+
+	// External textures are only referenced, embedded ones are stored as they are in the source file
+	writer.Write< uint32_t >(scene.textures.size());
+	for (const auto & t : scene.textures)
 	{
-		CreateTexture(scene->mTextures[i]);
+		writer.WriteString(t.path);
+		writer.Write< int32_t >(t.width);
+		writer.Write< int32_t >(t.height);
+		writer.Write< uint32_t >(t.encoded.size());
+		writer.WriteBytes(t.encoded.data(), t.encoded.size());
+		// Only raw embedded textures are already decoded at this point
+		writer.Write< uint32_t >(t.pixels.size());
+		writer.WriteBytes(t.pixels.data(), t.pixels.size());
 	}
 
-	// Load all materials
-	for (unsigned i = 0; i < scene->mNumMaterials; i++)
+	writer.Write< uint32_t >(scene.materials.size());
+	for (const auto & m : scene.materials)
 	{
-		materials.push_back(CreateMaterial(scene->mMaterials[i]));
+		writer.WriteString(m.name);
+		writer.Write(m.albedo);
+		writer.Write< int32_t >(m.albedoTexture);
+		writer.Write< int32_t >(m.normalTexture);
 	}
 
-	// Load all meshes
-	for (unsigned i = 0; i < scene->mNumMeshes; i++)
+	WriteNode(writer, scene.root);
+
+	writer.Write< uint32_t >(scene.meshes.size());
+	for (size_t i = 0; i < scene.meshes.size(); i++)
 	{
-		auto mesh = CreateMesh(scene->mMeshes[i]);
+		writer.Write< uint32_t >(scene.meshMaterials[i]);
+		writer.Write< uint32_t >(scene.meshes[i] != nullptr);
+		if (scene.meshes[i] != nullptr)
+			MeshCache::WriteMesh(writer, *scene.meshes[i]);
+	}
 
-		// add one game objects per meshes
-		root->AddChild(new GameObject(new MeshRenderer(mesh, materials[scene->mMeshes[i]->mMaterialIndex])));
+	return writer.SaveToFile(cachePath);
+}
+
+std::shared_ptr< ModelLoader::ImportedScene >	ModelLoader::LoadCache(const std::string & cachePath, MeshCache::SourceFile & source, uint64_t settingsHash, bool & outdatedTime)
+{
+	MappedFile	file;
+
+	if (!file.Open(cachePath))
+		return nullptr;
+
+	try {
+		MeshCache::Reader	reader(file.GetData(), file.GetSize());
+		auto				scene = std::make_shared< ImportedScene >();
+
+		if (!MeshCache::ReadHeader(reader, MeshCache::SceneMagic, source, settingsHash, &outdatedTime))
+			return nullptr;
+
+		scene->fromCache = true;
+
+		scene->name = reader.ReadString();
+
+		// The counts are checked against the size of the file and the indices against the counts, everything
+		// read here goes to the GPU uploads and the draws of Instantiate
+		scene->textures.resize(reader.ReadCount(5 * sizeof(uint32_t)));
+		for (auto & t : scene->textures)
+		{
+			t.path = reader.ReadString();
+			t.width = reader.Read< int32_t >();
+			t.height = reader.Read< int32_t >();
+			uint32_t encodedSize = reader.Read< uint32_t >();
+			auto encoded = static_cast< const uint8_t * >(reader.ReadBytes(encodedSize));
+			t.encoded.assign(encoded, encoded + encodedSize);
+			uint32_t pixelsSize = reader.Read< uint32_t >();
+			auto pixels = static_cast< const uint8_t * >(reader.ReadBytes(pixelsSize));
+			t.pixels.assign(pixels, pixels + pixelsSize);
+
+			if (t.width < 0 || t.height < 0 || (pixelsSize != 0 && static_cast< uint64_t >(t.width) * t.height * 4 != pixelsSize))
+				throw std::runtime_error("Texture size doesn't match its pixels");
+		}
+
+		scene->materials.resize(reader.ReadCount(sizeof(uint32_t) + sizeof(glm::vec4) + 2 * sizeof(int32_t)));
+		for (auto & m : scene->materials)
+		{
+			m.name = reader.ReadString();
+			m.albedo = reader.Read< glm::vec4 >();
+			m.albedoTexture = reader.Read< int32_t >();
+			m.normalTexture = reader.Read< int32_t >();
+
+			if (!IsTextureIndexValid(m.albedoTexture, scene->textures.size()) || !IsTextureIndexValid(m.normalTexture, scene->textures.size()))
+				throw std::runtime_error("Texture index out of range");
+		}
+
+		ReadNode(reader, scene->root);
+
+		uint32_t meshCount = reader.ReadCount(2 * sizeof(uint32_t));
+		scene->meshes.resize(meshCount);
+		scene->meshMaterials.resize(meshCount);
+		for (uint32_t i = 0; i < meshCount; i++)
+		{
+			scene->meshMaterials[i] = reader.Read< uint32_t >();
+			if (reader.Read< uint32_t >())
+			{
+				if (scene->meshMaterials[i] >= scene->materials.size())
+					throw std::runtime_error("Material index out of range");
+				scene->meshes[i] = MeshCache::ReadMesh(reader);
+			}
+		}
+
+		ValidateNode(scene->root, meshCount);
+
+		return scene;
+	} catch (const std::exception & e) {
+		std::cerr << "Invalid model cache " << cachePath << ": " << e.what() << std::endl;
+		return nullptr;
 	}
+}
 
-	return root;
+GameObject *		ModelLoader::Instantiate(const ImportedScene & scene)
+{
+	std::vector< Texture2D * >	textures;
+	std::vector< Material * >	materials;
+
+	// All the GPU uploads are done here, once everything is decoded
+	for (const auto & t : scene.textures)
+	{
+		if (t.pixels.size() == 0)
+		{
+			textures.push_back(nullptr);
+			continue ;
+		}
+
+		auto texture = Texture2D::Create(t.width, t.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, (void *)t.pixels.data(), t.pixels.size(), true);
+		texture->SetName(GetFileNameWithoutExtension(t.path));
+		textures.push_back(texture);
+	}
+
+	for (const auto & m : scene.materials)
+	{
+		Texture2D *	albedo = (m.albedoTexture >= 0) ? textures[m.albedoTexture] : nullptr;
+		Material *	material = Material::Create(BuiltinShaders::Standard);
+
+		// The standard shader samples the albedo map so materials without texture get a 1x1 of their color
+		if (albedo == nullptr)
+		{
+			glm::vec4	c = glm::clamp(m.albedo, 0.0f, 1.0f) * 255.0f;
+			uint8_t		color[4] = {(uint8_t)c.x, (uint8_t)c.y, (uint8_t)c.z, (uint8_t)c.w};
+			albedo = Texture2D::Create(1, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, color, sizeof(color));
+		}
+
+		material->SetAlbedo(m.albedo);
+		material->SetTexture(TextureBinding::Albedo, albedo, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+		if (m.normalTexture >= 0 && textures[m.normalTexture] != nullptr)
+			material->SetTexture(TextureBinding::Normal, textures[m.normalTexture], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, true);
+		materials.push_back(material);
+	}
+
+	std::function< GameObject *(const DecodedNode &) >	createGameObject = [&](const DecodedNode & node)
+	{
+		GameObject *	go = new GameObject();
+
+		go->SetName(node.name);
+		go->GetTransform()->SetPosition(node.position);
+		go->GetTransform()->SetRotation(node.rotation);
+		go->GetTransform()->SetScale(node.scale);
+
+		// add one game objects per meshes
+		for (unsigned meshIndex : node.meshes)
+		{
+			if (scene.meshes[meshIndex] == nullptr)
+				continue ;
+
+			auto renderer = new MeshRenderer(materials[scene.meshMaterials[meshIndex]]);
+			renderer->SetMesh(scene.meshes[meshIndex]);
+			go->AddChild(new GameObject(renderer));
+		}
+
+		for (const auto & child : node.children)
+			go->AddChild(createGameObject(child));
+
+		return go;
+	};
+
+	return createGameObject(scene.root);
 }
 
-Mesh *		CreateMesh(aiMesh * mesh)
+std::shared_ptr< Mesh >	CreateMesh(aiMesh * mesh, int lodCount)
 {
+	std::vector< Mesh::VertexAttributes >	attributes(mesh->mNumVertices);
+	std::vector< int >						indices;
+
+	// Points and lines are separated by aiProcess_SortByPType, we only render triangles
+	if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+		return nullptr;
 
+	for (unsigned i = 0; i < mesh->mNumVertices; i++)
+	{
+		auto & a = attributes[i];
+
+		a.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+		a.normal = (mesh->HasNormals()) ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0, 0, 0);
+		a.tangent = (mesh->HasTangentsAndBitangents()) ? glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z) : glm::vec3(0, 0, 0);
+		a.color = (mesh->HasVertexColors(0)) ? glm::vec3(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b) : glm::vec3(0, 0, 0);
+		a.texCoord = (mesh->HasTextureCoords(0)) ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y) : glm::vec2(0, 0);
+	}
+
+	indices.reserve(mesh->mNumFaces * 3);
+	for (unsigned i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace & face = mesh->mFaces[i];
+
+		if (face.mNumIndices != 3)
+			continue ;
+		indices.push_back(face.mIndices[0]);
+		indices.push_back(face.mIndices[1]);
+		indices.push_back(face.mIndices[2]);
+	}
+
+	auto m = std::make_shared< Mesh >();
+	m->SetVertexAttributes(attributes);
+	m->SetIndices(indices);
+
+	if (lodCount > 1)
+		m->GenerateLODs(lodCount);
+
+	return m;
 }
 
-Texture *	CreateTexture(aiTexture * texture)
+void			ExtractTexture(const aiScene * scene, DecodedTexture & texture)
 {
+	// Embedded textures are referenced as "*index"
+	if (texture.path.size() <= 1 || texture.path[0] != '*')
+		return ;
 
+	unsigned index = std::strtoul(texture.path.c_str() + 1, nullptr, 10);
+
+	if (index >= scene->mNumTextures)
+		return ;
+
+	const aiTexture * t = scene->mTextures[index];
+
+	// mHeight == 0 means that the texture is compressed (png, jpg, ...) and mWidth is the size in bytes
+	if (t->mHeight == 0)
+	{
+		const uint8_t * data = reinterpret_cast< const uint8_t * >(t->pcData);
+		texture.encoded.assign(data, data + t->mWidth);
+	}
+	else
+	{
+		texture.width = t->mWidth;
+		texture.height = t->mHeight;
+		texture.pixels.resize(t->mWidth * t->mHeight * 4);
+		for (unsigned i = 0; i < t->mWidth * t->mHeight; i++)
+		{
+			texture.pixels[i * 4 + 0] = t->pcData[i].r;
+			texture.pixels[i * 4 + 1] = t->pcData[i].g;
+			texture.pixels[i * 4 + 2] = t->pcData[i].b;
+			texture.pixels[i * 4 + 3] = t->pcData[i].a;
+		}
+	}
 }
 
-Material *	CreateMaterial(aiMaterial * material)
+void			DecodeTexture(const std::string & directory, DecodedTexture & texture)
 {
-	for (unsigned j = 0; j < material->mNumProperties; j++)
+	int			channels;
+	stbi_uc *	pixels = nullptr;
+
+	// Raw embedded texture, nothing to decode
+	if (texture.pixels.size() != 0)
+		return ;
+
+	if (texture.encoded.size() != 0)
+		pixels = stbi_load_from_memory(texture.encoded.data(), texture.encoded.size(), &texture.width, &texture.height, &channels, STBI_rgb_alpha);
+	else
+	{
+		std::string path = texture.path;
+
+		std::replace(path.begin(), path.end(), '\\', '/');
+		pixels = stbi_load((directory + path).c_str(), &texture.width, &texture.height, &channels, STBI_rgb_alpha);
+	}
+
+	if (!pixels)
 	{
-		auto prop = material->mProperties[j];
+		std::cerr << "Failed to load texture " << texture.path << ": " << stbi_failure_reason() << std::endl;
+		return ;
 	}
+
+	texture.pixels.assign(pixels, pixels + texture.width * texture.height * 4);
+	stbi_image_free(pixels);
+}
+
+DecodedMaterial	CreateMaterial(aiMaterial * material, std::unordered_map< std::string, int > & textureIndices)
+{
+	DecodedMaterial	decoded{"Material", glm::vec4(1, 1, 1, 1), -1, -1};
+	aiString		name;
+	aiColor4D		diffuse;
+	float			opacity;
+
+	if (material->Get(AI_MATKEY_NAME, name) == AI_SUCCESS)
+		decoded.name = name.C_Str();
+	if (material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == AI_SUCCESS)
+		decoded.albedo = glm::vec4(diffuse.r, diffuse.g, diffuse.b, diffuse.a);
+	if (material->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS)
+		decoded.albedo.w = opacity;
+
+	auto findTexture = [&](aiTextureType type) -> int
+	{
+		aiString path;
+
+		if (material->GetTextureCount(type) == 0 || material->GetTexture(type, 0, &path) != AI_SUCCESS)
+			return -1;
+
+		// Textures shared between materials are decoded only once
+		auto it = textureIndices.emplace(path.C_Str(), static_cast< int >(textureIndices.size()));
+		return it.first->second;
+	};
+
+	decoded.albedoTexture = findTexture(aiTextureType_DIFFUSE);
+	decoded.normalTexture = findTexture(aiTextureType_NORMALS);
+	// obj files store normal maps as bump maps
+	if (decoded.normalTexture == -1)
+		decoded.normalTexture = findTexture(aiTextureType_HEIGHT);
+
+	return decoded;
+}
+
+void			CreateNode(const aiNode * node, DecodedNode & decoded)
+{
+	aiVector3D		scaling;
+	aiQuaternion	rotation;
+	aiVector3D		position;
+
+	node->mTransformation.Decompose(scaling, rotation, position);
+
+	decoded.name = node->mName.C_Str();
+	decoded.position = glm::vec3(position.x, position.y, position.z);
+	decoded.rotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+	decoded.scale = glm::vec3(scaling.x, scaling.y, scaling.z);
+	decoded.meshes.assign(node->mMeshes, node->mMeshes + node->mNumMeshes);
+
+	decoded.children.resize(node->mNumChildren);
+	for (unsigned i = 0; i < node->mNumChildren; i++)
+		CreateNode(node->mChildren[i], decoded.children[i]);
 }
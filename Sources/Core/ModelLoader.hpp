@@ -2,9 +2,14 @@
 
 #include <iostream>
 #include <string>
+#include <future>
+#include <mutex>
+#include <vector>
+#include <memory>
 
 #include "IncludeDeps.hpp"
 #include "Core/Mesh.hpp"
+#include "Core/MeshCache.hpp"
 #include "Core/Textures/Texture.hpp"
 #include "Core/Vulkan/Material.hpp"
 
@@ -15,6 +20,25 @@ namespace LWGC
 	class		ModelLoader
 	{
 		private:
+			// CPU side result of an import, defined in the cpp because it depends on assimp
+			struct ImportedScene;
+
+			struct PendingScene
+			{
+				std::shared_ptr< ImportedScene >				scene;
+				std::shared_ptr< std::promise< GameObject * > >	promise;
+			};
+
+			static std::mutex					_pendingScenesMutex;
+			static std::vector< PendingScene >	_pendingScenes;
+			static bool							_updateListenerRegistered;
+
+			static std::shared_ptr< ImportedScene >	Import(const std::string & path, bool optimize, int lodCount);
+			static std::shared_ptr< ImportedScene >	ImportWithAssimp(const std::string & path, bool optimize, int lodCount);
+			static bool								SaveCache(const std::string & cachePath, const ImportedScene & scene, MeshCache::SourceFile & source, uint64_t settingsHash);
+			static std::shared_ptr< ImportedScene >	LoadCache(const std::string & cachePath, MeshCache::SourceFile & source, uint64_t settingsHash, bool & outdatedTime);
+			static GameObject *						Instantiate(const ImportedScene & scene);
+			static void								FinalizePendingScenes(void) noexcept;
 
 		public:
 			ModelLoader(void) = delete;
@@ -23,6 +47,11 @@ namespace LWGC
 
 			ModelLoader &	operator=(ModelLoader const & src) = delete;
 
-			static GameObject *	Load(const std::string & path, bool optimize = false) noexcept;
+			static GameObject *	Load(const std::string & path, bool optimize = false, int lodCount = 1) noexcept;
+
+			// Models are cached in MeshCache::GetDirectory in the .lwgcscene format and only re-imported when they change.
+			// Import and decode on worker threads, the GPU upload and the GameObject creation are done
+			// on the main thread during Application::update so the caller can keep rendering meanwhile.
+			static std::future< GameObject * >	LoadAsync(const std::string & path, bool optimize = false, int lodCount = 1);
 	};
-}
\ No newline at end of file
+}
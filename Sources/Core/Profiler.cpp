@@ -1,31 +1,446 @@
 #include "Profiler.hpp"
 
+#include <algorithm>
+
 using namespace LWGC;
 
-ProfilingSamples	Profiler::_samples;
-ProfilingEntryData	Profiler::_lastInsertedEntry;
+std::atomic< bool >								Profiler::_enabled(false);
+thread_local Profiler::ThreadBuffer *			Profiler::_threadBuffer = nullptr;
+std::mutex										Profiler::_threadsMutex;
+std::vector< std::unique_ptr< Profiler::ThreadBuffer > >	Profiler::_threads;
+std::vector< Profiler::ThreadBuffer * >			Profiler::_freeThreads;
+
+std::mutex										Profiler::_namesMutex;
+std::deque< std::string >						Profiler::_names = {"Frame"};
+std::unordered_map< std::string, ProfilerNameId >	Profiler::_nameIds = {{"Frame", static_cast< ProfilerNameId >(Profiler::FrameName)}};
+
+std::thread										Profiler::_aggregationThread;
+std::mutex										Profiler::_aggregationMutex;
+std::condition_variable							Profiler::_aggregationCondition;
+bool											Profiler::_stop = false;
+ProfilerFrame									Profiler::_openFrame = {0, 0, 0, {}, {}};
+std::vector< ProfilerScope >					Profiler::_pendingScopes;
+std::vector< uint64_t >							Profiler::_frameMarkers;
+std::vector< ProfilerAllocation >				Profiler::_closingAllocations;
+
+std::mutex										Profiler::_allocationsMutex;
+std::vector< ProfilerAllocation >				Profiler::_pendingAllocations;
+
+std::mutex										Profiler::_framesMutex;
+std::deque< ProfilerFrame >						Profiler::_frames;
+std::map< uint64_t, std::vector< ProfilerScope > >	Profiler::_lateScopes;
+uint64_t										Profiler::_lastLateFrame = 0;
+bool											Profiler::_hasLateScopes = false;
+std::atomic< uint64_t >							Profiler::_frameCount(0);
+
+uint64_t										Profiler::_calibrationTimestamp = 0;
+uint64_t										Profiler::_calibrationTime = 0;
+double											Profiler::_nanosecondsPerTick = 1.0;
+
+// Without frame markers the scopes would accumulate forever
+static const size_t		MaxPendingScopes = 1 << 20;
+static const size_t		MaxPendingAllocations = 1 << 16;
+static const auto		AggregationInterval = std::chrono::milliseconds(2);
+
+void					Profiler::Start(void)
+{
+	if (_aggregationThread.joinable())
+		return ;
+
+	// The thread starting the profiler is the main one
+	SetThreadName("Main");
+
+	_calibrationTimestamp = GetTimestamp();
+	_calibrationTime = GetTime();
+#ifdef LWGC_PROFILER_TSC
+	// Measure the TSC frequency once before any event is converted, the aggregation thread refines it afterwards
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	Calibrate();
+#endif
+	_stop = false;
+	_enabled = true;
+	_aggregationThread = std::thread(&Profiler::AggregationLoop);
+}
+
+void					Profiler::Stop(void)
+{
+	if (!_aggregationThread.joinable())
+		return ;
+
+	_enabled = false;
+	{
+		std::lock_guard< std::mutex >	lock(_aggregationMutex);
+		_stop = true;
+	}
+	_aggregationCondition.notify_one();
+	_aggregationThread.join();
+}
+
+bool					Profiler::IsEnabled(void) noexcept { return _enabled; }
+
+ProfilerNameId			Profiler::InternName(const std::string & name)
+{
+	std::lock_guard< std::mutex >	lock(_namesMutex);
+
+	auto id = _nameIds.find(name);
+	if (id != _nameIds.end())
+		return id->second;
+
+	ProfilerNameId	newId = static_cast< ProfilerNameId >(_names.size());
+
+	_names.push_back(name);
+	_nameIds[name] = newId;
+
+	return newId;
+}
+
+std::string				Profiler::GetName(ProfilerNameId name)
+{
+	std::lock_guard< std::mutex >	lock(_namesMutex);
+
+	return (name < _names.size()) ? _names[name] : "Unknown";
+}
+
+Profiler::ThreadBuffer *	Profiler::RegisterThread(void)
+{
+	// Gives the buffer back to the free list when the thread exits (thread pools, loaders)
+	struct	ThreadExit
+	{
+		~ThreadExit(void) { Profiler::ReleaseThread(); }
+	};
+	static thread_local ThreadExit	threadExit;
+
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+
+	// The buffers are never destroyed: the aggregation thread can still be draining the events of the exited thread
+	if (!_freeThreads.empty())
+	{
+		_threadBuffer = _freeThreads.back();
+		_freeThreads.pop_back();
+	}
+	else
+	{
+		_threads.emplace_back(new ThreadBuffer(EventCapacity, static_cast< uint32_t >(_threads.size())));
+		_threadBuffer = _threads.back().get();
+	}
+	_threadBuffer->name = "Thread " + std::to_string(_threadBuffer->index);
+
+	return _threadBuffer;
+}
+
+void					Profiler::ReleaseThread(void) noexcept
+{
+	if (_threadBuffer == nullptr)
+		return ;
+
+	try {
+		std::lock_guard< std::mutex >	lock(_threadsMutex);
+		_freeThreads.push_back(_threadBuffer);
+	} catch (const std::exception &) {
+		// The buffer is leaked, it's still owned by _threads
+	}
+	_threadBuffer = nullptr;
+}
+
+void					Profiler::SetThreadName(const std::string & name)
+{
+	if (_threadBuffer == nullptr)
+		RegisterThread();
+
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+	_threadBuffer->name = name;
+}
+
+std::string				Profiler::GetThreadName(uint32_t threadIndex)
+{
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+
+	return (threadIndex < _threads.size()) ? _threads[threadIndex]->name : "Unknown";
+}
+
+size_t					Profiler::GetThreadCount(void)
+{
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+
+	return _threads.size();
+}
+
+uint32_t				Profiler::AddTrack(const std::string & name)
+{
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+	uint32_t						index = static_cast< uint32_t >(_threads.size());
+
+	// Nothing is ever pushed in the events of a track
+	_threads.emplace_back(new ThreadBuffer(1, index));
+	_threads.back()->name = name;
+
+	return index;
+}
+
+Profiler::ThreadBuffer *	Profiler::RegisterThreadNoExcept(void) noexcept
+{
+	try {
+		return RegisterThread();
+	} catch (const std::exception &) {
+		return nullptr;
+	}
+}
+
+void					Profiler::BeginFrame(void) noexcept
+{
+	// The n-th marker that reaches the aggregation thread opens the frame of index n
+	if (_enabled.load(std::memory_order_relaxed) && PushEvent(FrameName, ProfilerEventType::Frame))
+		_frameCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void					Profiler::RecordAllocation(ProfilerNameId name, int64_t bytes) noexcept
+{
+	if (!_enabled.load(std::memory_order_relaxed))
+		return ;
+
+	ThreadBuffer *	buffer = (_threadBuffer != nullptr) ? _threadBuffer : RegisterThreadNoExcept();
+
+	if (buffer == nullptr)
+		return ;
+
+	try {
+		std::lock_guard< std::mutex >	lock(_allocationsMutex);
+
+		if (_pendingAllocations.size() < MaxPendingAllocations)
+			_pendingAllocations.push_back({GetTime(), bytes, name, buffer->index});
+	} catch (const std::exception &) {
+		// Same as a dropped event
+	}
+}
+
+uint64_t				Profiler::GetFrameIndex(void) noexcept
+{
+	uint64_t count = _frameCount.load(std::memory_order_relaxed);
+
+	return (count == 0) ? 0 : count - 1;
+}
+
+void					Profiler::AddLateScopes(uint64_t frameIndex, const std::vector< ProfilerScope > & scopes)
+{
+	std::lock_guard< std::mutex >	lock(_framesMutex);
+
+	_hasLateScopes = true;
+	_lastLateFrame = std::max(_lastLateFrame, frameIndex);
+
+	// Not closed yet, merged by CloseFrame
+	if (_frames.empty() || frameIndex > _frames.back().index)
+	{
+		auto & pending = _lateScopes[frameIndex];
+		pending.insert(pending.end(), scopes.begin(), scopes.end());
+		return ;
+	}
+
+	for (auto frame = _frames.rbegin(); frame != _frames.rend(); ++frame)
+	{
+		if (frame->index == frameIndex)
+		{
+			frame->scopes.insert(frame->scopes.end(), scopes.begin(), scopes.end());
+			return ;
+		}
+	}
+	// Too old, the frame left the history
+}
+
+void					Profiler::AggregationLoop(void)
+{
+	std::unique_lock< std::mutex >	lock(_aggregationMutex);
+
+	while (!_stop)
+	{
+		_aggregationCondition.wait_for(lock, AggregationInterval, [](){ return _stop; });
+		Aggregate();
+	}
+}
 
-void					Profiler::AddSample(const std::string & name, double durationInMilliseconds, double frameTimeInMilliseconds) noexcept
+void					Profiler::Calibrate(void)
 {
-	ProfilingEntryData data = ProfilingEntryData{ durationInMilliseconds, frameTimeInMilliseconds };
-	_samples.emplace(name, data);
-	_lastInsertedEntry = data;
+#ifdef LWGC_PROFILER_TSC
+	uint64_t	timestamp = GetTimestamp();
+	uint64_t	time = GetTime();
+
+	// The longer the measured interval, the more precise the TSC frequency
+	if (time - _calibrationTime > 1000000 && timestamp > _calibrationTimestamp)
+		_nanosecondsPerTick = static_cast< double >(time - _calibrationTime) / static_cast< double >(timestamp - _calibrationTimestamp);
+#endif
 }
 
-const ProfilingSamples &Profiler::GetSamples(void) noexcept
+uint64_t				Profiler::ToNanoseconds(uint64_t timestamp) noexcept
 {
-	return _samples;
+#ifdef LWGC_PROFILER_TSC
+	return _calibrationTime + static_cast< uint64_t >(static_cast< double >(static_cast< int64_t >(timestamp - _calibrationTimestamp)) * _nanosecondsPerTick);
+#else
+	return timestamp;
+#endif
 }
 
-// Useful to retrieve the sample that contains all other samples (the frame)
-const ProfilingEntryData Profiler::GetLastSample(void) noexcept
+void					Profiler::Aggregate(void)
 {
-	return _lastInsertedEntry;
+	std::vector< ThreadBuffer * >	threads;
+	ProfilerEvent					event;
+
+	{
+		std::lock_guard< std::mutex >	lock(_threadsMutex);
+		for (const auto & thread : _threads)
+			threads.push_back(thread.get());
+	}
+
+	Calibrate();
+
+	for (auto thread : threads)
+	{
+		auto & openScopes = thread->openScopes;
+
+		while (thread->events.Pop(event))
+		{
+			switch (event.type)
+			{
+				case ProfilerEventType::Begin:
+					event.time = ToNanoseconds(event.time);
+					openScopes.push_back(event);
+					break ;
+				case ProfilerEventType::End:
+					if (!openScopes.empty() && openScopes.back().name == event.name)
+					{
+						uint64_t start = openScopes.back().time;
+
+						openScopes.pop_back();
+						_pendingScopes.push_back({start, ToNanoseconds(event.time), event.name, static_cast< uint32_t >(openScopes.size()), thread->index});
+					}
+					else // Some events were dropped, the nesting can't be recovered
+						openScopes.clear();
+					break ;
+				case ProfilerEventType::Frame:
+					_frameMarkers.push_back(ToNanoseconds(event.time));
+					break ;
+			}
+		}
+	}
+
+	{
+		std::lock_guard< std::mutex >	lock(_allocationsMutex);
+
+		_closingAllocations.insert(_closingAllocations.end(), _pendingAllocations.begin(), _pendingAllocations.end());
+		_pendingAllocations.clear();
+	}
+
+	for (auto marker : _frameMarkers)
+		CloseFrame(marker);
+	_frameMarkers.clear();
+
+	if (_pendingScopes.size() > MaxPendingScopes)
+		_pendingScopes.clear();
+	if (_closingAllocations.size() > MaxPendingAllocations)
+		_closingAllocations.clear();
 }
 
-void					Profiler::Reset(void) noexcept
+void					Profiler::CloseFrame(uint64_t end)
 {
-	_samples.clear();
+	// The first marker only opens a frame
+	if (_openFrame.start == 0)
+	{
+		_openFrame.start = end;
+		return ;
+	}
+
+	// Scopes of other threads drained after the marker end up in the next frame
+	auto split = std::stable_partition(_pendingScopes.begin(), _pendingScopes.end(), [end](const ProfilerScope & scope){ return scope.start < end; });
+
+	_openFrame.end = end;
+	_openFrame.scopes.assign(_pendingScopes.begin(), split);
+	_pendingScopes.erase(_pendingScopes.begin(), split);
+
+	auto allocationSplit = std::stable_partition(_closingAllocations.begin(), _closingAllocations.end(), [end](const ProfilerAllocation & allocation){ return allocation.time < end; });
+
+	_openFrame.allocations.assign(_closingAllocations.begin(), allocationSplit);
+	_closingAllocations.erase(_closingAllocations.begin(), allocationSplit);
+
+	uint64_t nextIndex = _openFrame.index + 1;
+
+	{
+		std::lock_guard< std::mutex >	lock(_framesMutex);
+
+		auto late = _lateScopes.find(_openFrame.index);
+		if (late != _lateScopes.end())
+			_openFrame.scopes.insert(_openFrame.scopes.end(), late->second.begin(), late->second.end());
+		_lateScopes.erase(_lateScopes.begin(), _lateScopes.upper_bound(_openFrame.index));
+
+		_frames.push_back(std::move(_openFrame));
+		if (_frames.size() > FrameHistorySize)
+			_frames.pop_front();
+	}
+
+	_openFrame = ProfilerFrame{nextIndex, end, 0, {}, {}};
+}
+
+bool					Profiler::GetLastFrame(ProfilerFrame & frame, bool waitLateScopes)
+{
+	std::lock_guard< std::mutex >	lock(_framesMutex);
+
+	if (_frames.empty())
+		return false;
+
+	if (!waitLateScopes || !_hasLateScopes)
+	{
+		frame = _frames.back();
+		return true;
+	}
+
+	for (auto last = _frames.rbegin(); last != _frames.rend(); ++last)
+	{
+		if (last->index <= _lastLateFrame)
+		{
+			frame = *last;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool					Profiler::GetLastFrameIndex(uint64_t & index)
+{
+	std::lock_guard< std::mutex >	lock(_framesMutex);
+
+	if (_frames.empty())
+		return false;
+
+	index = _frames.back().index;
+	return true;
+}
+
+void					Profiler::GetFrames(uint64_t firstIndex, uint64_t lastIndex, std::vector< ProfilerFrame > & frames)
+{
+	std::lock_guard< std::mutex >	lock(_framesMutex);
+
+	frames.clear();
+	for (const auto & frame : _frames)
+		if (frame.index >= firstIndex && frame.index <= lastIndex)
+			frames.push_back(frame);
+}
+
+void					Profiler::GetFrameDurations(std::vector< float > & durations)
+{
+	std::lock_guard< std::mutex >	lock(_framesMutex);
+
+	durations.clear();
+	for (auto frame = _frames.rbegin(); frame != _frames.rend(); ++frame)
+		durations.push_back(static_cast< float >(frame->end - frame->start) / 1000000.0f);
+}
+
+uint64_t				Profiler::GetDroppedEventCount(void)
+{
+	std::lock_guard< std::mutex >	lock(_threadsMutex);
+	uint64_t						count = 0;
+
+	for (const auto & thread : _threads)
+		count += thread->droppedEvents.load(std::memory_order_relaxed);
+
+	return count;
 }
 
 std::ostream &	operator<<(std::ostream & o, Profiler const & r)
@@ -2,40 +2,234 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <deque>
 #include <unordered_map>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
 
-#include "Core/Vulkan/ProfilingSample.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# define LWGC_PROFILER_TSC
+#endif
+
+#include "Utils/LockFreeQueue.tpp"
+
+#define LWGC_PROFILER_CONCAT_(a, b)	a##b
+#define LWGC_PROFILER_CONCAT(a, b)	LWGC_PROFILER_CONCAT_(a, b)
+
+// Profile the rest of the current scope. The name is interned once per call site, so the cost of a
+// scope is two timestamps and two ring buffer writes.
+#define LWGC_PROFILE_SCOPE(name) \
+	static const LWGC::ProfilerNameId LWGC_PROFILER_CONCAT(_profilerName, __LINE__) = LWGC::Profiler::InternName(name); \
+	LWGC::ProfilingScope LWGC_PROFILER_CONCAT(_profilerScope, __LINE__)(LWGC_PROFILER_CONCAT(_profilerName, __LINE__))
 
 namespace LWGC
 {
-	struct		ProfilingEntryData
+	using ProfilerNameId = uint32_t;
+
+	enum class	ProfilerEventType : uint32_t
+	{
+		Begin,
+		End,
+		Frame,
+	};
+
+	struct		ProfilerEvent
 	{
-		double	duration;	// in milliseconds
-		double	time;		// in milliseconds
+		uint64_t			time;	// in Profiler::GetTimestamp ticks
+		ProfilerNameId		name;
+		ProfilerEventType	type;
 	};
 
-	using ProfilingSamples = std::unordered_multimap< std::string, ProfilingEntryData >;
+	struct		ProfilerScope
+	{
+		uint64_t		start;	// in nanoseconds
+		uint64_t		end;
+		ProfilerNameId	name;
+		uint32_t		depth;
+		uint32_t		threadIndex;
+	};
 
+	struct		ProfilerAllocation
+	{
+		uint64_t		time;	// in nanoseconds
+		int64_t			bytes;	// negative for a release
+		ProfilerNameId	name;
+		uint32_t		threadIndex;
+	};
+
+	// All the scopes and allocations that started between two Profiler::BeginFrame
+	struct		ProfilerFrame
+	{
+		uint64_t							index;
+		uint64_t							start;	// in nanoseconds
+		uint64_t							end;
+		std::vector< ProfilerScope >		scopes;
+		std::vector< ProfilerAllocation >	allocations;
+	};
+
+	// Every thread writes its begin / end events in its own lock-free ring buffer, a background thread
+	// pairs them into scopes and groups them by frame. Nothing is allocated on the profiled threads
+	// once their buffer exists, and the events are dropped when a buffer is full.
 	class		Profiler
 	{
-		friend class ProfilingSample;
 		private:
-			static ProfilingSamples		_samples;
-			static ProfilingEntryData	_lastInsertedEntry;
+			struct	ThreadBuffer
+			{
+				LockFreeQueue< ProfilerEvent >	events;
+				std::string						name;
+				uint32_t						index;
+				std::atomic< uint64_t >			droppedEvents;
+				std::vector< ProfilerEvent >	openScopes;	// Only used by the aggregation thread
+
+				ThreadBuffer(size_t capacity, uint32_t index) : events(capacity), index(index), droppedEvents(0) {}
+			};
+
+			static std::atomic< bool >							_enabled;
+			static thread_local ThreadBuffer *					_threadBuffer;
+			static std::mutex									_threadsMutex;
+			static std::vector< std::unique_ptr< ThreadBuffer > >	_threads;
+			static std::vector< ThreadBuffer * >				_freeThreads;	// Buffers of exited threads, reused by the new ones
+
+			static std::mutex									_namesMutex;
+			static std::deque< std::string >					_names;
+			static std::unordered_map< std::string, ProfilerNameId >	_nameIds;
+
+			static std::thread									_aggregationThread;
+			static std::mutex									_aggregationMutex;
+			static std::condition_variable						_aggregationCondition;
+			static bool											_stop;
+			static ProfilerFrame								_openFrame;
+			static std::vector< ProfilerScope >					_pendingScopes;
+			static std::vector< uint64_t >						_frameMarkers;
+			static std::vector< ProfilerAllocation >			_closingAllocations;	// Only used by the aggregation thread
 
-			static void	AddSample(const std::string & name, double durationInMilliseconds, double frameTimeInMilliseconds) noexcept;
+			// Allocations are rare enough to go through a lock instead of the ring buffers
+			static std::mutex									_allocationsMutex;
+			static std::vector< ProfilerAllocation >			_pendingAllocations;
+
+			static std::mutex									_framesMutex;
+			static std::deque< ProfilerFrame >					_frames;
+
+			// Timestamp to nanoseconds conversion, refined by the aggregation thread
+			static uint64_t										_calibrationTimestamp;
+			static uint64_t										_calibrationTime;
+			static double										_nanosecondsPerTick;
+
+			// Scopes timed elsewhere (GPU queries) and added to frames that can already be closed
+			static std::map< uint64_t, std::vector< ProfilerScope > >	_lateScopes;
+			static uint64_t										_lastLateFrame;
+			static bool											_hasLateScopes;
+			static std::atomic< uint64_t >						_frameCount;
+
+			static ThreadBuffer *	RegisterThread(void);
+			static bool				PushEvent(ProfilerNameId name, ProfilerEventType type) noexcept
+			{
+				ThreadBuffer *	buffer = _threadBuffer;
+
+				// Only the first event of a thread allocates
+				if (buffer == nullptr && (buffer = RegisterThreadNoExcept()) == nullptr)
+					return false;
+
+				if (!buffer->events.Push(ProfilerEvent{GetTimestamp(), name, type}))
+				{
+					buffer->droppedEvents.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				return true;
+			}
+			static ThreadBuffer *	RegisterThreadNoExcept(void) noexcept;
+			static void				ReleaseThread(void) noexcept;
+			static void				AggregationLoop(void);
+			static void				Aggregate(void);
+			static void				CloseFrame(uint64_t end);
+			static void				Calibrate(void);
+			static uint64_t			ToNanoseconds(uint64_t timestamp) noexcept;
 
 		public:
+			static const size_t			EventCapacity = 16384;
+			static const size_t			FrameHistorySize = 128;
+			static const ProfilerNameId	FrameName = 0;
+
 			Profiler(void) = delete;
 			Profiler(const Profiler &) = delete;
 			virtual ~Profiler(void) = delete;
 
 			Profiler &	operator=(Profiler const & src) = delete;
 
-			static const ProfilingEntryData GetLastSample(void) noexcept;
-			static const ProfilingSamples &	GetSamples(void) noexcept;
-			static void		Reset(void) noexcept;
+			// Start and stop the aggregation thread, the events are ignored while the profiler is stopped
+			static void		Start(void);
+			static void		Stop(void);
+			static bool		IsEnabled(void) noexcept;
+
+			// Return the same id for the same name, can be called from any thread
+			static ProfilerNameId	InternName(const std::string & name);
+			static std::string		GetName(ProfilerNameId name);
+			// Name displayed for the calling thread, registers the thread if needed
+			static void				SetThreadName(const std::string & name);
+			static std::string		GetThreadName(uint32_t threadIndex);
+			static size_t			GetThreadCount(void);
+			// Row that isn't bound to a thread, for the scopes added with AddLateScopes. Returns its thread index
+			static uint32_t			AddTrack(const std::string & name);
+
+			static void		BeginScope(ProfilerNameId name) noexcept { if (_enabled.load(std::memory_order_relaxed)) PushEvent(name, ProfilerEventType::Begin); }
+			static void		EndScope(ProfilerNameId name) noexcept { if (_enabled.load(std::memory_order_relaxed)) PushEvent(name, ProfilerEventType::End); }
+			// Called once per frame by the main thread
+			static void		BeginFrame(void) noexcept;
+			// Index of the frame opened by the last BeginFrame
+			static uint64_t	GetFrameIndex(void) noexcept;
+			// Add scopes to a frame after the fact, the frame can be closed already if it's still in the history
+			static void		AddLateScopes(uint64_t frameIndex, const std::vector< ProfilerScope > & scopes);
+			// Memory allocated (or released with a negative size) by the calling thread
+			static void		RecordAllocation(ProfilerNameId name, int64_t bytes) noexcept;
+
+			// Raw tick counter used for the events: the TSC on x86, steady_clock nanoseconds elsewhere
+			static uint64_t	GetTimestamp(void) noexcept
+			{
+#ifdef LWGC_PROFILER_TSC
+				return __rdtsc();
+#else
+				return GetTime();
+#endif
+			}
+
+			// In nanoseconds, the time base of the aggregated scopes and frames
+			static uint64_t	GetTime(void) noexcept
+			{
+				return std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			// The last aggregated frame, false if there is none yet. With waitLateScopes, the last frame that
+			// received its late scopes is returned instead (once some were added)
+			static bool		GetLastFrame(ProfilerFrame & frame, bool waitLateScopes = false);
+			// Index of the last aggregated frame, false if there is none yet
+			static bool		GetLastFrameIndex(uint64_t & index);
+			// Copy the frames of the history between firstIndex and lastIndex (included), the oldest first
+			static void		GetFrames(uint64_t firstIndex, uint64_t lastIndex, std::vector< ProfilerFrame > & frames);
+			// Duration in milliseconds of the last frames, the most recent first
+			static void		GetFrameDurations(std::vector< float > & durations);
+			static uint64_t	GetDroppedEventCount(void);
+	};
+
+	class		ProfilingScope
+	{
+		private:
+			ProfilerNameId	_name;
+
+		public:
+			ProfilingScope(ProfilerNameId name) noexcept : _name(name) { Profiler::BeginScope(_name); }
+			ProfilingScope(const ProfilingScope &) = delete;
+			~ProfilingScope(void) { Profiler::EndScope(_name); }
+
+			ProfilingScope &	operator=(ProfilingScope const & src) = delete;
 	};
 
 	std::ostream &	operator<<(std::ostream & o, Profiler const & r);
-}
\ No newline at end of file
+}
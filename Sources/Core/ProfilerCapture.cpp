@@ -0,0 +1,504 @@
+#include "ProfilerCapture.hpp"
+
+#include <cstring>
+#include <cstdio>
+
+using namespace LWGC;
+
+std::mutex										ProfilerCapture::_mutex;
+std::thread										ProfilerCapture::_thread;
+std::condition_variable							ProfilerCapture::_condition;
+bool											ProfilerCapture::_stop = false;
+std::atomic< bool >								ProfilerCapture::_capturing(false);
+
+std::ofstream									ProfilerCapture::_file;
+std::string										ProfilerCapture::_path;
+ProfilerCaptureFormat							ProfilerCapture::_format = ProfilerCaptureFormat::ChromeTrace;
+uint64_t										ProfilerCapture::_maxFileSize = ProfilerCapture::DefaultMaxFileSize;
+uint64_t										ProfilerCapture::_fileSize = 0;
+uint64_t										ProfilerCapture::_nextFrame = 0;
+uint64_t										ProfilerCapture::_origin = 0;
+int64_t											ProfilerCapture::_allocatedBytes = 0;
+std::atomic< uint64_t >							ProfilerCapture::_writtenFrames(0);
+std::atomic< uint64_t >							ProfilerCapture::_lostFrames(0);
+std::unordered_map< ProfilerNameId, std::string >	ProfilerCapture::_names;
+std::unordered_set< uint32_t >					ProfilerCapture::_threads;
+
+const char *		ProfilerCapture::ArgumentPrefix = "--profiler-capture=";
+const char *		ProfilerCapture::MaxSizeArgumentPrefix = "--profiler-capture-max-size=";
+const char *		ProfilerCapture::BinaryExtension = ".lwgcprof";
+
+static const auto		CaptureInterval = std::chrono::milliseconds(20);
+static const char		BinaryMagic[] = "LWGCPROF";
+static const uint64_t	BinaryVersion = 1;
+
+// Records of the binary format, all the integers are LEB128 varints and the signed ones are zigzag encoded.
+// The times are in nanoseconds, the frames relative to the first frame and the rest relative to their frame.
+enum class	BinaryRecord : uint8_t
+{
+	Name = 1,		// id, length, characters
+	Thread,			// index, length, characters
+	Frame,			// index, start, duration
+	Scope,			// thread, name, depth, signed start, duration
+	Allocation,		// thread, name, signed time, signed bytes
+};
+
+static void			AppendVarint(std::string & data, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back(static_cast< char >((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	data.push_back(static_cast< char >(value));
+}
+
+static void			AppendSigned(std::string & data, int64_t value)
+{
+	AppendVarint(data, (static_cast< uint64_t >(value) << 1) ^ static_cast< uint64_t >(value >> 63));
+}
+
+static void			AppendString(std::string & data, const std::string & value)
+{
+	AppendVarint(data, value.size());
+	data += value;
+}
+
+static uint64_t		ReadVarint(std::istream & stream)
+{
+	uint64_t	value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = stream.get();
+
+		if (byte == EOF)
+			throw std::runtime_error("Truncated profiler capture");
+
+		value |= static_cast< uint64_t >(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return value;
+	}
+
+	throw std::runtime_error("Invalid varint in profiler capture");
+}
+
+static int64_t		ReadSigned(std::istream & stream)
+{
+	uint64_t value = ReadVarint(stream);
+
+	return static_cast< int64_t >(value >> 1) ^ -static_cast< int64_t >(value & 1);
+}
+
+static std::string	ReadString(std::istream & stream)
+{
+	std::string	value(ReadVarint(stream), '\0');
+
+	if (!stream.read(&value[0], value.size()))
+		throw std::runtime_error("Truncated profiler capture");
+
+	return value;
+}
+
+static std::string	EscapeJson(const std::string & value)
+{
+	std::string	escaped;
+
+	for (char c : value)
+	{
+		if (c == '"' || c == '\\')
+			escaped += std::string("\\") + c;
+		else if (static_cast< unsigned char >(c) < 0x20)
+		{
+			char	code[8];
+			snprintf(code, sizeof(code), "\\u%04x", c);
+			escaped += code;
+		}
+		else
+			escaped += c;
+	}
+
+	return escaped;
+}
+
+// Trace event format: the times are in microseconds, everything is in the same process
+static std::string	ChromeMicroseconds(int64_t nanoseconds)
+{
+	char	buffer[32];
+
+	snprintf(buffer, sizeof(buffer), "%.3f", static_cast< double >(nanoseconds) / 1000.0);
+	return buffer;
+}
+
+static std::string	ChromeThreadEvent(uint32_t threadIndex, const std::string & name)
+{
+	return "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(threadIndex) + ",\"args\":{\"name\":\"" + EscapeJson(name) + "\"}}";
+}
+
+static std::string	ChromeFrameEvent(uint64_t index, int64_t start)
+{
+	return "{\"name\":\"Frame " + std::to_string(index) + "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" + ChromeMicroseconds(start) + "}";
+}
+
+static std::string	ChromeScopeEvent(const std::string & escapedName, uint32_t threadIndex, int64_t start, uint64_t duration)
+{
+	return "{\"name\":\"" + escapedName + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(threadIndex) + ",\"ts\":" + ChromeMicroseconds(start) + ",\"dur\":" + ChromeMicroseconds(static_cast< int64_t >(duration)) + "}";
+}
+
+// An instant event on the thread for the allocation itself, and a counter for the sum of the recorded
+// allocations and releases
+static std::string	ChromeAllocationEvents(const std::string & escapedName, uint32_t threadIndex, int64_t time, int64_t bytes, int64_t allocatedBytes)
+{
+	return "{\"name\":\"" + escapedName + "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" + std::to_string(threadIndex) + ",\"ts\":" + ChromeMicroseconds(time) + ",\"args\":{\"bytes\":" + std::to_string(bytes) + "}},\n"
+		+ "{\"name\":\"Recorded allocations\",\"ph\":\"C\",\"pid\":1,\"ts\":" + ChromeMicroseconds(time) + ",\"args\":{\"bytes\":" + std::to_string(allocatedBytes) + "}}";
+}
+
+bool				ProfilerCapture::Start(const std::string & path, ProfilerCaptureFormat format, uint64_t maxFileSize)
+{
+	uint64_t	lastFrame;
+
+	if (_capturing)
+		return false;
+
+	// The previous capture stopped by itself when its file was full
+	if (_thread.joinable())
+		Stop();
+
+	_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!_file.is_open())
+	{
+		std::cout << "Can't open the profiler capture file " << path << std::endl;
+		return false;
+	}
+
+	_path = path;
+	_format = format;
+	_maxFileSize = maxFileSize;
+	_fileSize = 0;
+	_nextFrame = Profiler::GetLastFrameIndex(lastFrame) ? lastFrame + 1 : 0;
+	_origin = 0;
+	_allocatedBytes = 0;
+	_writtenFrames = 0;
+	_lostFrames = 0;
+	_names.clear();
+	_threads.clear();
+
+	std::string	header;
+
+	if (_format == ProfilerCaptureFormat::Binary)
+	{
+		header.assign(BinaryMagic, sizeof(BinaryMagic) - 1);
+		AppendVarint(header, BinaryVersion);
+	}
+	else // JSON array format, the closing bracket is optional so a capture cut short is still readable
+		header = "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LWGC\"}}";
+
+	Flush(header);
+
+	_stop = false;
+	_capturing = true;
+	_thread = std::thread(&ProfilerCapture::CaptureLoop);
+
+	return true;
+}
+
+void				ProfilerCapture::Stop(void)
+{
+	if (!_thread.joinable())
+		return ;
+
+	{
+		std::lock_guard< std::mutex >	lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_one();
+	_thread.join();
+}
+
+bool				ProfilerCapture::IsCapturing(void) noexcept { return _capturing; }
+
+void				ProfilerCapture::CaptureLoop(void)
+{
+	std::unique_lock< std::mutex >	lock(_mutex);
+
+	while (!_stop && _capturing)
+	{
+		_condition.wait_for(lock, CaptureInterval, [](){ return _stop; });
+		WriteFrames(_stop);
+	}
+
+	if (_format == ProfilerCaptureFormat::ChromeTrace)
+		_file << "\n]\n";
+	_file.close();
+
+	std::cout << "Profiler capture " << _path << ": " << _writtenFrames << " frames written, " << _lostFrames << " lost" << std::endl;
+	_capturing = false;
+}
+
+void				ProfilerCapture::WriteFrames(bool flush)
+{
+	std::vector< ProfilerFrame >	frames;
+	uint64_t						lastFrame;
+
+	if (!Profiler::GetLastFrameIndex(lastFrame))
+		return ;
+
+	// Leave time to the late GPU scopes, except for the last frames when the capture stops
+	if (!flush)
+	{
+		if (lastFrame < LateScopeFrameDelay)
+			return ;
+		lastFrame -= LateScopeFrameDelay;
+	}
+
+	if (lastFrame < _nextFrame)
+		return ;
+
+	Profiler::GetFrames(_nextFrame, lastFrame, frames);
+
+	for (const auto & frame : frames)
+	{
+		// The capture thread was too slow and the frames left the history
+		if (frame.index > _nextFrame)
+			_lostFrames += frame.index - _nextFrame;
+
+		WriteFrame(frame);
+		if (!_capturing)
+			return ;
+
+		_nextFrame = frame.index + 1;
+		_writtenFrames++;
+	}
+}
+
+void				ProfilerCapture::WriteFrame(const ProfilerFrame & frame)
+{
+	std::string	data;
+
+	if (_origin == 0)
+		_origin = frame.start;
+
+	int64_t	frameStart = static_cast< int64_t >(frame.start - _origin);
+
+	// Names and threads first, the binary reader needs them before the records that use them
+	for (const auto & scope : frame.scopes)
+	{
+		WriteThread(scope.threadIndex, data);
+		WriteName(scope.name, data);
+	}
+	for (const auto & allocation : frame.allocations)
+	{
+		WriteThread(allocation.threadIndex, data);
+		WriteName(allocation.name, data);
+	}
+
+	if (_format == ProfilerCaptureFormat::Binary)
+	{
+		data.push_back(static_cast< char >(BinaryRecord::Frame));
+		AppendVarint(data, frame.index);
+		AppendVarint(data, static_cast< uint64_t >(frameStart));
+		AppendVarint(data, frame.end - frame.start);
+
+		for (const auto & scope : frame.scopes)
+		{
+			data.push_back(static_cast< char >(BinaryRecord::Scope));
+			AppendVarint(data, scope.threadIndex);
+			AppendVarint(data, scope.name);
+			AppendVarint(data, scope.depth);
+			AppendSigned(data, static_cast< int64_t >(scope.start - frame.start));
+			AppendVarint(data, scope.end - scope.start);
+		}
+
+		for (const auto & allocation : frame.allocations)
+		{
+			data.push_back(static_cast< char >(BinaryRecord::Allocation));
+			AppendVarint(data, allocation.threadIndex);
+			AppendVarint(data, allocation.name);
+			AppendSigned(data, static_cast< int64_t >(allocation.time - frame.start));
+			AppendSigned(data, allocation.bytes);
+		}
+	}
+	else
+	{
+		WriteEvent(ChromeFrameEvent(frame.index, frameStart), data);
+
+		for (const auto & scope : frame.scopes)
+			WriteEvent(ChromeScopeEvent(_names[scope.name], scope.threadIndex, static_cast< int64_t >(scope.start - _origin), scope.end - scope.start), data);
+
+		for (const auto & allocation : frame.allocations)
+		{
+			_allocatedBytes += allocation.bytes;
+			WriteEvent(ChromeAllocationEvents(_names[allocation.name], allocation.threadIndex, static_cast< int64_t >(allocation.time - _origin), allocation.bytes, _allocatedBytes), data);
+		}
+	}
+
+	Flush(data);
+}
+
+const std::string &	ProfilerCapture::WriteName(ProfilerNameId name, std::string & data)
+{
+	auto written = _names.find(name);
+
+	if (written != _names.end())
+		return written->second;
+
+	std::string	value = Profiler::GetName(name);
+
+	if (_format == ProfilerCaptureFormat::Binary)
+	{
+		data.push_back(static_cast< char >(BinaryRecord::Name));
+		AppendVarint(data, name);
+		AppendString(data, value);
+	}
+	else // Only kept to write the events
+		value = EscapeJson(value);
+
+	return _names.insert({name, value}).first->second;
+}
+
+void				ProfilerCapture::WriteThread(uint32_t threadIndex, std::string & data)
+{
+	if (!_threads.insert(threadIndex).second)
+		return ;
+
+	std::string	name = Profiler::GetThreadName(threadIndex);
+
+	if (_format == ProfilerCaptureFormat::Binary)
+	{
+		data.push_back(static_cast< char >(BinaryRecord::Thread));
+		AppendVarint(data, threadIndex);
+		AppendString(data, name);
+	}
+	else
+		WriteEvent(ChromeThreadEvent(threadIndex, name), data);
+}
+
+void				ProfilerCapture::WriteEvent(const std::string & event, std::string & data)
+{
+	// Never the first event, the header contains the process name
+	data += ",\n" + event;
+}
+
+bool				ProfilerCapture::Flush(const std::string & data)
+{
+	if (_fileSize + data.size() > _maxFileSize)
+	{
+		std::cout << "Profiler capture " << _path << " reached its maximum size of " << _maxFileSize << " bytes, stopping the capture" << std::endl;
+		_capturing = false;
+		return false;
+	}
+
+	_file.write(data.data(), data.size());
+	_fileSize += data.size();
+
+	return true;
+}
+
+bool				ProfilerCapture::ParseArguments(int ac, char ** av)
+{
+	std::string	path;
+	uint64_t	maxFileSize = DefaultMaxFileSize;
+
+	for (int i = 1; i < ac; i++)
+	{
+		if (strncmp(av[i], ArgumentPrefix, strlen(ArgumentPrefix)) == 0)
+			path = av[i] + strlen(ArgumentPrefix);
+		else if (strncmp(av[i], MaxSizeArgumentPrefix, strlen(MaxSizeArgumentPrefix)) == 0)
+			maxFileSize = std::stoull(av[i] + strlen(MaxSizeArgumentPrefix)) * 1024 * 1024;
+	}
+
+	if (path.empty())
+		return false;
+
+	size_t	extensionLength = strlen(BinaryExtension);
+	bool	binary = path.size() >= extensionLength && path.compare(path.size() - extensionLength, extensionLength, BinaryExtension) == 0;
+
+	return Start(path, binary ? ProfilerCaptureFormat::Binary : ProfilerCaptureFormat::ChromeTrace, maxFileSize);
+}
+
+uint64_t			ProfilerCapture::GetWrittenFrameCount(void) noexcept { return _writtenFrames; }
+
+uint64_t			ProfilerCapture::GetLostFrameCount(void) noexcept { return _lostFrames; }
+
+void				ProfilerCapture::ConvertToChromeTrace(const std::string & binaryPath, const std::string & chromeTracePath)
+{
+	std::ifstream	input(binaryPath, std::ios::binary);
+	std::ofstream	output(chromeTracePath, std::ios::binary | std::ios::trunc);
+	char			magic[sizeof(BinaryMagic) - 1];
+
+	if (!input.is_open())
+		throw std::runtime_error("Can't open the profiler capture " + binaryPath);
+	if (!output.is_open())
+		throw std::runtime_error("Can't create the Chrome trace " + chromeTracePath);
+
+	if (!input.read(magic, sizeof(magic)) || memcmp(magic, BinaryMagic, sizeof(magic)) != 0)
+		throw std::runtime_error(binaryPath + " is not a binary profiler capture");
+	if (ReadVarint(input) != BinaryVersion)
+		throw std::runtime_error("Unsupported version of the binary profiler capture " + binaryPath);
+
+	std::unordered_map< uint64_t, std::string >	names;
+	int64_t										frameStart = 0;
+	int64_t										allocatedBytes = 0;
+	int											record;
+
+	output << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LWGC\"}}";
+
+	// Events are written one by one, the only state kept is the name table
+	while ((record = input.get()) != EOF)
+	{
+		switch (static_cast< BinaryRecord >(record))
+		{
+			case BinaryRecord::Name:
+			{
+				uint64_t id = ReadVarint(input);
+				names[id] = EscapeJson(ReadString(input));
+				break ;
+			}
+			case BinaryRecord::Thread:
+			{
+				uint32_t threadIndex = static_cast< uint32_t >(ReadVarint(input));
+				output << ",\n" << ChromeThreadEvent(threadIndex, ReadString(input));
+				break ;
+			}
+			case BinaryRecord::Frame:
+			{
+				uint64_t index = ReadVarint(input);
+				frameStart = static_cast< int64_t >(ReadVarint(input));
+				ReadVarint(input);
+				output << ",\n" << ChromeFrameEvent(index, frameStart);
+				break ;
+			}
+			case BinaryRecord::Scope:
+			{
+				uint32_t	threadIndex = static_cast< uint32_t >(ReadVarint(input));
+				uint64_t	name = ReadVarint(input);
+				ReadVarint(input);
+				int64_t		start = frameStart + ReadSigned(input);
+				uint64_t	duration = ReadVarint(input);
+				output << ",\n" << ChromeScopeEvent(names[name], threadIndex, start, duration);
+				break ;
+			}
+			case BinaryRecord::Allocation:
+			{
+				uint32_t	threadIndex = static_cast< uint32_t >(ReadVarint(input));
+				uint64_t	name = ReadVarint(input);
+				int64_t		time = frameStart + ReadSigned(input);
+				int64_t		bytes = ReadSigned(input);
+				allocatedBytes += bytes;
+				output << ",\n" << ChromeAllocationEvents(names[name], threadIndex, time, bytes, allocatedBytes);
+				break ;
+			}
+			default:
+				throw std::runtime_error("Unknown record " + std::to_string(record) + " in the profiler capture " + binaryPath);
+		}
+	}
+
+	output << "\n]\n";
+}
+
+std::ostream &	operator<<(std::ostream & o, ProfilerCapture const & r)
+{
+	o << "ProfilerCapture" << std::endl;
+	(void)r;
+	return (o);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+#include "Core/Profiler.hpp"
+
+namespace LWGC
+{
+	enum class	ProfilerCaptureFormat
+	{
+		ChromeTrace,	// Trace event JSON, opens in chrome://tracing, Perfetto or Tracy's importer
+		Binary,			// Compact stream of varint records, see ConvertToChromeTrace
+	};
+
+	// Streams the aggregated profiler frames to a file: scopes of every thread and GPU lane, frame markers,
+	// allocations and thread names. A background thread copies the frames out of the Profiler history a few
+	// frames after they close (so the GPU scopes are read back) and writes them right away, the memory used
+	// doesn't grow with the length of the capture. The capture stops by itself when the file reaches its
+	// maximum size, and the frames that left the history before being written are counted as lost.
+	class		ProfilerCapture
+	{
+		private:
+			static std::mutex						_mutex;
+			static std::thread						_thread;
+			static std::condition_variable			_condition;
+			static bool								_stop;
+			static std::atomic< bool >				_capturing;
+
+			// Only used by the capture thread once started
+			static std::ofstream					_file;
+			static std::string						_path;
+			static ProfilerCaptureFormat			_format;
+			static uint64_t							_maxFileSize;
+			static uint64_t							_fileSize;
+			static uint64_t							_nextFrame;
+			static uint64_t							_origin;			// Profiler time of the first written frame
+			static int64_t							_allocatedBytes;
+			static std::atomic< uint64_t >			_writtenFrames;
+			static std::atomic< uint64_t >			_lostFrames;
+			static std::unordered_map< ProfilerNameId, std::string >	_names;	// Names already written
+			static std::unordered_set< uint32_t >	_threads;
+
+			static void		CaptureLoop(void);
+			static void		WriteFrames(bool flush);
+			static void		WriteFrame(const ProfilerFrame & frame);
+			static const std::string &	WriteName(ProfilerNameId name, std::string & data);
+			static void		WriteThread(uint32_t threadIndex, std::string & data);
+			static void		WriteEvent(const std::string & event, std::string & data);
+			static bool		Flush(const std::string & data);
+
+		public:
+			// Frames a capture waits before writing a frame, enough for the GPU readback of the frames in flight
+			static const uint64_t	LateScopeFrameDelay = 8;
+			static const uint64_t	DefaultMaxFileSize = 1024ull * 1024 * 1024;
+			static const char *		ArgumentPrefix;
+			static const char *		MaxSizeArgumentPrefix;
+			static const char *		BinaryExtension;
+
+			ProfilerCapture(void) = delete;
+			ProfilerCapture(const ProfilerCapture &) = delete;
+			virtual ~ProfilerCapture(void) = delete;
+
+			ProfilerCapture &	operator=(ProfilerCapture const & src) = delete;
+
+			// Captures the frames that close from now on, false when the file can't be created
+			static bool		Start(const std::string & path, ProfilerCaptureFormat format = ProfilerCaptureFormat::ChromeTrace, uint64_t maxFileSize = DefaultMaxFileSize);
+			// Writes the remaining frames of the history and closes the file
+			static void		Stop(void);
+			static bool		IsCapturing(void) noexcept;
+
+			// Starts a capture for --profiler-capture=<path>, binary when the path ends with BinaryExtension.
+			// The maximum size is set in MB with --profiler-capture-max-size=<size>. False if there is no capture
+			static bool		ParseArguments(int ac, char ** av);
+
+			static uint64_t	GetWrittenFrameCount(void) noexcept;
+			static uint64_t	GetLostFrameCount(void) noexcept;
+
+			// Rewrite a binary capture as a Chrome trace
+			static void		ConvertToChromeTrace(const std::string & binaryPath, const std::string & chromeTracePath);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ProfilerCapture const & r);
+}
@@ -0,0 +1,285 @@
+#include "CameraCulling.hpp"
+
+#include "Core/Rendering/RenderContext.tpp"
+#include "Core/Components/MeshRenderer.hpp"
+#include "Core/Rendering/OcclusionCulling.hpp"
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace LWGC;
+
+CameraCulling::CameraCulling(void) : _queueCount(0), _occlusion(nullptr)
+{
+}
+
+CameraCulling::~CameraCulling(void)
+{
+	Release();
+}
+
+void			CameraCulling::Release(void) noexcept
+{
+	_objects.clear();
+	_cameraPlanes.clear();
+	_visibility.clear();
+	_lists.clear();
+	_cameraIndices.clear();
+	_casterPlanes.clear();
+	_casterVisibility.clear();
+	_casterLists.clear();
+	_cameraPyramids.clear();
+}
+
+// Vulkan clip space: -w <= x <= w, -w <= y <= w and 0 <= z <= w, glm matrices are indexed by column
+void			CameraCulling::ExtractFrustumPlanes(const glm::mat4 & viewProjection, std::vector< glm::vec4 > & planes)
+{
+	glm::vec4	rows[4];
+
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	const glm::vec4	frustum[6] = {
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[2], rows[3] - rows[2],
+	};
+
+	for (const auto & plane : frustum)
+	{
+		float length = glm::length(glm::vec3(plane));
+
+		// The far plane of the reverse Z projection is almost at the infinite, nothing is behind it
+		if (length < 1e-12f)
+			planes.push_back(glm::vec4(0, 0, 0, 1));
+		else
+			planes.push_back(plane / length);
+	}
+}
+
+void			CameraCulling::GatherObjects(RenderContext * context)
+{
+	auto	renderQueue = context->GetRenderQueue();
+
+	_objects.clear();
+	_queueCount = renderQueue->GetQueueCount();
+
+	for (uint32_t i = 0; i < _queueCount; i++)
+	{
+		for (auto renderer : renderQueue->GetRenderersForQueue(i))
+		{
+			CullingObject	object = {renderer, i, glm::vec3(0), glm::vec3(0), true, renderer->GetCastShadows(), renderer->IsStatic()};
+			auto			meshRenderer = dynamic_cast< MeshRenderer * >(renderer);
+
+			// The transforms are not thread safe, the world bounds are computed here for all the cameras
+			if (meshRenderer != nullptr && meshRenderer->GetMesh() != nullptr)
+			{
+				Bounds		bounds = meshRenderer->GetBounds();
+				glm::mat4	localToWorld = renderer->GetTransform()->GetLocalToWorldMatrix();
+				glm::vec3	localExtents = bounds.GetSize() * 0.5f;
+
+				if (bounds.GetSize() != glm::vec3(0))
+				{
+					object.center = glm::vec3(localToWorld * glm::vec4(bounds.GetMin() + localExtents, 1.0f));
+					for (int axis = 0; axis < 3; axis++)
+						object.extents += glm::abs(glm::vec3(localToWorld[axis])) * localExtents[axis];
+					object.alwaysVisible = false;
+				}
+			}
+
+			_objects.push_back(object);
+		}
+	}
+}
+
+void			CameraCulling::CullBatch(const std::vector< glm::vec4 > & planes, std::vector< uint8_t > & visibility, size_t firstObject, size_t lastObject, bool casters) noexcept
+{
+	for (size_t i = firstObject; i < lastObject; i++)
+	{
+		const auto & object = _objects[i];
+
+		if (casters && (object.alwaysVisible || !object.castShadows))
+			continue ;
+
+		if (object.alwaysVisible)
+		{
+			visibility[i] = 1;
+			continue ;
+		}
+
+		// Visible if the box is not completely outside of one plane of any of the views
+		for (size_t view = 0; view < planes.size() && !visibility[i]; view += 6)
+		{
+			bool	inside = true;
+
+			for (size_t p = view; p < view + 6 && inside; p++)
+			{
+				float distance = glm::dot(glm::vec3(planes[p]), object.center) + planes[p].w;
+				float radius = glm::dot(glm::abs(glm::vec3(planes[p])), object.extents);
+
+				inside = distance + radius >= 0.0f;
+			}
+			visibility[i] = inside;
+		}
+	}
+}
+
+// Flags the visible objects behind the depth as occluded, 2
+void			CameraCulling::OccludeBatch(const DepthPyramid & pyramid, std::vector< uint8_t > & visibility, size_t firstObject, size_t lastObject) noexcept
+{
+	for (size_t i = firstObject; i < lastObject; i++)
+	{
+		const auto & object = _objects[i];
+
+		if (visibility[i] && !object.alwaysVisible && pyramid.IsOccluded(object.center, object.extents))
+			visibility[i] = 2;
+	}
+}
+
+void			CameraCulling::BuildList(size_t cameraIndex)
+{
+	auto &	list = _lists[cameraIndex];
+
+	// The vectors keep their capacity from the last frames
+	list.queues.resize(_queueCount);
+	for (auto & queue : list.queues)
+		queue.clear();
+	list.visibleCount = 0;
+	list.occludedCount = 0;
+
+	for (size_t i = 0; i < _objects.size(); i++)
+	{
+		if (_visibility[cameraIndex][i] == 2)
+			list.occludedCount++;
+		if (_visibility[cameraIndex][i] != 1)
+			continue ;
+
+		list.queues[_objects[i].queue].push_back(_objects[i].renderer);
+		list.visibleCount++;
+	}
+}
+
+void			CameraCulling::BuildCasterList(size_t viewIndex)
+{
+	auto &	list = _casterLists[viewIndex];
+
+	list.staticCasters.clear();
+	list.dynamicCasters.clear();
+
+	for (size_t i = 0; i < _objects.size(); i++)
+	{
+		if (!_casterVisibility[viewIndex][i])
+			continue ;
+
+		if (_objects[i].isStatic)
+			list.staticCasters.push_back(_objects[i].renderer);
+		else
+			list.dynamicCasters.push_back(_objects[i].renderer);
+	}
+}
+
+void			CameraCulling::CullViews(size_t viewCount, const std::function< void(size_t view, size_t firstObject, size_t lastObject) > & cull)
+{
+	size_t	batchCount = (_objects.size() + ObjectsPerBatch - 1) / ObjectsPerBatch;
+	size_t	jobCount = batchCount * viewCount;
+	auto	job = [this, batchCount, &cull](size_t index)
+	{
+		size_t	firstObject = (index % batchCount) * ObjectsPerBatch;
+
+		cull(index / batchCount, firstObject, std::min(firstObject + ObjectsPerBatch, _objects.size()));
+	};
+
+	// Each job writes the flags of its own objects, the lists are built after so their order is stable
+	if (jobCount > 1)
+		ThreadPool::GetShared().ParallelFor(jobCount, job);
+	else
+	{
+		for (size_t i = 0; i < jobCount; i++)
+			job(i);
+	}
+}
+
+void			CameraCulling::Cull(const std::vector< Camera * > & cameras, RenderContext * context)
+{
+	LWGC_PROFILE_SCOPE("Camera Culling");
+
+	GatherObjects(context);
+
+	_cameraIndices.clear();
+	_cameraPlanes.resize(cameras.size());
+	_visibility.resize(cameras.size());
+	_lists.resize(cameras.size());
+	_cameraPyramids.resize(cameras.size());
+
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		_cameraIndices[cameras[i]] = i;
+		_cameraPyramids[i] = (_occlusion != nullptr) ? _occlusion->GetDepthPyramid(cameras[i]) : nullptr;
+		_cameraPlanes[i].clear();
+		for (uint32_t view = 0; view < cameras[i]->GetViewCount(); view++)
+			ExtractFrustumPlanes(cameras[i]->GetViewProjectionMatrix(view), _cameraPlanes[i]);
+		_visibility[i].assign(_objects.size(), 0);
+	}
+
+	CullViews(cameras.size(), [this](size_t camera, size_t firstObject, size_t lastObject)
+	{
+		CullBatch(_cameraPlanes[camera], _visibility[camera], firstObject, lastObject, false);
+		if (_cameraPyramids[camera] != nullptr)
+			OccludeBatch(*_cameraPyramids[camera], _visibility[camera], firstObject, lastObject);
+	});
+
+	for (size_t i = 0; i < cameras.size(); i++)
+		BuildList(i);
+}
+
+void			CameraCulling::CullShadowCasters(const std::vector< glm::mat4 > & viewProjections)
+{
+	LWGC_PROFILE_SCOPE("Shadow Caster Culling");
+
+	_casterPlanes.resize(viewProjections.size());
+	_casterVisibility.resize(viewProjections.size());
+	_casterLists.resize(viewProjections.size());
+
+	for (size_t i = 0; i < viewProjections.size(); i++)
+	{
+		_casterPlanes[i].clear();
+		ExtractFrustumPlanes(viewProjections[i], _casterPlanes[i]);
+		_casterVisibility[i].assign(_objects.size(), 0);
+	}
+
+	CullViews(viewProjections.size(), [this](size_t view, size_t firstObject, size_t lastObject)
+	{
+		CullBatch(_casterPlanes[view], _casterVisibility[view], firstObject, lastObject, true);
+	});
+
+	for (size_t i = 0; i < viewProjections.size(); i++)
+		BuildCasterList(i);
+}
+
+const VisibilityList *	CameraCulling::GetVisibleRenderers(const Camera * camera) const
+{
+	auto index = _cameraIndices.find(camera);
+
+	if (index == _cameraIndices.end())
+		return nullptr;
+	return &_lists[index->second];
+}
+
+const ShadowCasterList &	CameraCulling::GetShadowCasters(size_t viewIndex) const
+{
+	if (viewIndex >= _casterLists.size())
+		throw std::runtime_error("No shadow casters culled for the light view " + std::to_string(viewIndex));
+
+	return _casterLists[viewIndex];
+}
+
+void			CameraCulling::SetOcclusionCulling(const OcclusionCulling * occlusion) noexcept { _occlusion = occlusion; }
+
+size_t			CameraCulling::GetObjectCount(void) const noexcept { return _objects.size(); }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, CameraCulling const & r)
+{
+	o << "CameraCulling: " << r.GetObjectCount() << " objects" << std::endl;
+	return (o);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Components/Camera.hpp"
+#include "Core/Components/Renderer.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	class RenderContext;
+	class DepthPyramid;
+	class OcclusionCulling;
+
+	// Renderers in the frustum of at least one view of a camera, in the order of the render queues
+	struct	VisibilityList
+	{
+		std::vector< std::vector< Renderer * > >	queues;
+		size_t										visibleCount = 0;
+		size_t										occludedCount = 0;	// In the frustum but behind the depth pyramid
+	};
+
+	// Renderers casting shadows in a light view, the static ones can be drawn in a cache
+	struct	ShadowCasterList
+	{
+		std::vector< Renderer * >	staticCasters;
+		std::vector< Renderer * >	dynamicCasters;
+	};
+
+	// Frustum culling of all the cameras of a frame. The world bounds of the renderers are computed once on
+	// the main thread, then every camera tests them on the worker threads: the jobs are batches of renderers
+	// of a camera, so a single camera also uses all the cores. The lists are kept in the render queue order.
+	// The renderers in the frustum of a camera with a depth pyramid are also tested against it.
+	class		CameraCulling
+	{
+		private:
+			struct	CullingObject
+			{
+				Renderer *	renderer;
+				uint32_t	queue;
+				glm::vec3	center;
+				glm::vec3	extents;
+				bool		alwaysVisible;	// Renderers without bounds
+				bool		castShadows;
+				bool		isStatic;
+			};
+
+			std::vector< CullingObject >					_objects;
+			std::vector< std::vector< glm::vec4 > >			_cameraPlanes;	// Per camera, 6 planes per view facing inside
+			std::vector< std::vector< uint8_t > >			_visibility;	// Per camera, one flag per object
+			std::vector< VisibilityList >					_lists;
+			std::unordered_map< const Camera *, size_t >	_cameraIndices;
+			uint32_t										_queueCount;
+			std::vector< std::vector< glm::vec4 > >			_casterPlanes;		// Per light view
+			std::vector< std::vector< uint8_t > >			_casterVisibility;
+			std::vector< ShadowCasterList >					_casterLists;
+			const OcclusionCulling *						_occlusion;
+			std::vector< const DepthPyramid * >				_cameraPyramids;
+
+			void		GatherObjects(RenderContext * context);
+			void		CullBatch(const std::vector< glm::vec4 > & planes, std::vector< uint8_t > & visibility, size_t firstObject, size_t lastObject, bool casters) noexcept;
+			void		OccludeBatch(const DepthPyramid & pyramid, std::vector< uint8_t > & visibility, size_t firstObject, size_t lastObject) noexcept;
+			void		BuildList(size_t cameraIndex);
+			void		BuildCasterList(size_t viewIndex);
+			// Runs the jobs of viewCount views on the workers, by batches of objects
+			void		CullViews(size_t viewCount, const std::function< void(size_t view, size_t firstObject, size_t lastObject) > & cull);
+
+			static void	ExtractFrustumPlanes(const glm::mat4 & viewProjection, std::vector< glm::vec4 > & planes);
+
+		public:
+			static const size_t	ObjectsPerBatch = 256;
+
+			CameraCulling(void);
+			CameraCulling(const CameraCulling &) = delete;
+			virtual ~CameraCulling(void);
+
+			CameraCulling &	operator=(CameraCulling const & src) = delete;
+
+			void		Release(void) noexcept;
+
+			// Called once per frame with the camera matrices of the frame, before the render passes are recorded
+			void		Cull(const std::vector< Camera * > & cameras, RenderContext * context);
+
+			// The cameras are tested against the pyramids it has when they are culled, nullptr disables it
+			void		SetOcclusionCulling(const OcclusionCulling * occlusion) noexcept;
+
+			// nullptr if the camera was not culled this frame
+			const VisibilityList *	GetVisibleRenderers(const Camera * camera) const;
+
+			// Culls the shadow casters of the last Cull against each light view projection (depth 0 to 1). The
+			// renderers without bounds never cast shadows
+			void		CullShadowCasters(const std::vector< glm::mat4 > & viewProjections);
+			// Casters of a view of the last CullShadowCasters, in the render queue order
+			const ShadowCasterList &	GetShadowCasters(size_t viewIndex) const;
+			size_t		GetObjectCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, CameraCulling const & r);
+}
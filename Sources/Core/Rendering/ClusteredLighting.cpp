@@ -0,0 +1,313 @@
+#include "ClusteredLighting.hpp"
+
+#include "Core/Rendering/RenderContext.tpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/Components/Light.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/Material.hpp"
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace LWGC;
+
+static const VkDeviceSize	ClustersSize = sizeof(LightCluster) * LightClusterBinning::ClusterCount;
+// Large enough for the fixed lists of the compute path, the CPU lists are packed at the beginning
+static const VkDeviceSize	IndicesSize = sizeof(uint32_t) * LightClusterBinning::ClusterCount * LightClusterBinning::MaxLightsPerCluster;
+
+ClusteredLighting::ClusteredLighting(void) : _device(VK_NULL_HANDLE), _frameCount(0), _currentFrame(0), _mode(LightBinningMode::CPU),
+	_clusterFarPlane(500.0f), _directionalLightCount(0), _droppedLightCount(0), _shadowLight(nullptr)
+{
+}
+
+ClusteredLighting::~ClusteredLighting(void)
+{
+	Release();
+}
+
+static void		DestroyBuffer(VkDevice device, UniformBuffer & buffer) noexcept
+{
+	vkDestroyBuffer(device, buffer.buffer, nullptr);
+	vkFreeMemory(device, buffer.memory, nullptr);
+	buffer = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+}
+
+void			ClusteredLighting::Initialize(size_t frameCount)
+{
+	_device = VulkanInstance::Get()->GetDevice();
+	_frameCount = frameCount;
+
+	_lightBuffers.resize(frameCount);
+	for (auto & lightBuffer : _lightBuffers)
+	{
+		Vk::CreateBuffer(
+			sizeof(LWGC_Light) * MaxLights,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			lightBuffer.buffer,
+			lightBuffer.memory
+		);
+	}
+}
+
+// The frames using the buffers must be done
+void			ClusteredLighting::Release(void) noexcept
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	for (auto & camera : _cameras)
+	{
+		for (auto & resources : camera.second)
+		{
+			DestroyBuffer(_device, resources->params);
+			DestroyBuffer(_device, resources->clusters);
+			DestroyBuffer(_device, resources->indices);
+		}
+	}
+	for (auto & lightBuffer : _lightBuffers)
+		DestroyBuffer(_device, lightBuffer);
+
+	_cameras.clear();
+	_lightBuffers.clear();
+	_pendingDispatches.clear();
+	_device = VK_NULL_HANDLE;
+}
+
+void			ClusteredLighting::AllocateFrameResources(FrameResources & resources, size_t frameIndex)
+{
+	Vk::CreateBuffer(
+		sizeof(LWGC_LightClusters),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		resources.params.buffer,
+		resources.params.memory
+	);
+	Vk::CreateBuffer(ClustersSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, resources.clusters.buffer, resources.clusters.memory);
+	Vk::CreateBuffer(IndicesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, resources.indices.buffer, resources.indices.memory);
+
+	resources.set.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, resources.params.buffer, sizeof(LWGC_LightClusters));
+	resources.set.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _lightBuffers[frameIndex].buffer, sizeof(LWGC_Light) * MaxLights);
+	resources.set.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, resources.clusters.buffer, ClustersSize);
+	resources.set.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, resources.indices.buffer, IndicesSize);
+}
+
+ClusteredLighting::FrameResources *	ClusteredLighting::GetFrameResources(const Camera * camera)
+{
+	auto & frames = _cameras[camera];
+
+	if (frames.empty())
+	{
+		for (size_t i = 0; i < _frameCount; i++)
+		{
+			frames.push_back(std::make_unique< FrameResources >());
+			AllocateFrameResources(*frames.back(), i);
+		}
+	}
+
+	return frames[_currentFrame].get();
+}
+
+// The resources of the cameras that didn't render this frame are destroyed once the frames in flight are done
+void			ClusteredLighting::ReleaseUnusedCameras(const std::vector< Camera * > & cameras)
+{
+	for (auto camera = _cameras.begin(); camera != _cameras.end(); )
+	{
+		if (std::find(cameras.begin(), cameras.end(), camera->first) != cameras.end())
+		{
+			++camera;
+			continue ;
+		}
+
+		VkDevice	device = _device;
+		auto		resources = std::make_shared< CameraResources >(std::move(camera->second));
+
+		RenderPipelineManager::ReleaseAfterFrames([device, resources]()
+		{
+			for (auto & frame : *resources)
+			{
+				DestroyBuffer(device, frame->params);
+				DestroyBuffer(device, frame->clusters);
+				DestroyBuffer(device, frame->indices);
+			}
+			resources->clear();
+		});
+		camera = _cameras.erase(camera);
+	}
+}
+
+void			ClusteredLighting::GatherLights(RenderContext * context)
+{
+	std::unordered_set< Light * >	lights;
+
+	context->GetLights(lights);
+
+	_lights.clear();
+	_lightSpheres.clear();
+
+	// The directional lights are first, the shaders evaluate them for all the pixels
+	for (auto pass : {0, 1})
+	{
+		for (const auto light : lights)
+		{
+			if ((light->GetLightType() == LightType::Directional) != (pass == 0))
+				continue ;
+
+			Color		color = light->GetColor();
+			glm::vec3	position = glm::vec3(light->GetTransform()->GetLocalToWorldMatrix()[3]);
+			float		cosOuter = std::cos(glm::radians(light->GetOuterSpotAngle() / 2.0f));
+			float		cosInner = std::cos(glm::radians(light->GetInnerSpotAngle() / 2.0f));
+			LWGC_Light	data;
+
+			data.positionWS = glm::vec4(position, light->GetRange());
+			data.color = glm::vec4(color.r, color.g, color.b, 0.0f) * light->GetIntensity();
+			data.color.a = static_cast< float >(light->GetLightType());
+			data.directionWS = glm::vec4(light->GetDirection(), (light == _shadowLight) ? 1.0f : 0.0f);
+			data.spotAngles = glm::vec4(cosOuter, 1.0f / std::max(cosInner - cosOuter, 1e-4f), 0.0f, 0.0f);
+			_lights.push_back(data);
+
+			// The sphere of the range also bounds the cone of the spot lights
+			if (pass == 1)
+				_lightSpheres.push_back(data.positionWS);
+		}
+
+		if (pass == 0)
+			_directionalLightCount = static_cast< uint32_t >(std::min< size_t >(_lights.size(), MaxLights));
+	}
+
+	if (_lights.size() > MaxLights)
+	{
+		_droppedLightCount += _lights.size() - MaxLights;
+		_lights.resize(MaxLights);
+		_lightSpheres.resize(MaxLights - _directionalLightCount);
+	}
+
+	if (!_lights.empty())
+		Vk::UploadToMemory(_lightBuffers[_currentFrame].memory, _lights.data(), sizeof(LWGC_Light) * _lights.size());
+}
+
+void			ClusteredLighting::UpdateCamera(Camera * camera, FrameResources & resources)
+{
+	glm::mat4			view = camera->GetViewMatrix();
+	glm::mat4			projection = camera->GetProjectionMatrix();
+	VkRect2D			rect = camera->GetPixelRect();
+	LWGC_LightClusters	params;
+	LightClusterGrid	grid;
+	float				padding = 0.0f;
+
+	// The clusters are the ones of the camera, the eyes of the other views see the lights moved by their offset
+	for (uint32_t i = 0; i < camera->GetViewCount(); i++)
+		padding = std::max(padding, glm::length(glm::vec3(camera->GetViewOffset(i)[3])));
+
+	grid.nearPlane = camera->GetNearPlane();
+	grid.farPlane = std::max(_clusterFarPlane, grid.nearPlane * 2.0f);
+	grid.projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+
+	// Transposed for HLSL, like the camera matrices
+	params.view = glm::transpose(view);
+	params.gridSize = glm::uvec4(LightClusterBinning::TilesX, LightClusterBinning::TilesY, LightClusterBinning::Slices, LightClusterBinning::MaxLightsPerCluster);
+	params.lightCounts = glm::uvec4(_directionalLightCount, static_cast< uint32_t >(_lights.size()), 0, 0);
+	params.depthSlicing = glm::vec4(grid.nearPlane, LightClusterBinning::GetSliceScale(grid), projection[2][2], projection[3][2]);
+	params.viewport = glm::vec4(rect.offset.x, rect.offset.y, 1.0f / std::max(rect.extent.width, 1u), 1.0f / std::max(rect.extent.height, 1u));
+	params.projection = glm::vec4(grid.projectionScale, padding, 0.0f);
+	Vk::UploadToMemory(resources.params.memory, &params, sizeof(params));
+
+	if (_mode == LightBinningMode::Compute)
+	{
+		if (resources.binningShader == nullptr)
+		{
+			auto &	shader = resources.binningShader;
+
+			shader = std::make_unique< ComputeShader >("Shaders/Compute/LightClusters.hlsl");
+			shader->SetBuffer(LWGCBinding::Lights, resources.params.buffer, sizeof(LWGC_LightClusters), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+			shader->SetBuffer("lights", _lightBuffers[_currentFrame].buffer, sizeof(LWGC_Light) * MaxLights, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+			shader->SetBuffer("clusterLightRanges", resources.clusters.buffer, ClustersSize, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+			shader->SetBuffer("clusterLightIndices", resources.indices.buffer, IndicesSize, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+			// The lists are read by the fragment shaders of the passes recorded after
+			for (auto buffer : {resources.clusters.buffer, resources.indices.buffer})
+			{
+				VkBufferMemoryBarrier	barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.buffer = buffer;
+				barrier.offset = 0;
+				barrier.size = VK_WHOLE_SIZE;
+				shader->AddBufferBarrier(barrier, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			}
+		}
+		_pendingDispatches.push_back(&resources);
+		return ;
+	}
+
+	_viewSpheres.resize(_lightSpheres.size());
+	for (size_t i = 0; i < _lightSpheres.size(); i++)
+		_viewSpheres[i] = glm::vec4(glm::vec3(view * glm::vec4(glm::vec3(_lightSpheres[i]), 1.0f)), _lightSpheres[i].w + padding);
+
+	_binning.Bin(grid, _viewSpheres, _directionalLightCount, &ThreadPool::GetShared());
+	_droppedLightCount += _binning.GetDroppedLightCount();
+
+	const auto & indices = _binning.GetLightIndices();
+
+	Vk::UploadToMemory(resources.clusters.memory, const_cast< LightCluster * >(_binning.GetClusters().data()), ClustersSize);
+	if (!indices.empty())
+		Vk::UploadToMemory(resources.indices.memory, const_cast< uint32_t * >(indices.data()), sizeof(uint32_t) * indices.size());
+}
+
+void			ClusteredLighting::Update(const std::vector< Camera * > & cameras, RenderContext * context, size_t frameIndex)
+{
+	LWGC_PROFILE_SCOPE("Clustered Lighting");
+
+	_currentFrame = frameIndex;
+	_droppedLightCount = 0;
+	_pendingDispatches.clear();
+
+	GatherLights(context);
+
+	for (const auto camera : cameras)
+		UpdateCamera(camera, *GetFrameResources(camera));
+
+	ReleaseUnusedCameras(cameras);
+}
+
+void			ClusteredLighting::RecordBinning(VkCommandBuffer cmd)
+{
+	for (auto resources : _pendingDispatches)
+		resources->binningShader->Dispatch(cmd, LightClusterBinning::TilesX, LightClusterBinning::TilesY, LightClusterBinning::Slices);
+}
+
+VkDescriptorSet		ClusteredLighting::GetDescriptorSet(const Camera * camera)
+{
+	return GetFrameResources(camera)->set.GetDescriptorSet();
+}
+
+LightBinningMode	ClusteredLighting::GetBinningMode(void) const noexcept { return _mode; }
+void		ClusteredLighting::SetBinningMode(LightBinningMode mode) noexcept { _mode = mode; }
+
+float		ClusteredLighting::GetClusterFarPlane(void) const noexcept { return _clusterFarPlane; }
+
+void		ClusteredLighting::SetClusterFarPlane(float farPlane)
+{
+	if (farPlane <= 0.0f)
+		throw std::runtime_error("The far plane of the light clusters must be positive");
+
+	_clusterFarPlane = farPlane;
+}
+
+void		ClusteredLighting::SetShadowLight(const Light * light) noexcept { _shadowLight = light; }
+
+size_t		ClusteredLighting::GetLightCount(void) const noexcept { return _lights.size(); }
+size_t		ClusteredLighting::GetDroppedLightCount(void) const noexcept { return _droppedLightCount; }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, ClusteredLighting const & r)
+{
+	o << "ClusteredLighting: " << r.GetLightCount() << " lights, " << r.GetDroppedLightCount() << " dropped" << std::endl;
+	return (o);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Components/Camera.hpp"
+#include "Core/Rendering/LightClusterBinning.hpp"
+#include "Core/Shaders/ComputeShader.hpp"
+#include "Core/Vulkan/DescriptorSet.hpp"
+#include "Core/Vulkan/UniformBuffer.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include GLM_INCLUDE
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	class RenderContext;
+	class Light;
+
+	enum class	LightBinningMode
+	{
+		CPU,		// LightClusterBinning on the worker threads, the lists are uploaded
+		Compute,	// A compute shader per camera, recorded with RecordBinning
+	};
+
+	// Light lists of the clusters of each camera, read by the shaders including Common/ClusteredLighting.hlsl.
+	// The lights are uploaded once per frame, directional ones first: they are not binned, every pixel
+	// evaluates them. The buffers of a camera are allocated the first time it renders, one set per frame in
+	// flight so the CPU never writes the ones the GPU is reading.
+	class		ClusteredLighting
+	{
+		private:
+			struct	LWGC_Light
+			{
+				glm::vec4	positionWS;
+				glm::vec4	color;
+				glm::vec4	directionWS;
+				glm::vec4	spotAngles;
+			};
+
+			struct	LWGC_LightClusters
+			{
+				glm::mat4	view;
+				glm::uvec4	gridSize;
+				glm::uvec4	lightCounts;
+				glm::vec4	depthSlicing;
+				glm::vec4	viewport;
+				glm::vec4	projection;
+			};
+
+			struct	FrameResources
+			{
+				UniformBuffer					params;
+				UniformBuffer					clusters;
+				UniformBuffer					indices;
+				DescriptorSet					set;
+				std::unique_ptr< ComputeShader >	binningShader;
+			};
+
+			using CameraResources = std::vector< std::unique_ptr< FrameResources > >;
+
+			VkDevice					_device;
+			size_t						_frameCount;
+			size_t						_currentFrame;
+			LightBinningMode			_mode;
+			float						_clusterFarPlane;
+			LightClusterBinning			_binning;
+			std::vector< UniformBuffer >	_lightBuffers;	// Per frame in flight
+			std::vector< LWGC_Light >		_lights;
+			std::vector< glm::vec4 >		_lightSpheres;	// World space bounds of the binned lights
+			std::vector< glm::vec4 >		_viewSpheres;
+			uint32_t					_directionalLightCount;
+			size_t						_droppedLightCount;
+			const Light *				_shadowLight;
+			std::unordered_map< const Camera *, CameraResources >	_cameras;
+			std::vector< FrameResources * >	_pendingDispatches;
+
+			void				GatherLights(RenderContext * context);
+			FrameResources *	GetFrameResources(const Camera * camera);
+			void				ReleaseUnusedCameras(const std::vector< Camera * > & cameras);
+			void				AllocateFrameResources(FrameResources & resources, size_t frameIndex);
+			void				UpdateCamera(Camera * camera, FrameResources & resources);
+
+		public:
+			// Lights over it are ignored
+			static const uint32_t	MaxLights = 16384;
+
+			ClusteredLighting(void);
+			ClusteredLighting(const ClusteredLighting &) = delete;
+			virtual ~ClusteredLighting(void);
+
+			ClusteredLighting &	operator=(ClusteredLighting const & src) = delete;
+
+			void		Initialize(size_t frameCount);
+			void		Release(void) noexcept;
+
+			// Uploads the lights and bins them for each camera, the camera matrices must be the ones of the frame
+			void		Update(const std::vector< Camera * > & cameras, RenderContext * context, size_t frameIndex);
+			// Dispatches the binning of the cameras in compute mode, outside of a render pass
+			void		RecordBinning(VkCommandBuffer cmd);
+
+			// Set bound with LWGCBinding::Lights, valid for the cameras of the last Update
+			VkDescriptorSet		GetDescriptorSet(const Camera * camera);
+
+			// The directional light sampling the shadow maps, see ShadowMaps::GetShadowLight
+			void		SetShadowLight(const Light * light) noexcept;
+
+			LightBinningMode	GetBinningMode(void) const noexcept;
+			void		SetBinningMode(LightBinningMode mode) noexcept;
+			// Depth of the beginning of the last slice, the slices are thinner when it's closer to the near plane
+			float		GetClusterFarPlane(void) const noexcept;
+			void		SetClusterFarPlane(float farPlane);
+
+			size_t		GetLightCount(void) const noexcept;
+			// Lights over MaxLights, and in CPU mode over MaxLightsPerCluster in a cluster, during the last Update
+			size_t		GetDroppedLightCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ClusteredLighting const & r);
+}
@@ -0,0 +1,134 @@
+#include "DepthPyramid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace LWGC;
+
+DepthPyramid::DepthPyramid(void) : _viewProjection(1.0f), _cameraPosition(0.0f), _width(0), _height(0), _firstLevel(0)
+{
+}
+
+std::vector< DepthPyramidLevel >	DepthPyramid::GetLevels(uint32_t width, uint32_t height)
+{
+	std::vector< DepthPyramidLevel >	levels;
+	size_t								offset = 0;
+
+	if (width == 0 || height == 0)
+		return levels;
+
+	while (true)
+	{
+		levels.push_back({width, height, offset});
+		offset += static_cast< size_t >(width) * height;
+
+		if (width == 1 && height == 1)
+			break ;
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	return levels;
+}
+
+size_t			DepthPyramid::GetDepthCount(uint32_t width, uint32_t height)
+{
+	auto levels = GetLevels(width, height);
+
+	return levels.empty() ? 0 : levels.back().offset + 1;
+}
+
+void			DepthPyramid::Initialize(const glm::mat4 & viewProjection, const glm::vec3 & cameraPosition, uint32_t width, uint32_t height, uint32_t firstLevel, std::vector< float > depths)
+{
+	auto	levels = GetLevels(width, height);
+
+	if (firstLevel >= levels.size())
+		throw std::runtime_error("The depth pyramid of " + std::to_string(width) + "x" + std::to_string(height) + " has no level " + std::to_string(firstLevel));
+
+	size_t	firstOffset = levels[firstLevel].offset;
+
+	if (depths.size() != levels.back().offset + 1 - firstOffset)
+		throw std::runtime_error("The depth count doesn't match the levels of the pyramid");
+
+	_levels.assign(levels.begin() + firstLevel, levels.end());
+	for (auto & level : _levels)
+		level.offset -= firstOffset;
+
+	_viewProjection = viewProjection;
+	_cameraPosition = cameraPosition;
+	_width = width;
+	_height = height;
+	_firstLevel = firstLevel;
+	_depths = std::move(depths);
+}
+
+bool			DepthPyramid::IsOccluded(const glm::vec3 & center, const glm::vec3 & extents) const noexcept
+{
+	if (_levels.empty())
+		return false;
+
+	glm::vec2	ndcMin(1e30f);
+	glm::vec2	ndcMax(-1e30f);
+	float		nearestDepth = 0.0f;
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3	sign = glm::vec3((corner & 1) ? 1 : -1, (corner & 2) ? 1 : -1, (corner & 4) ? 1 : -1);
+		glm::vec4	clip = _viewProjection * glm::vec4(center + extents * sign, 1.0f);
+
+		if (clip.w <= 1e-5f)
+			return false;
+
+		glm::vec3	ndc = glm::vec3(clip) / clip.w;
+
+		ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+		ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+		nearestDepth = std::max(nearestDepth, ndc.z);
+	}
+
+	if (ndcMin.x < -1.0f || ndcMin.y < -1.0f || ndcMax.x > 1.0f || ndcMax.y > 1.0f)
+		return false;
+
+	// Texels of the level 0 under the box, then of the first kept level
+	auto toTexel = [](float ndc, uint32_t size, uint32_t level)
+	{
+		uint32_t texel = static_cast< uint32_t >(std::min((ndc * 0.5f + 0.5f) * size, size - 1.0f));
+		return texel >> level;
+	};
+
+	uint32_t	x0 = toTexel(ndcMin.x, _width, _firstLevel);
+	uint32_t	x1 = toTexel(ndcMax.x, _width, _firstLevel);
+	uint32_t	y0 = toTexel(ndcMin.y, _height, _firstLevel);
+	uint32_t	y1 = toTexel(ndcMax.y, _height, _firstLevel);
+	size_t		level = 0;
+
+	while ((x1 - x0 > 1 || y1 - y0 > 1) && level + 1 < _levels.size())
+	{
+		x0 >>= 1;
+		x1 >>= 1;
+		y0 >>= 1;
+		y1 >>= 1;
+		level++;
+	}
+
+	const DepthPyramidLevel &	l = _levels[level];
+	float						farthestDepth = 1.0f;
+
+	for (uint32_t y = y0; y <= y1; y++)
+		for (uint32_t x = x0; x <= x1; x++)
+			farthestDepth = std::min(farthestDepth, _depths[l.offset + static_cast< size_t >(y) * l.width + x]);
+
+	return nearestDepth < farthestDepth;
+}
+
+const glm::mat4 &	DepthPyramid::GetViewProjection(void) const noexcept { return _viewProjection; }
+const glm::vec3 &	DepthPyramid::GetCameraPosition(void) const noexcept { return _cameraPosition; }
+uint32_t			DepthPyramid::GetFirstLevel(void) const noexcept { return _firstLevel; }
+const std::vector< DepthPyramidLevel > &	DepthPyramid::GetLevels(void) const noexcept { return _levels; }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, DepthPyramid const & r)
+{
+	o << "DepthPyramid: " << r.GetLevels().size() << " levels from " << r.GetFirstLevel() << std::endl;
+	return (o);
+}
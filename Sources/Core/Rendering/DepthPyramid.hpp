@@ -0,0 +1,63 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	struct	DepthPyramidLevel
+	{
+		uint32_t	width;
+		uint32_t	height;
+		size_t		offset;		// In depths, from the first level of the pyramid
+	};
+
+	// Hierarchical depth of a camera: each texel of a level is the farthest (smallest, the depth is reversed)
+	// depth of the 2x2 texels under it, the levels are half the size of the previous one rounded up so a texel
+	// always covers its children. A box is hidden when its nearest point is behind the farthest depth of the
+	// few texels covering it, at the level where it spans at most 2x2 texels. The pyramid can be a few
+	// frames old: the boxes are projected with the matrix it was rendered with.
+	class		DepthPyramid
+	{
+		private:
+			glm::mat4						_viewProjection;
+			glm::vec3						_cameraPosition;
+			uint32_t						_width;
+			uint32_t						_height;
+			uint32_t						_firstLevel;
+			std::vector< DepthPyramidLevel >	_levels;	// From _firstLevel
+			std::vector< float >			_depths;
+
+		public:
+			DepthPyramid(void);
+			DepthPyramid(const DepthPyramid &) = delete;
+			virtual ~DepthPyramid(void) = default;
+
+			DepthPyramid &	operator=(DepthPyramid const & src) = delete;
+
+			// The levels under firstLevel are not kept, the depths are the ones of the kept levels one after the other
+			void		Initialize(const glm::mat4 & viewProjection, const glm::vec3 & cameraPosition, uint32_t width, uint32_t height, uint32_t firstLevel, std::vector< float > depths);
+
+			// True when the world space box is completely behind the depth. The boxes crossing the near plane or
+			// the sides of the view are never hidden, they were not in the frame of the pyramid
+			bool		IsOccluded(const glm::vec3 & center, const glm::vec3 & extents) const noexcept;
+
+			const glm::mat4 &	GetViewProjection(void) const noexcept;
+			const glm::vec3 &	GetCameraPosition(void) const noexcept;
+			uint32_t	GetFirstLevel(void) const noexcept;
+			const std::vector< DepthPyramidLevel > &	GetLevels(void) const noexcept;
+
+			// All the levels of a pyramid of this size, down to 1x1, with their offsets from the level 0
+			static std::vector< DepthPyramidLevel >	GetLevels(uint32_t width, uint32_t height);
+			// Depth count of the pyramid
+			static size_t	GetDepthCount(uint32_t width, uint32_t height);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, DepthPyramid const & r);
+}
@@ -3,48 +3,56 @@
 #include "Core/Vulkan/Vk.hpp"
 #include "Core/Rendering/RenderPipelineManager.hpp"
 #include "Core/Vulkan/ProfilingSample.hpp"
+#include "Core/Vulkan/MaterialStates.hpp"
+#include "Core/Shaders/BuiltinShaders.hpp"
+#include "Core/Components/MeshRenderer.hpp"
+
+#include <algorithm>
 
 using namespace LWGC;
 
-Texture2D * fractalTexture;
+ForwardRenderPipeline::~ForwardRenderPipeline(void)
+{
+	vkDeviceWaitIdle(device);
+
+	if (!IsInitialized())
+		return ;
+
+	occlusionCulling.Release();
+	for (auto fence : asyncComputeFences)
+		vkDestroyFence(device, fence, nullptr);
+	for (int i = 0; i < 2; i++)
+	{
+		vkDestroySemaphore(device, asyncComputeSemaphores[i], nullptr);
+		vkDestroySemaphore(device, graphicsSemaphores[i], nullptr);
+	}
+}
 
 void	ForwardRenderPipeline::Initialize(SwapChain * swapChain)
 {
 	RenderPipeline::Initialize(swapChain);
 
-	heavyComputeShader.LoadShader("Shaders/Compute/Heavy.hlsl");
-	heavyComputeFence = Vk::CreateFence(true);
-
-	// Allocate an async command queue (the device must have more than one queue to run the application)
+	// Allocate an async command queue, it's the main queue when the device doesn't have another one
 	instance->AllocateDeviceQueue(asyncComputeQueue, asyncComputeQueueIndex);
 	asyncComputePool.Initialize(asyncComputeQueue, asyncComputeQueueIndex);
-	asyncCommandBuffer = asyncComputePool.Allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-	fractalTexture = Texture2D::Create(2048, 2048, VK_FORMAT_R8G8B8A8_SNORM, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-	heavyComputeShader.SetTexture("fractal", fractalTexture, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-	heavyComputeShader.SetBuffer(LWGCBinding::Frame, _uniformPerFrame.buffer, sizeof(LWGC_PerFrame), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-
-	VkImageMemoryBarrier barrier = {};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = fractalTexture->GetImage();
-
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+	asyncComputePool.AllocateFrameCommandBuffers(framesInFlight);
+	asyncComputeLane = GpuProfiler::AddLane("GPU Async Compute", asyncComputeQueue, asyncComputeQueueIndex);
+	renderGraph.SetAsyncComputeQueue(asyncComputeQueueIndex);
 
-	barrier.srcAccessMask = 0;
-	barrier.dstAccessMask = 0;
+	for (size_t i = 0; i < framesInFlight; i++)
+		asyncComputeFences.push_back(Vk::CreateFence(true));
 
-	heavyComputeShader.AddImageBarrier(barrier, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-	// By default the descriptor set is created with stage all flags
-	asyncComputeSet.AddBinding(0, fractalTexture, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+	for (int i = 0; i < 2; i++)
+	{
+		asyncComputeSemaphores[i] = Vk::CreateSemaphore();
+		graphicsSemaphores[i] = Vk::CreateSemaphore();
+		fractalTextures[i] = Texture2D::Create(2048, 2048, VK_FORMAT_R8G8B8A8_SNORM, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		heavyComputeShaders[i].LoadShader("Shaders/Compute/Heavy.hlsl");
+		heavyComputeShaders[i].SetTexture("fractal", fractalTextures[i], VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+		// By default the descriptor set is created with stage all flags
+		asyncComputeSets[i].AddBinding(0, fractalTextures[i], VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+	}
 
 	// Test
 	if (VulkanInstance::IsRayTracingEnabled())
@@ -86,6 +94,40 @@ void	ForwardRenderPipeline::Initialize(SwapChain * swapChain)
 		vkCreateAccelerationStructureNV(device, &info, nullptr, &structure);
 	}
 
+	clusteredLighting.Initialize(framesInFlight);
+	shadowMaps.Initialize(framesInFlight, GetRenderTexturePool());
+	occlusionCulling.Initialize(framesInFlight, GetReadbackManager());
+	GetCameraCulling()->SetOcclusionCulling(&occlusionCulling);
+
+	// The prepass only fetches the positions, from the stream of Mesh::BindPositionBuffers
+	static auto bindingDescription = Mesh::GetPositionBindingDescription();
+	static auto attributeDescriptions = Mesh::GetPositionAttributeDescriptions();
+
+	VkPipelineVertexInputStateCreateInfo	vertexInputState = {};
+	vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputState.vertexBindingDescriptionCount = static_cast< uint32_t >(bindingDescription.size());
+	vertexInputState.vertexAttributeDescriptionCount = static_cast< uint32_t >(attributeDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescription.data();
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// Same culling as the default materials, no depth bias: the shading pass must find the exact same depth
+	VkPipelineRasterizationStateCreateInfo	rasterizationState = {};
+	rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizationState.depthClampEnable = VK_FALSE;
+	rasterizationState.rasterizerDiscardEnable = VK_FALSE;
+	rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizationState.lineWidth = 1.0f;
+	rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizationState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizationState.depthBiasEnable = VK_FALSE;
+
+	depthPrepassMaterial = Material::Create(BuiltinShaders::DepthPrepass, BuiltinShaders::DepthPrepassVertex);
+	depthPrepassMaterial->SetVertexInputState(vertexInputState);
+	depthPrepassMaterial->SetRasterizationState(rasterizationState);
+	depthPrepassMaterial->SetColorBlendState(MaterialState::noColorWriteState);
+	depthPrepassMaterial->SetDepthStencilState(MaterialState::CreateDepthState(true, true, VK_COMPARE_OP_GREATER));
+	depthPrepassMaterial->MarkAsReady();
+
 	// Setup the render passes we uses:
 	SetupRenderPasses();
 }
@@ -100,13 +142,13 @@ void	ForwardRenderPipeline::SetupRenderPasses()
 	forwardPass.Initialize(swapChain);
 
 	forwardPass.AddAttachment(
-		RenderPass::GetDefaultColorAttachment(swapChain->GetImageFormat()),
+		RenderPass::GetDefaultColorAttachment(swapChain->GetImageFormat(), swapChain->GetFinalLayout()),
 		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	);
-	forwardPass.SetDepthAttachment(
-		RenderPass::GetDefaultDepthAttachment(instance->FindDepthFormat()),
-		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-	);
+	// The depth is kept for the pyramids of the occlusion culling
+	VkAttachmentDescription	depthAttachment = RenderPass::GetDefaultDepthAttachment(instance->FindDepthFormat());
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	forwardPass.SetDepthAttachment(depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 
 	VkSubpassDependency dependency = {};
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
@@ -129,37 +171,313 @@ void	ForwardRenderPipeline::SetupRenderPasses()
 
 void	ForwardRenderPipeline::Render(const std::vector< Camera * > & cameras, RenderContext * context)
 {
-	VkCommandBuffer cmd = GetCurrentFrameCommandBuffer();
+	size_t	writeIndex = fractalWriteIndex;
+	size_t	readIndex = 1 - writeIndex;
+
+	renderGraph.Reset();
+
+	RenderGraphResource fractalWrite = renderGraph.ImportTexture(fractalTextures[writeIndex]);
+	RenderGraphResource fractalRead = renderGraph.ImportTexture(fractalTextures[readIndex]);
+
+	auto noisePass = renderGraph.AddPass("Noise Dispatch", RenderGraphPassType::AsyncCompute, [&](VkCommandBuffer cmd)
+	{
+		heavyComputeShaders[writeIndex].BindDescriptorSet(LWGCBinding::Frame, GetFrameDescriptorSet());
+		heavyComputeShaders[writeIndex].Dispatch(cmd, 512, 512, 1);
+	});
+	noisePass->Write(fractalWrite, RenderGraphAccess::StorageWrite);
+	// Sampled by the forward pass of the next frame, it's released to the graphics queue at the end of this one
+	renderGraph.SetNextFrameRead(fractalWrite, RenderGraphPassType::Graphics, RenderGraphAccess::Sampled, VK_IMAGE_LAYOUT_GENERAL);
+
+	// Process the compute shader before everything, the resources of the dispatchers aren't tracked by the graph
+	auto computesPass = renderGraph.AddPass("Computes", RenderGraphPassType::Compute, [&](VkCommandBuffer cmd)
+	{
+		computePass.Begin(cmd, VK_NULL_HANDLE, "All Computes");
+		{
+			computePass.BindDescriptorSet(LWGCBinding::Frame, GetFrameDescriptorSet());
+			RenderPipeline::RecordAllComputeDispatches(computePass, context);
+		}
+		computePass.End();
+	});
+	computesPass->SetSideEffect();
+
+	// The casters of the cascades are culled after the cameras, the pages whose casters didn't change are kept
+	shadowMaps.Update(cameras, context, GetCameraCulling(), currentFrame);
+	RenderGraphResource shadowAtlas = shadowMaps.RecordPasses(renderGraph);
+
+	// The light lists are filled before any camera renders, on the CPU or by a compute pass
+	clusteredLighting.SetShadowLight(shadowMaps.GetShadowLight());
+	clusteredLighting.Update(cameras, context, currentFrame);
+	if (clusteredLighting.GetBinningMode() == LightBinningMode::Compute)
+	{
+		auto lightClustersPass = renderGraph.AddPass("Light Clusters", RenderGraphPassType::Compute, [&](VkCommandBuffer cmd)
+		{
+			clusteredLighting.RecordBinning(cmd);
+		});
+		// The lists are buffers, the graph doesn't track them
+		lightClustersPass->SetSideEffect();
+	}
+
+	// The cameras sharing a target (split screen, minimap) are rendered in a single pass, the ones with several
+	// views in a multiview pass
+	std::vector< std::pair< RenderTarget *, std::vector< Camera * > > >	targetCameras;
+	std::vector< Camera * >												swapChainCameras;
 
+	for (const auto camera : cameras)
 	{
-		auto computeSample = ProfilingSample("Noise Dispatch");
+		RenderTarget *	target = camera->GetTarget();
+
+		if (camera->GetViewCount() != ((target != nullptr) ? target->GetViewCount() : 1))
+			throw std::runtime_error("A camera with " + std::to_string(camera->GetViewCount()) + " views needs a render target with as many views");
 
-		auto asyncCmd = asyncComputePool.BeginSingle();
-		heavyComputeShader.Dispatch(cmd, 512, 512, 1);
-		asyncComputePool.EndSingle(asyncCmd); // fence
+		if (target == nullptr)
+		{
+			swapChainCameras.push_back(camera);
+			continue ;
+		}
+
+		auto group = std::find_if(targetCameras.begin(), targetCameras.end(), [target](const auto & g) { return g.first == target; });
+		if (group == targetCameras.end())
+			targetCameras.push_back({target, {camera}});
+		else
+			group->second.push_back(camera);
 	}
 
-	// Process the compute shader before everything:
-	computePass.Begin(cmd, VK_NULL_HANDLE, "All Computes");
+	// Receives the pyramids of the last frames before the next Cull, and picks the cameras building one now
+	occlusionCulling.Update(swapChainCameras, swapChain);
+	RenderGraphResource sceneDepth = occlusionCulling.ImportDepth(renderGraph, swapChain);
+
+	// The targets render before the forward pass, which can sample their attachments
+	std::unordered_map< Texture *, RenderGraphResource >				targetTextures;
+	std::vector< std::pair< RenderGraphResource, RenderGraphAccess > >	sampledAttachments;
+
+	for (const auto & group : targetCameras)
 	{
-		computePass.BindDescriptorSet(LWGCBinding::Frame, perFrameSet.GetDescriptorSet());
-		RenderPipeline::RecordAllComputeDispatches(computePass, context);
+		RenderTarget *	target = group.first;
+
+		target->Update();
+
+		auto targetPass = renderGraph.AddPass(target->GetName(), RenderGraphPassType::Graphics, [&, target, targetGroup = &group.second](VkCommandBuffer cmd)
+		{
+			RenderPass *	pass = target->GetRenderPass();
+
+			pass->Begin(cmd, target->GetFramebuffer(), target->GetExtent(), target->GetName());
+			{
+				pass->BindDescriptorSet(LWGCBinding::Frame, GetFrameDescriptorSet());
+				pass->BindDescriptorSet("asyncTexture", asyncComputeSets[readIndex]);
+				RenderCameras(*pass, *targetGroup);
+			}
+			pass->End();
+		});
+		targetPass->Read(fractalRead, RenderGraphAccess::Sampled, VK_IMAGE_LAYOUT_GENERAL);
+		targetPass->Read(shadowAtlas, RenderGraphAccess::DepthStencilRead);
+		// Nothing in the graph may read the target, the camera still renders into it
+		targetPass->SetSideEffect();
+
+		auto declareAttachment = [&](Texture * texture, RenderGraphAccess access, RenderGraphAccess sampledAccess)
+		{
+			auto imported = targetTextures.find(texture);
+			if (imported == targetTextures.end())
+				imported = targetTextures.emplace(texture, renderGraph.ImportTexture(texture)).first;
+
+			targetPass->Write(imported->second, access);
+			if (texture->GetUsage() & VK_IMAGE_USAGE_SAMPLED_BIT)
+				sampledAttachments.push_back({imported->second, sampledAccess});
+		};
+
+		for (auto texture : target->GetColorAttachments())
+			declareAttachment(texture, RenderGraphAccess::ColorAttachment, RenderGraphAccess::Sampled);
+		if (target->GetDepthAttachment() != nullptr)
+			declareAttachment(target->GetDepthAttachment(), RenderGraphAccess::DepthStencilAttachment, RenderGraphAccess::DepthStencilRead);
 	}
-	computePass.End();
 
-	forwardPass.Begin(cmd, GetCurrentFrameBuffer(), "All Cameras");
+	auto opaquePass = renderGraph.AddPass("Forward", RenderGraphPassType::Graphics, [&](VkCommandBuffer cmd)
 	{
-		forwardPass.BindDescriptorSet(LWGCBinding::Frame, perFrameSet.GetDescriptorSet());
-		forwardPass.BindDescriptorSet("asyncTexture", asyncComputeSet);
-		for (const auto camera : cameras)
+		forwardPass.Begin(cmd, GetCurrentFrameBuffer(), "All Cameras");
 		{
-			RenderPipelineManager::beginCameraRendering.Invoke(camera);
-			forwardPass.BindDescriptorSet(LWGCBinding::Camera, camera->GetDescriptorSet());
+			forwardPass.BindDescriptorSet(LWGCBinding::Frame, GetFrameDescriptorSet());
+			forwardPass.BindDescriptorSet("asyncTexture", asyncComputeSets[readIndex]);
+			RenderCameras(forwardPass, swapChainCameras);
+		}
+		forwardPass.End();
+	});
+	// asyncComputeSets were written with the general layout of the fractals
+	opaquePass->Read(fractalRead, RenderGraphAccess::Sampled, VK_IMAGE_LAYOUT_GENERAL);
+	opaquePass->Read(shadowAtlas, RenderGraphAccess::DepthStencilRead);
+	// Materials bind the attachments of the targets with the shader read only layouts
+	for (const auto & attachment : sampledAttachments)
+		opaquePass->Read(attachment.first, attachment.second);
+	opaquePass->Write(sceneDepth, RenderGraphAccess::DepthStencilAttachment);
+	// Renders into the swap chain framebuffer, the render pass handles its transitions
+	opaquePass->SetSideEffect();
+
+	occlusionCulling.RecordPasses(renderGraph, sceneDepth);
+
+	renderGraph.Compile(currentFrame);
+
+	if (renderGraph.HasAsyncComputePasses())
+	{
+		VkCommandBuffer	asyncCmd = asyncComputePool.GetFrameCommandBuffer(currentFrame);
 
-			RenderPipeline::RecordAllMeshRenderers(forwardPass, context);
+		// The async command buffer of this slot was submitted a few frames ago
+		vkWaitForFences(device, 1, &asyncComputeFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		asyncComputePool.ResetCommandBuffer(currentFrame);
 
-			RenderPipelineManager::endCameraRendering.Invoke(camera);
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		Vk::CheckResult(vkBeginCommandBuffer(asyncCmd, &beginInfo), "Failed to begin recording of async compute command buffer!");
+		// Samples recorded in asyncCmd go to the async compute lane of the profiler
+		GpuProfiler::BeginCommandBuffer(asyncCmd, asyncComputeLane);
+
+		renderGraph.Execute(GetCurrentFrameCommandBuffer(), asyncCmd);
+
+		Vk::CheckResult(vkEndCommandBuffer(asyncCmd), "Failed to record async compute command buffer!");
+		SubmitAsyncCompute(asyncCmd, asyncComputeSemaphores[writeIndex]);
+	}
+	else
+	{
+		renderGraph.Execute(GetCurrentFrameCommandBuffer());
+
+		// Nothing runs on the async queue, the graphics submit consumes the pending semaphores
+		if (pendingGraphicsSemaphore != VK_NULL_HANDLE)
+			AddFrameWaitSemaphore(pendingGraphicsSemaphore, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		if (pendingAsyncComputeSemaphore != VK_NULL_HANDLE)
+			AddFrameWaitSemaphore(pendingAsyncComputeSemaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		pendingAsyncComputeSemaphore = VK_NULL_HANDLE;
+	}
+
+	AddFrameSignalSemaphore(graphicsSemaphores[writeIndex]);
+	pendingGraphicsSemaphore = graphicsSemaphores[writeIndex];
+	fractalWriteIndex = readIndex;
+}
+
+void	ForwardRenderPipeline::RenderCameras(RenderPass & pass, const std::vector< Camera * > & cameras)
+{
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		Camera *	camera = cameras[i];
+		VkRect2D	rect = camera->GetPixelRect();
+
+		RenderPipelineManager::beginCameraRendering.Invoke(camera);
+		pass.SetViewport(rect);
+		// The pass cleared the whole target, the cameras drawn over the previous ones only clear their depth
+		if (i > 0)
+			pass.ClearDepth(rect);
+		pass.BindDescriptorSet(LWGCBinding::Camera, camera->GetDescriptorSet());
+		pass.BindDescriptorSet(LWGCBinding::Lights, clusteredLighting.GetDescriptorSet(camera));
+		pass.BindDescriptorSet(LWGCBinding::Shadows, shadowMaps.GetDescriptorSet(camera));
+
+		if (depthPrepass)
+		{
+			RecordDepthPrepass(pass, camera);
+			RecordPrepassedMeshRenderers(pass, camera);
 		}
+		else
+			RenderPipeline::RecordVisibleMeshRenderers(pass, camera);
+
+		RenderPipelineManager::endCameraRendering.Invoke(camera);
+	}
+}
+
+// Not cached: the program of a material changes with ReloadShaders and its keywords, and it only compares the
+// paths of the stages
+bool	ForwardRenderPipeline::IsDepthPrepassCompatible(const Material * material) const
+{
+	const auto &	depthState = material->GetDepthStencilState();
+	const auto &	sources = material->GetShaderProgram()->GetShaderSources();
+
+	if (material->IsTransparent() || !depthState.depthTestEnable || !depthState.depthWriteEnable || depthState.depthCompareOp != VK_COMPARE_OP_GREATER)
+		return false;
+
+	// The prepass can't reproduce custom vertex shaders, their depth wouldn't match the shaded one
+	return std::any_of(sources.begin(), sources.end(), [](const ShaderSource * source) { return source->GetPath() == BuiltinShaders::DefaultVertex; });
+}
+
+void	ForwardRenderPipeline::RecordDepthPrepass(RenderPass & pass, Camera * camera)
+{
+	VkCommandBuffer				cmd = pass.GetCommandBuffer();
+	const VisibilityList *		visibility = GetCameraCulling()->GetVisibleRenderers(camera);
+
+	if (visibility == nullptr || visibility->queues.empty())
+		return ;
+
+	pass.BindMaterial(depthPrepassMaterial);
+	depthPrepassMaterial->BindPipeline(cmd, &pass);
+	depthPrepassMaterial->BindProperties(cmd);
+
+	// Only the opaque queue, the transparent renderers don't write their depth
+	for (auto renderer : visibility->queues[0])
+	{
+		if (dynamic_cast< MeshRenderer * >(renderer) == nullptr || !IsDepthPrepassCompatible(renderer->GetMaterial()))
+			continue ;
+
+		pass.BindDescriptorSet(LWGCBinding::Object, renderer->GetDescriptorSet());
+		pass.UpdateDescriptorBindings();
+		renderer->RecordDepthCommands(cmd);
 	}
-	forwardPass.End();
-}
\ No newline at end of file
+}
+
+void	ForwardRenderPipeline::RecordPrepassedMeshRenderers(RenderPass & pass, Camera * camera)
+{
+	const VisibilityList *	visibility = GetCameraCulling()->GetVisibleRenderers(camera);
+
+	if (visibility == nullptr)
+		throw std::runtime_error("The camera was not culled this frame");
+
+	// The renderers drawn by the prepass only shade the fragments that have its depth
+	for (size_t i = 0; i < visibility->queues.size(); i++)
+		for (auto renderer : visibility->queues[i])
+			RecordMeshRenderer(pass, renderer, i == 0 && dynamic_cast< MeshRenderer * >(renderer) != nullptr && IsDepthPrepassCompatible(renderer->GetMaterial()));
+}
+
+ClusteredLighting *	ForwardRenderPipeline::GetClusteredLighting(void) noexcept { return &clusteredLighting; }
+ShadowMaps *		ForwardRenderPipeline::GetShadowMaps(void) noexcept { return &shadowMaps; }
+OcclusionCulling *	ForwardRenderPipeline::GetOcclusionCulling(void) noexcept { return &occlusionCulling; }
+void				ForwardRenderPipeline::SetDepthPrepass(bool enabled) noexcept { depthPrepass = enabled; }
+bool				ForwardRenderPipeline::IsDepthPrepassEnabled(void) const noexcept { return depthPrepass; }
+
+// The async work is submitted before the graphics commands of the frame are, so it runs alongside them.
+// Each binary semaphore signaled by a queue is waited exactly once by the other: at the stages the graph
+// reported when the results are used, at the top of the pipe otherwise (it then only orders the submits)
+void	ForwardRenderPipeline::SubmitAsyncCompute(VkCommandBuffer asyncCmd, VkSemaphore signalSemaphore)
+{
+	VkSubmitInfo			submitInfo = {};
+	VkPipelineStageFlags	graphicsWaitStages = renderGraph.GetPreviousGraphicsWaitStages();
+
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+	if (pendingGraphicsSemaphore != VK_NULL_HANDLE)
+	{
+		if (graphicsWaitStages == 0)
+			graphicsWaitStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &pendingGraphicsSemaphore;
+		submitInfo.pWaitDstStageMask = &graphicsWaitStages;
+	}
+
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &asyncCmd;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &signalSemaphore;
+
+	Vk::CheckResult(vkResetFences(device, 1, &asyncComputeFences[currentFrame]), "Reset fence failed");
+	Vk::CheckResult(vkQueueSubmit(asyncComputeQueue, 1, &submitInfo, asyncComputeFences[currentFrame]), "Failed to submit async compute queue");
+	pendingGraphicsSemaphore = VK_NULL_HANDLE;
+
+	// Results of the last frame, the transfers to the graphics queue were released at its end
+	if (pendingAsyncComputeSemaphore != VK_NULL_HANDLE)
+	{
+		VkPipelineStageFlags stages = renderGraph.GetPreviousAsyncComputeWaitStages();
+		AddFrameWaitSemaphore(pendingAsyncComputeSemaphore, (stages == 0) ? static_cast< VkPipelineStageFlags >(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT) : stages);
+	}
+
+	// The graphics work of this frame only waits if it uses the results right away, otherwise the wait
+	// moves to the next frame and the two queues overlap
+	if (renderGraph.GetAsyncComputeWaitStages() != 0)
+	{
+		AddFrameWaitSemaphore(signalSemaphore, renderGraph.GetAsyncComputeWaitStages());
+		pendingAsyncComputeSemaphore = VK_NULL_HANDLE;
+	}
+	else
+		pendingAsyncComputeSemaphore = signalSemaphore;
+}
@@ -2,10 +2,15 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_map>
 
 #include "RenderPipeline.hpp"
 #include "Core/Shaders/ComputeShader.hpp"
 #include "Core/Vulkan/DescriptorSet.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
+#include "Core/Rendering/ClusteredLighting.hpp"
+#include "Core/Rendering/ShadowMaps.hpp"
+#include "Core/Rendering/OcclusionCulling.hpp"
 
 namespace LWGC
 {
@@ -18,15 +23,40 @@ namespace LWGC
 			VkQueue				asyncComputeQueue;
 			uint32_t			asyncComputeQueueIndex;
 
-			CommandBufferPool	asyncComputePool;
-			VkCommandBuffer		asyncCommandBuffer;
+			CommandBufferPool	asyncComputePool;	// One command buffer per frame in flight
+			GpuProfilerLane		asyncComputeLane;
+			std::vector< VkFence >		asyncComputeFences;		// Per frame in flight
+			// Alternate with the fractals: a semaphore is waited by the next frame at the latest, before it's
+			// signaled again, even with a single frame in flight
+			VkSemaphore			asyncComputeSemaphores[2];	// Signaled by the async submit of the frame
+			VkSemaphore			graphicsSemaphores[2];		// Signaled by the graphics submit of the frame
+			// Semaphores signaled by the last submit of each queue that nothing waited on yet
+			VkSemaphore			pendingAsyncComputeSemaphore = VK_NULL_HANDLE;
+			VkSemaphore			pendingGraphicsSemaphore = VK_NULL_HANDLE;
 
-			ComputeShader		heavyComputeShader;
-			VkFence				heavyComputeFence;
+			// The async compute of a frame writes one fractal while the graphics samples the other one,
+			// written the frame before, so the two queues never wait on each other within a frame
+			ComputeShader		heavyComputeShaders[2];
+			Texture2D *			fractalTextures[2];
+			DescriptorSet		asyncComputeSets[2];
+			size_t				fractalWriteIndex = 0;
 
-			DescriptorSet		asyncComputeSet;
+			ClusteredLighting	clusteredLighting;
+			ShadowMaps			shadowMaps;
+			OcclusionCulling	occlusionCulling;
+
+			// Depth only draw of the opaque renderers before they are shaded, both compute the position with the same
+			// precise operations and the shading pass tests the depth with GREATER_OR_EQUAL without writing it
+			Material *			depthPrepassMaterial = nullptr;
+			bool				depthPrepass = false;
 
 			void	SetupRenderPasses(void);
+			void	SubmitAsyncCompute(VkCommandBuffer asyncCmd, VkSemaphore signalSemaphore);
+			// The cameras share the pass, each one draws its visible renderers in its viewport
+			void	RenderCameras(RenderPass & pass, const std::vector< Camera * > & cameras);
+			void	RecordDepthPrepass(RenderPass & pass, Camera * camera);
+			void	RecordPrepassedMeshRenderers(RenderPass & pass, Camera * camera);
+			bool	IsDepthPrepassCompatible(const Material * material) const;
 
 		protected:
 			void	Render(const std::vector< Camera * > & cameras, RenderContext * context) override;
@@ -34,6 +64,17 @@ namespace LWGC
 
 		public:
 			ForwardRenderPipeline(void) = default;
-			virtual ~ForwardRenderPipeline(void) = default;
+			virtual ~ForwardRenderPipeline(void);
+
+			// Lights of the Lit shaders, binned in clusters for each camera
+			ClusteredLighting *	GetClusteredLighting(void) noexcept;
+			// Cascaded shadows of the brightest directional light
+			ShadowMaps *		GetShadowMaps(void) noexcept;
+			// Hierarchical depth of the swap chain cameras, hides the renderers behind the depth of the last frames
+			OcclusionCulling *	GetOcclusionCulling(void) noexcept;
+
+			// The opaque renderers with the default vertex shader write their depth before any is shaded
+			void				SetDepthPrepass(bool enabled) noexcept;
+			bool				IsDepthPrepassEnabled(void) const noexcept;
 	};
 }
@@ -0,0 +1,53 @@
+#include "FramePacer.hpp"
+
+#include <thread>
+
+using namespace LWGC;
+
+const std::chrono::microseconds	FramePacer::SpinDuration(2000);
+
+FramePacer::FramePacer(void) : _framePeriod(Clock::duration::zero()), _nextFrame(Clock::now())
+{
+}
+
+void		FramePacer::SetFrameRateLimit(double framesPerSecond) noexcept
+{
+	if (framesPerSecond <= 0.0)
+		_framePeriod = Clock::duration::zero();
+	else
+		_framePeriod = std::chrono::duration_cast< Clock::duration >(std::chrono::duration< double >(1.0 / framesPerSecond));
+	_nextFrame = Clock::now();
+}
+
+double		FramePacer::GetFrameRateLimit(void) const noexcept
+{
+	if (_framePeriod == Clock::duration::zero())
+		return 0.0;
+	return 1.0 / std::chrono::duration< double >(_framePeriod).count();
+}
+
+void		FramePacer::Wait(void) noexcept
+{
+	if (_framePeriod == Clock::duration::zero())
+		return ;
+
+	auto now = Clock::now();
+
+	if (_nextFrame - now > SpinDuration)
+		std::this_thread::sleep_for(_nextFrame - now - SpinDuration);
+
+	while (Clock::now() < _nextFrame)
+		std::this_thread::yield();
+
+	// A late frame doesn't make the next ones shorter to catch up, the pace restarts from now
+	now = Clock::now();
+	_nextFrame += _framePeriod;
+	if (_nextFrame < now)
+		_nextFrame = now + _framePeriod;
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, FramePacer const & r)
+{
+	o << "FramePacer: " << r.GetFrameRateLimit() << " fps limit" << std::endl;
+	return (o);
+}
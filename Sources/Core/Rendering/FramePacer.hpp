@@ -0,0 +1,44 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <chrono>
+
+namespace LWGC
+{
+	enum class	LatencyMode
+	{
+		MaxThroughput,	// The CPU runs ahead of the GPU by all the frames in flight, mailbox present when available
+		LowLatency,		// The input is read once the GPU finished the last frame, immediate present when available
+	};
+
+	// CPU side frame rate limiter. It sleeps until shortly before the start of the next frame and spins for the
+	// rest, the sleep of the OS is too coarse to hit the deadline by itself.
+	class		FramePacer
+	{
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			Clock::duration		_framePeriod;
+			Clock::time_point	_nextFrame;
+
+		public:
+			// Time left to the spin loop, the sleep of most schedulers overshoots by less than that
+			static const std::chrono::microseconds	SpinDuration;
+
+			FramePacer(void);
+			FramePacer(const FramePacer &) = delete;
+			virtual ~FramePacer(void) = default;
+
+			FramePacer &	operator=(FramePacer const & src) = delete;
+
+			// 0 disables the limiter
+			void	SetFrameRateLimit(double framesPerSecond) noexcept;
+			double	GetFrameRateLimit(void) const noexcept;
+
+			// Blocks until the next frame can start
+			void	Wait(void) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, FramePacer const & r);
+}
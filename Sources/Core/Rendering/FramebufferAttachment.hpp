@@ -1,3 +1,5 @@
+#pragma once
+
 namespace LWGC
 {
 	enum class FramebufferAttachment
@@ -0,0 +1,122 @@
+#include "HeadlessOutput.hpp"
+
+#include <cstdio>
+
+using namespace LWGC;
+
+HeadlessOutput::HeadlessOutput(void) : _readbacks(nullptr), _framesInFlight(0), _width(0), _height(0), _format(VK_FORMAT_UNDEFINED), _frameCount(0)
+{
+}
+
+HeadlessOutput::~HeadlessOutput(void)
+{
+	Release();
+}
+
+static bool		IsWritableFormat(VkFormat format) noexcept
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void			HeadlessOutput::Initialize(ReadbackManager * readbacks, size_t framesInFlight, uint32_t width, uint32_t height, VkFormat format)
+{
+	if (!_outputDirectory.empty() && !IsWritableFormat(format))
+		throw std::runtime_error("Headless frames can only be written to the disk from 8 bit RGBA or BGRA images");
+
+	_readbacks = readbacks;
+	_framesInFlight = framesInFlight;
+	_width = width;
+	_height = height;
+	_format = format;
+}
+
+void			HeadlessOutput::Release(void) noexcept
+{
+	// The readbacks still resolve the copies in flight, their files are written
+	_pending.clear();
+	_readbacks = nullptr;
+}
+
+bool			HeadlessOutput::IsInitialized(void) const noexcept { return _readbacks != nullptr; }
+
+void			HeadlessOutput::RecordCopy(VkCommandBuffer cmd, VkImage image)
+{
+	ReadbackImageRequest	request;
+	char					fileName[32];
+
+	// The render pass leaves the image in the transfer source layout
+	request.image = image;
+	request.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	request.format = _format;
+	request.width = _width;
+	request.height = _height;
+
+	if (!_outputDirectory.empty())
+	{
+		snprintf(fileName, sizeof(fileName), "frame_%06llu.png", static_cast< unsigned long long >(_frameCount));
+		request.encoding = ReadbackEncoding::PNG;
+		request.path = _outputDirectory + "/" + fileName;
+	}
+
+	_pending.push_back({_frameCount++, _readbacks->ReadImage(cmd, request)});
+}
+
+void			HeadlessOutput::Collect(void)
+{
+	// Past the frames in flight, the readbacks are on the worker: too many of them waits for the disk
+	while (_pending.size() > _framesInFlight + MaxPendingWrites)
+		Deliver(_pending.front());
+
+	// The worker resolves the readbacks in order, the first one not ready stops the delivery
+	while (!_pending.empty() && _pending.front().result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		Deliver(_pending.front());
+}
+
+void			HeadlessOutput::Flush(void)
+{
+	if (_readbacks == nullptr)
+		return ;
+
+	_readbacks->Flush();
+
+	while (!_pending.empty())
+		Deliver(_pending.front());
+}
+
+void			HeadlessOutput::Deliver(PendingFrame & pending)
+{
+	ReadbackResult	result;
+	uint64_t		index = pending.index;
+
+	try {
+		result = pending.result.get();
+	} catch (const std::exception & e) {
+		std::cout << "Headless frame " << index << " readback failed: " << e.what() << std::endl;
+		_pending.pop_front();
+		return ;
+	}
+	_pending.pop_front();
+
+	if (_callback)
+		_callback(HeadlessFrame{index, result.width, result.height, result.format, result.data.data()});
+}
+
+void			HeadlessOutput::SetCallback(const HeadlessFrameCallback & callback) noexcept { _callback = callback; }
+void			HeadlessOutput::SetOutputDirectory(const std::string & directory) noexcept { _outputDirectory = directory; }
+const std::string &	HeadlessOutput::GetOutputDirectory(void) const noexcept { return _outputDirectory; }
+uint64_t		HeadlessOutput::GetFrameCount(void) const noexcept { return _frameCount; }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, HeadlessOutput const & r)
+{
+	o << "HeadlessOutput of " << r.GetFrameCount() << " frames" << std::endl;
+	return (o);
+}
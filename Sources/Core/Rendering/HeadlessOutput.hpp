@@ -0,0 +1,87 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <future>
+#include <functional>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Vulkan/ReadbackManager.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Pixels of a frame rendered without a window, the rows are tightly packed
+	struct	HeadlessFrame
+	{
+		uint64_t		index;		// Number of the frame since the output was initialized
+		uint32_t		width;
+		uint32_t		height;
+		VkFormat		format;
+		const uint8_t *	pixels;		// Only valid during the callback
+	};
+
+	using HeadlessFrameCallback = std::function< void(const HeadlessFrame & frame) >;
+
+	// Reads back the offscreen images of a headless swap chain through the ReadbackManager of the pipeline.
+	// The copy of the image is recorded at the end of the frame and the pixels are delivered once the
+	// readback resolves, after the wait on the fence of its frame slot, so nothing blocks on the GPU.
+	// The frames go to the callback and/or are encoded as PNG files in the output directory by the
+	// worker thread of the readbacks.
+	class		HeadlessOutput
+	{
+		private:
+			struct	PendingFrame
+			{
+				uint64_t						index;
+				std::future< ReadbackResult >	result;
+			};
+
+			ReadbackManager *				_readbacks;
+			size_t							_framesInFlight;
+			uint32_t						_width;
+			uint32_t						_height;
+			VkFormat						_format;
+			std::deque< PendingFrame >		_pending;	// In submission order
+			uint64_t						_frameCount;
+			HeadlessFrameCallback			_callback;
+			std::string						_outputDirectory;
+
+			void		Deliver(PendingFrame & pending);
+
+		public:
+			// Frames waiting to be encoded and written before the render thread waits for the disk
+			static const size_t		MaxPendingWrites = 8;
+
+			HeadlessOutput(void);
+			HeadlessOutput(const HeadlessOutput &) = delete;
+			virtual ~HeadlessOutput(void);
+
+			HeadlessOutput &	operator=(HeadlessOutput const & src) = delete;
+
+			// Only 8 bit RGBA and BGRA images can be written to the disk
+			void		Initialize(ReadbackManager * readbacks, size_t framesInFlight, uint32_t width, uint32_t height, VkFormat format);
+			// The frames that weren't delivered yet are dropped
+			void		Release(void) noexcept;
+			bool		IsInitialized(void) const noexcept;
+
+			void		SetCallback(const HeadlessFrameCallback & callback) noexcept;
+			// Frames are written as <directory>/frame_<index>.png, an empty directory disables the writes
+			void		SetOutputDirectory(const std::string & directory) noexcept;
+			const std::string &	GetOutputDirectory(void) const noexcept;
+
+			// Copies the image at the end of the frame, it must be in the transfer source layout
+			void		RecordCopy(VkCommandBuffer cmd, VkImage image);
+			// Delivers the frames whose readback resolved, call it after ReadbackManager::BeginFrame
+			void		Collect(void);
+			// Waits for the device and delivers all the frames in flight, with their writes to the disk
+			void		Flush(void);
+
+			uint64_t	GetFrameCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, HeadlessOutput const & r);
+}
@@ -0,0 +1,184 @@
+#include "LightClusterBinning.hpp"
+
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace LWGC;
+
+LightClusterBinning::LightClusterBinning(void) : _grid{}, _sliceScale(0), _droppedLightCount(0)
+{
+	_clusters.assign(ClusterCount, {0, 0});
+}
+
+// NDC range of the view space interval [lo, hi] for the depths in [zNear, zFar], scaled by the projection
+static inline void	ProjectRange(float lo, float hi, float zNear, float zFar, float scale, float & ndcMin, float & ndcMax) noexcept
+{
+	// The extremes are on the closest depth when the bound is on its side of the axis, on the farthest otherwise
+	float a = lo / ((lo >= 0.0f) ? zFar : zNear) * scale;
+	float b = hi / ((hi >= 0.0f) ? zNear : zFar) * scale;
+
+	// The y scale is negative, the range is flipped
+	ndcMin = std::min(a, b);
+	ndcMax = std::max(a, b);
+}
+
+static inline int32_t	NDCToTile(float ndc, uint32_t tileCount) noexcept
+{
+	float t = (std::clamp(ndc, -1.0f, 1.0f) * 0.5f + 0.5f) * static_cast< float >(tileCount);
+
+	return std::min(static_cast< int32_t >(t), static_cast< int32_t >(tileCount) - 1);
+}
+
+// Written without early outs so the compiler can vectorize the loop
+void			LightClusterBinning::ComputeBounds(const std::vector< glm::vec4 > & lights, size_t first, size_t last) noexcept
+{
+	const float	nearPlane = _grid.nearPlane;
+	const float	sliceScale = _sliceScale;
+	const float	scaleX = _grid.projectionScale.x;
+	const float	scaleY = _grid.projectionScale.y;
+
+	for (size_t i = first; i < last; i++)
+	{
+		const glm::vec4 & light = lights[i];
+		float	zNear = std::max(light.z - light.w, nearPlane);
+		float	zFar = std::max(light.z + light.w, nearPlane);
+		float	minX, maxX, minY, maxY;
+
+		ProjectRange(light.x - light.w, light.x + light.w, zNear, zFar, scaleX, minX, maxX);
+		ProjectRange(light.y - light.w, light.y + light.w, zNear, zFar, scaleY, minY, maxY);
+
+		bool	visible = light.z + light.w > nearPlane && maxX >= -1.0f && minX <= 1.0f && maxY >= -1.0f && minY <= 1.0f;
+		float	sliceNear = std::log(zNear / nearPlane) * sliceScale;
+		float	sliceFar = std::log(zFar / nearPlane) * sliceScale;
+
+		_minX[i] = NDCToTile(minX, TilesX);
+		_maxX[i] = NDCToTile(maxX, TilesX);
+		_minY[i] = NDCToTile(minY, TilesY);
+		_maxY[i] = NDCToTile(maxY, TilesY);
+		_minZ[i] = visible ? std::min(static_cast< int32_t >(std::max(sliceNear, 0.0f)), static_cast< int32_t >(Slices) - 1) : 1;
+		_maxZ[i] = visible ? std::min(static_cast< int32_t >(std::max(sliceFar, 0.0f)), static_cast< int32_t >(Slices) - 1) : 0;
+	}
+}
+
+void			LightClusterBinning::CountSlice(uint32_t slice, size_t lightCount) noexcept
+{
+	const int32_t	z = static_cast< int32_t >(slice);
+
+	for (uint32_t i = GetClusterIndex(0, 0, slice); i < GetClusterIndex(0, 0, slice + 1); i++)
+		_clusters[i].count = 0;
+
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		if (z < _minZ[i] || z > _maxZ[i])
+			continue ;
+
+		for (int32_t y = _minY[i]; y <= _maxY[i]; y++)
+			for (int32_t x = _minX[i]; x <= _maxX[i]; x++)
+				_clusters[GetClusterIndex(x, y, slice)].count++;
+	}
+}
+
+void			LightClusterBinning::FillSlice(uint32_t slice, size_t lightCount, uint32_t baseIndex) noexcept
+{
+	const int32_t	z = static_cast< int32_t >(slice);
+	uint32_t		cursors[TilesX * TilesY] = {};
+
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		if (z < _minZ[i] || z > _maxZ[i])
+			continue ;
+
+		for (int32_t y = _minY[i]; y <= _maxY[i]; y++)
+		{
+			for (int32_t x = _minX[i]; x <= _maxX[i]; x++)
+			{
+				const LightCluster &	cluster = _clusters[GetClusterIndex(x, y, slice)];
+				uint32_t &				cursor = cursors[y * TilesX + x];
+
+				if (cursor < cluster.count)
+					_lightIndices[cluster.offset + cursor++] = baseIndex + static_cast< uint32_t >(i);
+			}
+		}
+	}
+}
+
+void			LightClusterBinning::Bin(const LightClusterGrid & grid, const std::vector< glm::vec4 > & lights, uint32_t baseIndex, ThreadPool * workers)
+{
+	LWGC_PROFILE_SCOPE("Light Binning");
+
+	size_t	lightCount = lights.size();
+	size_t	batchCount = (lightCount + LightsPerBatch - 1) / LightsPerBatch;
+
+	if (grid.nearPlane <= 0.0f || grid.farPlane <= grid.nearPlane)
+		throw std::runtime_error("The light cluster grid needs 0 < near plane < far plane");
+
+	_grid = grid;
+	_sliceScale = GetSliceScale(grid);
+
+	for (auto bounds : {&_minX, &_maxX, &_minY, &_maxY, &_minZ, &_maxZ})
+		bounds->resize(lightCount);
+
+	auto run = [workers](size_t count, const std::function< void(size_t) > & job)
+	{
+		if (workers != nullptr && count > 1)
+			workers->ParallelFor(count, job);
+		else
+		{
+			for (size_t i = 0; i < count; i++)
+				job(i);
+		}
+	};
+
+	run(batchCount, [&](size_t batch)
+	{
+		ComputeBounds(lights, batch * LightsPerBatch, std::min((batch + 1) * LightsPerBatch, lightCount));
+	});
+
+	// Each slice only writes its own clusters
+	run(Slices, [&](size_t slice) { CountSlice(static_cast< uint32_t >(slice), lightCount); });
+
+	uint32_t	offset = 0;
+
+	_droppedLightCount = 0;
+	for (auto & cluster : _clusters)
+	{
+		if (cluster.count > MaxLightsPerCluster)
+		{
+			_droppedLightCount += cluster.count - MaxLightsPerCluster;
+			cluster.count = MaxLightsPerCluster;
+		}
+		cluster.offset = offset;
+		offset += cluster.count;
+	}
+	_lightIndices.resize(offset);
+
+	run(Slices, [&](size_t slice) { FillSlice(static_cast< uint32_t >(slice), lightCount, baseIndex); });
+}
+
+const std::vector< LightCluster > &	LightClusterBinning::GetClusters(void) const noexcept { return _clusters; }
+const std::vector< uint32_t > &		LightClusterBinning::GetLightIndices(void) const noexcept { return _lightIndices; }
+size_t		LightClusterBinning::GetDroppedLightCount(void) const noexcept { return _droppedLightCount; }
+
+uint32_t	LightClusterBinning::GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) noexcept
+{
+	return (z * TilesY + y) * TilesX + x;
+}
+
+float		LightClusterBinning::GetSliceScale(const LightClusterGrid & grid) noexcept
+{
+	return static_cast< float >(Slices) / std::log(grid.farPlane / grid.nearPlane);
+}
+
+float		LightClusterBinning::GetSliceDepth(const LightClusterGrid & grid, uint32_t slice) noexcept
+{
+	return grid.nearPlane * std::pow(grid.farPlane / grid.nearPlane, static_cast< float >(slice) / static_cast< float >(Slices));
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, LightClusterBinning const & r)
+{
+	o << "LightClusterBinning: " << r.GetLightIndices().size() << " light indices, " << r.GetDroppedLightCount() << " dropped" << std::endl;
+	return (o);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	// Froxel grid of a camera: the screen is split in tiles and the depth in slices growing exponentially
+	// from the near plane, the last slice extends to the infinite
+	struct	LightClusterGrid
+	{
+		float		nearPlane;
+		float		farPlane;			// Depth of the beginning of the last slice
+		glm::vec2	projectionScale;	// projection[0][0] and projection[1][1], from view space x / z and y / z to NDC
+	};
+
+	// Range of the light list of a cluster in the light indices, matches the uint2 read by the shaders
+	struct	LightCluster
+	{
+		uint32_t	offset;
+		uint32_t	count;
+	};
+
+	// Assigns the point and spot lights to the clusters they touch. The lights are bounded by their view space
+	// box, projected on the tiles and the slices it covers: it's conservative, the shaders still test the
+	// range. The bounds are computed by batches of lights, then the slices count their lights, reserve their
+	// part of the index list and fill it, each on a worker thread. The lists are sorted by light index so the
+	// result doesn't depend on the scheduling. Doesn't use the GPU, the result can be checked on the CPU.
+	class		LightClusterBinning
+	{
+		private:
+			LightClusterGrid				_grid;
+			float							_sliceScale;	// Slices / log(far / near)
+			// Covered tiles and slices per light, inclusive. A light out of the grid has minZ > maxZ
+			std::vector< int32_t >			_minX;
+			std::vector< int32_t >			_maxX;
+			std::vector< int32_t >			_minY;
+			std::vector< int32_t >			_maxY;
+			std::vector< int32_t >			_minZ;
+			std::vector< int32_t >			_maxZ;
+			std::vector< LightCluster >		_clusters;
+			std::vector< uint32_t >			_lightIndices;
+			size_t							_droppedLightCount;
+
+			void		ComputeBounds(const std::vector< glm::vec4 > & lights, size_t first, size_t last) noexcept;
+			void		CountSlice(uint32_t slice, size_t lightCount) noexcept;
+			void		FillSlice(uint32_t slice, size_t lightCount, uint32_t baseIndex) noexcept;
+
+		public:
+			static const uint32_t	TilesX = 16;
+			static const uint32_t	TilesY = 9;
+			static const uint32_t	Slices = 24;
+			static const uint32_t	ClusterCount = TilesX * TilesY * Slices;
+			// The lights after it are dropped, the GPU path has the same limit
+			static const uint32_t	MaxLightsPerCluster = 128;
+			static const size_t		LightsPerBatch = 1024;
+
+			LightClusterBinning(void);
+			LightClusterBinning(const LightClusterBinning &) = delete;
+			virtual ~LightClusterBinning(void) = default;
+
+			LightClusterBinning &	operator=(LightClusterBinning const & src) = delete;
+
+			// lights are view space spheres (xyz position, w range). The indices in the lists are the ones of
+			// the lights plus baseIndex. Without workers it runs on the calling thread
+			void		Bin(const LightClusterGrid & grid, const std::vector< glm::vec4 > & lights, uint32_t baseIndex = 0, ThreadPool * workers = nullptr);
+
+			// Per cluster, indexed by GetClusterIndex
+			const std::vector< LightCluster > &	GetClusters(void) const noexcept;
+			const std::vector< uint32_t > &		GetLightIndices(void) const noexcept;
+			// Lights over MaxLightsPerCluster in the clusters of the last binning
+			size_t		GetDroppedLightCount(void) const noexcept;
+
+			static uint32_t	GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) noexcept;
+			static float	GetSliceScale(const LightClusterGrid & grid) noexcept;
+			// Depth at which a slice begins
+			static float	GetSliceDepth(const LightClusterGrid & grid, uint32_t slice) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, LightClusterBinning const & r);
+}
@@ -0,0 +1,340 @@
+#include "OcclusionCulling.hpp"
+
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace LWGC;
+
+OcclusionCulling::OcclusionCulling(void) : _device(VK_NULL_HANDLE), _frameCount(0), _frame(0), _readbacks(nullptr), _enabled(true),
+	_maxCameraMotion(1.0f), _depthImage(VK_NULL_HANDLE), _depthLayout(VK_IMAGE_LAYOUT_UNDEFINED), _depthFormat(VK_FORMAT_UNDEFINED)
+{
+}
+
+OcclusionCulling::~OcclusionCulling(void)
+{
+	Release();
+}
+
+void			OcclusionCulling::Initialize(size_t frameCount, ReadbackManager * readbacks)
+{
+	_device = VulkanInstance::Get()->GetDevice();
+	_frameCount = frameCount;
+	_readbacks = readbacks;
+}
+
+void			OcclusionCulling::Release(void) noexcept
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	for (auto & camera : _cameras)
+		if (camera.second.resources != nullptr)
+			DestroyResources(*camera.second.resources);
+	for (auto & resources : _retiredResources)
+		DestroyResources(*resources);
+
+	_cameras.clear();
+	_frameCameras.clear();
+	_retiredResources.clear();
+	_device = VK_NULL_HANDLE;
+}
+
+std::unique_ptr< OcclusionCulling::PyramidResources >	OcclusionCulling::CreateResources(uint32_t width, uint32_t height)
+{
+	auto	resources = std::make_unique< PyramidResources >();
+
+	resources->width = width;
+	resources->height = height;
+	resources->levels = DepthPyramid::GetLevels(width, height);
+	resources->releaseFrame = 0;
+
+	// The first level read back is the largest one under ReadbackResolution, never the copy of the depth
+	resources->readbackLevel = 1;
+	while (resources->readbackLevel + 1 < resources->levels.size()
+		&& std::max(resources->levels[resources->readbackLevel].width, resources->levels[resources->readbackLevel].height) > ReadbackResolution)
+		resources->readbackLevel++;
+
+	Vk::CreateBuffer(
+		sizeof(float) * DepthPyramid::GetDepthCount(width, height),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		resources->buffer,
+		resources->memory
+	);
+
+	resources->downsample = std::make_unique< ComputeShader >("Shaders/Compute/DepthPyramid.hlsl");
+	resources->downsample->SetBuffer("pyramid", resources->buffer, sizeof(float) * DepthPyramid::GetDepthCount(width, height), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	// Each level reads the previous one
+	VkMemoryBarrier	barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	resources->downsample->AddMemoryBarrier(barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+	return resources;
+}
+
+void			OcclusionCulling::DestroyResources(PyramidResources & resources) noexcept
+{
+	vkDestroyBuffer(_device, resources.buffer, nullptr);
+	vkFreeMemory(_device, resources.memory, nullptr);
+}
+
+// The frames in flight can still use the buffer
+void			OcclusionCulling::RetireResources(std::unique_ptr< PyramidResources > resources)
+{
+	if (resources == nullptr)
+		return ;
+
+	resources->releaseFrame = _frame + _frameCount;
+	_retiredResources.push_back(std::move(resources));
+}
+
+void			OcclusionCulling::ReceiveReadbacks(CameraOcclusion & occlusion)
+{
+	// The readbacks come back in order, only the last one that is ready is kept
+	while (!occlusion.readbacks.empty() && occlusion.readbacks.front().result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		PendingReadback	readback = std::move(occlusion.readbacks.front());
+
+		occlusion.readbacks.pop_front();
+
+		try {
+			ReadbackResult			result = readback.result.get();
+			std::vector< float >	depths(result.data.size() / sizeof(float));
+
+			std::memcpy(depths.data(), result.data.data(), depths.size() * sizeof(float));
+			occlusion.pyramid.Initialize(readback.viewProjection, readback.cameraPosition, readback.width, readback.height, readback.firstLevel, std::move(depths));
+			occlusion.hasPyramid = true;
+		} catch (const std::exception & e) {
+			std::cerr << "Depth pyramid readback failed: " << e.what() << std::endl;
+		}
+	}
+}
+
+void			OcclusionCulling::Update(const std::vector< Camera * > & cameras, SwapChain * swapChain)
+{
+	LWGC_PROFILE_SCOPE("Occlusion Culling");
+
+	VkExtent2D	extent = swapChain->GetExtent();
+
+	_frame++;
+	_frameCameras.clear();
+
+	auto retired = std::remove_if(_retiredResources.begin(), _retiredResources.end(), [this](const auto & resources)
+	{
+		if (resources->releaseFrame > _frame)
+			return false;
+		DestroyResources(*resources);
+		return true;
+	});
+	_retiredResources.erase(retired, _retiredResources.end());
+
+	for (auto & camera : _cameras)
+		camera.second.used = false;
+
+	for (size_t i = 0; _enabled && i < cameras.size(); i++)
+	{
+		Camera *	camera = cameras[i];
+		VkRect2D	rect = camera->GetPixelRect();
+
+		if (camera->GetTarget() != nullptr || camera->GetViewCount() != 1)
+			continue ;
+
+		// The cameras drawn after this one would be in its depth
+		bool	covered = false;
+		for (size_t j = i + 1; j < cameras.size() && !covered; j++)
+		{
+			VkRect2D	other = cameras[j]->GetPixelRect();
+
+			covered = cameras[j]->GetTarget() == nullptr
+				&& other.offset.x < rect.offset.x + static_cast< int32_t >(rect.extent.width) && rect.offset.x < other.offset.x + static_cast< int32_t >(other.extent.width)
+				&& other.offset.y < rect.offset.y + static_cast< int32_t >(rect.extent.height) && rect.offset.y < other.offset.y + static_cast< int32_t >(other.extent.height);
+		}
+
+		int32_t	maxX = std::min(rect.offset.x + static_cast< int32_t >(rect.extent.width), static_cast< int32_t >(extent.width));
+		int32_t	maxY = std::min(rect.offset.y + static_cast< int32_t >(rect.extent.height), static_cast< int32_t >(extent.height));
+
+		rect.offset.x = std::max(rect.offset.x, 0);
+		rect.offset.y = std::max(rect.offset.y, 0);
+		if (covered || maxX - rect.offset.x < 2 || maxY - rect.offset.y < 2)
+			continue ;
+		rect.extent = {static_cast< uint32_t >(maxX - rect.offset.x), static_cast< uint32_t >(maxY - rect.offset.y)};
+
+		CameraOcclusion &	occlusion = _cameras[camera];
+
+		ReceiveReadbacks(occlusion);
+
+		if (occlusion.resources == nullptr || occlusion.resources->width != rect.extent.width || occlusion.resources->height != rect.extent.height)
+		{
+			RetireResources(std::move(occlusion.resources));
+			occlusion.resources = CreateResources(rect.extent.width, rect.extent.height);
+		}
+
+		occlusion.used = true;
+		occlusion.rect = rect;
+		occlusion.viewProjection = camera->GetViewProjectionMatrix(0);
+		occlusion.cameraPosition = glm::vec3(glm::inverse(camera->GetViewMatrix())[3]);
+		_frameCameras.push_back(&occlusion);
+	}
+
+	for (auto camera = _cameras.begin(); camera != _cameras.end(); )
+	{
+		if (camera->second.used)
+		{
+			++camera;
+			continue ;
+		}
+
+		RetireResources(std::move(camera->second.resources));
+		camera = _cameras.erase(camera);
+	}
+}
+
+RenderGraphResource	OcclusionCulling::ImportDepth(RenderGraph & renderGraph, SwapChain * swapChain)
+{
+	VkExtent2D	extent = swapChain->GetExtent();
+
+	// A new depth image after the swap chain was recreated
+	if (swapChain->GetDepthImage() != _depthImage)
+	{
+		_depthImage = swapChain->GetDepthImage();
+		_depthLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	}
+	_depthFormat = swapChain->GetDepthFormat();
+
+	return renderGraph.ImportImage("Scene Depth", _depthImage, swapChain->GetDepthImageView(), _depthFormat, extent.width, extent.height, _depthLayout);
+}
+
+void			OcclusionCulling::RecordPasses(RenderGraph & renderGraph, RenderGraphResource depth)
+{
+	// The graph doesn't keep the layout of the images it doesn't own, the forward pass leaves it as an attachment
+	if (_frameCameras.empty())
+	{
+		_depthLayout = RenderGraph::GetAccessLayout(RenderGraphAccess::DepthStencilAttachment);
+		return ;
+	}
+
+	auto pyramidPass = renderGraph.AddPass("Depth Pyramid", RenderGraphPassType::Compute, [this](VkCommandBuffer cmd)
+	{
+		RecordPyramids(cmd);
+	});
+	pyramidPass->Read(depth, RenderGraphAccess::TransferSource);
+	// The pyramids are buffers read back by the CPU
+	pyramidPass->SetSideEffect();
+
+	_depthLayout = RenderGraph::GetAccessLayout(RenderGraphAccess::TransferSource);
+}
+
+static void		RecordMemoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+{
+	VkMemoryBarrier	barrier = {};
+
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	vkCmdPipelineBarrier(cmd, srcStages, dstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void			OcclusionCulling::RecordPyramids(VkCommandBuffer cmd)
+{
+	// The readbacks of the last frame are done with the buffers
+	RecordMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+
+	// The depth aspect is copied as 32 bit floats, or as 24 bit normalized values in 32 bits
+	for (auto occlusion : _frameCameras)
+	{
+		VkBufferImageCopy	region = {};
+
+		region.imageSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+		region.imageOffset = {occlusion->rect.offset.x, occlusion->rect.offset.y, 0};
+		region.imageExtent = {occlusion->rect.extent.width, occlusion->rect.extent.height, 1};
+
+		vkCmdCopyImageToBuffer(cmd, _depthImage, RenderGraph::GetAccessLayout(RenderGraphAccess::TransferSource), occlusion->resources->buffer, 1, &region);
+	}
+
+	RecordMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	uint32_t	unormDepth = (_depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) ? 1 : 0;
+
+	for (auto occlusion : _frameCameras)
+	{
+		const auto &	levels = occlusion->resources->levels;
+		ComputeShader *	downsample = occlusion->resources->downsample.get();
+
+		for (size_t i = 1; i < levels.size(); i++)
+		{
+			glm::uvec4	source(levels[i - 1].width, levels[i - 1].height, levels[i - 1].offset, (i == 1) ? unormDepth : 0);
+			glm::uvec4	destination(levels[i].width, levels[i].height, levels[i].offset, 0);
+			uint32_t	groupsX = (levels[i].width + GroupSize - 1) / GroupSize;
+			uint32_t	groupsY = (levels[i].height + GroupSize - 1) / GroupSize;
+
+			downsample->SetPushConstant(cmd, "source", &source);
+			downsample->SetPushConstant(cmd, "destination", &destination);
+			downsample->Dispatch(cmd, groupsX * GroupSize, groupsY * GroupSize, 1);
+		}
+	}
+
+	RecordMemoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+	for (auto occlusion : _frameCameras)
+	{
+		const auto &	resources = *occlusion->resources;
+		VkDeviceSize	offset = sizeof(float) * resources.levels[resources.readbackLevel].offset;
+		VkDeviceSize	size = sizeof(float) * DepthPyramid::GetDepthCount(resources.width, resources.height) - offset;
+
+		occlusion->readbacks.push_back(PendingReadback{
+			_readbacks->ReadBuffer(cmd, resources.buffer, offset, size),
+			occlusion->viewProjection,
+			occlusion->cameraPosition,
+			resources.width,
+			resources.height,
+			resources.readbackLevel
+		});
+	}
+}
+
+const DepthPyramid *	OcclusionCulling::GetDepthPyramid(const Camera * camera) const
+{
+	auto occlusion = _cameras.find(camera);
+
+	if (!_enabled || occlusion == _cameras.end() || !occlusion->second.hasPyramid)
+		return nullptr;
+
+	glm::vec3	position = glm::vec3(glm::inverse(camera->GetViewMatrix())[3]);
+
+	if (glm::length(position - occlusion->second.pyramid.GetCameraPosition()) > _maxCameraMotion)
+		return nullptr;
+
+	return &occlusion->second.pyramid;
+}
+
+bool		OcclusionCulling::IsEnabled(void) const noexcept { return _enabled; }
+void		OcclusionCulling::SetEnabled(bool enabled) noexcept { _enabled = enabled; }
+float		OcclusionCulling::GetMaxCameraMotion(void) const noexcept { return _maxCameraMotion; }
+
+void		OcclusionCulling::SetMaxCameraMotion(float distance)
+{
+	if (distance < 0.0f)
+		throw std::runtime_error("The max camera motion of the occlusion culling can't be negative");
+
+	_maxCameraMotion = distance;
+}
+
+size_t		OcclusionCulling::GetPyramidCount(void) const noexcept
+{
+	return std::count_if(_cameras.begin(), _cameras.end(), [](const auto & camera) { return camera.second.hasPyramid; });
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, OcclusionCulling const & r)
+{
+	o << "OcclusionCulling: " << r.GetPyramidCount() << " depth pyramids" << std::endl;
+	return (o);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Components/Camera.hpp"
+#include "Core/Rendering/DepthPyramid.hpp"
+#include "Core/Rendering/RenderGraph.hpp"
+#include "Core/Shaders/ComputeShader.hpp"
+#include "Core/Vulkan/ReadbackManager.hpp"
+#include "Core/Vulkan/SwapChain.hpp"
+
+#include GLM_INCLUDE
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Hierarchical depth of the cameras rendering into the swap chain, tested by CameraCulling. After the
+	// forward pass the depth of each camera is copied into a buffer and reduced to a pyramid by a compute
+	// shader, then the small levels are read back: the renderers of the next frames are tested on the CPU
+	// against the last pyramid that came back, with the matrix of its frame. The pyramid is not used once the
+	// camera moved too far from where it was rendered, the hidden objects it uncovered would pop in late.
+	// Only the cameras with one view and no other camera drawn over them have a pyramid.
+	class		OcclusionCulling
+	{
+		private:
+			struct	PyramidResources
+			{
+				VkBuffer						buffer;
+				VkDeviceMemory					memory;
+				uint32_t						width;
+				uint32_t						height;
+				std::vector< DepthPyramidLevel >	levels;
+				uint32_t						readbackLevel;
+				std::unique_ptr< ComputeShader >	downsample;
+				uint64_t						releaseFrame;	// Destroyed once this frame is reached
+			};
+
+			struct	PendingReadback
+			{
+				std::future< ReadbackResult >	result;
+				glm::mat4						viewProjection;
+				glm::vec3						cameraPosition;
+				uint32_t						width;
+				uint32_t						height;
+				uint32_t						firstLevel;
+			};
+
+			struct	CameraOcclusion
+			{
+				std::unique_ptr< PyramidResources >	resources;
+				std::deque< PendingReadback >		readbacks;
+				DepthPyramid						pyramid;
+				bool								hasPyramid = false;
+				bool								used = false;
+				VkRect2D							rect;
+				glm::mat4							viewProjection;
+				glm::vec3							cameraPosition;
+			};
+
+			VkDevice					_device;
+			size_t						_frameCount;
+			uint64_t					_frame;
+			ReadbackManager *			_readbacks;
+			bool						_enabled;
+			float						_maxCameraMotion;
+			std::unordered_map< const Camera *, CameraOcclusion >	_cameras;
+			std::vector< CameraOcclusion * >				_frameCameras;	// Building their pyramid this frame
+			std::vector< std::unique_ptr< PyramidResources > >	_retiredResources;
+			VkImage						_depthImage;
+			VkImageLayout				_depthLayout;	// Left by the last frame
+			VkFormat					_depthFormat;
+
+			std::unique_ptr< PyramidResources >	CreateResources(uint32_t width, uint32_t height);
+			void		DestroyResources(PyramidResources & resources) noexcept;
+			void		RetireResources(std::unique_ptr< PyramidResources > resources);
+			void		ReceiveReadbacks(CameraOcclusion & occlusion);
+			void		RecordPyramids(VkCommandBuffer cmd);
+
+		public:
+			// Size under which the levels of a pyramid are read back
+			static const uint32_t	ReadbackResolution = 128;
+			static const uint32_t	GroupSize = 8;
+
+			OcclusionCulling(void);
+			OcclusionCulling(const OcclusionCulling &) = delete;
+			virtual ~OcclusionCulling(void);
+
+			OcclusionCulling &	operator=(OcclusionCulling const & src) = delete;
+
+			void		Initialize(size_t frameCount, ReadbackManager * readbacks);
+			// The frames using the buffers must be done
+			void		Release(void) noexcept;
+
+			// Receives the pyramids read back and selects the cameras building one this frame, in the draw order
+			void		Update(const std::vector< Camera * > & cameras, SwapChain * swapChain);
+			// Depth of the swap chain, the forward pass writes it before RecordPasses
+			RenderGraphResource	ImportDepth(RenderGraph & renderGraph, SwapChain * swapChain);
+			// Adds the pass building the pyramids of the cameras of the last Update
+			void		RecordPasses(RenderGraph & renderGraph, RenderGraphResource depth);
+
+			// nullptr when the camera has no pyramid yet or moved too far from the one it has
+			const DepthPyramid *	GetDepthPyramid(const Camera * camera) const;
+
+			bool		IsEnabled(void) const noexcept;
+			void		SetEnabled(bool enabled) noexcept;
+			// World distance between the camera and the position of its pyramid over which it's not used
+			float		GetMaxCameraMotion(void) const noexcept;
+			void		SetMaxCameraMotion(float distance);
+			size_t		GetPyramidCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, OcclusionCulling const & r);
+}
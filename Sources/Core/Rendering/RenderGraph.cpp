@@ -0,0 +1,816 @@
+#include "RenderGraph.hpp"
+
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/ProfilingSample.hpp"
+
+#include <algorithm>
+
+using namespace LWGC;
+
+static const VkAccessFlags			WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+	| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+// Stages that can be used in the barriers of a compute queue
+static const VkPipelineStageFlags	ComputeStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+	| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+static void					HashCombine(size_t & hash, size_t value) noexcept
+{
+	hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+static VkPipelineStageFlags	MaskStages(VkPipelineStageFlags stages, bool async) noexcept
+{
+	if (async)
+		stages &= ComputeStageMask;
+	return (stages == 0) ? static_cast< VkPipelineStageFlags >(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT) : stages;
+}
+
+// RenderGraphPass
+
+RenderGraphPass::RenderGraphPass(const std::string & name, RenderGraphPassType type, const ExecuteCallback & execute) :
+	_name(name), _profilerName(Profiler::InternName(name)), _type(type), _execute(execute), _sideEffect(false), _culled(false), _async(false)
+{
+	_barriers = {0, 0, {}};
+	_releases = {0, 0, {}};
+}
+
+void	RenderGraphPass::AddAccess(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout, bool write)
+{
+	bool					compute = _type != RenderGraphPassType::Graphics;
+	VkPipelineStageFlags	shaderStages = compute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	Access					a = {resource, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, !write, false};
+
+	if (compute && (access == RenderGraphAccess::ColorAttachment || access == RenderGraphAccess::DepthStencilAttachment))
+		throw std::runtime_error("Compute pass " + _name + " can't use attachments");
+
+	switch (access)
+	{
+		case RenderGraphAccess::ColorAttachment:
+			a = {resource, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, !write, true};
+			break ;
+		case RenderGraphAccess::DepthStencilAttachment:
+			a = {resource, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, !write, true};
+			break ;
+		case RenderGraphAccess::DepthStencilRead:
+			if (compute)
+				a = {resource, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, shaderStages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+			else
+				a = {resource, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | shaderStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+			break ;
+		case RenderGraphAccess::Sampled:
+			a = {resource, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, shaderStages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+			break ;
+		case RenderGraphAccess::StorageRead:
+			a = {resource, VK_IMAGE_LAYOUT_GENERAL, shaderStages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_STORAGE_BIT, true, false};
+			break ;
+		case RenderGraphAccess::StorageWrite:
+			a = {resource, VK_IMAGE_LAYOUT_GENERAL, shaderStages, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_USAGE_STORAGE_BIT, false, true};
+			break ;
+		case RenderGraphAccess::TransferSource:
+			a = {resource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, false};
+			break ;
+		case RenderGraphAccess::TransferDestination:
+			a = {resource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT, false, true};
+			break ;
+	}
+
+	if (write != a.write)
+		throw std::runtime_error("Pass " + _name + " declares a " + (write ? "write" : "read") + " with an access that doesn't " + (write ? "write" : "read"));
+
+	if (layout != VK_IMAGE_LAYOUT_MAX_ENUM)
+		a.layout = layout;
+
+	// Merge the accesses to the same resource, they must agree on the layout
+	for (auto & other : _accesses)
+	{
+		if (other.resource != resource)
+			continue ;
+
+		if (other.layout != a.layout)
+			throw std::runtime_error("Pass " + _name + " uses the same resource in two layouts");
+		other.stages |= a.stages;
+		other.accessMask |= a.accessMask;
+		other.usage |= a.usage;
+		other.read |= a.read;
+		other.write |= a.write;
+		return ;
+	}
+
+	_accesses.push_back(a);
+}
+
+void	RenderGraphPass::Read(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout)
+{
+	// Attachments written by the pass can be read too, when blending or loading the previous content
+	bool	attachment = access == RenderGraphAccess::ColorAttachment || access == RenderGraphAccess::DepthStencilAttachment;
+
+	AddAccess(resource, access, layout, attachment);
+	for (auto & a : _accesses)
+		if (a.resource == resource)
+			a.read = true;
+}
+
+void	RenderGraphPass::Write(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout)
+{
+	AddAccess(resource, access, layout, true);
+}
+
+void				RenderGraphPass::SetSideEffect(void) noexcept { _sideEffect = true; }
+const std::string &	RenderGraphPass::GetName(void) const noexcept { return _name; }
+bool				RenderGraphPass::IsCulled(void) const noexcept { return _culled; }
+bool				RenderGraphPass::IsAsync(void) const noexcept { return _async; }
+
+// RenderGraph
+
+RenderGraph::RenderGraph(void) :
+	_device(VK_NULL_HANDLE), _graphicsFamily(0), _asyncComputeFamily(0), _asyncComputeEnabled(false), _currentSlot(nullptr),
+	_asyncWaitStages(0), _previousAsyncWaitStages(0), _previousGraphicsWaitStages(0), _compiled(false), _culledPassCount(0), _transientMemorySize(0), _transientMemoryWithoutAliasing(0)
+{
+}
+
+RenderGraph::~RenderGraph(void)
+{
+	Release();
+}
+
+void		RenderGraph::Initialize(size_t frameCount)
+{
+	VulkanInstance * instance = VulkanInstance::Get();
+
+	_device = instance->GetDevice();
+	_graphicsFamily = instance->GetQueueIndex();
+	_slots.resize(frameCount, {0, {}, {}, {}, {}});
+}
+
+void		RenderGraph::Release(void) noexcept
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	vkDeviceWaitIdle(_device);
+
+	for (auto & slot : _slots)
+		ReleaseSlot(slot);
+	_importedStates.clear();
+	_currentSlot = nullptr;
+	_compiled = false;
+}
+
+void		RenderGraph::SetAsyncComputeQueue(uint32_t queueFamilyIndex) noexcept
+{
+	// A queue of the graphics family gains nothing from the ownership transfers
+	_asyncComputeFamily = queueFamilyIndex;
+	_asyncComputeEnabled = queueFamilyIndex != _graphicsFamily;
+}
+
+void		RenderGraph::Reset(void) noexcept
+{
+	_passes.clear();
+	_resources.clear();
+	_compiled = false;
+}
+
+RenderGraphResource	RenderGraph::ImportTexture(Texture * texture)
+{
+	RenderGraphResource resource = ImportImage(texture->GetName(), texture->image, texture->view, texture->format, texture->width, texture->height, texture->layout);
+
+	_resources[resource].texture = texture;
+	return resource;
+}
+
+RenderGraphResource	RenderGraph::ImportImage(const std::string & name, VkImage image, VkImageView view, VkFormat format, uint32_t width, uint32_t height, VkImageLayout layout)
+{
+	_resources.push_back({name, true, nullptr, image, view, format, width, height, layout, 0, -1, -1, false, layout, false, false, layout});
+	return static_cast< RenderGraphResource >(_resources.size() - 1);
+}
+
+RenderGraphResource	RenderGraph::CreateTexture(const std::string & name, const RenderGraphTextureDesc & desc)
+{
+	_resources.push_back({name, false, nullptr, VK_NULL_HANDLE, VK_NULL_HANDLE, desc.format, desc.width, desc.height, VK_IMAGE_LAYOUT_UNDEFINED, 0, -1, -1, false, VK_IMAGE_LAYOUT_UNDEFINED, false, false, VK_IMAGE_LAYOUT_UNDEFINED});
+	return static_cast< RenderGraphResource >(_resources.size() - 1);
+}
+
+RenderGraphPass *	RenderGraph::AddPass(const std::string & name, RenderGraphPassType type, const RenderGraphPass::ExecuteCallback & execute)
+{
+	_passes.emplace_back(new RenderGraphPass(name, type, execute));
+	return _passes.back().get();
+}
+
+void		RenderGraph::SetNextFrameRead(RenderGraphResource resource, RenderGraphPassType type, RenderGraphAccess access, VkImageLayout layout)
+{
+	if (resource >= _resources.size() || !_resources[resource].imported)
+		throw std::runtime_error("Only the imported images are kept for the next frame");
+
+	auto &	r = _resources[resource];
+
+	r.nextFrameRead = true;
+	r.nextFrameAsync = type == RenderGraphPassType::AsyncCompute;
+	r.nextFrameLayout = (layout == VK_IMAGE_LAYOUT_MAX_ENUM) ? GetAccessLayout(access) : layout;
+}
+
+void		RenderGraph::CullPasses(void)
+{
+	std::vector< bool >	needed(_resources.size(), false);
+
+	// Walk back from the passes with visible results: a pass is kept if it writes something read later
+	_culledPassCount = 0;
+	for (size_t i = _passes.size(); i-- > 0; )
+	{
+		auto &	pass = *_passes[i];
+		bool	alive = pass._sideEffect;
+
+		for (const auto & a : pass._accesses)
+		{
+			if (a.resource >= _resources.size())
+				throw std::runtime_error("Pass " + pass._name + " uses an unknown resource");
+			if (a.write && (_resources[a.resource].imported || needed[a.resource]))
+				alive = true;
+		}
+
+		pass._culled = !alive;
+		if (!alive)
+		{
+			_culledPassCount++;
+			continue ;
+		}
+
+		// An overwritten resource doesn't need the writes of the previous passes
+		for (const auto & a : pass._accesses)
+			if (a.write && !a.read)
+				needed[a.resource] = false;
+		for (const auto & a : pass._accesses)
+			if (a.read)
+				needed[a.resource] = true;
+	}
+}
+
+void		RenderGraph::SchedulePasses(void)
+{
+	std::vector< bool >	graphicsUse(_resources.size(), false);
+
+	// An async compute pass only moves to the second queue if it doesn't depend on the graphics work of the
+	// frame, so the async queue never waits on the graphics one and a single semaphore is enough
+	for (auto & pass : _passes)
+	{
+		pass->_async = false;
+		if (pass->_culled)
+			continue ;
+
+		if (pass->_type == RenderGraphPassType::AsyncCompute && _asyncComputeEnabled)
+			pass->_async = std::none_of(pass->_accesses.begin(), pass->_accesses.end(), [&](const RenderGraphPass::Access & a) { return graphicsUse[a.resource]; });
+
+		if (!pass->_async)
+			for (const auto & a : pass->_accesses)
+				graphicsUse[a.resource] = true;
+	}
+}
+
+void		RenderGraph::ComputeLifetimes(void)
+{
+	for (auto & resource : _resources)
+	{
+		resource.firstPass = -1;
+		resource.lastPass = -1;
+		resource.async = false;
+		if (!resource.imported)
+			resource.usage = 0;
+	}
+
+	for (size_t i = 0; i < _passes.size(); i++)
+	{
+		if (_passes[i]->_culled)
+			continue ;
+
+		for (const auto & a : _passes[i]->_accesses)
+		{
+			auto & resource = _resources[a.resource];
+
+			if (resource.firstPass == -1)
+				resource.firstPass = static_cast< int >(i);
+			resource.lastPass = static_cast< int >(i);
+			resource.async |= _passes[i]->_async;
+			if (!resource.imported)
+				resource.usage |= a.usage;
+		}
+	}
+}
+
+size_t		RenderGraph::HashTransients(void) const noexcept
+{
+	size_t	hash = 0;
+
+	for (size_t i = 0; i < _resources.size(); i++)
+	{
+		const auto & r = _resources[i];
+
+		if (r.imported || r.firstPass == -1)
+			continue ;
+
+		HashCombine(hash, i);
+		HashCombine(hash, r.width);
+		HashCombine(hash, r.height);
+		HashCombine(hash, static_cast< size_t >(r.format));
+		HashCombine(hash, r.usage);
+		HashCombine(hash, static_cast< size_t >(r.firstPass));
+		HashCombine(hash, static_cast< size_t >(r.lastPass));
+		HashCombine(hash, r.async);
+	}
+
+	return hash;
+}
+
+void		RenderGraph::ReleaseSlot(FrameSlot & slot) noexcept
+{
+	static const ProfilerNameId	memoryName = Profiler::InternName("Render graph memory");
+
+	for (auto & framebuffer : slot.framebuffers)
+		vkDestroyFramebuffer(_device, framebuffer.second, nullptr);
+	for (auto & image : slot.images)
+	{
+		if (image.view != VK_NULL_HANDLE)
+			vkDestroyImageView(_device, image.view, nullptr);
+		if (image.image != VK_NULL_HANDLE)
+			vkDestroyImage(_device, image.image, nullptr);
+	}
+	for (size_t i = 0; i < slot.memories.size(); i++)
+	{
+		vkFreeMemory(_device, slot.memories[i], nullptr);
+		Profiler::RecordAllocation(memoryName, -static_cast< int64_t >(slot.memorySizes[i]));
+	}
+
+	slot.hash = 0;
+	slot.framebuffers.clear();
+	slot.images.clear();
+	slot.memories.clear();
+	slot.memorySizes.clear();
+}
+
+void		RenderGraph::AllocateTransients(FrameSlot & slot)
+{
+	static const ProfilerNameId	memoryName = Profiler::InternName("Render graph memory");
+	VulkanInstance *			instance = VulkanInstance::Get();
+	std::vector< uint32_t >		memoryTypes;
+	std::vector< VkDeviceSize >	alignments(_resources.size(), 1);
+	std::vector< uint32_t >		order;
+
+	ReleaseSlot(slot);
+	slot.images.resize(_resources.size(), {VK_NULL_HANDLE, VK_NULL_HANDLE, 0, 0, 0, {}});
+
+	for (uint32_t i = 0; i < _resources.size(); i++)
+	{
+		const auto & r = _resources[i];
+
+		if (r.imported || r.firstPass == -1)
+			continue ;
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = {r.width, r.height, 1};
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = r.format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = r.usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		auto & transient = slot.images[i];
+		Vk::CheckResult(vkCreateImage(_device, &imageInfo, nullptr, &transient.image), "Failed to create transient image " + r.name);
+		Vk::SetImageDebugName(r.name, transient.image);
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(_device, transient.image, &requirements);
+
+		uint32_t memoryType = instance->FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		auto memory = std::find(memoryTypes.begin(), memoryTypes.end(), memoryType);
+		transient.memory = static_cast< uint32_t >(memory - memoryTypes.begin());
+		if (memory == memoryTypes.end())
+		{
+			memoryTypes.push_back(memoryType);
+			slot.memorySizes.push_back(0);
+		}
+		transient.size = requirements.size;
+		alignments[i] = requirements.alignment;
+		order.push_back(i);
+	}
+
+	auto overlaps = [&](uint32_t a, uint32_t b)
+	{
+		const auto & ra = _resources[a];
+		const auto & rb = _resources[b];
+		// The order of the async passes against the graphics ones isn't known
+		return ra.async || rb.async || !(ra.lastPass < rb.firstPass || rb.lastPass < ra.firstPass);
+	};
+	auto sharesMemory = [&](uint32_t a, uint32_t b)
+	{
+		const auto & ta = slot.images[a];
+		const auto & tb = slot.images[b];
+		return ta.memory == tb.memory && ta.offset < tb.offset + tb.size && tb.offset < ta.offset + ta.size;
+	};
+
+	// Biggest images first, each one goes at the lowest offset not used by an image alive at the same time
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return slot.images[a].size > slot.images[b].size; });
+
+	_transientMemoryWithoutAliasing = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		auto &	transient = slot.images[order[i]];
+		bool	moved = true;
+
+		_transientMemoryWithoutAliasing += transient.size;
+		transient.offset = 0;
+		while (moved)
+		{
+			moved = false;
+			for (size_t j = 0; j < i; j++)
+			{
+				if (!overlaps(order[i], order[j]) || !sharesMemory(order[i], order[j]))
+					continue ;
+				const auto & other = slot.images[order[j]];
+				VkDeviceSize alignment = alignments[order[i]];
+				transient.offset = (other.offset + other.size + alignment - 1) / alignment * alignment;
+				moved = true;
+			}
+		}
+		slot.memorySizes[transient.memory] = std::max(slot.memorySizes[transient.memory], transient.offset + transient.size);
+	}
+
+	// The first use of an aliased image must wait for the images that used its memory before
+	for (uint32_t a : order)
+		for (uint32_t b : order)
+			if (a != b && !overlaps(a, b) && sharesMemory(a, b) && _resources[b].lastPass < _resources[a].firstPass)
+				slot.images[a].predecessors.push_back(b);
+
+	_transientMemorySize = 0;
+	for (size_t i = 0; i < memoryTypes.size(); i++)
+	{
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = slot.memorySizes[i];
+		allocInfo.memoryTypeIndex = memoryTypes[i];
+
+		VkDeviceMemory memory;
+		Vk::CheckResult(vkAllocateMemory(_device, &allocInfo, nullptr, &memory), "Failed to allocate render graph memory");
+		slot.memories.push_back(memory);
+		_transientMemorySize += slot.memorySizes[i];
+		Profiler::RecordAllocation(memoryName, static_cast< int64_t >(slot.memorySizes[i]));
+	}
+
+	for (uint32_t i : order)
+	{
+		auto & transient = slot.images[i];
+		const auto & r = _resources[i];
+
+		Vk::CheckResult(vkBindImageMemory(_device, transient.image, slot.memories[transient.memory], transient.offset), "Bind transient image memory failed");
+		transient.view = Vk::CreateImageView(transient.image, r.format, 1, VK_IMAGE_VIEW_TYPE_2D, Vk::GetImageAspect(r.format));
+	}
+
+	slot.hash = HashTransients();
+}
+
+void		RenderGraph::BuildBarriers(void)
+{
+	std::vector< ResourceState >		states(_resources.size());
+	std::vector< RenderGraphPass * >	lastUsers(_resources.size(), nullptr);
+
+	for (size_t i = 0; i < _resources.size(); i++)
+	{
+		const auto &	r = _resources[i];
+		auto &			state = states[i];
+		auto			imported = _importedStates.find(r.image);
+
+		// The state is only kept if nothing changed the layout of the image since the last frame
+		if (r.imported && imported != _importedStates.end() && r.initialLayout ==
+			((imported->second.releaseFamily != VK_QUEUE_FAMILY_IGNORED) ? imported->second.releaseLayout : imported->second.layout))
+			state = imported->second;
+		else if (r.imported)
+		{
+			// Unknown previous use: wait for anything that can use the image in its current layout
+			VkPipelineStageFlags	stages;
+			VkAccessFlags			access;
+
+			Vk::GetLayoutStagesAndAccess(r.initialLayout, stages, access);
+			state = {r.initialLayout, stages, access & WriteAccessMask, 0, 0, 0, _graphicsFamily, false, VK_QUEUE_FAMILY_IGNORED, r.initialLayout};
+		}
+		else
+			state = {VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0, 0, VK_QUEUE_FAMILY_IGNORED, false, VK_QUEUE_FAMILY_IGNORED, VK_IMAGE_LAYOUT_UNDEFINED};
+	}
+
+	_asyncWaitStages = 0;
+	_previousAsyncWaitStages = 0;
+	_previousGraphicsWaitStages = 0;
+	for (auto & passPointer : _passes)
+	{
+		auto &		pass = *passPointer;
+		uint32_t	family = pass._async ? _asyncComputeFamily : _graphicsFamily;
+
+		pass._barriers = {0, 0, {}};
+		pass._releases = {0, 0, {}};
+		if (pass._culled)
+			continue ;
+
+		for (const auto & a : pass._accesses)
+		{
+			const auto &	r = _resources[a.resource];
+			auto &			state = states[a.resource];
+			auto			lastUser = lastUsers[a.resource];
+
+			// Aliased memory: wait for the passes that used the previous images
+			if (!r.imported && lastUser == nullptr)
+			{
+				for (uint32_t predecessor : _currentSlot->images[a.resource].predecessors)
+				{
+					state.writeStages |= states[predecessor].writeStages | states[predecessor].readStages;
+					state.writeAccess |= states[predecessor].writeAccess;
+				}
+			}
+
+			bool	transition = state.layout != a.layout;
+			// Last used by the other queue, in this frame or the previous one, the order comes from a semaphore
+			bool	queueChange = (lastUser != nullptr) ? lastUser->_async != pass._async
+				: state.queueFamily != VK_QUEUE_FAMILY_IGNORED && state.async != pass._async;
+			bool	acquire = lastUser == nullptr && state.releaseFamily != VK_QUEUE_FAMILY_IGNORED;
+			bool	hazard = a.write ? (state.writeStages | state.readStages) != 0
+				: state.writeStages != 0 && ((a.stages & ~state.visibleStages) != 0 || (a.accessMask & ~state.visibleAccess) != 0);
+
+			if (transition || queueChange || acquire || hazard)
+			{
+				VkImageMemoryBarrier	barrier = {};
+				VkPipelineStageFlags	srcStages = state.writeStages | ((a.write || transition) ? state.readStages : 0);
+
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.oldLayout = state.layout;
+				barrier.newLayout = a.layout;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = r.imported ? r.image : _currentSlot->images[a.resource].image;
+				barrier.subresourceRange = {Vk::GetImageAspect(r.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+				barrier.srcAccessMask = state.writeAccess;
+				barrier.dstAccessMask = a.accessMask;
+
+				if (acquire)
+				{
+					// Released at the end of the last frame, when the graph changed the image is discarded instead
+					if (state.releaseFamily == family && state.releaseLayout == a.layout)
+					{
+						barrier.srcQueueFamilyIndex = state.queueFamily;
+						barrier.dstQueueFamilyIndex = family;
+					}
+					else
+						barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				}
+				else if (queueChange && state.queueFamily != family)
+				{
+					if (lastUser != nullptr)
+					{
+						// Release on the queue of the last user, the acquire waits on the semaphore between the queues
+						barrier.srcQueueFamilyIndex = state.queueFamily;
+						barrier.dstQueueFamilyIndex = family;
+
+						VkImageMemoryBarrier release = barrier;
+						release.dstAccessMask = 0;
+						lastUser->_releases.srcStages |= MaskStages(srcStages, lastUser->_async);
+						lastUser->_releases.dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+						lastUser->_releases.barriers.push_back(release);
+					}
+					else // Owned by the other family without a release (see SetNextFrameRead), the content is lost
+						barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				}
+
+				if (queueChange || acquire)
+				{
+					barrier.srcAccessMask = 0;
+					srcStages = a.stages;
+					if (lastUser != nullptr)
+						_asyncWaitStages |= a.stages;
+					else if (pass._async)
+						_previousGraphicsWaitStages |= a.stages;
+					else
+						_previousAsyncWaitStages |= a.stages;
+				}
+
+				pass._barriers.srcStages |= MaskStages(srcStages, pass._async);
+				pass._barriers.dstStages |= MaskStages(a.stages, pass._async);
+				pass._barriers.barriers.push_back(barrier);
+
+				if (a.write)
+					state = {a.layout, a.stages, a.accessMask & WriteAccessMask, 0, a.stages, a.accessMask, family, pass._async, VK_QUEUE_FAMILY_IGNORED, a.layout};
+				else
+					state = {a.layout, a.stages, 0, a.stages, a.stages, a.accessMask, family, pass._async, VK_QUEUE_FAMILY_IGNORED, a.layout};
+			}
+			else
+			{
+				state.readStages |= a.stages;
+				state.visibleStages |= a.stages;
+				state.visibleAccess |= a.accessMask;
+			}
+
+			lastUsers[a.resource] = passPointer.get();
+		}
+	}
+
+	// Imported images read by the other queue first next frame are released at the end of this one. Unless
+	// SetNextFrameRead says otherwise, the next frame is expected to use them like this one
+	for (size_t i = 0; i < _resources.size(); i++)
+	{
+		auto &	r = _resources[i];
+		auto &	state = states[i];
+
+		if (!r.imported || r.firstPass == -1)
+			continue ;
+
+		uint32_t		nextFamily;
+		VkImageLayout	nextLayout;
+		bool			nextRead;
+
+		if (r.nextFrameRead)
+		{
+			nextFamily = (r.nextFrameAsync && _asyncComputeEnabled) ? _asyncComputeFamily : _graphicsFamily;
+			nextLayout = r.nextFrameLayout;
+			nextRead = true;
+		}
+		else
+		{
+			const auto &	firstPass = *_passes[r.firstPass];
+			auto			firstAccess = std::find_if(firstPass._accesses.begin(), firstPass._accesses.end(), [i](const RenderGraphPass::Access & a) { return a.resource == i; });
+
+			nextFamily = firstPass._async ? _asyncComputeFamily : _graphicsFamily;
+			nextLayout = firstAccess->layout;
+			nextRead = firstAccess->read;
+		}
+
+		if (nextFamily != state.queueFamily && nextRead)
+		{
+			auto &					lastUser = *lastUsers[i];
+			VkImageMemoryBarrier	release = {};
+
+			release.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			release.oldLayout = state.layout;
+			release.newLayout = nextLayout;
+			release.srcQueueFamilyIndex = state.queueFamily;
+			release.dstQueueFamilyIndex = nextFamily;
+			release.image = r.image;
+			release.subresourceRange = {Vk::GetImageAspect(r.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+			release.srcAccessMask = state.writeAccess;
+			release.dstAccessMask = 0;
+
+			lastUser._releases.srcStages |= MaskStages(state.writeStages | state.readStages, lastUser._async);
+			lastUser._releases.dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			lastUser._releases.barriers.push_back(release);
+			state.releaseFamily = nextFamily;
+			state.releaseLayout = nextLayout;
+		}
+
+		r.finalLayout = (state.releaseFamily != VK_QUEUE_FAMILY_IGNORED) ? state.releaseLayout : state.layout;
+		_importedStates[r.image] = state;
+	}
+}
+
+void		RenderGraph::Compile(size_t frameIndex)
+{
+	LWGC_PROFILE_SCOPE("Render Graph Compile");
+
+	if (_device == VK_NULL_HANDLE)
+		throw std::runtime_error("RenderGraph must be initialized before compiling");
+	if (frameIndex >= _slots.size())
+		_slots.resize(frameIndex + 1, {0, {}, {}, {}, {}});
+
+	CullPasses();
+	SchedulePasses();
+	ComputeLifetimes();
+
+	_currentSlot = &_slots[frameIndex];
+	if (_currentSlot->hash != HashTransients() || _currentSlot->images.size() != _resources.size())
+		AllocateTransients(*_currentSlot);
+
+	BuildBarriers();
+	_compiled = true;
+}
+
+static void	RecordBarriers(VkCommandBuffer cmd, const std::vector< VkImageMemoryBarrier > & barriers, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages)
+{
+	if (barriers.empty())
+		return ;
+
+	vkCmdPipelineBarrier(
+		cmd,
+		srcStages, dstStages,
+		0,										// Dependency flags
+		0, nullptr,
+		0, nullptr,
+		static_cast< uint32_t >(barriers.size()), barriers.data()
+	);
+}
+
+void		RenderGraph::Execute(VkCommandBuffer graphicsCmd, VkCommandBuffer asyncComputeCmd)
+{
+	if (!_compiled)
+		throw std::runtime_error("RenderGraph must be compiled before being executed");
+	if (HasAsyncComputePasses() && asyncComputeCmd == VK_NULL_HANDLE)
+		throw std::runtime_error("RenderGraph has async compute passes but no async command buffer");
+
+	for (auto & pass : _passes)
+	{
+		if (pass->_culled)
+			continue ;
+
+		VkCommandBuffer cmd = pass->_async ? asyncComputeCmd : graphicsCmd;
+		auto sample = ProfilingSample(cmd, pass->_profilerName);
+
+		RecordBarriers(cmd, pass->_barriers.barriers, pass->_barriers.srcStages, pass->_barriers.dstStages);
+		pass->_execute(cmd);
+		RecordBarriers(cmd, pass->_releases.barriers, pass->_releases.srcStages, pass->_releases.dstStages);
+	}
+
+	for (const auto & r : _resources)
+		if (r.texture != nullptr && r.firstPass != -1)
+			r.texture->layout = r.finalLayout;
+}
+
+VkImage		RenderGraph::GetImage(RenderGraphResource resource) const
+{
+	if (!_compiled || resource >= _resources.size())
+		throw std::runtime_error("Invalid render graph resource");
+
+	return _resources[resource].imported ? _resources[resource].image : _currentSlot->images[resource].image;
+}
+
+VkImageView	RenderGraph::GetView(RenderGraphResource resource) const
+{
+	if (!_compiled || resource >= _resources.size())
+		throw std::runtime_error("Invalid render graph resource");
+
+	return _resources[resource].imported ? _resources[resource].view : _currentSlot->images[resource].view;
+}
+
+// Framebuffers are cached with the transient images of the slot, until they are reallocated or the graph is released
+VkFramebuffer	RenderGraph::GetFramebuffer(VkRenderPass renderPass, const std::vector< RenderGraphResource > & attachments)
+{
+	std::vector< VkImageView >	views;
+	size_t						hash = reinterpret_cast< size_t >(renderPass);
+
+	if (attachments.empty())
+		throw std::runtime_error("Can't create a framebuffer without attachments");
+
+	for (auto attachment : attachments)
+	{
+		views.push_back(GetView(attachment));
+		HashCombine(hash, reinterpret_cast< size_t >(views.back()));
+	}
+
+	auto framebuffer = _currentSlot->framebuffers.find(hash);
+	if (framebuffer != _currentSlot->framebuffers.end())
+		return framebuffer->second;
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast< uint32_t >(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = _resources[attachments[0]].width;
+	framebufferInfo.height = _resources[attachments[0]].height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer result;
+	Vk::CheckResult(vkCreateFramebuffer(_device, &framebufferInfo, nullptr, &result), "Failed to create render graph framebuffer");
+	_currentSlot->framebuffers[hash] = result;
+
+	return result;
+}
+
+VkImageLayout	RenderGraph::GetAccessLayout(RenderGraphAccess access) noexcept
+{
+	switch (access)
+	{
+		case RenderGraphAccess::ColorAttachment:		return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		case RenderGraphAccess::DepthStencilAttachment:	return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		case RenderGraphAccess::DepthStencilRead:		return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		case RenderGraphAccess::Sampled:				return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		case RenderGraphAccess::TransferSource:			return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		case RenderGraphAccess::TransferDestination:	return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		default:										return VK_IMAGE_LAYOUT_GENERAL;
+	}
+}
+
+bool					RenderGraph::HasAsyncComputePasses(void) const noexcept
+{
+	return std::any_of(_passes.begin(), _passes.end(), [](const std::unique_ptr< RenderGraphPass > & p) { return !p->_culled && p->_async; });
+}
+
+VkPipelineStageFlags	RenderGraph::GetAsyncComputeWaitStages(void) const noexcept { return _asyncWaitStages; }
+VkPipelineStageFlags	RenderGraph::GetPreviousAsyncComputeWaitStages(void) const noexcept { return _previousAsyncWaitStages; }
+VkPipelineStageFlags	RenderGraph::GetPreviousGraphicsWaitStages(void) const noexcept { return _previousGraphicsWaitStages; }
+
+size_t					RenderGraph::GetPassCount(void) const noexcept { return _passes.size(); }
+size_t					RenderGraph::GetCulledPassCount(void) const noexcept { return _culledPassCount; }
+VkDeviceSize			RenderGraph::GetTransientMemorySize(void) const noexcept { return _transientMemorySize; }
+VkDeviceSize			RenderGraph::GetTransientMemoryWithoutAliasing(void) const noexcept { return _transientMemoryWithoutAliasing; }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, RenderGraph const & r)
+{
+	o << "RenderGraph: " << r.GetPassCount() << " passes, " << r.GetCulledPassCount() << " culled" << std::endl;
+	return (o);
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Profiler.hpp"
+#include "Core/Textures/Texture.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	using RenderGraphResource = uint32_t;
+
+	// How a pass uses an image, the layout, stages and access masks of the barriers are derived from it
+	enum class	RenderGraphAccess
+	{
+		ColorAttachment,
+		DepthStencilAttachment,
+		DepthStencilRead,		// Read-only depth test, or depth sampled in a shader
+		Sampled,
+		StorageRead,
+		StorageWrite,
+		TransferSource,
+		TransferDestination,
+	};
+
+	enum class	RenderGraphPassType
+	{
+		Graphics,
+		Compute,
+		AsyncCompute,			// Compute pass that can run on the async compute queue, see SetAsyncComputeQueue
+	};
+
+	// Transient texture, only lives during the frame. The usage flags are deduced from the accesses
+	struct	RenderGraphTextureDesc
+	{
+		uint32_t	width;
+		uint32_t	height;
+		VkFormat	format;
+	};
+
+	class		RenderGraphPass
+	{
+		friend class RenderGraph;
+
+		public:
+			using ExecuteCallback = std::function< void(VkCommandBuffer cmd) >;
+
+		private:
+			struct	Access
+			{
+				RenderGraphResource		resource;
+				VkImageLayout			layout;
+				VkPipelineStageFlags	stages;
+				VkAccessFlags			accessMask;
+				VkImageUsageFlags		usage;
+				bool					read;		// The pass needs the previous content
+				bool					write;
+			};
+
+			struct	BarrierBatch
+			{
+				VkPipelineStageFlags				srcStages;
+				VkPipelineStageFlags				dstStages;
+				std::vector< VkImageMemoryBarrier >	barriers;
+			};
+
+			std::string				_name;
+			ProfilerNameId			_profilerName;
+			RenderGraphPassType		_type;
+			ExecuteCallback			_execute;
+			std::vector< Access >	_accesses;
+			bool					_sideEffect;
+
+			// Set by RenderGraph::Compile
+			bool					_culled;
+			bool					_async;
+			BarrierBatch			_barriers;			// Recorded before the pass
+			BarrierBatch			_releases;			// Queue ownership releases recorded after the pass
+
+			RenderGraphPass(const std::string & name, RenderGraphPassType type, const ExecuteCallback & execute);
+
+			void	AddAccess(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout, bool write);
+
+		public:
+			RenderGraphPass(void) = delete;
+			RenderGraphPass(const RenderGraphPass &) = delete;
+			virtual ~RenderGraphPass(void) = default;
+
+			RenderGraphPass &	operator=(RenderGraphPass const & src) = delete;
+
+			// The layout can be forced when the descriptors of the pass were written with another one.
+			// A write overwrites the resource, a pass that accumulates into it must also declare a read.
+			void	Read(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout = VK_IMAGE_LAYOUT_MAX_ENUM);
+			void	Write(RenderGraphResource resource, RenderGraphAccess access, VkImageLayout layout = VK_IMAGE_LAYOUT_MAX_ENUM);
+			// The pass has effects outside of the graph (presents, writes buffers, ...), it's never culled
+			void	SetSideEffect(void) noexcept;
+
+			const std::string &	GetName(void) const noexcept;
+			bool				IsCulled(void) const noexcept;
+			bool				IsAsync(void) const noexcept;
+	};
+
+	// Passes declare the images they read and write, and the graph records the synchronization: Compile
+	// culls the passes whose results are never used, moves the async compute passes that only depend on
+	// async work to the second queue, places the transient textures whose lifetimes don't overlap in the
+	// same memory and derives the barriers, layout transitions and queue ownership transfers between the
+	// passes. The pipeline builds the graph again each frame, the transient memory of a frame slot is only
+	// rebuilt when the transient textures or their lifetimes change.
+	class		RenderGraph
+	{
+		private:
+			struct	ResourceState
+			{
+				VkImageLayout			layout;
+				VkPipelineStageFlags	writeStages;	// Last write or layout transition
+				VkAccessFlags			writeAccess;
+				VkPipelineStageFlags	readStages;		// Reads since the last write
+				VkPipelineStageFlags	visibleStages;	// Stages the last write was made visible to
+				VkAccessFlags			visibleAccess;
+				uint32_t				queueFamily;
+				bool					async;			// Last used on the async compute queue
+				uint32_t				releaseFamily;	// Family that acquires the image at its next use
+				VkImageLayout			releaseLayout;
+			};
+
+			struct	Resource
+			{
+				std::string				name;
+				bool					imported;
+				Texture *				texture;
+				VkImage					image;
+				VkImageView				view;
+				VkFormat				format;
+				uint32_t				width;
+				uint32_t				height;
+				VkImageLayout			initialLayout;
+				VkImageUsageFlags		usage;
+				int						firstPass;
+				int						lastPass;
+				bool					async;			// Used by a pass of the async compute queue
+				VkImageLayout			finalLayout;
+				bool					nextFrameRead;	// See SetNextFrameRead
+				bool					nextFrameAsync;
+				VkImageLayout			nextFrameLayout;
+			};
+
+			struct	TransientImage
+			{
+				VkImage					image;
+				VkImageView				view;
+				uint32_t				memory;			// Index in the memories of the slot
+				VkDeviceSize			offset;
+				VkDeviceSize			size;
+				std::vector< uint32_t >	predecessors;	// Transient images that used the same memory before
+			};
+
+			struct	FrameSlot
+			{
+				size_t										hash;
+				std::vector< TransientImage >				images;		// One per resource, null for imported ones
+				std::vector< VkDeviceMemory >				memories;
+				std::vector< VkDeviceSize >					memorySizes;
+				std::unordered_map< size_t, VkFramebuffer >	framebuffers;
+			};
+
+			VkDevice										_device;
+			uint32_t										_graphicsFamily;
+			uint32_t										_asyncComputeFamily;
+			bool											_asyncComputeEnabled;
+			std::vector< std::unique_ptr< RenderGraphPass > >	_passes;
+			std::vector< Resource >							_resources;
+			std::vector< FrameSlot >						_slots;
+			FrameSlot *										_currentSlot;
+			std::unordered_map< VkImage, ResourceState >	_importedStates;	// State of the imported images at the end of the last frame
+			VkPipelineStageFlags							_asyncWaitStages;
+			VkPipelineStageFlags							_previousAsyncWaitStages;
+			VkPipelineStageFlags							_previousGraphicsWaitStages;
+			bool											_compiled;
+			size_t											_culledPassCount;
+			VkDeviceSize									_transientMemorySize;
+			VkDeviceSize									_transientMemoryWithoutAliasing;
+
+			void	CullPasses(void);
+			void	SchedulePasses(void);
+			void	ComputeLifetimes(void);
+			void	AllocateTransients(FrameSlot & slot);
+			void	ReleaseSlot(FrameSlot & slot) noexcept;
+			void	BuildBarriers(void);
+			size_t	HashTransients(void) const noexcept;
+
+		public:
+			RenderGraph(void);
+			RenderGraph(const RenderGraph &) = delete;
+			virtual ~RenderGraph(void);
+
+			RenderGraph &	operator=(RenderGraph const & src) = delete;
+
+			// frameCount is the number of frames in flight, each one has its own transient memory
+			void		Initialize(size_t frameCount);
+			// Waits for the device and destroys the transient images
+			void		Release(void) noexcept;
+			// Async compute passes are only moved to another queue once its family is set, and if it's not the graphics one
+			void		SetAsyncComputeQueue(uint32_t queueFamilyIndex) noexcept;
+
+			// Clear the passes and resources to build the graph of a new frame
+			void		Reset(void) noexcept;
+
+			RenderGraphResource	ImportTexture(Texture * texture);
+			RenderGraphResource	ImportImage(const std::string & name, VkImage image, VkImageView view, VkFormat format, uint32_t width, uint32_t height, VkImageLayout layout);
+			RenderGraphResource	CreateTexture(const std::string & name, const RenderGraphTextureDesc & desc);
+
+			// The pass is owned by the graph, the pointer is valid until Reset
+			RenderGraphPass *	AddPass(const std::string & name, RenderGraphPassType type, const RenderGraphPass::ExecuteCallback & execute);
+			// Declares the first use of an imported image next frame when it differs from its first use in this
+			// one (double buffered results), so the ownership is released to the right queue at the end of the frame
+			void		SetNextFrameRead(RenderGraphResource resource, RenderGraphPassType type, RenderGraphAccess access, VkImageLayout layout = VK_IMAGE_LAYOUT_MAX_ENUM);
+
+			// Must be called after the fence of the frame slot is signaled, the transient images of the slot can be recreated
+			void		Compile(size_t frameIndex);
+			// The async command buffer is only needed when HasAsyncComputePasses, it must be submitted before
+			// the graphics one and signal a semaphore, see the wait stages below
+			void		Execute(VkCommandBuffer graphicsCmd, VkCommandBuffer asyncComputeCmd = VK_NULL_HANDLE);
+
+			// Resources can be queried by the passes once the graph is compiled
+			VkImage			GetImage(RenderGraphResource resource) const;
+			VkImageView		GetView(RenderGraphResource resource) const;
+			VkFramebuffer	GetFramebuffer(VkRenderPass renderPass, const std::vector< RenderGraphResource > & attachments);
+
+			bool					HasAsyncComputePasses(void) const noexcept;
+			// Stages of the graphics submit that wait on the async compute semaphore of this frame, 0 when the
+			// graphics passes don't use the async results of this frame and the wait can move to the next frame
+			VkPipelineStageFlags	GetAsyncComputeWaitStages(void) const noexcept;
+			// Stages of the graphics submit that use what the async compute queue did last frame
+			VkPipelineStageFlags	GetPreviousAsyncComputeWaitStages(void) const noexcept;
+			// Stages of the async compute submit that use what the graphics queue did last frame
+			VkPipelineStageFlags	GetPreviousGraphicsWaitStages(void) const noexcept;
+			size_t					GetPassCount(void) const noexcept;
+			size_t					GetCulledPassCount(void) const noexcept;
+			VkDeviceSize			GetTransientMemorySize(void) const noexcept;
+			VkDeviceSize			GetTransientMemoryWithoutAliasing(void) const noexcept;
+
+			// Layout used for an access, the attachments of the render passes should use it as initial and final layout
+			static VkImageLayout	GetAccessLayout(RenderGraphAccess access) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, RenderGraph const & r);
+}
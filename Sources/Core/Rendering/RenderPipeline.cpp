@@ -9,13 +9,18 @@
 #include "Core/Handles/HandleManager.hpp"
 #include "Core/MaterialTable.hpp"
 #include "Core/Time.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
+#include "Core/Vulkan/ProfilingSample.hpp"
 
 #include <cmath>
+#include <algorithm>
 #include <unordered_set>
 
 using namespace LWGC;
 
-RenderPipeline::RenderPipeline(void) : framebufferResized(false), _initialized(false)
+RenderPipeline::RenderPipeline(void) : framesInFlight(DefaultFramesInFlight), framebufferResized(false), _imageIndex(0), _initialized(false),
+	_latencyMode(LatencyMode::MaxThroughput), _presentModeChanged(false), _inputTime(0), _lastLatency(0),
+	_submittedFrameCount(0), _completedFrameCount(0)
 {
 	swapChain = VK_NULL_HANDLE;
 	instance = VK_NULL_HANDLE;
@@ -26,15 +31,29 @@ RenderPipeline::~RenderPipeline(void)
 {
 	vkDeviceWaitIdle(device);
 
-	for (size_t i = 0; i < swapChain->GetImageCount(); i++)
+	_completedFrameCount = _submittedFrameCount;
+	RunCompletedReleases();
+
+	_headlessOutput.Release();
+	_readbacks.Release();
+	_renderTextures.Release();
+	_culling.Release();
+
+	for (size_t i = 0; i < inFlightFences.size(); i++)
 	{
-		vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
 		vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
 		vkDestroyFence(device, inFlightFences[i], nullptr);
 	}
+	for (auto semaphore : renderFinishedSemaphores)
+		vkDestroySemaphore(device, semaphore, nullptr);
 
-	vkDestroyBuffer(device, _uniformPerFrame.buffer, nullptr);
-	vkFreeMemory(device, _uniformPerFrame.memory, nullptr);
+	for (auto & uniform : _uniformPerFrame)
+	{
+		vkDestroyBuffer(device, uniform.buffer, nullptr);
+		vkFreeMemory(device, uniform.memory, nullptr);
+	}
+
+	GpuProfiler::Release();
 }
 
 void                RenderPipeline::Initialize(SwapChain * swapChain)
@@ -46,13 +65,39 @@ void                RenderPipeline::Initialize(SwapChain * swapChain)
 	renderPass.Initialize(swapChain);
 	CreateRenderPass();
 
-	// Allocate primary command buffers used for frame rendering
-	this->mainCommandPool->AllocateFrameCommandBuffers(swapChain->GetImageCount());
+	// More frames in flight than images would only wait on the acquire
+	framesInFlight = std::max< size_t >(1, std::min< size_t >(framesInFlight, swapChain->GetImageCount()));
+
+	// The swap chain was created with the present modes of the max throughput mode
+	if (_latencyMode != LatencyMode::MaxThroughput)
+		UpdatePresentModes();
 
-	// Allocate LWGC_PerFrame uniform buffer
-	Vk::CreateBuffer(sizeof(LWGC_PerFrame), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _uniformPerFrame.buffer, _uniformPerFrame.memory);
+	// Allocate primary command buffers used for frame rendering
+	this->mainCommandPool->AllocateFrameCommandBuffers(framesInFlight);
+	this->mainCommandPool->Allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, _frameEndCommandBuffers, framesInFlight);
+	_frameInputTimes.assign(framesInFlight, 0);
+	_frameProfilerIndices.assign(framesInFlight, 0);
+	_slotFrameNumbers.assign(framesInFlight, 0);
+
+	// One set of timestamp queries per frame in flight
+	GpuProfiler::Initialize(framesInFlight);
+	renderGraph.Initialize(framesInFlight);
+	_readbacks.Initialize(framesInFlight);
+	_renderTextures.Initialize(framesInFlight);
+
+	// The swap chain images are read back at the end of each frame
+	if (swapChain->IsHeadless())
+		_headlessOutput.Initialize(&_readbacks, framesInFlight, swapChain->GetExtent().width, swapChain->GetExtent().height, swapChain->GetImageFormat());
+
+	// Allocate LWGC_PerFrame uniform buffers, one per frame in flight so the frames still on the GPU keep their values
+	_uniformPerFrame.resize(framesInFlight);
+	for (size_t i = 0; i < framesInFlight; i++)
+	{
+		Vk::CreateBuffer(sizeof(LWGC_PerFrame), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _uniformPerFrame[i].buffer, _uniformPerFrame[i].memory);
 
-	perFrameSet.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, _uniformPerFrame.buffer, sizeof(LWGC_PerFrame));
+		perFrameSets.push_back(std::make_unique< DescriptorSet >());
+		perFrameSets[i]->AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, _uniformPerFrame[i].buffer, sizeof(LWGC_PerFrame));
+	}
 
 	// InitializeHandles();
 
@@ -69,7 +114,7 @@ void				RenderPipeline::InitializeHandles(void) noexcept
 void				RenderPipeline::CreateRenderPass(void)
 {
 	renderPass.AddAttachment(
-		RenderPass::GetDefaultColorAttachment(swapChain->GetImageFormat()),
+		RenderPass::GetDefaultColorAttachment(swapChain->GetImageFormat(), swapChain->GetFinalLayout()),
 		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	);
 	renderPass.SetDepthAttachment(
@@ -105,10 +150,8 @@ void			RenderPipeline::RenderGUI(RenderContext * context) noexcept
 
 void			RenderPipeline::CreateSyncObjects(void)
 {
-	size_t frameBufferCount = swapChain->GetImageCount();
-	imageAvailableSemaphores.resize(frameBufferCount);
-	renderFinishedSemaphores.resize(frameBufferCount);
-	inFlightFences.resize(frameBufferCount);
+	imageAvailableSemaphores.resize(framesInFlight);
+	inFlightFences.resize(framesInFlight);
 
 	VkSemaphoreCreateInfo semaphoreInfo = {};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -117,29 +160,65 @@ void			RenderPipeline::CreateSyncObjects(void)
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	for (size_t i = 0; i < frameBufferCount; i++)
+	for (size_t i = 0; i < framesInFlight; i++)
 	{
 		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS
-			|| vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS
 			|| vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create synchronization objects for a frame!");
 		}
 	}
 
+	CreateImageSyncObjects();
+
 	printf("Semaphores created !\n");
 }
 
+// The device must be idle, the image count can change when the swap chain is recreated
+void			RenderPipeline::CreateImageSyncObjects(void)
+{
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (auto semaphore : renderFinishedSemaphores)
+		vkDestroySemaphore(device, semaphore, nullptr);
+
+	renderFinishedSemaphores.resize(swapChain->GetImageCount());
+	imagesInFlight.assign(swapChain->GetImageCount(), VK_NULL_HANDLE);
+
+	for (auto & semaphore : renderFinishedSemaphores)
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+			throw std::runtime_error("failed to create synchronization objects for a swap chain image!");
+}
+
+void			RenderPipeline::UpdatePresentModes(void)
+{
+	if (swapChain->IsHeadless())
+		return ;
+
+	// Mailbox never tears and never blocks, immediate presents right away but tears
+	if (_latencyMode == LatencyMode::LowLatency)
+		swapChain->SetPresentModes({VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR});
+	else
+		swapChain->SetPresentModes({VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR});
+	_presentModeChanged = true;
+}
+
 void			RenderPipeline::RecreateSwapChain(void)
 {
 	vkDeviceWaitIdle(device);
 
+	_completedFrameCount = _submittedFrameCount;
+	RunCompletedReleases();
+
 	swapChain->Cleanup();
 	renderPass.Cleanup();
 
 	instance->UpdateSurface();
 	swapChain->Create();
 	CreateRenderPass();
+	if (!imageAvailableSemaphores.empty())
+		CreateImageSyncObjects();
 
 	// Recreate all materials with the new RenderPass
 	MaterialTable::Get()->RecreateAll();
@@ -147,57 +226,132 @@ void			RenderPipeline::RecreateSwapChain(void)
 
 void			RenderPipeline::UpdatePerframeUnformBuffer(void) noexcept
 {
-	_perFrame.time.x = static_cast< float >(glfwGetTime());
+	_perFrame.time.x = Time::GetTime();
 	_perFrame.time.y = sin(_perFrame.time.x);
 	_perFrame.time.z = Time::GetDeltaTime();
 	_perFrame.frameIndex = currentFrame;
+	_perFrame.frameCount = static_cast< uint32_t >(_submittedFrameCount + 1);
 
 	// Upload datas to GPU
-	Vk::UploadToMemory(_uniformPerFrame.memory, &_perFrame, sizeof(LWGC_PerFrame));
+	Vk::UploadToMemory(_uniformPerFrame[currentFrame].memory, &_perFrame, sizeof(LWGC_PerFrame));
+}
+
+void			RenderPipeline::WaitForNextFrame(void)
+{
+	_framePacer.Wait();
+
+	// The frames don't queue: the input is read when the GPU is done with the last one, at the cost of the
+	// CPU and GPU work not overlapping anymore
+	if (_latencyMode == LatencyMode::LowLatency && !inFlightFences.empty())
+	{
+		LWGC_PROFILE_SCOPE("Wait For GPU");
+		size_t lastFrame = (currentFrame + framesInFlight - 1) % framesInFlight;
+
+		vkWaitForFences(device, 1, &inFlightFences[lastFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+}
+
+void			RenderPipeline::ReportLatency(void)
+{
+	static const ProfilerNameId	latencyName = Profiler::InternName("Input To GPU End");
+	static const uint32_t		latencyTrack = Profiler::AddTrack("Input Latency");
+	uint64_t					inputTime = _frameInputTimes[currentFrame];
+	uint64_t					gpuEndTime;
+
+	// The presentation itself can't be timed without a display timing extension, the end of the GPU work
+	// of the frame is the closest point
+	if (inputTime != 0 && GpuProfiler::GetFrameEndTime(currentFrame, GpuProfiler::GraphicsLane, gpuEndTime) && gpuEndTime > inputTime)
+	{
+		_lastLatency = static_cast< float >(gpuEndTime - inputTime) / 1000000.0f;
+		Profiler::AddLateScopes(_frameProfilerIndices[currentFrame], {{inputTime, gpuEndTime, latencyName, 0, latencyTrack}});
+	}
+
+	_frameInputTimes[currentFrame] = _inputTime;
+	_frameProfilerIndices[currentFrame] = Profiler::GetFrameIndex();
 }
 
 bool			RenderPipeline::RenderInternal(const std::vector< Camera * > & cameras, RenderContext * context)
 {
-	UpdatePerframeUnformBuffer();
+	{
+		LWGC_PROFILE_SCOPE("Wait For Frame Slot");
+		vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
 
-	vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	// The last frame that read the buffer of this slot is done
+	UpdatePerframeUnformBuffer();
 
-	// TODO: maybe put this function inside the swapChain class ?
-	VkResult result = vkAcquireNextImageKHR(device, swapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &_imageIndex);
+	// The GPU is done with this frame slot, its timestamps and pixels can be read without waiting
+	_completedFrameCount = std::max(_completedFrameCount, _slotFrameNumbers[currentFrame]);
+	RunCompletedReleases();
+	GpuProfiler::BeginFrame(currentFrame);
+	_readbacks.BeginFrame(currentFrame);
+	_renderTextures.BeginFrame(currentFrame);
+	ReportLatency();
 
-	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	if (swapChain->IsHeadless())
 	{
-		std::cout << "Recreating swapchain !\n";
-		RecreateSwapChain();
-		return false;
+		_headlessOutput.Collect();
+		// Nothing is presented, the images are used in turn
+		_imageIndex = (_imageIndex + 1) % swapChain->GetImageCount();
 	}
-	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	else
 	{
-		throw std::runtime_error("failed to acquire swap chain image!");
+		// TODO: maybe put this function inside the swapChain class ?
+		VkResult result = vkAcquireNextImageKHR(device, swapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &_imageIndex);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			std::cout << "Recreating swapchain !\n";
+			RecreateSwapChain();
+			return false;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("failed to acquire swap chain image!");
+		}
 	}
 
+	// With more images than frames in flight, the image can still be used by the frame of another slot
+	if (imagesInFlight[_imageIndex] != VK_NULL_HANDLE && imagesInFlight[_imageIndex] != inFlightFences[currentFrame])
+		vkWaitForFences(device, 1, &imagesInFlight[_imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	imagesInFlight[_imageIndex] = inFlightFences[currentFrame];
+
 	// reset the current command buffer so that old commands aren't re-executed
 	mainCommandPool->ResetCommandBuffer(currentFrame);
 
 	// each frame we recreate the list of primary command buffers used to render a frame
 	frameCommandBuffers.clear();
 	frameCommandBuffers.push_back(GetCurrentFrameCommandBuffer());
-
-	currentCamera = (cameras.size() == 0) ? nullptr : cameras[0];
+	frameWaitSemaphores.clear();
+	frameWaitStages.clear();
+	frameSignalSemaphores.clear();
 
 	if (cameras.empty())
 		throw std::runtime_error("No camera for rendering !");
 
+	// The cameras with the same priority keep the order of the hierarchy
+	_sortedCameras = cameras;
+	std::stable_sort(_sortedCameras.begin(), _sortedCameras.end(), [](const Camera * a, const Camera * b) { return a->GetPriority() < b->GetPriority(); });
+	currentCamera = _sortedCameras[0];
+
+	_culling.Cull(_sortedCameras, context);
+
 	VkCommandBufferBeginInfo beginInfo = {};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; // humm...
 	Vk::CheckResult(vkBeginCommandBuffer(GetCurrentFrameCommandBuffer(), &beginInfo), "Failed to begin recording of frame command buffer!");
+	GpuProfiler::BeginCommandBuffer(GetCurrentFrameCommandBuffer(), GpuProfiler::GraphicsLane);
 
-	RenderPipelineManager::beginFrameRendering.Invoke();
 	{
-		Render(cameras, context);
+		static const ProfilerNameId	renderName = Profiler::InternName("Render Pipeline");
+		auto sample = ProfilingSample(GetCurrentFrameCommandBuffer(), renderName);
+
+		RenderPipelineManager::beginFrameRendering.Invoke();
+		{
+			Render(_sortedCameras, context);
+		}
+		RenderPipelineManager::endFrameRendering.Invoke();
 	}
-	RenderPipelineManager::endFrameRendering.Invoke();
 
 	Vk::CheckResult(vkEndCommandBuffer(GetCurrentFrameCommandBuffer()), "Failed to record command buffer!");
 
@@ -208,23 +362,59 @@ void	RenderPipeline::PresentFrame(void)
 {
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	bool headless = swapChain->IsHeadless();
 
-	VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
+	// Last command buffer of the frame: the readbacks, and the latency is measured up to its timestamp
+	if (Profiler::IsEnabled() || headless || _readbacks.HasQueuedCopies())
+	{
+		VkCommandBuffer frameEnd = _frameEndCommandBuffers[currentFrame];
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkResetCommandBuffer(frameEnd, 0);
+		Vk::CheckResult(vkBeginCommandBuffer(frameEnd, &beginInfo), "Failed to begin recording of frame end command buffer!");
+		_readbacks.RecordQueuedCopies(frameEnd);
+		if (headless)
+			_headlessOutput.RecordCopy(frameEnd, swapChain->GetImages()[_imageIndex]);
+		if (Profiler::IsEnabled())
+		{
+			GpuProfiler::BeginCommandBuffer(frameEnd, GpuProfiler::GraphicsLane);
+			GpuProfiler::WriteFrameEnd(frameEnd);
+		}
+		Vk::CheckResult(vkEndCommandBuffer(frameEnd), "Failed to record frame end command buffer!");
+		frameCommandBuffers.push_back(frameEnd);
+	}
+
+	if (!headless)
+	{
+		frameWaitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+		frameWaitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		frameSignalSemaphores.push_back(renderFinishedSemaphores[_imageIndex]);
+	}
+	submitInfo.waitSemaphoreCount = frameWaitSemaphores.size();
+	submitInfo.pWaitSemaphores = frameWaitSemaphores.data();
+	submitInfo.pWaitDstStageMask = frameWaitStages.data();
 
 	submitInfo.commandBufferCount = frameCommandBuffers.size();
 	submitInfo.pCommandBuffers = frameCommandBuffers.data();
 
-	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	submitInfo.signalSemaphoreCount = frameSignalSemaphores.size();
+	submitInfo.pSignalSemaphores = frameSignalSemaphores.data();
 
 	Vk::CheckResult(vkResetFences(device, 1, &inFlightFences[currentFrame]), "Reset fence failed");
 
 	Vk::CheckResult(vkQueueSubmit(instance->GetQueue(), 1, &submitInfo, inFlightFences[currentFrame]), "Failed to submit queue");
+	_slotFrameNumbers[currentFrame] = ++_submittedFrameCount;
+
+	// The pixels are delivered once the frame slot comes back
+	if (headless)
+	{
+		currentFrame = (currentFrame + 1) % framesInFlight;
+		return ;
+	}
+
+	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[_imageIndex]};
 
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -240,9 +430,10 @@ void	RenderPipeline::PresentFrame(void)
 
 	VkResult result = vkQueuePresentKHR(instance->GetQueue(), &presentInfo);
 
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized || _presentModeChanged)
 	{
 		framebufferResized = false;
+		_presentModeChanged = false;
 		RecreateSwapChain();
 	}
 	else if (result != VK_SUCCESS)
@@ -250,7 +441,7 @@ void	RenderPipeline::PresentFrame(void)
 		throw std::runtime_error("failed to present swap chain image!");
 	}
 
-	currentFrame = (currentFrame + 1) % swapChain->GetImageCount();
+	currentFrame = (currentFrame + 1) % framesInFlight;
 }
 
 void			RenderPipeline::RecordAllComputeDispatches(RenderPass & pass, RenderContext * context)
@@ -277,33 +468,49 @@ void			RenderPipeline::RecordAllComputeDispatches(RenderPass & pass, RenderConte
 void			RenderPipeline::RecordAllMeshRenderers(RenderPass & pass, RenderContext * context)
 {
 	auto renderQueue = context->GetRenderQueue();
-	VkCommandBuffer cmd = pass.GetCommandBuffer();
 
 	for (uint32_t i = 0; i < renderQueue->GetQueueCount(); i++)
 	{
 		const auto & renderers = renderQueue->GetRenderersForQueue(i);
 
 		for (auto renderer : renderers)
-		{
-			// We only care about mesh renderers
-			if (dynamic_cast< MeshRenderer * >(renderer) == nullptr)
-				continue ;
+			RecordMeshRenderer(pass, renderer);
+	}
+}
+
+void			RenderPipeline::RecordVisibleMeshRenderers(RenderPass & pass, Camera * camera)
+{
+	const VisibilityList * visibility = _culling.GetVisibleRenderers(camera);
 
-			auto material = renderer->GetMaterial();
-			pass.BindMaterial(material);
+	if (visibility == nullptr)
+		throw std::runtime_error("The camera was not culled this frame");
 
-			// TODO: optimize this when doing the renderqueues (sort materials and avoid pipeline switches)
-			material->BindPipeline(cmd);
-			material->BindProperties(cmd);
+	for (const auto & renderers : visibility->queues)
+		for (auto renderer : renderers)
+			RecordMeshRenderer(pass, renderer);
+}
 
-			pass.BindDescriptorSet(LWGCBinding::Object, renderer->GetDescriptorSet());
+void			RenderPipeline::RecordMeshRenderer(RenderPass & pass, Renderer * renderer, bool depthPrepassed)
+{
+	VkCommandBuffer cmd = pass.GetCommandBuffer();
 
-			// We bind / rebind everything we need for the folowing draws
-			pass.UpdateDescriptorBindings();
+	// We only care about mesh renderers
+	if (dynamic_cast< MeshRenderer * >(renderer) == nullptr)
+		return ;
 
-			renderer->RecordCommands(cmd);
-		}
-	}
+	auto material = renderer->GetMaterial();
+	pass.BindMaterial(material);
+
+	// TODO: optimize this when doing the renderqueues (sort materials and avoid pipeline switches)
+	material->BindPipeline(cmd, &pass, depthPrepassed);
+	material->BindProperties(cmd);
+
+	pass.BindDescriptorSet(LWGCBinding::Object, renderer->GetDescriptorSet());
+
+	// We bind / rebind everything we need for the folowing draws
+	pass.UpdateDescriptorBindings();
+
+	renderer->RecordCommands(cmd);
 }
 
 VkCommandBuffer	RenderPipeline::GetCurrentFrameCommandBuffer(void)
@@ -313,12 +520,17 @@ VkCommandBuffer	RenderPipeline::GetCurrentFrameCommandBuffer(void)
 
 VkFramebuffer	RenderPipeline::GetCurrentFrameBuffer(void)
 {
-	return swapChain->GetFramebuffers()[currentFrame];
+	return swapChain->GetFramebuffers()[_imageIndex];
 }
 
 UniformBuffer	RenderPipeline::GetFrameUniformBuffer(void) const
 {
-	return _uniformPerFrame;
+	return _uniformPerFrame[currentFrame];
+}
+
+VkDescriptorSet	RenderPipeline::GetFrameDescriptorSet(void)
+{
+	return perFrameSets[currentFrame]->GetDescriptorSet();
 }
 
 void			RenderPipeline::SetLastRenderPass(const RenderPass & renderPass)
@@ -326,12 +538,82 @@ void			RenderPipeline::SetLastRenderPass(const RenderPass & renderPass)
 	swapChain->CreateFrameBuffers(renderPass);
 }
 
+void			RenderPipeline::ReleaseAfterFrames(std::function< void(void) > release)
+{
+	// Nothing is on the GPU before the first frame
+	if (!_initialized)
+	{
+		release();
+		return ;
+	}
+
+	_pendingReleases.emplace_back(_submittedFrameCount + 1, std::move(release));
+}
+
+void			RenderPipeline::RunCompletedReleases(void) noexcept
+{
+	while (!_pendingReleases.empty() && _pendingReleases.front().first <= _completedFrameCount)
+	{
+		// Moved out first, a release can defer another one
+		auto release = std::move(_pendingReleases.front().second);
+
+		_pendingReleases.pop_front();
+		release();
+	}
+}
+
 void			RenderPipeline::EnqueueFrameCommandBuffer(VkCommandBuffer cmd)
 {
 	frameCommandBuffers.push_back(cmd);
 }
 
+void			RenderPipeline::AddFrameWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags stages)
+{
+	frameWaitSemaphores.push_back(semaphore);
+	frameWaitStages.push_back(stages);
+}
+
+void			RenderPipeline::AddFrameSignalSemaphore(VkSemaphore semaphore)
+{
+	frameSignalSemaphores.push_back(semaphore);
+}
+
 // This must return the render pass compatible with the swapchain (for the final blit)
 RenderPass *	RenderPipeline::GetRenderPass(void) { return &renderPass; }
 Camera *		RenderPipeline::GetCurrentCamera(void) { return currentCamera; }
 bool			RenderPipeline::IsInitialized(void) { return _initialized; }
+size_t			RenderPipeline::GetCurrentFrameIndex(void) const noexcept { return currentFrame; }
+uint32_t		RenderPipeline::GetCurrentImageIndex(void) const noexcept { return _imageIndex; }
+size_t			RenderPipeline::GetFramesInFlight(void) const noexcept { return framesInFlight; }
+uint64_t		RenderPipeline::GetSubmittedFrameCount(void) const noexcept { return _submittedFrameCount; }
+uint64_t		RenderPipeline::GetCompletedFrameCount(void) const noexcept { return _completedFrameCount; }
+LatencyMode		RenderPipeline::GetLatencyMode(void) const noexcept { return _latencyMode; }
+double			RenderPipeline::GetFrameRateLimit(void) const noexcept { return _framePacer.GetFrameRateLimit(); }
+float			RenderPipeline::GetLastLatency(void) const noexcept { return _lastLatency; }
+HeadlessOutput *	RenderPipeline::GetHeadlessOutput(void) noexcept { return &_headlessOutput; }
+ReadbackManager *	RenderPipeline::GetReadbackManager(void) noexcept { return &_readbacks; }
+RenderTexturePool *	RenderPipeline::GetRenderTexturePool(void) noexcept { return &_renderTextures; }
+CameraCulling *		RenderPipeline::GetCameraCulling(void) noexcept { return &_culling; }
+
+void			RenderPipeline::SetFramesInFlight(size_t count)
+{
+	if (_initialized)
+		throw std::runtime_error("The frames in flight can't change once the render pipeline is initialized");
+
+	framesInFlight = count;
+}
+
+void			RenderPipeline::SetLatencyMode(LatencyMode mode) noexcept
+{
+	if (_latencyMode == mode)
+		return ;
+
+	_latencyMode = mode;
+	if (_initialized)
+		UpdatePresentModes();
+}
+
+void			RenderPipeline::SetFrameRateLimit(double framesPerSecond) noexcept
+{
+	_framePacer.SetFrameRateLimit(framesPerSecond);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <array>
+#include <deque>
+#include <functional>
+#include <memory>
 
 #include "RenderTarget.hpp"
 #include "Core/Components/Camera.hpp"
@@ -12,6 +15,12 @@
 #include "Core/Vulkan/CommandBufferPool.hpp"
 #include "Core/Rendering/IRenderQueue.hpp"
 #include "Core/Vulkan/DescriptorSet.hpp"
+#include "Core/Rendering/RenderGraph.hpp"
+#include "Core/Rendering/FramePacer.hpp"
+#include "Core/Rendering/HeadlessOutput.hpp"
+#include "Core/Vulkan/ReadbackManager.hpp"
+#include "Core/Rendering/RenderTexturePool.hpp"
+#include "Core/Rendering/CameraCulling.hpp"
 
 #include IMGUI_INCLUDE
 
@@ -24,6 +33,7 @@ namespace LWGC
 	{
 		glm::vec3	time;
 		uint32_t	frameIndex;
+		uint32_t	frameCount;
 	};
 	
 	class RenderPipeline
@@ -31,22 +41,33 @@ namespace LWGC
 		friend class Application;
 		protected:
 
-			std::vector< VkSemaphore >		imageAvailableSemaphores;
-			std::vector< VkSemaphore >		renderFinishedSemaphores;
-			std::vector< VkFence >			inFlightFences;
+			// The frames in flight don't depend on the swap chain: the per frame objects are indexed by
+			// currentFrame and the ones of the swap chain images by the index of the acquired image
+			std::vector< VkSemaphore >		imageAvailableSemaphores;	// Per frame in flight
+			std::vector< VkSemaphore >		renderFinishedSemaphores;	// Per swap chain image
+			std::vector< VkFence >			inFlightFences;				// Per frame in flight
+			std::vector< VkFence >			imagesInFlight;				// Fence of the last frame that rendered each image
 			VkDevice						device;
 			VulkanInstance *				instance;
 			size_t							currentFrame = 0;
+			size_t							framesInFlight;
 			RenderPass						renderPass;
 			VkFramebuffer					framebuffer;
 			SwapChain *						swapChain;
 			std::vector< VkCommandBuffer >	frameCommandBuffers;
+			// Extra semaphores of the frame submit, cleared each frame
+			std::vector< VkSemaphore >			frameWaitSemaphores;
+			std::vector< VkPipelineStageFlags >	frameWaitStages;
+			std::vector< VkSemaphore >			frameSignalSemaphores;
 			CommandBufferPool *				mainCommandPool;
 			bool							framebufferResized;
 			Camera *						currentCamera;
-			DescriptorSet					perFrameSet;
+			// LWGC_PerFrame buffer and set per frame in flight, written after the wait on the fence of the slot
+			std::vector< std::unique_ptr< DescriptorSet > >	perFrameSets;
+			// Built by the pipeline each frame, derives the barriers between the passes
+			RenderGraph						renderGraph;
 
-			UniformBuffer					_uniformPerFrame;
+			std::vector< UniformBuffer >	_uniformPerFrame;
 
 			void				SetLastRenderPass(const RenderPass & renderPass);
 			VkCommandBuffer		GetCurrentFrameCommandBuffer(void);
@@ -59,11 +80,14 @@ namespace LWGC
 			virtual void		PresentFrame(void);
 			virtual void		Initialize(SwapChain * swapChain);
 			virtual void		CreateSyncObjects(void);
+			void				CreateImageSyncObjects(void);
 			virtual void		RenderGUI(RenderContext * context) noexcept;
 
 			// API to record command on predefined object lists
 			void				RecordAllComputeDispatches(RenderPass & pass, RenderContext * context);
 			void				RecordAllMeshRenderers(RenderPass & pass, RenderContext * context);
+			// Only the renderers in the frustum of the camera, culled at the beginning of the frame
+			void				RecordVisibleMeshRenderers(RenderPass & pass, Camera * camera);
 
 		// The private part is only used as internal render-pipeline setup and should be overwritten by a custom render pipeline
 		private:
@@ -71,11 +95,39 @@ namespace LWGC
 			uint32_t						_imageIndex;
 			bool							_initialized;
 
+			FramePacer						_framePacer;
+			LatencyMode						_latencyMode;
+			bool							_presentModeChanged;
+			std::vector< VkCommandBuffer >	_frameEndCommandBuffers;	// Readbacks, and the timestamp of the end of the frame for the latency
+			uint64_t						_inputTime;					// When the input of the frame was read, set by Application
+			std::vector< uint64_t >			_frameInputTimes;			// Per frame in flight
+			std::vector< uint64_t >			_frameProfilerIndices;
+			float							_lastLatency;
+			HeadlessOutput					_headlessOutput;
+			ReadbackManager					_readbacks;
+			RenderTexturePool				_renderTextures;
+			CameraCulling					_culling;
+			std::vector< Camera * >			_sortedCameras;		// By priority
+			std::vector< uint64_t >			_slotFrameNumbers;	// Number of the last frame submitted in each frame slot
+			uint64_t						_submittedFrameCount;
+			uint64_t						_completedFrameCount;
+			// Released once the frame number is complete, in order
+			std::deque< std::pair< uint64_t, std::function< void(void) > > >	_pendingReleases;
+
+			// Frame limiter, and in low latency the wait for the GPU before the input is read
+			void				WaitForNextFrame(void);
 			bool				RenderInternal(const std::vector< Camera * > & cameras, RenderContext * context);
+			void				ReportLatency(void);
+			void				UpdatePresentModes(void);
 
 			void				UpdatePerframeUnformBuffer(void) noexcept;
+			void				RunCompletedReleases(void) noexcept;
+			// depthPrepassed: the depth of the renderer was drawn before, see Material::BindPipeline
+			void				RecordMeshRenderer(RenderPass & pass, Renderer * renderer, bool depthPrepassed = false);
 
 		public:
+			static const size_t	DefaultFramesInFlight = 2;
+
 			RenderPipeline(void);
 			RenderPipeline(const RenderPipeline & p) = delete;
 			virtual			~RenderPipeline(void);
@@ -85,9 +137,46 @@ namespace LWGC
 			RenderPass *	GetRenderPass(void);
 			Camera *		GetCurrentCamera(void);
 			bool			IsInitialized(void);
+			// LWGC_PerFrame buffer of the current frame in flight, and the set binding it
 			UniformBuffer	GetFrameUniformBuffer(void) const;
+			VkDescriptorSet	GetFrameDescriptorSet(void);
+			// Index of the frame in flight, also exposed to the shaders as frame.frameIndex
+			size_t			GetCurrentFrameIndex(void) const noexcept;
+			// Index of the swap chain image the frame renders to
+			uint32_t		GetCurrentImageIndex(void) const noexcept;
+
+			// Must be called before the pipeline is initialized, it's clamped to the swap chain image count
+			void			SetFramesInFlight(size_t count);
+			size_t			GetFramesInFlight(void) const noexcept;
+			// Changing the mode recreates the swap chain for its present mode
+			void			SetLatencyMode(LatencyMode mode) noexcept;
+			LatencyMode		GetLatencyMode(void) const noexcept;
+			// 0 disables the limiter
+			void			SetFrameRateLimit(double framesPerSecond) noexcept;
+			double			GetFrameRateLimit(void) const noexcept;
+			// Time between the input read and the end of the GPU work of the last measured frame, in milliseconds.
+			// Also shown on the "Input Latency" track of the profiler, only measured while the profiler runs
+			float			GetLastLatency(void) const noexcept;
+			// Receives the frames when the swap chain is headless, it can be configured before the initialization
+			HeadlessOutput *	GetHeadlessOutput(void) noexcept;
+			// Copies of images and buffers read back asynchronously, resolved when the frame slot comes back
+			ReadbackManager *	GetReadbackManager(void) noexcept;
+			// Render textures recycled across the frames, used by the render targets
+			RenderTexturePool *	GetRenderTexturePool(void) noexcept;
+			// Visible renderers of the cameras of the current frame
+			CameraCulling *		GetCameraCulling(void) noexcept;
+
+			// Destroy objects the frames on the GPU may still use: the release runs once the frame being recorded
+			// (the next one between two frames) is complete, when the fence of its frame slot has been waited
+			void			ReleaseAfterFrames(std::function< void(void) > release);
+			// Frames given to the queue, and the ones the GPU is done with
+			uint64_t		GetSubmittedFrameCount(void) const noexcept;
+			uint64_t		GetCompletedFrameCount(void) const noexcept;
 
 			void			EnqueueFrameCommandBuffer(VkCommandBuffer cmd);
+			// Synchronize the frame submit with the work of the other queues
+			void			AddFrameWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags stages);
+			void			AddFrameSignalSemaphore(VkSemaphore semaphore);
 
 			static RenderPipeline *	Get();
 	};
@@ -19,4 +19,14 @@ void		RenderPipelineManager::ReleaseAllPipelines(void)
 {
 	for (auto pipeline : _usedPipelines)
 		delete pipeline;
+	_usedPipelines.clear();
+	currentRenderPipeline = nullptr;
+}
+
+void		RenderPipelineManager::ReleaseAfterFrames(std::function< void(void) > release)
+{
+	if (currentRenderPipeline != nullptr)
+		currentRenderPipeline->ReleaseAfterFrames(std::move(release));
+	else
+		release();
 }
\ No newline at end of file
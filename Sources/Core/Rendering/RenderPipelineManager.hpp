@@ -25,6 +25,8 @@ namespace LWGC
 
 			static void		SetCurrentRenderPipeline(RenderPipeline * newPipeline);
 			static void		ReleaseAllPipelines(void);
+			// RenderPipeline::ReleaseAfterFrames of the current pipeline, the release runs right away without one
+			static void		ReleaseAfterFrames(std::function< void(void) > release);
 
 			static BeginFrameRenderingDelegate		beginFrameRendering;
 			static BeginCameraRenderingDelegate		beginCameraRendering;
@@ -1,73 +1,285 @@
 #include "RenderTarget.hpp"
 
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/Rendering/RenderTexturePool.hpp"
+#include "Core/Rendering/RenderGraph.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/Vk.hpp"
+
 using namespace LWGC;
 
-RenderTarget::RenderTarget(void)
+RenderTarget::RenderTarget(void) : RenderTarget(0, 0)
 {
-	this->_attachmentIds = NULL;
-	this->_name = "Default target";
-	this->_enabledAttachments = 0;
 }
 
-RenderTarget::RenderTarget(RenderTarget const & src)
+RenderTarget::RenderTarget(uint32_t width, uint32_t height, VkSampleCountFlagBits samples, uint32_t viewCount) : _name("Render Target"),
+	_width(width), _height(height), _samples(samples), _viewCount(viewCount), _depthAttachment{nullptr, false, 0}, _pool(nullptr),
+	_renderPass(std::make_unique< RenderPass >()), _framebuffer(VK_NULL_HANDLE), _clearColor(Color::Black), _clearDepth(0.0f), _dirty(true)
 {
-	*this = src;
+	_colorAttachments.fill({nullptr, false, 0});
 }
 
 RenderTarget::~RenderTarget(void)
 {
+	DestroyFramebuffer();
+
+	for (auto & attachment : _colorAttachments)
+		ReleaseAttachment(attachment);
+	ReleaseAttachment(_depthAttachment);
+}
+
+RenderTarget::Attachment &	RenderTarget::GetSlot(FramebufferAttachment fba)
+{
+	if (fba <= FramebufferAttachment::Color9)
+		return _colorAttachments[static_cast< size_t >(fba)];
+	return _depthAttachment;
 }
 
-void		RenderTarget::AddAttachment(const FramebufferAttachment fba)
+const RenderTarget::Attachment &	RenderTarget::GetSlot(FramebufferAttachment fba) const
 {
-	(void)fba;
+	if (fba <= FramebufferAttachment::Color9)
+		return _colorAttachments[static_cast< size_t >(fba)];
+	return _depthAttachment;
 }
 
-void		RenderTarget::AddAttachment(const FramebufferAttachment fba, GLuint attachmentId)
+static VkFormat	GetDefaultFormat(FramebufferAttachment fba)
 {
-	(void)fba, (void)attachmentId;
+	VulkanInstance *	instance = VulkanInstance::Get();
+
+	switch (fba)
+	{
+		case FramebufferAttachment::Depht16:
+			return VK_FORMAT_D16_UNORM;
+		case FramebufferAttachment::Depht24:
+			return instance->FindSupportedFormat({VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D32_SFLOAT}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		case FramebufferAttachment::Depht32:
+			return VK_FORMAT_D32_SFLOAT;
+		case FramebufferAttachment::Stencil:
+		case FramebufferAttachment::DepthStencil:
+			return instance->FindSupportedFormat({VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		default:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+void		RenderTarget::AcquireAttachment(Attachment & attachment, VkFormat format)
+{
+	RenderTextureDescriptor	descriptor;
+
+	if (_pool == nullptr)
+		_pool = RenderPipelineManager::currentRenderPipeline->GetRenderTexturePool();
+
+	descriptor.width = _width;
+	descriptor.height = _height;
+	descriptor.format = format;
+	descriptor.samples = _samples;
+	descriptor.layers = _viewCount;
+	descriptor.usage = attachment.usage;
+
+	attachment.texture = _pool->Acquire(descriptor);
+	attachment.pooled = true;
+	attachment.texture->SetName(_name);
+}
+
+void		RenderTarget::ReleaseAttachment(Attachment & attachment)
+{
+	// The frames in flight can still use it, the pool only recycles it once they are done
+	if (attachment.pooled)
+		_pool->Release(attachment.texture);
+
+	attachment = {nullptr, false, 0};
+}
+
+void		RenderTarget::AddAttachment(const FramebufferAttachment fba, VkFormat format, VkImageUsageFlags usage)
+{
+	Attachment &	attachment = GetSlot(fba);
+
+	ReleaseAttachment(attachment);
+	attachment.usage = usage;
+	AcquireAttachment(attachment, (format == VK_FORMAT_UNDEFINED) ? GetDefaultFormat(fba) : format);
+	_dirty = true;
+}
+
+void		RenderTarget::AddAttachment(const FramebufferAttachment fba, Texture * texture)
+{
+	Attachment &	attachment = GetSlot(fba);
+
+	if (attachment.texture == texture)
+		return ;
+
+	ReleaseAttachment(attachment);
+	attachment.texture = texture;
+	_dirty = true;
 }
 
 void		RenderTarget::RemoveAttachment(const FramebufferAttachment fba)
 {
-	(void)fba;
+	Attachment &	attachment = GetSlot(fba);
+
+	if (attachment.texture == nullptr)
+		return ;
+
+	ReleaseAttachment(attachment);
+	_dirty = true;
 }
 
-void		RenderTarget::Update(void)
+void		RenderTarget::Resize(uint32_t width, uint32_t height)
+{
+	if (width == _width && height == _height)
+		return ;
+
+	_width = width;
+	_height = height;
+
+	auto resize = [&](Attachment & attachment)
+	{
+		if (!attachment.pooled)
+			return ;
+
+		VkFormat			format = attachment.texture->GetFormat();
+		VkImageUsageFlags	usage = attachment.usage;
+
+		ReleaseAttachment(attachment);
+		attachment.usage = usage;
+		AcquireAttachment(attachment, format);
+	};
+
+	for (auto & attachment : _colorAttachments)
+		resize(attachment);
+	resize(_depthAttachment);
+	_dirty = true;
+}
+
+void		RenderTarget::DestroyFramebuffer(void)
 {
-	
+	if (_framebuffer == VK_NULL_HANDLE)
+		return ;
+
+	VkDevice		device = VulkanInstance::Get()->GetDevice();
+	VkFramebuffer	framebuffer = _framebuffer;
+	RenderPass *	renderPass = _renderPass.release();
+
+	// The frames in flight can still use them, they are destroyed once these frames are done
+	_renderPass = std::make_unique< RenderPass >();
+	RenderPipelineManager::ReleaseAfterFrames([device, framebuffer, renderPass]()
+	{
+		vkDestroyFramebuffer(device, framebuffer, nullptr);
+		delete renderPass;
+	});
+	_framebuffer = VK_NULL_HANDLE;
 }
 
-RenderTarget &	RenderTarget::operator=(RenderTarget const & src)
+void		RenderTarget::CreateFramebuffer(void)
 {
-	if (this != &src) {
-		this->_framebuffer = src.GetFramebuffer();
-		this->_attachmentIds = src.GetAttachmentIds();
-		this->_name = src.GetName();
-		this->_size = src.GetSize();
-		this->_enabledAttachments = src.GetEnabledAttachments();
+	std::vector< VkImageView >	views;
+	VkDevice					device = VulkanInstance::Get()->GetDevice();
+
+	_renderPass->Initialize(nullptr);
+	_renderPass->SetViewCount(_viewCount);
+
+	// The render pass clears the attachments, the layouts are the ones the render graph transitions them to
+	for (const auto & attachment : _colorAttachments)
+	{
+		if (attachment.texture == nullptr)
+			continue ;
+
+		auto description = RenderPass::GetDefaultColorAttachment(
+			attachment.texture->GetFormat(),
+			RenderGraph::GetAccessLayout(RenderGraphAccess::ColorAttachment),
+			attachment.texture->GetSamples()
+		);
+		_renderPass->AddAttachment(description, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		views.push_back(attachment.texture->GetView());
 	}
-	return (*this);
+
+	if (_depthAttachment.texture != nullptr)
+	{
+		auto description = RenderPass::GetDefaultDepthAttachment(_depthAttachment.texture->GetFormat(), _depthAttachment.texture->GetSamples());
+
+		// The depth of a target is kept, shadow maps are sampled after
+		description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		if (Vk::HasStencilComponent(_depthAttachment.texture->GetFormat()))
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		description.finalLayout = RenderGraph::GetAccessLayout(RenderGraphAccess::DepthStencilAttachment);
+		_renderPass->SetDepthAttachment(description, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		views.push_back(_depthAttachment.texture->GetView());
+	}
+
+	_renderPass->SetClearColor(_clearColor, _clearDepth, 0);
+	_renderPass->Create();
+	Vk::SetRenderPassDebugName(_name, _renderPass->GetRenderPass());
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = _renderPass->GetRenderPass();
+	framebufferInfo.attachmentCount = static_cast< uint32_t >(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = _width;
+	framebufferInfo.height = _height;
+	// The views of a multiview pass are the layers of the attachments, the framebuffer itself has one
+	framebufferInfo.layers = 1;
+
+	Vk::CheckResult(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &_framebuffer), "Failed to create render target framebuffer");
+	Vk::SetFramebufferDebugName(_name, _framebuffer);
 }
 
-GLuint		RenderTarget::GetFramebuffer(void) const { return (this->_framebuffer); }
-void		RenderTarget::SetFramebuffer(GLuint tmp) { this->_framebuffer = tmp; }
+void		RenderTarget::Update(void)
+{
+	if (!_dirty)
+		return ;
 
-GLuint *		RenderTarget::GetAttachmentIds(void) const { return (this->_attachmentIds); }
-void		RenderTarget::SetAttachmentIds(GLuint * tmp) { this->_attachmentIds = tmp; }
+	std::vector< Texture * >	attachments = GetColorAttachments();
 
-std::string		RenderTarget::GetName(void) const { return (this->_name); }
-void		RenderTarget::SetName(std::string tmp) { this->_name = tmp; }
+	if (_depthAttachment.texture != nullptr)
+		attachments.push_back(_depthAttachment.texture);
+
+	if (attachments.empty())
+		throw std::runtime_error("Render target " + _name + " has no attachment");
+
+	for (const auto texture : attachments)
+		if (static_cast< uint32_t >(texture->GetWidth()) != _width || static_cast< uint32_t >(texture->GetHeight()) != _height
+			|| texture->GetSamples() != _samples || static_cast< uint32_t >(texture->GetArraySize()) != _viewCount)
+			throw std::runtime_error("The attachments of the render target " + _name + " don't have its size, sample count or view count");
+
+	DestroyFramebuffer();
+	CreateFramebuffer();
+	_dirty = false;
+}
+
+Texture *		RenderTarget::GetAttachment(const FramebufferAttachment fba) const { return GetSlot(fba).texture; }
+Texture *		RenderTarget::GetDepthAttachment(void) const { return _depthAttachment.texture; }
+
+std::vector< Texture * >	RenderTarget::GetColorAttachments(void) const
+{
+	std::vector< Texture * >	textures;
 
-glm::vec2		RenderTarget::GetSize(void) const { return (this->_size); }
-void		RenderTarget::SetSize(glm::vec2 tmp) { this->_size = tmp; }
+	for (const auto & attachment : _colorAttachments)
+		if (attachment.texture != nullptr)
+			textures.push_back(attachment.texture);
+
+	return textures;
+}
+
+void			RenderTarget::SetClearColor(const Color & color, float depth)
+{
+	_clearColor = color;
+	_clearDepth = depth;
+	_renderPass->SetClearColor(color, depth, 0);
+}
+
+RenderPass *	RenderTarget::GetRenderPass(void) noexcept { return _renderPass.get(); }
+VkFramebuffer	RenderTarget::GetFramebuffer(void) const noexcept { return _framebuffer; }
+VkExtent2D		RenderTarget::GetExtent(void) const noexcept { return {_width, _height}; }
+VkSampleCountFlagBits	RenderTarget::GetSamples(void) const noexcept { return _samples; }
+uint32_t		RenderTarget::GetViewCount(void) const noexcept { return _viewCount; }
+
+std::string		RenderTarget::GetName(void) const { return (this->_name); }
+void			RenderTarget::SetName(const std::string & name) { this->_name = name; }
 
-int		RenderTarget::GetEnabledAttachments(void) const { return (this->_enabledAttachments); }
-void		RenderTarget::SetEnabledAttachments(int tmp) { this->_enabledAttachments = tmp; }
+glm::vec2		RenderTarget::GetSize(void) const { return glm::vec2(_width, _height); }
 
-std::ostream &	operator<<(std::ostream & o, RenderTarget const & r)
+std::ostream &	LWGC::operator<<(std::ostream & o, RenderTarget const & r)
 {
-	o << r.GetName() << std::endl;
-	(void)r;
+	o << "RenderTarget " << r.GetName() << ": " << r.GetSize().x << "x" << r.GetSize().y << std::endl;
 	return (o);
 }
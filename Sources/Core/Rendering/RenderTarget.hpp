@@ -2,55 +2,100 @@
 
 #include <iostream>
 #include <string>
+#include <array>
+#include <vector>
+#include <memory>
 
 #include "IncludeDeps.hpp"
 
 #include "FramebufferAttachment.hpp"
+#include "Core/Textures/Texture.hpp"
+#include "Core/Vulkan/RenderPass.hpp"
+#include "Utils/Color.hpp"
 
-#include GLFW_INCLUDE
+#include VULKAN_INCLUDE
 #include GLM_INCLUDE
 
 namespace LWGC
 {
+	class RenderTexturePool;
+
+	// Framebuffer made of texture attachments that cameras can render into. The attachments added with a
+	// format come from the render texture pool of the pipeline, the render pass and the framebuffer are only
+	// created again when the attachments change, not each frame. The attachments end in the attachment
+	// layouts (RenderGraph::GetAccessLayout), the passes that sample them declare it to the render graph.
+	// A target with several views has Texture2DArray attachments with one layer per view, all rendered by
+	// the same multiview render pass.
 	class		RenderTarget
 	{
+		public:
+			static const size_t	MaxColorAttachments = 10;
+
 		private:
-			// TODO: not really vulkan complient
-			GLuint		_framebuffer;
-			GLuint *	_attachmentIds;
-			std::string	_name;
-			glm::vec2	_size;
-			int			_enabledAttachments;
+			struct	Attachment
+			{
+				Texture *			texture;
+				bool				pooled;		// Acquired from the pool, otherwise not owned by the target
+				VkImageUsageFlags	usage;
+			};
+
+			std::string										_name;
+			uint32_t										_width;
+			uint32_t										_height;
+			VkSampleCountFlagBits							_samples;
+			uint32_t										_viewCount;
+			std::array< Attachment, MaxColorAttachments >	_colorAttachments;
+			Attachment										_depthAttachment;
+			RenderTexturePool *								_pool;
+			std::unique_ptr< RenderPass >					_renderPass;	// Replaced when the attachments change, the old one is retired with the frames
+			VkFramebuffer									_framebuffer;
+			Color											_clearColor;
+			float											_clearDepth;
+			bool											_dirty;
+
+			Attachment &	GetSlot(FramebufferAttachment fba);
+			const Attachment &	GetSlot(FramebufferAttachment fba) const;
+			void			AcquireAttachment(Attachment & attachment, VkFormat format);
+			void			ReleaseAttachment(Attachment & attachment);
+			void			DestroyFramebuffer(void);
+			void			CreateFramebuffer(void);
 
 		public:
 			RenderTarget(void);
-			RenderTarget(const RenderTarget&);
+			RenderTarget(uint32_t width, uint32_t height, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT, uint32_t viewCount = 1);
+			RenderTarget(const RenderTarget &) = delete;
+			// Must be destroyed before the render pipeline, the pooled attachments go back to its pool
 			virtual		~RenderTarget(void);
 
-			RenderTarget &	operator=(RenderTarget const & src);
-
-			void		AddAttachment(const FramebufferAttachment fba);
-
-			void		AddAttachment(const FramebufferAttachment fba, GLuint attachmentId);
+			RenderTarget &	operator=(RenderTarget const & src) = delete;
 
+			// Attachment acquired from the render texture pool, without format it's deduced from fba:
+			// RGBA8 for the colors and a depth format of the size requested for the depth ones
+			void		AddAttachment(const FramebufferAttachment fba, VkFormat format = VK_FORMAT_UNDEFINED, VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT);
+			// The texture is not owned by the target, it must have its size, sample count and a layer per view
+			void		AddAttachment(const FramebufferAttachment fba, Texture * texture);
 			void		RemoveAttachment(const FramebufferAttachment fba);
+			// The pooled attachments are acquired again with the new size, the other ones must be replaced
+			void		Resize(uint32_t width, uint32_t height);
 
+			// Creates the render pass and the framebuffer if the attachments changed, called before rendering
 			void		Update(void);
 
-			GLuint		GetFramebuffer(void) const;
-			void		SetFramebuffer(GLuint tmp);
-			
-			GLuint *	GetAttachmentIds(void) const;
-			void		SetAttachmentIds(GLuint * tmp);
-			
+			Texture *					GetAttachment(const FramebufferAttachment fba) const;
+			std::vector< Texture * >	GetColorAttachments(void) const;
+			Texture *					GetDepthAttachment(void) const;
+
+			RenderPass *	GetRenderPass(void) noexcept;
+			VkFramebuffer	GetFramebuffer(void) const noexcept;
+			VkExtent2D		GetExtent(void) const noexcept;
+			VkSampleCountFlagBits	GetSamples(void) const noexcept;
+			uint32_t		GetViewCount(void) const noexcept;
+			void			SetClearColor(const Color & color, float depth = 0.0f);
+
 			std::string	GetName(void) const;
-			void		SetName(std::string tmp);
-			
+			void		SetName(const std::string & name);
+
 			glm::vec2	GetSize(void) const;
-			void		SetSize(glm::vec2 tmp);
-			
-			int			GetEnabledAttachments(void) const;
-			void		SetEnabledAttachments(int tmp);
 	};
 
 	std::ostream &	operator<<(std::ostream & o, RenderTarget const & r);
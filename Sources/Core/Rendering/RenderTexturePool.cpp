@@ -0,0 +1,224 @@
+#include "RenderTexturePool.hpp"
+
+#include "Core/Application.hpp"
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+
+#include <algorithm>
+
+using namespace LWGC;
+
+static void		HashCombine(size_t & hash, size_t value) noexcept
+{
+	hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+bool		RenderTextureDescriptor::operator==(const RenderTextureDescriptor & rhs) const noexcept
+{
+	return width == rhs.width && height == rhs.height && format == rhs.format && samples == rhs.samples && layers == rhs.layers && usage == rhs.usage;
+}
+
+bool		RenderTextureDescriptor::operator!=(const RenderTextureDescriptor & rhs) const noexcept { return !(*this == rhs); }
+
+size_t		RenderTextureDescriptorHash::operator()(const RenderTextureDescriptor & descriptor) const noexcept
+{
+	size_t	hash = descriptor.width;
+
+	HashCombine(hash, descriptor.height);
+	HashCombine(hash, static_cast< size_t >(descriptor.format));
+	HashCombine(hash, static_cast< size_t >(descriptor.samples));
+	HashCombine(hash, descriptor.layers);
+	HashCombine(hash, descriptor.usage);
+	return hash;
+}
+
+RenderTexturePool::RenderTexturePool(void) : _frameIndex(0), _frameCount(0), _allocationCount(0)
+{
+}
+
+RenderTexturePool::~RenderTexturePool(void)
+{
+	Release();
+}
+
+void			RenderTexturePool::Initialize(size_t frameCount)
+{
+	_pending.resize(frameCount);
+	_frameIndex = 0;
+}
+
+void			RenderTexturePool::Release(void) noexcept
+{
+	if (_pending.empty())
+		return ;
+
+	vkDeviceWaitIdle(VulkanInstance::Get()->GetDevice());
+
+	for (auto & textures : _pending)
+		for (auto & pooled : textures)
+			DestroyTexture(pooled.texture);
+	_pending.clear();
+
+	for (auto & textures : _free)
+		for (auto & pooled : textures.second)
+			DestroyTexture(pooled.texture);
+	_free.clear();
+
+	for (auto & acquired : _acquired)
+		DestroyTexture(acquired.first);
+	_acquired.clear();
+}
+
+bool			RenderTexturePool::IsInitialized(void) const noexcept { return !_pending.empty(); }
+
+VkImageUsageFlags	RenderTexturePool::GetAttachmentUsage(VkFormat format) noexcept
+{
+	if (Vk::GetImageAspect(format) & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+		return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+}
+
+Texture *		RenderTexturePool::CreateTexture(const RenderTextureDescriptor & descriptor)
+{
+	Texture *			texture;
+	VkImageUsageFlags	usage = descriptor.usage | GetAttachmentUsage(descriptor.format);
+
+	if (descriptor.layers > 1)
+	{
+		if (descriptor.samples != VK_SAMPLE_COUNT_1_BIT)
+			throw std::runtime_error("Multisampled render texture arrays are not supported");
+		texture = Texture2DArray::Create(descriptor.width, descriptor.height, descriptor.layers, descriptor.format, usage);
+	}
+	else
+		texture = Texture2D::Create(descriptor.width, descriptor.height, descriptor.format, usage, false, descriptor.samples);
+
+	// The pool owns its textures, they are not destroyed with the other ones of the application
+	Application::Get()->GetTextureTable()->UnregisterObject(texture);
+	_allocationCount++;
+
+	return texture;
+}
+
+void			RenderTexturePool::DestroyTexture(Texture * texture) noexcept
+{
+	delete texture;
+}
+
+Texture *		RenderTexturePool::Acquire(const RenderTextureDescriptor & descriptor)
+{
+	if (!IsInitialized())
+		throw std::runtime_error("The render texture pool must be initialized before acquiring textures");
+	if (descriptor.width == 0 || descriptor.height == 0 || descriptor.layers == 0 || descriptor.format == VK_FORMAT_UNDEFINED)
+		throw std::runtime_error("Invalid render texture descriptor");
+
+	Texture *	texture;
+	auto		free = _free.find(descriptor);
+
+	// The most recently used texture is taken first, the others can reach the unused limit
+	if (free != _free.end() && !free->second.empty())
+	{
+		texture = free->second.back().texture;
+		free->second.pop_back();
+	}
+	else
+		texture = CreateTexture(descriptor);
+
+	_acquired[texture] = descriptor;
+	return texture;
+}
+
+void			RenderTexturePool::Release(Texture * texture)
+{
+	if (texture == nullptr)
+		return ;
+
+	// Textures given back after the pool was released are already destroyed
+	if (!IsInitialized())
+		return ;
+
+	auto acquired = _acquired.find(texture);
+	if (acquired == _acquired.end())
+		throw std::runtime_error("The texture was not acquired from the render texture pool");
+
+	_pending[_frameIndex].push_back({texture, acquired->second, 0});
+	_acquired.erase(acquired);
+}
+
+bool			RenderTexturePool::TryRelease(Texture * texture) noexcept
+{
+	if (texture == nullptr || !IsInitialized())
+		return false;
+
+	auto acquired = _acquired.find(texture);
+	if (acquired == _acquired.end())
+		return false;
+
+	try {
+		_pending[_frameIndex].push_back({texture, acquired->second, 0});
+	} catch (const std::bad_alloc &) {
+		// Still acquired, it's destroyed with the pool
+		return false;
+	}
+	_acquired.erase(acquired);
+	return true;
+}
+
+void			RenderTexturePool::BeginFrame(size_t frameIndex)
+{
+	if (!IsInitialized())
+		return ;
+
+	_frameIndex = frameIndex;
+	_frameCount++;
+
+	for (auto & pooled : _pending[_frameIndex])
+	{
+		pooled.lastUsedFrame = _frameCount;
+		_free[pooled.descriptor].push_back(pooled);
+	}
+	_pending[_frameIndex].clear();
+
+	TrimFreeTextures();
+}
+
+// Render textures of a size that isn't used anymore (window resized, target removed) don't stay allocated
+void			RenderTexturePool::TrimFreeTextures(void) noexcept
+{
+	for (auto it = _free.begin(); it != _free.end();)
+	{
+		auto	unused = std::remove_if(it->second.begin(), it->second.end(), [this](PooledTexture & pooled)
+		{
+			if (_frameCount - pooled.lastUsedFrame <= MaxUnusedFrames)
+				return false;
+			DestroyTexture(pooled.texture);
+			return true;
+		});
+		it->second.erase(unused, it->second.end());
+
+		if (it->second.empty())
+			it = _free.erase(it);
+		else
+			++it;
+	}
+}
+
+size_t			RenderTexturePool::GetAcquiredCount(void) const noexcept { return _acquired.size(); }
+size_t			RenderTexturePool::GetAllocationCount(void) const noexcept { return _allocationCount; }
+
+size_t			RenderTexturePool::GetFreeCount(void) const noexcept
+{
+	size_t	count = 0;
+
+	for (const auto & textures : _free)
+		count += textures.second.size();
+	for (const auto & textures : _pending)
+		count += textures.size();
+
+	return count;
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, RenderTexturePool const & r)
+{
+	o << "RenderTexturePool: " << r.GetAcquiredCount() << " acquired, " << r.GetFreeCount() << " free, " << r.GetAllocationCount() << " allocated" << std::endl;
+	return (o);
+}
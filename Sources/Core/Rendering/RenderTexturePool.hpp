@@ -0,0 +1,99 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/Texture2D.hpp"
+#include "Core/Textures/Texture2DArray.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	struct	RenderTextureDescriptor
+	{
+		uint32_t				width = 0;
+		uint32_t				height = 0;
+		VkFormat				format = VK_FORMAT_UNDEFINED;
+		VkSampleCountFlagBits	samples = VK_SAMPLE_COUNT_1_BIT;
+		// More than one layer allocates a Texture2DArray, for the multiview passes
+		uint32_t				layers = 1;
+		// The attachment usage is added from the format
+		VkImageUsageFlags		usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+
+		bool	operator==(const RenderTextureDescriptor & rhs) const noexcept;
+		bool	operator!=(const RenderTextureDescriptor & rhs) const noexcept;
+	};
+
+	struct	RenderTextureDescriptorHash
+	{
+		size_t	operator()(const RenderTextureDescriptor & descriptor) const noexcept;
+	};
+
+	// Textures rendered by the GPU, recycled instead of being allocated each time a pass needs one. A released
+	// texture can be used by the frames still in flight: it's only given back to Acquire when the fence of the
+	// frame slot it was released in is signaled. Free textures that weren't used for a while are destroyed.
+	class		RenderTexturePool
+	{
+		private:
+			struct	PooledTexture
+			{
+				Texture *				texture;
+				RenderTextureDescriptor	descriptor;
+				uint64_t				lastUsedFrame;
+			};
+
+			using FreeTextures = std::unordered_map< RenderTextureDescriptor, std::vector< PooledTexture >, RenderTextureDescriptorHash >;
+
+			FreeTextures												_free;
+			std::unordered_map< Texture *, RenderTextureDescriptor >	_acquired;
+			std::vector< std::vector< PooledTexture > >					_pending;	// Per frame in flight, released during the frame
+			size_t														_frameIndex;
+			uint64_t													_frameCount;
+			size_t														_allocationCount;
+
+			Texture *		CreateTexture(const RenderTextureDescriptor & descriptor);
+			void			DestroyTexture(Texture * texture) noexcept;
+			void			TrimFreeTextures(void) noexcept;
+
+		public:
+			// Free textures that weren't used for this many frames are destroyed
+			static const uint64_t	MaxUnusedFrames = 120;
+
+			RenderTexturePool(void);
+			RenderTexturePool(const RenderTexturePool &) = delete;
+			virtual ~RenderTexturePool(void);
+
+			RenderTexturePool &	operator=(RenderTexturePool const & src) = delete;
+
+			void		Initialize(size_t frameCount);
+			// Waits for the device and destroys all the textures, the acquired ones included
+			void		Release(void) noexcept;
+			bool		IsInitialized(void) const noexcept;
+
+			// The content of the texture is undefined, and its layout is the one it was released with
+			Texture *	Acquire(const RenderTextureDescriptor & descriptor);
+			// The texture can still be used in the commands of the current frame
+			void		Release(Texture * texture);
+			// Same as Release for the teardown paths: textures the pool doesn't know (destroyed with the pool, or
+			// acquired before a re-initialization) are ignored, returns false for them
+			bool		TryRelease(Texture * texture) noexcept;
+
+			// The fence of the frame slot is signaled: the textures released in it can be acquired again
+			void		BeginFrame(size_t frameIndex);
+
+			size_t		GetAcquiredCount(void) const noexcept;
+			size_t		GetFreeCount(void) const noexcept;
+			// Number of textures created since the initialization
+			size_t		GetAllocationCount(void) const noexcept;
+
+			// Usage needed to render into a texture of this format, depth stencil or color attachment
+			static VkImageUsageFlags	GetAttachmentUsage(VkFormat format) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, RenderTexturePool const & r);
+}
@@ -0,0 +1,141 @@
+#include "ShadowCascades.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace LWGC;
+
+ShadowCascades::ShadowCascades(void) : _cascadeCount(MaxCascades), _shadowDistance(150.0f), _splitLambda(0.8f),
+	_casterDistance(200.0f), _resolution(1024)
+{
+}
+
+glm::mat4		ShadowCascades::GetLightView(const glm::vec3 & lightDirection)
+{
+	glm::vec3	forward = glm::normalize(lightDirection);
+	glm::vec3	reference = (std::abs(forward.y) > 0.99f) ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+	glm::vec3	right = glm::normalize(glm::cross(reference, forward));
+	glm::vec3	up = glm::cross(forward, right);
+	glm::mat4	view(1.0f);
+
+	// The rows are the axes of the light space, glm matrices are indexed by column
+	for (int i = 0; i < 3; i++)
+	{
+		view[i][0] = right[i];
+		view[i][1] = up[i];
+		view[i][2] = forward[i];
+	}
+
+	return view;
+}
+
+// Mix of the uniform and the logarithmic splits
+float			ShadowCascades::GetSplitDepth(float nearPlane, float shadowDistance, float lambda, uint32_t split, uint32_t cascadeCount) noexcept
+{
+	float	t = static_cast< float >(split) / static_cast< float >(cascadeCount);
+	float	logarithmic = nearPlane * std::pow(shadowDistance / nearPlane, t);
+	float	uniform = nearPlane + (shadowDistance - nearPlane) * t;
+
+	return lambda * logarithmic + (1.0f - lambda) * uniform;
+}
+
+void			ShadowCascades::Fit(const glm::mat4 & cameraToWorld, const glm::vec2 & tanHalfFov, float nearPlane, const glm::vec3 & lightDirection, float padding)
+{
+	glm::mat4	lightView = GetLightView(lightDirection);
+	float		cornerScale = glm::dot(tanHalfFov, tanHalfFov);	// Squared distance to the axis of a corner at the depth 1
+	float		shadowDistance = std::max(_shadowDistance, nearPlane * 2.0f);
+	uint32_t	guardTexels = _resolution / GuardDivisor;
+
+	_cascades.resize(_cascadeCount);
+	for (uint32_t i = 0; i < _cascadeCount; i++)
+	{
+		ShadowCascade &	cascade = _cascades[i];
+		float			sliceNear = GetSplitDepth(nearPlane, shadowDistance, _splitLambda, i, _cascadeCount);
+		float			sliceFar = GetSplitDepth(nearPlane, shadowDistance, _splitLambda, i + 1, _cascadeCount);
+
+		// The center is on the axis, at the same distance of the near and the far corners, but not past the far plane
+		float	center = std::min((sliceNear + sliceFar) * 0.5f * (1.0f + cornerScale), sliceFar);
+		float	farOffset = sliceFar - center;
+		float	nearOffset = center - sliceNear;
+		float	radius = std::sqrt(std::max(farOffset * farOffset + sliceFar * sliceFar * cornerScale, nearOffset * nearOffset + sliceNear * sliceNear * cornerScale)) + padding;
+
+		// The sphere fits in the cascade wherever the center is snapped, the step is a whole number of texels
+		float	halfSize = radius * static_cast< float >(_resolution) / static_cast< float >(_resolution - guardTexels);
+		float	texelSize = halfSize * 2.0f / static_cast< float >(_resolution);
+		float	step = texelSize * static_cast< float >(guardTexels);
+
+		glm::vec3	centerWS = glm::vec3(cameraToWorld * glm::vec4(0, 0, center, 1));
+		glm::vec3	centerLS = glm::vec3(lightView * glm::vec4(centerWS, 1));
+
+		centerLS = glm::floor(centerLS / step + 0.5f) * step;
+
+		float		zNear = centerLS.z - halfSize - _casterDistance;
+		float		zFar = centerLS.z + halfSize;
+		glm::mat4	projection(1.0f);
+
+		// Orthographic projection of the cascade box, Vulkan clip space with the depth from 0 to 1
+		projection[0][0] = 1.0f / halfSize;
+		projection[1][1] = 1.0f / halfSize;
+		projection[2][2] = 1.0f / (zFar - zNear);
+		projection[3][0] = -centerLS.x / halfSize;
+		projection[3][1] = -centerLS.y / halfSize;
+		projection[3][2] = -zNear / (zFar - zNear);
+
+		cascade.viewProjection = projection * lightView;
+		cascade.sphere = glm::vec4(centerWS, radius);
+		cascade.splitDepth = sliceFar;
+		cascade.texelSize = texelSize;
+	}
+}
+
+const std::vector< ShadowCascade > &	ShadowCascades::GetCascades(void) const noexcept { return _cascades; }
+
+uint32_t	ShadowCascades::GetCascadeCount(void) const noexcept { return _cascadeCount; }
+
+void		ShadowCascades::SetCascadeCount(uint32_t count)
+{
+	if (count == 0 || count > MaxCascades)
+		throw std::runtime_error("The cascade count must be between 1 and " + std::to_string(MaxCascades));
+
+	_cascadeCount = count;
+}
+
+float		ShadowCascades::GetShadowDistance(void) const noexcept { return _shadowDistance; }
+
+void		ShadowCascades::SetShadowDistance(float distance)
+{
+	if (distance <= 0.0f)
+		throw std::runtime_error("The shadow distance must be positive");
+
+	_shadowDistance = distance;
+}
+
+float		ShadowCascades::GetSplitLambda(void) const noexcept { return _splitLambda; }
+void		ShadowCascades::SetSplitLambda(float lambda) { _splitLambda = std::clamp(lambda, 0.0f, 1.0f); }
+
+float		ShadowCascades::GetCasterDistance(void) const noexcept { return _casterDistance; }
+
+void		ShadowCascades::SetCasterDistance(float distance)
+{
+	if (distance < 0.0f)
+		throw std::runtime_error("The shadow caster distance can't be negative");
+
+	_casterDistance = distance;
+}
+
+uint32_t	ShadowCascades::GetResolution(void) const noexcept { return _resolution; }
+
+void		ShadowCascades::SetResolution(uint32_t resolution)
+{
+	if (resolution < GuardDivisor * 2)
+		throw std::runtime_error("The shadow cascade resolution is too small");
+
+	_resolution = resolution;
+}
+
+std::ostream &	LWGC::operator<<(std::ostream & o, ShadowCascades const & r)
+{
+	o << "ShadowCascades: " << r.GetCascadeCount() << " cascades up to " << r.GetShadowDistance() << std::endl;
+	return (o);
+}
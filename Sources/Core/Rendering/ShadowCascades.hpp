@@ -0,0 +1,76 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	struct	ShadowCascade
+	{
+		glm::mat4	viewProjection;	// World to the clip space of the cascade, depth 0 on the side of the light
+		glm::vec4	sphere;			// World space bounds of the slice of the camera frustum, w: radius
+		float		splitDepth;		// View depth where the cascade ends
+		float		texelSize;		// World size of a texel of the cascade
+	};
+
+	// Fits the cascades of a directional light on the slices of a camera frustum. A cascade bounds the
+	// sphere of its slice, which only depends on the projection and the split depths: it doesn't change size
+	// when the camera turns. The light space is only a rotation so the texel grid is fixed in the world, and
+	// the cascade is larger than the sphere by a border of GuardTexels: its center is snapped to steps of
+	// that border, the cascade only moves by whole texels when the camera moved enough. The edges of the
+	// shadows don't shimmer, and the cascades of a slowly moving camera keep the same matrices for many frames.
+	class		ShadowCascades
+	{
+		private:
+			uint32_t					_cascadeCount;
+			float						_shadowDistance;
+			float						_splitLambda;
+			float						_casterDistance;
+			uint32_t					_resolution;
+			std::vector< ShadowCascade >	_cascades;
+
+		public:
+			static const uint32_t	MaxCascades = 4;
+			// Fraction of the resolution kept as a border, 1 / GuardDivisor
+			static const uint32_t	GuardDivisor = 8;
+
+			ShadowCascades(void);
+			ShadowCascades(const ShadowCascades &) = delete;
+			virtual ~ShadowCascades(void) = default;
+
+			ShadowCascades &	operator=(ShadowCascades const & src) = delete;
+
+			// cameraToWorld is the inverse of the view matrix, tanHalfFov the tangents of the half horizontal
+			// and vertical angles. padding enlarges the slices, for the offsets of the other views of the camera
+			void		Fit(const glm::mat4 & cameraToWorld, const glm::vec2 & tanHalfFov, float nearPlane, const glm::vec3 & lightDirection, float padding = 0.0f);
+
+			const std::vector< ShadowCascade > &	GetCascades(void) const noexcept;
+
+			uint32_t	GetCascadeCount(void) const noexcept;
+			void		SetCascadeCount(uint32_t count);
+			// View depth where the last cascade ends
+			float		GetShadowDistance(void) const noexcept;
+			void		SetShadowDistance(float distance);
+			// 0 splits the distance in equal parts, 1 grows them exponentially like the precision of the depth
+			float		GetSplitLambda(void) const noexcept;
+			void		SetSplitLambda(float lambda);
+			// Distance toward the light over which the casters out of the slices still cast shadows in them
+			float		GetCasterDistance(void) const noexcept;
+			void		SetCasterDistance(float distance);
+			// Size of a cascade in texels
+			uint32_t	GetResolution(void) const noexcept;
+			void		SetResolution(uint32_t resolution);
+
+			// Rotation from the world to the light space, the light travels toward +z
+			static glm::mat4	GetLightView(const glm::vec3 & lightDirection);
+			static float		GetSplitDepth(float nearPlane, float shadowDistance, float lambda, uint32_t split, uint32_t cascadeCount) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ShadowCascades const & r);
+}
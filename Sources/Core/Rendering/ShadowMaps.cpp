@@ -0,0 +1,528 @@
+#include "ShadowMaps.hpp"
+
+#include "Core/Rendering/RenderContext.tpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/MaterialStates.hpp"
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Mesh.hpp"
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace LWGC;
+
+ShadowMaps::ShadowMaps(void) : _device(VK_NULL_HANDLE), _texturePool(nullptr), _frameCount(0), _currentFrame(0),
+	_casterMaterial(nullptr), _staticAtlas(nullptr), _dynamicAtlas(nullptr), _staticFramebuffer(VK_NULL_HANDLE),
+	_dynamicFramebuffer(VK_NULL_HANDLE), _culling(nullptr), _shadowLight(nullptr), _staticInvalidated(false),
+	_staticRedrawCount(0), _droppedCascadeCount(0)
+{
+}
+
+ShadowMaps::~ShadowMaps(void)
+{
+	Release();
+}
+
+void			ShadowMaps::Initialize(size_t frameCount, RenderTexturePool * texturePool)
+{
+	_device = VulkanInstance::Get()->GetDevice();
+	_frameCount = frameCount;
+	_texturePool = texturePool;
+	_cascades.SetResolution(PageResolution);
+
+	_pages.assign(PageCount, ShadowPage{});
+	_freePages.clear();
+	for (uint32_t i = PageCount; i-- > 0; )
+		_freePages.push_back(i);
+
+	RenderTextureDescriptor	descriptor;
+
+	descriptor.width = AtlasResolution;
+	descriptor.height = AtlasResolution;
+	descriptor.format = VulkanInstance::Get()->FindSupportedFormat(
+		{VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM},
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+	);
+
+	// The static pages are only copied, the frame pages are also sampled
+	descriptor.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	_staticAtlas = _texturePool->Acquire(descriptor);
+	_staticAtlas->SetName("Static Shadow Atlas");
+	descriptor.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	_dynamicAtlas = _texturePool->Acquire(descriptor);
+	_dynamicAtlas->SetName("Shadow Atlas");
+
+	// The pages that are not drawn keep their depth, the regular depth is cleared to the far plane
+	auto description = RenderPass::GetDefaultDepthAttachment(descriptor.format);
+	description.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	description.initialLayout = RenderGraph::GetAccessLayout(RenderGraphAccess::DepthStencilAttachment);
+	description.finalLayout = RenderGraph::GetAccessLayout(RenderGraphAccess::DepthStencilAttachment);
+
+	_atlasPass.Initialize(nullptr);
+	_atlasPass.SetDepthAttachment(description, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	_atlasPass.SetClearColor(Color::Black, 1.0f, 0);
+	_atlasPass.Create();
+	Vk::SetRenderPassDebugName("Shadow Atlas", _atlasPass.GetRenderPass());
+
+	_staticFramebuffer = CreateFramebuffer(_staticAtlas);
+	_dynamicFramebuffer = CreateFramebuffer(_dynamicAtlas);
+
+	// The casters only fetch their positions, from the stream of Mesh::BindPositionBuffers
+	static auto bindingDescription = Mesh::GetPositionBindingDescription();
+	static auto attributeDescriptions = Mesh::GetPositionAttributeDescriptions();
+
+	VkPipelineVertexInputStateCreateInfo	vertexInputState = {};
+	vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputState.vertexBindingDescriptionCount = static_cast< uint32_t >(bindingDescription.size());
+	vertexInputState.vertexAttributeDescriptionCount = static_cast< uint32_t >(attributeDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescription.data();
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// Both faces cast shadows, the slope bias keeps the lit surfaces out of their own shadow
+	VkPipelineRasterizationStateCreateInfo	rasterizationState = {};
+	rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizationState.depthClampEnable = VK_FALSE;
+	rasterizationState.rasterizerDiscardEnable = VK_FALSE;
+	rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizationState.lineWidth = 1.0f;
+	rasterizationState.cullMode = VK_CULL_MODE_NONE;
+	rasterizationState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizationState.depthBiasEnable = VK_TRUE;
+	rasterizationState.depthBiasConstantFactor = 1.0f;
+	rasterizationState.depthBiasSlopeFactor = 1.5f;
+
+	_casterMaterial = Material::Create(BuiltinShaders::ShadowCaster, BuiltinShaders::ShadowCasterVertex);
+	_casterMaterial->SetVertexInputState(vertexInputState);
+	_casterMaterial->SetRasterizationState(rasterizationState);
+	_casterMaterial->SetDepthStencilState(MaterialState::CreateDepthState(true, true, VK_COMPARE_OP_LESS_OR_EQUAL));
+	_casterMaterial->MarkAsReady();
+}
+
+// The frames using the atlases must be done
+void			ShadowMaps::Release(void) noexcept
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	for (auto & camera : _cameras)
+	{
+		for (auto & resources : camera.second)
+		{
+			vkDestroyBuffer(_device, resources->params.buffer, nullptr);
+			vkFreeMemory(_device, resources->params.memory, nullptr);
+		}
+	}
+
+	vkDestroyFramebuffer(_device, _staticFramebuffer, nullptr);
+	vkDestroyFramebuffer(_device, _dynamicFramebuffer, nullptr);
+	_atlasPass.Cleanup();
+	// The pool may have been released (and its textures destroyed) before the shadow maps
+	_texturePool->TryRelease(_staticAtlas);
+	_texturePool->TryRelease(_dynamicAtlas);
+
+	_cameras.clear();
+	_cameraPages.clear();
+	_activePages.clear();
+	_pages.clear();
+	_freePages.clear();
+	_staticAtlas = nullptr;
+	_dynamicAtlas = nullptr;
+	_staticFramebuffer = VK_NULL_HANDLE;
+	_dynamicFramebuffer = VK_NULL_HANDLE;
+	_device = VK_NULL_HANDLE;
+}
+
+VkFramebuffer	ShadowMaps::CreateFramebuffer(Texture * atlas)
+{
+	VkFramebuffer			framebuffer;
+	VkImageView				view = atlas->GetView();
+	VkFramebufferCreateInfo	framebufferInfo = {};
+
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = _atlasPass.GetRenderPass();
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &view;
+	framebufferInfo.width = AtlasResolution;
+	framebufferInfo.height = AtlasResolution;
+	framebufferInfo.layers = 1;
+
+	Vk::CheckResult(vkCreateFramebuffer(_device, &framebufferInfo, nullptr, &framebuffer), "Failed to create shadow atlas framebuffer");
+	Vk::SetFramebufferDebugName(atlas->GetName(), framebuffer);
+
+	return framebuffer;
+}
+
+void			ShadowMaps::AllocateFrameResources(FrameResources & resources)
+{
+	Vk::CreateBuffer(
+		sizeof(LWGC_Shadows),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		resources.params.buffer,
+		resources.params.memory
+	);
+
+	resources.set.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, resources.params.buffer, sizeof(LWGC_Shadows));
+	// The passes of the cameras declare the atlas as a depth read
+	resources.set.AddBinding(1, _dynamicAtlas, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, RenderGraph::GetAccessLayout(RenderGraphAccess::DepthStencilRead));
+}
+
+ShadowMaps::FrameResources *	ShadowMaps::GetFrameResources(const Camera * camera)
+{
+	auto & frames = _cameras[camera];
+
+	if (frames.empty())
+	{
+		for (size_t i = 0; i < _frameCount; i++)
+		{
+			frames.push_back(std::make_unique< FrameResources >());
+			AllocateFrameResources(*frames.back());
+		}
+	}
+
+	return frames[_currentFrame].get();
+}
+
+Light *			ShadowMaps::FindShadowLight(RenderContext * context) const
+{
+	std::unordered_set< Light * >	lights;
+	Light *							shadowLight = nullptr;
+
+	context->GetLights(lights);
+
+	for (const auto light : lights)
+	{
+		if (light->GetLightType() != LightType::Directional || !light->GetCastShadows())
+			continue ;
+
+		if (shadowLight == nullptr || light->GetIntensity() > shadowLight->GetIntensity())
+			shadowLight = light;
+	}
+
+	return shadowLight;
+}
+
+VkRect2D		ShadowMaps::GetPageRect(uint32_t page) const noexcept
+{
+	VkRect2D	rect;
+
+	rect.offset = {static_cast< int32_t >((page % PagesPerRow) * PageResolution), static_cast< int32_t >((page / PagesPerRow) * PageResolution)};
+	rect.extent = {PageResolution, PageResolution};
+
+	return rect;
+}
+
+void			ShadowMaps::UpdateCamera(Camera * camera, FrameResources & resources)
+{
+	LWGC_Shadows	params = {};
+
+	if (_shadowLight != nullptr)
+	{
+		glm::mat4	projection = camera->GetProjectionMatrix();
+		glm::vec2	tanHalfFov = glm::vec2(1.0f / projection[0][0], 1.0f / std::abs(projection[1][1]));
+		float		padding = 0.0f;
+		auto &		pages = _cameraPages[camera];
+
+		// The cascades are fitted on the main view, the slices are enlarged by the offsets of the others
+		for (uint32_t i = 0; i < camera->GetViewCount(); i++)
+			padding = std::max(padding, glm::length(glm::vec3(camera->GetViewOffset(i)[3])));
+
+		_cascades.Fit(glm::inverse(camera->GetViewMatrix()), tanHalfFov, camera->GetNearPlane(), _shadowLight->GetDirection(), padding);
+
+		const auto &	cascades = _cascades.GetCascades();
+		uint32_t		cascadeCount = 0;
+
+		for (; cascadeCount < cascades.size(); cascadeCount++)
+		{
+			if (cascadeCount == pages.size())
+			{
+				if (_freePages.empty())
+				{
+					_droppedCascadeCount += cascades.size() - cascadeCount;
+					break ;
+				}
+				pages.push_back(_freePages.back());
+				_freePages.pop_back();
+			}
+
+			const ShadowCascade &	cascade = cascades[cascadeCount];
+			uint32_t				pageIndex = pages[cascadeCount];
+			ShadowPage &			page = _pages[pageIndex];
+			VkRect2D				rect = GetPageRect(pageIndex);
+
+			page.used = true;
+			page.viewProjection = cascade.viewProjection;
+			page.casterView = _activePages.size();
+			_activePages.push_back(pageIndex);
+
+			// Transposed for HLSL, like the camera matrices
+			params.cascadeViewProjections[cascadeCount] = glm::transpose(cascade.viewProjection);
+			params.cascadeSpheres[cascadeCount] = glm::vec4(glm::vec3(cascade.sphere), cascade.sphere.w * cascade.sphere.w);
+			params.cascadeRects[cascadeCount] = glm::vec4(rect.offset.x, rect.offset.y, rect.extent.width, rect.extent.height) / static_cast< float >(AtlasResolution);
+			// The receivers are moved along their normal by a texel and a half, the lookups stay in the page
+			params.cascadeBiases[cascadeCount] = glm::vec4(cascade.texelSize * 1.5f, 0.5f / PageResolution, 0.0f, 0.0f);
+		}
+		params.counts = glm::uvec4(cascadeCount, 0, 0, 0);
+	}
+
+	Vk::UploadToMemory(resources.params.memory, &params, sizeof(params));
+}
+
+// The pages of the cameras that didn't render this frame, or with less cascades, go back to the pool
+void			ShadowMaps::ReleaseUnusedPages(void)
+{
+	for (auto camera = _cameraPages.begin(); camera != _cameraPages.end(); )
+	{
+		auto &	pages = camera->second;
+
+		for (auto page : pages)
+		{
+			if (_pages[page].used)
+				continue ;
+
+			_pages[page] = ShadowPage{};
+			_freePages.push_back(page);
+		}
+		pages.erase(std::remove_if(pages.begin(), pages.end(), [this](uint32_t page) { return !_pages[page].used; }), pages.end());
+
+		if (pages.empty())
+			camera = _cameraPages.erase(camera);
+		else
+			++camera;
+	}
+}
+
+// The uniforms of the cameras that didn't render this frame are destroyed once the frames in flight are done
+void			ShadowMaps::ReleaseUnusedCameras(const std::vector< Camera * > & cameras)
+{
+	for (auto camera = _cameras.begin(); camera != _cameras.end(); )
+	{
+		if (std::find(cameras.begin(), cameras.end(), camera->first) != cameras.end())
+		{
+			++camera;
+			continue ;
+		}
+
+		VkDevice	device = _device;
+		auto		resources = std::make_shared< CameraResources >(std::move(camera->second));
+
+		RenderPipelineManager::ReleaseAfterFrames([device, resources]()
+		{
+			for (auto & frame : *resources)
+			{
+				vkDestroyBuffer(device, frame->params.buffer, nullptr);
+				vkFreeMemory(device, frame->params.memory, nullptr);
+			}
+			resources->clear();
+		});
+		camera = _cameras.erase(camera);
+	}
+}
+
+static uint64_t	HashCasters(const std::vector< Renderer * > & casters) noexcept
+{
+	uint64_t	hash = 14695981039346656037ull;
+
+	for (const auto caster : casters)
+	{
+		hash ^= reinterpret_cast< uintptr_t >(caster);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// A static page is kept while its matrix and its static casters don't change. The frame page is only copied
+// and redrawn when the static one changed or it has dynamic casters, this frame or the last one
+void			ShadowMaps::UpdateCachedPages(void)
+{
+	for (auto pageIndex : _activePages)
+	{
+		ShadowPage &	page = _pages[pageIndex];
+		const auto &	casters = _culling->GetShadowCasters(page.casterView);
+		uint64_t		hash = HashCasters(casters.staticCasters);
+
+		page.staticDirty = _staticInvalidated || !page.cached || page.cachedViewProjection != page.viewProjection || page.cachedCasterHash != hash;
+		if (page.staticDirty)
+		{
+			page.cached = true;
+			page.cachedViewProjection = page.viewProjection;
+			page.cachedCasterHash = hash;
+			_staticRedrawCount++;
+		}
+
+		page.dynamicDirty = page.staticDirty || page.hasDynamicDepth || !casters.dynamicCasters.empty();
+		page.hasDynamicDepth = !casters.dynamicCasters.empty();
+	}
+
+	_staticInvalidated = false;
+}
+
+void			ShadowMaps::Update(const std::vector< Camera * > & cameras, RenderContext * context, CameraCulling * culling, size_t frameIndex)
+{
+	LWGC_PROFILE_SCOPE("Shadow Maps");
+
+	_currentFrame = frameIndex;
+	_culling = culling;
+	_shadowLight = FindShadowLight(context);
+	_activePages.clear();
+	_staticRedrawCount = 0;
+	_droppedCascadeCount = 0;
+
+	for (auto & page : _pages)
+		page.used = false;
+
+	for (const auto camera : cameras)
+		UpdateCamera(camera, *GetFrameResources(camera));
+
+	ReleaseUnusedPages();
+	ReleaseUnusedCameras(cameras);
+
+	std::vector< glm::mat4 >	viewProjections;
+
+	for (auto page : _activePages)
+		viewProjections.push_back(_pages[page].viewProjection);
+
+	if (viewProjections.empty())
+		return ;
+
+	_culling->CullShadowCasters(viewProjections);
+	UpdateCachedPages();
+}
+
+void			ShadowMaps::RecordCasters(VkCommandBuffer cmd, const std::vector< Renderer * > & casters, const glm::mat4 & viewProjection)
+{
+	if (casters.empty())
+		return ;
+
+	glm::mat4	lightViewProjection = glm::transpose(viewProjection);
+
+	_atlasPass.BindMaterial(_casterMaterial);
+	_casterMaterial->BindPipeline(cmd, &_atlasPass);
+	_casterMaterial->BindProperties(cmd);
+	_casterMaterial->SetPushConstant(cmd, "lightViewProjection", &lightViewProjection);
+
+	for (const auto renderer : casters)
+	{
+		_atlasPass.BindDescriptorSet(LWGCBinding::Object, renderer->GetDescriptorSet());
+		_atlasPass.UpdateDescriptorBindings();
+		renderer->RecordDepthCommands(cmd);
+	}
+}
+
+void			ShadowMaps::RecordAtlas(VkCommandBuffer cmd, VkFramebuffer framebuffer, bool staticCasters)
+{
+	_atlasPass.Begin(cmd, framebuffer, {AtlasResolution, AtlasResolution}, staticCasters ? "Static Shadows" : "Dynamic Shadows");
+	{
+		for (auto pageIndex : _activePages)
+		{
+			const ShadowPage &	page = _pages[pageIndex];
+			const auto &		casters = _culling->GetShadowCasters(page.casterView);
+			VkRect2D			rect = GetPageRect(pageIndex);
+
+			if (!(staticCasters ? page.staticDirty : page.dynamicDirty))
+				continue ;
+
+			_atlasPass.SetViewport(rect);
+			if (staticCasters)
+				_atlasPass.ClearDepth(rect);
+			RecordCasters(cmd, staticCasters ? casters.staticCasters : casters.dynamicCasters, page.viewProjection);
+		}
+	}
+	_atlasPass.End();
+}
+
+void			ShadowMaps::CopyStaticPages(VkCommandBuffer cmd)
+{
+	std::vector< VkImageCopy >	regions;
+	VkImageAspectFlags			aspect = Vk::GetImageAspect(_staticAtlas->GetFormat());
+
+	for (auto pageIndex : _activePages)
+	{
+		if (!_pages[pageIndex].dynamicDirty)
+			continue ;
+
+		VkRect2D	rect = GetPageRect(pageIndex);
+		VkImageCopy	region = {};
+
+		region.srcSubresource = {aspect, 0, 0, 1};
+		region.dstSubresource = {aspect, 0, 0, 1};
+		region.srcOffset = {rect.offset.x, rect.offset.y, 0};
+		region.dstOffset = {rect.offset.x, rect.offset.y, 0};
+		region.extent = {rect.extent.width, rect.extent.height, 1};
+		regions.push_back(region);
+	}
+
+	vkCmdCopyImage(
+		cmd,
+		_staticAtlas->GetImage(), RenderGraph::GetAccessLayout(RenderGraphAccess::TransferSource),
+		_dynamicAtlas->GetImage(), RenderGraph::GetAccessLayout(RenderGraphAccess::TransferDestination),
+		static_cast< uint32_t >(regions.size()), regions.data()
+	);
+}
+
+RenderGraphResource	ShadowMaps::RecordPasses(RenderGraph & renderGraph)
+{
+	RenderGraphResource	dynamicAtlas = renderGraph.ImportTexture(_dynamicAtlas);
+	auto				isStaticDirty = [this](uint32_t page) { return _pages[page].staticDirty; };
+	auto				isDynamicDirty = [this](uint32_t page) { return _pages[page].dynamicDirty; };
+
+	// The pages of the last frame are still valid
+	if (std::none_of(_activePages.begin(), _activePages.end(), isDynamicDirty))
+		return dynamicAtlas;
+
+	RenderGraphResource	staticAtlas = renderGraph.ImportTexture(_staticAtlas);
+
+	if (std::any_of(_activePages.begin(), _activePages.end(), isStaticDirty))
+	{
+		auto staticPass = renderGraph.AddPass("Static Shadows", RenderGraphPassType::Graphics, [this](VkCommandBuffer cmd)
+		{
+			RecordAtlas(cmd, _staticFramebuffer, true);
+		});
+		// Only the changed pages are drawn, the others are kept
+		staticPass->Read(staticAtlas, RenderGraphAccess::DepthStencilAttachment);
+		staticPass->Write(staticAtlas, RenderGraphAccess::DepthStencilAttachment);
+	}
+
+	auto copyPass = renderGraph.AddPass("Shadow Cache Copy", RenderGraphPassType::Graphics, [this](VkCommandBuffer cmd)
+	{
+		CopyStaticPages(cmd);
+	});
+	copyPass->Read(staticAtlas, RenderGraphAccess::TransferSource);
+	copyPass->Write(dynamicAtlas, RenderGraphAccess::TransferDestination);
+
+	auto dynamicPass = renderGraph.AddPass("Dynamic Shadows", RenderGraphPassType::Graphics, [this](VkCommandBuffer cmd)
+	{
+		RecordAtlas(cmd, _dynamicFramebuffer, false);
+	});
+	// Drawn over the static depth
+	dynamicPass->Read(dynamicAtlas, RenderGraphAccess::DepthStencilAttachment);
+	dynamicPass->Write(dynamicAtlas, RenderGraphAccess::DepthStencilAttachment);
+
+	return dynamicAtlas;
+}
+
+VkDescriptorSet		ShadowMaps::GetDescriptorSet(const Camera * camera)
+{
+	return GetFrameResources(camera)->set.GetDescriptorSet();
+}
+
+void		ShadowMaps::InvalidateStaticShadows(void) noexcept { _staticInvalidated = true; }
+
+ShadowCascades *	ShadowMaps::GetCascades(void) noexcept { return &_cascades; }
+Light *		ShadowMaps::GetShadowLight(void) const noexcept { return _shadowLight; }
+size_t		ShadowMaps::GetActivePageCount(void) const noexcept { return _activePages.size(); }
+size_t		ShadowMaps::GetStaticRedrawCount(void) const noexcept { return _staticRedrawCount; }
+size_t		ShadowMaps::GetDroppedCascadeCount(void) const noexcept { return _droppedCascadeCount; }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, ShadowMaps const & r)
+{
+	o << "ShadowMaps: " << r.GetActivePageCount() << " pages, " << r.GetStaticRedrawCount() << " static pages redrawn" << std::endl;
+	return (o);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Components/Camera.hpp"
+#include "Core/Components/Light.hpp"
+#include "Core/Rendering/CameraCulling.hpp"
+#include "Core/Rendering/RenderGraph.hpp"
+#include "Core/Rendering/RenderTexturePool.hpp"
+#include "Core/Rendering/ShadowCascades.hpp"
+#include "Core/Vulkan/DescriptorSet.hpp"
+#include "Core/Vulkan/Material.hpp"
+#include "Core/Vulkan/RenderPass.hpp"
+#include "Core/Vulkan/UniformBuffer.hpp"
+
+#include GLM_INCLUDE
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	class RenderContext;
+
+	// Cascaded shadow maps of the brightest directional light casting shadows, read by the shaders including
+	// Common/Shadows.hlsl. The cascades of the cameras are pages of an atlas, taken from a pool of free pages
+	// and given back when a camera stops rendering. The static casters are drawn in a second atlas with the
+	// same layout, only when the matrix of a page or its static casters change: each frame the pages are
+	// copied from it and the dynamic casters drawn over them. The casters are drawn with their positions only.
+	class		ShadowMaps
+	{
+		private:
+			struct	LWGC_Shadows
+			{
+				glm::mat4	cascadeViewProjections[ShadowCascades::MaxCascades];
+				glm::vec4	cascadeSpheres[ShadowCascades::MaxCascades];
+				glm::vec4	cascadeRects[ShadowCascades::MaxCascades];
+				glm::vec4	cascadeBiases[ShadowCascades::MaxCascades];
+				glm::uvec4	counts;
+			};
+
+			struct	ShadowPage
+			{
+				bool		used;				// By a camera this frame
+				bool		cached;				// The static atlas has the static casters of cachedViewProjection
+				bool		staticDirty;		// Redrawn in the static atlas this frame
+				bool		dynamicDirty;		// Copied from the static atlas and redrawn this frame
+				bool		hasDynamicDepth;	// Dynamic casters were drawn in it since the last copy
+				glm::mat4	viewProjection;
+				glm::mat4	cachedViewProjection;
+				uint64_t	cachedCasterHash;
+				size_t		casterView;			// Index of its casters in the culling
+			};
+
+			struct	FrameResources
+			{
+				UniformBuffer	params;
+				DescriptorSet	set;
+			};
+
+			using CameraResources = std::vector< std::unique_ptr< FrameResources > >;
+
+			VkDevice					_device;
+			RenderTexturePool *			_texturePool;
+			size_t						_frameCount;
+			size_t						_currentFrame;
+			ShadowCascades				_cascades;
+			Material *					_casterMaterial;
+			RenderPass					_atlasPass;
+			Texture *					_staticAtlas;
+			Texture *					_dynamicAtlas;
+			VkFramebuffer				_staticFramebuffer;
+			VkFramebuffer				_dynamicFramebuffer;
+			std::vector< ShadowPage >	_pages;
+			std::vector< uint32_t >		_freePages;
+			std::vector< uint32_t >		_activePages;	// Used this frame, in the order of the caster views
+			std::unordered_map< const Camera *, std::vector< uint32_t > >	_cameraPages;	// Page of each cascade
+			std::unordered_map< const Camera *, CameraResources >			_cameras;
+			CameraCulling *				_culling;
+			Light *						_shadowLight;
+			bool						_staticInvalidated;
+			size_t						_staticRedrawCount;
+			size_t						_droppedCascadeCount;
+
+			Light *				FindShadowLight(RenderContext * context) const;
+			FrameResources *	GetFrameResources(const Camera * camera);
+			void				AllocateFrameResources(FrameResources & resources);
+			void				UpdateCamera(Camera * camera, FrameResources & resources);
+			void				ReleaseUnusedPages(void);
+			void				ReleaseUnusedCameras(const std::vector< Camera * > & cameras);
+			void				UpdateCachedPages(void);
+			VkFramebuffer		CreateFramebuffer(Texture * atlas);
+			VkRect2D			GetPageRect(uint32_t page) const noexcept;
+
+			void				RecordAtlas(VkCommandBuffer cmd, VkFramebuffer framebuffer, bool staticCasters);
+			void				RecordCasters(VkCommandBuffer cmd, const std::vector< Renderer * > & casters, const glm::mat4 & viewProjection);
+			void				CopyStaticPages(VkCommandBuffer cmd);
+
+		public:
+			static const uint32_t	AtlasResolution = 4096;
+			static const uint32_t	PageResolution = 1024;
+			static const uint32_t	PagesPerRow = AtlasResolution / PageResolution;
+			static const uint32_t	PageCount = PagesPerRow * PagesPerRow;
+
+			ShadowMaps(void);
+			ShadowMaps(const ShadowMaps &) = delete;
+			virtual ~ShadowMaps(void);
+
+			ShadowMaps &	operator=(ShadowMaps const & src) = delete;
+
+			// The atlases are render textures of the pool
+			void		Initialize(size_t frameCount, RenderTexturePool * texturePool);
+			void		Release(void) noexcept;
+
+			// Fits the cascades of the cameras and culls their casters, after the cameras were culled this frame
+			void		Update(const std::vector< Camera * > & cameras, RenderContext * context, CameraCulling * culling, size_t frameIndex);
+			// Adds the passes drawing the pages of the frame, the returned atlas is read with DepthStencilRead
+			RenderGraphResource	RecordPasses(RenderGraph & renderGraph);
+
+			// Set bound with LWGCBinding::Shadows, valid for the cameras of the last Update
+			VkDescriptorSet		GetDescriptorSet(const Camera * camera);
+
+			// Redraws the static casters of all the pages, after a static renderer moved
+			void		InvalidateStaticShadows(void) noexcept;
+
+			// Split and distance settings of the cascades, their resolution is PageResolution
+			ShadowCascades *	GetCascades(void) noexcept;
+			// nullptr when no directional light casts shadows
+			Light *		GetShadowLight(void) const noexcept;
+			size_t		GetActivePageCount(void) const noexcept;
+			// Pages whose static casters were drawn again during the last Update
+			size_t		GetStaticRedrawCount(void) const noexcept;
+			// Cascades without a page during the last Update, the pool was empty
+			size_t		GetDroppedCascadeCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ShadowMaps const & r);
+}
@@ -4,7 +4,12 @@ using namespace LWGC;
 
 const std::string BuiltinShaders::Standard = "Shaders/Debug/AlbedoTexture.hlsl";
 const std::string BuiltinShaders::ColorDirection = "Shaders/Debug/ColorDirection.hlsl";
+const std::string BuiltinShaders::Lit = "Shaders/Lighting/Lit.hlsl";
 const std::string BuiltinShaders::DefaultVertex = "Shaders/DefaultVertex.hlsl";
 const std::string BuiltinShaders::FullScreenQuad = "Shaders/FullScreenQuad.hlsl";
 const std::string BuiltinShaders::Pink = "Shaders/Error/Pink.hlsl";
 const std::string BuiltinShaders::ComputeError = "Shaders/Error/Compute.hlsl";
+const std::string BuiltinShaders::ShadowCaster = "Shaders/Shadows/ShadowCaster.hlsl";
+const std::string BuiltinShaders::ShadowCasterVertex = "Shaders/Shadows/ShadowCasterVertex.hlsl";
+const std::string BuiltinShaders::DepthPrepass = "Shaders/Depth/DepthPrepass.hlsl";
+const std::string BuiltinShaders::DepthPrepassVertex = "Shaders/Depth/DepthPrepassVertex.hlsl";
@@ -12,6 +12,11 @@ namespace LWGC
 			static const std::string	FullScreenQuad;
 			static const std::string	Pink;
 			static const std::string	ColorDirection;
+			static const std::string	Lit;
 			static const std::string	ComputeError;
+			static const std::string	ShadowCaster;
+			static const std::string	ShadowCasterVertex;
+			static const std::string	DepthPrepass;
+			static const std::string	DepthPrepassVertex;
 	};
 }
\ No newline at end of file
@@ -23,7 +23,7 @@ void		ComputeShader::Dispatch(VkCommandBuffer cmd, int width, int height, int de
 
 	for (const auto & bindingName : shaderBindingNames)
 	{
-		if (!_material->IsPropertyBound(bindingName))
+		if (!_material->IsPropertyBound(bindingName) && !_renderPass.HasBinding(bindingName))
 			std::cerr << "Compute shader property " << bindingName << " is not bound for compute " << _material->GetName() << std::endl;
 	}
 
@@ -44,6 +44,11 @@ void		ComputeShader::BindFrameProperties(VkCommandBuffer cmd)
 	_material->BindFrameProperties(cmd);
 }
 
+void		ComputeShader::BindDescriptorSet(const std::string & bindingName, VkDescriptorSet set)
+{
+	_renderPass.BindDescriptorSet(bindingName, set);
+}
+
 void		ComputeShader::SetBuffer(const std::string & bindingName, VkBuffer buffer, size_t size, VkDescriptorType descriptorType, size_t offset, bool silent)
 {
 	_material->SetBuffer(bindingName, buffer, size, descriptorType, offset, silent);
@@ -32,6 +32,8 @@ namespace LWGC
 			void	Dispatch(VkCommandBuffer cmd, int width, int height, int depth) noexcept;
 
 			void	BindFrameProperties(VkCommandBuffer cmd);
+			// Bound over the material properties in the next dispatches, for the sets owned by the render pipeline
+			void	BindDescriptorSet(const std::string & bindingName, VkDescriptorSet set);
 
 			void	SetBuffer(const std::string & bindingName, VkBuffer buffer, size_t size, VkDescriptorType descriptorType, size_t offset = 0, bool silent = false);
 			void	SetTexture(const std::string & bindingName, const Texture * texture, VkImageLayout imageLayout, VkDescriptorType descriptorType, bool silent = false);
@@ -50,6 +50,19 @@ PushConstantBinding &	ShaderBindingTable::AddPushConstant(const std::string & na
 	}}).first)->second;
 }
 
+void					ShaderBindingTable::AddReflection(const ShaderReflection & reflection)
+{
+	for (const auto & binding : reflection.bindings)
+	{
+		auto & shaderBinding = AddBinding(binding.name, binding.binding.descriptorSet, binding.binding.bindingIndex, binding.binding.descriptorType);
+		if (binding.binding.elementSize != 0)
+			shaderBinding.elementSize = binding.binding.elementSize;
+	}
+
+	for (const auto & pushConstant : reflection.pushConstants)
+		AddPushConstant(pushConstant.name, pushConstant.range.offset, pushConstant.range.size);
+}
+
 void					ShaderBindingTable::GenerateSetLayouts()
 {
 	std::unordered_map< int, std::vector< VkDescriptorSetLayoutBinding > >	layoutBindings;
@@ -99,6 +112,15 @@ void					ShaderBindingTable::GenerateSetLayouts()
 	}
 }
 
+void					ShaderBindingTable::Swap(ShaderBindingTable & table) noexcept
+{
+	std::swap(_bindings, table._bindings);
+	std::swap(_pushConstants, table._pushConstants);
+	std::swap(_elementLayouts, table._elementLayouts);
+	std::swap(_stageFlags, table._stageFlags);
+	std::swap(_descriptorSetLayout, table._descriptorSetLayout);
+}
+
 VkDescriptorSetLayout	ShaderBindingTable::GetDescriptorSetLayout(const std::string & setElementName) const
 {
 	return _elementLayouts.find(setElementName)->second;
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "IncludeDeps.hpp"
 
@@ -25,6 +26,28 @@ namespace LWGC
 		uint32_t		size;
 	};
 
+	// Resources used by a single shader stage, as found by spirv_cross
+	struct ShaderReflection
+	{
+		struct Binding
+		{
+			std::string		name;
+			ShaderBinding	binding;
+		};
+
+		struct PushConstant
+		{
+			std::string			name;
+			PushConstantBinding	range;
+		};
+
+		std::vector< Binding >		bindings;
+		std::vector< PushConstant >	pushConstants;
+		uint32_t					threadWidth;
+		uint32_t					threadHeight;
+		uint32_t					threadDepth;
+	};
+
 	class		ShaderBindingTable
 	{
 		private:
@@ -42,7 +65,10 @@ namespace LWGC
 			void			SetStage(VkShaderStageFlagBits stage);
 			ShaderBinding &	AddBinding(const std::string & name, int descriptorSet, int bindingIndex, VkDescriptorType descriptorType);
 			PushConstantBinding & AddPushConstant(const std::string & name, uint32_t offset, uint32_t size);
+			void			AddReflection(const ShaderReflection & reflection);
 			void			GenerateSetLayouts(void);
+			// Exchange the content (and the ownership of the layouts) of the two tables
+			void			Swap(ShaderBindingTable & table) noexcept;
 			bool			HasBinding(const std::string & bindingName) const;
 
 			const std::vector< VkDescriptorSetLayout > &	GetDescriptorSetLayouts(void) const;
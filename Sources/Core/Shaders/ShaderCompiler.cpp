@@ -0,0 +1,359 @@
+#include "ShaderCompiler.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <sys/stat.h>
+
+#include "Utils/Utils.hpp"
+
+#include GLSLANG_INCLUDE
+#include GLSLANG_RESOURCES_INCLUDE
+#include GLSLANG_SPV_INCLUDE
+
+using namespace LWGC;
+
+std::once_flag	ShaderCompiler::_initializeFlag;
+
+static bool		ReadSource(const std::string & path, std::string & source)
+{
+	std::ifstream		file(path, std::ios::binary);
+	std::stringstream	stream;
+
+	if (!file.is_open())
+		return false;
+
+	stream << file.rdbuf();
+	source = stream.str();
+
+	return true;
+}
+
+static bool		FileExists(const std::string & path)
+{
+	struct stat buffer;
+
+	return stat(path.c_str(), &buffer) == 0 && S_ISREG(buffer.st_mode);
+}
+
+static EShLanguage	StageToLanguage(const VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+		case VK_SHADER_STAGE_VERTEX_BIT:					return EShLangVertex;
+		case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:		return EShLangTessControl;
+		case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:	return EShLangTessEvaluation;
+		case VK_SHADER_STAGE_GEOMETRY_BIT:					return EShLangGeometry;
+		case VK_SHADER_STAGE_FRAGMENT_BIT:					return EShLangFragment;
+		case VK_SHADER_STAGE_COMPUTE_BIT:					return EShLangCompute;
+		case VK_SHADER_STAGE_RAYGEN_BIT_NV:					return EShLangRayGenNV;
+		case VK_SHADER_STAGE_ANY_HIT_BIT_NV:				return EShLangAnyHitNV;
+		case VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV:			return EShLangClosestHitNV;
+		case VK_SHADER_STAGE_MISS_BIT_NV:					return EShLangMissNV;
+		case VK_SHADER_STAGE_INTERSECTION_BIT_NV:			return EShLangIntersectNV;
+		case VK_SHADER_STAGE_CALLABLE_BIT_NV:				return EShLangCallableNV;
+		default:
+			throw std::runtime_error("Unhandled stage");
+	}
+}
+
+// Resolve #include like glslangValidator -I: relative to the including file, then the working directory,
+// then the include paths. Every resolved file is recorded so the caller knows the dependencies of the shader.
+class		ShaderIncluder : public glslang::TShader::Includer
+{
+	private:
+		const std::vector< std::string > &	_includePaths;
+		std::vector< std::string > &		_includedFiles;
+
+		IncludeResult *	Include(const std::string & path)
+		{
+			std::string * source = new std::string();
+
+			if (!ReadSource(path, *source))
+			{
+				delete source;
+				return nullptr;
+			}
+
+			if (std::find(_includedFiles.begin(), _includedFiles.end(), path) == _includedFiles.end())
+				_includedFiles.push_back(path);
+
+			// The header name is used by glslang in the diagnostics, so it must be the resolved path
+			return new IncludeResult(path, source->c_str(), source->size(), source);
+		}
+
+	public:
+		ShaderIncluder(const std::vector< std::string > & includePaths, std::vector< std::string > & includedFiles) :
+			_includePaths(includePaths), _includedFiles(includedFiles) {}
+
+		IncludeResult *	includeLocal(const char * headerName, const char * includerName, size_t) override
+		{
+			std::string	includer = includerName;
+			size_t		lastSlash = includer.find_last_of("\\/");
+
+			if (lastSlash != std::string::npos)
+			{
+				std::string path = includer.substr(0, lastSlash + 1) + headerName;
+				if (FileExists(path))
+					return Include(path);
+			}
+
+			return includeSystem(headerName, includerName, 0);
+		}
+
+		IncludeResult *	includeSystem(const char * headerName, const char *, size_t) override
+		{
+			if (FileExists(headerName))
+				return Include(headerName);
+
+			for (const auto & includePath : _includePaths)
+			{
+				std::string path = includePath + headerName;
+				if (FileExists(path))
+					return Include(path);
+			}
+
+			return nullptr;
+		}
+
+		void			releaseInclude(IncludeResult * result) override
+		{
+			if (result == nullptr)
+				return ;
+
+			delete static_cast< std::string * >(result->userData);
+			delete result;
+		}
+};
+
+// glslang logs are formatted as "ERROR: <file>:<line>: <message>", the file is the string index when it has no name
+static void		ParseInfoLog(const char * log, const std::string & path, std::vector< ShaderDiagnostic > & diagnostics)
+{
+	static const std::regex	locatedMessage("^(ERROR|WARNING): (.+?):([0-9]+): (.*)$");
+	std::istringstream		stream(log);
+	std::string				line;
+
+	while (std::getline(stream, line))
+	{
+		std::smatch	match;
+
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue ;
+
+		if (std::regex_match(line, match, locatedMessage))
+		{
+			std::string file = match[2];
+
+			if (std::all_of(file.begin(), file.end(), ::isdigit))
+				file = path;
+
+			diagnostics.push_back({file, std::stoi(match[3]), match[1] == "ERROR", match[4]});
+		}
+		else if (line.compare(0, 7, "ERROR: ") == 0 || line.compare(0, 9, "WARNING: ") == 0)
+		{
+			bool isError = line[0] == 'E';
+
+			// The error count summary doesn't add anything to the diagnostics
+			if (line.find("compilation errors") != std::string::npos)
+				continue ;
+
+			diagnostics.push_back({path, 0, isError, line.substr(isError ? 7 : 9)});
+		}
+		else if (!diagnostics.empty())
+			diagnostics.back().message += "\n" + line;
+		else
+			diagnostics.push_back({path, 0, false, line});
+	}
+}
+
+// Source strings given to glslang, they must stay alive until the shader is parsed
+struct		ShaderInput
+{
+	std::string		source;
+	std::string		preamble;
+	const char *	sourceString;
+	int				sourceLength;
+	const char *	sourceName;
+	EShMessages		messages;
+};
+
+static std::string	DefinesToPreamble(const std::vector< std::string > & defines)
+{
+	std::string	preamble;
+
+	// "NAME" or "NAME=VALUE", like the -D option of the compilers
+	for (const auto & define : defines)
+	{
+		size_t equal = define.find('=');
+
+		if (equal == std::string::npos)
+			preamble += "#define " + define + " 1\n";
+		else
+			preamble += "#define " + define.substr(0, equal) + " " + define.substr(equal + 1) + "\n";
+	}
+
+	return preamble;
+}
+
+// The source and preamble of the input are set by the caller
+static void		SetupShaderSource(glslang::TShader & shader, ShaderInput & input, const std::string & path, EShLanguage language)
+{
+	bool	isHlsl = GetExtension(path) == "hlsl";
+
+	input.sourceString = input.source.c_str();
+	input.sourceLength = static_cast< int >(input.source.size());
+	input.sourceName = path.c_str();
+	input.messages = static_cast< EShMessages >(EShMsgSpvRules | EShMsgVulkanRules | (isHlsl ? EShMsgReadHlsl : EShMsgDefault));
+
+	// Same settings as glslangValidator -V -e main (-D for hlsl)
+	shader.setStringsWithLengthsAndNames(&input.sourceString, &input.sourceLength, &input.sourceName, 1);
+	shader.setPreamble(input.preamble.c_str());
+	shader.setEntryPoint(ShaderCompiler::EntryPoint);
+	shader.setSourceEntryPoint(ShaderCompiler::EntryPoint);
+	shader.setEnvInput(isHlsl ? glslang::EShSourceHlsl : glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+	shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+	shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+}
+
+static bool		SetupShader(glslang::TShader & shader, ShaderInput & input, const std::string & path, EShLanguage language, const std::vector< std::string > & defines, std::vector< ShaderDiagnostic > & diagnostics)
+{
+	if (!ReadSource(path, input.source))
+	{
+		diagnostics.push_back({path, 0, true, "can't open shader file"});
+		return false;
+	}
+
+	input.preamble = DefinesToPreamble(defines);
+	SetupShaderSource(shader, input, path, language);
+
+	return true;
+}
+
+static void		ParseAndGenerateSpirV(glslang::TShader & shader, ShaderInput & input, glslang::TShader::Includer & includer, const std::string & path, EShLanguage language, ShaderCompiler::Result & result)
+{
+	glslang::TProgram	program;
+
+	bool parsed = shader.parse(&glslang::DefaultTBuiltInResource, 100, false, input.messages, includer);
+	ParseInfoLog(shader.getInfoLog(), path, result.diagnostics);
+	if (!parsed)
+		return ;
+
+	program.addShader(&shader);
+	bool linked = program.link(input.messages);
+	ParseInfoLog(program.getInfoLog(), path, result.diagnostics);
+	if (!linked)
+		return ;
+
+	spv::SpvBuildLogger		logger;
+	glslang::SpvOptions		options;
+
+	glslang::GlslangToSpv(*program.getIntermediate(language), result.spirV, &logger, &options);
+
+	std::string spvMessages = logger.getAllMessages();
+	if (!spvMessages.empty())
+		result.diagnostics.push_back({path, 0, false, spvMessages});
+
+	result.success = !result.spirV.empty();
+}
+
+void			ShaderCompiler::Initialize(void)
+{
+	glslang::InitializeProcess();
+	std::atexit(glslang::FinalizeProcess);
+}
+
+ShaderCompiler::Result		ShaderCompiler::Compile(const std::string & path, VkShaderStageFlagBits stage, const std::vector< std::string > & includePaths, const std::vector< std::string > & defines)
+{
+	Result				result = {{}, "", {}, {}, false};
+	EShLanguage			language = StageToLanguage(stage);
+	ShaderInput			input;
+	ShaderIncluder		includer(includePaths, result.includedFiles);
+	glslang::TShader	shader(language);
+
+	std::call_once(_initializeFlag, Initialize);
+
+	if (!SetupShader(shader, input, path, language, defines, result.diagnostics))
+		return result;
+
+	ParseAndGenerateSpirV(shader, input, includer, path, language, result);
+
+	return result;
+}
+
+ShaderCompiler::Result		ShaderCompiler::CompilePreprocessed(const Result & preprocessed, const std::string & path, VkShaderStageFlagBits stage)
+{
+	Result						result = {{}, "", preprocessed.includedFiles, {}, false};
+	EShLanguage					language = StageToLanguage(stage);
+	ShaderInput					input;
+	std::vector< std::string >	noIncludePaths;
+	std::vector< std::string >	noIncludedFiles;
+	ShaderIncluder				includer(noIncludePaths, noIncludedFiles);
+	glslang::TShader			shader(language);
+
+	std::call_once(_initializeFlag, Initialize);
+
+	input.source = preprocessed.preprocessedSource;
+	SetupShaderSource(shader, input, path, language);
+	ParseAndGenerateSpirV(shader, input, includer, path, language, result);
+
+	return result;
+}
+
+ShaderCompiler::Result		ShaderCompiler::Preprocess(const std::string & path, VkShaderStageFlagBits stage, const std::vector< std::string > & includePaths, const std::vector< std::string > & defines)
+{
+	Result				result = {{}, "", {}, {}, false};
+	EShLanguage			language = StageToLanguage(stage);
+	ShaderInput			input;
+	ShaderIncluder		includer(includePaths, result.includedFiles);
+	glslang::TShader	shader(language);
+
+	std::call_once(_initializeFlag, Initialize);
+
+	if (!SetupShader(shader, input, path, language, defines, result.diagnostics))
+		return result;
+
+	result.success = shader.preprocess(&glslang::DefaultTBuiltInResource, 100, ENoProfile, false, false, input.messages, &result.preprocessedSource, includer);
+	ParseInfoLog(shader.getInfoLog(), path, result.diagnostics);
+
+	return result;
+}
+
+const std::string &	ShaderCompiler::GetVersion(void)
+{
+	static const std::string version = std::string("glslang ") + glslang::GetGlslVersionString() + " spirv-generator " + std::to_string(glslang::GetSpirvGeneratorVersion());
+
+	return version;
+}
+
+std::string		ShaderCompiler::FormatDiagnostics(const std::vector< ShaderDiagnostic > & diagnostics)
+{
+	std::string		text;
+
+	for (const auto & diagnostic : diagnostics)
+	{
+		text += diagnostic.file + ":";
+		if (diagnostic.line > 0)
+			text += std::to_string(diagnostic.line) + ":";
+		text += (diagnostic.isError ? " error: " : " warning: ") + diagnostic.message + "\n";
+
+		if (diagnostic.line <= 0)
+			continue ;
+
+		// Show the line the diagnostic points to
+		std::ifstream	file(diagnostic.file);
+		std::string		sourceLine;
+		int				lineNumber = 0;
+
+		while (lineNumber < diagnostic.line && std::getline(file, sourceLine))
+			lineNumber++;
+		if (lineNumber == diagnostic.line)
+			text += "\t" + sourceLine + "\n";
+	}
+
+	return text;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	struct		ShaderDiagnostic
+	{
+		std::string		file;
+		int				line;		// 0 when the message is not attached to a line
+		bool			isError;
+		std::string		message;
+	};
+
+	// In-process HLSL / GLSL to SPIR-V compiler (glslang). Compile can be called from any thread,
+	// the source and its includes are read directly and the SPIR-V is returned in memory.
+	class		ShaderCompiler
+	{
+		private:
+			static std::once_flag	_initializeFlag;
+
+			static void		Initialize(void);
+
+		public:
+			static constexpr const char *	EntryPoint = "main";
+
+			struct	Result
+			{
+				std::vector< uint32_t >			spirV;
+				std::string						preprocessedSource;	// Only filled by Preprocess
+				std::vector< std::string >		includedFiles;	// Resolved path of every file included by the source
+				std::vector< ShaderDiagnostic >	diagnostics;
+				bool							success;
+			};
+
+			ShaderCompiler(void) = delete;
+			ShaderCompiler(const ShaderCompiler &) = delete;
+			virtual ~ShaderCompiler(void) = delete;
+
+			ShaderCompiler &	operator=(ShaderCompiler const & src) = delete;
+
+			// Include are resolved relative to the including file, then the working directory, then the include paths.
+			// Defines are "NAME" or "NAME=VALUE".
+			static Result		Compile(const std::string & path, VkShaderStageFlagBits stage, const std::vector< std::string > & includePaths, const std::vector< std::string > & defines = {});
+			// Run the preprocessor only, the output contains the source of all the includes
+			static Result		Preprocess(const std::string & path, VkShaderStageFlagBits stage, const std::vector< std::string > & includePaths, const std::vector< std::string > & defines = {});
+			// Compile the output of Preprocess, the includes and defines are already expanded in it
+			static Result		CompilePreprocessed(const Result & preprocessed, const std::string & path, VkShaderStageFlagBits stage);
+
+			// Identify the compiler, SPIR-V generated by another version must not be reused
+			static const std::string &	GetVersion(void);
+
+			// "file:line: error: message" lines followed by the source line the diagnostic points to
+			static std::string	FormatDiagnostics(const std::vector< ShaderDiagnostic > & diagnostics);
+	};
+}
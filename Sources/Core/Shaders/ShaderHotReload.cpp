@@ -0,0 +1,159 @@
+#include "ShaderHotReload.hpp"
+
+#include <chrono>
+
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/MaterialTable.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+
+using namespace LWGC;
+
+// One compiler thread is enough for the few files saved at once and keeps the other cores for the frame
+ShaderHotReload::ShaderHotReload(void) : _compiler(1)
+{
+}
+
+ShaderHotReload::~ShaderHotReload(void)
+{
+	_watcher.Stop();
+	_compiler.WaitIdle();
+
+	for (auto & reload : _reloads)
+		delete reload.second.next;
+}
+
+void			ShaderHotReload::Register(ShaderProgram * program)
+{
+	_newPrograms.push_back(program);
+}
+
+void			ShaderHotReload::Start(void)
+{
+	_watcher.Start();
+}
+
+void			ShaderHotReload::WatchFiles(ShaderProgram * program, const std::vector< std::string > & files)
+{
+	for (const auto & file : files)
+	{
+		if (_watcher.Watch(file))
+			_dependencies[FileWatcher::NormalizePath(file)].insert(program);
+	}
+}
+
+void			ShaderHotReload::StartReload(ShaderProgram * program)
+{
+	ShaderProgram *	next = program->Clone();
+
+	// Only the SPIR-V is generated on the worker, the Vulkan objects are created by FinishReload on the main thread
+	_reloads[program] = Reload{next, _compiler.Submit([next]()
+	{
+		for (auto shaderSource : next->GetShaderSources())
+			shaderSource->CompileSpirV();
+	}), false};
+}
+
+void			ShaderHotReload::FinishReload(ShaderProgram * program, Reload & reload)
+{
+	ShaderProgram *	next = reload.next;
+
+	reload.next = nullptr;
+	reload.compilation.get();
+
+	bool	reloaded = false;
+
+	try {
+		next->CompileAndLink();
+		// The pipelines of all the materials are created before the program is swapped
+		reloaded = MaterialTable::Get()->UpdateMaterial(program, next);
+	} catch (const std::runtime_error & e) {
+		std::cerr << e.what() << std::endl;
+	}
+
+	if (!reloaded)
+	{
+		std::cerr << "Shader " << program->GetName() << " not reloaded, keeping the last working version" << std::endl;
+
+		// The broken version may include new files, fixing them must trigger a reload too
+		WatchFiles(program, next->GetSourceFiles());
+		delete next;
+		return ;
+	}
+
+	// next now holds the old modules and layouts, the frames in flight can still use them
+	RenderPipelineManager::ReleaseAfterFrames([next]() { delete next; });
+
+	for (auto & dependency : _dependencies)
+		dependency.second.erase(program);
+	WatchFiles(program, program->GetSourceFiles());
+
+	std::cout << "Reloaded shader " << program->GetName() << std::endl;
+}
+
+void			ShaderHotReload::Update(void)
+{
+	std::vector< std::string >			changedFiles;
+	std::unordered_set< ShaderProgram * >	changedPrograms;
+	std::vector< ShaderProgram * >		restartedPrograms;
+
+	for (auto program : _newPrograms)
+		WatchFiles(program, program->GetSourceFiles());
+	_newPrograms.clear();
+
+	if (!_watcher.Poll(changedFiles))
+	{
+		// Some events were dropped, we can't know which files changed
+		std::cerr << "Too many file changes, reloading all the shaders" << std::endl;
+		for (const auto & dependency : _dependencies)
+			changedPrograms.insert(dependency.second.begin(), dependency.second.end());
+	}
+
+	for (const auto & file : changedFiles)
+	{
+		auto dependency = _dependencies.find(file);
+
+		if (dependency != _dependencies.end())
+			changedPrograms.insert(dependency->second.begin(), dependency->second.end());
+	}
+
+	for (auto program : changedPrograms)
+	{
+		auto reload = _reloads.find(program);
+
+		if (reload != _reloads.end())
+			reload->second.dirty = true;
+		else
+			StartReload(program);
+	}
+
+	for (auto reload = _reloads.begin(); reload != _reloads.end();)
+	{
+		if (reload->second.compilation.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++reload;
+			continue ;
+		}
+
+		// The compiled version is already outdated, compile it again instead of swapping it
+		if (reload->second.dirty)
+		{
+			reload->second.compilation.get();
+			delete reload->second.next;
+			restartedPrograms.push_back(reload->first);
+		}
+		else
+			FinishReload(reload->first, reload->second);
+
+		reload = _reloads.erase(reload);
+	}
+
+	for (auto program : restartedPrograms)
+		StartReload(program);
+}
+
+std::ostream &	operator<<(std::ostream & o, ShaderHotReload const & r)
+{
+	o << "tostring of the class" << std::endl;
+	(void)r;
+	return (o);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <future>
+
+#include "Core/Shaders/ShaderProgram.hpp"
+#include "Utils/FileWatcher.hpp"
+#include "Utils/ThreadPool.hpp"
+
+namespace LWGC
+{
+	// Recompile the shader programs when one of their source or included files is modified.
+	// A modified program is cloned and compiled on a worker thread while the old one is still used, the
+	// materials are switched to the new program only if it compiled, otherwise the old one is kept.
+	class		ShaderHotReload
+	{
+		private:
+			struct	Reload
+			{
+				ShaderProgram *		next;
+				std::future< void >	compilation;
+				bool				dirty;	// A file changed again during the compilation
+			};
+
+			FileWatcher																_watcher;
+			ThreadPool																_compiler;
+			// Normalized file path -> programs using it
+			std::unordered_map< std::string, std::unordered_set< ShaderProgram * > >	_dependencies;
+			std::unordered_map< ShaderProgram *, Reload >							_reloads;
+			std::vector< ShaderProgram * >											_newPrograms;
+
+			void			WatchFiles(ShaderProgram * program, const std::vector< std::string > & files);
+			void			StartReload(ShaderProgram * program);
+			void			FinishReload(ShaderProgram * program, Reload & reload);
+
+		public:
+			ShaderHotReload(void);
+			ShaderHotReload(const ShaderHotReload &) = delete;
+			virtual ~ShaderHotReload(void);
+
+			ShaderHotReload &	operator=(ShaderHotReload const & src) = delete;
+
+			// The files of the program are watched on the next Update, once it has been compiled and its includes are known
+			void			Register(ShaderProgram * program);
+			void			Start(void);
+			// Called once per frame on the main thread
+			void			Update(void);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ShaderHotReload const & r);
+}
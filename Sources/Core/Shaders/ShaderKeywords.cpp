@@ -0,0 +1,103 @@
+#include "ShaderKeywords.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+using namespace LWGC;
+
+const std::string	ShaderKeywords::Pragma = "#pragma keywords";
+
+ShaderKeywords::ShaderKeywords(void)
+{
+}
+
+ShaderKeywords::~ShaderKeywords(void)
+{
+}
+
+void			ShaderKeywords::AddKeyword(const std::string & keyword)
+{
+	if (HasKeyword(keyword))
+		return ;
+
+	if (_keywords.size() == MaxKeywords)
+		throw std::runtime_error("Too many shader keywords, can't add " + keyword + " (max " + std::to_string(MaxKeywords) + ")");
+
+	_keywords.push_back(keyword);
+}
+
+void			ShaderKeywords::ParseFile(const std::string & path)
+{
+	std::ifstream	file(path);
+	std::string		line;
+
+	while (std::getline(file, line))
+	{
+		size_t start = line.find_first_not_of(" \t");
+
+		if (start == std::string::npos || line.compare(start, Pragma.size(), Pragma) != 0)
+			continue ;
+
+		std::istringstream	keywords(line.substr(start + Pragma.size()));
+		std::string			keyword;
+
+		while (keywords >> keyword)
+			AddKeyword(keyword);
+	}
+}
+
+bool			ShaderKeywords::HasKeyword(const std::string & keyword) const noexcept
+{
+	return std::find(_keywords.begin(), _keywords.end(), keyword) != _keywords.end();
+}
+
+KeywordMask		ShaderKeywords::GetMask(const std::string & keyword) const noexcept
+{
+	auto it = std::find(_keywords.begin(), _keywords.end(), keyword);
+
+	if (it == _keywords.end())
+		return 0;
+
+	return KeywordMask(1) << (it - _keywords.begin());
+}
+
+KeywordMask		ShaderKeywords::GetValidMask(void) const noexcept
+{
+	if (_keywords.size() == MaxKeywords)
+		return ~KeywordMask(0);
+
+	return (KeywordMask(1) << _keywords.size()) - 1;
+}
+
+std::vector< std::string >	ShaderKeywords::GetDefines(KeywordMask mask) const
+{
+	std::vector< std::string >	defines;
+
+	for (size_t i = 0; i < _keywords.size(); i++)
+		if (mask & (KeywordMask(1) << i))
+			defines.push_back(_keywords[i]);
+
+	return defines;
+}
+
+std::string		ShaderKeywords::ToString(KeywordMask mask) const
+{
+	std::string	result;
+
+	for (const auto & define : GetDefines(mask))
+		result += (result.empty() ? "" : " ") + define;
+
+	return result;
+}
+
+const std::vector< std::string > &	ShaderKeywords::GetKeywords(void) const noexcept { return _keywords; }
+
+std::ostream &	operator<<(std::ostream & o, ShaderKeywords const & r)
+{
+	o << "ShaderKeywords:";
+	for (const auto & keyword : r.GetKeywords())
+		o << " " << keyword;
+	o << std::endl;
+	return (o);
+}
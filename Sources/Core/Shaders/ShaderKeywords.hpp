@@ -0,0 +1,47 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace LWGC
+{
+	// One bit per keyword, in the declaration order of the shader
+	using KeywordMask = uint64_t;
+
+	// Keywords declared by a shader with "#pragma keywords NAME_A NAME_B" lines. Each combination of
+	// keywords is compiled as a separate variant with the enabled keywords defined, so the shader can
+	// use #ifdef instead of branching at runtime.
+	class		ShaderKeywords
+	{
+		private:
+			std::vector< std::string >	_keywords;
+
+		public:
+			static const size_t		MaxKeywords = 64;
+			static const std::string	Pragma;
+
+			ShaderKeywords(void);
+			ShaderKeywords(const ShaderKeywords &) = default;
+			virtual ~ShaderKeywords(void);
+
+			ShaderKeywords &	operator=(ShaderKeywords const & src) = default;
+
+			void			AddKeyword(const std::string & keyword);
+			// Add the keywords declared in the file, the includes are not parsed
+			void			ParseFile(const std::string & path);
+
+			bool			HasKeyword(const std::string & keyword) const noexcept;
+			// 0 if the keyword is not declared
+			KeywordMask		GetMask(const std::string & keyword) const noexcept;
+			// Bits of the undeclared keywords are ignored
+			KeywordMask		GetValidMask(void) const noexcept;
+			std::vector< std::string >	GetDefines(KeywordMask mask) const;
+			std::string		ToString(KeywordMask mask) const;
+
+			const std::vector< std::string > &	GetKeywords(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ShaderKeywords const & r);
+}
@@ -1,13 +1,14 @@
 #include "ShaderProgram.hpp"
 
 #include <algorithm>
+#include <unordered_set>
 
 #include "Core/Vulkan/Vk.hpp"
-#include "Core/Application.hpp"
+#include "Utils/ThreadPool.hpp"
 
 using namespace LWGC;
 
-ShaderProgram::ShaderProgram(void) : _threadWidth(1), _threadHeight(1), _threadDepth(1), _isUpdateBound(false)
+ShaderProgram::ShaderProgram(void) : _threadWidth(1), _threadHeight(1), _threadDepth(1), _keywordsParsed(false), _keywordMask(0)
 {
 }
 
@@ -21,7 +22,14 @@ ShaderProgram::ShaderProgram(const std::string & fragmentShaderName, const std::
 
 ShaderProgram::~ShaderProgram(void)
 {
-	Application::update.RemoveListener(_updateIndex);
+	if (_prewarm.valid())
+		_prewarm.wait();
+
+	for (auto shaderSource : _shaderSources)
+		delete shaderSource;
+
+	for (auto & variant : _variants)
+		delete variant.second;
 }
 
 void		ShaderProgram::CompileAndLink(void)
@@ -30,11 +38,10 @@ void		ShaderProgram::CompileAndLink(void)
 	// TODO: We don't know how the layout will be bound: compute or graphic stages ?
 	// See this when we will refactor the pipeline layout
 	_bindingTable.SetStage(IsCompute() ? VK_SHADER_STAGE_ALL : VK_SHADER_STAGE_ALL);
-	if (!_isUpdateBound)
-	{
-		_updateIndex = Application::update.AddListener(std::bind(&ShaderProgram::Update, this));
-		_isUpdateBound = true;
-	}
+
+	// The sources must not be compiled by the pool and this thread at the same time
+	if (_prewarm.valid())
+		_prewarm.wait();
 
 	for (auto & shaderSource : _shaderSources)
 	{
@@ -56,6 +63,28 @@ void		ShaderProgram::CompileAndLink(void)
 	_bindingTable.GenerateSetLayouts();
 }
 
+void		ShaderProgram::Precompile(const std::vector< ShaderProgram * > & programs)
+{
+	std::unordered_set< ShaderProgram * >	uniquePrograms;
+	std::vector< ShaderSource * >			sources;
+
+	for (auto program : programs)
+	{
+		if (program->IsCompiled() || program->_prewarm.valid() || !uniquePrograms.insert(program).second)
+			continue ;
+		sources.insert(sources.end(), program->_shaderSources.begin(), program->_shaderSources.end());
+	}
+
+	if (sources.empty())
+		return ;
+
+	// Only the SPIR-V generation runs in parallel, the modules and layouts are created by CompileAndLink
+	ThreadPool::GetShared().ParallelFor(sources.size(), [&](size_t i)
+	{
+		sources[i]->CompileSpirV();
+	});
+}
+
 bool		ShaderProgram::IsCompiled(void) const noexcept
 {
 	return _shaderStages.size() > 0;
@@ -70,6 +99,7 @@ void		ShaderProgram::SetSourceFile(const std::string & file, VkShaderStageFlagBi
 		_name = GetFileName(file);
 
 	_shaderSources.push_back(new ShaderSource(file, stage));
+	_shaderSources.back()->SetDefines(_defines);
 }
 
 const std::string	ShaderProgram::GetFileName(const std::string & filePath)
@@ -91,22 +121,100 @@ bool		ShaderProgram::IsCompute(void) const noexcept
 	});
 }
 
-void		ShaderProgram::Update(void)
+ShaderProgram *	ShaderProgram::CreateCopy(KeywordMask keywordMask, const std::vector< std::string > & defines) const
 {
-	auto device = VulkanInstance::Get()->GetDevice();
+	ShaderProgram *	program = new ShaderProgram();
 
-	for (auto & shaderSource : _shaderSources)
+	// The defines are set before the sources so they get them
+	program->_defines = defines;
+	program->_keywordMask = keywordMask;
+	for (const auto & shaderSource : _shaderSources)
+		program->SetSourceFile(shaderSource->GetPath(), shaderSource->GetStage());
+	program->_name = _name;
+
+	return program;
+}
+
+ShaderProgram *	ShaderProgram::Clone(void) const
+{
+	return CreateCopy(_keywordMask, _defines);
+}
+
+ShaderProgram *	ShaderProgram::GetVariant(KeywordMask keywordMask)
+{
+	const auto & keywords = GetKeywords();
+
+	keywordMask &= keywords.GetValidMask();
+	if (keywordMask == 0)
+		return this;
+
+	auto variant = _variants.find(keywordMask);
+	if (variant != _variants.end())
+		return variant->second;
+
+	std::vector< std::string >	defines = _defines;
+	std::vector< std::string >	keywordDefines = keywords.GetDefines(keywordMask);
+
+	defines.insert(defines.end(), keywordDefines.begin(), keywordDefines.end());
+
+	ShaderProgram *	program = CreateCopy(keywordMask, defines);
+	program->_name = _name + " [" + keywords.ToString(keywordMask) + "]";
+
+	_variants[keywordMask] = program;
+
+	return program;
+}
+
+void		ShaderProgram::PrewarmVariants(const std::vector< KeywordMask > & keywordMasks)
+{
+	for (auto keywordMask : keywordMasks)
 	{
-		if (shaderSource->NeedReload())
+		ShaderProgram *	program = GetVariant(keywordMask);
+
+		if (program->IsCompiled() || program->_prewarm.valid())
+			continue ;
+
+		program->_prewarm = ThreadPool::GetShared().Submit([program]()
 		{
-			for (auto stage : _shaderStages)
-				vkDestroyShaderModule(device, stage.module, nullptr);
-			_shaderStages.clear();
-			Application::Get()->GetMaterialTable()->UpdateMaterial(this);
-		}
+			for (auto shaderSource : program->_shaderSources)
+				shaderSource->CompileSpirV();
+		}).share();
 	}
 }
 
+bool		ShaderProgram::IsPrewarming(void) const noexcept
+{
+	return _prewarm.valid() && _prewarm.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+const ShaderKeywords &	ShaderProgram::GetKeywords(void)
+{
+	// The keywords are read from the files only when a variant is needed
+	if (!_keywordsParsed)
+	{
+		for (const auto & shaderSource : _shaderSources)
+			_keywords.ParseFile(shaderSource->GetPath());
+		_keywordsParsed = true;
+	}
+
+	return _keywords;
+}
+
+KeywordMask	ShaderProgram::GetKeywordMask(void) const noexcept
+{
+	return _keywordMask;
+}
+
+void		ShaderProgram::Swap(ShaderProgram & program) noexcept
+{
+	std::swap(_shaderSources, program._shaderSources);
+	std::swap(_shaderStages, program._shaderStages);
+	std::swap(_threadWidth, program._threadWidth);
+	std::swap(_threadHeight, program._threadHeight);
+	std::swap(_threadDepth, program._threadDepth);
+	_bindingTable.Swap(program._bindingTable);
+}
+
 VkPipelineShaderStageCreateInfo *		ShaderProgram::GetShaderStages(void)
 {
 	return _shaderStages.data();
@@ -124,6 +232,26 @@ bool			ShaderProgram::HasBinding(const std::string & bindingName) const
 	return _bindingTable.HasBinding(bindingName);
 }
 
+std::vector< std::string >	ShaderProgram::GetSourceFiles(void) const
+{
+	std::vector< std::string >	files;
+
+	for (const auto & shaderSource : _shaderSources)
+	{
+		const auto & includedFiles = shaderSource->GetIncludedFiles();
+
+		files.push_back(shaderSource->GetPath());
+		files.insert(files.end(), includedFiles.begin(), includedFiles.end());
+	}
+
+	return files;
+}
+
+const std::vector< ShaderSource * > &	ShaderProgram::GetShaderSources(void) const
+{
+	return _shaderSources;
+}
+
 const ShaderBindingTable *	ShaderProgram::GetShaderBindingTable(void) const
 {
 	return &_bindingTable;
@@ -3,13 +3,15 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <future>
 
 #include "IncludeDeps.hpp"
 
 #include GLFW_INCLUDE
 #include "ShaderSource.hpp"
-#include "Core/Delegate.tpp"
 #include "Core/Shaders/ShaderBindingTable.hpp"
+#include "Core/Shaders/ShaderKeywords.hpp"
 
 namespace LWGC
 {
@@ -23,10 +25,15 @@ namespace LWGC
 			uint32_t										_threadWidth;
 			uint32_t										_threadHeight;
 			uint32_t										_threadDepth;
-			DelegateIndex<void ()>							_updateIndex;
-			bool											_isUpdateBound;
+			ShaderKeywords									_keywords;
+			bool											_keywordsParsed;
+			KeywordMask										_keywordMask;
+			std::vector< std::string >						_defines;
+			std::unordered_map< KeywordMask, ShaderProgram * >	_variants;
+			std::shared_future< void >						_prewarm;
 
 			const std::string		GetFileName(const std::string & filePath);
+			ShaderProgram *			CreateCopy(KeywordMask keywordMask, const std::vector< std::string > & defines) const;
 
 		public:
 			ShaderProgram(void);
@@ -38,13 +45,35 @@ namespace LWGC
 
 			void		CompileAndLink(void);
 
+			// Generate the SPIR-V of all the programs not yet compiled on a thread pool, CompileAndLink will reuse it
+			static void	Precompile(const std::vector< ShaderProgram * > & programs);
+
+			// New uncompiled program with the same source files, used to recompile a program while the old one is still in use
+			ShaderProgram *	Clone(void) const;
+			// Exchange the compiled sources, modules and layouts with another program of the same source files
+			void		Swap(ShaderProgram & program) noexcept;
+
+			// Program compiled with the keywords of the mask defined, created on the first call and compiled
+			// lazily by the material using it. A mask of 0 returns this program.
+			ShaderProgram *	GetVariant(KeywordMask keywordMask);
+			// Create the variants and start the generation of their SPIR-V on the shared thread pool, CompileAndLink
+			// waits for it
+			void		PrewarmVariants(const std::vector< KeywordMask > & keywordMasks);
+			// True while the SPIR-V started by PrewarmVariants is generated
+			bool		IsPrewarming(void) const noexcept;
+			// Keywords declared by the source files of the program
+			const ShaderKeywords &	GetKeywords(void);
+			KeywordMask	GetKeywordMask(void) const noexcept;
+
 			void		Bind(void);
-			void		Update(void);
 			bool		IsCompiled(void) const noexcept;
 			bool		IsCompute(void) const noexcept;
 
 			void								SetSourceFile(const std::string & file, VkShaderStageFlagBits stage);
 			VkPipelineShaderStageCreateInfo *	GetShaderStages();
+			// The source file of each stage and all the files they include
+			std::vector< std::string >			GetSourceFiles(void) const;
+			const std::vector< ShaderSource * > &	GetShaderSources(void) const;
 			void								GetWorkingThreadSize(uint32_t & width, uint32_t & height, uint32_t & depth);
 			bool								HasBinding(const std::string & bindingName) const;
 			const ShaderBindingTable *			GetShaderBindingTable(void) const;
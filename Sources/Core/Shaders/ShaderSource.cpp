@@ -1,10 +1,9 @@
 #include "ShaderSource.hpp"
 
 #include <sys/stat.h>
-#include <fstream>
-#include <unistd.h>
 #include "IncludeDeps.hpp"
-#include "Utils/Utils.hpp"
+#include "Core/Shaders/ShaderCompiler.hpp"
+#include "Core/Shaders/SpirVCache.hpp"
 
 #include SPIRV_CROSS_INCLUDE
 
@@ -14,7 +13,7 @@ using namespace LWGC;
 
 std::vector< std::string > ShaderSource::shaderIncludePaths;
 
-ShaderSource::ShaderSource(void) : _sourceFile({"", 0}), _module(VK_NULL_HANDLE), _threadWidth(1), _threadHeight(1), _threadDepth(1)
+ShaderSource::ShaderSource(void) : _sourceFile({"", 0}), _module(VK_NULL_HANDLE), _reflection({{}, {}, 1, 1, 1}), _threadWidth(1), _threadHeight(1), _threadDepth(1)
 {
 }
 
@@ -33,23 +32,6 @@ ShaderSource::~ShaderSource(void)
 	}
 }
 
-std::vector< char > ShaderSource::ReadFile(const std::string & fileName)
-{
-	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open())
-	    throw std::runtime_error("failed to open file!");
-
-	size_t fileSize = (size_t) file.tellg();
-	std::vector< char > buffer(fileSize);
-
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
-	file.close();
-
-	return buffer;
-}
-
 long		ShaderSource::GetFileModificationTime(const std::string & file) const
 {
 	struct stat st;
@@ -63,21 +45,6 @@ long		ShaderSource::GetFileModificationTime(const std::string & file) const
 #endif
 }
 
-std::string	ShaderSource::StageToText(const VkShaderStageFlagBits stage)
-{
-	switch (stage)
-	{
-		case VK_SHADER_STAGE_FRAGMENT_BIT:
-			return "frag";
-		case VK_SHADER_STAGE_VERTEX_BIT:
-			return "vert";
-		case VK_SHADER_STAGE_COMPUTE_BIT:
-			return "comp";
-		default:
-			throw std::runtime_error("Unhandled stage");
-	}
-}
-
 void		ShaderSource::SetSourceFile(const std::string & file, const VkShaderStageFlagBits stage)
 {
 	struct stat buffer;
@@ -101,61 +68,20 @@ void		ShaderSource::SetSourceFile(const std::string & file, const VkShaderStageF
 	_sourceFile = ShaderFileInfo{filePath, GetFileModificationTime(file)};
 }
 
-void		ShaderSource::Compile(void)
-{
-	char path[2048];
-	getcwd(path, sizeof(path));
-
-	_sourceFile.lastModificationTime = GetFileModificationTime(_sourceFile.path);
-
-	std::string compilerPath = "glslangValidator";
-
-	// If the compiler is in the same directory, we need to add ./
-	if (access(compilerPath.c_str(), F_OK) != -1)
-		compilerPath = "./" + compilerPath;
-
-	std::string isHlslSource = "";
-
-	if (GetExtension(_sourceFile.path) == "hlsl")
-		isHlslSource = "-D ";
-
-	// I gave up using the c++ api of glslang, it's totally unusable
-	std::string cmd = compilerPath + " -e main -V " + isHlslSource + " -S " + StageToText(_stage) + " -I" + path;
-	for (const auto & p : shaderIncludePaths)
-		cmd += " -I" + p;
-	std::string tmpPidPath = tmpFilePath + std::to_string(getpid());
-	cmd += " " + _sourceFile.path + " -o " + tmpPidPath;
-	if (system(cmd.c_str()) != 0)
-		throw std::runtime_error("Shader compilation error");
-
-	// Read back spriv from tmp file
-	const auto & spirV = ReadFile(tmpPidPath);
-
-	_SpirVCode.resize(spirV.size() / 4);
-	std::memcpy(_SpirVCode.data(), spirV.data(), spirV.size());
-
-	// Create Vulkan module
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = spirV.size();
-	createInfo.pCode = reinterpret_cast< uint32_t * >(_SpirVCode.data());
-
-	if (vkCreateShaderModule(VulkanInstance::Get()->GetDevice(), &createInfo, nullptr, &_module) != VK_SUCCESS)
-		throw std::runtime_error("failed to create shader module!");
-}
-
-void		ShaderSource::GenerateBindingTable(ShaderBindingTable & bindingTable)
+// spirv_cross is only needed when the shader is not in the SpirVCache
+static ShaderReflection	ReflectSpirV(std::vector< uint32_t > spirV, VkShaderStageFlagBits stage)
 {
-	auto reflection = new spirv_cross::CompilerReflection(std::move(_SpirVCode));
+	ShaderReflection	result = {{}, {}, 1, 1, 1};
+	auto reflection = new spirv_cross::CompilerReflection(std::move(spirV));
 
 	// Retrieve working group size of compute shader
-	if (_stage == VK_SHADER_STAGE_COMPUTE_BIT)
+	if (stage == VK_SHADER_STAGE_COMPUTE_BIT)
 	{
-		const auto & entry = reflection->get_entry_point("main", spv::ExecutionModel::ExecutionModelGLCompute);
+		const auto & entry = reflection->get_entry_point(ShaderCompiler::EntryPoint, spv::ExecutionModel::ExecutionModelGLCompute);
 
-		_threadWidth = entry.workgroup_size.x;
-		_threadHeight = entry.workgroup_size.y;
-		_threadDepth = entry.workgroup_size.z;
+		result.threadWidth = entry.workgroup_size.x;
+		result.threadHeight = entry.workgroup_size.y;
+		result.threadDepth = entry.workgroup_size.z;
 	}
 
 	spirv_cross::ShaderResources resources = reflection->get_shader_resources();
@@ -164,11 +90,12 @@ void		ShaderSource::GenerateBindingTable(ShaderBindingTable & bindingTable)
 		unsigned set = reflection->get_decoration(resource.id, spv::DecorationDescriptorSet);
 		unsigned binding = reflection->get_decoration(resource.id, spv::DecorationBinding);
 		const spirv_cross::SPIRType & type = reflection->get_type(resource.type_id);
-		auto & shaderBinding = bindingTable.AddBinding(resource.name, set, binding, descriptorType);
+		ShaderBinding shaderBinding = {static_cast< int >(set), static_cast< int >(binding), descriptorType, 0};
 		if (type.basetype == spirv_cross::SPIRType::Struct)
 		{
 			shaderBinding.elementSize = reflection->get_declared_struct_size(type);
 		}
+		result.bindings.push_back({resource.name, shaderBinding});
 	};
 
 	const auto & addPushConstant = [&](const spirv_cross::Resource & resource) {
@@ -179,7 +106,7 @@ void		ShaderSource::GenerateBindingTable(ShaderBindingTable & bindingTable)
 		{
 			const auto & ranges = reflection->get_active_buffer_ranges(resource.id);
 			for (auto & range : ranges)
-				bindingTable.AddPushConstant(reflection->get_member_name(resource.base_type_id, range.index), range.offset, range.range);
+				result.pushConstants.push_back({reflection->get_member_name(resource.base_type_id, range.index), {static_cast< uint32_t >(range.offset), static_cast< uint32_t >(range.range)}});
 		}
 		else
 		{
@@ -226,6 +153,116 @@ void		ShaderSource::GenerateBindingTable(ShaderBindingTable & bindingTable)
 	}
 
 	delete reflection;
+
+	return result;
+}
+
+void		ShaderSource::CompileSpirV(void)
+{
+	ShaderCompiler::Result	preprocessed;
+	ShaderCompiler::Result	result;
+	SpirVCache::Entry		cacheEntry;
+	uint64_t				cacheKey = 0;
+
+	_sourceFile.lastModificationTime = GetFileModificationTime(_sourceFile.path);
+
+	try {
+		// The preprocessed source contains the includes, so it's enough to find the shader in the cache
+		if (SpirVCache::IsEnabled())
+		{
+			preprocessed = ShaderCompiler::Preprocess(_sourceFile.path, _stage, shaderIncludePaths, _defines);
+			if (preprocessed.success)
+			{
+				cacheKey = SpirVCache::ComputeKey(preprocessed.preprocessedSource, _defines, _stage, ShaderCompiler::EntryPoint);
+				if (SpirVCache::Load(cacheKey, cacheEntry))
+				{
+					_compileErrors.clear();
+					_SpirVCode = std::move(cacheEntry.spirV);
+					_reflection = std::move(cacheEntry.reflection);
+					_includedFiles = std::move(cacheEntry.includedFiles);
+					return ;
+				}
+			}
+		}
+
+		// On a cache miss the preprocessed source is compiled, the preprocessor doesn't run a second time
+		if (cacheKey != 0)
+			result = ShaderCompiler::CompilePreprocessed(preprocessed, _sourceFile.path, _stage);
+		else
+			result = ShaderCompiler::Compile(_sourceFile.path, _stage, shaderIncludePaths, _defines);
+	} catch (const std::runtime_error & e) {
+		_SpirVCode.clear();
+		_compileErrors = _sourceFile.path + ": " + e.what();
+		return ;
+	}
+
+	std::string diagnostics = ShaderCompiler::FormatDiagnostics(result.diagnostics);
+
+	_includedFiles = std::move(result.includedFiles);
+
+	if (!result.success)
+	{
+		_SpirVCode.clear();
+		_compileErrors = diagnostics.empty() ? "Shader compilation error: " + _sourceFile.path : diagnostics;
+		return ;
+	}
+
+	// Warnings
+	if (!diagnostics.empty())
+		std::cout << diagnostics;
+
+	_compileErrors.clear();
+	_SpirVCode = std::move(result.spirV);
+
+	try {
+		_reflection = ReflectSpirV(_SpirVCode, _stage);
+	} catch (const std::runtime_error & e) {
+		_SpirVCode.clear();
+		_compileErrors = _sourceFile.path + ": reflection failed: " + e.what();
+		return ;
+	}
+
+	if (cacheKey != 0 && !SpirVCache::Store(cacheKey, {_SpirVCode, _reflection, _includedFiles}))
+		std::cerr << "Can't write shader cache entry for " << _sourceFile.path << " in " << SpirVCache::GetDirectory() << std::endl;
+}
+
+void		ShaderSource::Compile(void)
+{
+	// Reuse the SPIR-V of CompileSpirV unless the file changed since
+	if ((_SpirVCode.empty() && _compileErrors.empty()) || NeedReload())
+		CompileSpirV();
+
+	if (!_compileErrors.empty())
+	{
+		std::string errors = std::move(_compileErrors);
+		_compileErrors.clear();
+		throw std::runtime_error(errors);
+	}
+
+	// Create Vulkan module
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = _SpirVCode.size() * sizeof(uint32_t);
+	createInfo.pCode = _SpirVCode.data();
+
+	if (vkCreateShaderModule(VulkanInstance::Get()->GetDevice(), &createInfo, nullptr, &_module) != VK_SUCCESS)
+		throw std::runtime_error("failed to create shader module!");
+
+	// The module holds the code now, the reflection is kept for GenerateBindingTable
+	_SpirVCode.clear();
+}
+
+void		ShaderSource::GenerateBindingTable(ShaderBindingTable & bindingTable)
+{
+	bindingTable.AddReflection(_reflection);
+
+	// Retrieve working group size of compute shader
+	if (_stage == VK_SHADER_STAGE_COMPUTE_BIT)
+	{
+		_threadWidth = _reflection.threadWidth;
+		_threadHeight = _reflection.threadHeight;
+		_threadDepth = _reflection.threadDepth;
+	}
 }
 
 void		ShaderSource::GetWorkingThreadSize(uint32_t & width, uint32_t & height, uint32_t & depth) const
@@ -235,6 +272,11 @@ void		ShaderSource::GetWorkingThreadSize(uint32_t & width, uint32_t & height, ui
 	depth = _threadDepth;
 }
 
+void		ShaderSource::SetDefines(const std::vector< std::string > & defines)
+{
+	_defines = defines;
+}
+
 bool		ShaderSource::NeedReload(void) const
 {
 	if (_sourceFile.lastModificationTime != GetFileModificationTime(_sourceFile.path))
@@ -243,6 +285,11 @@ bool		ShaderSource::NeedReload(void) const
 		return false;
 }
 
+const std::string &		ShaderSource::GetPath(void) const
+{
+	return _sourceFile.path;
+}
+
 VkShaderModule			ShaderSource::GetModule(void) const
 {
 	return _module;
@@ -258,6 +305,11 @@ bool		ShaderSource::HasSource(void) const
 	return !_sourceFile.path.empty();
 }
 
+const std::vector< std::string > &	ShaderSource::GetIncludedFiles(void) const
+{
+	return _includedFiles;
+}
+
 void		ShaderSource::AddIncludePath(const std::string & path)
 {
 	shaderIncludePaths.push_back(path);
@@ -25,16 +25,16 @@ namespace LWGC
 			VkShaderModule			_module;
 			VkShaderStageFlagBits	_stage;
 			std::vector< uint32_t >	_SpirVCode;
+			std::string				_compileErrors;
+			ShaderReflection		_reflection;
+			std::vector< std::string >	_includedFiles;
+			std::vector< std::string >	_defines;
 
 			uint32_t				_threadWidth;
 			uint32_t				_threadHeight;
 			uint32_t				_threadDepth;
 
-			std::vector< char >		ReadFile(const std::string & fileName);
 			long					GetFileModificationTime(const std::string & file) const;
-			std::string				StageToText(const VkShaderStageFlagBits stage);
-
-			const std::string		tmpFilePath = "/tmp/LWGC_spirV_";
 
 			static std::vector< std::string >	shaderIncludePaths;
 
@@ -49,13 +49,20 @@ namespace LWGC
 			ShaderSource &	operator=(ShaderSource const & src) = delete;
 
 			void	SetSourceFile(const std::string & file, const VkShaderStageFlagBits stage);
+			// "NAME" or "NAME=VALUE", must be set before the compilation
+			void	SetDefines(const std::vector< std::string > & defines);
 			bool	NeedReload(void) const;
+			// Generate the SPIR-V only, can be called from any thread. The errors are thrown by the next Compile
+			void	CompileSpirV(void);
+			// Create the shader module, the SPIR-V is generated unless CompileSpirV was called before
 			void	Compile(void);
 			void	GenerateBindingTable(ShaderBindingTable & bindingTable);
 
+			const std::string &		GetPath(void) const;
 			VkShaderModule			GetModule(void) const;
 			VkShaderStageFlagBits	GetStage(void) const;
 			bool					HasSource(void) const;
+			const std::vector< std::string > &	GetIncludedFiles(void) const;
 			void					GetWorkingThreadSize(uint32_t & width, uint32_t & height, uint32_t & depth) const;
 
 			static void	AddIncludePath(const std::string & path);
@@ -0,0 +1,171 @@
+#include "SpirVCache.hpp"
+
+#include <dirent.h>
+#include <cstdio>
+
+#include "Core/MeshCache.hpp"
+#include "Core/Shaders/ShaderCompiler.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/Utils.hpp"
+
+using namespace LWGC;
+
+const std::string	SpirVCache::Extension = ".lwgcspv";
+std::string			SpirVCache::_directory = "Cache/Shaders/";
+bool				SpirVCache::_enabled = true;
+std::mutex			SpirVCache::_directoryMutex;
+
+uint64_t			SpirVCache::ComputeKey(const std::string & preprocessedSource, const std::vector< std::string > & defines, VkShaderStageFlagBits stage, const std::string & entryPoint)
+{
+	const std::string &	compilerVersion = ShaderCompiler::GetVersion();
+	uint32_t			version = Version;
+	uint64_t			hash = MeshCache::HashBytes(preprocessedSource.data(), preprocessedSource.size());
+
+	// The size of each string is hashed too so "AB" + "C" and "A" + "BC" don't collide
+	for (const auto & define : defines)
+	{
+		uint64_t size = define.size();
+		hash = MeshCache::HashBytes(&size, sizeof(size), hash);
+		hash = MeshCache::HashBytes(define.data(), define.size(), hash);
+	}
+	hash = MeshCache::HashBytes(&stage, sizeof(stage), hash);
+	hash = MeshCache::HashBytes(entryPoint.data(), entryPoint.size() + 1, hash);
+	hash = MeshCache::HashBytes(compilerVersion.data(), compilerVersion.size() + 1, hash);
+	hash = MeshCache::HashBytes(&version, sizeof(version), hash);
+
+	return hash;
+}
+
+std::string			SpirVCache::GetEntryPath(uint64_t key)
+{
+	char	name[17];
+
+	snprintf(name, sizeof(name), "%016llx", static_cast< unsigned long long >(key));
+
+	return _directory + name + Extension;
+}
+
+bool				SpirVCache::Load(uint64_t key, Entry & entry)
+{
+	MappedFile	file;
+
+	if (!_enabled || !file.Open(GetEntryPath(key)))
+		return false;
+
+	try {
+		MeshCache::Reader	reader(file.GetData(), file.GetSize());
+
+		// The key is stored to detect a renamed or corrupted file
+		if (reader.Read< uint32_t >() != Magic || reader.Read< uint32_t >() != Version || reader.Read< uint64_t >() != key)
+			return false;
+
+		entry.reflection.threadWidth = reader.Read< uint32_t >();
+		entry.reflection.threadHeight = reader.Read< uint32_t >();
+		entry.reflection.threadDepth = reader.Read< uint32_t >();
+
+		entry.reflection.bindings.resize(reader.ReadCount(sizeof(uint32_t) + sizeof(ShaderBinding)));
+		for (auto & binding : entry.reflection.bindings)
+		{
+			binding.name = reader.ReadString();
+			binding.binding = reader.Read< ShaderBinding >();
+		}
+
+		entry.reflection.pushConstants.resize(reader.ReadCount(sizeof(uint32_t) + sizeof(PushConstantBinding)));
+		for (auto & pushConstant : entry.reflection.pushConstants)
+		{
+			pushConstant.name = reader.ReadString();
+			pushConstant.range = reader.Read< PushConstantBinding >();
+		}
+
+		entry.includedFiles.resize(reader.ReadCount(sizeof(uint32_t)));
+		for (auto & includedFile : entry.includedFiles)
+			includedFile = reader.ReadString();
+
+		uint32_t wordCount = reader.ReadCount(sizeof(uint32_t));
+		auto words = static_cast< const uint32_t * >(reader.ReadBytes(wordCount * sizeof(uint32_t)));
+		entry.spirV.assign(words, words + wordCount);
+	} catch (const std::exception & e) {
+		// bad_alloc and length_error too, the counts come from the file
+		std::cerr << "Invalid shader cache entry " << GetEntryPath(key) << ": " << e.what() << std::endl;
+		return false;
+	}
+
+	return !entry.spirV.empty();
+}
+
+bool				SpirVCache::Store(uint64_t key, const Entry & entry)
+{
+	MeshCache::Writer	writer;
+
+	if (!_enabled)
+		return false;
+
+	{
+		std::lock_guard< std::mutex >	lock(_directoryMutex);
+
+		if (!CreateDirectories(_directory))
+			return false;
+	}
+
+	writer.Write< uint32_t >(static_cast< uint32_t >(Magic));
+	writer.Write< uint32_t >(static_cast< uint32_t >(Version));
+	writer.Write(key);
+
+	writer.Write(entry.reflection.threadWidth);
+	writer.Write(entry.reflection.threadHeight);
+	writer.Write(entry.reflection.threadDepth);
+
+	writer.Write< uint32_t >(static_cast< uint32_t >(entry.reflection.bindings.size()));
+	for (const auto & binding : entry.reflection.bindings)
+	{
+		writer.WriteString(binding.name);
+		writer.Write(binding.binding);
+	}
+
+	writer.Write< uint32_t >(static_cast< uint32_t >(entry.reflection.pushConstants.size()));
+	for (const auto & pushConstant : entry.reflection.pushConstants)
+	{
+		writer.WriteString(pushConstant.name);
+		writer.Write(pushConstant.range);
+	}
+
+	writer.Write< uint32_t >(static_cast< uint32_t >(entry.includedFiles.size()));
+	for (const auto & includedFile : entry.includedFiles)
+		writer.WriteString(includedFile);
+
+	writer.Write< uint32_t >(static_cast< uint32_t >(entry.spirV.size()));
+	writer.WriteBytes(entry.spirV.data(), entry.spirV.size() * sizeof(uint32_t));
+
+	return writer.SaveToFile(GetEntryPath(key));
+}
+
+void				SpirVCache::Clear(void)
+{
+	DIR *			dir = opendir(_directory.c_str());
+	struct dirent *	file;
+
+	if (dir == nullptr)
+		return ;
+
+	while ((file = readdir(dir)) != nullptr)
+	{
+		std::string name = file->d_name;
+
+		if (name.size() > Extension.size() && name.compare(name.size() - Extension.size(), Extension.size(), Extension) == 0)
+			std::remove((_directory + name).c_str());
+	}
+
+	closedir(dir);
+}
+
+void				SpirVCache::SetDirectory(const std::string & directory)
+{
+	_directory = directory;
+
+	if (!_directory.empty() && _directory.back() != '/')
+		_directory += '/';
+}
+
+const std::string &	SpirVCache::GetDirectory(void) { return _directory; }
+void				SpirVCache::SetEnabled(bool enabled) { _enabled = enabled; }
+bool				SpirVCache::IsEnabled(void) { return _enabled; }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Shaders/ShaderBindingTable.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Persistent cache of compiled shaders (.lwgcspv), content addressed: the key is a hash of the preprocessed
+	// source (so it contains all the includes), the defines, the stage, the entry point and the compiler version.
+	// An edit in an included file only changes the key of the shaders that include it. The reflection is stored
+	// with the SPIR-V so a cache hit doesn't need spirv_cross.
+	class		SpirVCache
+	{
+		public:
+			static const uint32_t		Version = 1;
+			static const uint32_t		Magic = 0x5653574C; // "LWSV"
+			static const std::string	Extension;
+
+			struct	Entry
+			{
+				std::vector< uint32_t >		spirV;
+				ShaderReflection			reflection;
+				std::vector< std::string >	includedFiles;
+			};
+
+		private:
+			static std::string	_directory;
+			static bool			_enabled;
+			static std::mutex	_directoryMutex;
+
+			static std::string	GetEntryPath(uint64_t key);
+
+		public:
+			SpirVCache(void) = delete;
+			SpirVCache(const SpirVCache &) = delete;
+			virtual ~SpirVCache(void) = delete;
+
+			SpirVCache &	operator=(SpirVCache const & src) = delete;
+
+			static uint64_t	ComputeKey(const std::string & preprocessedSource, const std::vector< std::string > & defines, VkShaderStageFlagBits stage, const std::string & entryPoint);
+
+			// Load and Store can be called from any thread, Store fails silently if the directory is not writable
+			static bool		Load(uint64_t key, Entry & entry);
+			static bool		Store(uint64_t key, const Entry & entry);
+			// Remove all the entries of the cache directory
+			static void		Clear(void);
+
+			static void					SetDirectory(const std::string & directory);
+			static const std::string &	GetDirectory(void);
+			static void					SetEnabled(bool enabled);
+			static bool					IsEnabled(void);
+	};
+}
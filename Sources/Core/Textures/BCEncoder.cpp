@@ -0,0 +1,600 @@
+#include "BCEncoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+using namespace LWGC;
+
+struct		BC7Mode
+{
+	int		subsetCount;
+	int		partitionBits;
+	int		rotationBits;
+	int		indexSelectionBits;
+	int		colorBits;
+	int		alphaBits;
+	int		endpointPBits;
+	int		sharedPBits;
+	int		indexBits;
+	int		secondaryIndexBits;
+};
+
+static const BC7Mode	BC7Modes[8] = {
+	{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+	{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+	{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+	{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+	{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+	{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+	{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+	{2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// One bit per pixel, set when the pixel belongs to the second subset
+static const uint16_t	BC7Partitions2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+static const uint8_t	BC7Partitions3[64][16] = {
+	{0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2}, {0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1}, {0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1}, {0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1},
+	{0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2}, {0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2}, {0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1}, {0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1},
+	{0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2}, {0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2},
+	{0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2}, {0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2}, {0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2}, {0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0},
+	{0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2}, {0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0}, {0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2}, {0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1},
+	{0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2}, {0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1}, {0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2}, {0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0},
+	{0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0}, {0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2}, {0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0}, {0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1},
+	{0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2}, {0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2}, {0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1}, {0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1},
+	{0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2}, {0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1}, {0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2}, {0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0},
+	{0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0}, {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0}, {0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0}, {0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1},
+	{0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1}, {0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1}, {0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2},
+	{0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1}, {0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1}, {0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1}, {0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1},
+	{0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2}, {0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1}, {0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2}, {0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2},
+	{0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2}, {0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2}, {0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2},
+	{0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2}, {0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2}, {0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2}, {0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2},
+	{0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1}, {0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2}, {0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2}, {0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0},
+};
+
+// Pixels whose index is stored with one bit less, the first pixel is always the anchor of the first subset
+static const uint8_t	BC7Anchors2[64] = {
+	15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15, 15, 2, 8, 2, 2, 8, 8,15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15,15, 6, 8, 2, 8,15,15, 2, 8, 2, 2, 2,15,15, 6, 6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+};
+
+static const uint8_t	BC7Anchors3Second[64] = {
+	 3, 3,15,15, 8, 3,15,15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8,15, 3, 3, 6,10, 5, 8, 8, 6, 8, 5,15,15,
+	 8,15, 3, 5, 6,10, 8,15,15, 3,15, 5,15,15,15,15, 3,15, 5, 5, 5, 8, 5,10, 5,10, 8,13,15,12, 3, 3,
+};
+
+static const uint8_t	BC7Anchors3Third[64] = {
+	15, 8, 8, 3,15,15, 3, 8,15,15,15,15,15,15,15, 8,15, 8,15, 3,15, 8,15, 8, 3,15, 6,10,15,15,10, 8,
+	15, 3,15,10,10, 8, 9,10, 6,15, 8,15, 3, 6, 6, 8,15, 3,15,15,15,15,15,15,15,15,15,15, 3,15,15, 8,
+};
+
+static const int		BC7Weights2[4] = {0, 21, 43, 64};
+static const int		BC7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static const int		BC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+class		BlockBitReader
+{
+	private:
+		const uint8_t *	_block;
+		int				_position;
+
+	public:
+		BlockBitReader(const uint8_t * block) : _block(block), _position(0) {}
+
+		int		Read(int bitCount)
+		{
+			int	value = 0;
+
+			for (int i = 0; i < bitCount; i++, _position++)
+				value |= ((_block[_position >> 3] >> (_position & 7)) & 1) << i;
+			return value;
+		}
+};
+
+static uint16_t		PackRGB565(int r, int g, int b)
+{
+	return static_cast< uint16_t >(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static void			UnpackRGB565(uint16_t c, int * rgb)
+{
+	int r = (c >> 11) & 31;
+	int g = (c >> 5) & 63;
+	int b = c & 31;
+
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void			WriteColorBlock(const uint8_t * rgba, uint8_t * block)
+{
+	int		min[3] = {255, 255, 255};
+	int		max[3] = {0, 0, 0};
+	int		mean[3] = {0, 0, 0};
+
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+		{
+			min[c] = std::min(min[c], (int)rgba[i * 4 + c]);
+			max[c] = std::max(max[c], (int)rgba[i * 4 + c]);
+			mean[c] += rgba[i * 4 + c];
+		}
+
+	// Pick the bounding box diagonal that follows the colors: flip green and blue when they are anti-correlated with red
+	int		covRG = 0, covRB = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int r = rgba[i * 4 + 0] * 16 - mean[0];
+		covRG += r * (rgba[i * 4 + 1] * 16 - mean[1]);
+		covRB += r * (rgba[i * 4 + 2] * 16 - mean[2]);
+	}
+	if (covRG < 0)
+		std::swap(min[1], max[1]);
+	if (covRB < 0)
+		std::swap(min[2], max[2]);
+
+	// Inset the box a bit, the extremes are rarely worth an endpoint
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (max[c] - min[c]) / 16;
+		max[c] = std::min(255, std::max(0, max[c] - inset));
+		min[c] = std::min(255, std::max(0, min[c] + inset));
+	}
+
+	uint16_t	c0 = PackRGB565(max[0], max[1], max[2]);
+	uint16_t	c1 = PackRGB565(min[0], min[1], min[2]);
+	uint32_t	indices = 0;
+
+	// c0 > c1 selects the 4 colors mode
+	if (c0 < c1)
+		std::swap(c0, c1);
+
+	if (c0 != c1)
+	{
+		int		palette[4][3];
+
+		UnpackRGB565(c0, palette[0]);
+		UnpackRGB565(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestDistance = INT_MAX;
+
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = rgba[i * 4 + 0] - palette[p][0];
+				int dg = rgba[i * 4 + 1] - palette[p][1];
+				int db = rgba[i * 4 + 2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	block[0] = c0 & 0xFF;
+	block[1] = c0 >> 8;
+	block[2] = c1 & 0xFF;
+	block[3] = c1 >> 8;
+	std::memcpy(block + 4, &indices, 4);
+}
+
+static void			ReadColorBlock(const uint8_t * block, uint8_t * rgba, bool allowTransparency)
+{
+	uint16_t	c0 = block[0] | (block[1] << 8);
+	uint16_t	c1 = block[2] | (block[3] << 8);
+	uint32_t	indices;
+	int			palette[4][4];
+
+	std::memcpy(&indices, block + 4, 4);
+	UnpackRGB565(c0, palette[0]);
+	UnpackRGB565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+	if (c0 > c1 || !allowTransparency)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	}
+	else
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		palette[3][3] = 0;
+	}
+
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = palette[(indices >> (i * 2)) & 3][c];
+}
+
+void				BCEncoder::EncodeBC1Block(const uint8_t * rgba, uint8_t * block) noexcept
+{
+	WriteColorBlock(rgba, block);
+}
+
+void				BCEncoder::EncodeBC2Block(const uint8_t * rgba, uint8_t * block) noexcept
+{
+	uint64_t	alpha = 0;
+
+	for (int i = 0; i < 16; i++)
+		alpha |= (uint64_t)((rgba[i * 4 + 3] * 15 + 127) / 255) << (i * 4);
+
+	std::memcpy(block, &alpha, 8);
+	WriteColorBlock(rgba, block + 8);
+}
+
+void				BCEncoder::EncodeBC3Block(const uint8_t * rgba, uint8_t * block) noexcept
+{
+	EncodeBC4Block(rgba, block, 3);
+	WriteColorBlock(rgba, block + 8);
+}
+
+void				BCEncoder::EncodeBC4Block(const uint8_t * rgba, uint8_t * block, int channel) noexcept
+{
+	int			min = 255;
+	int			max = 0;
+	uint64_t	indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		min = std::min(min, (int)rgba[i * 4 + channel]);
+		max = std::max(max, (int)rgba[i * 4 + channel]);
+	}
+
+	// max > min selects the 8 values mode, indices stay at 0 when the block is uniform
+	if (max != min)
+	{
+		int	palette[8];
+
+		palette[0] = max;
+		palette[1] = min;
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * max + p * min) / 7;
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestDistance = INT_MAX;
+
+			for (int p = 0; p < 8; p++)
+			{
+				int distance = std::abs(rgba[i * 4 + channel] - palette[p]);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (uint64_t)best << (i * 3);
+		}
+	}
+
+	block[0] = max;
+	block[1] = min;
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+void				BCEncoder::EncodeBC5Block(const uint8_t * rgba, uint8_t * block) noexcept
+{
+	EncodeBC4Block(rgba, block, 0);
+	EncodeBC4Block(rgba, block + 8, 1);
+}
+
+void				BCEncoder::DecodeBC1Block(const uint8_t * block, uint8_t * rgba, bool allowTransparency) noexcept
+{
+	ReadColorBlock(block, rgba, allowTransparency);
+}
+
+void				BCEncoder::DecodeBC2Block(const uint8_t * block, uint8_t * rgba) noexcept
+{
+	uint64_t	alpha;
+
+	ReadColorBlock(block + 8, rgba, false);
+	std::memcpy(&alpha, block, 8);
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + 3] = ((alpha >> (i * 4)) & 15) * 17;
+}
+
+void				BCEncoder::DecodeBC3Block(const uint8_t * block, uint8_t * rgba) noexcept
+{
+	ReadColorBlock(block + 8, rgba, false);
+	DecodeBC4Block(block, rgba, 3);
+}
+
+void				BCEncoder::DecodeBC4Block(const uint8_t * block, uint8_t * rgba, int channel, bool isSigned) noexcept
+{
+	int			palette[8];
+	uint64_t	indices = 0;
+	// Signed endpoints are two's complement, -128 is the same value as -127
+	int			minValue = (isSigned) ? -127 : 0;
+	int			maxValue = (isSigned) ? 127 : 255;
+
+	palette[0] = (isSigned) ? std::max((int)(int8_t)block[0], minValue) : block[0];
+	palette[1] = (isSigned) ? std::max((int)(int8_t)block[1], minValue) : block[1];
+	if (palette[0] > palette[1])
+	{
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * palette[0] + p * palette[1]) / 7;
+	}
+	else
+	{
+		for (int p = 1; p < 5; p++)
+			palette[p + 1] = ((5 - p) * palette[0] + p * palette[1]) / 5;
+		palette[6] = minValue;
+		palette[7] = maxValue;
+	}
+
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64_t)block[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + channel] = static_cast< uint8_t >(palette[(indices >> (i * 3)) & 7]);
+}
+
+void				BCEncoder::DecodeBC5Block(const uint8_t * block, uint8_t * rgba, bool isSigned) noexcept
+{
+	DecodeBC4Block(block, rgba, 0, isSigned);
+	DecodeBC4Block(block + 8, rgba, 1, isSigned);
+	for (int i = 0; i < 16; i++)
+	{
+		rgba[i * 4 + 2] = 0;
+		rgba[i * 4 + 3] = (isSigned) ? 127 : 255;
+	}
+}
+
+void				BCEncoder::DecodeBC7Block(const uint8_t * block, uint8_t * rgba) noexcept
+{
+	BlockBitReader	reader(block);
+	int				modeIndex = 0;
+
+	while (modeIndex < 8 && reader.Read(1) == 0)
+		modeIndex++;
+
+	// Reserved mode, decoded as transparent black
+	if (modeIndex == 8)
+	{
+		std::memset(rgba, 0, 16 * 4);
+		return ;
+	}
+
+	const BC7Mode &	mode = BC7Modes[modeIndex];
+	int				partition = reader.Read(mode.partitionBits);
+	int				rotation = reader.Read(mode.rotationBits);
+	int				indexSelection = reader.Read(mode.indexSelectionBits);
+	int				endpointCount = mode.subsetCount * 2;
+	int				endpoints[6][4];
+
+	for (int c = 0; c < 3; c++)
+		for (int e = 0; e < endpointCount; e++)
+			endpoints[e][c] = reader.Read(mode.colorBits);
+	for (int e = 0; e < endpointCount; e++)
+		endpoints[e][3] = (mode.alphaBits) ? reader.Read(mode.alphaBits) : 255;
+
+	// Append the p-bits and expand the endpoints to 8 bits by replicating their high bits
+	int		pBits[6] = {};
+	int		hasPBit = mode.endpointPBits || mode.sharedPBits;
+
+	if (mode.endpointPBits)
+		for (int e = 0; e < endpointCount; e++)
+			pBits[e] = reader.Read(1);
+	if (mode.sharedPBits)
+		for (int s = 0; s < mode.subsetCount; s++)
+			pBits[s * 2] = pBits[s * 2 + 1] = reader.Read(1);
+
+	for (int e = 0; e < endpointCount; e++)
+		for (int c = 0; c < 4; c++)
+		{
+			int bits = (c == 3) ? mode.alphaBits : mode.colorBits;
+
+			if (bits == 0)
+				continue ;
+			int value = (hasPBit) ? (endpoints[e][c] << 1) | pBits[e] : endpoints[e][c];
+			bits += hasPBit;
+			value <<= 8 - bits;
+			endpoints[e][c] = value | (value >> bits);
+		}
+
+	int		subsets[16];
+	int		anchors[3] = {0, 0, 0};
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (mode.subsetCount == 2)
+			subsets[i] = (BC7Partitions2[partition] >> i) & 1;
+		else if (mode.subsetCount == 3)
+			subsets[i] = BC7Partitions3[partition][i];
+		else
+			subsets[i] = 0;
+	}
+	if (mode.subsetCount == 2)
+		anchors[1] = BC7Anchors2[partition];
+	else if (mode.subsetCount == 3)
+	{
+		anchors[1] = BC7Anchors3Second[partition];
+		anchors[2] = BC7Anchors3Third[partition];
+	}
+
+	int		indices[16];
+	int		secondaryIndices[16] = {};
+
+	for (int i = 0; i < 16; i++)
+		indices[i] = reader.Read(mode.indexBits - (i == anchors[subsets[i]]));
+	if (mode.secondaryIndexBits)
+		for (int i = 0; i < 16; i++)
+			secondaryIndices[i] = reader.Read(mode.secondaryIndexBits - (i == 0));
+
+	// Modes 4 and 5 interpolate color and alpha with separate indices, the index selection bit swaps them
+	int				colorIndexBits = mode.indexBits;
+	int				alphaIndexBits = (mode.secondaryIndexBits) ? mode.secondaryIndexBits : mode.indexBits;
+	const int *		colorIndices = indices;
+	const int *		alphaIndices = (mode.secondaryIndexBits) ? secondaryIndices : indices;
+
+	if (indexSelection)
+	{
+		std::swap(colorIndexBits, alphaIndexBits);
+		std::swap(colorIndices, alphaIndices);
+	}
+
+	const int *		colorWeights = (colorIndexBits == 2) ? BC7Weights2 : (colorIndexBits == 3) ? BC7Weights3 : BC7Weights4;
+	const int *		alphaWeights = (alphaIndexBits == 2) ? BC7Weights2 : (alphaIndexBits == 3) ? BC7Weights3 : BC7Weights4;
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int *	e0 = endpoints[subsets[i] * 2];
+		const int *	e1 = endpoints[subsets[i] * 2 + 1];
+		int			colorWeight = colorWeights[colorIndices[i]];
+		int			alphaWeight = alphaWeights[alphaIndices[i]];
+		uint8_t *	pixel = rgba + i * 4;
+
+		for (int c = 0; c < 3; c++)
+			pixel[c] = ((64 - colorWeight) * e0[c] + colorWeight * e1[c] + 32) >> 6;
+		pixel[3] = ((64 - alphaWeight) * e0[3] + alphaWeight * e1[3] + 32) >> 6;
+
+		if (rotation)
+			std::swap(pixel[3], pixel[rotation - 1]);
+	}
+}
+
+bool				BCEncoder::CanEncode(BCFormat format) noexcept
+{
+	return format != BCFormat::BC4S && format != BCFormat::BC5S && format != BCFormat::BC7;
+}
+
+size_t				BCEncoder::GetBlockSize(BCFormat format) noexcept
+{
+	return (format == BCFormat::BC1 || format == BCFormat::BC4 || format == BCFormat::BC4S) ? 8 : 16;
+}
+
+size_t				BCEncoder::GetCompressedSize(BCFormat format, int width, int height) noexcept
+{
+	return static_cast< size_t >((std::max(width, 1) + 3) / 4) * ((std::max(height, 1) + 3) / 4) * GetBlockSize(format);
+}
+
+std::vector< uint8_t >	BCEncoder::Encode(const uint8_t * rgba, int width, int height, BCFormat format)
+{
+	std::vector< uint8_t >	blocks(GetCompressedSize(format, width, height));
+	size_t					blockSize = GetBlockSize(format);
+	int						blockCountX = (width + 3) / 4;
+	int						blockCountY = (height + 3) / 4;
+	uint8_t					pixels[16 * 4];
+
+	if (!CanEncode(format))
+		throw std::runtime_error("Block format " + std::to_string(static_cast< int >(format)) + " can only be decoded");
+
+	for (int by = 0; by < blockCountY; by++)
+		for (int bx = 0; bx < blockCountX; bx++)
+		{
+			for (int y = 0; y < 4; y++)
+				for (int x = 0; x < 4; x++)
+				{
+					int px = std::min(bx * 4 + x, width - 1);
+					int py = std::min(by * 4 + y, height - 1);
+					std::memcpy(pixels + (y * 4 + x) * 4, rgba + (py * width + px) * 4, 4);
+				}
+
+			uint8_t * block = blocks.data() + (by * blockCountX + bx) * blockSize;
+			switch (format)
+			{
+				case BCFormat::BC1: EncodeBC1Block(pixels, block); break ;
+				case BCFormat::BC2: EncodeBC2Block(pixels, block); break ;
+				case BCFormat::BC3: EncodeBC3Block(pixels, block); break ;
+				case BCFormat::BC4: EncodeBC4Block(pixels, block); break ;
+				case BCFormat::BC5: EncodeBC5Block(pixels, block); break ;
+				default: break ;
+			}
+		}
+
+	return blocks;
+}
+
+std::vector< uint8_t >	BCEncoder::Decode(const uint8_t * blocks, int width, int height, BCFormat format)
+{
+	std::vector< uint8_t >	rgba(width * height * 4);
+	size_t					blockSize = GetBlockSize(format);
+	int						blockCountX = (width + 3) / 4;
+	int						blockCountY = (height + 3) / 4;
+	uint8_t					pixels[16 * 4];
+	uint8_t					one = (format == BCFormat::BC4S || format == BCFormat::BC5S) ? 127 : 255;
+
+	for (int by = 0; by < blockCountY; by++)
+		for (int bx = 0; bx < blockCountX; bx++)
+		{
+			const uint8_t * block = blocks + (by * blockCountX + bx) * blockSize;
+
+			// single channel formats are expanded as red, 0, 0, 1
+			for (int i = 0; i < 16; i++)
+			{
+				pixels[i * 4 + 0] = pixels[i * 4 + 1] = pixels[i * 4 + 2] = 0;
+				pixels[i * 4 + 3] = one;
+			}
+
+			switch (format)
+			{
+				case BCFormat::BC1: DecodeBC1Block(block, pixels); break ;
+				case BCFormat::BC2: DecodeBC2Block(block, pixels); break ;
+				case BCFormat::BC3: DecodeBC3Block(block, pixels); break ;
+				case BCFormat::BC4: DecodeBC4Block(block, pixels); break ;
+				case BCFormat::BC5: DecodeBC5Block(block, pixels); break ;
+				case BCFormat::BC4S: DecodeBC4Block(block, pixels, 0, true); break ;
+				case BCFormat::BC5S: DecodeBC5Block(block, pixels, true); break ;
+				case BCFormat::BC7: DecodeBC7Block(block, pixels); break ;
+			}
+
+			for (int y = 0; y < 4 && by * 4 + y < height; y++)
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+					std::memcpy(rgba.data() + ((by * 4 + y) * width + bx * 4 + x) * 4, pixels + (y * 4 + x) * 4, 4);
+		}
+
+	return rgba;
+}
+
+std::vector< uint8_t >	BCEncoder::Downsample(const uint8_t * rgba, int width, int height)
+{
+	int						mipWidth = std::max(width / 2, 1);
+	int						mipHeight = std::max(height / 2, 1);
+	std::vector< uint8_t >	mip(mipWidth * mipHeight * 4);
+
+	for (int y = 0; y < mipHeight; y++)
+		for (int x = 0; x < mipWidth; x++)
+		{
+			int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+
+			for (int c = 0; c < 4; c++)
+			{
+				int sum = rgba[(y0 * width + x0) * 4 + c] + rgba[(y0 * width + x1) * 4 + c]
+						+ rgba[(y1 * width + x0) * 4 + c] + rgba[(y1 * width + x1) * 4 + c];
+				mip[(y * mipWidth + x) * 4 + c] = (sum + 2) / 4;
+			}
+		}
+
+	return mip;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace LWGC
+{
+	enum class	BCFormat
+	{
+		BC1,	// RGB + 1 bit alpha, 8 bytes per block
+		BC2,	// BC1 color + explicit 4 bits alpha, 16 bytes per block
+		BC3,	// BC1 color + interpolated alpha, 16 bytes per block
+		BC4,	// one interpolated channel (red), 8 bytes per block
+		BC5,	// two interpolated channels (red, green), 16 bytes per block
+		BC4S,	// signed BC4, decoded to R8G8B8A8_SNORM bytes
+		BC5S,	// signed BC5, decoded to R8G8B8A8_SNORM bytes
+		BC7,	// RGBA with 8 block modes, 16 bytes per block
+	};
+
+	// CPU block compression of RGBA8 images, only depends on the standard library so it can be tested in isolation.
+	// It's a fast bounding box fit encoder meant for offline conversion (results are cached on the disk).
+	// The signed and BC7 formats can only be decoded, for devices without BC support.
+	class		BCEncoder
+	{
+		public:
+			BCEncoder(void) = delete;
+			BCEncoder(const BCEncoder &) = delete;
+			virtual ~BCEncoder(void) = delete;
+
+			BCEncoder &	operator=(BCEncoder const & src) = delete;
+
+			static void		EncodeBC1Block(const uint8_t * rgba, uint8_t * block) noexcept;
+			static void		EncodeBC2Block(const uint8_t * rgba, uint8_t * block) noexcept;
+			static void		EncodeBC3Block(const uint8_t * rgba, uint8_t * block) noexcept;
+			static void		EncodeBC4Block(const uint8_t * rgba, uint8_t * block, int channel = 0) noexcept;
+			static void		EncodeBC5Block(const uint8_t * rgba, uint8_t * block) noexcept;
+
+			static void		DecodeBC1Block(const uint8_t * block, uint8_t * rgba, bool allowTransparency = true) noexcept;
+			static void		DecodeBC2Block(const uint8_t * block, uint8_t * rgba) noexcept;
+			static void		DecodeBC3Block(const uint8_t * block, uint8_t * rgba) noexcept;
+			static void		DecodeBC4Block(const uint8_t * block, uint8_t * rgba, int channel = 0, bool isSigned = false) noexcept;
+			static void		DecodeBC5Block(const uint8_t * block, uint8_t * rgba, bool isSigned = false) noexcept;
+			static void		DecodeBC7Block(const uint8_t * block, uint8_t * rgba) noexcept;
+
+			static bool		CanEncode(BCFormat format) noexcept;
+			static size_t	GetBlockSize(BCFormat format) noexcept;
+			static size_t	GetCompressedSize(BCFormat format, int width, int height) noexcept;
+
+			// Whole images, rgba is width * height * 4 bytes, borders of partial blocks are clamped. Encode throws if !CanEncode(format)
+			static std::vector< uint8_t >	Encode(const uint8_t * rgba, int width, int height, BCFormat format);
+			static std::vector< uint8_t >	Decode(const uint8_t * blocks, int width, int height, BCFormat format);
+
+			// 2x2 box filter used to build mip chains on the CPU
+			static std::vector< uint8_t >	Downsample(const uint8_t * rgba, int width, int height);
+	};
+}
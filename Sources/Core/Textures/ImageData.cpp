@@ -0,0 +1,530 @@
+#include "ImageData.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "Utils/MappedFile.hpp"
+#include "Utils/Utils.hpp"
+#include "Core/MeshCache.hpp"
+
+#include STB_INCLUDE_IMAGE
+
+using namespace LWGC;
+
+static const uint8_t	KTX2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const uint32_t	DDSMagic = 0x20534444; // "DDS "
+static const uint32_t	DDSAlphaModeOpaque = 3; // DDS_ALPHA_MODE_OPAQUE
+static const char *		CacheDirectory = "Cache/Textures/";
+static const uint32_t	MaxImageSize = 65536;
+static const uint32_t	MaxLevelCount = 17; // log2(MaxImageSize) + 1
+
+#define FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+struct		DDSPixelFormat
+{
+	uint32_t	size;
+	uint32_t	flags;
+	uint32_t	fourCC;
+	uint32_t	rgbBitCount;
+	uint32_t	rBitMask;
+	uint32_t	gBitMask;
+	uint32_t	bBitMask;
+	uint32_t	aBitMask;
+};
+
+struct		DDSHeader
+{
+	uint32_t		size;
+	uint32_t		flags;
+	uint32_t		height;
+	uint32_t		width;
+	uint32_t		pitchOrLinearSize;
+	uint32_t		depth;
+	uint32_t		mipMapCount;
+	uint32_t		reserved1[11];
+	DDSPixelFormat	pixelFormat;
+	uint32_t		caps;
+	uint32_t		caps2;
+	uint32_t		caps3;
+	uint32_t		caps4;
+	uint32_t		reserved2;
+};
+
+struct		DDSHeaderDX10
+{
+	uint32_t	dxgiFormat;
+	uint32_t	resourceDimension;
+	uint32_t	miscFlag;
+	uint32_t	arraySize;
+	uint32_t	miscFlags2;
+};
+
+struct		DXGIFormat
+{
+	uint32_t	dxgi;
+	VkFormat	format;
+};
+
+static const DXGIFormat	DXGIFormats[] = {
+	{28, VK_FORMAT_R8G8B8A8_UNORM},
+	{29, VK_FORMAT_R8G8B8A8_SRGB},
+	{87, VK_FORMAT_B8G8R8A8_UNORM},
+	{71, VK_FORMAT_BC1_RGBA_UNORM_BLOCK},
+	{72, VK_FORMAT_BC1_RGBA_SRGB_BLOCK},
+	{71, VK_FORMAT_BC1_RGB_UNORM_BLOCK},
+	{72, VK_FORMAT_BC1_RGB_SRGB_BLOCK},
+	{74, VK_FORMAT_BC2_UNORM_BLOCK},
+	{75, VK_FORMAT_BC2_SRGB_BLOCK},
+	{77, VK_FORMAT_BC3_UNORM_BLOCK},
+	{78, VK_FORMAT_BC3_SRGB_BLOCK},
+	{80, VK_FORMAT_BC4_UNORM_BLOCK},
+	{81, VK_FORMAT_BC4_SNORM_BLOCK},
+	{83, VK_FORMAT_BC5_UNORM_BLOCK},
+	{84, VK_FORMAT_BC5_SNORM_BLOCK},
+	{95, VK_FORMAT_BC6H_UFLOAT_BLOCK},
+	{96, VK_FORMAT_BC6H_SFLOAT_BLOCK},
+	{98, VK_FORMAT_BC7_UNORM_BLOCK},
+	{99, VK_FORMAT_BC7_SRGB_BLOCK},
+};
+
+ImageData::ImageData(void) : format(VK_FORMAT_UNDEFINED), width(0), height(0)
+{
+}
+
+void				ImageData::AddLevel(const uint8_t * levelData, size_t size, int levelWidth, int levelHeight)
+{
+	levels.push_back(Level{data.size(), size, levelWidth, levelHeight});
+	data.insert(data.end(), levelData, levelData + size);
+}
+
+bool				ImageData::IsBlockCompressed(VkFormat format) noexcept
+{
+	return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+bool				ImageData::ToBCFormat(VkFormat format, BCFormat & bcFormat) noexcept
+{
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: bcFormat = BCFormat::BC1; return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK: bcFormat = BCFormat::BC2; return true;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK: bcFormat = BCFormat::BC3; return true;
+		case VK_FORMAT_BC4_UNORM_BLOCK: bcFormat = BCFormat::BC4; return true;
+		case VK_FORMAT_BC5_UNORM_BLOCK: bcFormat = BCFormat::BC5; return true;
+		case VK_FORMAT_BC4_SNORM_BLOCK: bcFormat = BCFormat::BC4S; return true;
+		case VK_FORMAT_BC5_SNORM_BLOCK: bcFormat = BCFormat::BC5S; return true;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK: bcFormat = BCFormat::BC7; return true;
+		default: return false;
+	}
+}
+
+bool				ImageData::CanEncode(VkFormat format) noexcept
+{
+	BCFormat	bcFormat;
+
+	return ToBCFormat(GetEncodableFormat(format), bcFormat) && BCEncoder::CanEncode(bcFormat);
+}
+
+VkFormat			ImageData::GetEncodableFormat(VkFormat format) noexcept
+{
+	// There is no BC7 encoder, BC3 has the same channels at a lower quality
+	if (format == VK_FORMAT_BC7_UNORM_BLOCK)
+		return VK_FORMAT_BC3_UNORM_BLOCK;
+	if (format == VK_FORMAT_BC7_SRGB_BLOCK)
+		return VK_FORMAT_BC3_SRGB_BLOCK;
+	return format;
+}
+
+size_t				ImageData::GetLevelSize(VkFormat format, int width, int height)
+{
+	size_t	blocks = static_cast< size_t >((std::max(width, 1) + 3) / 4) * ((std::max(height, 1) + 3) / 4);
+
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return blocks * 8;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+			return static_cast< size_t >(std::max(width, 1)) * std::max(height, 1) * 4;
+		default:
+			if (IsBlockCompressed(format))
+				return blocks * 16;
+			throw std::runtime_error("Unsupported image format: " + std::to_string(format));
+	}
+}
+
+ImageData			ImageData::Decompress(void) const
+{
+	ImageData	decompressed;
+	BCFormat	bcFormat;
+
+	if (!IsBlockCompressed(format))
+		return *this;
+
+	if (!ToBCFormat(format, bcFormat))
+		throw std::runtime_error("Can't decompress image format " + std::to_string(format) + " on the CPU");
+
+	bool srgb = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+		|| format == VK_FORMAT_BC2_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+
+	if (bcFormat == BCFormat::BC4S || bcFormat == BCFormat::BC5S)
+		decompressed.format = VK_FORMAT_R8G8B8A8_SNORM;
+	else
+		decompressed.format = (srgb) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	decompressed.width = width;
+	decompressed.height = height;
+
+	for (const auto & level : levels)
+	{
+		auto rgba = BCEncoder::Decode(data.data() + level.offset, level.width, level.height, bcFormat);
+		decompressed.AddLevel(rgba.data(), rgba.size(), level.width, level.height);
+	}
+
+	return decompressed;
+}
+
+ImageData			ImageData::LoadKTX2(const std::string & path)
+{
+	MappedFile		file;
+	ImageData		image;
+	uint32_t		header[9];
+
+	if (!file.Open(path))
+		throw std::runtime_error("Failed to open texture file: " + path);
+
+	if (file.GetSize() < 80 || std::memcmp(file.GetData(), KTX2Identifier, sizeof(KTX2Identifier)) != 0)
+		throw std::runtime_error("Not a KTX2 file: " + path);
+
+	// vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount, faceCount, levelCount, supercompressionScheme
+	std::memcpy(header, file.GetData() + 12, sizeof(header));
+
+	if (header[8] != 0)
+		throw std::runtime_error("Supercompressed KTX2 files are not supported: " + path);
+	if (header[0] == VK_FORMAT_UNDEFINED)
+		throw std::runtime_error("KTX2 files without vkFormat (basis universal) are not supported: " + path);
+	if (header[4] > 1 || header[5] > 1 || header[6] != 1)
+		throw std::runtime_error("Only 2D KTX2 textures are supported: " + path);
+
+	if (header[2] == 0 || header[2] > MaxImageSize || header[3] > MaxImageSize || header[7] > MaxLevelCount)
+		throw std::runtime_error("Invalid KTX2 image size in " + path);
+
+	image.format = static_cast< VkFormat >(header[0]);
+	image.width = header[2];
+	image.height = std::max(header[3], 1u);
+
+	// Compare with divisions and subtractions, a crafted level count or offset must not wrap around the checks
+	uint32_t levelCount = std::max(header[7], 1u);
+	if (levelCount > (file.GetSize() - 80) / 24)
+		throw std::runtime_error("Truncated KTX2 file: " + path);
+
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		uint64_t	levelIndex[3]; // byteOffset, byteLength, uncompressedByteLength
+		int			levelWidth = std::max(image.width >> i, 1);
+		int			levelHeight = std::max(image.height >> i, 1);
+
+		std::memcpy(levelIndex, file.GetData() + 80 + i * 24, sizeof(levelIndex));
+		if (levelIndex[0] > file.GetSize() || levelIndex[1] > file.GetSize() - levelIndex[0]
+			|| levelIndex[1] < GetLevelSize(image.format, levelWidth, levelHeight))
+			throw std::runtime_error("Invalid KTX2 level " + std::to_string(i) + " in " + path);
+
+		image.AddLevel(file.GetData() + levelIndex[0], GetLevelSize(image.format, levelWidth, levelHeight), levelWidth, levelHeight);
+	}
+
+	return image;
+}
+
+ImageData			ImageData::LoadDDS(const std::string & path)
+{
+	MappedFile		file;
+	ImageData		image;
+	DDSHeader		header;
+	size_t			offset = 4 + sizeof(DDSHeader);
+
+	if (!file.Open(path))
+		throw std::runtime_error("Failed to open texture file: " + path);
+
+	if (file.GetSize() < offset || *reinterpret_cast< const uint32_t * >(file.GetData()) != DDSMagic)
+		throw std::runtime_error("Not a DDS file: " + path);
+
+	std::memcpy(&header, file.GetData() + 4, sizeof(header));
+
+	const DDSPixelFormat & pf = header.pixelFormat;
+	if (pf.fourCC == FOURCC('D', 'X', '1', '0'))
+	{
+		DDSHeaderDX10	dx10;
+
+		if (file.GetSize() < offset + sizeof(dx10))
+			throw std::runtime_error("Truncated DDS file: " + path);
+		std::memcpy(&dx10, file.GetData() + offset, sizeof(dx10));
+		offset += sizeof(dx10);
+
+		if (dx10.resourceDimension != 3 || dx10.arraySize > 1)
+			throw std::runtime_error("Only 2D DDS textures are supported: " + path);
+
+		for (const auto & f : DXGIFormats)
+			if (f.dxgi == dx10.dxgiFormat)
+			{
+				image.format = f.format;
+				break ;
+			}
+
+		if ((dx10.miscFlags2 & 0x7) == DDSAlphaModeOpaque && image.format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK)
+			image.format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		else if ((dx10.miscFlags2 & 0x7) == DDSAlphaModeOpaque && image.format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK)
+			image.format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	}
+	else if (pf.fourCC == FOURCC('D', 'X', 'T', '1'))
+		image.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('D', 'X', 'T', '2') || pf.fourCC == FOURCC('D', 'X', 'T', '3'))
+		image.format = VK_FORMAT_BC2_UNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('D', 'X', 'T', '4') || pf.fourCC == FOURCC('D', 'X', 'T', '5'))
+		image.format = VK_FORMAT_BC3_UNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('A', 'T', 'I', '1') || pf.fourCC == FOURCC('B', 'C', '4', 'U'))
+		image.format = VK_FORMAT_BC4_UNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('B', 'C', '4', 'S'))
+		image.format = VK_FORMAT_BC4_SNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('A', 'T', 'I', '2') || pf.fourCC == FOURCC('B', 'C', '5', 'U'))
+		image.format = VK_FORMAT_BC5_UNORM_BLOCK;
+	else if (pf.fourCC == FOURCC('B', 'C', '5', 'S'))
+		image.format = VK_FORMAT_BC5_SNORM_BLOCK;
+	else if (pf.rgbBitCount == 32 && pf.rBitMask == 0x000000FF)
+		image.format = VK_FORMAT_R8G8B8A8_UNORM;
+	else if (pf.rgbBitCount == 32 && pf.rBitMask == 0x00FF0000)
+		image.format = VK_FORMAT_B8G8R8A8_UNORM;
+
+	if (image.format == VK_FORMAT_UNDEFINED)
+		throw std::runtime_error("Unsupported DDS format in " + path);
+
+	if (header.caps2 & 0x200) // DDSCAPS2_CUBEMAP
+		throw std::runtime_error("Only 2D DDS textures are supported: " + path);
+
+	if (header.width == 0 || header.height == 0 || header.width > MaxImageSize || header.height > MaxImageSize)
+		throw std::runtime_error("Invalid DDS image size in " + path);
+
+	image.width = header.width;
+	image.height = header.height;
+
+	uint32_t levelCount = (header.flags & 0x20000) ? std::max(header.mipMapCount, 1u) : 1; // DDSD_MIPMAPCOUNT
+	if (levelCount > MaxLevelCount)
+		throw std::runtime_error("Invalid DDS mip count in " + path);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		int		levelWidth = std::max(image.width >> i, 1);
+		int		levelHeight = std::max(image.height >> i, 1);
+		size_t	size = GetLevelSize(image.format, levelWidth, levelHeight);
+
+		if (size > file.GetSize() - offset)
+			throw std::runtime_error("Truncated DDS file: " + path);
+
+		image.AddLevel(file.GetData() + offset, size, levelWidth, levelHeight);
+		offset += size;
+	}
+
+	return image;
+}
+
+bool				ImageData::SaveDDS(const std::string & path) const
+{
+	DDSHeader		header = {};
+	DDSHeaderDX10	dx10 = {};
+	MeshCache::Writer	writer;
+
+	for (const auto & f : DXGIFormats)
+		if (f.format == format)
+			dx10.dxgiFormat = f.dxgi;
+
+	if (dx10.dxgiFormat == 0)
+		return false;
+
+	// BC1 with and without alpha share their DXGI format, the alpha mode tells them apart
+	if (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK)
+		dx10.miscFlags2 = DDSAlphaModeOpaque;
+
+	header.size = sizeof(DDSHeader);
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // CAPS, HEIGHT, WIDTH, PIXELFORMAT, MIPMAPCOUNT, LINEARSIZE
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = (levels.size() > 0) ? levels[0].size : 0;
+	header.mipMapCount = levels.size();
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = 0x4; // DDPF_FOURCC
+	header.pixelFormat.fourCC = FOURCC('D', 'X', '1', '0');
+	header.caps = 0x1000 | ((levels.size() > 1) ? 0x8 | 0x400000 : 0); // TEXTURE, COMPLEX | MIPMAP
+	dx10.resourceDimension = 3; // TEXTURE2D
+	dx10.arraySize = 1;
+
+	writer.Write(DDSMagic);
+	writer.Write(header);
+	writer.Write(dx10);
+	for (const auto & level : levels)
+		writer.WriteBytes(data.data() + level.offset, level.size);
+
+	// Unique temporary file: the streamer and the model loader can compress the same source at the same time
+	return writer.SaveToFile(path);
+}
+
+bool				ImageData::IsContainerFile(const std::string & path)
+{
+	std::string	extension = GetExtension(path);
+
+	return extension == "ktx2" || extension == "dds" || extension == "KTX2" || extension == "DDS";
+}
+
+ImageData			ImageData::LoadContainerFile(const std::string & path)
+{
+	std::string	extension = GetExtension(path);
+
+	if (extension == "ktx2" || extension == "KTX2")
+		return LoadKTX2(path);
+	return LoadDDS(path);
+}
+
+ImageData			ImageData::FromRGBA8(const uint8_t * pixels, int width, int height, VkFormat format, bool generateMips, int maxLevelCount)
+{
+	ImageData				image;
+	BCFormat				bcFormat;
+	std::vector< uint8_t >	mip(pixels, pixels + width * height * 4);
+	int						mipWidth = width;
+	int						mipHeight = height;
+	bool					compress = ToBCFormat(format, bcFormat);
+
+	if (compress && !BCEncoder::CanEncode(bcFormat))
+		throw std::runtime_error("Can't encode RGBA8 pixels to format " + std::to_string(format));
+	if (!compress && format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB)
+		throw std::runtime_error("Can't encode RGBA8 pixels to format " + std::to_string(format));
+
+	image.format = format;
+	image.width = width;
+	image.height = height;
+
+	while (true)
+	{
+		if (compress)
+		{
+			auto blocks = BCEncoder::Encode(mip.data(), mipWidth, mipHeight, bcFormat);
+			image.AddLevel(blocks.data(), blocks.size(), mipWidth, mipHeight);
+		}
+		else
+			image.AddLevel(mip.data(), mip.size(), mipWidth, mipHeight);
+
+		if (!generateMips || (mipWidth == 1 && mipHeight == 1))
+			break ;
+		if (maxLevelCount > 0 && image.levels.size() >= static_cast< size_t >(maxLevelCount))
+			break ;
+
+		mip = BCEncoder::Downsample(mip.data(), mipWidth, mipHeight);
+		mipWidth = std::max(mipWidth / 2, 1);
+		mipHeight = std::max(mipHeight / 2, 1);
+	}
+
+	return image;
+}
+
+std::string			ImageData::GetCachePath(const std::string & path, VkFormat format, bool generateMips)
+{
+	char	hash[17];
+
+	// Same naming as the mesh cache: readable name and a hash of the path to separate the files with the same name
+	snprintf(hash, sizeof(hash), "%016llx", static_cast< unsigned long long >(MeshCache::HashBytes(path.data(), path.size())));
+
+	return std::string(CacheDirectory) + GetFileName(path) + "_" + hash + ".vk" + std::to_string(format) + ((generateMips) ? ".mips" : "") + ".dds";
+}
+
+VkFormat			ImageData::GetAlphaFormat(VkFormat format) noexcept
+{
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return VK_FORMAT_BC3_SRGB_BLOCK;
+		default: return format;
+	}
+}
+
+bool				ImageData::IsOpaque(const uint8_t * rgba, int width, int height) noexcept
+{
+	size_t	pixelCount = static_cast< size_t >(width) * height;
+
+	for (size_t i = 0; i < pixelCount; i++)
+		if (rgba[i * 4 + 3] != 255)
+			return false;
+	return true;
+}
+
+ImageData			ImageData::LoadAndCompress(const std::string & path, VkFormat format, bool generateMips)
+{
+	struct stat		sourceStat;
+	struct stat		cacheStat;
+	VkFormat		encodedFormat = GetEncodableFormat(format);
+	VkFormat		alphaFormat = GetAlphaFormat(encodedFormat);
+	std::string		cachePath = GetCachePath(path, encodedFormat, generateMips);
+
+	if (stat(path.c_str(), &sourceStat) == -1)
+		throw std::runtime_error("Failed to load texture image, not a valid file: " + path);
+
+	// The cache is valid as long as it's more recent than the source image
+	if (stat(cachePath.c_str(), &cacheStat) == 0 && cacheStat.st_mtime >= sourceStat.st_mtime)
+	{
+		try {
+			ImageData cached = LoadDDS(cachePath);
+			if (cached.format == encodedFormat || cached.format == alphaFormat)
+				return cached;
+		} catch (const std::runtime_error & e) {
+			std::cerr << "Invalid texture cache " << cachePath << ": " << e.what() << std::endl;
+		}
+	}
+
+	int			width, height, channels;
+	stbi_uc *	pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (!pixels)
+		throw std::runtime_error("Failed to load texture image from file: " + path);
+
+	// BC1 has no alpha channel with the 4 colors blocks the encoder writes, keep the alpha in BC3 instead
+	if (alphaFormat != encodedFormat && !IsOpaque(pixels, width, height))
+		encodedFormat = alphaFormat;
+
+	ImageData image = FromRGBA8(pixels, width, height, encodedFormat, generateMips);
+	stbi_image_free(pixels);
+
+	if (!CreateDirectories(CacheDirectory) || !image.SaveDDS(cachePath))
+		std::cerr << "Can't write texture cache " << cachePath << std::endl;
+
+	return image;
+}
+
+ImageData			ImageData::LoadRGBA8(const std::string & path, bool generateMips)
+{
+	int			width, height, channels;
+	stbi_uc *	pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (!pixels)
+		throw std::runtime_error("Failed to load texture image from file: " + path);
+
+	ImageData image = FromRGBA8(pixels, width, height, VK_FORMAT_R8G8B8A8_UNORM, generateMips);
+	stbi_image_free(pixels);
+
+	return image;
+}
+
+std::ostream &	operator<<(std::ostream & o, ImageData const & r)
+{
+	o << "ImageData " << r.width << "x" << r.height << " with " << r.levels.size() << " levels" << std::endl;
+	return (o);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/BCEncoder.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// CPU side image with all it's mip levels stored contiguously, in the layout expected by vkCmdCopyBufferToImage
+	class		ImageData
+	{
+		public:
+			struct Level
+			{
+				size_t	offset;
+				size_t	size;
+				int		width;
+				int		height;
+			};
+
+			VkFormat				format;
+			int						width;
+			int						height;
+			std::vector< Level >	levels;
+			std::vector< uint8_t >	data;
+
+			ImageData(void);
+			ImageData(const ImageData &) = default;
+			virtual ~ImageData(void) = default;
+
+			ImageData &	operator=(ImageData const & src) = default;
+
+			void			AddLevel(const uint8_t * levelData, size_t size, int levelWidth, int levelHeight);
+
+			// Decompress block compressed data to RGBA8 (SNORM for the signed formats), for devices without BC support.
+			// Throws for BC6H, which has no CPU decoder
+			ImageData		Decompress(void) const;
+
+			bool			SaveDDS(const std::string & path) const;
+
+			static ImageData	LoadKTX2(const std::string & path);
+			static ImageData	LoadDDS(const std::string & path);
+			static bool			IsContainerFile(const std::string & path);
+			static ImageData	LoadContainerFile(const std::string & path);
+
+			// Compress an RGBA8 image to a BC format, with optional CPU generated mips (maxLevelCount 0 is the full chain)
+			static ImageData	FromRGBA8(const uint8_t * pixels, int width, int height, VkFormat format, bool generateMips, int maxLevelCount = 0);
+
+			// Decode a png/jpg/... to RGBA8, throws if the file can't be loaded
+			static ImageData	LoadRGBA8(const std::string & path, bool generateMips = false);
+
+			// Load a png/jpg/... as a BC texture, the compressed result is cached in Cache/Textures/.
+			// BC1 is promoted to BC3 when the image has transparent pixels
+			static ImageData	LoadAndCompress(const std::string & path, VkFormat format, bool generateMips);
+			static std::string	GetCachePath(const std::string & path, VkFormat format, bool generateMips);
+
+			static bool			IsBlockCompressed(VkFormat format) noexcept;
+			static bool			CanEncode(VkFormat format) noexcept;
+			static bool			ToBCFormat(VkFormat format, BCFormat & bcFormat) noexcept;
+			static VkFormat		GetEncodableFormat(VkFormat format) noexcept;
+			static VkFormat		GetAlphaFormat(VkFormat format) noexcept;
+			static bool			IsOpaque(const uint8_t * rgba, int width, int height) noexcept;
+			static size_t		GetLevelSize(VkFormat format, int width, int height);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ImageData const & r);
+}
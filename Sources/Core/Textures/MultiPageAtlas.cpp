@@ -0,0 +1,230 @@
+#include "MultiPageAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+
+using namespace LWGC;
+
+MultiPageAtlas::MultiPageAtlas(int pageWidth, int pageHeight, int padding, int maxPages) :
+	_pageWidth(pageWidth), _pageHeight(pageHeight), _padding(std::max(padding, 0)), _maxPages(std::max(maxPages, 1)),
+	_mipLevelCount(1), _texture(nullptr), _entryBuffer(VK_NULL_HANDLE), _entryMemory(VK_NULL_HANDLE)
+{
+}
+
+MultiPageAtlas::~MultiPageAtlas(void)
+{
+	if (_entryBuffer == VK_NULL_HANDLE)
+		return ;
+
+	VkDevice device = VulkanInstance::Get()->GetDevice();
+	vkDestroyBuffer(device, _entryBuffer, nullptr);
+	vkFreeMemory(device, _entryMemory, nullptr);
+}
+
+size_t				MultiPageAtlas::Add(const std::string & fileName)
+{
+	_sources.push_back(Source{fileName, ImageData(), ""});
+	_entries.push_back(Entry{fileName, -1, {0, 0, 0, 0}, glm::vec4(0)});
+
+	return _entries.size() - 1;
+}
+
+size_t				MultiPageAtlas::Add(const uint8_t * rgba, int width, int height)
+{
+	_sources.push_back(Source{"", ImageData::FromRGBA8(rgba, width, height, VK_FORMAT_R8G8B8A8_UNORM, false), ""});
+	_entries.push_back(Entry{"", -1, {0, 0, 0, 0}, glm::vec4(0)});
+
+	return _entries.size() - 1;
+}
+
+void				MultiPageAtlas::DecodeSources(ThreadPool & pool)
+{
+	pool.ParallelFor(_sources.size(), [&](size_t i)
+	{
+		Source & source = _sources[i];
+
+		if (source.fileName.empty())
+			return ;
+
+		try {
+			source.image = ImageData::LoadRGBA8(source.fileName);
+		} catch (const std::runtime_error & e) {
+			source.error = e.what();
+		}
+	});
+}
+
+// Returns the number of pages, each page is packed with the images that didn't fit in the previous ones
+int					MultiPageAtlas::PackPages(void)
+{
+	std::vector< size_t >	pending;
+	int						pageCount = 0;
+
+	for (size_t i = 0; i < _sources.size(); i++)
+	{
+		if (!_sources[i].error.empty())
+			std::cerr << "MultiPageAtlas: " << _sources[i].error << std::endl;
+		else
+			pending.push_back(i);
+	}
+
+	while (!pending.empty() && pageCount < _maxPages)
+	{
+		AtlasAllocator				allocator(_pageWidth, _pageHeight, _padding);
+		std::vector< glm::ivec2 >	sizes;
+		std::vector< size_t >		remaining;
+
+		for (size_t i : pending)
+			sizes.push_back(glm::ivec2(_sources[i].image.width, _sources[i].image.height));
+
+		auto ids = allocator.AllocateBatch(sizes);
+
+		for (size_t k = 0; k < pending.size(); k++)
+		{
+			Entry & entry = _entries[pending[k]];
+
+			if (ids[k] == AtlasAllocator::InvalidId)
+			{
+				remaining.push_back(pending[k]);
+				continue ;
+			}
+
+			entry.page = pageCount;
+			entry.rect = allocator.GetRect(ids[k]);
+			entry.sizeOffset = glm::vec4(
+				static_cast< float >(entry.rect.width) / _pageWidth, static_cast< float >(entry.rect.height) / _pageHeight,
+				static_cast< float >(entry.rect.x) / _pageWidth, static_cast< float >(entry.rect.y) / _pageHeight
+			);
+		}
+
+		// Only images bigger than a page are left
+		if (remaining.size() == pending.size())
+			break ;
+
+		pending = remaining;
+		pageCount++;
+	}
+
+	for (size_t i : pending)
+		std::cerr << "MultiPageAtlas: can't place image " << i << " " << _sources[i].fileName << " ("
+			<< _sources[i].image.width << "x" << _sources[i].image.height << ")" << std::endl;
+
+	return pageCount;
+}
+
+void				MultiPageAtlas::ComposePage(ThreadPool & pool, int page, std::vector< uint8_t > & pixels) const
+{
+	std::vector< size_t >	indices;
+
+	for (size_t i = 0; i < _entries.size(); i++)
+		if (_entries[i].page == page)
+			indices.push_back(i);
+
+	// Images don't overlap (padding included) so they can be copied in parallel
+	pool.ParallelFor(indices.size(), [&](size_t k)
+	{
+		const AtlasRect &	rect = _entries[indices[k]].rect;
+		const ImageData &	image = _sources[indices[k]].image;
+		const uint8_t *		src = image.data.data();
+
+		// The padding is filled with the border pixels of the image, so filtering and mips only see the image colors
+		for (int y = -_padding; y < rect.height + _padding; y++)
+		{
+			int			srcY = std::min(std::max(y, 0), rect.height - 1);
+			uint8_t *	dst = pixels.data() + (static_cast< size_t >(rect.y + y) * _pageWidth + rect.x - _padding) * 4;
+
+			for (int x = -_padding; x < 0; x++, dst += 4)
+				std::memcpy(dst, src + static_cast< size_t >(srcY) * rect.width * 4, 4);
+			std::memcpy(dst, src + static_cast< size_t >(srcY) * rect.width * 4, static_cast< size_t >(rect.width) * 4);
+			dst += static_cast< size_t >(rect.width) * 4;
+			for (int x = 0; x < _padding; x++, dst += 4)
+				std::memcpy(dst, src + (static_cast< size_t >(srcY) * rect.width + rect.width - 1) * 4, 4);
+		}
+	});
+}
+
+void				MultiPageAtlas::Build(bool generateMips, VkFormat format, int usage)
+{
+	if (_texture != nullptr)
+		throw std::runtime_error("MultiPageAtlas is already built");
+
+	ThreadPool	pool;
+
+	DecodeSources(pool);
+
+	int pageCount = std::max(PackPages(), 1);
+
+	// Mips beyond floor(log2(padding)) would average the pixels of neighbour images
+	_mipLevelCount = 1;
+	if (generateMips && _padding > 0)
+	{
+		int fullChain = static_cast< int >(std::floor(std::log2(std::max(_pageWidth, _pageHeight)))) + 1;
+		_mipLevelCount = std::min(static_cast< int >(std::floor(std::log2(_padding))) + 1, fullChain);
+	}
+
+	_texture = Texture2DArray::Create(_pageWidth, _pageHeight, pageCount, format, usage, _mipLevelCount);
+
+	// Pages are composed one at a time to bound the memory, they all go in the same staging buffer
+	std::vector< uint8_t >	pixels;
+	for (int page = 0; page < pageCount; page++)
+	{
+		pixels.assign(static_cast< size_t >(_pageWidth) * _pageHeight * 4, 0);
+		ComposePage(pool, page, pixels);
+		_texture->SetImage(ImageData::FromRGBA8(pixels.data(), _pageWidth, _pageHeight, format, _mipLevelCount > 1, _mipLevelCount), page);
+	}
+	_texture->Upload();
+
+	// The decoded images are not needed anymore
+	for (auto & source : _sources)
+		source.image = ImageData();
+
+	CreateEntryBuffer();
+}
+
+void				MultiPageAtlas::CreateEntryBuffer(void)
+{
+	std::vector< AtlasEntryData >	data;
+
+	for (const auto & entry : _entries)
+		data.push_back(AtlasEntryData{entry.sizeOffset, glm::vec4(std::max(entry.page, 0), 0, 0, 0)});
+
+	// An empty buffer can't be bound, keep at least one entry
+	if (data.empty())
+		data.push_back(AtlasEntryData{glm::vec4(0), glm::vec4(0)});
+
+	Vk::CreateBuffer(
+		data.size() * sizeof(AtlasEntryData),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // StructuredBuffer are always in storage mode
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		_entryBuffer,
+		_entryMemory
+	);
+	Vk::UploadToMemory(_entryMemory, data.data(), data.size() * sizeof(AtlasEntryData));
+}
+
+void				MultiPageAtlas::Bind(Material * material, const std::string & textureBinding, const std::string & entriesBinding) const
+{
+	if (_texture == nullptr)
+		throw std::runtime_error("MultiPageAtlas must be built before being bound");
+
+	material->SetTexture(textureBinding, _texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+	material->SetBuffer(entriesBinding, _entryBuffer, GetEntryBufferSize(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+}
+
+const MultiPageAtlas::Entry &	MultiPageAtlas::GetEntry(size_t index) const { return _entries.at(index); }
+size_t				MultiPageAtlas::GetEntryCount(void) const noexcept { return _entries.size(); }
+int					MultiPageAtlas::GetPageCount(void) const noexcept { return (_texture != nullptr) ? _texture->GetArraySize() : 0; }
+int					MultiPageAtlas::GetMipLevelCount(void) const noexcept { return _mipLevelCount; }
+Texture2DArray *	MultiPageAtlas::GetTexture(void) const noexcept { return _texture; }
+VkBuffer			MultiPageAtlas::GetEntryBuffer(void) const noexcept { return _entryBuffer; }
+size_t				MultiPageAtlas::GetEntryBufferSize(void) const noexcept { return std::max< size_t >(_entries.size(), 1) * sizeof(AtlasEntryData); }
+
+std::ostream &	operator<<(std::ostream & o, MultiPageAtlas const & r)
+{
+	o << "MultiPageAtlas: " << r.GetEntryCount() << " entries in " << r.GetPageCount() << " pages" << std::endl;
+	return (o);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IncludeDeps.hpp"
+#include "Core/AtlasAllocator.hpp"
+#include "Core/Textures/Texture2DArray.hpp"
+#include "Core/Textures/ImageData.hpp"
+#include "Core/Vulkan/Material.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include GLM_INCLUDE
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Matches AtlasEntry in Shaders/Debug/TextureAtlasArray.hlsl
+	struct		AtlasEntryData
+	{
+		glm::vec4	sizeOffset;	// xy: size, zw: offset (UV space)
+		glm::vec4	page;		// x: layer of the texture array
+	};
+
+	// Atlas built in one go from many images: they are decoded in parallel, packed by decreasing area in as many
+	// pages as needed, composed with extruded borders on the CPU (so mips don't bleed) and uploaded in a single
+	// command buffer to a Texture2DArray with one layer per page.
+	class		MultiPageAtlas
+	{
+		public:
+			struct	Entry
+			{
+				std::string	fileName;
+				int			page;	// -1 if the image couldn't be loaded or placed
+				AtlasRect	rect;
+				glm::vec4	sizeOffset;
+			};
+
+		private:
+			struct	Source
+			{
+				std::string	fileName;
+				ImageData	image;
+				std::string	error;
+			};
+
+			int							_pageWidth;
+			int							_pageHeight;
+			int							_padding;
+			int							_maxPages;
+			int							_mipLevelCount;
+			std::vector< Source >		_sources;
+			std::vector< Entry >		_entries;
+			Texture2DArray *			_texture;
+			VkBuffer					_entryBuffer;
+			VkDeviceMemory				_entryMemory;
+
+			void		DecodeSources(ThreadPool & pool);
+			int			PackPages(void);
+			void		ComposePage(ThreadPool & pool, int page, std::vector< uint8_t > & pixels) const;
+			void		CreateEntryBuffer(void);
+
+		public:
+			MultiPageAtlas(void) = delete;
+			// A padding of p pixels around each image keeps floor(log2(p)) + 1 mips free of bleeding
+			MultiPageAtlas(int pageWidth, int pageHeight, int padding = 8, int maxPages = 16);
+			MultiPageAtlas(const MultiPageAtlas &) = delete;
+			virtual ~MultiPageAtlas(void);
+
+			MultiPageAtlas &	operator=(MultiPageAtlas const & src) = delete;
+
+			// Returns the index of the entry, images are only loaded in Build
+			size_t				Add(const std::string & fileName);
+			size_t				Add(const uint8_t * rgba, int width, int height);
+
+			// Can be called only once, format must be RGBA8 or a BC format supported by the BCEncoder
+			void				Build(bool generateMips = true, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM, int usage = VK_IMAGE_USAGE_SAMPLED_BIT);
+
+			// Bind the texture array and the entry buffer of the atlas
+			void				Bind(Material * material, const std::string & textureBinding = "atlasTexture", const std::string & entriesBinding = "atlasEntries") const;
+
+			const Entry &		GetEntry(size_t index) const;
+			size_t				GetEntryCount(void) const noexcept;
+			int					GetPageCount(void) const noexcept;
+			int					GetMipLevelCount(void) const noexcept;
+			Texture2DArray *	GetTexture(void) const noexcept;
+			VkBuffer			GetEntryBuffer(void) const noexcept;
+			size_t				GetEntryBufferSize(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, MultiPageAtlas const & r);
+}
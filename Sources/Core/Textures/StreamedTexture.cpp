@@ -0,0 +1,55 @@
+#include "StreamedTexture.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Core/Textures/TextureStreamer.hpp"
+#include "Utils/Utils.hpp"
+
+using namespace LWGC;
+
+StreamedTexture::StreamedTexture(TextureStreamer * streamer, const std::string & fileName, VkFormat format, int usage, VkImageView placeholder)
+	: _streamer(streamer), _fileName(fileName), _requestedFormat(format), _state(TextureStreamingState::Loading), _requestId(0),
+	_lastUsedFrame(0), _mipCount(0), _firstResidentMip(0)
+{
+	this->format = format;
+	this->usage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	this->width = 1;
+	this->height = 1;
+	this->view = placeholder;
+	this->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+StreamedTexture::~StreamedTexture(void)
+{
+	// The image may still be used by frames in flight, the streamer destroys it later
+	_streamer->Unregister(this);
+	allocated = false;
+}
+
+void					StreamedTexture::MarkUsed(void) const noexcept
+{
+	_lastUsedFrame = _streamer->GetFrameIndex();
+}
+
+const std::string &		StreamedTexture::GetFileName(void) const noexcept { return _fileName; }
+TextureStreamingState	StreamedTexture::GetState(void) const noexcept { return _state; }
+bool					StreamedTexture::IsReady(void) const noexcept { return _mipCount > 0; }
+int						StreamedTexture::GetMipCount(void) const noexcept { return _mipCount; }
+int						StreamedTexture::GetFirstResidentMip(void) const noexcept { return _firstResidentMip; }
+
+size_t					StreamedTexture::GetResidentSize(void) const noexcept
+{
+	return std::accumulate(_levelSizes.begin() + std::min< size_t >(_firstResidentMip, _levelSizes.size()), _levelSizes.end(), size_t(0));
+}
+
+size_t					StreamedTexture::GetFullSize(void) const noexcept
+{
+	return std::accumulate(_levelSizes.begin(), _levelSizes.end(), size_t(0));
+}
+
+std::ostream &	operator<<(std::ostream & o, StreamedTexture const & r)
+{
+	o << "StreamedTexture " << r.GetFileName() << " mips " << r.GetFirstResidentMip() << "/" << r.GetMipCount() << std::endl;
+	return (o);
+}
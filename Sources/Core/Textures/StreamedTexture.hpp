@@ -0,0 +1,71 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/Texture.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	class	TextureStreamer;
+
+	enum class	TextureStreamingState
+	{
+		Loading,	// Decode in progress, the texture is bound to the placeholder or to its previous (evicted) image
+		Resident,
+		Failed,
+	};
+
+	// Handle returned by the TextureStreamer, usable right away in materials: the view points to a placeholder until
+	// the image is uploaded, and to a lower resolution image while its high mips are evicted.
+	class		StreamedTexture : public Texture
+	{
+		friend class TextureStreamer;
+
+		private:
+			// Copy of an evicted mip in host memory, copied back to the image when the texture is used again
+			struct	EvictedLevel
+			{
+				VkBuffer		buffer;
+				VkDeviceMemory	memory;
+			};
+
+			StreamedTexture(void) = delete;
+			StreamedTexture(TextureStreamer * streamer, const std::string & fileName, VkFormat format, int usage, VkImageView placeholder);
+			StreamedTexture(const StreamedTexture &) = delete;
+
+			TextureStreamer *		_streamer;
+			std::string				_fileName;
+			VkFormat				_requestedFormat;
+			TextureStreamingState	_state;
+			uint64_t				_requestId;
+			mutable uint64_t		_lastUsedFrame;
+			// Mip count of the full texture and index of the first mip in the GPU image
+			int						_mipCount;
+			int						_firstResidentMip;
+			std::vector< size_t >	_levelSizes;
+			// Indexed by mip, only the levels before _firstResidentMip are valid
+			std::vector< EvictedLevel >	_evictedLevels;
+
+		public:
+			virtual ~StreamedTexture(void);
+
+			StreamedTexture &	operator=(StreamedTexture const & src) = delete;
+
+			void					MarkUsed(void) const noexcept override;
+
+			const std::string &		GetFileName(void) const noexcept;
+			TextureStreamingState	GetState(void) const noexcept;
+			bool					IsReady(void) const noexcept;
+			int						GetMipCount(void) const noexcept;
+			int						GetFirstResidentMip(void) const noexcept;
+			size_t					GetResidentSize(void) const noexcept;
+			size_t					GetFullSize(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, StreamedTexture const & r);
+}
@@ -16,7 +16,7 @@
 
 using namespace LWGC;
 
-Texture::Texture(void) : width(0), height(0), depth(1), arraySize(1), autoGenerateMips(false), usage(0),
+Texture::Texture(void) : width(0), height(0), depth(1), arraySize(1), samples(VK_SAMPLE_COUNT_1_BIT), autoGenerateMips(false), usage(0),
 	allocated(false), maxMipLevel(1), image(VK_NULL_HANDLE), memory(VK_NULL_HANDLE), view(VK_NULL_HANDLE),
 	layout(VK_IMAGE_LAYOUT_UNDEFINED)
 {
@@ -63,8 +63,13 @@ void			Texture::AllocateImage(VkImageViewType viewType)
 {
 	this->allocated = true;
 
-	Vk::CreateImage(width, height, depth, arraySize, maxMipLevel, format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
-	view = Vk::CreateImageView(image, format, maxMipLevel, viewType, VK_IMAGE_ASPECT_COLOR_BIT);
+	Vk::CreateImage(width, height, depth, arraySize, maxMipLevel, format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, samples);
+
+	// The views of depth stencil images only see the depth so they can be sampled
+	VkImageAspectFlags aspect = Vk::GetImageAspect(format);
+	if (aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+		aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	view = Vk::CreateImageView(image, format, maxMipLevel, viewType, aspect, arraySize);
 }
 
 // TODO: HDR and EXR support (stbi_us)
@@ -100,6 +105,42 @@ void			Texture::UploadImage(stbi_uc * pixels, VkDeviceSize devizeSize, glm::ivec
 	vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
+// Upload all the levels of a pre-mipped (and possibly block compressed) image with a single staging buffer
+void			Texture::UploadImageData(const ImageData & imageData)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	std::vector< VkBufferImageCopy > regions;
+
+	Vk::CreateBuffer(imageData.data.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	Vk::UploadToMemory(stagingBufferMemory, const_cast< uint8_t * >(imageData.data.data()), imageData.data.size());
+
+	for (size_t i = 0; i < imageData.levels.size(); i++)
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = imageData.levels[i].offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {
+			static_cast< uint32_t >(imageData.levels[i].width),
+			static_cast< uint32_t >(imageData.levels[i].height),
+			1
+		};
+		regions.push_back(region);
+	}
+
+	VkCommandBuffer cmd = graphicCommandBufferPool->BeginSingle();
+	TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast< uint32_t >(regions.size()), regions.data());
+	TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	graphicCommandBufferPool->EndSingle(cmd);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	vkFreeMemory(device, stagingBufferMemory, nullptr);
+}
+
 void			Texture::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
 {
 	VkCommandBuffer commandBuffer = graphicCommandBufferPool->BeginSingle();
@@ -117,36 +158,18 @@ void			Texture::TransitionImageLayout(VkCommandBuffer cmd, VkImage image, VkImag
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = image;
 
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.aspectMask = Vk::GetImageAspect(format);
     barrier.subresourceRange.baseMipLevel = 0;
     barrier.subresourceRange.levelCount = maxMipLevel;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = arraySize;
 
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	} else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_GENERAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	// Barrier between any use of the old layout and any use of the new one
+	VkPipelineStageFlags sourceStage;
+	VkPipelineStageFlags destinationStage;
 
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
+	Vk::GetLayoutStagesAndAccess(oldLayout, sourceStage, barrier.srcAccessMask);
+	Vk::GetLayoutStagesAndAccess(newLayout, destinationStage, barrier.dstAccessMask);
 
     vkCmdPipelineBarrier(
             cmd,
@@ -280,10 +303,15 @@ void			Texture::GenerateMipMaps(VkImage image, VkFormat format, int32_t width, i
 int				Texture::GetWidth(void) const noexcept { return (this->width); }
 int				Texture::GetHeight(void) const noexcept { return (this->height); }
 int				Texture::GetDepth(void) const noexcept { return (this->depth); }
+int				Texture::GetArraySize(void) const noexcept { return (this->arraySize); }
+VkFormat		Texture::GetFormat(void) const noexcept { return (this->format); }
+VkSampleCountFlagBits	Texture::GetSamples(void) const noexcept { return (this->samples); }
+VkImageUsageFlags	Texture::GetUsage(void) const noexcept { return static_cast< VkImageUsageFlags >(this->usage); }
 VkImageView		Texture::GetView(void) const noexcept { return this->view; }
 VkImage			Texture::GetImage(void) const noexcept { return this->image; }
 VkImageLayout	Texture::GetLayout(void) const noexcept { return this->layout; }
 bool			Texture::GetAutoGenerateMips(void) const noexcept { return this->autoGenerateMips; }
+void			Texture::MarkUsed(void) const noexcept {}
 
 std::ostream &	operator<<(std::ostream & o, Texture const & r)
 {
@@ -8,6 +8,7 @@
 #include "Core/Vulkan/VulkanInstance.hpp"
 #include "Core/Vulkan/CommandBufferPool.hpp"
 #include "Core/Object.hpp"
+#include "Core/Textures/ImageData.hpp"
 #include VULKAN_INCLUDE
 
 #include STB_INCLUDE_IMAGE
@@ -17,12 +18,15 @@ namespace LWGC
 {
 	class		Texture : public Object
 	{
+		friend class RenderGraph; // Tracks the layout of the imported textures
+
 		protected:
 			int					width;
 			int					height;
 			int					depth;
 			int					arraySize;
 			VkFormat			format;
+			VkSampleCountFlagBits	samples;
 			bool				autoGenerateMips;
 			int					usage;
 			bool				allocated;
@@ -38,6 +42,7 @@ namespace LWGC
 			void			AllocateImage(VkImageViewType viewType);
 			void			UploadImage(stbi_uc * pixels, VkDeviceSize deviceSize, glm::ivec3 imageSize, glm::ivec3 offset = {0, 0, 0});
 			void			UploadImageWithMips(VkImage image, VkFormat format, void * pixels, VkDeviceSize deviceSize, glm::ivec3 imageSize, glm::ivec3 offset = {0, 0, 0});
+			void			UploadImageData(const ImageData & imageData);
 			void			TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
 			void			TransitionImageLayout(VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
 			stbi_uc *		LoadFromFile(const std::string & fileName, int & width, int & height);
@@ -54,6 +59,9 @@ namespace LWGC
 			int				GetHeight(void) const noexcept;
 			int				GetDepth(void) const noexcept;
 			int				GetArraySize(void) const noexcept;
+			VkFormat		GetFormat(void) const noexcept;
+			VkSampleCountFlagBits	GetSamples(void) const noexcept;
+			VkImageUsageFlags	GetUsage(void) const noexcept;
 			VkImageView		GetView(void) const noexcept;
 			VkImage			GetImage(void) const noexcept;
 			bool			GetAutoGenerateMips(void) const noexcept;
@@ -61,6 +69,8 @@ namespace LWGC
 			void			ChangeLayout(VkImageLayout targetLayout);
 			VkImageLayout	GetLayout(void) const noexcept;
 			void			Destroy(void) noexcept;
+			// Called when the texture is bound for rendering, used by streamed textures to track their usage
+			virtual void	MarkUsed(void) const noexcept;
 	};
 
 	std::ostream &	operator<<(std::ostream & o, Texture const & r);
@@ -13,6 +13,17 @@ Texture2D::Texture2D(const std::string fileName, VkFormat format, int usage, boo
 	// Force transfer flag (as the image comes from the RAM)
     usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	this->usage = usage;
+    this->depth = 1;
+
+	if (LoadCompressed(fileName, format, generateMips))
+	{
+		SetName(GetFileNameWithoutExtension(fileName));
+		return ;
+	}
+
+	// Block compression not available, fallback to RGBA8
+	if (ImageData::IsBlockCompressed(format))
+		this->format = format = VK_FORMAT_R8G8B8A8_UNORM;
 
     _pixels = LoadFromFile(fileName, this->width, this->height);
 
@@ -21,8 +32,6 @@ Texture2D::Texture2D(const std::string fileName, VkFormat format, int usage, boo
 		maxMipLevel = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
 	}
 
-    this->depth = 1;
-
 	AllocateImage(VK_IMAGE_VIEW_TYPE_2D);
 
 	// UploadImage(_pixels, this->width * this->height * 4);
@@ -34,11 +43,52 @@ Texture2D::Texture2D(const std::string fileName, VkFormat format, int usage, boo
 	SetName(GetFileNameWithoutExtension(fileName));
 }
 
+bool		Texture2D::LoadCompressed(const std::string & fileName, VkFormat requestedFormat, bool generateMips)
+{
+	VulkanInstance *	vulkanInstance = VulkanInstance::Get();
+	ImageData			imageData;
+
+	if (ImageData::IsContainerFile(fileName))
+	{
+		imageData = ImageData::LoadContainerFile(fileName);
+		// Devices without BC support get the decompressed image
+		if (!vulkanInstance->IsFormatSupported(imageData.format, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		{
+			try {
+				imageData = imageData.Decompress();
+			} catch (const std::runtime_error & e) {
+				// No CPU decoder for this format (BC6H), there is no source image to fallback on so use a placeholder
+				static const uint8_t	placeholder[4] = {255, 0, 255, 255};
+
+				std::cerr << "Can't load texture " << fileName << " on this device: " << e.what() << std::endl;
+				imageData = ImageData::FromRGBA8(placeholder, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, false);
+			}
+		}
+	}
+	else if (ImageData::IsBlockCompressed(requestedFormat) && ImageData::CanEncode(requestedFormat)
+		&& vulkanInstance->IsFormatSupported(ImageData::GetEncodableFormat(requestedFormat), VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		imageData = ImageData::LoadAndCompress(fileName, requestedFormat, generateMips);
+	else
+		return false;
+
+	this->format = imageData.format;
+	this->width = imageData.width;
+	this->height = imageData.height;
+	this->maxMipLevel = static_cast< int >(imageData.levels.size());
+
+	AllocateImage(VK_IMAGE_VIEW_TYPE_2D);
+	UploadImageData(imageData);
+
+	return true;
+}
+
 Texture2D::Texture2D(unsigned width, unsigned height, VkFormat format, int usage, void *data, unsigned size, bool generateMips)
 {
 	this->format = format;
 	this->width = width;
 	this->height = height;
+	// Force transfer flag (as the image comes from the RAM)
+    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     this->usage = usage;
 
 	if (generateMips)
@@ -52,13 +102,17 @@ Texture2D::Texture2D(unsigned width, unsigned height, VkFormat format, int usage
 	UploadImageWithMips(image, format, data, size, imgSize);
 }
 
-Texture2D::Texture2D(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips)
+Texture2D::Texture2D(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips, VkSampleCountFlagBits samples)
 {
 	this->format = format;
 	this->width = width;
 	this->height = height;
     this->arraySize = 1;
     this->usage = usage;
+	this->samples = samples;
+
+	if (allocateMips && samples != VK_SAMPLE_COUNT_1_BIT)
+		throw std::runtime_error("Multisampled textures can't have mips");
 
 	maxMipLevel = (allocateMips) ? static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1 : 1;
 
@@ -79,9 +133,14 @@ Texture2D * Texture2D::Create(const std::string fileName, VkFormat format, int u
 	return new Texture2D(fileName, format, usage, generateMips);
 }
 
-Texture2D * Texture2D::Create(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips)
+Texture2D * Texture2D::Create(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips, VkSampleCountFlagBits samples)
+{
+	return new Texture2D(width, height, format, usage, allocateMips, samples);
+}
+
+Texture2D * Texture2D::Create(unsigned width, unsigned height, VkFormat format, int usage, void * data, unsigned size, bool generateMips)
 {
-	return new Texture2D(width, height, format, usage, allocateMips);
+	return new Texture2D(width, height, format, usage, data, size, generateMips);
 }
 
 Texture2D * Texture2D::Create(Texture2D const & src)
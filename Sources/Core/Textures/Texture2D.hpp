@@ -18,15 +18,20 @@ namespace LWGC
 			Texture2D(void) = delete;
 			Texture2D(const std::string fileName, VkFormat format, int usage, bool generateMips = false);
 			Texture2D(unsigned width, unsigned height, VkFormat format, int usage, void *data, unsigned size, bool generateMips = false);
-			Texture2D(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips = false);
+			Texture2D(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips = false, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
 			Texture2D(const Texture2D &);
 
 			std::string		_name;
 			stbi_uc *		_pixels;
 
+			// Load KTX2/DDS files or BC compress the image, returns false if the RGBA8 path must be used
+			bool			LoadCompressed(const std::string & fileName, VkFormat requestedFormat, bool generateMips);
+
 		public:
 			static Texture2D *Create(const std::string fileName, VkFormat format, int usage, bool generateMips = false);
-			static Texture2D *Create(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips = false);
+			// Empty image in the general layout, multisampled images can't have mips
+			static Texture2D *Create(std::size_t width, std::size_t height, VkFormat format, int usage, bool allocateMips = false, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
+			static Texture2D *Create(unsigned width, unsigned height, VkFormat format, int usage, void * data, unsigned size, bool generateMips = false);
 			static Texture2D *Create(const Texture2D &);
 
 			virtual ~Texture2D(void);
@@ -7,19 +7,20 @@ using namespace LWGC;
 
 #include STB_INCLUDE_IMAGE
 
-Texture2DArray::Texture2DArray(int width, int height, int arraySize, VkFormat format, int usage)
+Texture2DArray::Texture2DArray(int width, int height, int arraySize, VkFormat format, int usage, int mipLevels) :
+	_stagingBuffer(VK_NULL_HANDLE), _stagingBufferMemory(VK_NULL_HANDLE), _stagingData(nullptr), _layerStagingSize(0), _uploaded(false)
 {
 	this->format = format;
 	this->width = width;
 	this->height = height;
 	this->arraySize = arraySize;
-	this->usage = usage;
+	this->usage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	this->maxMipLevel = std::max(mipLevels, 1);
 
 	AllocateImage(VK_IMAGE_VIEW_TYPE_2D_ARRAY);
 
-	// TODO: hardcoded pixel size
-	VkDeviceSize imageSize = width * height * 4 * arraySize;
-	Vk::CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _stagingBuffer, _stagingBufferMemory);
+	for (int i = 0; i < maxMipLevel; i++)
+		_layerStagingSize += ImageData::GetLevelSize(format, std::max(width >> i, 1), std::max(height >> i, 1));
 }
 
 Texture2DArray::Texture2DArray(Texture2DArray const & src)
@@ -27,9 +28,9 @@ Texture2DArray::Texture2DArray(Texture2DArray const & src)
 	*this = src;
 }
 
-Texture2DArray *Texture2DArray::Create(int width, int height, int arraySize, VkFormat format, int usage)
+Texture2DArray *Texture2DArray::Create(int width, int height, int arraySize, VkFormat format, int usage, int mipLevels)
 {
-	return new Texture2DArray(width, height, arraySize, format, usage);
+	return new Texture2DArray(width, height, arraySize, format, usage, mipLevels);
 }
 
 Texture2DArray *Texture2DArray::Create(Texture2DArray const & src)
@@ -37,6 +38,28 @@ Texture2DArray *Texture2DArray::Create(Texture2DArray const & src)
 	return new Texture2DArray(src);
 }
 
+// The staging buffer only lives between the first SetImage and the Upload
+void	Texture2DArray::AllocateStagingBuffer(void)
+{
+	VkDeviceSize stagingSize = _layerStagingSize * arraySize;
+
+	Vk::CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _stagingBuffer, _stagingBufferMemory);
+	Vk::CheckResult(vkMapMemory(device, _stagingBufferMemory, 0, stagingSize, 0, reinterpret_cast< void ** >(&_stagingData)), "Can't map texture array staging buffer");
+}
+
+void	Texture2DArray::ReleaseStagingBuffer(void) noexcept
+{
+	if (_stagingBuffer == VK_NULL_HANDLE)
+		return ;
+
+	vkUnmapMemory(device, _stagingBufferMemory);
+	vkDestroyBuffer(device, _stagingBuffer, nullptr);
+	vkFreeMemory(device, _stagingBufferMemory, nullptr);
+	_stagingBuffer = VK_NULL_HANDLE;
+	_stagingBufferMemory = VK_NULL_HANDLE;
+	_stagingData = nullptr;
+}
+
 void	Texture2DArray::SetImage(const std::string & fileName, int targetIndex)
 {
 	int imageWidth;
@@ -45,55 +68,98 @@ void	Texture2DArray::SetImage(const std::string & fileName, int targetIndex)
 	stbi_uc * pixels = LoadFromFile(fileName, imageWidth, imageHeight);
 
 	if (imageWidth != width || imageHeight != height)
+	{
+		stbi_image_free(pixels);
 		throw std::runtime_error("Mismatching texture size between texture array and assigned texture");
+	}
 
-	// TODO: hardcoded pixel size
-	VkDeviceSize imageSize = width * height * 4;
-
-	// Copy image to staging buffer region
-	memcpy(static_cast< char * >(_stagingData) + imageSize * targetIndex, pixels, imageSize);
-
+	ImageData image = ImageData::FromRGBA8(pixels, imageWidth, imageHeight, format, maxMipLevel > 1, maxMipLevel);
 	stbi_image_free(pixels);
 
-	// setup staging buffer image to final texture 2D array
-	VkBufferImageCopy bufferCopyRegion = {};
-	bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	bufferCopyRegion.imageSubresource.mipLevel = 0;
-	bufferCopyRegion.imageSubresource.baseArrayLayer = targetIndex;
-	bufferCopyRegion.imageSubresource.layerCount = 1;
-	bufferCopyRegion.imageExtent.width = static_cast<uint32_t>(width);
-	bufferCopyRegion.imageExtent.height = static_cast<uint32_t>(height);
-	bufferCopyRegion.imageExtent.depth = 1;
-	bufferCopyRegion.bufferOffset = imageSize * targetIndex;
-
-	_bufferCopyRegions.push_back(bufferCopyRegion);
+	SetImage(image, targetIndex);
 }
 
-void	Texture2DArray::Upload(void)
+void	Texture2DArray::SetImage(const ImageData & image, int targetIndex)
 {
-	vkUnmapMemory(device, _stagingBufferMemory);
-
-	const auto & cmd = graphicCommandBufferPool->BeginSingle();
+	if (image.width != width || image.height != height || image.format != format)
+		throw std::runtime_error("Mismatching texture size or format between texture array and assigned texture");
+	if (image.levels.size() < static_cast< size_t >(maxMipLevel))
+		throw std::runtime_error("Texture array image needs " + std::to_string(maxMipLevel) + " mip levels");
+	if (targetIndex < 0 || targetIndex >= arraySize)
+		throw std::runtime_error("Texture array index out of range: " + std::to_string(targetIndex));
+
+	if (_stagingData == nullptr)
+		AllocateStagingBuffer();
+
+	VkDeviceSize offset = _layerStagingSize * targetIndex;
+	for (int i = 0; i < maxMipLevel; i++)
+	{
+		const auto & level = image.levels[i];
+
+		memcpy(_stagingData + offset, image.data.data() + level.offset, level.size);
+
+		VkBufferImageCopy bufferCopyRegion = {};
+		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		bufferCopyRegion.imageSubresource.mipLevel = static_cast< uint32_t >(i);
+		bufferCopyRegion.imageSubresource.baseArrayLayer = static_cast< uint32_t >(targetIndex);
+		bufferCopyRegion.imageSubresource.layerCount = 1;
+		bufferCopyRegion.imageExtent.width = static_cast< uint32_t >(level.width);
+		bufferCopyRegion.imageExtent.height = static_cast< uint32_t >(level.height);
+		bufferCopyRegion.imageExtent.depth = 1;
+		bufferCopyRegion.bufferOffset = offset;
+		_bufferCopyRegions.push_back(bufferCopyRegion);
+
+		offset += level.size;
+	}
+}
 
-	TransitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+void	Texture2DArray::Upload(void)
+{
+	if (_bufferCopyRegions.empty())
+		return ;
+
+	VkCommandBuffer cmd = graphicCommandBufferPool->BeginSingle();
+
+	// Layers uploaded previously must be preserved, so the old layout can't be undefined after the first upload
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = (_uploaded) ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = static_cast< uint32_t >(maxMipLevel);
+	barrier.subresourceRange.layerCount = static_cast< uint32_t >(arraySize);
+	barrier.srcAccessMask = (_uploaded) ? VK_ACCESS_SHADER_READ_BIT : 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
 	vkCmdCopyBufferToImage(
 		cmd,
 		_stagingBuffer,
 		image,
 		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		_bufferCopyRegions.size(),
+		static_cast< uint32_t >(_bufferCopyRegions.size()),
 		_bufferCopyRegions.data()
 	);
 
-	TransitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	graphicCommandBufferPool->EndSingle(cmd);
+
+	_bufferCopyRegions.clear();
+	_uploaded = true;
+	ReleaseStagingBuffer();
 }
 
 Texture2DArray::~Texture2DArray(void)
 {
-	vkDestroyBuffer(device, _stagingBuffer, nullptr);
+	ReleaseStagingBuffer();
 }
 
+int		Texture2DArray::GetArraySize() { return arraySize; }
+int		Texture2DArray::GetMipLevelCount(void) const noexcept { return maxMipLevel; }
+
 Texture2DArray &	Texture2DArray::operator=(Texture2DArray const & src)
 {
 	Texture::operator=(src);
@@ -6,6 +6,7 @@
 
 #include "IncludeDeps.hpp"
 #include "Core/Textures/Texture.hpp"
+#include "Core/Textures/ImageData.hpp"
 
 #include VULKAN_INCLUDE
 
@@ -15,26 +16,35 @@ namespace LWGC
 	{
 		private:
 			Texture2DArray(void) = delete;
-			Texture2DArray(int width, int height, int arraySize, VkFormat format, int usage);
+			Texture2DArray(int width, int height, int arraySize, VkFormat format, int usage, int mipLevels);
 			Texture2DArray(const Texture2DArray &);
 
 			VkBuffer							_stagingBuffer;
 			VkDeviceMemory						_stagingBufferMemory;
-			void *								_stagingData;
+			uint8_t *							_stagingData;
+			VkDeviceSize						_layerStagingSize;
 			std::vector< VkBufferImageCopy >	_bufferCopyRegions;
-	
+			bool								_uploaded;
+
+			void	AllocateStagingBuffer(void);
+			void	ReleaseStagingBuffer(void) noexcept;
+
 		public:
-			static Texture2DArray *Create(int width, int height, int arraySize, VkFormat format, int usage);
+			static Texture2DArray *Create(int width, int height, int arraySize, VkFormat format, int usage, int mipLevels = 1);
 			static Texture2DArray *Create(const Texture2DArray &);
 			virtual ~Texture2DArray(void);
 
 			void	SetImage(const std::string & fileName, int targetIndex);
+			// The image must have the size and format of the array and at least as many levels
+			void	SetImage(const ImageData & image, int targetIndex);
+			// Copy all the images set since the last upload in a single command buffer and release the staging memory
 			void	Upload(void);
 
 			int		GetArraySize();
-	
+			int		GetMipLevelCount(void) const noexcept;
+
 			Texture2DArray &	operator=(Texture2DArray const & src);
 	};
-	
+
 	std::ostream &	operator<<(std::ostream & o, Texture2DArray const & r);
-}
\ No newline at end of file
+}
@@ -1,13 +1,17 @@
 #include "Texture2DAtlas.hpp"
 #include "Utils/Vector.hpp"
+#include "Utils/ThreadPool.hpp"
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 
 using namespace LWGC;
 
 // check in is power of 2
-Texture2DAtlas::Texture2DAtlas(uint32_t w, uint32_t h, VkFormat format, int usage, bool allocateMips) : _nodetree(w, h)
+Texture2DAtlas::Texture2DAtlas(uint32_t w, uint32_t h, VkFormat format, int usage, bool allocateMips) : _allocator(w, h), _hasContent(false),
+	_sizeOffsetsBuffer(VK_NULL_HANDLE), _sizeOffsetsMemory(VK_NULL_HANDLE), _sizeOffsetsCapacity(0)
 {
 	if ((((w * h) != 0) && ( (w * h) &  ((w * h) - 1)) == 1) )
 		throw std::runtime_error("Texture2DAtlas needs to be power of 2");
@@ -46,41 +50,225 @@ Texture2DAtlas *Texture2DAtlas::Create(uint32_t w, uint32_t h, VkFormat format,
 
 Rect Texture2DAtlas::Fit(const std::string & fileName)
 {
-	int width, height;
-
-	_pixels = LoadFromFile(fileName, width, height);
-	Rect rect = _nodetree.Allocate(width, height);
-	glm::ivec3 imgSize = glm::ivec3(width ,height, 1);
-	glm::ivec3 offset = glm::ivec3(rect.GetMinX(), rect.GetMinY(), 0);
-	glm::vec4 sizeoffset = glm::vec4(
-		glm::vec2(imgSize.x, imgSize.y) / glm::vec2(this->width, this->height),
-		glm::vec2(offset.x, offset.y) / glm::vec2(this->width, this->height)
-	);
-	this->_sizeOffsets.push_back(sizeoffset);
-	UploadImage(_pixels, width * height * 4, imgSize, offset);
+	std::vector< ImageData > images{ImageData::LoadRGBA8(fileName)};
+
+	Rect rect = FitImages(images, {fileName})[0];
+	UploadAtlasDatas();
 
-	stbi_image_free(_pixels);
 	return rect;
 }
 
+std::vector< Rect >	Texture2DAtlas::Fit(const std::vector< std::string > & fileNames)
+{
+	std::vector< ImageData >	images(fileNames.size());
+	std::vector< std::string >	errors(fileNames.size());
+	ThreadPool					pool;
+
+	pool.ParallelFor(fileNames.size(), [&](size_t i)
+	{
+		try {
+			images[i] = ImageData::LoadRGBA8(fileNames[i]);
+		} catch (const std::runtime_error & e) {
+			errors[i] = e.what();
+		}
+	});
+
+	for (const auto & error : errors)
+		if (!error.empty())
+			std::cerr << error << std::endl;
+
+	auto rects = FitImages(images, fileNames);
+	UploadAtlasDatas();
+
+	return rects;
+}
+
+std::vector< Rect >	Texture2DAtlas::FitImages(const std::vector< ImageData > & images, const std::vector< std::string > & names)
+{
+	std::vector< glm::ivec2 >			sizes;
+	std::vector< Rect >					rects(images.size(), Rect::Invalid);
+	std::vector< VkBufferImageCopy >	regions;
+	VkDeviceSize						stagingSize = 0;
+
+	// Images that failed to load have a null size and are never allocated
+	for (const auto & img : images)
+		sizes.push_back(glm::ivec2(img.width, img.height));
+
+	auto ids = _allocator.AllocateBatch(sizes);
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (ids[i] == AtlasAllocator::InvalidId)
+		{
+			if (images[i].width > 0)
+				std::cerr << "No space left in texture2DAtlas for " << names[i] << " (" << images[i].width << "x" << images[i].height << ")" << std::endl;
+			continue ;
+		}
+
+		AtlasRect area = _allocator.GetRect(ids[i]);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = stagingSize;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = {area.x, area.y, 0};
+		region.imageExtent = {static_cast< uint32_t >(area.width), static_cast< uint32_t >(area.height), 1};
+		regions.push_back(region);
+		stagingSize += images[i].data.size();
+
+		rects[i] = Rect(area.width, area.height, area.x, area.y);
+		this->_sizeOffsets.push_back(glm::vec4(
+			glm::vec2(area.width, area.height) / glm::vec2(this->width, this->height),
+			glm::vec2(area.x, area.y) / glm::vec2(this->width, this->height)
+		));
+		this->_allocationIds.push_back(ids[i]);
+	}
+
+	if (regions.empty())
+		return rects;
+
+	VkBuffer		stagingBuffer;
+	VkDeviceMemory	stagingBufferMemory;
+	uint8_t *		stagingData;
+
+	Vk::CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	Vk::CheckResult(vkMapMemory(device, stagingBufferMemory, 0, stagingSize, 0, reinterpret_cast< void ** >(&stagingData)), "Can't map atlas staging buffer");
+	for (size_t i = 0, r = 0; i < images.size(); i++)
+		if (ids[i] != AtlasAllocator::InvalidId)
+			std::memcpy(stagingData + regions[r++].bufferOffset, images[i].data.data(), images[i].data.size());
+	vkUnmapMemory(device, stagingBufferMemory);
+
+	// The images already in the atlas must be preserved, the old layout is only undefined for the first upload
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = (_hasContent) ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = maxMipLevel;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = (_hasContent) ? VK_ACCESS_SHADER_READ_BIT : 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	VkCommandBuffer cmd = graphicCommandBufferPool->BeginSingle();
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast< uint32_t >(regions.size()), regions.data());
+	TransitionImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	graphicCommandBufferPool->EndSingle(cmd);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	_hasContent = true;
+
+	return rects;
+}
+
 void	Texture2DAtlas::UploadAtlasDatas(void)
 {
-	Vk::CreateBuffer(
-		GetSizeOffsetBufferSize(),
-		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // StructuredBuffer are always in storage mode
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		this->_sizeOffsetsBuffer,
-		this->_sizeOffsetsMemory
-	);
+	if (_sizeOffsets.empty())
+		return ;
+
+	// The buffer is only reallocated when it's too small, the descriptors bound to the old one become invalid
+	if (_sizeOffsets.size() > _sizeOffsetsCapacity)
+	{
+		if (_sizeOffsetsBuffer != VK_NULL_HANDLE)
+		{
+			vkDeviceWaitIdle(device);
+			vkDestroyBuffer(device, _sizeOffsetsBuffer, nullptr);
+			vkFreeMemory(device, _sizeOffsetsMemory, nullptr);
+		}
+
+		_sizeOffsetsCapacity = std::max(_sizeOffsets.size(), _sizeOffsetsCapacity * 2);
+		Vk::CreateBuffer(
+			_sizeOffsetsCapacity * sizeof(glm::vec4),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // StructuredBuffer are always in storage mode
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			this->_sizeOffsetsBuffer,
+			this->_sizeOffsetsMemory
+		);
+	}
 
 	// this->_sizeOffsetBufferView = Vk::CreateBufferView(this->_sizeOffsetsBuffer, VK_FORMAT_R32G32B32A32_SFLOAT); // Not supported on Metal 1
 	Vk::UploadToMemory(_sizeOffsetsMemory, _sizeOffsets.data(), GetSizeOffsetBufferSize());
 	Vk::UploadToMemory(_atlasSizeMemory, &_atlasSize, GetAtlasSizeBufferSize());
 }
 
+void	Texture2DAtlas::Remove(size_t index)
+{
+	if (index >= _allocationIds.size() || _allocationIds[index] == AtlasAllocator::InvalidId)
+		return ;
+
+	_allocator.Deallocate(_allocationIds[index]);
+	_allocationIds[index] = AtlasAllocator::InvalidId;
+	_sizeOffsets[index] = glm::vec4(0);
+}
+
+size_t	Texture2DAtlas::Defragment(size_t maxMoves)
+{
+	auto moves = _allocator.Defragment(maxMoves);
+
+	if (moves.empty())
+		return 0;
+
+	std::vector< VkImageCopy >	regions;
+	for (const auto & move : moves)
+	{
+		size_t index = std::find(_allocationIds.begin(), _allocationIds.end(), move.id) - _allocationIds.begin();
+
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.srcOffset = {move.from.x, move.from.y, 0};
+		region.dstSubresource = region.srcSubresource;
+		region.dstOffset = {move.to.x, move.to.y, 0};
+		region.extent = {static_cast< uint32_t >(move.to.width), static_cast< uint32_t >(move.to.height), 1};
+		regions.push_back(region);
+
+		_sizeOffsets[index] = glm::vec4(
+			glm::vec2(move.to.width, move.to.height) / glm::vec2(this->width, this->height),
+			glm::vec2(move.to.x, move.to.y) / glm::vec2(this->width, this->height)
+		);
+	}
+
+	// Source and destination are in the same image so it has to be in general layout during the copy,
+	// the allocator guarantees that no destination overlaps a source
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = maxMipLevel;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	VkCommandBuffer cmd = graphicCommandBufferPool->BeginSingle();
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	vkCmdCopyImage(cmd, image, VK_IMAGE_LAYOUT_GENERAL, image, VK_IMAGE_LAYOUT_GENERAL, static_cast< uint32_t >(regions.size()), regions.data());
+
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	graphicCommandBufferPool->EndSingle(cmd);
+
+	if (_sizeOffsetsBuffer != VK_NULL_HANDLE)
+		Vk::UploadToMemory(_sizeOffsetsMemory, _sizeOffsets.data(), GetSizeOffsetBufferSize());
+
+	return moves.size();
+}
+
 void	Texture2DAtlas::Clear(void)
 {
-	_nodetree.Clear();
+	_allocator.Clear();
+	_sizeOffsets.clear();
+	_allocationIds.clear();
 }
 
 VkBuffer		Texture2DAtlas::GetAtlasSizeBuffer() { return _atlasSizeBuffer; }
@@ -88,6 +276,7 @@ VkBuffer		Texture2DAtlas::GetSizeOffsetBuffer() { return _sizeOffsetsBuffer; }
 VkBufferView	Texture2DAtlas::GetSizeOffsetBufferView() { return _sizeOffsetBufferView; }
 size_t			Texture2DAtlas::GetAtlasSizeBufferSize() { return sizeof(glm::vec4); }
 size_t			Texture2DAtlas::GetSizeOffsetBufferSize() {return _sizeOffsets.size() * sizeof(glm::vec4); }
+const AtlasAllocator &	Texture2DAtlas::GetAllocator(void) const noexcept { return _allocator; }
 
 std::ostream &	operator<<(std::ostream & o, Texture2DAtlas const & r)
 {
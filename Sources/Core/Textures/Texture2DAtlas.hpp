@@ -4,7 +4,9 @@
 # include <string>
 
 #include "IncludeDeps.hpp"
-#include "Core/NodeTree.hpp"
+#include "Core/AtlasAllocator.hpp"
+#include "Core/Textures/ImageData.hpp"
+#include "Utils/Rect.hpp"
 #include "Core/Textures/Texture.hpp"
 #include "Core/Vulkan/Vk.hpp"
 
@@ -18,10 +20,11 @@ namespace LWGC
 		private:
 			Texture2DAtlas(uint32_t w, uint32_t h, VkFormat format, int usage, bool allocateMips);
 			int							_maxMipLevel;
-			stbi_uc						*_pixels;
-			NodeTree					_nodetree;
+			AtlasAllocator				_allocator;
+			bool						_hasContent;
 
 			std::vector< glm::vec4 >	_sizeOffsets; // xy: size, zw: offset (UV space)
+			std::vector< uint32_t >		_allocationIds; // Allocator id of each sizeOffset
 			glm::vec4					_atlasSize;
 
 			VkBuffer		_sizeOffsetsBuffer;
@@ -30,6 +33,9 @@ namespace LWGC
 
 			VkDeviceMemory	_sizeOffsetsMemory;
 			VkDeviceMemory	_atlasSizeMemory;
+			size_t			_sizeOffsetsCapacity;
+
+			std::vector< Rect >	FitImages(const std::vector< ImageData > & images, const std::vector< std::string > & names);
 
 		public:
 			Texture2DAtlas(void) = delete;
@@ -39,7 +45,15 @@ namespace LWGC
 
 			// vector of blocks -- texture, width, height
 			static Texture2DAtlas	*Create(uint32_t w, uint32_t h, VkFormat format, int usage, bool allocateMips);
+			// Returns Rect::Invalid if there is no space left in the atlas
 			Rect					Fit(const std::string & fileName);
+			// Decode the images in parallel, pack them by decreasing area and upload them with a single command buffer.
+			// The size offset buffer is updated, its indices follow the successfully placed images
+			std::vector< Rect >		Fit(const std::vector< std::string > & fileNames);
+			// Free the space of a texture, its index in the sizeOffset buffer stays valid (with a null size)
+			void					Remove(size_t index);
+			// Move at most maxMoves textures to compact the atlas with GPU copies, returns the number of moved textures
+			size_t					Defragment(size_t maxMoves);
 			void					UploadAtlasDatas(void);
 
 			VkBuffer				GetAtlasSizeBuffer(void);
@@ -48,6 +62,7 @@ namespace LWGC
 			size_t					GetAtlasSizeBufferSize(void);
 			size_t					GetSizeOffsetBufferSize(void);
 			void					Clear(void);
+			const AtlasAllocator &	GetAllocator(void) const noexcept;
 
 			Texture2DAtlas &	operator=(Texture2DAtlas const & src) = delete;
 	};
@@ -0,0 +1,576 @@
+#include "TextureStreamer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "Core/MaterialTable.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/Vulkan/Vk.hpp"
+
+#include STB_INCLUDE_IMAGE
+
+using namespace LWGC;
+
+static void		ImageBarrier(VkCommandBuffer cmd, VkImage image, int levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+{
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = static_cast< uint32_t >(levelCount);
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+TextureStreamer::TextureStreamer(void) : _device(VK_NULL_HANDLE), _placeholder(nullptr), _frameIndex(0), _nextRequestId(1),
+	_memoryBudget(DefaultMemoryBudget), _uploadBudget(DefaultUploadBudget), _residentSize(0)
+{
+}
+
+TextureStreamer::~TextureStreamer(void)
+{
+	if (!_stagingRing.IsInitialized())
+		return ;
+
+	// Wait for the decode jobs before anything else, they push into _decodedTextures
+	WaitDecodes();
+	for (auto texture : _textures)
+		ReleaseEvictedLevels(texture);
+	_stagingRing.Release();
+	vkDeviceWaitIdle(_device);
+	DestroyReleasedResources(true);
+}
+
+void				TextureStreamer::Initialize(void)
+{
+	uint8_t		gray[4] = {128, 128, 128, 255};
+
+	_device = VulkanInstance::Get()->GetDevice();
+	_stagingRing.Initialize(DefaultStagingSize);
+	_placeholder = Texture2D::Create(1u, 1u, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, gray, 4);
+}
+
+StreamedTexture *	TextureStreamer::Load(const std::string & fileName, VkFormat format, int usage)
+{
+	if (!_stagingRing.IsInitialized())
+		Initialize();
+
+	auto texture = new StreamedTexture(this, fileName, format, usage, _placeholder->GetView());
+	texture->_lastUsedFrame = _frameIndex;
+	_textures.insert(texture);
+
+	RequestDecode(texture);
+
+	return texture;
+}
+
+void				TextureStreamer::RequestDecode(StreamedTexture * texture)
+{
+	uint64_t	requestId = _nextRequestId++;
+	std::string	fileName = texture->_fileName;
+	VkFormat	format = texture->_requestedFormat;
+
+	texture->_state = TextureStreamingState::Loading;
+	texture->_requestId = requestId;
+
+	// The texture pointer is only used as a key on the main thread, it may be destroyed before the decode ends
+	_decodes.push_back(ThreadPool::GetShared().Submit([this, texture, requestId, fileName, format]()
+	{
+		auto decoded = std::make_shared< DecodedTexture >();
+
+		decoded->texture = texture;
+		decoded->requestId = requestId;
+		try {
+			decoded->image = DecodeFile(fileName, format);
+		} catch (const std::exception & e) {
+			decoded->error = e.what();
+		}
+
+		std::lock_guard< std::mutex > lock(_decodedMutex);
+		_decodedTextures.push_back(decoded);
+	}));
+}
+
+void				TextureStreamer::WaitDecodes(void)
+{
+	// Only the jobs of the streamer, the shared pool also runs the ones of the other systems
+	for (auto & decode : _decodes)
+		decode.wait();
+	_decodes.clear();
+}
+
+ImageData			TextureStreamer::DecodeFile(const std::string & fileName, VkFormat format)
+{
+	VulkanInstance *	instance = VulkanInstance::Get();
+
+	if (ImageData::IsContainerFile(fileName))
+	{
+		ImageData image = ImageData::LoadContainerFile(fileName);
+		if (!instance->IsFormatSupported(image.format, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+			image = image.Decompress();
+		return image;
+	}
+
+	if (ImageData::IsBlockCompressed(format) && ImageData::CanEncode(format)
+		&& instance->IsFormatSupported(ImageData::GetEncodableFormat(format), VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		return ImageData::LoadAndCompress(fileName, format, true);
+
+	int			width, height, channels;
+	stbi_uc *	pixels = stbi_load(fileName.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (!pixels)
+		throw std::runtime_error("Failed to load texture image from file: " + fileName);
+
+	// Mips are generated here instead of blitting them on the GPU, so the upload is a single copy
+	ImageData image = ImageData::FromRGBA8(pixels, width, height, (format == VK_FORMAT_R8G8B8A8_SRGB) ? format : VK_FORMAT_R8G8B8A8_UNORM, true);
+	stbi_image_free(pixels);
+
+	return image;
+}
+
+void				TextureStreamer::Update(void)
+{
+	if (!_stagingRing.IsInitialized())
+		return ;
+
+	_frameIndex++;
+
+	auto done = std::remove_if(_decodes.begin(), _decodes.end(), [](const std::future< void > & decode)
+	{
+		return decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	});
+	_decodes.erase(done, _decodes.end());
+
+	_stagingRing.Retire();
+	DestroyReleasedResources();
+
+	UploadDecodedTextures();
+	EnforceMemoryBudget();
+	RestoreEvictedMips();
+
+	// Submission order guarantees the copies are done before this frame's rendering
+	if (_stagingRing.HasPendingCommands())
+		_stagingRing.Submit();
+
+	if (!_changedTextures.empty())
+	{
+		MaterialTable::Get()->NotifyTexturesChanged(_changedTextures);
+		_changedTextures.clear();
+	}
+}
+
+void				TextureStreamer::Flush(void)
+{
+	if (!_stagingRing.IsInitialized())
+		return ;
+
+	WaitDecodes();
+
+	while (true)
+	{
+		size_t	uploadBudget = _uploadBudget;
+
+		_uploadBudget = SIZE_MAX;
+		UploadDecodedTextures();
+		_uploadBudget = uploadBudget;
+
+		if (_stagingRing.HasPendingCommands())
+			_stagingRing.Submit();
+		_stagingRing.WaitIdle();
+
+		std::lock_guard< std::mutex > lock(_decodedMutex);
+		if (_decodedTextures.empty())
+			break ;
+	}
+
+	if (!_changedTextures.empty())
+	{
+		MaterialTable::Get()->NotifyTexturesChanged(_changedTextures);
+		_changedTextures.clear();
+	}
+}
+
+void				TextureStreamer::UploadDecodedTextures(void)
+{
+	size_t	uploadedSize = 0;
+
+	while (true)
+	{
+		std::shared_ptr< DecodedTexture >	decoded;
+
+		{
+			std::lock_guard< std::mutex > lock(_decodedMutex);
+			if (_decodedTextures.empty())
+				break ;
+			// Only the main thread pops, so the front stays valid after unlocking
+			decoded = _decodedTextures.front();
+		}
+
+		auto	texture = decoded->texture;
+		bool	stale = _textures.count(texture) == 0 || texture->_requestId != decoded->requestId;
+		size_t	size = decoded->image.data.size();
+
+		if (!stale && decoded->error.empty())
+		{
+			if (uploadedSize > 0 && uploadedSize + size > _uploadBudget)
+				break ;
+			// Staging ring is full, wait for the previous batches to complete
+			if (!Upload(texture, decoded->image))
+				break ;
+			uploadedSize += size;
+		}
+		else if (!stale)
+		{
+			std::cerr << "Failed to stream texture: " << decoded->error << std::endl;
+			texture->_state = (texture->IsReady()) ? TextureStreamingState::Resident : TextureStreamingState::Failed;
+		}
+
+		std::lock_guard< std::mutex > lock(_decodedMutex);
+		_decodedTextures.pop_front();
+	}
+}
+
+bool				TextureStreamer::Upload(StreamedTexture * texture, const ImageData & imageData)
+{
+	VkBuffer			buffer;
+	VkDeviceSize		offset = 0;
+	uint8_t *			data;
+	VkImage				image;
+	VkDeviceMemory		memory;
+	int					levelCount = static_cast< int >(imageData.levels.size());
+
+	if (imageData.data.size() > _stagingRing.GetSize())
+		buffer = _stagingRing.AllocateDedicated(imageData.data.size(), data);
+	else if (_stagingRing.Allocate(imageData.data.size(), 16, offset, data))
+		buffer = _stagingRing.GetBuffer();
+	else
+		return false;
+
+	std::memcpy(data, imageData.data.data(), imageData.data.size());
+
+	Vk::CreateImage(imageData.width, imageData.height, 1, 1, levelCount, imageData.format, VK_IMAGE_TILING_OPTIMAL, texture->usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+	VkImageView view = Vk::CreateImageView(image, imageData.format, levelCount, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	std::vector< VkBufferImageCopy >	regions;
+	for (int i = 0; i < levelCount; i++)
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = offset + imageData.levels[i].offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {static_cast< uint32_t >(imageData.levels[i].width), static_cast< uint32_t >(imageData.levels[i].height), 1};
+		regions.push_back(region);
+	}
+
+	VkCommandBuffer cmd = _stagingRing.GetCommandBuffer();
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	vkCmdCopyBufferToImage(cmd, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast< uint32_t >(regions.size()), regions.data());
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	texture->format = imageData.format;
+	texture->width = imageData.width;
+	texture->height = imageData.height;
+	texture->_mipCount = levelCount;
+	texture->_levelSizes.clear();
+	for (const auto & level : imageData.levels)
+		texture->_levelSizes.push_back(level.size);
+
+	ReleaseEvictedLevels(texture);
+	SwapImage(texture, image, memory, view, 0, levelCount);
+	texture->_state = TextureStreamingState::Resident;
+
+	return true;
+}
+
+void				TextureStreamer::SwapImage(StreamedTexture * texture, VkImage image, VkDeviceMemory memory, VkImageView view, int firstMip, int levelCount)
+{
+	if (texture->allocated)
+	{
+		ReleaseImage(texture->image, texture->memory, texture->view);
+		_residentSize -= texture->GetResidentSize();
+	}
+
+	texture->image = image;
+	texture->memory = memory;
+	texture->view = view;
+	texture->allocated = true;
+	texture->maxMipLevel = levelCount;
+	texture->_firstResidentMip = firstMip;
+	_residentSize += texture->GetResidentSize();
+
+	// Descriptor sets still point to the old view
+	_changedTextures.insert(texture);
+}
+
+void				TextureStreamer::EnforceMemoryBudget(void)
+{
+	std::vector< StreamedTexture * >				candidates;
+	std::unordered_map< StreamedTexture *, int >	droppedMips;
+	size_t											projectedSize = _residentSize;
+
+	if (_residentSize <= _memoryBudget)
+		return ;
+
+	for (auto texture : _textures)
+		if (texture->_state == TextureStreamingState::Resident && texture->_mipCount - texture->_firstResidentMip > 1)
+			candidates.push_back(texture);
+
+	std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture * a, const StreamedTexture * b)
+	{
+		return a->_lastUsedFrame < b->_lastUsedFrame;
+	});
+
+	// Drop one mip at a time in LRU order so recently used textures lose as little resolution as possible
+	bool progress = true;
+	while (projectedSize > _memoryBudget && progress)
+	{
+		progress = false;
+		for (auto texture : candidates)
+		{
+			int & dropped = droppedMips[texture];
+			int firstMip = texture->_firstResidentMip + dropped;
+
+			if (texture->_mipCount - firstMip <= 1)
+				continue ;
+
+			projectedSize -= texture->_levelSizes[firstMip];
+			dropped++;
+			progress = true;
+
+			if (projectedSize <= _memoryBudget)
+				break ;
+		}
+	}
+
+	for (const auto & drop : droppedMips)
+		if (drop.second > 0)
+			DropHighMips(drop.first, drop.second);
+}
+
+void				TextureStreamer::DropHighMips(StreamedTexture * texture, int count)
+{
+	VkImage			image;
+	VkDeviceMemory	memory;
+	int				firstMip = texture->_firstResidentMip + count;
+	int				levelCount = texture->_mipCount - firstMip;
+	uint32_t		width = std::max(texture->width >> firstMip, 1);
+	uint32_t		height = std::max(texture->height >> firstMip, 1);
+
+	Vk::CreateImage(width, height, 1, 1, levelCount, texture->format, VK_IMAGE_TILING_OPTIMAL, texture->usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+	VkImageView view = Vk::CreateImageView(image, texture->format, levelCount, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	std::vector< VkImageCopy >	regions;
+	for (int i = 0; i < levelCount; i++)
+	{
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.mipLevel = static_cast< uint32_t >(i + count);
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.dstSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.extent = {std::max(width >> i, 1u), std::max(height >> i, 1u), 1};
+		regions.push_back(region);
+	}
+
+	// The old image is released after this batch, no need to transition it back
+	VkCommandBuffer cmd = _stagingRing.GetCommandBuffer();
+	ImageBarrier(cmd, texture->image, texture->maxMipLevel, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	vkCmdCopyImage(cmd, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast< uint32_t >(regions.size()), regions.data());
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	// The dropped mips are kept in host memory so they come back without decoding the file again
+	texture->_evictedLevels.resize(texture->_mipCount, {VK_NULL_HANDLE, VK_NULL_HANDLE});
+	for (int i = 0; i < count; i++)
+	{
+		int					level = texture->_firstResidentMip + i;
+		auto &				evicted = texture->_evictedLevels[level];
+		VkBufferImageCopy	region = {};
+
+		Vk::CreateBuffer(texture->_levelSizes[level], VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, evicted.buffer, evicted.memory);
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {static_cast< uint32_t >(std::max(texture->width >> level, 1)), static_cast< uint32_t >(std::max(texture->height >> level, 1)), 1};
+		vkCmdCopyImageToBuffer(cmd, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, evicted.buffer, 1, &region);
+	}
+
+	SwapImage(texture, image, memory, view, firstMip, levelCount);
+}
+
+void				TextureStreamer::RestoreEvictedMips(void)
+{
+	size_t	projectedSize = _residentSize;
+	size_t	restoredSize = 0;
+
+	for (auto texture : _textures)
+	{
+		size_t missingSize = texture->GetFullSize() - texture->GetResidentSize();
+
+		// Only textures used last frame are restored, and only if they fit in the budgets
+		if (texture->_state != TextureStreamingState::Resident || texture->_firstResidentMip == 0
+			|| texture->_lastUsedFrame + 1 < _frameIndex || projectedSize + missingSize > _memoryBudget
+			|| (restoredSize > 0 && restoredSize + missingSize > _uploadBudget))
+			continue ;
+
+		projectedSize += missingSize;
+		restoredSize += missingSize;
+		RestoreEvictedMips(texture);
+	}
+}
+
+void				TextureStreamer::RestoreEvictedMips(StreamedTexture * texture)
+{
+	VkImage			image;
+	VkDeviceMemory	memory;
+	int				firstMip = texture->_firstResidentMip;
+	int				levelCount = texture->_mipCount;
+
+	Vk::CreateImage(texture->width, texture->height, 1, 1, levelCount, texture->format, VK_IMAGE_TILING_OPTIMAL, texture->usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+	VkImageView view = Vk::CreateImageView(image, texture->format, levelCount, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	std::vector< VkImageCopy >	regions;
+	for (int i = firstMip; i < levelCount; i++)
+	{
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.mipLevel = static_cast< uint32_t >(i - firstMip);
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.dstSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.extent = {static_cast< uint32_t >(std::max(texture->width >> i, 1)), static_cast< uint32_t >(std::max(texture->height >> i, 1)), 1};
+		regions.push_back(region);
+	}
+
+	// The evicted mips were written by a previous batch
+	VkMemoryBarrier	memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkCommandBuffer cmd = _stagingRing.GetCommandBuffer();
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	ImageBarrier(cmd, texture->image, texture->maxMipLevel, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	for (int i = 0; i < firstMip; i++)
+	{
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = static_cast< uint32_t >(i);
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {static_cast< uint32_t >(std::max(texture->width >> i, 1)), static_cast< uint32_t >(std::max(texture->height >> i, 1)), 1};
+		vkCmdCopyBufferToImage(cmd, texture->_evictedLevels[i].buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+	vkCmdCopyImage(cmd, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast< uint32_t >(regions.size()), regions.data());
+	ImageBarrier(cmd, image, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	ReleaseEvictedLevels(texture);
+	SwapImage(texture, image, memory, view, 0, levelCount);
+}
+
+void				TextureStreamer::ReleaseEvictedLevels(StreamedTexture * texture)
+{
+	int		evictedCount = std::min(texture->_firstResidentMip, static_cast< int >(texture->_evictedLevels.size()));
+
+	for (int i = 0; i < evictedCount; i++)
+		ReleaseResource(VK_NULL_HANDLE, VK_NULL_HANDLE, texture->_evictedLevels[i].buffer, texture->_evictedLevels[i].memory);
+	texture->_evictedLevels.clear();
+}
+
+void				TextureStreamer::ReleaseImage(VkImage image, VkDeviceMemory memory, VkImageView view)
+{
+	ReleaseResource(image, view, VK_NULL_HANDLE, memory);
+}
+
+void				TextureStreamer::ReleaseResource(VkImage image, VkImageView view, VkBuffer buffer, VkDeviceMemory memory)
+{
+	RenderPipeline *	pipeline = RenderPipelineManager::currentRenderPipeline;
+
+	// Wait for the current batch (which may copy from the resource) and the frames in flight that may sample it
+	uint64_t batchId = (_stagingRing.HasPendingCommands()) ? _stagingRing.GetCurrentBatchId() : _stagingRing.GetCurrentBatchId() - 1;
+	uint64_t frameNumber = (pipeline != nullptr) ? pipeline->GetSubmittedFrameCount() + 1 : 0;
+
+	_releasedResources.push_back(ReleasedResource{image, view, buffer, memory, frameNumber, batchId});
+}
+
+void				TextureStreamer::DestroyReleasedResources(bool force) noexcept
+{
+	RenderPipeline *	pipeline = RenderPipelineManager::currentRenderPipeline;
+	uint64_t			completedFrame = (pipeline != nullptr) ? pipeline->GetCompletedFrameCount() : UINT64_MAX;
+
+	while (!_releasedResources.empty())
+	{
+		const auto & released = _releasedResources.front();
+
+		if (!force && (released.frameNumber > completedFrame || released.batchId > _stagingRing.GetCompletedBatchId()))
+			break ;
+
+		vkDestroyImageView(_device, released.view, nullptr);
+		vkDestroyImage(_device, released.image, nullptr);
+		vkDestroyBuffer(_device, released.buffer, nullptr);
+		vkFreeMemory(_device, released.memory, nullptr);
+		_releasedResources.pop_front();
+	}
+}
+
+void				TextureStreamer::Unregister(StreamedTexture * texture) noexcept
+{
+	if (_textures.erase(texture) == 0)
+		return ;
+
+	_changedTextures.erase(texture);
+	ReleaseEvictedLevels(texture);
+
+	if (texture->allocated)
+	{
+		_residentSize -= texture->GetResidentSize();
+		ReleaseImage(texture->image, texture->memory, texture->view);
+	}
+}
+
+void				TextureStreamer::SetMemoryBudget(size_t bytes) noexcept { _memoryBudget = bytes; }
+size_t				TextureStreamer::GetMemoryBudget(void) const noexcept { return _memoryBudget; }
+void				TextureStreamer::SetUploadBudget(size_t bytes) noexcept { _uploadBudget = bytes; }
+size_t				TextureStreamer::GetUploadBudget(void) const noexcept { return _uploadBudget; }
+size_t				TextureStreamer::GetResidentSize(void) const noexcept { return _residentSize; }
+uint64_t			TextureStreamer::GetFrameIndex(void) const noexcept { return _frameIndex; }
+
+size_t				TextureStreamer::GetPendingCount(void) const noexcept
+{
+	return std::count_if(_textures.begin(), _textures.end(), [](const StreamedTexture * texture)
+	{
+		return texture->GetState() == TextureStreamingState::Loading;
+	});
+}
+
+std::ostream &	operator<<(std::ostream & o, TextureStreamer const & r)
+{
+	o << "TextureStreamer " << r.GetResidentSize() << "/" << r.GetMemoryBudget() << " bytes resident, " << r.GetPendingCount() << " pending" << std::endl;
+	return (o);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <unordered_set>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/StreamedTexture.hpp"
+#include "Core/Textures/Texture2D.hpp"
+#include "Core/Textures/ImageData.hpp"
+#include "Core/Vulkan/StagingRing.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Asynchronous texture loading: files are decoded (and mipped) on a thread pool, then uploaded in batches
+	// through a staging ring during Update. The resident GPU memory is kept under a budget by moving the
+	// high mips of the least recently used textures to host memory, they are copied back when the texture is used again.
+	class		TextureStreamer
+	{
+		private:
+			struct	DecodedTexture
+			{
+				StreamedTexture *	texture;
+				uint64_t			requestId;
+				ImageData			image;
+				std::string			error;
+			};
+
+			// Image or evicted mip buffer, destroyed once the frames in flight and the staging batch are done with it
+			struct	ReleasedResource
+			{
+				VkImage			image;
+				VkImageView		view;
+				VkBuffer		buffer;
+				VkDeviceMemory	memory;
+				uint64_t		frameNumber;
+				uint64_t		batchId;
+			};
+
+			static const VkDeviceSize	DefaultStagingSize = 64 * 1024 * 1024;
+			static const size_t			DefaultMemoryBudget = 512 * 1024 * 1024;
+			static const size_t			DefaultUploadBudget = 32 * 1024 * 1024;
+
+			VkDevice										_device;
+			std::vector< std::future< void > >				_decodes;	// Jobs on the shared thread pool
+			StagingRing										_stagingRing;
+			Texture2D *										_placeholder;
+			std::unordered_set< StreamedTexture * >			_textures;
+			std::mutex										_decodedMutex;
+			std::deque< std::shared_ptr< DecodedTexture > >	_decodedTextures;
+			std::deque< ReleasedResource >					_releasedResources;
+			std::unordered_set< const Texture * >			_changedTextures;
+			uint64_t										_frameIndex;
+			uint64_t										_nextRequestId;
+			size_t											_memoryBudget;
+			size_t											_uploadBudget;
+			size_t											_residentSize;
+
+			void		Initialize(void);
+			void		RequestDecode(StreamedTexture * texture);
+			void		WaitDecodes(void);
+			void		UploadDecodedTextures(void);
+			bool		Upload(StreamedTexture * texture, const ImageData & image);
+			void		EnforceMemoryBudget(void);
+			void		DropHighMips(StreamedTexture * texture, int count);
+			void		RestoreEvictedMips(void);
+			void		RestoreEvictedMips(StreamedTexture * texture);
+			void		ReleaseImage(VkImage image, VkDeviceMemory memory, VkImageView view);
+			void		ReleaseEvictedLevels(StreamedTexture * texture);
+			void		ReleaseResource(VkImage image, VkImageView view, VkBuffer buffer, VkDeviceMemory memory);
+			void		DestroyReleasedResources(bool force = false) noexcept;
+			void		SwapImage(StreamedTexture * texture, VkImage image, VkDeviceMemory memory, VkImageView view, int firstMip, int levelCount);
+
+			static ImageData	DecodeFile(const std::string & fileName, VkFormat format);
+
+		public:
+			TextureStreamer(void);
+			TextureStreamer(const TextureStreamer &) = delete;
+			virtual ~TextureStreamer(void);
+
+			TextureStreamer &	operator=(TextureStreamer const & src) = delete;
+
+			// Returns immediately, the texture is bound to a placeholder until it's loaded
+			StreamedTexture *	Load(const std::string & fileName, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM, int usage = VK_IMAGE_USAGE_SAMPLED_BIT);
+
+			// Called once per frame on the main thread, before rendering
+			void				Update(void);
+			// Block until all the requested textures are resident
+			void				Flush(void);
+
+			void				Unregister(StreamedTexture * texture) noexcept;
+
+			void				SetMemoryBudget(size_t bytes) noexcept;
+			size_t				GetMemoryBudget(void) const noexcept;
+			// Maximum amount of texture data uploaded per frame
+			void				SetUploadBudget(size_t bytes) noexcept;
+			size_t				GetUploadBudget(void) const noexcept;
+			size_t				GetResidentSize(void) const noexcept;
+			size_t				GetPendingCount(void) const noexcept;
+			uint64_t			GetFrameIndex(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, TextureStreamer const & r);
+}
@@ -0,0 +1,333 @@
+#include "VirtualTexture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#include "Core/Application.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/Vulkan/Vk.hpp"
+
+using namespace LWGC;
+
+static void		CacheBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+{
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	// The physical cache stays in general layout so tiles can be written while other tiles are sampled
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+static void		BufferBarrier(VkCommandBuffer cmd, VkBuffer buffer, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+{
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+VirtualTexture::VirtualTexture(const std::string & path, uint32_t cacheWidthInTiles, uint32_t cacheHeightInTiles) :
+	_device(VulkanInstance::Get()->GetDevice()), _physicalCache(nullptr), _feedbackData(nullptr), _feedbackSegmentCount(0),
+	_maxPendingLoads(DefaultMaxPendingLoads), _maxUploadsPerFrame(DefaultMaxUploadsPerFrame)
+{
+	_file.Open(path);
+
+	const auto &	layout = _file.GetLayout();
+	size_t			padded = static_cast< size_t >(layout.GetPaddedTileSize());
+
+	_pageManager = std::make_unique< VirtualTexturePageManager >(layout, cacheWidthInTiles, cacheHeightInTiles);
+	_physicalCache = Texture2D::Create(cacheWidthInTiles * padded, cacheHeightInTiles * padded, VK_FORMAT_R8G8B8A8_UNORM,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, false);
+
+	std::memset(&_info, 0, sizeof(_info));
+	_info.size = glm::vec4(layout.GetWidth(), layout.GetHeight(), 1.0f / layout.GetWidth(), 1.0f / layout.GetHeight());
+	_info.tileInfo = glm::vec4(layout.GetTileSize(), layout.GetBorder(), padded, layout.GetMipCount());
+	_info.cacheInfo = glm::vec4(cacheWidthInTiles, cacheHeightInTiles, 1.0f / (cacheWidthInTiles * padded), 1.0f / (cacheHeightInTiles * padded));
+	_info.feedbackInfo = glm::uvec4(layout.GetFeedbackWordCount(), DefaultFeedbackSampleRate, layout.GetPageCount(), 0);
+	for (int mip = 0; mip < layout.GetMipCount(); mip++)
+		_info.mipOffsets[mip / 4][mip % 4] = layout.GetMipOffset(mip);
+
+	// Tile reads are mostly page faults in the mapped file, a couple of threads are enough
+	_threadPool = std::make_unique< ThreadPool >(2);
+	_stagingRing.Initialize(DefaultStagingSize);
+
+	CreateBuffers();
+
+	_updateIndex = Application::update.AddListener(std::bind(&VirtualTexture::Update, this));
+	_beginFrameIndex = RenderPipelineManager::beginFrameRendering.AddListener(std::bind(&VirtualTexture::ReadFeedback, this));
+}
+
+VirtualTexture::~VirtualTexture(void)
+{
+	Application::update.RemoveListener(_updateIndex);
+	RenderPipelineManager::beginFrameRendering.RemoveListener(_beginFrameIndex);
+
+	// Join the loading threads first, they push into _loadedTiles
+	_threadPool.reset();
+	_stagingRing.Release();
+	vkDeviceWaitIdle(_device);
+
+	vkUnmapMemory(_device, _feedbackMemory);
+	vkDestroyBuffer(_device, _feedbackBuffer, nullptr);
+	vkFreeMemory(_device, _feedbackMemory, nullptr);
+	vkDestroyBuffer(_device, _pageTableBuffer, nullptr);
+	vkFreeMemory(_device, _pageTableMemory, nullptr);
+	for (auto & info : _infoBuffers)
+	{
+		vkDestroyBuffer(_device, info.buffer, nullptr);
+		vkFreeMemory(_device, info.memory, nullptr);
+	}
+}
+
+void				VirtualTexture::CreateBuffers(void)
+{
+	const auto &	layout = _file.GetLayout();
+	VkDeviceSize	pageTableSize = layout.GetPageCount() * sizeof(uint32_t);
+
+	Vk::CreateBuffer(
+		pageTableSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		_pageTableBuffer,
+		_pageTableMemory
+	);
+
+	// One feedback segment per frame in flight, the shaders write the one given in the vtInfo of the frame
+	auto pipeline = RenderPipelineManager::currentRenderPipeline;
+	_feedbackSegmentCount = (pipeline != nullptr) ? pipeline->GetFramesInFlight() : RenderPipeline::DefaultFramesInFlight;
+	VkDeviceSize feedbackSize = _feedbackSegmentCount * layout.GetFeedbackWordCount() * sizeof(uint32_t);
+	Vk::CreateBuffer(
+		feedbackSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		_feedbackBuffer,
+		_feedbackMemory
+	);
+	Vk::CheckResult(vkMapMemory(_device, _feedbackMemory, 0, feedbackSize, 0, reinterpret_cast< void ** >(&_feedbackData)), "Can't map virtual texture feedback");
+	std::memset(_feedbackData, 0, feedbackSize);
+
+	_infoBuffers.resize(_feedbackSegmentCount);
+	for (size_t i = 0; i < _feedbackSegmentCount; i++)
+	{
+		Vk::CreateBuffer(
+			sizeof(VirtualTextureInfo),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			_infoBuffers[i].buffer,
+			_infoBuffers[i].memory
+		);
+		_info.feedbackInfo.w = static_cast< uint32_t >(i);
+		Vk::UploadToMemory(_infoBuffers[i].memory, &_info, sizeof(_info));
+
+		_descriptorSets.push_back(std::make_unique< DescriptorSet >());
+		_descriptorSets[i]->AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, _infoBuffers[i].buffer, sizeof(VirtualTextureInfo));
+		_descriptorSets[i]->AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _pageTableBuffer, pageTableSize);
+		_descriptorSets[i]->AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _feedbackBuffer, feedbackSize);
+		_descriptorSets[i]->AddBinding(3, _physicalCache, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	// Every entry of the page table is dirty at creation, the whole table is uploaded in the first Update
+	VkCommandBuffer cmd = _stagingRing.GetCommandBuffer();
+	vkCmdFillBuffer(cmd, _pageTableBuffer, 0, pageTableSize, 0);
+	BufferBarrier(cmd, _pageTableBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+void				VirtualTexture::Update(void)
+{
+	_stagingRing.Retire();
+
+	RequestTiles();
+
+	VkCommandBuffer cmd = _stagingRing.GetCommandBuffer();
+	UploadTiles(cmd);
+	UploadPageTable(cmd);
+
+	if (_stagingRing.HasPendingCommands())
+		_stagingRing.Submit();
+}
+
+void				VirtualTexture::ReadFeedback(void)
+{
+	auto	pipeline = RenderPipelineManager::currentRenderPipeline;
+	size_t	wordCount = _file.GetLayout().GetFeedbackWordCount();
+
+	if (pipeline == nullptr || pipeline->GetCurrentFrameIndex() >= _feedbackSegmentCount)
+		return ;
+
+	// The fence of the frame slot was just waited, so the GPU is done writing its segment and reading its info
+	size_t		slot = pipeline->GetCurrentFrameIndex();
+	uint32_t *	segment = _feedbackData + slot * wordCount;
+	_pageManager->ProcessFeedback(segment, wordCount);
+	std::memset(segment, 0, wordCount * sizeof(uint32_t));
+
+	_info.feedbackInfo.w = static_cast< uint32_t >(slot);
+	Vk::UploadToMemory(_infoBuffers[slot].memory, &_info, sizeof(_info));
+}
+
+void				VirtualTexture::RequestTiles(void)
+{
+	size_t loading = _pageManager->GetLoadingCount();
+
+	if (loading >= _maxPendingLoads)
+		return ;
+
+	for (uint32_t pageIndex : _pageManager->PopRequests(_maxPendingLoads - loading))
+	{
+		_threadPool->Enqueue([this, pageIndex]()
+		{
+			auto	tile = std::make_shared< LoadedTile >();
+			auto	data = _file.GetTile(pageIndex);
+
+			tile->pageIndex = pageIndex;
+			tile->data.assign(data, data + _file.GetHeader().tileByteSize);
+
+			std::lock_guard< std::mutex > lock(_loadedMutex);
+			_loadedTiles.push_back(tile);
+		});
+	}
+}
+
+void				VirtualTexture::UploadTiles(VkCommandBuffer cmd)
+{
+	std::vector< std::shared_ptr< LoadedTile > >	tiles;
+	uint32_t										padded = static_cast< uint32_t >(_file.GetLayout().GetPaddedTileSize());
+	VkDeviceSize									tileByteSize = _file.GetHeader().tileByteSize;
+
+	{
+		std::lock_guard< std::mutex > lock(_loadedMutex);
+		while (!_loadedTiles.empty() && tiles.size() < _maxUploadsPerFrame)
+		{
+			tiles.push_back(_loadedTiles.front());
+			_loadedTiles.pop_front();
+		}
+	}
+
+	if (tiles.empty())
+		return ;
+
+	CacheBarrier(cmd, _physicalCache->GetImage(), VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		VkDeviceSize	offset;
+		uint8_t *		data;
+
+		if (!_stagingRing.Allocate(tileByteSize, 16, offset, data))
+		{
+			// Ring full: put the remaining tiles back, they are uploaded in the next frames
+			std::lock_guard< std::mutex > lock(_loadedMutex);
+			_loadedTiles.insert(_loadedTiles.begin(), tiles.begin() + i, tiles.end());
+			break ;
+		}
+
+		uint32_t slot = _pageManager->MapPage(tiles[i]->pageIndex);
+
+		// All the slots are used by pages visible this frame, the page is requested again by the next feedback
+		if (slot == VirtualTexturePageManager::InvalidSlot)
+		{
+			_pageManager->CancelRequest(tiles[i]->pageIndex);
+			continue ;
+		}
+
+		std::memcpy(data, tiles[i]->data.data(), tileByteSize);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = {static_cast< int32_t >(_pageManager->GetSlotX(slot) * padded), static_cast< int32_t >(_pageManager->GetSlotY(slot) * padded), 0};
+		region.imageExtent = {padded, padded, 1};
+
+		vkCmdCopyBufferToImage(cmd, _stagingRing.GetBuffer(), _physicalCache->GetImage(), VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+	}
+
+	CacheBarrier(cmd, _physicalCache->GetImage(), VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void				VirtualTexture::UploadPageTable(VkCommandBuffer cmd)
+{
+	const auto &					pageTable = _pageManager->GetPageTable();
+	std::vector< VkBufferCopy >		regions;
+
+	for (const auto & range : _pageManager->PopDirtyRanges())
+	{
+		VkDeviceSize	size = range.count * sizeof(uint32_t);
+		VkDeviceSize	offset;
+		uint8_t *		data;
+
+		// The page table is small compared to the ring, fall back on a dedicated buffer if it's full anyway
+		if (_stagingRing.Allocate(size, sizeof(uint32_t), offset, data))
+		{
+			std::memcpy(data, pageTable.data() + range.first, size);
+			regions.push_back({offset, range.first * sizeof(uint32_t), size});
+		}
+		else
+		{
+			VkBuffer buffer = _stagingRing.AllocateDedicated(size, data);
+			VkBufferCopy region = {0, range.first * sizeof(uint32_t), size};
+
+			std::memcpy(data, pageTable.data() + range.first, size);
+			vkCmdCopyBuffer(cmd, buffer, _pageTableBuffer, 1, &region);
+		}
+	}
+
+	if (!regions.empty())
+		vkCmdCopyBuffer(cmd, _stagingRing.GetBuffer(), _pageTableBuffer, static_cast< uint32_t >(regions.size()), regions.data());
+
+	BufferBarrier(cmd, _pageTableBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void				VirtualTexture::Bind(RenderPass & pass)
+{
+	pass.BindDescriptorSet("vtInfo", GetDescriptorSet());
+}
+
+VkDescriptorSet		VirtualTexture::GetDescriptorSet(void)
+{
+	auto	pipeline = RenderPipelineManager::currentRenderPipeline;
+	size_t	slot = (pipeline != nullptr) ? pipeline->GetCurrentFrameIndex() : 0;
+
+	return _descriptorSets[std::min(slot, _descriptorSets.size() - 1)]->GetDescriptorSet();
+}
+
+void				VirtualTexture::SetMaxPendingLoads(size_t count) noexcept { _maxPendingLoads = std::max< size_t >(count, 1); }
+void				VirtualTexture::SetMaxUploadsPerFrame(size_t count) noexcept { _maxUploadsPerFrame = std::max< size_t >(count, 1); }
+
+void				VirtualTexture::SetFeedbackSampleRate(uint32_t rate)
+{
+	// Uploaded with the info of each frame slot once the GPU is done with it
+	_info.feedbackInfo.y = std::max(rate, 1u);
+}
+
+const VirtualTextureFile &			VirtualTexture::GetFile(void) const noexcept { return _file; }
+const VirtualTexturePageManager &	VirtualTexture::GetPageManager(void) const noexcept { return *_pageManager; }
+Texture2D *							VirtualTexture::GetPhysicalCache(void) const noexcept { return _physicalCache; }
+
+std::ostream &	operator<<(std::ostream & o, VirtualTexture const & r)
+{
+	o << "VirtualTexture: " << r.GetFile().GetLayout().GetWidth() << "x" << r.GetFile().GetLayout().GetHeight()
+		<< ", resident pages: " << r.GetPageManager().GetResidentCount() << "/" << r.GetPageManager().GetSlotCount() << std::endl;
+	return o;
+}
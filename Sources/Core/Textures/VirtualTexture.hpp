@@ -0,0 +1,110 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/VirtualTextureFile.hpp"
+#include "Core/Textures/VirtualTexturePageManager.hpp"
+#include "Core/Textures/Texture2D.hpp"
+#include "Core/Vulkan/StagingRing.hpp"
+#include "Core/Vulkan/UniformBuffer.hpp"
+#include "Core/Vulkan/Material.hpp"
+#include "Core/Vulkan/RenderPass.hpp"
+#include "Core/Vulkan/DescriptorSet.hpp"
+#include "Core/Delegate.tpp"
+#include "Utils/ThreadPool.hpp"
+
+#include GLM_INCLUDE
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Matches VirtualTextureInfo in Shaders/Common/VirtualTexture.hlsl
+	struct	VirtualTextureInfo
+	{
+		glm::vec4	size;			// xy: virtual size in pixels, zw: 1 / size
+		glm::vec4	tileInfo;		// x: tile size, y: border, z: padded tile size, w: mip count
+		glm::vec4	cacheInfo;		// xy: physical cache size in tiles, zw: 1 / physical cache size in pixels
+		glm::uvec4	feedbackInfo;	// x: words per feedback segment, y: feedback sample rate, z: page count, w: feedback segment of this frame
+		glm::uvec4	mipOffsets[VirtualTextureLayout::MaxMipCount / 4];
+	};
+
+	// GPU side of a virtual texture: a physical cache texture holding the resident tiles, the page table and the
+	// feedback buffers. Shaders sample it with SampleVirtualTexture and write the pages they need in the feedback
+	// buffer, tiles are read from the memory mapped file on a thread pool and uploaded in Update.
+	class		VirtualTexture
+	{
+		private:
+			struct	LoadedTile
+			{
+				uint32_t				pageIndex;
+				std::vector< uint8_t >	data;
+			};
+
+			static const VkDeviceSize	DefaultStagingSize = 16 * 1024 * 1024;
+			static const size_t			DefaultMaxPendingLoads = 64;
+			static const size_t			DefaultMaxUploadsPerFrame = 16;
+			static const uint32_t		DefaultFeedbackSampleRate = 4;
+
+			VkDevice										_device;
+			VirtualTextureFile								_file;
+			std::unique_ptr< VirtualTexturePageManager >	_pageManager;
+			Texture2D *										_physicalCache;
+			VkBuffer										_pageTableBuffer;
+			VkDeviceMemory									_pageTableMemory;
+			VkBuffer										_feedbackBuffer;
+			VkDeviceMemory									_feedbackMemory;
+			uint32_t *										_feedbackData;
+			size_t											_feedbackSegmentCount;
+			// vtInfo and descriptor set per frame in flight, the info tells the shaders which feedback segment to write
+			std::vector< UniformBuffer >					_infoBuffers;
+			std::vector< std::unique_ptr< DescriptorSet > >	_descriptorSets;
+			VirtualTextureInfo								_info;
+			StagingRing										_stagingRing;
+			std::unique_ptr< ThreadPool >					_threadPool;
+			std::mutex										_loadedMutex;
+			std::deque< std::shared_ptr< LoadedTile > >		_loadedTiles;
+			DelegateIndex< void(void) >						_updateIndex;
+			DelegateIndex< void(void) >						_beginFrameIndex;
+			size_t											_maxPendingLoads;
+			size_t											_maxUploadsPerFrame;
+
+			void		CreateBuffers(void);
+			void		RequestTiles(void);
+			void		UploadTiles(VkCommandBuffer cmd);
+			void		UploadPageTable(VkCommandBuffer cmd);
+
+		public:
+			VirtualTexture(const std::string & path, uint32_t cacheWidthInTiles = 32, uint32_t cacheHeightInTiles = 32);
+			VirtualTexture(const VirtualTexture &) = delete;
+			virtual ~VirtualTexture(void);
+
+			VirtualTexture &	operator=(VirtualTexture const & src) = delete;
+
+			// Called automatically once per frame, before rendering
+			void		Update(void);
+			// Called automatically once the render pipeline waited for the frame slot about to be recorded
+			void		ReadFeedback(void);
+
+			// Bind the vtInfo, vtPageTable, vtFeedback and vtPhysicalCache resources of the current frame in flight,
+			// for the materials drawn after in the pass
+			void		Bind(RenderPass & pass);
+			VkDescriptorSet	GetDescriptorSet(void);
+
+			void		SetMaxPendingLoads(size_t count) noexcept;
+			void		SetMaxUploadsPerFrame(size_t count) noexcept;
+			// 1 pixel out of rate * rate writes the feedback, the pattern changes every frame
+			void		SetFeedbackSampleRate(uint32_t rate);
+
+			const VirtualTextureFile &			GetFile(void) const noexcept;
+			const VirtualTexturePageManager &	GetPageManager(void) const noexcept;
+			Texture2D *							GetPhysicalCache(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, VirtualTexture const & r);
+}
@@ -0,0 +1,126 @@
+#include "VirtualTextureFeedbackSimulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace LWGC;
+
+VirtualTextureFeedbackSimulator::VirtualTextureFeedbackSimulator(const VirtualTextureLayout & layout)
+	: _layout(layout), _feedback(layout.GetFeedbackWordCount(), 0)
+{
+}
+
+void		VirtualTextureFeedbackSimulator::Clear(void) noexcept
+{
+	std::fill(_feedback.begin(), _feedback.end(), 0);
+}
+
+int			VirtualTextureFeedbackSimulator::ComputeMip(glm::vec2 uvDx, glm::vec2 uvDy) const noexcept
+{
+	glm::vec2	size(_layout.GetWidth(), _layout.GetHeight());
+	glm::vec2	dx = uvDx * size;
+	glm::vec2	dy = uvDy * size;
+	float		maxLength = std::max(dx.x * dx.x + dx.y * dx.y, dy.x * dy.x + dy.y * dy.y);
+
+	// Same as the shader: 0.5 * log2 of the squared footprint
+	float mip = (maxLength > 0) ? 0.5f * std::log2(maxLength) : 0;
+
+	return std::min(std::max(static_cast< int >(mip), 0), _layout.GetMipCount() - 1);
+}
+
+void		VirtualTextureFeedbackSimulator::Sample(glm::vec2 uv, int mip) noexcept
+{
+	uint32_t	pagesX = _layout.GetPagesX(mip);
+	uint32_t	pagesY = _layout.GetPagesY(mip);
+	float		u = std::min(std::max(uv.x, 0.0f), 1.0f);
+	float		v = std::min(std::max(uv.y, 0.0f), 1.0f);
+	// Pages are computed from the mip pixel position, the last page of a mip can be partially covered
+	uint32_t	x = std::min(static_cast< uint32_t >(u * _layout.GetMipWidth(mip)) / _layout.GetTileSize(), pagesX - 1);
+	uint32_t	y = std::min(static_cast< uint32_t >(v * _layout.GetMipHeight(mip)) / _layout.GetTileSize(), pagesY - 1);
+	uint32_t	page = _layout.GetPageIndex(mip, x, y);
+
+	_feedback[page / 32] |= 1u << (page % 32);
+}
+
+void		VirtualTextureFeedbackSimulator::Sample(glm::vec2 uv, glm::vec2 uvDx, glm::vec2 uvDy) noexcept
+{
+	Sample(uv, ComputeMip(uvDx, uvDy));
+}
+
+void		VirtualTextureFeedbackSimulator::SimulateView(glm::vec2 uvMin, glm::vec2 uvMax, int viewportWidth, int viewportHeight, int sampleRate) noexcept
+{
+	glm::vec2	uvDx((uvMax.x - uvMin.x) / viewportWidth, 0);
+	glm::vec2	uvDy(0, (uvMax.y - uvMin.y) / viewportHeight);
+	int			mip = ComputeMip(uvDx, uvDy);
+
+	for (int y = 0; y < viewportHeight; y += sampleRate)
+		for (int x = 0; x < viewportWidth; x += sampleRate)
+		{
+			glm::vec2 uv(uvMin.x + (x + 0.5f) * uvDx.x, uvMin.y + (y + 0.5f) * uvDy.y);
+
+			if (uv.x >= 0 && uv.x <= 1 && uv.y >= 0 && uv.y <= 1)
+				Sample(uv, mip);
+		}
+}
+
+// Intersect the ray of a pixel with the plane y = 0, returns false if it's above the horizon
+static bool	PixelToPlane(const glm::mat4 & inverseViewProjection, float ndcX, float ndcY, glm::vec2 planeSize, glm::vec2 & uv)
+{
+	glm::vec4	nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 0, 1);
+	glm::vec4	farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1, 1);
+	glm::vec3	origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3	direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+	if (std::abs(direction.y) < 1e-6f)
+		return false;
+
+	float t = -origin.y / direction.y;
+	if (t < 0)
+		return false;
+
+	uv = glm::vec2((origin.x + direction.x * t) / planeSize.x, (origin.z + direction.z * t) / planeSize.y);
+	return true;
+}
+
+void		VirtualTextureFeedbackSimulator::SimulatePlane(const glm::mat4 & inverseViewProjection, glm::vec2 planeSize, int viewportWidth, int viewportHeight, int sampleRate) noexcept
+{
+	float	pixelWidth = 2.0f / viewportWidth;
+	float	pixelHeight = 2.0f / viewportHeight;
+
+	for (int y = 0; y < viewportHeight; y += sampleRate)
+		for (int x = 0; x < viewportWidth; x += sampleRate)
+		{
+			glm::vec2	uv, uvRight, uvDown;
+			float		ndcX = (x + 0.5f) * pixelWidth - 1;
+			float		ndcY = (y + 0.5f) * pixelHeight - 1;
+
+			// Derivatives are the difference with the neighbour pixels, like ddx / ddy
+			if (!PixelToPlane(inverseViewProjection, ndcX, ndcY, planeSize, uv)
+				|| !PixelToPlane(inverseViewProjection, ndcX + pixelWidth, ndcY, planeSize, uvRight)
+				|| !PixelToPlane(inverseViewProjection, ndcX, ndcY + pixelHeight, planeSize, uvDown))
+				continue ;
+
+			if (uv.x < 0 || uv.x > 1 || uv.y < 0 || uv.y > 1)
+				continue ;
+
+			Sample(uv, uvRight - uv, uvDown - uv);
+		}
+}
+
+size_t		VirtualTextureFeedbackSimulator::GetRequestedPageCount(void) const noexcept
+{
+	size_t	count = 0;
+
+	for (auto word : _feedback)
+		count += __builtin_popcount(word);
+
+	return count;
+}
+
+const std::vector< uint32_t > &	VirtualTextureFeedbackSimulator::GetFeedback(void) const noexcept { return _feedback; }
+
+std::ostream &	operator<<(std::ostream & o, VirtualTextureFeedbackSimulator const & r)
+{
+	o << "VirtualTextureFeedbackSimulator " << r.GetRequestedPageCount() << " pages requested" << std::endl;
+	return (o);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "IncludeDeps.hpp"
+#include "Core/Textures/VirtualTextureLayout.hpp"
+
+#include GLM_INCLUDE
+
+namespace LWGC
+{
+	// Generates on the CPU the feedback the VirtualTexture.hlsl shader would write, to drive and test the page
+	// manager without a GPU: same mip selection (from the uv derivatives) and same page bitfield layout.
+	class		VirtualTextureFeedbackSimulator
+	{
+		private:
+			VirtualTextureLayout	_layout;
+			std::vector< uint32_t >	_feedback;
+
+		public:
+			VirtualTextureFeedbackSimulator(const VirtualTextureLayout & layout);
+			VirtualTextureFeedbackSimulator(const VirtualTextureFeedbackSimulator &) = delete;
+			virtual ~VirtualTextureFeedbackSimulator(void) = default;
+
+			VirtualTextureFeedbackSimulator &	operator=(VirtualTextureFeedbackSimulator const & src) = delete;
+
+			void		Clear(void) noexcept;
+
+			// Request the page containing uv at the given mip
+			void		Sample(glm::vec2 uv, int mip) noexcept;
+			// Request the page like a pixel with these uv derivatives (ddx, ddy) would
+			void		Sample(glm::vec2 uv, glm::vec2 uvDx, glm::vec2 uvDy) noexcept;
+
+			// Orthographic view of the uv rectangle on a viewport, one sample every sampleRate pixels
+			void		SimulateView(glm::vec2 uvMin, glm::vec2 uvMax, int viewportWidth, int viewportHeight, int sampleRate = 1) noexcept;
+			// Perspective view of the plane y = 0, textured from (0, 0) to planeSize on xz
+			void		SimulatePlane(const glm::mat4 & inverseViewProjection, glm::vec2 planeSize, int viewportWidth, int viewportHeight, int sampleRate = 1) noexcept;
+
+			int			ComputeMip(glm::vec2 uvDx, glm::vec2 uvDy) const noexcept;
+			size_t		GetRequestedPageCount(void) const noexcept;
+			const std::vector< uint32_t > &	GetFeedback(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, VirtualTextureFeedbackSimulator const & r);
+}
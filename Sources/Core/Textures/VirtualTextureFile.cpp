@@ -0,0 +1,152 @@
+#include "VirtualTextureFile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "Core/Textures/BCEncoder.hpp"
+#include "IncludeDeps.hpp"
+
+#include STB_INCLUDE_IMAGE
+
+using namespace LWGC;
+
+const std::string	VirtualTextureFile::Extension = ".lwgcvt";
+
+static const size_t	TileDataAlignment = 4096;
+
+VirtualTextureFile::VirtualTextureFile(void) : _header(), _pageOffsets(nullptr)
+{
+}
+
+void							VirtualTextureFile::Open(const std::string & path)
+{
+	if (!_file.Open(path))
+		throw std::runtime_error("Failed to open virtual texture file: " + path);
+
+	if (_file.GetSize() < sizeof(Header))
+		throw std::runtime_error("Invalid virtual texture file: " + path);
+
+	std::memcpy(&_header, _file.GetData(), sizeof(Header));
+
+	if (_header.magic != Magic || _header.version != Version || _header.format != FormatRGBA8)
+		throw std::runtime_error("Unsupported virtual texture file: " + path);
+
+	_layout = VirtualTextureLayout(_header.width, _header.height, _header.tileSize, _header.border);
+
+	size_t paddedTile = _layout.GetPaddedTileSize();
+	if (_layout.GetPageCount() != _header.pageCount || _header.tileByteSize != paddedTile * paddedTile * BytesPerPixel
+		|| sizeof(Header) + _header.pageCount * sizeof(uint64_t) > _file.GetSize())
+		throw std::runtime_error("Corrupted virtual texture file: " + path);
+
+	_pageOffsets = reinterpret_cast< const uint64_t * >(_file.GetData() + sizeof(Header));
+
+	for (uint64_t i = 0; i < _header.pageCount; i++)
+		if (_pageOffsets[i] + _header.tileByteSize > _file.GetSize())
+			throw std::runtime_error("Truncated virtual texture file: " + path);
+}
+
+bool							VirtualTextureFile::IsOpen(void) const noexcept { return _file.IsOpen(); }
+
+const uint8_t *					VirtualTextureFile::GetTile(uint32_t pageIndex) const
+{
+	if (pageIndex >= _header.pageCount)
+		throw std::out_of_range("Virtual texture page out of range: " + std::to_string(pageIndex));
+
+	return _file.GetData() + _pageOffsets[pageIndex];
+}
+
+const VirtualTextureLayout &	VirtualTextureFile::GetLayout(void) const noexcept { return _layout; }
+const VirtualTextureFile::Header &	VirtualTextureFile::GetHeader(void) const noexcept { return _header; }
+
+void							VirtualTextureFile::Build(const uint8_t * rgba, int width, int height, const std::string & path, int tileSize, int border)
+{
+	VirtualTextureLayout	layout(width, height, tileSize, border);
+	Header					header = {};
+	int						paddedTile = layout.GetPaddedTileSize();
+	std::vector< uint8_t >	tile(paddedTile * paddedTile * BytesPerPixel);
+	std::vector< uint8_t >	mip(rgba, rgba + static_cast< size_t >(width) * height * BytesPerPixel);
+	std::vector< uint64_t >	offsets(layout.GetPageCount());
+	std::string				tmpPath = path + ".tmp" + std::to_string(getpid());
+
+	header.magic = Magic;
+	header.version = Version;
+	header.width = width;
+	header.height = height;
+	header.tileSize = tileSize;
+	header.border = border;
+	header.mipCount = layout.GetMipCount();
+	header.format = FormatRGBA8;
+	header.tileByteSize = tile.size();
+	header.pageCount = layout.GetPageCount();
+
+	uint64_t dataOffset = (sizeof(Header) + offsets.size() * sizeof(uint64_t) + TileDataAlignment - 1) / TileDataAlignment * TileDataAlignment;
+	for (size_t i = 0; i < offsets.size(); i++)
+		offsets[i] = dataOffset + i * header.tileByteSize;
+
+	std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("Can't write virtual texture file: " + tmpPath);
+
+	file.write(reinterpret_cast< const char * >(&header), sizeof(header));
+	file.write(reinterpret_cast< const char * >(offsets.data()), offsets.size() * sizeof(uint64_t));
+	file.seekp(dataOffset);
+
+	for (int m = 0; m < layout.GetMipCount(); m++)
+	{
+		int mipWidth = layout.GetMipWidth(m);
+		int mipHeight = layout.GetMipHeight(m);
+
+		if (m > 0)
+			mip = BCEncoder::Downsample(mip.data(), layout.GetMipWidth(m - 1), layout.GetMipHeight(m - 1));
+
+		for (uint32_t py = 0; py < layout.GetPagesY(m); py++)
+			for (uint32_t px = 0; px < layout.GetPagesX(m); px++)
+			{
+				// Borders and the parts outside of the mip are clamped to the edge
+				for (int y = 0; y < paddedTile; y++)
+				{
+					int sy = std::min(std::max(static_cast< int >(py) * tileSize + y - border, 0), mipHeight - 1);
+					for (int x = 0; x < paddedTile; x++)
+					{
+						int sx = std::min(std::max(static_cast< int >(px) * tileSize + x - border, 0), mipWidth - 1);
+						std::memcpy(&tile[(y * paddedTile + x) * BytesPerPixel], &mip[(static_cast< size_t >(sy) * mipWidth + sx) * BytesPerPixel], BytesPerPixel);
+					}
+				}
+				file.write(reinterpret_cast< const char * >(tile.data()), tile.size());
+			}
+	}
+
+	file.close();
+	if (!file || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tmpPath.c_str());
+		throw std::runtime_error("Can't write virtual texture file: " + path);
+	}
+}
+
+void							VirtualTextureFile::Build(const std::string & sourcePath, const std::string & path, int tileSize, int border)
+{
+	int			width, height, channels;
+	stbi_uc *	pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (!pixels)
+		throw std::runtime_error("Failed to load texture image from file: " + sourcePath);
+
+	try {
+		Build(pixels, width, height, path, tileSize, border);
+	} catch (...) {
+		stbi_image_free(pixels);
+		throw ;
+	}
+	stbi_image_free(pixels);
+}
+
+std::ostream &	operator<<(std::ostream & o, VirtualTextureFile const & r)
+{
+	o << "VirtualTextureFile " << r.GetLayout().GetWidth() << "x" << r.GetLayout().GetHeight() << ", " << r.GetLayout().GetPageCount() << " pages" << std::endl;
+	return (o);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Core/Textures/VirtualTextureLayout.hpp"
+#include "Utils/MappedFile.hpp"
+
+namespace LWGC
+{
+	// Tiled on-disk format of a virtual texture: a header, the offset of each page (in layout order) and the tiles,
+	// each tile is tileSize + 2 * border pixels wide with the border copied from the neighbour tiles for filtering.
+	// The file is memory mapped so a tile read only touches the pages of the file it needs.
+	class		VirtualTextureFile
+	{
+		public:
+			static const uint32_t	Magic = 0x5456574C; // "LWVT"
+			static const uint32_t	Version = 1;
+			static const uint32_t	BytesPerPixel = 4;
+			static const uint32_t	FormatRGBA8 = 37; // VK_FORMAT_R8G8B8A8_UNORM
+			static const std::string	Extension;
+
+			struct	Header
+			{
+				uint32_t	magic;
+				uint32_t	version;
+				uint32_t	width;
+				uint32_t	height;
+				uint32_t	tileSize;
+				uint32_t	border;
+				uint32_t	mipCount;
+				uint32_t	format;		// VkFormat of the tiles, only R8G8B8A8 for now
+				uint64_t	tileByteSize;
+				uint64_t	pageCount;
+			};
+
+		private:
+			MappedFile				_file;
+			Header					_header;
+			VirtualTextureLayout	_layout;
+			const uint64_t *		_pageOffsets;
+
+		public:
+			VirtualTextureFile(void);
+			VirtualTextureFile(const VirtualTextureFile &) = delete;
+			virtual ~VirtualTextureFile(void) = default;
+
+			VirtualTextureFile &	operator=(VirtualTextureFile const & src) = delete;
+
+			void							Open(const std::string & path);
+			bool							IsOpen(void) const noexcept;
+			// Tile pixels with their border, tileByteSize bytes
+			const uint8_t *					GetTile(uint32_t pageIndex) const;
+			const VirtualTextureLayout &	GetLayout(void) const noexcept;
+			const Header &					GetHeader(void) const noexcept;
+
+			// Build a tiled file from RGBA8 pixels, mips are generated on the CPU
+			static void		Build(const uint8_t * rgba, int width, int height, const std::string & path, int tileSize = 128, int border = 4);
+			// Build from an image file (png, jpg, ...), only for source images that fit in memory
+			static void		Build(const std::string & sourcePath, const std::string & path, int tileSize = 128, int border = 4);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, VirtualTextureFile const & r);
+}
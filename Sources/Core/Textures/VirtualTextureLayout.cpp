@@ -0,0 +1,79 @@
+#include "VirtualTextureLayout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace LWGC;
+
+VirtualTextureLayout::VirtualTextureLayout(void) : _width(0), _height(0), _tileSize(1), _border(0), _mipCount(0), _pageCount(0)
+{
+}
+
+VirtualTextureLayout::VirtualTextureLayout(int width, int height, int tileSize, int border)
+	: _width(width), _height(height), _tileSize(tileSize), _border(border), _mipCount(0), _pageCount(0)
+{
+	if (width <= 0 || height <= 0 || tileSize <= 0 || border < 0)
+		throw std::runtime_error("Invalid virtual texture layout");
+
+	// The mip chain stops at the first mip that fits in a single page
+	for (int mip = 0; mip < MaxMipCount; mip++)
+	{
+		uint32_t pagesX = (GetMipWidth(mip) + tileSize - 1) / tileSize;
+		uint32_t pagesY = (GetMipHeight(mip) + tileSize - 1) / tileSize;
+
+		_pagesX.push_back(pagesX);
+		_pagesY.push_back(pagesY);
+		_mipOffsets.push_back(_pageCount);
+		_pageCount += pagesX * pagesY;
+		_mipCount++;
+
+		if (pagesX == 1 && pagesY == 1)
+			break ;
+	}
+}
+
+uint32_t	VirtualTextureLayout::GetPageIndex(int mip, uint32_t x, uint32_t y) const noexcept
+{
+	return _mipOffsets[mip] + y * _pagesX[mip] + x;
+}
+
+void		VirtualTextureLayout::GetPage(uint32_t pageIndex, int & mip, uint32_t & x, uint32_t & y) const noexcept
+{
+	mip = static_cast< int >(std::upper_bound(_mipOffsets.begin(), _mipOffsets.end(), pageIndex) - _mipOffsets.begin()) - 1;
+
+	uint32_t local = pageIndex - _mipOffsets[mip];
+	x = local % _pagesX[mip];
+	y = local / _pagesX[mip];
+}
+
+uint32_t	VirtualTextureLayout::GetParentPage(uint32_t pageIndex) const noexcept
+{
+	int			mip;
+	uint32_t	x, y;
+
+	GetPage(pageIndex, mip, x, y);
+	if (mip + 1 >= _mipCount)
+		return pageIndex;
+
+	return GetPageIndex(mip + 1, std::min(x / 2, _pagesX[mip + 1] - 1), std::min(y / 2, _pagesY[mip + 1] - 1));
+}
+
+int			VirtualTextureLayout::GetWidth(void) const noexcept { return _width; }
+int			VirtualTextureLayout::GetHeight(void) const noexcept { return _height; }
+int			VirtualTextureLayout::GetMipWidth(int mip) const noexcept { return std::max(_width >> mip, 1); }
+int			VirtualTextureLayout::GetMipHeight(int mip) const noexcept { return std::max(_height >> mip, 1); }
+int			VirtualTextureLayout::GetTileSize(void) const noexcept { return _tileSize; }
+int			VirtualTextureLayout::GetBorder(void) const noexcept { return _border; }
+int			VirtualTextureLayout::GetPaddedTileSize(void) const noexcept { return _tileSize + _border * 2; }
+int			VirtualTextureLayout::GetMipCount(void) const noexcept { return _mipCount; }
+uint32_t	VirtualTextureLayout::GetPageCount(void) const noexcept { return _pageCount; }
+uint32_t	VirtualTextureLayout::GetPagesX(int mip) const noexcept { return _pagesX[mip]; }
+uint32_t	VirtualTextureLayout::GetPagesY(int mip) const noexcept { return _pagesY[mip]; }
+uint32_t	VirtualTextureLayout::GetMipOffset(int mip) const noexcept { return _mipOffsets[mip]; }
+size_t		VirtualTextureLayout::GetFeedbackWordCount(void) const noexcept { return (_pageCount + 31) / 32; }
+
+std::ostream &	operator<<(std::ostream & o, VirtualTextureLayout const & r)
+{
+	o << "VirtualTextureLayout " << r.GetWidth() << "x" << r.GetHeight() << ", " << r.GetMipCount() << " mips, " << r.GetPageCount() << " pages" << std::endl;
+	return (o);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace LWGC
+{
+	// Page indexing of a virtual texture, shared by the disk format, the page manager, the feedback and the shaders:
+	// pages of all the mips are numbered linearly, mip 0 first, row major in each mip.
+	class		VirtualTextureLayout
+	{
+		private:
+			int							_width;
+			int							_height;
+			int							_tileSize;
+			int							_border;
+			int							_mipCount;
+			uint32_t					_pageCount;
+			std::vector< uint32_t >		_pagesX;
+			std::vector< uint32_t >		_pagesY;
+			std::vector< uint32_t >		_mipOffsets;
+
+		public:
+			// Max mip count, limited by the shader side mip offset table
+			static const int	MaxMipCount = 16;
+
+			VirtualTextureLayout(void);
+			VirtualTextureLayout(int width, int height, int tileSize, int border);
+			VirtualTextureLayout(const VirtualTextureLayout &) = default;
+			virtual ~VirtualTextureLayout(void) = default;
+
+			VirtualTextureLayout &	operator=(VirtualTextureLayout const & src) = default;
+
+			uint32_t	GetPageIndex(int mip, uint32_t x, uint32_t y) const noexcept;
+			void		GetPage(uint32_t pageIndex, int & mip, uint32_t & x, uint32_t & y) const noexcept;
+			// Index of the page at mip + 1 containing this page, or the page itself for the last mip
+			uint32_t	GetParentPage(uint32_t pageIndex) const noexcept;
+
+			int			GetWidth(void) const noexcept;
+			int			GetHeight(void) const noexcept;
+			int			GetMipWidth(int mip) const noexcept;
+			int			GetMipHeight(int mip) const noexcept;
+			int			GetTileSize(void) const noexcept;
+			int			GetBorder(void) const noexcept;
+			// Size of a tile with its border, in pixels
+			int			GetPaddedTileSize(void) const noexcept;
+			int			GetMipCount(void) const noexcept;
+			uint32_t	GetPageCount(void) const noexcept;
+			uint32_t	GetPagesX(int mip) const noexcept;
+			uint32_t	GetPagesY(int mip) const noexcept;
+			uint32_t	GetMipOffset(int mip) const noexcept;
+			// uint32 words of a page bitfield (feedback)
+			size_t		GetFeedbackWordCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, VirtualTextureLayout const & r);
+}
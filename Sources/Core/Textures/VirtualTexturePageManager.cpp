@@ -0,0 +1,257 @@
+#include "VirtualTexturePageManager.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace LWGC;
+
+VirtualTexturePageManager::VirtualTexturePageManager(const VirtualTextureLayout & layout, uint32_t cacheWidthInTiles, uint32_t cacheHeightInTiles)
+	: _layout(layout), _cacheWidth(cacheWidthInTiles), _cacheHeight(cacheHeightInTiles), _pageTable(layout.GetPageCount(), 0),
+	_pages(layout.GetPageCount()), _resident(layout.GetPageCount(), false), _dirtyMin(layout.GetMipCount(), UINT32_MAX),
+	_dirtyMax(layout.GetMipCount(), 0), _frameIndex(0)
+{
+	int lastMip = layout.GetMipCount() - 1;
+
+	if (cacheWidthInTiles > 4096 || cacheHeightInTiles > 4096)
+		throw std::runtime_error("Virtual texture cache is limited to 4096x4096 tiles");
+	// The last mip is always resident, it's the fallback of all the other pages
+	if (GetSlotCount() <= layout.GetPagesX(lastMip) * layout.GetPagesY(lastMip))
+		throw std::runtime_error("Virtual texture cache is too small");
+
+	for (uint32_t slot = GetSlotCount(); slot > 0; slot--)
+		_freeSlots.push_back(slot - 1);
+}
+
+void			VirtualTexturePageManager::ProcessFeedback(const uint32_t * feedback, size_t wordCount)
+{
+	int		lastMip = _layout.GetMipCount() - 1;
+
+	_frameIndex++;
+	// Requests only reflect the latest feedback, pages that are not visible anymore are not loaded
+	_requests.clear();
+
+	for (uint32_t page = _layout.GetMipOffset(lastMip); page < _layout.GetPageCount(); page++)
+		if (!_resident[page])
+			Request(page);
+
+	for (size_t word = 0; word < wordCount; word++)
+	{
+		for (uint32_t bits = feedback[word]; bits != 0; bits &= bits - 1)
+		{
+			uint32_t page = static_cast< uint32_t >(word * 32 + __builtin_ctz(bits));
+
+			if (page >= _layout.GetPageCount())
+				break ;
+
+			// Also request the missing parents so the resolution increases progressively
+			while (!_resident[page])
+			{
+				Request(page);
+
+				uint32_t parent = _layout.GetParentPage(page);
+				if (parent == page)
+					break ;
+				page = parent;
+			}
+
+			if (_resident[page])
+				Touch(page);
+		}
+	}
+}
+
+void			VirtualTexturePageManager::Request(uint32_t pageIndex)
+{
+	if (_loading.count(pageIndex) == 0)
+		_requests.insert(pageIndex);
+}
+
+void			VirtualTexturePageManager::Touch(uint32_t pageIndex)
+{
+	ResidentPage & page = _pages[pageIndex];
+
+	page.lastUsedFrame = _frameIndex;
+	if (!page.locked)
+		_lru.splice(_lru.begin(), _lru, page.lruIterator);
+}
+
+std::vector< uint32_t >	VirtualTexturePageManager::PopRequests(size_t maxCount)
+{
+	std::vector< std::pair< int, uint32_t > >	sorted;
+	std::vector< uint32_t >						pages;
+
+	for (auto page : _requests)
+	{
+		int			mip;
+		uint32_t	x, y;
+
+		_layout.GetPage(page, mip, x, y);
+		sorted.push_back({mip, page});
+	}
+
+	// Coarse mips first: they cover more pixels and are the fallback of the finer ones
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair< int, uint32_t > & a, const std::pair< int, uint32_t > & b)
+	{
+		return a.first > b.first || (a.first == b.first && a.second < b.second);
+	});
+
+	for (size_t i = 0; i < sorted.size() && i < maxCount; i++)
+	{
+		pages.push_back(sorted[i].second);
+		_requests.erase(sorted[i].second);
+		_loading.insert(sorted[i].second);
+	}
+
+	return pages;
+}
+
+uint32_t		VirtualTexturePageManager::AllocateSlot(void)
+{
+	if (!_freeSlots.empty())
+	{
+		uint32_t slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		return slot;
+	}
+
+	// Don't evict pages that were visible in the last feedback, it would thrash the cache
+	if (_lru.empty() || _pages[_lru.back()].lastUsedFrame == _frameIndex)
+		return InvalidSlot;
+
+	uint32_t victim = _lru.back();
+	uint32_t parent = _layout.GetParentPage(victim);
+	uint32_t fallback = (parent == victim) ? 0 : _pageTable[parent];
+
+	_lru.pop_back();
+	_resident[victim] = false;
+	SetEntry(victim, fallback);
+	PropagateEntry(victim, fallback);
+
+	return _pages[victim].slot;
+}
+
+uint32_t		VirtualTexturePageManager::MapPage(uint32_t pageIndex)
+{
+	int			mip;
+	uint32_t	x, y;
+
+	_loading.erase(pageIndex);
+	if (_resident[pageIndex])
+		return _pages[pageIndex].slot;
+
+	uint32_t slot = AllocateSlot();
+	if (slot == InvalidSlot)
+		return InvalidSlot;
+
+	_layout.GetPage(pageIndex, mip, x, y);
+
+	ResidentPage & page = _pages[pageIndex];
+	page.slot = slot;
+	page.lastUsedFrame = _frameIndex;
+	page.locked = (mip == _layout.GetMipCount() - 1);
+	if (!page.locked)
+	{
+		_lru.push_front(pageIndex);
+		page.lruIterator = _lru.begin();
+	}
+	_resident[pageIndex] = true;
+
+	uint32_t entry = PackEntry(GetSlotX(slot), GetSlotY(slot), mip);
+	SetEntry(pageIndex, entry);
+	PropagateEntry(pageIndex, entry);
+
+	return slot;
+}
+
+void			VirtualTexturePageManager::CancelRequest(uint32_t pageIndex)
+{
+	_loading.erase(pageIndex);
+}
+
+void			VirtualTexturePageManager::SetEntry(uint32_t pageIndex, uint32_t entry)
+{
+	int			mip;
+	uint32_t	x, y;
+
+	if (_pageTable[pageIndex] == entry)
+		return ;
+
+	_pageTable[pageIndex] = entry;
+	_layout.GetPage(pageIndex, mip, x, y);
+	_dirtyMin[mip] = std::min(_dirtyMin[mip], pageIndex);
+	_dirtyMax[mip] = std::max(_dirtyMax[mip], pageIndex);
+}
+
+void			VirtualTexturePageManager::PropagateEntry(uint32_t pageIndex, uint32_t entry)
+{
+	int			mip;
+	uint32_t	x, y;
+
+	_layout.GetPage(pageIndex, mip, x, y);
+	if (mip == 0)
+		return ;
+
+	// Non resident pages of the finer mips sample the nearest resident ancestor
+	int			childMip = mip - 1;
+	uint32_t	lastX = (x == _layout.GetPagesX(mip) - 1) ? _layout.GetPagesX(childMip) - 1 : std::min(x * 2 + 1, _layout.GetPagesX(childMip) - 1);
+	uint32_t	lastY = (y == _layout.GetPagesY(mip) - 1) ? _layout.GetPagesY(childMip) - 1 : std::min(y * 2 + 1, _layout.GetPagesY(childMip) - 1);
+
+	for (uint32_t cy = y * 2; cy <= lastY; cy++)
+		for (uint32_t cx = x * 2; cx <= lastX; cx++)
+		{
+			uint32_t child = _layout.GetPageIndex(childMip, cx, cy);
+
+			if (_resident[child])
+				continue ;
+			SetEntry(child, entry);
+			PropagateEntry(child, entry);
+		}
+}
+
+std::vector< VirtualTexturePageManager::DirtyRange >	VirtualTexturePageManager::PopDirtyRanges(void)
+{
+	std::vector< DirtyRange >	ranges;
+
+	for (size_t mip = 0; mip < _dirtyMin.size(); mip++)
+	{
+		if (_dirtyMin[mip] > _dirtyMax[mip])
+			continue ;
+
+		ranges.push_back(DirtyRange{_dirtyMin[mip], _dirtyMax[mip] - _dirtyMin[mip] + 1});
+		_dirtyMin[mip] = UINT32_MAX;
+		_dirtyMax[mip] = 0;
+	}
+
+	return ranges;
+}
+
+uint32_t		VirtualTexturePageManager::PackEntry(uint32_t slotX, uint32_t slotY, int mip) noexcept
+{
+	return (slotX & 0xFFF) | ((slotY & 0xFFF) << 12) | ((static_cast< uint32_t >(mip) & 0x7F) << 24) | 0x80000000;
+}
+
+bool			VirtualTexturePageManager::UnpackEntry(uint32_t entry, uint32_t & slotX, uint32_t & slotY, int & mip) noexcept
+{
+	slotX = entry & 0xFFF;
+	slotY = (entry >> 12) & 0xFFF;
+	mip = (entry >> 24) & 0x7F;
+
+	return (entry & 0x80000000) != 0;
+}
+
+bool			VirtualTexturePageManager::IsResident(uint32_t pageIndex) const noexcept { return _resident[pageIndex]; }
+uint32_t		VirtualTexturePageManager::GetSlotX(uint32_t slot) const noexcept { return slot % _cacheWidth; }
+uint32_t		VirtualTexturePageManager::GetSlotY(uint32_t slot) const noexcept { return slot / _cacheWidth; }
+size_t			VirtualTexturePageManager::GetResidentCount(void) const noexcept { return GetSlotCount() - _freeSlots.size(); }
+size_t			VirtualTexturePageManager::GetRequestCount(void) const noexcept { return _requests.size(); }
+size_t			VirtualTexturePageManager::GetLoadingCount(void) const noexcept { return _loading.size(); }
+uint32_t		VirtualTexturePageManager::GetSlotCount(void) const noexcept { return _cacheWidth * _cacheHeight; }
+const std::vector< uint32_t > &	VirtualTexturePageManager::GetPageTable(void) const noexcept { return _pageTable; }
+const VirtualTextureLayout &	VirtualTexturePageManager::GetLayout(void) const noexcept { return _layout; }
+
+std::ostream &	operator<<(std::ostream & o, VirtualTexturePageManager const & r)
+{
+	o << "VirtualTexturePageManager " << r.GetResidentCount() << "/" << r.GetSlotCount() << " pages resident, "
+		<< r.GetRequestCount() << " requested, " << r.GetLoadingCount() << " loading" << std::endl;
+	return (o);
+}
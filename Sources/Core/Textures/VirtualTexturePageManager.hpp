@@ -0,0 +1,92 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_set>
+#include <cstdint>
+
+#include "Core/Textures/VirtualTextureLayout.hpp"
+
+namespace LWGC
+{
+	// CPU side residency of a virtual texture: consumes the page feedback, decides which tiles to load, assigns them
+	// a slot in the physical tile cache (evicting the least recently used ones) and maintains the page table.
+	// Doesn't depend on Vulkan so it can be driven by the VirtualTextureFeedbackSimulator.
+	class		VirtualTexturePageManager
+	{
+		public:
+			static const uint32_t	InvalidSlot = 0xFFFFFFFF;
+
+			struct	DirtyRange
+			{
+				uint32_t	first;
+				uint32_t	count;
+			};
+
+		private:
+			struct	ResidentPage
+			{
+				uint32_t					slot;
+				uint64_t					lastUsedFrame;
+				bool						locked;
+				std::list< uint32_t >::iterator	lruIterator;
+			};
+
+			VirtualTextureLayout			_layout;
+			uint32_t						_cacheWidth;
+			uint32_t						_cacheHeight;
+			std::vector< uint32_t >			_pageTable;
+			std::vector< ResidentPage >		_pages;
+			std::vector< bool >				_resident;
+			// Most recently used first, locked pages (last mip) are never in the list
+			std::list< uint32_t >			_lru;
+			std::vector< uint32_t >			_freeSlots;
+			std::unordered_set< uint32_t >	_requests;
+			std::unordered_set< uint32_t >	_loading;
+			std::vector< uint32_t >			_dirtyMin;
+			std::vector< uint32_t >			_dirtyMax;
+			uint64_t						_frameIndex;
+
+			void		SetEntry(uint32_t pageIndex, uint32_t entry);
+			void		PropagateEntry(uint32_t pageIndex, uint32_t entry);
+			void		Request(uint32_t pageIndex);
+			void		Touch(uint32_t pageIndex);
+			uint32_t	AllocateSlot(void);
+
+		public:
+			VirtualTexturePageManager(const VirtualTextureLayout & layout, uint32_t cacheWidthInTiles, uint32_t cacheHeightInTiles);
+			VirtualTexturePageManager(const VirtualTexturePageManager &) = delete;
+			virtual ~VirtualTexturePageManager(void) = default;
+
+			VirtualTexturePageManager &	operator=(VirtualTexturePageManager const & src) = delete;
+
+			// Feedback is a bitfield of GetFeedbackWordCount() words, one bit per requested page
+			void			ProcessFeedback(const uint32_t * feedback, size_t wordCount);
+			// Next pages to load, coarse mips first; they stay marked as loading until mapped or canceled
+			std::vector< uint32_t >	PopRequests(size_t maxCount);
+			// Assign a cache slot to a loaded page, returns InvalidSlot if all the slots are used by visible pages
+			uint32_t		MapPage(uint32_t pageIndex);
+			void			CancelRequest(uint32_t pageIndex);
+
+			// Ranges of the page table modified since the last call
+			std::vector< DirtyRange >	PopDirtyRanges(void);
+
+			bool			IsResident(uint32_t pageIndex) const noexcept;
+			uint32_t		GetSlotX(uint32_t slot) const noexcept;
+			uint32_t		GetSlotY(uint32_t slot) const noexcept;
+			size_t			GetResidentCount(void) const noexcept;
+			size_t			GetRequestCount(void) const noexcept;
+			size_t			GetLoadingCount(void) const noexcept;
+			uint32_t		GetSlotCount(void) const noexcept;
+			const std::vector< uint32_t > &	GetPageTable(void) const noexcept;
+			const VirtualTextureLayout &	GetLayout(void) const noexcept;
+
+			// Page table entry: bits 0-11 cache slot x, 12-23 slot y, 24-30 mip of the mapped page, 31 valid
+			static uint32_t	PackEntry(uint32_t slotX, uint32_t slotY, int mip) noexcept;
+			static bool		UnpackEntry(uint32_t entry, uint32_t & slotX, uint32_t & slotY, int & mip) noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, VirtualTexturePageManager const & r);
+}
@@ -18,11 +18,16 @@ void					DescriptorSet::SetStage(VkShaderStageFlagBits stageFlags)
 }
 
 void					DescriptorSet::AddBinding(uint32_t index, Texture * texture, VkDescriptorType descriptorType)
+{
+	AddBinding(index, texture, descriptorType, texture->GetLayout());
+}
+
+void					DescriptorSet::AddBinding(uint32_t index, Texture * texture, VkDescriptorType descriptorType, VkImageLayout layout)
 {
 	_layoutBinding.push_back(Vk::CreateDescriptorSetLayoutBinding(index, descriptorType, _stageFlags));
 
 	VkDescriptorImageInfo imageInfo = {};
-	imageInfo.imageLayout = texture->GetLayout();
+	imageInfo.imageLayout = layout;
 	imageInfo.imageView = texture->GetView();
 	imageInfo.sampler = 0;
 
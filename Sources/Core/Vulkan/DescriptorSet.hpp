@@ -43,6 +43,8 @@ namespace LWGC
 			void					SetStage(VkShaderStageFlagBits stageFlags);
 
 			void					AddBinding(uint32_t index, Texture * texture, VkDescriptorType descriptorType);
+			// The layout the texture will be in when the set is used, for the images transitioned by the render graph
+			void					AddBinding(uint32_t index, Texture * texture, VkDescriptorType descriptorType, VkImageLayout layout);
 			void					AddBinding(uint32_t index, VkDescriptorType descriptorType, VkBuffer buffer, VkDeviceSize range, VkDeviceSize offset = 0);
 			// TODO: bindings for buffers, samplers and texel buffers
 
@@ -0,0 +1,339 @@
+#include "GpuProfiler.hpp"
+
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/Vk.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace LWGC;
+
+std::mutex										GpuProfiler::_mutex;
+VkDevice										GpuProfiler::_device = VK_NULL_HANDLE;
+double											GpuProfiler::_timestampPeriod = 1.0;
+std::vector< GpuProfiler::Lane >				GpuProfiler::_lanes;
+std::unordered_map< VkCommandBuffer, GpuProfilerLane >	GpuProfiler::_commandBuffers;
+size_t											GpuProfiler::_frameIndex = 0;
+size_t											GpuProfiler::_frameCount = 0;
+uint64_t										GpuProfiler::_droppedSamples = 0;
+
+void				GpuProfiler::Initialize(size_t frameCount)
+{
+	VulkanInstance *	instance = VulkanInstance::Get();
+
+	Release();
+
+	_device = instance->GetDevice();
+	_timestampPeriod = instance->GetLimits().timestampPeriod;
+	_frameCount = frameCount;
+	_frameIndex = 0;
+
+	AddLane("GPU Graphics", instance->GetQueue(), instance->GetQueueIndex());
+}
+
+void				GpuProfiler::Release(void) noexcept
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	for (auto & lane : _lanes)
+		for (auto & frame : lane.frames)
+			vkDestroyQueryPool(_device, frame.pool, nullptr);
+
+	_lanes.clear();
+	_commandBuffers.clear();
+}
+
+GpuProfilerLane		GpuProfiler::AddLane(const std::string & name, VkQueue queue, uint32_t queueFamilyIndex)
+{
+	uint32_t	familyCount = 0;
+	Lane		lane;
+
+	vkGetPhysicalDeviceQueueFamilyProperties(VulkanInstance::Get()->GetPhysicalDevice(), &familyCount, nullptr);
+	std::vector< VkQueueFamilyProperties >	families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(VulkanInstance::Get()->GetPhysicalDevice(), &familyCount, families.data());
+
+	if (queueFamilyIndex >= familyCount)
+		throw std::runtime_error("Invalid queue family for the GPU profiler lane " + name);
+
+	uint32_t	validBits = families[queueFamilyIndex].timestampValidBits;
+
+	lane.name = name;
+	lane.track = Profiler::AddTrack(name);
+	lane.validMask = (validBits >= 64) ? std::numeric_limits< uint64_t >::max() : (uint64_t(1) << validBits) - 1;
+	lane.supported = validBits != 0;
+	lane.offset = 0;
+
+	// The lane still exists so the samples recorded in its command buffers are ignored
+	if (!lane.supported)
+		std::cout << "Warning: the queue of " << name << " doesn't support timestamps, GPU profiling disabled for this lane" << std::endl;
+	else
+	{
+		lane.offset = Calibrate(queue, queueFamilyIndex, lane.validMask);
+
+		VkQueryPoolCreateInfo	poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = MaxQueriesPerFrame;
+
+		lane.frames.resize(_frameCount, FrameQueries{VK_NULL_HANDLE, 0, false, 0, {}, {}, NoQuery, 0});
+		for (auto & frame : lane.frames)
+		{
+			Vk::CheckResult(vkCreateQueryPool(_device, &poolInfo, nullptr, &frame.pool), "Failed to create the timestamp query pool");
+			frame.samples.reserve(MaxQueriesPerFrame / 2);
+			frame.openSamples.reserve(MaxQueriesPerFrame / 2);
+		}
+	}
+
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	_lanes.push_back(std::move(lane));
+	return static_cast< GpuProfilerLane >(_lanes.size() - 1);
+}
+
+// The timestamp is written somewhere between the submit and the end of the wait, the middle of this
+// interval is used as the CPU time of the timestamp. Precise to the submit latency, which is enough to
+// place the GPU samples next to the CPU ones.
+int64_t				GpuProfiler::Calibrate(VkQueue queue, uint32_t queueFamilyIndex, uint64_t validMask)
+{
+	VkCommandPool		commandPool;
+	VkCommandBuffer		cmd;
+	VkQueryPool			queryPool;
+	uint64_t			timestamp = 0;
+
+	VkCommandPoolCreateInfo	commandPoolInfo = {};
+	commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+	commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	Vk::CheckResult(vkCreateCommandPool(_device, &commandPoolInfo, nullptr, &commandPool), "Failed to create the calibration command pool");
+
+	VkQueryPoolCreateInfo	queryPoolInfo = {};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = 1;
+	Vk::CheckResult(vkCreateQueryPool(_device, &queryPoolInfo, nullptr, &queryPool), "Failed to create the calibration query pool");
+
+	VkCommandBufferAllocateInfo	allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	Vk::CheckResult(vkAllocateCommandBuffers(_device, &allocInfo, &cmd), "Failed to allocate the calibration command buffer");
+
+	VkCommandBufferBeginInfo	beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	Vk::CheckResult(vkBeginCommandBuffer(cmd, &beginInfo), "Failed to begin the calibration command buffer");
+	vkCmdResetQueryPool(cmd, queryPool, 0, 1);
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+	Vk::CheckResult(vkEndCommandBuffer(cmd), "Failed to end the calibration command buffer");
+
+	VkSubmitInfo	submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmd;
+
+	VkFence		fence = Vk::CreateFence(false);
+	uint64_t	submitTime = Profiler::GetTime();
+
+	Vk::CheckResult(vkQueueSubmit(queue, 1, &submitInfo, fence), "Failed to submit the calibration command buffer");
+	Vk::CheckResult(vkWaitForFences(_device, 1, &fence, VK_TRUE, std::numeric_limits< uint64_t >::max()), "Failed to wait the calibration fence");
+
+	uint64_t	endTime = Profiler::GetTime();
+
+	Vk::CheckResult(vkGetQueryPoolResults(_device, queryPool, 0, 1, sizeof(timestamp), &timestamp, sizeof(timestamp), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT), "Failed to read the calibration timestamp");
+
+	vkDestroyFence(_device, fence, nullptr);
+	vkDestroyQueryPool(_device, queryPool, nullptr);
+	vkDestroyCommandPool(_device, commandPool, nullptr);
+
+	int64_t	gpuTime = static_cast< int64_t >(static_cast< double >(timestamp & validMask) * _timestampPeriod);
+
+	return static_cast< int64_t >(submitTime + (endTime - submitTime) / 2) - gpuTime;
+}
+
+void				GpuProfiler::BeginFrame(size_t frameIndex)
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	if (frameIndex >= _frameCount)
+		return ;
+
+	_frameIndex = frameIndex;
+	_commandBuffers.clear();
+
+	for (auto & lane : _lanes)
+	{
+		if (!lane.supported)
+			continue ;
+
+		FrameQueries & frame = lane.frames[_frameIndex];
+
+		ReadBack(lane, frame);
+
+		frame.queryCount = 0;
+		frame.frameEndQuery = NoQuery;
+		frame.reset = false;
+		frame.samples.clear();
+		frame.openSamples.clear();
+	}
+}
+
+void				GpuProfiler::ReadBack(Lane & lane, FrameQueries & frame)
+{
+	frame.frameEndTime = 0;
+	if (frame.queryCount == 0)
+		return ;
+
+	// Value and availability of each query. Without the wait bit, the unavailable queries are just skipped
+	std::vector< uint64_t >			results(frame.queryCount * 2, 0);
+	std::vector< ProfilerScope >	scopes;
+
+	VkResult result = vkGetQueryPoolResults(_device, frame.pool, 0, frame.queryCount, results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		_droppedSamples += frame.samples.size();
+		return ;
+	}
+
+	for (const auto & sample : frame.samples)
+	{
+		// The sample was never ended
+		if (sample.endQuery == sample.beginQuery || results[sample.beginQuery * 2 + 1] == 0 || results[sample.endQuery * 2 + 1] == 0)
+		{
+			_droppedSamples++;
+			continue ;
+		}
+
+		uint64_t	begin = results[sample.beginQuery * 2] & lane.validMask;
+		uint64_t	end = results[sample.endQuery * 2] & lane.validMask;
+
+		scopes.push_back({
+			static_cast< uint64_t >(static_cast< int64_t >(static_cast< double >(begin) * _timestampPeriod) + lane.offset),
+			static_cast< uint64_t >(static_cast< int64_t >(static_cast< double >(std::max(begin, end)) * _timestampPeriod) + lane.offset),
+			sample.name,
+			sample.depth,
+			lane.track,
+		});
+	}
+
+	if (frame.frameEndQuery != NoQuery && results[frame.frameEndQuery * 2 + 1] != 0)
+		frame.frameEndTime = static_cast< uint64_t >(static_cast< int64_t >(static_cast< double >(results[frame.frameEndQuery * 2] & lane.validMask) * _timestampPeriod) + lane.offset);
+
+	if (!scopes.empty())
+		Profiler::AddLateScopes(frame.profilerFrame, scopes);
+}
+
+void				GpuProfiler::BeginCommandBuffer(VkCommandBuffer cmd, GpuProfilerLane lane) noexcept
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	if (!Profiler::IsEnabled() || lane >= _lanes.size() || !_lanes[lane].supported)
+		return ;
+
+	FrameQueries & frame = _lanes[lane].frames[_frameIndex];
+
+	if (!frame.reset)
+	{
+		vkCmdResetQueryPool(cmd, frame.pool, 0, MaxQueriesPerFrame);
+		frame.reset = true;
+		frame.profilerFrame = Profiler::GetFrameIndex();
+	}
+
+	try {
+		_commandBuffers[cmd] = lane;
+	} catch (const std::exception &) {
+		// Without the command buffer in the map, its samples are ignored
+	}
+}
+
+GpuProfiler::FrameQueries *	GpuProfiler::GetFrameQueries(VkCommandBuffer cmd) noexcept
+{
+	auto lane = _commandBuffers.find(cmd);
+
+	if (lane == _commandBuffers.end())
+		return nullptr;
+
+	FrameQueries & frame = _lanes[lane->second].frames[_frameIndex];
+
+	return frame.reset ? &frame : nullptr;
+}
+
+bool				GpuProfiler::BeginSample(VkCommandBuffer cmd, ProfilerNameId name) noexcept
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+	FrameQueries *					frame = GetFrameQueries(cmd);
+
+	if (frame == nullptr)
+		return false;
+
+	// The end query of every open sample is reserved so EndSample never runs out of queries
+	if (frame->queryCount + frame->openSamples.size() + 2 > MaxQueriesPerFrame)
+	{
+		_droppedSamples++;
+		return false;
+	}
+
+	// Both vectors have the capacity for all the samples of a frame, this never allocates
+	frame->samples.push_back({name, frame->queryCount, frame->queryCount, static_cast< uint32_t >(frame->openSamples.size())});
+	frame->openSamples.push_back(frame->samples.size() - 1);
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->pool, frame->queryCount);
+	frame->queryCount++;
+	return true;
+}
+
+void				GpuProfiler::EndSample(VkCommandBuffer cmd) noexcept
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+	FrameQueries *					frame = GetFrameQueries(cmd);
+
+	if (frame == nullptr || frame->openSamples.empty())
+		return ;
+
+	Sample & sample = frame->samples[frame->openSamples.back()];
+
+	frame->openSamples.pop_back();
+	sample.endQuery = frame->queryCount;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->pool, frame->queryCount);
+	frame->queryCount++;
+}
+
+void				GpuProfiler::WriteFrameEnd(VkCommandBuffer cmd) noexcept
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+	FrameQueries *					frame = GetFrameQueries(cmd);
+
+	if (frame == nullptr || frame->queryCount + frame->openSamples.size() + 1 > MaxQueriesPerFrame)
+		return ;
+
+	frame->frameEndQuery = frame->queryCount;
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->pool, frame->queryCount);
+	frame->queryCount++;
+}
+
+bool				GpuProfiler::GetFrameEndTime(size_t frameIndex, GpuProfilerLane lane, uint64_t & time)
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	if (lane >= _lanes.size() || !_lanes[lane].supported || frameIndex >= _frameCount)
+		return false;
+
+	time = _lanes[lane].frames[frameIndex].frameEndTime;
+	return time != 0;
+}
+
+uint64_t			GpuProfiler::GetDroppedSampleCount(void)
+{
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	return _droppedSamples;
+}
+
+std::ostream &	operator<<(std::ostream & o, GpuProfiler const & r)
+{
+	o << "GpuProfiler" << std::endl;
+	(void)r;
+	return (o);
+}
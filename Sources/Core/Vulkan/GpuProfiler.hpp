@@ -0,0 +1,110 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Core/Profiler.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	using GpuProfilerLane = uint32_t;
+
+	// GPU execution time of the samples, measured with timestamp queries. Each lane (one per queue) has a
+	// query pool per frame in flight: the timestamps are written around the samples in the command buffers
+	// and read back when the frame slot is reused, without waiting for the queries. The results are added
+	// to the Profiler frame in which they were recorded, with one profiler track per lane.
+	class		GpuProfiler
+	{
+		private:
+			struct	Sample
+			{
+				ProfilerNameId	name;
+				uint32_t		beginQuery;
+				uint32_t		endQuery;
+				uint32_t		depth;
+			};
+
+			struct	FrameQueries
+			{
+				VkQueryPool				pool;
+				uint32_t				queryCount;
+				bool					reset;			// The reset of the pool is recorded for this frame
+				uint64_t				profilerFrame;
+				std::vector< Sample >	samples;
+				std::vector< size_t >	openSamples;
+				uint32_t				frameEndQuery;	// NoQuery when WriteFrameEnd wasn't called
+				uint64_t				frameEndTime;	// Read back from frameEndQuery, 0 if unavailable
+			};
+
+			struct	Lane
+			{
+				std::string					name;
+				uint32_t					track;
+				uint64_t					validMask;		// Mask of the timestampValidBits of the queue family
+				int64_t						offset;			// GPU nanoseconds to Profiler::GetTime
+				bool						supported;
+				std::vector< FrameQueries >	frames;
+			};
+
+			static std::mutex									_mutex;
+			static VkDevice										_device;
+			static double										_timestampPeriod;
+			static std::vector< Lane >							_lanes;
+			static std::unordered_map< VkCommandBuffer, GpuProfilerLane >	_commandBuffers;
+			static size_t										_frameIndex;
+			static size_t										_frameCount;
+			static uint64_t										_droppedSamples;
+
+			static int64_t	Calibrate(VkQueue queue, uint32_t queueFamilyIndex, uint64_t validMask);
+			static void		ReadBack(Lane & lane, FrameQueries & frame);
+			static FrameQueries *	GetFrameQueries(VkCommandBuffer cmd) noexcept;
+
+		public:
+			static const uint32_t			MaxQueriesPerFrame = 1024;
+			static const uint32_t			NoQuery = UINT32_MAX;
+			static const GpuProfilerLane	GraphicsLane = 0;
+
+			GpuProfiler(void) = delete;
+			GpuProfiler(const GpuProfiler &) = delete;
+			virtual ~GpuProfiler(void) = delete;
+
+			GpuProfiler &	operator=(GpuProfiler const & src) = delete;
+
+			// Create the graphics lane on the main queue, frameCount is the number of frames in flight
+			static void		Initialize(size_t frameCount);
+			static void		Release(void) noexcept;
+
+			// Lane for the command buffers submitted to another queue, stalls once to align its clock with the CPU
+			static GpuProfilerLane	AddLane(const std::string & name, VkQueue queue, uint32_t queueFamilyIndex);
+
+			// Read back the queries of the frame slot, must be called once the fence of this slot is signaled
+			static void		BeginFrame(size_t frameIndex);
+
+			// Only the samples recorded in a command buffer begun here are timed. This records the reset of
+			// the lane queries when it's the first command buffer of the lane in the frame, so it must be
+			// called outside of a render pass and this command buffer must be submitted first.
+			static void		BeginCommandBuffer(VkCommandBuffer cmd, GpuProfilerLane lane) noexcept;
+
+			// EndSample must only be called when BeginSample returned true, it ends the last open sample
+			static bool		BeginSample(VkCommandBuffer cmd, ProfilerNameId name) noexcept;
+			static void		EndSample(VkCommandBuffer cmd) noexcept;
+
+			// Timestamp the end of the frame in the last command buffer submitted for it
+			static void		WriteFrameEnd(VkCommandBuffer cmd) noexcept;
+			// When the GPU finished the last frame of the slot, in Profiler::GetTime nanoseconds. It's read back by
+			// BeginFrame, false if the frame end wasn't written or isn't available
+			static bool		GetFrameEndTime(size_t frameIndex, GpuProfilerLane lane, uint64_t & time);
+
+			// Samples lost because the query pool was full or the results were not available at readback
+			static uint64_t	GetDroppedSampleCount(void);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, GpuProfiler const & r);
+}
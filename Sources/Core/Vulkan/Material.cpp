@@ -15,6 +15,8 @@
 #include "Core/Vulkan/RenderPass.hpp"
 #include "Core/Application.hpp"
 #include "Core/ShaderCache.hpp"
+#include "Core/Rendering/RenderPipelineManager.hpp"
+#include "Core/MaterialTable.hpp"
 #include "Utils/Utils.hpp"
 
 using namespace LWGC;
@@ -35,6 +37,8 @@ const std::string	LWGCBinding::Frame = "frame";
 const std::string	LWGCBinding::Camera = "camera";
 const std::string	LWGCBinding::Material = "material";
 const std::string	LWGCBinding::Object = "object";
+const std::string	LWGCBinding::Lights = "lightClusters";
+const std::string	LWGCBinding::Shadows = "shadows";
 
 Material::Material(void)
 {
@@ -60,9 +64,14 @@ Material::~Material(void)
 	if (_instance == nullptr)
 		return ;
 
+	if (MaterialTable::Get() != nullptr)
+		MaterialTable::Get()->_pendingVariants.erase(this);
+
 	vkDeviceWaitIdle(_instance->GetDevice());
 
 	CleanupPipelineAndLayout();
+	for (const auto & set : _setTable)
+		vkFreeDescriptorSets(_device, _instance->GetDescriptorPool(), 1, &set.second.set);
 
 	vkDestroyBuffer(_device, _uniformPerMaterial.buffer, nullptr);
 	vkFreeMemory(_device, _uniformPerMaterial.memory, nullptr);
@@ -93,6 +102,10 @@ void					Material::SetupDefaultSettings(void)
 	this->_swapChain = nullptr;
 	this->_renderPass = nullptr;
 	this->_program = nullptr;
+	this->_baseProgram = _originalProgram;
+	this->_keywordMask = 0;
+	this->_activeKeywordMask = 0;
+	this->_perMaterial.albedo = glm::vec4(1, 1, 0, 1);
 
 	static auto bindingDescription = Mesh::GetBindingDescription();
 	static auto attributeDescriptions = Mesh::GetAttributeDescriptions();
@@ -156,136 +169,194 @@ void					Material::Initialize(SwapChain * swapChain, RenderPass * renderPass)
 void					Material::BindMaterialProperties(void) noexcept
 {
 	for (const auto & prop : _materialProperties)
+		BindMaterialProperty(prop.first, prop.second);
+}
+
+void					Material::BindMaterialProperty(const std::string & bindingName, const MaterialProperty & property) noexcept
+{
+	switch (property.propertyType)
 	{
-		switch (prop.second.propertyType)
-		{
-			case MaterialPropertyType::Buffer:
-				SetBuffer(prop.first, prop.second.buffer, prop.second.size, prop.second.descriptorType);
-				break ;
-			case MaterialPropertyType::Texture:
-				SetTexture(prop.first, prop.second.texture, prop.second.imageLayout, prop.second.descriptorType);
-				break ;
-			case MaterialPropertyType::Sampler:
-				SetSampler(prop.first, prop.second.sampler);
-				break ;
-			default:
-				std::cerr << "Can't bind material property of type " << static_cast< int >(prop.second.propertyType) << std::endl;
-				break ;
-		}
+		case MaterialPropertyType::Buffer:
+			SetBuffer(bindingName, property.buffer, property.size, property.descriptorType);
+			break ;
+		case MaterialPropertyType::Texture:
+			SetTexture(bindingName, property.texture, property.imageLayout, property.descriptorType);
+			break ;
+		case MaterialPropertyType::Sampler:
+			SetSampler(bindingName, property.sampler);
+			break ;
+		default:
+			std::cerr << "Can't bind material property of type " << static_cast< int >(property.propertyType) << std::endl;
+			break ;
 	}
 }
 
 void					Material::CompileShaders(void)
 {
+	_program = GetCompiledProgram();
+	_activeKeywordMask = _keywordMask;
+
+	// Retrieve set layout of the shader program:
+	_bindingTable = _program->GetShaderBindingTable();
+	_setLayouts = _bindingTable->GetDescriptorSetLayouts();
+}
+
+ShaderProgram *			Material::GetCompiledProgram(void)
+{
+	ShaderProgram *	program;
+
 	try {
 		if (!_originalProgram->IsCompiled())
 			_originalProgram->CompileAndLink();
-		_program = _originalProgram;
+		return _originalProgram;
 	} catch (const std::runtime_error & e) {
 		std::cout << e.what() << std::endl;
-		if (IsCompute())
-			_program = ShaderCache::GetShader(BuiltinShaders::ComputeError, VK_SHADER_STAGE_COMPUTE_BIT);
+		if (_originalProgram->IsCompute())
+			program = ShaderCache::GetShader(BuiltinShaders::ComputeError, VK_SHADER_STAGE_COMPUTE_BIT);
 		else
-			_program = ShaderCache::GetShader(BuiltinShaders::Pink, BuiltinShaders::DefaultVertex);
+			program = ShaderCache::GetShader(BuiltinShaders::Pink, BuiltinShaders::DefaultVertex);
 
-		if (!_program->IsCompiled())
-			_program->CompileAndLink();
+		if (!program->IsCompiled())
+			program->CompileAndLink();
 	}
 
-	// Retrieve set layout of the shader program:
-	_bindingTable = _program->GetShaderBindingTable();
-	_setLayouts = _bindingTable->GetDescriptorSetLayouts();
+	return program;
 }
 
 void					Material::CleanupPipelineAndLayout(void) noexcept
 {
 	vkDestroyPipeline(_device, _pipeline, nullptr);
+	for (const auto & pipeline : _passPipelines)
+		vkDestroyPipeline(_device, pipeline.second, nullptr);
+	_passPipelines.clear();
 	vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
+	DestroyCachedVariants();
+}
+
+void					Material::DestroyCachedVariants(void) noexcept
+{
+	for (const auto & variant : _variantCache)
+	{
+		vkDestroyPipeline(_device, variant.second.pipeline, nullptr);
+		for (const auto & pipeline : variant.second.passPipelines)
+			vkDestroyPipeline(_device, pipeline.second, nullptr);
+		vkDestroyPipelineLayout(_device, variant.second.layout, nullptr);
+	}
+	_variantCache.clear();
 }
 
 void					Material::CreatePipelineLayout(void)
 {
+	_pipelineLayout = CreatePipelineLayout(_program);
+}
+
+VkPipelineLayout		Material::CreatePipelineLayout(ShaderProgram * program)
+{
+	const auto &		setLayouts = program->GetShaderBindingTable()->GetDescriptorSetLayouts();
+	VkPipelineLayout	layout;
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
-	pipelineLayoutInfo.setLayoutCount = _setLayouts.size();
-	pipelineLayoutInfo.pSetLayouts = _setLayouts.data();
+	pipelineLayoutInfo.setLayoutCount = setLayouts.size();
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
 
-	const auto & pushConstants = _bindingTable->GetPushConstants(IsCompute() ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_ALL_GRAPHICS);
+	const auto & pushConstants = program->GetShaderBindingTable()->GetPushConstants(program->IsCompute() ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_ALL_GRAPHICS);
 	pipelineLayoutInfo.pushConstantRangeCount = pushConstants.size();
 	pipelineLayoutInfo.pPushConstantRanges = pushConstants.data();
 
-	if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
+	if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
 		throw std::runtime_error("failed to create pipeline layout !");
+
+	return layout;
 }
 
 void					Material::CreatePipeline(void)
 {
 	if (_program->IsCompute())
-		CreateComputePipeline();
+		_pipeline = CreateComputePipeline(_program, _pipelineLayout);
 	else
-		CreateGraphicPipeline();
+		_pipeline = CreateGraphicPipeline(_renderPass, _program, _pipelineLayout);
 	
 	Vk::SetPipelineDebugName(_program->GetName(), _pipeline);
 }
 
-void					Material::CreateComputePipeline(void)
+VkPipeline				Material::CreateComputePipeline(ShaderProgram * program, VkPipelineLayout layout)
 {
+	VkPipeline	pipeline;
+
 	VkComputePipelineCreateInfo pipelineCreateInfo = {};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-	pipelineCreateInfo.stage = _program->GetShaderStages()[0];
-	pipelineCreateInfo.layout = _pipelineLayout;
+	pipelineCreateInfo.stage = program->GetShaderStages()[0];
+	pipelineCreateInfo.layout = layout;
 
 	Vk::CheckResult(vkCreateComputePipelines(
-		_device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, NULL, &_pipeline),
+		_device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, NULL, &pipeline),
 		"Can't create compute pipeline");
+
+	return pipeline;
 }
 
-void					Material::CreateGraphicPipeline(void)
+VkPipeline				Material::CreateGraphicPipeline(const RenderPass * renderPass, ShaderProgram * program, VkPipelineLayout layout, bool depthPrepassed)
 {
-	const auto & extent = _swapChain->GetExtent();
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float) extent.width;
-	viewport.height = (float) extent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = {0, 0};
-	scissor.extent = extent;
-
+	// The viewport and scissor are set by RenderPass::Begin, so the pipelines don't depend on the size of the target
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+
+	const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	VkPipelineMultisampleStateCreateInfo multisampling = {};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.rasterizationSamples = renderPass->GetSampleCount();
+
+	// The blend state of the material is used for all the color attachments of the pass (none for a depth only pass)
+	VkPipelineColorBlendStateCreateInfo						colorBlendState = _colorBlendState;
+	std::vector< VkPipelineColorBlendAttachmentState >		blendAttachments;
+
+	if (_colorBlendState.attachmentCount > 0 && renderPass->GetColorAttachmentCount() != _colorBlendState.attachmentCount)
+	{
+		blendAttachments.assign(renderPass->GetColorAttachmentCount(), _colorBlendState.pAttachments[0]);
+		colorBlendState.attachmentCount = static_cast< uint32_t >(blendAttachments.size());
+		colorBlendState.pAttachments = blendAttachments.data();
+	}
 
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = _program->GetShaderStages();
+	pipelineInfo.pStages = program->GetShaderStages();
 	pipelineInfo.pVertexInputState = &_vertexInputState;
 	pipelineInfo.pInputAssemblyState = &_inputAssemblyState;
 	pipelineInfo.pViewportState = &viewportState;
 	pipelineInfo.pRasterizationState = &_rasterizationState;
 	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pColorBlendState = &_colorBlendState;
-	pipelineInfo.layout = _pipelineLayout;
-	pipelineInfo.renderPass = _renderPass->GetRenderPass();
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = layout;
+	pipelineInfo.renderPass = renderPass->GetRenderPass();
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-	pipelineInfo.pDepthStencilState = &_depthStencilState;
+	VkPipelineDepthStencilStateCreateInfo	depthStencilState = _depthStencilState;
+
+	// The depth is already in the buffer, only the fragments of the visible surfaces are shaded (reversed Z)
+	if (depthPrepassed)
+	{
+		depthStencilState.depthWriteEnable = VK_FALSE;
+		depthStencilState.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	}
+	pipelineInfo.pDepthStencilState = &depthStencilState;
 
-	if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline) != VK_SUCCESS)
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
 		throw std::runtime_error("failed to create graphics pipeline!");
+
+	return pipeline;
 }
 
 void					Material::CreateTextureSampler(void)
@@ -304,17 +375,232 @@ void					Material::CreateUniformBuffer(void)
 	);
 }
 
-void					Material::ReloadShaders(void) noexcept
+Material::ProgramPipelines	Material::CreateProgramPipelines(ShaderProgram * program)
 {
-	CompileShaders();
-	vkDestroyPipeline(VulkanInstance::Get()->GetDevice(), _pipeline, NULL);
-	CreatePipeline();
+	ProgramPipelines	pipelines = {program, VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+	pipelines.layout = CreatePipelineLayout(program);
+
+	try {
+		if (program->IsCompute())
+			pipelines.pipeline = CreateComputePipeline(program, pipelines.layout);
+		else
+			pipelines.pipeline = CreateGraphicPipeline(_renderPass, program, pipelines.layout);
+	} catch (...) {
+		vkDestroyPipelineLayout(_device, pipelines.layout, nullptr);
+		throw ;
+	}
+
+	Vk::SetPipelineDebugName(program->GetName(), pipelines.pipeline);
+
+	return pipelines;
 }
 
-void					Material::UpdateUniformBuffer()
+void					Material::DestroyProgramPipelines(const ProgramPipelines & pipelines) noexcept
+{
+	vkDestroyPipeline(_device, pipelines.pipeline, nullptr);
+	vkDestroyPipelineLayout(_device, pipelines.layout, nullptr);
+}
+
+void					Material::ApplyProgramPipelines(const ProgramPipelines & pipelines)
+{
+	ReleasePipelinesAndSets();
+
+	_program = pipelines.program;
+	_activeKeywordMask = _keywordMask;
+	_bindingTable = _program->GetShaderBindingTable();
+	_setLayouts = _bindingTable->GetDescriptorSetLayouts();
+	_pipelineLayout = pipelines.layout;
+	_pipeline = pipelines.pipeline;
+
+	// The set layouts may have changed, the properties are bound again in new descriptor sets
+	BindMaterialProperties();
+}
+
+void					Material::ReleasePipelinesAndSets(void)
+{
+	std::vector< VkPipeline >		pipelines = {_pipeline};
+	VkPipelineLayout				layout = _pipelineLayout;
+	VkDevice						device = _device;
+
+	for (const auto & pipeline : _passPipelines)
+		pipelines.push_back(pipeline.second);
+
+	_passPipelines.clear();
+	_pipeline = VK_NULL_HANDLE;
+	_pipelineLayout = VK_NULL_HANDLE;
+
+	ReleaseDescriptorSets();
+	RenderPipelineManager::ReleaseAfterFrames([device, pipelines, layout]()
+	{
+		for (auto pipeline : pipelines)
+			vkDestroyPipeline(device, pipeline, nullptr);
+		vkDestroyPipelineLayout(device, layout, nullptr);
+	});
+}
+
+void					Material::ReleaseDescriptorSets(void)
+{
+	std::unordered_set< uint32_t >	setBindings;
+
+	for (const auto & set : _setTable)
+		setBindings.insert(set.first);
+	ReleaseDescriptorSets(setBindings);
+}
+
+void					Material::ReleaseDescriptorSets(const std::unordered_set< uint32_t > & setBindings)
+{
+	std::vector< VkDescriptorSet >	sets;
+	VkDevice						device = _device;
+	VkDescriptorPool				pool = _instance->GetDescriptorPool();
+
+	for (auto setBinding : setBindings)
+	{
+		auto set = _setTable.find(setBinding);
+
+		if (set == _setTable.end())
+			continue ;
+		sets.push_back(set->second.set);
+		_setTable.erase(set);
+	}
+
+	if (sets.empty())
+		return ;
+
+	RenderPipelineManager::ReleaseAfterFrames([device, pool, sets]()
+	{
+		vkFreeDescriptorSets(device, pool, static_cast< uint32_t >(sets.size()), sets.data());
+	});
+}
+
+void					Material::ReleaseCachedVariants(const ShaderProgram * program)
 {
-	_perMaterial.albedo = glm::vec4(1, 1, 0, 1);
+	std::vector< VkPipeline >		pipelines;
+	std::vector< VkPipelineLayout >	layouts;
+	VkDevice						device = _device;
 
+	for (auto variant = _variantCache.begin(); variant != _variantCache.end();)
+	{
+		if (variant->second.program != program)
+		{
+			++variant;
+			continue ;
+		}
+
+		pipelines.push_back(variant->second.pipeline);
+		for (const auto & pipeline : variant->second.passPipelines)
+			pipelines.push_back(pipeline.second);
+		layouts.push_back(variant->second.layout);
+		variant = _variantCache.erase(variant);
+	}
+
+	if (layouts.empty())
+		return ;
+
+	RenderPipelineManager::ReleaseAfterFrames([device, pipelines, layouts]()
+	{
+		for (auto pipeline : pipelines)
+			vkDestroyPipeline(device, pipeline, nullptr);
+		for (auto layout : layouts)
+			vkDestroyPipelineLayout(device, layout, nullptr);
+	});
+}
+
+bool					Material::UpdateKeywordVariant(void)
+{
+	if (!IsInitialized() || _activeKeywordMask == _keywordMask)
+		return true;
+	if (_originalProgram->IsPrewarming())
+		return false;
+
+	KeywordVariant	variant;
+	auto			cached = _variantCache.find(_keywordMask);
+
+	if (cached != _variantCache.end())
+	{
+		variant = std::move(cached->second);
+		_variantCache.erase(cached);
+	}
+	else
+	{
+		try {
+			ProgramPipelines	pipelines = CreateProgramPipelines(GetCompiledProgram());
+
+			variant = {pipelines.program, pipelines.layout, pipelines.pipeline, {}};
+		} catch (const std::runtime_error & e) {
+			// Keep the current pipelines
+			std::cerr << e.what() << std::endl;
+			return true;
+		}
+	}
+
+	// The pipelines of the current variant are kept for a switch back, the descriptor sets are allocated again
+	// because the set layouts of the variants can differ
+	_variantCache[_activeKeywordMask] = {_program, _pipelineLayout, _pipeline, std::move(_passPipelines)};
+	_passPipelines.clear();
+	ReleaseDescriptorSets();
+
+	_program = variant.program;
+	_activeKeywordMask = _keywordMask;
+	_bindingTable = _program->GetShaderBindingTable();
+	_setLayouts = _bindingTable->GetDescriptorSetLayouts();
+	_pipelineLayout = variant.layout;
+	_pipeline = variant.pipeline;
+	_passPipelines = std::move(variant.passPipelines);
+
+	BindMaterialProperties();
+
+	return true;
+}
+
+void					Material::ReloadShaders(void)
+{
+	ApplyProgramPipelines(CreateProgramPipelines(GetCompiledProgram()));
+}
+
+void					Material::EnableKeyword(const std::string & keyword) { SetKeyword(keyword, true); }
+void					Material::DisableKeyword(const std::string & keyword) { SetKeyword(keyword, false); }
+
+void					Material::SetKeyword(const std::string & keyword, bool enabled)
+{
+	KeywordMask	mask = _baseProgram->GetKeywords().GetMask(keyword);
+
+	if (mask == 0)
+	{
+		std::cerr << "Keyword " << keyword << " is not declared in shader " << _baseProgram->GetName() << std::endl;
+		return ;
+	}
+
+	KeywordMask	keywordMask = enabled ? (_keywordMask | mask) : (_keywordMask & ~mask);
+
+	if (keywordMask == _keywordMask)
+		return ;
+
+	ShaderProgram *	oldProgram = _originalProgram;
+
+	_keywordMask = keywordMask;
+	_originalProgram = _baseProgram->GetVariant(_keywordMask);
+	Application::Get()->GetMaterialTable()->UpdateMaterialProgram(this, oldProgram);
+
+	if (!IsInitialized())
+		return ;
+
+	// A variant not used before is compiled on the shared thread pool, the material keeps its current
+	// pipelines until MaterialTable::Update finds the variant ready
+	if (_variantCache.find(_keywordMask) == _variantCache.end())
+		_baseProgram->PrewarmVariants({_keywordMask});
+	Application::Get()->GetMaterialTable()->UpdateKeywordVariant(this);
+}
+
+bool					Material::IsKeywordEnabled(const std::string & keyword)
+{
+	return (_keywordMask & _baseProgram->GetKeywords().GetMask(keyword)) != 0;
+}
+
+KeywordMask				Material::GetKeywordMask(void) const noexcept { return _keywordMask; }
+
+void					Material::UpdateUniformBuffer()
+{
 	Vk::UploadToMemory(_uniformPerMaterial.memory, &_perMaterial, sizeof(_perMaterial));
 }
 
@@ -442,6 +728,33 @@ void				Material::SetBuffer(const std::string & bindingName, VkBuffer buffer, si
 	vkUpdateDescriptorSets(_device, static_cast< uint32_t >(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
+void				Material::RebindTextures(const std::unordered_set< const Texture * > & textures)
+{
+	std::unordered_set< uint32_t >	changedSets;
+
+	if (!IsCompiled())
+		return ;
+
+	for (const auto & prop : _materialProperties)
+	{
+		if (prop.second.propertyType != MaterialPropertyType::Texture || textures.count(prop.second.texture) == 0)
+			continue ;
+
+		uint32_t setBinding = GetDescriptorSetBinding(prop.first);
+		if (setBinding != -1u && _setTable.find(setBinding) != _setTable.end())
+			changedSets.insert(setBinding);
+	}
+
+	if (changedSets.empty())
+		return ;
+
+	// The properties of the released sets are written in newly allocated ones, the frame set is written when bound
+	ReleaseDescriptorSets(changedSets);
+	for (const auto & prop : _materialProperties)
+		if (changedSets.count(GetDescriptorSetBinding(prop.first)))
+			BindMaterialProperty(prop.first, prop.second);
+}
+
 void				Material::SetTexture(const std::string & bindingName, const Texture * texture, VkImageLayout imageLayout, VkDescriptorType descriptorType, bool silent)
 {
 	_materialProperties[bindingName] = MaterialProperty{
@@ -554,17 +867,42 @@ void				Material::SetPushConstant(VkCommandBuffer cmd, const std::string name, c
 	);
 }
 
-void				Material::BindPipeline(VkCommandBuffer cmd)
+void				Material::BindPipeline(VkCommandBuffer cmd, const RenderPass * renderPass, bool depthPrepassed)
 {
+	VkPipeline	pipeline = _pipeline;
+
+	if (renderPass == nullptr)
+		renderPass = _renderPass;
+
+	if (!IsCompute() && (depthPrepassed || renderPass->GetCompatibilityHash() != _renderPass->GetCompatibilityHash()))
+	{
+		// The prepassed pipelines share the map, their key is the complement of the hash of their pass
+		size_t	key = (depthPrepassed) ? ~renderPass->GetCompatibilityHash() : renderPass->GetCompatibilityHash();
+		auto	passPipeline = _passPipelines.find(key);
+
+		if (passPipeline == _passPipelines.end())
+		{
+			pipeline = CreateGraphicPipeline(renderPass, _program, _pipelineLayout, depthPrepassed);
+			Vk::SetPipelineDebugName(_program->GetName(), pipeline);
+			_passPipelines[key] = pipeline;
+		}
+		else
+			pipeline = passPipeline->second;
+	}
+
 	vkCmdBindPipeline(
 		cmd,
 		IsCompute() ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS,
-		_pipeline
+		pipeline
 	);
 }
 
 void				Material::BindProperties(VkCommandBuffer cmd)
 {
+	for (const auto & prop : _materialProperties)
+		if (prop.second.propertyType == MaterialPropertyType::Texture)
+			prop.second.texture->MarkUsed();
+
 	// Bind the material descriptor sets:
 	for (const auto & k : _setTable)
 	{
@@ -590,14 +928,10 @@ void				Material::BindFrameProperties(VkCommandBuffer cmd)
 		// Check if the frame uniformbuffer exists in the shader
 		if (k == LWGCBinding::Frame)
 		{
-			AllocateDescriptorSet(k);
-
-			const auto set = _setTable.at(_bindingTable->GetDescriptorSetBinding(k)).set;
-			const auto ub = rp->GetFrameUniformBuffer();
+			// The pipeline has one set per frame in flight, rewriting a set of the material would change the
+			// buffer of the frames still on the GPU
+			const auto set = rp->GetFrameDescriptorSet();
 
-			// Set the pointer to the buffer
-			SetBuffer(k, ub.buffer, sizeof(LWGC_PerFrame), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-			
 			vkCmdBindDescriptorSets(
 				cmd,
 				IsCompute() ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -615,7 +949,10 @@ void				Material::SetInputAssemblyState(VkPipelineInputAssemblyStateCreateInfo i
 void				Material::SetDepthStencilState(VkPipelineDepthStencilStateCreateInfo info) { _depthStencilState = info; }
 void				Material::SetRasterizationState(VkPipelineRasterizationStateCreateInfo info) { _rasterizationState = info; }
 void				Material::SetColorBlendState(VkPipelineColorBlendStateCreateInfo info) { _colorBlendState = info; }
+void				Material::SetAlbedo(const glm::vec4 & albedo) { _perMaterial.albedo = albedo; }
+glm::vec4			Material::GetAlbedo(void) const { return _perMaterial.albedo; }
 bool				Material::IsTransparent(void) const noexcept { return _colorBlendState.pAttachments != nullptr && _colorBlendState.pAttachments->blendEnable; }
+const VkPipelineDepthStencilStateCreateInfo &	Material::GetDepthStencilState(void) const noexcept { return _depthStencilState; }
 
 bool				Material::IsReady(void) const noexcept { return _isReady; }
 
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_set>
 
 #include "Core/Textures/Texture.hpp"
 #include "Core/Vulkan/UniformBuffer.hpp"
@@ -45,6 +46,8 @@ namespace LWGC
 			static const std::string	Camera;
 			static const std::string	Material;
 			static const std::string	Object;
+			static const std::string	Lights;
+			static const std::string	Shadows;
 	};
 
 	class SwapChain;
@@ -53,6 +56,7 @@ namespace LWGC
 	class		Material
 	{
 		friend class RenderPass; // For binding descriptor sets
+		friend class MaterialTable; // For the shader reloads
 
 		private:
 			struct	LWGC_PerMaterial
@@ -84,11 +88,31 @@ namespace LWGC
 				VkSampler				sampler;
 			};
 
+			// Pipeline objects of a shader program, created completely before they replace the ones of the material
+			struct	ProgramPipelines
+			{
+				ShaderProgram *		program;
+				VkPipelineLayout	layout;
+				VkPipeline			pipeline;
+			};
+
+			// Pipelines of a keyword variant used before, kept to switch back to it without creating them again
+			struct	KeywordVariant
+			{
+				ShaderProgram *								program;
+				VkPipelineLayout							layout;
+				VkPipeline									pipeline;
+				std::unordered_map< size_t, VkPipeline >	passPipelines;
+			};
+
 			using PropertiesTable = std::unordered_map< std::string, MaterialProperty >;
 			using SetTable = std::unordered_map< uint32_t, DescriptorSet >;
 
 			VkPipelineLayout						_pipelineLayout;
 			VkPipeline								_pipeline;
+			// Created when the material is used in a render pass not compatible with _renderPass, by compatibility hash,
+			// or after a depth prepass
+			std::unordered_map< size_t, VkPipeline >	_passPipelines;
 			LWGC_PerMaterial						_perMaterial;
 			UniformBuffer							_uniformPerMaterial;
 			std::vector< VkSampler >				_samplers;
@@ -98,7 +122,12 @@ namespace LWGC
 			SwapChain *								_swapChain;
 			RenderPass *							_renderPass;
 			ShaderProgram *							_program;
-			ShaderProgram *							_originalProgram;
+			ShaderProgram *							_originalProgram;	// The variant of _baseProgram for the enabled keywords
+			ShaderProgram *							_baseProgram;
+			KeywordMask								_keywordMask;
+			// Keywords of the pipelines in use, differs from _keywordMask while the new variant is compiled
+			KeywordMask								_activeKeywordMask;
+			std::unordered_map< KeywordMask, KeywordVariant >	_variantCache;
 			std::vector< VkDescriptorSetLayout >	_setLayouts;
 			const ShaderBindingTable *				_bindingTable;
 			SetTable								_setTable;
@@ -116,14 +145,31 @@ namespace LWGC
 			void		CreateTextureSampler(void);
 			void		CreateUniformBuffer(void);
 			void		CompileShaders(void);
-			void		CreateGraphicPipeline(void);
-			void		CreateComputePipeline(void);
+			// The original program compiled, or the error shader if it doesn't compile
+			ShaderProgram *		GetCompiledProgram(void);
+			VkPipelineLayout	CreatePipelineLayout(ShaderProgram * program);
+			VkPipeline	CreateGraphicPipeline(const RenderPass * renderPass, ShaderProgram * program, VkPipelineLayout layout, bool depthPrepassed = false);
+			VkPipeline	CreateComputePipeline(ShaderProgram * program, VkPipelineLayout layout);
+			// Throws without changing the material if a pipeline can't be created
+			ProgramPipelines	CreateProgramPipelines(ShaderProgram * program);
+			void		ApplyProgramPipelines(const ProgramPipelines & pipelines);
+			void		DestroyProgramPipelines(const ProgramPipelines & pipelines) noexcept;
+			// The pipelines and descriptor sets are destroyed once the frames in flight are done with them
+			void		ReleasePipelinesAndSets(void);
+			void		ReleaseDescriptorSets(void);
+			void		ReleaseDescriptorSets(const std::unordered_set< uint32_t > & setBindings);
+			// Switch to the pipelines of _keywordMask, returns false while its variant is compiled in the background
+			bool		UpdateKeywordVariant(void);
+			// Drop the cached variants built from the program (hot reload)
+			void		ReleaseCachedVariants(const ShaderProgram * program);
+			void		DestroyCachedVariants(void) noexcept;
 			void		SetupDefaultSettings(void);
 			bool		DescriptorSetExists(const std::string & bindingName, bool silent);
 			void		InitMaterialIfPossible(void);
 			void		AllocateDescriptorSet(const std::string & bindingName);
 			bool		IsInitialized(void) const;
 			void		BindMaterialProperties(void) noexcept;
+			void		BindMaterialProperty(const std::string & bindingName, const MaterialProperty & property) noexcept;
 
 		public:
 			Material(const Material &) = delete;
@@ -152,17 +198,35 @@ namespace LWGC
 			bool				IsReady(void) const noexcept;
 			bool				IsCompiled(void) const noexcept;
 			bool				IsTransparent(void) const noexcept;
+			const VkPipelineDepthStencilStateCreateInfo &	GetDepthStencilState(void) const noexcept;
 			void				BindProperties(VkCommandBuffer cmd);
 			void				BindFrameProperties(VkCommandBuffer cmd);
-			void				BindPipeline(VkCommandBuffer cmd);
+			// The graphic pipelines are created for the render pass of the pipeline, pass the render pass the material
+			// is used in when it can be another one (render targets): a compatible pipeline is created the first time.
+			// When a depth prepass already wrote the depth of the draw, the pipeline tests it with GREATER_OR_EQUAL
+			// without writing it, the vertex shader must compute the same position as the prepass
+			void				BindPipeline(VkCommandBuffer cmd, const RenderPass * renderPass = nullptr, bool depthPrepassed = false);
 			bool				IsPropertyBound(const std::string & propertyName);
 
-			void				ReloadShaders(void) noexcept;
+			void				ReloadShaders(void);
+
+			// Switch to the shader variant compiled with the keyword defined, the keyword must be declared by the shader
+			void				EnableKeyword(const std::string & keyword);
+			void				DisableKeyword(const std::string & keyword);
+			void				SetKeyword(const std::string & keyword, bool enabled);
+			bool				IsKeywordEnabled(const std::string & keyword);
+			KeywordMask			GetKeywordMask(void) const noexcept;
 
 			void				SetBuffer(const std::string & bindingName, VkBuffer buffer, size_t size, VkDescriptorType descriptorType, size_t offset = 0, bool silent = false);
 			void				SetTexture(const std::string & bindingName, const Texture * texture, VkImageLayout imageLayout, VkDescriptorType descriptorType, bool silent = false);
 			void				SetSampler(const std::string & bindingName, VkSampler sampler, bool silent = false);
 			void				SetTexelBuffer(const std::string & bindingName, VkBufferView bufferView, VkDescriptorType descriptorType, bool silent = false);
+			// Update the descriptors of the bound textures whose view changed (streaming): the sets may be bound by the
+			// frames in flight, so new sets are written and the old ones are freed once these frames are done
+			void				RebindTextures(const std::unordered_set< const Texture * > & textures);
+
+			void				SetAlbedo(const glm::vec4 & albedo);
+			glm::vec4			GetAlbedo(void) const;
 
 			void				SetPushConstant(VkCommandBuffer cmd, const std::string name, const void * value);
 
@@ -128,6 +128,7 @@ namespace LWGC
 				VK_BLEND_FACTOR_ZERO,
 				VK_BLEND_OP_ADD
 			);
+			inline static const VkPipelineColorBlendAttachmentState		noColorWriteAttachment = CreateColorBlendAttachmentState(VK_FALSE, 0);
 
 			// depth stencil states
 			inline static const VkPipelineDepthStencilStateCreateInfo	depthCompareWrite = CreateDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_GREATER);
@@ -137,6 +138,7 @@ namespace LWGC
 			inline static const VkPipelineColorBlendStateCreateInfo		noColorBlendState = CreateColorBlendState(1, &noBlendAttachment); // we need at least one attachment for OSX
 			inline static const VkPipelineColorBlendStateCreateInfo		defaultColorBlendState = CreateColorBlendState(1, &defaultBlendAttachment);
 			inline static const VkPipelineColorBlendStateCreateInfo		additiveColorBlendState = CreateColorBlendState(1, &additiveBlendAttachment);
+			inline static const VkPipelineColorBlendStateCreateInfo		noColorWriteState = CreateColorBlendState(1, &noColorWriteAttachment); // Depth only draws in a pass with color attachments
 
 			// input assembly states
 			inline static const VkPipelineInputAssemblyStateCreateInfo	triangleListState = CreateInputAssemblyState(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, false);
@@ -1,32 +1,36 @@
 #include "ProfilingSample.hpp"
 
 #include "Core/Vulkan/Vk.hpp"
-#include "Core/Time.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
 
 using namespace LWGC;
 
-std::string ProfilingSample::_hierarchy;
-
 ProfilingSample::ProfilingSample(VkCommandBuffer cmd, const std::string & debugSampleName, const Color & color) : ProfilingSample(debugSampleName)
 {
+	_cmd = cmd;
+	_gpuSample = GpuProfiler::BeginSample(cmd, _name);
 	Vk::BeginProfilingSample(cmd, debugSampleName, color);
 }
 
-ProfilingSample::ProfilingSample(const std::string & sampleName) : _cmd(VK_NULL_HANDLE), _sampleName(sampleName), _ended(false)
+ProfilingSample::ProfilingSample(VkCommandBuffer cmd, ProfilerNameId name) : ProfilingSample(name)
 {
-	struct timeval  tv;
-
-	gettimeofday(&tv, NULL);
-	_startTime = (double)tv.tv_usec / 1000.0 + (double)tv.tv_sec * 1000.0;
+	_cmd = cmd;
+	_gpuSample = GpuProfiler::BeginSample(cmd, _name);
+}
 
-	_timeFrameRelative = Time::GetFrameRelativeTime();
+ProfilingSample::ProfilingSample(const std::string & sampleName) : ProfilingSample(Profiler::InternName(sampleName))
+{
+}
 
-	_hierarchy += "/" + sampleName;
+ProfilingSample::ProfilingSample(ProfilerNameId name) : _cmd(VK_NULL_HANDLE), _name(name), _ended(false), _gpuSample(false)
+{
+	Profiler::BeginScope(_name);
 }
 
 void	ProfilingSample::Insert(const std::string & debugSampleName, const Color & color)
 {
-	Vk::InsertProfilingSample(_cmd, debugSampleName, color);
+	if (_cmd != VK_NULL_HANDLE)
+		Vk::InsertProfilingSample(_cmd, debugSampleName, color);
 }
 
 void	ProfilingSample::End(void)
@@ -34,16 +38,13 @@ void	ProfilingSample::End(void)
 	if (_ended)
 		return;
 
-	struct timeval  tv;
-
-	Vk::EndProfilingSample(_cmd);
-
-	gettimeofday(&tv, NULL);
-	double endTime = (double)tv.tv_usec / 1000.0 + (double)tv.tv_sec * 1000.0;
+	if (_cmd != VK_NULL_HANDLE)
+		Vk::EndProfilingSample(_cmd);
 
-	Profiler::AddSample(_hierarchy, endTime - _startTime, _timeFrameRelative);
+	if (_gpuSample)
+		GpuProfiler::EndSample(_cmd);
 
-	_hierarchy = _hierarchy.substr(0, _hierarchy.size() - _sampleName.size() - 1);
+	Profiler::EndScope(_name);
 
 	_ended = true;
 }
@@ -2,7 +2,6 @@
 
 #include <iostream>
 #include <string>
-#include <sys/time.h>
 
 #include "IncludeDeps.hpp"
 #include "Utils/Color.hpp"
@@ -12,21 +11,22 @@
 
 namespace LWGC
 {
+	// CPU profiler scope. With a command buffer, it's also inserted as a debug label and timed on the GPU
+	// by the GpuProfiler. Prefer LWGC_PROFILE_SCOPE for hot code: the string constructors intern the name at each call.
 	class		ProfilingSample
 	{
 		private:
 			VkCommandBuffer	_cmd;
-			double			_startTime;
-			std::string		_sampleName;
-			float			_timeFrameRelative;
+			ProfilerNameId	_name;
 			bool			_ended;
-
-			static std::string		_hierarchy;
+			bool			_gpuSample;
 
 		public:
 			ProfilingSample(void) = delete;
 			ProfilingSample(VkCommandBuffer cmd, const std::string & debugSampleName, const Color & color = Color::Blue);
+			ProfilingSample(VkCommandBuffer cmd, ProfilerNameId name);
 			ProfilingSample(const std::string & sampleName);
+			ProfilingSample(ProfilerNameId name);
 			ProfilingSample(const ProfilingSample &) = delete;
 			virtual ~ProfilingSample(void);
 
@@ -0,0 +1,667 @@
+#include "ReadbackManager.hpp"
+
+#include "Core/Vulkan/Vk.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include STB_INCLUDE_IMAGE_WRITE
+
+using namespace LWGC;
+
+ReadbackManager::ReadbackManager(void) : _device(VK_NULL_HANDLE), _memoryProperties(0), _rowPitchAlignment(1), _frameIndex(0), _frameCount(0)
+{
+}
+
+ReadbackManager::~ReadbackManager(void)
+{
+	Release();
+}
+
+// Size of a texel in the buffer of a copy, 0 if the format isn't supported
+static uint32_t		GetTexelSize(VkFormat format, VkImageAspectFlags aspect) noexcept
+{
+	if (aspect == VK_IMAGE_ASPECT_STENCIL_BIT)
+		return 1;
+
+	switch (format)
+	{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8_SRGB:
+		case VK_FORMAT_R8_UINT:
+			return 1;
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R8G8_SRGB:
+		case VK_FORMAT_R16_SFLOAT:
+		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16_UINT:
+		case VK_FORMAT_D16_UNORM:
+			return 2;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+		case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+		case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R32_SFLOAT:
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_D32_SFLOAT:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+static bool			GetEncodingLayout(VkFormat format, ReadbackEncoding encoding, int & channels, int & channelSize) noexcept
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8_SRGB:
+			channels = 1; channelSize = 1; break ;
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R8G8_SRGB:
+			channels = 2; channelSize = 1; break ;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			channels = 4; channelSize = 1; break ;
+		case VK_FORMAT_R16_SFLOAT:
+			channels = 1; channelSize = 2; break ;
+		case VK_FORMAT_R16G16_SFLOAT:
+			channels = 2; channelSize = 2; break ;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			channels = 4; channelSize = 2; break ;
+		case VK_FORMAT_R32_SFLOAT:
+		case VK_FORMAT_D32_SFLOAT:
+			channels = 1; channelSize = 4; break ;
+		case VK_FORMAT_R32G32_SFLOAT:
+			channels = 2; channelSize = 4; break ;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			channels = 4; channelSize = 4; break ;
+		default:
+			return false;
+	}
+
+	// PNG only stores 8 bit channels, and EXR half and float channels
+	return (encoding == ReadbackEncoding::PNG) == (channelSize == 1);
+}
+
+static void			AppendToVector(void * context, void * data, int size)
+{
+	auto	out = static_cast< std::vector< uint8_t > * >(context);
+
+	out->insert(out->end(), static_cast< uint8_t * >(data), static_cast< uint8_t * >(data) + size);
+}
+
+static std::vector< uint8_t >	EncodePNG(const ReadbackResult & result, int channels)
+{
+	std::vector< uint8_t >	encoded;
+	std::vector< uint8_t >	swizzled;
+	const uint8_t *			data = result.data.data();
+	size_t					rowPitch = result.rowPitch;
+
+	if (result.format == VK_FORMAT_B8G8R8A8_UNORM || result.format == VK_FORMAT_B8G8R8A8_SRGB)
+	{
+		swizzled.resize(static_cast< size_t >(result.width) * result.height * 4);
+		for (uint32_t y = 0; y < result.height; y++)
+			for (uint32_t x = 0; x < result.width; x++)
+			{
+				const uint8_t *	src = data + y * rowPitch + x * 4;
+				uint8_t *		dst = swizzled.data() + (static_cast< size_t >(y) * result.width + x) * 4;
+
+				dst[0] = src[2];
+				dst[1] = src[1];
+				dst[2] = src[0];
+				dst[3] = src[3];
+			}
+		data = swizzled.data();
+		rowPitch = result.width * 4;
+	}
+
+	if (!stbi_write_png_to_func(AppendToVector, &encoded, result.width, result.height, channels, data, static_cast< int >(rowPitch)))
+		throw std::runtime_error("Failed to encode the readback as PNG");
+
+	return encoded;
+}
+
+template< typename T >
+static void			AppendValue(std::vector< uint8_t > & out, T value)
+{
+	// EXR is little endian, like all the platforms supported
+	out.insert(out.end(), reinterpret_cast< uint8_t * >(&value), reinterpret_cast< uint8_t * >(&value) + sizeof(T));
+}
+
+static void			AppendAttribute(std::vector< uint8_t > & out, const std::string & name, const std::string & type, const std::vector< uint8_t > & value)
+{
+	out.insert(out.end(), name.c_str(), name.c_str() + name.size() + 1);
+	out.insert(out.end(), type.c_str(), type.c_str() + type.size() + 1);
+	AppendValue< int32_t >(out, static_cast< int32_t >(value.size()));
+	out.insert(out.end(), value.begin(), value.end());
+}
+
+// Scanline EXR without compression, one line per block
+static std::vector< uint8_t >	EncodeEXR(const ReadbackResult & result, int channels, int channelSize)
+{
+	static const char *		channelNames[] = {"R", "G", "B", "A"};
+	std::vector< uint8_t >	out;
+	std::vector< uint8_t >	value;
+	std::vector< int >		order;
+	int32_t					lineSize = static_cast< int32_t >(result.width) * channels * channelSize;
+
+	AppendValue< uint32_t >(out, 20000630);	// Magic number
+	AppendValue< uint32_t >(out, 2);		// Version, single part scanline file
+
+	// The channels are sorted by name
+	for (int c = channels - 1; c >= 0; c--)
+		order.push_back(c);
+	std::sort(order.begin(), order.end(), [](int a, int b) { return std::strcmp(channelNames[a], channelNames[b]) < 0; });
+
+	for (int c : order)
+	{
+		value.push_back(channelNames[c][0]);
+		value.push_back(0);
+		AppendValue< int32_t >(value, (channelSize == 2) ? 1 : 2);	// HALF or FLOAT
+		AppendValue< uint32_t >(value, 0);							// pLinear and reserved
+		AppendValue< int32_t >(value, 1);
+		AppendValue< int32_t >(value, 1);
+	}
+	value.push_back(0);
+	AppendAttribute(out, "channels", "chlist", value);
+
+	AppendAttribute(out, "compression", "compression", {0});
+
+	value.clear();
+	AppendValue< int32_t >(value, 0);
+	AppendValue< int32_t >(value, 0);
+	AppendValue< int32_t >(value, static_cast< int32_t >(result.width) - 1);
+	AppendValue< int32_t >(value, static_cast< int32_t >(result.height) - 1);
+	AppendAttribute(out, "dataWindow", "box2i", value);
+	AppendAttribute(out, "displayWindow", "box2i", value);
+
+	AppendAttribute(out, "lineOrder", "lineOrder", {0});
+
+	value.clear();
+	AppendValue< float >(value, 1.0f);
+	AppendAttribute(out, "pixelAspectRatio", "float", value);
+	AppendAttribute(out, "screenWindowWidth", "float", value);
+
+	value.clear();
+	AppendValue< float >(value, 0.0f);
+	AppendValue< float >(value, 0.0f);
+	AppendAttribute(out, "screenWindowCenter", "v2f", value);
+
+	out.push_back(0);
+
+	size_t	offsetTable = out.size();
+	out.resize(out.size() + result.height * sizeof(uint64_t));
+
+	for (uint32_t y = 0; y < result.height; y++)
+	{
+		uint64_t		offset = out.size();
+		const uint8_t *	line = result.data.data() + y * result.rowPitch;
+
+		std::memcpy(out.data() + offsetTable + y * sizeof(uint64_t), &offset, sizeof(uint64_t));
+		AppendValue< int32_t >(out, static_cast< int32_t >(y));
+		AppendValue< int32_t >(out, lineSize);
+
+		// The pixels of a line are stored channel by channel
+		for (int c : order)
+			for (uint32_t x = 0; x < result.width; x++)
+				out.insert(out.end(), line + (x * channels + c) * channelSize, line + (x * channels + c + 1) * channelSize);
+	}
+
+	return out;
+}
+
+void			ReadbackManager::Initialize(size_t frameCount)
+{
+	VulkanInstance * instance = VulkanInstance::Get();
+
+	_device = instance->GetDevice();
+	_rowPitchAlignment = std::max< VkDeviceSize >(1, instance->GetLimits().optimalBufferCopyRowPitchAlignment);
+	_inFlight.resize(frameCount);
+	_frameIndex = 0;
+
+	// Cached memory is a lot faster to read from the CPU, but it's not available on all the devices.
+	// The memory types are probed with the requirements of a real readback buffer
+	VkBuffer				probe;
+	VkBufferCreateInfo		bufferInfo = {};
+	VkMemoryRequirements	requirements;
+
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = MinBufferSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	Vk::CheckResult(vkCreateBuffer(_device, &bufferInfo, nullptr, &probe), "Failed to create readback probe buffer");
+	vkGetBufferMemoryRequirements(_device, probe, &requirements);
+	vkDestroyBuffer(_device, probe, nullptr);
+
+	_memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	try {
+		instance->FindMemoryType(requirements.memoryTypeBits, _memoryProperties);
+	} catch (const std::runtime_error &) {
+		_memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	_worker = std::make_unique< ThreadPool >(1);
+}
+
+void			ReadbackManager::Release(void) noexcept
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	vkDeviceWaitIdle(_device);
+
+	// The copies of the current frame may have been recorded in a command buffer that was never submitted
+	for (size_t i = 0; i < _inFlight.size(); i++)
+		for (auto & request : _inFlight[i])
+		{
+			if (i == _frameIndex)
+			{
+				Fail(request, "The readback was released before its frame was submitted");
+				continue ;
+			}
+
+			try {
+				Resolve(request);
+			} catch (const std::exception & e) {
+				Fail(request, std::string("Failed to resolve the readback: ") + e.what());
+			}
+		}
+	_inFlight.clear();
+
+	for (auto & request : _queued)
+		Fail(request, "The readback was released before its copy was recorded");
+	_queued.clear();
+
+	// Finishes the jobs, they give their buffers back
+	_worker.reset();
+
+	for (auto & staging : _freeBuffers)
+		DestroyBuffer(staging);
+	for (auto & staging : _returnedBuffers)
+		DestroyBuffer(staging);
+	_freeBuffers.clear();
+	_returnedBuffers.clear();
+	_device = VK_NULL_HANDLE;
+}
+
+bool			ReadbackManager::IsInitialized(void) const noexcept { return _device != VK_NULL_HANDLE; }
+
+ReadbackManager::StagingBuffer	ReadbackManager::AcquireBuffer(VkDeviceSize size)
+{
+	auto	best = _freeBuffers.end();
+
+	// Smallest free buffer that fits, without taking a big one for a small readback
+	for (auto it = _freeBuffers.begin(); it != _freeBuffers.end(); ++it)
+		if (it->size >= size && it->size <= std::max< VkDeviceSize >(size * 4, +MinBufferSize) && (best == _freeBuffers.end() || it->size < best->size))
+			best = it;
+
+	if (best != _freeBuffers.end())
+	{
+		StagingBuffer	staging = *best;
+
+		_freeBuffers.erase(best);
+		return staging;
+	}
+
+	StagingBuffer	staging = {};
+
+	// Power of two sizes, so readbacks of similar sizes reuse the same buffers
+	staging.size = MinBufferSize;
+	while (staging.size < size)
+		staging.size *= 2;
+
+	Vk::CreateBuffer(staging.size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, _memoryProperties, staging.buffer, staging.memory);
+	Vk::SetBufferDebugName("Readback buffer", staging.buffer);
+	Vk::CheckResult(vkMapMemory(_device, staging.memory, 0, staging.size, 0, reinterpret_cast< void ** >(&staging.mappedData)), "Failed to map readback memory");
+
+	return staging;
+}
+
+void			ReadbackManager::DestroyBuffer(StagingBuffer & staging) noexcept
+{
+	vkUnmapMemory(_device, staging.memory);
+	vkDestroyBuffer(_device, staging.buffer, nullptr);
+	vkFreeMemory(_device, staging.memory, nullptr);
+}
+
+void			ReadbackManager::RecycleBuffers(void) noexcept
+{
+	{
+		std::lock_guard< std::mutex >	lock(_returnedMutex);
+
+		for (auto & staging : _returnedBuffers)
+		{
+			staging.lastUsedFrame = _frameCount;
+			_freeBuffers.push_back(staging);
+		}
+		_returnedBuffers.clear();
+	}
+
+	// The buffers of occasional readbacks like screenshots don't stay allocated
+	auto	unused = std::remove_if(_freeBuffers.begin(), _freeBuffers.end(), [this](StagingBuffer & staging)
+	{
+		if (_frameCount - staging.lastUsedFrame <= MaxUnusedFrames)
+			return false;
+		DestroyBuffer(staging);
+		return true;
+	});
+	_freeBuffers.erase(unused, _freeBuffers.end());
+}
+
+ReadbackManager::Request	ReadbackManager::CreateImageRequest(const ReadbackImageRequest & image)
+{
+	Request	request = {};
+	int		channels;
+	int		channelSize;
+
+	if (image.image == VK_NULL_HANDLE || image.width == 0 || image.height == 0)
+		throw std::runtime_error("Invalid readback image");
+	if (image.layout == VK_IMAGE_LAYOUT_UNDEFINED)
+		throw std::runtime_error("The content of an image in the undefined layout can't be read back");
+
+	request.texelSize = GetTexelSize(image.format, image.aspect);
+	if (request.texelSize == 0)
+		throw std::runtime_error("Unsupported readback format: " + std::to_string(image.format));
+	if (image.encoding != ReadbackEncoding::None && !GetEncodingLayout(image.format, image.encoding, channels, channelSize))
+		throw std::runtime_error("Can't encode the format " + std::to_string(image.format) + ((image.encoding == ReadbackEncoding::PNG) ? " as PNG" : " as EXR"));
+
+	// The alignment and the texel sizes are powers of two, the row length stays a whole number of texels
+	VkDeviceSize	alignment = std::max< VkDeviceSize >(_rowPitchAlignment, request.texelSize);
+
+	request.image = image;
+	request.isImage = true;
+	request.rowPitch = (static_cast< VkDeviceSize >(image.width) * request.texelSize + alignment - 1) / alignment * alignment;
+	request.size = request.rowPitch * image.height;
+	request.frame = _frameCount;
+	request.staging = AcquireBuffer(request.size);
+	request.promise = std::make_shared< std::promise< ReadbackResult > >();
+
+	return request;
+}
+
+ReadbackManager::Request	ReadbackManager::CreateBufferRequest(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	Request	request = {};
+
+	if (buffer == VK_NULL_HANDLE || size == 0)
+		throw std::runtime_error("Invalid readback buffer");
+
+	request.isImage = false;
+	request.buffer = buffer;
+	request.offset = offset;
+	request.size = size;
+	request.rowPitch = size;
+	request.frame = _frameCount;
+	request.staging = AcquireBuffer(request.size);
+	request.promise = std::make_shared< std::promise< ReadbackResult > >();
+
+	return request;
+}
+
+void			ReadbackManager::RecordCopy(VkCommandBuffer cmd, Request & request)
+{
+	if (request.isImage)
+	{
+		const auto &			image = request.image;
+		VkImageMemoryBarrier	barrier = {};
+
+		// The passes that wrote the image aren't known, the copy waits for all the writes
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = image.layout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.image;
+		barrier.subresourceRange = {image.aspect, image.mipLevel, 1, image.arrayLayer, 1};
+
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy	region = {};
+		region.bufferRowLength = static_cast< uint32_t >(request.rowPitch / request.texelSize);
+		region.imageSubresource = {image.aspect, image.mipLevel, image.arrayLayer, 1};
+		region.imageExtent = {image.width, image.height, 1};
+
+		vkCmdCopyImageToBuffer(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, request.staging.buffer, 1, &region);
+
+		if (image.layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+		{
+			VkPipelineStageFlags	stages;
+			VkAccessFlags			access;
+
+			Vk::GetLayoutStagesAndAccess(image.layout, stages, access);
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = access;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = image.layout;
+
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+	}
+	else
+	{
+		VkMemoryBarrier	barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy	region = {request.offset, 0, request.size};
+		vkCmdCopyBuffer(cmd, request.buffer, request.staging.buffer, 1, &region);
+	}
+
+	// The fence alone doesn't make the writes of the copy visible to the host
+	VkBufferMemoryBarrier	hostBarrier = {};
+	hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hostBarrier.buffer = request.staging.buffer;
+	hostBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+}
+
+void			ReadbackManager::Resolve(Request & request)
+{
+	_worker->Enqueue([this, request]()
+	{
+		const ReadbackImageRequest &	image = request.image;
+		ReadbackResult					result = {};
+		std::exception_ptr				error;
+
+		try {
+			result.frame = request.frame;
+			if (request.isImage)
+			{
+				size_t	rowSize = static_cast< size_t >(image.width) * request.texelSize;
+
+				result.width = image.width;
+				result.height = image.height;
+				result.format = image.format;
+				result.rowPitch = (image.tightRows) ? rowSize : request.rowPitch;
+				result.data.resize(result.rowPitch * image.height);
+
+				if (result.rowPitch == request.rowPitch)
+					std::memcpy(result.data.data(), request.staging.mappedData, result.data.size());
+				else
+					for (uint32_t y = 0; y < image.height; y++)
+						std::memcpy(result.data.data() + y * result.rowPitch, request.staging.mappedData + y * request.rowPitch, rowSize);
+			}
+			else
+			{
+				result.width = static_cast< uint32_t >(request.size);
+				result.height = 1;
+				result.format = VK_FORMAT_UNDEFINED;
+				result.rowPitch = request.size;
+				result.data.assign(request.staging.mappedData, request.staging.mappedData + request.size);
+			}
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		// The data was copied out, the buffer can be used by another readback
+		{
+			std::lock_guard< std::mutex >	lock(_returnedMutex);
+			_returnedBuffers.push_back(request.staging);
+		}
+
+		if (error)
+		{
+			request.promise->set_exception(error);
+			return ;
+		}
+
+		try {
+			int		channels;
+			int		channelSize;
+
+			if (request.isImage && image.encoding != ReadbackEncoding::None)
+			{
+				GetEncodingLayout(image.format, image.encoding, channels, channelSize);
+				result.encoded = (image.encoding == ReadbackEncoding::PNG) ? EncodePNG(result, channels) : EncodeEXR(result, channels, channelSize);
+
+				if (!image.path.empty())
+				{
+					std::ofstream	file(image.path, std::ios::binary);
+
+					if (!file.write(reinterpret_cast< const char * >(result.encoded.data()), result.encoded.size()))
+						throw std::runtime_error("Can't write the readback to " + image.path);
+				}
+			}
+			request.promise->set_value(std::move(result));
+		} catch (...) {
+			request.promise->set_exception(std::current_exception());
+		}
+	});
+}
+
+void			ReadbackManager::Fail(Request & request, const std::string & message) noexcept
+{
+	try {
+		request.promise->set_exception(std::make_exception_ptr(std::runtime_error(message)));
+	} catch (...) {
+		// The promise was already satisfied, nothing else can be reported
+	}
+	DestroyBuffer(request.staging);
+}
+
+std::future< ReadbackResult >	ReadbackManager::ReadImage(const ReadbackImageRequest & image)
+{
+	Request	request = CreateImageRequest(image);
+	auto	future = request.promise->get_future();
+
+	_queued.push_back(request);
+	return future;
+}
+
+std::future< ReadbackResult >	ReadbackManager::ReadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	Request	request = CreateBufferRequest(buffer, offset, size);
+	auto	future = request.promise->get_future();
+
+	_queued.push_back(request);
+	return future;
+}
+
+std::future< ReadbackResult >	ReadbackManager::ReadImage(VkCommandBuffer cmd, const ReadbackImageRequest & image)
+{
+	Request	request = CreateImageRequest(image);
+	auto	future = request.promise->get_future();
+
+	RecordCopy(cmd, request);
+	_inFlight[_frameIndex].push_back(request);
+	return future;
+}
+
+std::future< ReadbackResult >	ReadbackManager::ReadBuffer(VkCommandBuffer cmd, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	Request	request = CreateBufferRequest(buffer, offset, size);
+	auto	future = request.promise->get_future();
+
+	RecordCopy(cmd, request);
+	_inFlight[_frameIndex].push_back(request);
+	return future;
+}
+
+void			ReadbackManager::BeginFrame(size_t frameIndex)
+{
+	_frameIndex = frameIndex;
+	_frameCount++;
+
+	for (auto & request : _inFlight[_frameIndex])
+		Resolve(request);
+	_inFlight[_frameIndex].clear();
+
+	RecycleBuffers();
+}
+
+bool			ReadbackManager::HasQueuedCopies(void) const noexcept { return !_queued.empty(); }
+
+void			ReadbackManager::RecordQueuedCopies(VkCommandBuffer cmd)
+{
+	for (auto & request : _queued)
+	{
+		RecordCopy(cmd, request);
+		_inFlight[_frameIndex].push_back(request);
+	}
+	_queued.clear();
+}
+
+void			ReadbackManager::Flush(void)
+{
+	if (_device == VK_NULL_HANDLE)
+		return ;
+
+	vkDeviceWaitIdle(_device);
+
+	// From the oldest frame to the last one submitted
+	for (size_t i = 1; i <= _inFlight.size(); i++)
+	{
+		auto &	requests = _inFlight[(_frameIndex + i) % _inFlight.size()];
+
+		for (auto & request : requests)
+			Resolve(request);
+		requests.clear();
+	}
+
+	_worker->WaitIdle();
+	RecycleBuffers();
+}
+
+size_t			ReadbackManager::GetPendingCount(void) const noexcept
+{
+	size_t	count = _queued.size();
+
+	for (const auto & requests : _inFlight)
+		count += requests.size();
+	return count;
+}
+
+size_t			ReadbackManager::GetPooledBufferCount(void) const noexcept { return _freeBuffers.size(); }
+
+std::ostream &	LWGC::operator<<(std::ostream & o, ReadbackManager const & r)
+{
+	o << "ReadbackManager with " << r.GetPendingCount() << " pending readbacks" << std::endl;
+	return (o);
+}
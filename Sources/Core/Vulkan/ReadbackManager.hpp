@@ -0,0 +1,142 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+#include "IncludeDeps.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	enum class	ReadbackEncoding
+	{
+		None,
+		PNG,	// 8 bit formats with 1, 2 or 4 channels
+		EXR,	// 16 and 32 bit float formats, without compression
+	};
+
+	struct	ReadbackImageRequest
+	{
+		VkImage				image = VK_NULL_HANDLE;
+		// Layout of the image when the copy executes, the image is put back in this layout after the copy
+		VkImageLayout		layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkFormat			format = VK_FORMAT_UNDEFINED;
+		uint32_t			width = 0;
+		uint32_t			height = 0;
+		VkImageAspectFlags	aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		uint32_t			mipLevel = 0;
+		uint32_t			arrayLayer = 0;
+		// The copy uses the row pitch alignment preferred by the device, the padding is removed on the worker
+		bool				tightRows = true;
+		ReadbackEncoding	encoding = ReadbackEncoding::None;
+		// The encoded image is also written to this file when it's not empty
+		std::string			path;
+	};
+
+	struct	ReadbackResult
+	{
+		uint32_t				width;		// Size in bytes for a buffer
+		uint32_t				height;		// 1 for a buffer
+		VkFormat				format;		// VK_FORMAT_UNDEFINED for a buffer
+		size_t					rowPitch;	// Bytes between two rows of data
+		uint64_t				frame;		// Frame in which the copy was recorded
+		std::vector< uint8_t >	data;
+		std::vector< uint8_t >	encoded;	// Content of the PNG or EXR file
+	};
+
+	// Copies images and buffers to pooled host visible buffers in the command buffers of a frame, and resolves
+	// the futures when the frame slot comes back, after the wait on its fence: nothing waits for the queue.
+	// The copy out of the mapped memory, the row pitch conversion and the encoding run on a worker thread,
+	// errors are reported through the futures.
+	class		ReadbackManager
+	{
+		private:
+			struct	StagingBuffer
+			{
+				VkBuffer		buffer;
+				VkDeviceMemory	memory;
+				VkDeviceSize	size;
+				uint8_t *		mappedData;
+				uint64_t		lastUsedFrame;
+			};
+
+			struct	Request
+			{
+				ReadbackImageRequest	image;
+				bool					isImage;
+				VkBuffer				buffer;
+				VkDeviceSize			offset;
+				VkDeviceSize			size;
+				size_t					rowPitch;	// In the staging buffer
+				uint32_t				texelSize;
+				uint64_t				frame;
+				StagingBuffer			staging;
+				std::shared_ptr< std::promise< ReadbackResult > >	promise;
+			};
+
+			VkDevice								_device;
+			VkMemoryPropertyFlags					_memoryProperties;
+			VkDeviceSize							_rowPitchAlignment;
+			std::vector< StagingBuffer >			_freeBuffers;
+			std::mutex								_returnedMutex;
+			std::vector< StagingBuffer >			_returnedBuffers;	// Given back by the worker, reused next frame
+			std::vector< Request >					_queued;			// Recorded at the end of the frame
+			std::vector< std::vector< Request > >	_inFlight;			// Per frame in flight
+			size_t									_frameIndex;
+			uint64_t								_frameCount;
+			std::unique_ptr< ThreadPool >			_worker;
+
+			StagingBuffer	AcquireBuffer(VkDeviceSize size);
+			void			DestroyBuffer(StagingBuffer & staging) noexcept;
+			void			RecycleBuffers(void) noexcept;
+			Request			CreateImageRequest(const ReadbackImageRequest & image);
+			Request			CreateBufferRequest(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+			void			RecordCopy(VkCommandBuffer cmd, Request & request);
+			void			Resolve(Request & request);
+			void			Fail(Request & request, const std::string & message) noexcept;
+
+		public:
+			// Free staging buffers that weren't used for this many frames are destroyed
+			static const uint64_t		MaxUnusedFrames = 120;
+			// Smaller readbacks share buffers of this size in the pool
+			static const VkDeviceSize	MinBufferSize = 64 * 1024;
+
+			ReadbackManager(void);
+			ReadbackManager(const ReadbackManager &) = delete;
+			virtual ~ReadbackManager(void);
+
+			ReadbackManager &	operator=(ReadbackManager const & src) = delete;
+
+			void		Initialize(size_t frameCount);
+			// Waits for the device and resolves the readbacks of the previous frames. The ones never recorded and the
+			// ones recorded in the current frame, which may not have been submitted, get an exception: Flush first to get them
+			void		Release(void) noexcept;
+			bool		IsInitialized(void) const noexcept;
+
+			// Recorded at the end of the frame, after all the passes of the pipeline
+			std::future< ReadbackResult >	ReadImage(const ReadbackImageRequest & request);
+			std::future< ReadbackResult >	ReadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+			// Recorded now in cmd, it must be submitted with the current frame
+			std::future< ReadbackResult >	ReadImage(VkCommandBuffer cmd, const ReadbackImageRequest & request);
+			std::future< ReadbackResult >	ReadBuffer(VkCommandBuffer cmd, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+			// The fence of the frame slot is signaled: resolves its readbacks and starts recording a new frame
+			void		BeginFrame(size_t frameIndex);
+			bool		HasQueuedCopies(void) const noexcept;
+			void		RecordQueuedCopies(VkCommandBuffer cmd);
+			// Waits for the device, resolves all the submitted readbacks and waits for the worker. Call it between frames
+			void		Flush(void);
+
+			size_t		GetPendingCount(void) const noexcept;
+			size_t		GetPooledBufferCount(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ReadbackManager const & r);
+}
@@ -1,14 +1,24 @@
 #include "RenderPass.hpp"
 
+#include <algorithm>
+
 #include "Core/Vulkan/Material.hpp"
 #include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
 
 using namespace LWGC;
 
-RenderPass::RenderPass(void) : _instance(nullptr), _currentMaterial(nullptr)
+static void	HashCombine(size_t & hash, size_t value) noexcept
+{
+	hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+RenderPass::RenderPass(void) : _instance(nullptr), _hasDepth(false), _compatibilityHash(0), _currentMaterial(nullptr),
+	_clearColor(Color::Black), _clearDepth(0.0f), _clearStencil(0), _swapChain(nullptr), _gpuSample(false)
 {
 	this->_renderPass = VK_NULL_HANDLE;
 	this->_attachmentCount = 0;
+	this->_viewCount = 1;
 }
 
 RenderPass::~RenderPass(void)
@@ -32,6 +42,7 @@ void		RenderPass::AddAttachment(const VkAttachmentDescription & attachment, VkIm
 void		RenderPass::SetDepthAttachment(const VkAttachmentDescription & attachment, VkImageLayout layout) noexcept
 {
 	_depthAttachmentRef = {_attachmentCount++, layout};
+	_hasDepth = true;
 	_attachments.push_back(attachment);
 }
 
@@ -40,7 +51,11 @@ void		RenderPass::Cleanup(void) noexcept
 	if (_renderPass != VK_NULL_HANDLE)
 		vkDestroyRenderPass(_instance->GetDevice(), _renderPass, nullptr);
 
+	_renderPass = VK_NULL_HANDLE;
+	_hasDepth = false;
+	_compatibilityHash = 0;
 	_attachmentCount = 0;
+	_viewCount = 1;
 	_attachments.clear();
 	_references.clear();
 	_dependencies.clear();
@@ -51,6 +66,14 @@ void		RenderPass::AddDependency(const VkSubpassDependency & dependency) noexcept
 	_dependencies.push_back(dependency);
 }
 
+void		RenderPass::SetViewCount(uint32_t viewCount)
+{
+	if (viewCount == 0 || viewCount > _instance->GetMaxMultiviewViewCount())
+		throw std::runtime_error("Unsupported render pass view count: " + std::to_string(viewCount));
+
+	_viewCount = viewCount;
+}
+
 void		RenderPass::Create(bool computeOnly)
 {
 	if (computeOnly)
@@ -63,7 +86,7 @@ void		RenderPass::Create(bool computeOnly)
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpass.colorAttachmentCount = _references.size();
 	subpass.pColorAttachments = _references.data();
-	subpass.pDepthStencilAttachment = &_depthAttachmentRef;
+	subpass.pDepthStencilAttachment = (_hasDepth) ? &_depthAttachmentRef : nullptr;
 
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -74,9 +97,32 @@ void		RenderPass::Create(bool computeOnly)
 	renderPassInfo.dependencyCount = _dependencies.size();
 	renderPassInfo.pDependencies = _dependencies.data();
 
+	// All the views are rendered by the subpass, and are close enough for the implementation to share work
+	uint32_t viewMask = (1u << _viewCount) - 1;
+	VkRenderPassMultiviewCreateInfo multiviewInfo = {};
+	multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+	multiviewInfo.subpassCount = 1;
+	multiviewInfo.pViewMasks = &viewMask;
+	multiviewInfo.correlationMaskCount = 1;
+	multiviewInfo.pCorrelationMasks = &viewMask;
+	if (_viewCount > 1)
+		renderPassInfo.pNext = &multiviewInfo;
+
 	auto device = _instance->GetDevice();
 	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS)
 		throw std::runtime_error("failed to create render pass!");
+
+	// Only the formats and sample counts of the attachments, and the views matter for the compatibility of the pipelines
+	_compatibilityHash = _references.size();
+	HashCombine(_compatibilityHash, _viewCount);
+	HashCombine(_compatibilityHash, _hasDepth ? _depthAttachmentRef.attachment + 1 : 0);
+	for (const auto & attachment : _attachments)
+	{
+		HashCombine(_compatibilityHash, static_cast< size_t >(attachment.format));
+		HashCombine(_compatibilityHash, static_cast< size_t >(attachment.samples));
+	}
+
+	UpdateClearValues();
 }
 
 bool	RenderPass::BindDescriptorSet(const std::string & name, VkDescriptorSet set)
@@ -114,6 +160,11 @@ void	RenderPass::BindMaterial(Material * material)
 }
 
 void	RenderPass::Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const std::string & passName)
+{
+	Begin(commandBuffer, framebuffer, (_swapChain != nullptr) ? _swapChain->GetExtent() : VkExtent2D{0, 0}, passName);
+}
+
+void	RenderPass::Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent, const std::string & passName)
 {
 	_commandBuffer = commandBuffer;
 	_framebuffer = framebuffer;
@@ -123,6 +174,9 @@ void	RenderPass::Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer,
 		Vk::BeginProfilingSample(_commandBuffer, passName, Color::Cyan);
 	}
 
+	// Timed on the GPU including the load and store of the attachments
+	_gpuSample = GpuProfiler::BeginSample(_commandBuffer, Profiler::InternName(passName));
+
 	// If there is no framebuffer to bind, it means we're in a compute shader pass
 	if (framebuffer != VK_NULL_HANDLE)
 	{
@@ -131,11 +185,19 @@ void	RenderPass::Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer,
 		renderPassInfo.renderPass = _renderPass;
 		renderPassInfo.framebuffer = framebuffer;
 		renderPassInfo.renderArea.offset = {0, 0};
-		renderPassInfo.renderArea.extent = _swapChain->GetExtent();
+		renderPassInfo.renderArea.extent = extent;
 		renderPassInfo.clearValueCount = _clearValues.size();
 		renderPassInfo.pClearValues = _clearValues.data();
 
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = {};
+		viewport.width = static_cast< float >(extent.width);
+		viewport.height = static_cast< float >(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &renderPassInfo.renderArea);
 	}
 }
 
@@ -150,6 +212,41 @@ void	RenderPass::End(void)
 	{
 		vkCmdEndRenderPass(_commandBuffer);
 	}
+
+	if (_gpuSample)
+		GpuProfiler::EndSample(_commandBuffer);
+	_gpuSample = false;
+}
+
+void	RenderPass::SetViewport(const VkRect2D & rect)
+{
+	VkViewport viewport = {};
+	viewport.x = static_cast< float >(rect.offset.x);
+	viewport.y = static_cast< float >(rect.offset.y);
+	viewport.width = static_cast< float >(rect.extent.width);
+	viewport.height = static_cast< float >(rect.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(_commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(_commandBuffer, 0, 1, &rect);
+}
+
+void	RenderPass::ClearDepth(const VkRect2D & rect)
+{
+	if (!_hasDepth)
+		return ;
+
+	VkClearAttachment clear = {};
+	clear.aspectMask = Vk::GetImageAspect(_attachments[_depthAttachmentRef.attachment].format);
+	clear.clearValue.depthStencil = {_clearDepth, _clearStencil};
+
+	// With multiview the layer 0 stands for all the views of the pass
+	VkClearRect clearRect = {};
+	clearRect.rect = rect;
+	clearRect.baseArrayLayer = 0;
+	clearRect.layerCount = 1;
+
+	vkCmdClearAttachments(_commandBuffer, 1, &clear, 1, &clearRect);
 }
 
 void	RenderPass::UpdateDescriptorBindings(void)
@@ -181,33 +278,54 @@ void	RenderPass::ClearBindings(void)
 	_currentBindings.clear();
 }
 
+bool	RenderPass::HasBinding(const std::string & name) const noexcept
+{
+	return _currentBindings.find(name) != _currentBindings.end();
+}
+
 void	RenderPass::SetClearColor(const Color & color, float depth, uint32_t stencil)
 {
-	_clearValues.resize(2);
-	_clearValues[0].color = {{color.r, color.g, color.b, color.a}};
-	_clearValues[1].depthStencil = {depth, stencil};
+	_clearColor = color;
+	_clearDepth = depth;
+	_clearStencil = stencil;
+	UpdateClearValues();
+}
+
+// One clear value per attachment, before the attachments are added the depth is expected in the second one
+void	RenderPass::UpdateClearValues(void)
+{
+	size_t	depthIndex = (_hasDepth) ? _depthAttachmentRef.attachment : 1;
+
+	_clearValues.resize(std::max< size_t >(_attachments.size(), 2));
+	for (size_t i = 0; i < _clearValues.size(); i++)
+	{
+		if (i == depthIndex && (_hasDepth || _attachments.empty()))
+			_clearValues[i].depthStencil = {_clearDepth, _clearStencil};
+		else
+			_clearValues[i].color = {{_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a}};
+	}
 }
 
-VkAttachmentDescription RenderPass::GetDefaultColorAttachment(VkFormat format) noexcept
+VkAttachmentDescription RenderPass::GetDefaultColorAttachment(VkFormat format, VkImageLayout finalLayout, VkSampleCountFlagBits samples) noexcept
 {
 	VkAttachmentDescription colorAttachment = {};
 	colorAttachment.format = format;
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.samples = samples;
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = finalLayout;
 
 	return colorAttachment;
 }
 
-VkAttachmentDescription RenderPass::GetDefaultDepthAttachment(VkFormat format) noexcept
+VkAttachmentDescription RenderPass::GetDefaultDepthAttachment(VkFormat format, VkSampleCountFlagBits samples) noexcept
 {
 	VkAttachmentDescription depthAttachment = {};
 	depthAttachment.format = format;
-	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.samples = samples;
 	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
@@ -220,6 +338,14 @@ VkAttachmentDescription RenderPass::GetDefaultDepthAttachment(VkFormat format) n
 
 VkRenderPass	RenderPass::GetRenderPass(void) const noexcept { return (this->_renderPass); }
 VkCommandBuffer	RenderPass::GetCommandBuffer(void) const noexcept { return (this->_commandBuffer); }
+uint32_t		RenderPass::GetColorAttachmentCount(void) const noexcept { return static_cast< uint32_t >(this->_references.size()); }
+size_t			RenderPass::GetCompatibilityHash(void) const noexcept { return (this->_compatibilityHash); }
+uint32_t		RenderPass::GetViewCount(void) const noexcept { return (this->_viewCount); }
+
+VkSampleCountFlagBits	RenderPass::GetSampleCount(void) const noexcept
+{
+	return (_attachments.empty()) ? VK_SAMPLE_COUNT_1_BIT : _attachments[0].samples;
+}
 
 std::ostream &	operator<<(std::ostream & o, RenderPass const & r)
 {
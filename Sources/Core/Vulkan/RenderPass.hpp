@@ -35,14 +35,22 @@ namespace LWGC
 			std::vector< VkAttachmentReference >	_references;
 			std::vector< VkSubpassDependency >		_dependencies;
 			VkAttachmentReference					_depthAttachmentRef;
+			bool									_hasDepth;
 			uint32_t								_attachmentCount;
+			uint32_t								_viewCount;
+			size_t									_compatibilityHash;
 			VkCommandBuffer							_commandBuffer;
 			DescriptorBindings						_currentBindings;
 			Material * 								_currentMaterial;
 			std::vector< VkClearValue >				_clearValues;
+			Color									_clearColor;
+			float									_clearDepth;
+			uint32_t								_clearStencil;
 			SwapChain *								_swapChain;
+			bool									_gpuSample;
 
 			bool	BindDescriptorSet(const uint32_t binding, VkDescriptorSet set);
+			void	UpdateClearValues(void);
 
 		public:
 			RenderPass(void);
@@ -60,24 +68,41 @@ namespace LWGC
 			void	AddAttachment(const VkAttachmentDescription & attachment, VkImageLayout finalLayout) noexcept;
 			void	SetDepthAttachment(const VkAttachmentDescription & attachment, VkImageLayout layout) noexcept;
 			void	AddDependency(const VkSubpassDependency & dependency) noexcept;
+			// With more than one view the pass renders all the layers of its attachments at once (VK_KHR_multiview),
+			// the shaders get the index of the layer in SV_ViewID
+			void	SetViewCount(uint32_t viewCount);
 
 			// Bindings
 			bool	BindDescriptorSet(const std::string & name, VkDescriptorSet set);
 			bool	BindDescriptorSet(const std::string & name, DescriptorSet & set);
 			void	BindMaterial(Material * material);
 			void	ClearBindings(void);
+			bool	HasBinding(const std::string & name) const noexcept;
 			void	SetClearColor(const Color & color, float depth, uint32_t stencil);
 			void	UpdateDescriptorBindings(void);
 
 			// API
 			void	Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const std::string & passName);
+			// The viewport and scissor of the pipelines are dynamic, they are set to the whole render area
+			void	Begin(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent, const std::string & passName);
 			void	End(void);
+			// Restricts the following draws to a part of the render area
+			void	SetViewport(const VkRect2D & rect);
+			// Clears the depth of a part of the render area, for cameras drawing over the ones before them
+			void	ClearDepth(const VkRect2D & rect);
 
 			VkRenderPass	GetRenderPass(void) const noexcept;
 			VkCommandBuffer	GetCommandBuffer(void) const noexcept;
-
-			static VkAttachmentDescription	GetDefaultColorAttachment(VkFormat format) noexcept;
-			static VkAttachmentDescription	GetDefaultDepthAttachment(VkFormat format) noexcept;
+			uint32_t		GetColorAttachmentCount(void) const noexcept;
+			VkSampleCountFlagBits	GetSampleCount(void) const noexcept;
+			uint32_t		GetViewCount(void) const noexcept;
+			// Equal for the render passes with the same attachment formats, sample counts and views, a pipeline
+			// created for one of them can be used with all the others
+			size_t			GetCompatibilityHash(void) const noexcept;
+
+			// Pass SwapChain::GetFinalLayout when the pass renders into the swap chain images
+			static VkAttachmentDescription	GetDefaultColorAttachment(VkFormat format, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT) noexcept;
+			static VkAttachmentDescription	GetDefaultDepthAttachment(VkFormat format, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT) noexcept;
 	};
 
 	std::ostream &	operator<<(std::ostream & o, RenderPass const & r);
@@ -0,0 +1,178 @@
+#include "StagingRing.hpp"
+
+#include "Core/Vulkan/Vk.hpp"
+
+using namespace LWGC;
+
+StagingRing::StagingRing(void) : _device(VK_NULL_HANDLE), _commandBufferPool(nullptr), _buffer(VK_NULL_HANDLE), _memory(VK_NULL_HANDLE),
+	_mappedData(nullptr), _size(0), _head(0), _tail(0), _commandBuffer(VK_NULL_HANDLE), _nextBatchId(1), _completedBatchId(0)
+{
+}
+
+StagingRing::~StagingRing(void)
+{
+	Release();
+}
+
+void			StagingRing::Initialize(VkDeviceSize size)
+{
+	VulkanInstance * instance = VulkanInstance::Get();
+
+	_device = instance->GetDevice();
+	_commandBufferPool = instance->GetCommandBufferPool();
+	_size = size;
+
+	Vk::CreateBuffer(_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _buffer, _memory);
+	Vk::CheckResult(vkMapMemory(_device, _memory, 0, _size, 0, reinterpret_cast< void ** >(&_mappedData)), "Failed to map staging ring memory");
+}
+
+void			StagingRing::Release(void) noexcept
+{
+	if (_buffer == VK_NULL_HANDLE)
+		return ;
+
+	if (_commandBuffer != VK_NULL_HANDLE)
+	{
+		try {
+			Submit();
+		} catch (const std::exception & e) {
+			std::cerr << "Failed to submit the pending staging batch: " << e.what() << std::endl;
+			_commandBufferPool->FreeCommandBuffers({_commandBuffer});
+			_commandBuffer = VK_NULL_HANDLE;
+			for (const auto & staging : _batchBuffers)
+			{
+				vkUnmapMemory(_device, staging.memory);
+				vkDestroyBuffer(_device, staging.buffer, nullptr);
+				vkFreeMemory(_device, staging.memory, nullptr);
+			}
+			_batchBuffers.clear();
+		}
+	}
+	WaitIdle();
+
+	vkUnmapMemory(_device, _memory);
+	vkDestroyBuffer(_device, _buffer, nullptr);
+	vkFreeMemory(_device, _memory, nullptr);
+	_buffer = VK_NULL_HANDLE;
+	_memory = VK_NULL_HANDLE;
+	_mappedData = nullptr;
+}
+
+bool			StagingRing::IsInitialized(void) const noexcept { return _buffer != VK_NULL_HANDLE; }
+
+bool			StagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize & offset, uint8_t *& data) noexcept
+{
+	VkDeviceSize	position = _head % _size;
+	VkDeviceSize	aligned = (position + alignment - 1) / alignment * alignment;
+	uint64_t		required = aligned - position + size;
+
+	// Allocations are contiguous, skip the end of the buffer if it's too small
+	if (aligned + size > _size)
+		required = _size - position + size;
+
+	if (size > _size || (_head - _tail) + required > _size)
+		return false;
+
+	offset = (aligned + size > _size) ? 0 : aligned;
+	data = _mappedData + offset;
+	_head += required;
+
+	return true;
+}
+
+VkBuffer		StagingRing::AllocateDedicated(VkDeviceSize size, uint8_t *& data)
+{
+	DeferredBuffer	staging;
+
+	Vk::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory);
+	Vk::CheckResult(vkMapMemory(_device, staging.memory, 0, size, 0, reinterpret_cast< void ** >(&data)), "Failed to map staging memory");
+	_batchBuffers.push_back(staging);
+
+	return staging.buffer;
+}
+
+VkCommandBuffer	StagingRing::GetCommandBuffer(void)
+{
+	if (_commandBuffer == VK_NULL_HANDLE)
+		_commandBuffer = _commandBufferPool->BeginSingle();
+
+	return _commandBuffer;
+}
+
+bool			StagingRing::HasPendingCommands(void) const noexcept { return _commandBuffer != VK_NULL_HANDLE; }
+
+uint64_t		StagingRing::Submit(void)
+{
+	Batch				batch;
+	VkFenceCreateInfo	fenceInfo = {};
+
+	batch.commandBuffer = GetCommandBuffer();
+
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	Vk::CheckResult(vkCreateFence(_device, &fenceInfo, nullptr, &batch.fence), "Failed to create staging fence");
+
+	try {
+		_commandBufferPool->EndSingle(batch.commandBuffer, batch.fence);
+	} catch (...) {
+		vkDestroyFence(_device, batch.fence, nullptr);
+		throw ;
+	}
+
+	batch.id = _nextBatchId++;
+	batch.end = _head;
+	batch.buffers = std::move(_batchBuffers);
+	_batchBuffers.clear();
+
+	for (const auto & staging : batch.buffers)
+		vkUnmapMemory(_device, staging.memory);
+
+	_commandBuffer = VK_NULL_HANDLE;
+	_inFlight.push_back(std::move(batch));
+
+	return _inFlight.back().id;
+}
+
+void			StagingRing::ReleaseBatch(Batch & batch) noexcept
+{
+	vkDestroyFence(_device, batch.fence, nullptr);
+	_commandBufferPool->FreeCommandBuffers({batch.commandBuffer});
+	for (const auto & staging : batch.buffers)
+	{
+		vkDestroyBuffer(_device, staging.buffer, nullptr);
+		vkFreeMemory(_device, staging.memory, nullptr);
+	}
+
+	_tail = batch.end;
+	_completedBatchId = batch.id;
+}
+
+void			StagingRing::Retire(void) noexcept
+{
+	while (!_inFlight.empty() && vkGetFenceStatus(_device, _inFlight.front().fence) == VK_SUCCESS)
+	{
+		ReleaseBatch(_inFlight.front());
+		_inFlight.pop_front();
+	}
+}
+
+void			StagingRing::WaitIdle(void) noexcept
+{
+	for (auto & batch : _inFlight)
+	{
+		vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+		ReleaseBatch(batch);
+	}
+	_inFlight.clear();
+}
+
+VkBuffer		StagingRing::GetBuffer(void) const noexcept { return _buffer; }
+VkDeviceSize	StagingRing::GetSize(void) const noexcept { return _size; }
+VkDeviceSize	StagingRing::GetUsedSize(void) const noexcept { return _head - _tail; }
+uint64_t		StagingRing::GetCurrentBatchId(void) const noexcept { return _nextBatchId; }
+uint64_t		StagingRing::GetCompletedBatchId(void) const noexcept { return _completedBatchId; }
+
+std::ostream &	operator<<(std::ostream & o, StagingRing const & r)
+{
+	o << "StagingRing " << r.GetUsedSize() << "/" << r.GetSize() << " bytes used" << std::endl;
+	return (o);
+}
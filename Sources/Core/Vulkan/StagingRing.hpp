@@ -0,0 +1,87 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+
+#include "IncludeDeps.hpp"
+#include "Core/Vulkan/VulkanInstance.hpp"
+#include "Core/Vulkan/CommandBufferPool.hpp"
+
+#include VULKAN_INCLUDE
+
+namespace LWGC
+{
+	// Persistently mapped upload buffer used as a ring: transfers are recorded in a single command buffer per batch
+	// and the memory of a batch is reclaimed once its fence is signaled, so nothing waits for the queue to be idle.
+	class		StagingRing
+	{
+		private:
+			struct	DeferredBuffer
+			{
+				VkBuffer		buffer;
+				VkDeviceMemory	memory;
+			};
+
+			struct	Batch
+			{
+				uint64_t						id;
+				VkFence							fence;
+				VkCommandBuffer					commandBuffer;
+				uint64_t						end;
+				std::vector< DeferredBuffer >	buffers;
+			};
+
+			VkDevice					_device;
+			CommandBufferPool *			_commandBufferPool;
+			VkBuffer					_buffer;
+			VkDeviceMemory				_memory;
+			uint8_t *					_mappedData;
+			VkDeviceSize				_size;
+			// Monotonic byte counters, the ring position is head % size
+			uint64_t					_head;
+			uint64_t					_tail;
+			VkCommandBuffer				_commandBuffer;
+			std::vector< DeferredBuffer >	_batchBuffers;
+			std::deque< Batch >			_inFlight;
+			uint64_t					_nextBatchId;
+			uint64_t					_completedBatchId;
+
+			void			ReleaseBatch(Batch & batch) noexcept;
+
+		public:
+			StagingRing(void);
+			StagingRing(const StagingRing &) = delete;
+			virtual ~StagingRing(void);
+
+			StagingRing &	operator=(StagingRing const & src) = delete;
+
+			void			Initialize(VkDeviceSize size);
+			void			Release(void) noexcept;
+			bool			IsInitialized(void) const noexcept;
+
+			// Returns false when the ring is full, retry after some batches have been retired
+			bool			Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize & offset, uint8_t *& data) noexcept;
+			// Temporary staging buffer for uploads that don't fit in the ring, destroyed with the current batch
+			VkBuffer		AllocateDedicated(VkDeviceSize size, uint8_t *& data);
+
+			// Command buffer of the current batch, begun on first use
+			VkCommandBuffer	GetCommandBuffer(void);
+			bool			HasPendingCommands(void) const noexcept;
+			// Submit the current batch and return its id, batches complete in order.
+			// On failure the batch stays pending and the exception is rethrown
+			uint64_t		Submit(void);
+			// Reclaim the memory of the finished batches, never blocks
+			void			Retire(void) noexcept;
+			void			WaitIdle(void) noexcept;
+
+			VkBuffer		GetBuffer(void) const noexcept;
+			VkDeviceSize	GetSize(void) const noexcept;
+			VkDeviceSize	GetUsedSize(void) const noexcept;
+			uint64_t		GetCurrentBatchId(void) const noexcept;
+			uint64_t		GetCompletedBatchId(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, StagingRing const & r);
+}
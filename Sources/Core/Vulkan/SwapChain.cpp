@@ -3,11 +3,14 @@
 
 #include <array>
 #include <limits>
+#include <algorithm>
 
 using namespace LWGC;
 
-SwapChain::SwapChain(void) : _instance(nullptr), _window(nullptr), _imageCount(0)
+SwapChain::SwapChain(void) : _instance(nullptr), _window(nullptr), _imageCount(0), _presentMode(VK_PRESENT_MODE_FIFO_KHR), _headless(false),
+	_depthImage(VK_NULL_HANDLE), _depthImageMemory(VK_NULL_HANDLE), _depthImageView(VK_NULL_HANDLE), _depthFormat(VK_FORMAT_UNDEFINED)
 {
+	_presentModes = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
 	this->_swapChain = VK_NULL_HANDLE;
 	this->_device = VK_NULL_HANDLE;
 }
@@ -26,9 +29,24 @@ void		SwapChain::Initialize(const VulkanSurface & surface)
 	Create();
 }
 
+void		SwapChain::InitializeHeadless(uint32_t width, uint32_t height, uint32_t imageCount)
+{
+	_instance = VulkanInstance::Get();
+	_surface = VK_NULL_HANDLE;
+	_device = _instance->GetDevice();
+	_headless = true;
+	_extent = {width, height};
+	_imageCount = imageCount;
+	_imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	Create();
+}
+
 void		SwapChain::Create(void)
 {
-	CreateSwapChain();
+	if (_headless)
+		CreateOffscreenImages();
+	else
+		CreateSwapChain();
 	CreateImageViews();
 }
 
@@ -44,7 +62,16 @@ void		SwapChain::Cleanup(void) noexcept
 	for (size_t i = 0; i < _imageViews.size(); i++)
 		vkDestroyImageView(_device, _imageViews[i], nullptr);
 
-	vkDestroySwapchainKHR(_device, _swapChain, nullptr);
+	// The swap chain functions aren't loaded when the extension isn't enabled
+	if (_swapChain != VK_NULL_HANDLE)
+		vkDestroySwapchainKHR(_device, _swapChain, nullptr);
+
+	for (size_t i = 0; i < _imageMemories.size(); i++)
+	{
+		vkDestroyImage(_device, _images[i], nullptr);
+		vkFreeMemory(_device, _imageMemories[i], nullptr);
+	}
+	_imageMemories.clear();
 }
 
 void		SwapChain::CreateSwapChain(void)
@@ -70,6 +97,9 @@ void		SwapChain::CreateSwapChain(void)
 	createInfo.imageExtent = extent;
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	// Screenshots are copies of the swap chain images
+	if (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	createInfo.preTransform = capabilities.currentTransform;
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
@@ -87,6 +117,18 @@ void		SwapChain::CreateSwapChain(void)
 	_extent = extent;
 }
 
+void				SwapChain::CreateOffscreenImages(void)
+{
+	_images.resize(_imageCount);
+	_imageMemories.resize(_imageCount);
+
+	for (uint32_t i = 0; i < _imageCount; i++)
+	{
+		Vk::CreateImage(_extent.width, _extent.height, 1, 1, 1, _imageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _images[i], _imageMemories[i]);
+		Vk::SetImageDebugName("Headless image " + std::to_string(i), _images[i]);
+	}
+}
+
 void				SwapChain::CreateImageViews(void) noexcept
 {
 	_imageViews.resize(_images.size());
@@ -164,8 +206,10 @@ void				SwapChain::CreateDepthResources(void)
 {
 	VkFormat depthFormat = _instance->FindDepthFormat();
 
-	Vk::CreateImage(_extent.width, _extent.height, 1, 1, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _depthImage, _depthImageMemory);
+	// The occlusion culling copies the depth of the frame to build its pyramid
+	Vk::CreateImage(_extent.width, _extent.height, 1, 1, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _depthImage, _depthImageMemory);
 	_depthImageView = Vk::CreateImageView(_depthImage, depthFormat, 1, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT);
+	_depthFormat = depthFormat;
 	TransitionDepthImageLayout(_depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 }
 
@@ -214,21 +258,35 @@ VkSurfaceFormatKHR	SwapChain::ChooseSurfaceFormat(void) noexcept
 	return availableFormats[0];
 }
 
+static const char *	GetPresentModeName(VkPresentModeKHR presentMode) noexcept
+{
+	switch (presentMode)
+	{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR:		return "immediate";
+		case VK_PRESENT_MODE_MAILBOX_KHR:		return "mailbox";
+		case VK_PRESENT_MODE_FIFO_KHR:			return "fifo";
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR:	return "fifo relaxed";
+		default:								return "unknown";
+	}
+}
+
 VkPresentModeKHR	SwapChain::ChoosePresentMode(void) noexcept
 {
-	// return VK_PRESENT_MODE_FIFO_KHR;
 	const auto & availablePresentModes = _instance->GetSupportedPresentModes();
-	VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
 
-	for (const auto & availablePresentMode : availablePresentModes)
+	// FIFO is the only mode that every device supports
+	_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	for (const auto & presentMode : _presentModes)
 	{
-	    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-	        return availablePresentMode;
-	    else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-	        bestMode = availablePresentMode;
+		if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end())
+		{
+			_presentMode = presentMode;
+			break ;
+		}
 	}
 
-	return bestMode;
+	std::cout << "Swap chain present mode: " << GetPresentModeName(_presentMode) << std::endl;
+	return _presentMode;
 }
 
 VkExtent2D			SwapChain::ChooseExtent(void) noexcept
@@ -259,6 +317,22 @@ VkExtent2D						SwapChain::GetExtent(void) const noexcept { return (this->_exten
 const std::vector< VkImageView >SwapChain::GetImageViews(void) const noexcept { return (this->_imageViews); }
 const std::vector< VkFramebuffer >SwapChain::GetFramebuffers(void) const noexcept { return (this->_framebuffers); }
 uint32_t						SwapChain::GetImageCount(void) const noexcept { return (this->_imageCount); }
+VkPresentModeKHR				SwapChain::GetPresentMode(void) const noexcept { return (this->_presentMode); }
+bool							SwapChain::IsHeadless(void) const noexcept { return (this->_headless); }
+
+VkImageLayout					SwapChain::GetFinalLayout(void) const noexcept
+{
+	return _headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+}
+
+VkImage							SwapChain::GetDepthImage(void) const noexcept { return (this->_depthImage); }
+VkImageView						SwapChain::GetDepthImageView(void) const noexcept { return (this->_depthImageView); }
+VkFormat						SwapChain::GetDepthFormat(void) const noexcept { return (this->_depthFormat); }
+
+void							SwapChain::SetPresentModes(const std::vector< VkPresentModeKHR > & presentModes)
+{
+	_presentModes = presentModes;
+}
 
 std::ostream &	operator<<(std::ostream & o, SwapChain const & r)
 {
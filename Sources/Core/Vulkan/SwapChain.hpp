@@ -31,13 +31,19 @@ namespace LWGC
 			VulkanInstance *				_instance;
 			GLFWwindow *					_window;
 			uint32_t						_imageCount;
+			std::vector< VkPresentModeKHR >	_presentModes;	// By order of preference
+			VkPresentModeKHR				_presentMode;
+			bool							_headless;
+			std::vector< VkDeviceMemory >	_imageMemories;	// Offscreen images of the headless swap chain
 	
 			VkImage							_depthImage;
 			VkDeviceMemory					_depthImageMemory;
 			VkImageView						_depthImageView;
+			VkFormat						_depthFormat;
 	
 	
 			void				CreateSwapChain(void);
+			void				CreateOffscreenImages(void);
 			void				CreateImageViews(void) noexcept;
 			VkExtent2D			ChooseExtent(void) noexcept;
 			VkSurfaceFormatKHR	ChooseSurfaceFormat(void) noexcept;
@@ -56,6 +62,8 @@ namespace LWGC
 			SwapChain &	operator=(SwapChain const & src) = delete;
 	
 			void	Initialize(const VulkanSurface & surface);
+			// Renders into offscreen images that are never presented, the frames are read back by the render pipeline
+			void	InitializeHeadless(uint32_t width, uint32_t height, uint32_t imageCount);
 			void	Create(void);
 			void	Cleanup(void) noexcept;
 	
@@ -66,6 +74,17 @@ namespace LWGC
 			const std::vector< VkImageView >	GetImageViews(void) const noexcept;
 			const std::vector< VkFramebuffer >	GetFramebuffers(void) const noexcept;
 			uint32_t							GetImageCount(void) const noexcept;
+			VkPresentModeKHR					GetPresentMode(void) const noexcept;
+			bool								IsHeadless(void) const noexcept;
+			// Layout the last render pass of the frame leaves the images in: ready to present, or to copy when headless
+			VkImageLayout						GetFinalLayout(void) const noexcept;
+			// Depth buffer shared by the framebuffers, it can be copied after the last render pass stored it
+			VkImage								GetDepthImage(void) const noexcept;
+			VkImageView							GetDepthImageView(void) const noexcept;
+			VkFormat							GetDepthFormat(void) const noexcept;
+
+			// The first supported mode is used when the swap chain is (re)created, FIFO when none is
+			void								SetPresentModes(const std::vector< VkPresentModeKHR > & presentModes);
 
 			SwapChainRecreatedDelegate			onRecreated;
 	};
@@ -1,6 +1,7 @@
 #include "Vk.hpp"
 
 #include "Core/Vulkan/Material.hpp"
+#include "Core/Profiler.hpp"
 
 using namespace LWGC;
 
@@ -11,7 +12,7 @@ VkSampler Vk::Samplers::nearestClamp;
 VkSampler Vk::Samplers::nearestRepeat;
 VkSampler Vk::Samplers::anisotropicTrilinearClamp;
 
-VkImageView		Vk::CreateImageView(VkImage image, VkFormat format, int mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectFlags)
+VkImageView		Vk::CreateImageView(VkImage image, VkFormat format, int mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectFlags, int layerCount)
 {
 	VulkanInstance * instance = VulkanInstance::Get();
 
@@ -24,7 +25,7 @@ VkImageView		Vk::CreateImageView(VkImage image, VkFormat format, int mipLevels,
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = mipLevels;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
+	viewInfo.subresourceRange.layerCount = layerCount;
 
 	VkImageView imageView;
 	auto device = instance->GetDevice();
@@ -35,7 +36,7 @@ VkImageView		Vk::CreateImageView(VkImage image, VkFormat format, int mipLevels,
 	return imageView;
 }
 
-void			Vk::CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arrayCount, int mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+void			Vk::CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arrayCount, int mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkSampleCountFlagBits samples)
 {
 	VulkanInstance * instance = VulkanInstance::Get();
 
@@ -51,7 +52,7 @@ void			Vk::CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arra
 	imageInfo.tiling = tiling;
 	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imageInfo.usage = usage;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.samples = samples;
 	// TODO: expose as parameter, currently the resource can only be used by one queue
 	// (otherwise it have to trasfer the ownership of the resource)
 	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -71,6 +72,9 @@ void			Vk::CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arra
 	if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
 	    throw std::runtime_error("failed to allocate image memory!");
 
+	static const ProfilerNameId	imageMemoryName = Profiler::InternName("Image memory");
+	Profiler::RecordAllocation(imageMemoryName, static_cast< int64_t >(memRequirements.size));
+
 	CheckResult(vkBindImageMemory(device, image, imageMemory, 0), "Bind image memory failed");
 }
 
@@ -79,6 +83,78 @@ bool			Vk::HasStencilComponent(VkFormat format)
 	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
+VkImageAspectFlags	Vk::GetImageAspect(VkFormat format) noexcept
+{
+	switch (format)
+	{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+void			Vk::GetLayoutStagesAndAccess(VkImageLayout layout, VkPipelineStageFlags & stages, VkAccessFlags & access) noexcept
+{
+	const VkPipelineStageFlags	shaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	switch (layout)
+	{
+		case VK_IMAGE_LAYOUT_UNDEFINED:
+			stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			access = 0;
+			break ;
+		case VK_IMAGE_LAYOUT_PREINITIALIZED:
+			stages = VK_PIPELINE_STAGE_HOST_BIT;
+			access = VK_ACCESS_HOST_WRITE_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_GENERAL:
+			stages = shaderStages;
+			access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+			stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+			stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+			stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | shaderStages;
+			access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			stages = shaderStages;
+			access = VK_ACCESS_SHADER_READ_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+			stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			access = VK_ACCESS_TRANSFER_READ_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+			stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			access = VK_ACCESS_TRANSFER_WRITE_BIT;
+			break ;
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+			stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			access = 0;
+			break ;
+		default:
+			stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			break ;
+	}
+}
+
 void			Vk::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer & buffer, VkDeviceMemory & bufferMemory)
 {
 	VulkanInstance * instance = VulkanInstance::Get();
@@ -104,6 +180,9 @@ void			Vk::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPro
 	if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
 		throw std::runtime_error("failed to allocate buffer memory!");
 
+	static const ProfilerNameId	bufferMemoryName = Profiler::InternName("Buffer memory");
+	Profiler::RecordAllocation(bufferMemoryName, static_cast< int64_t >(memRequirements.size));
+
 	CheckResult(vkBindBufferMemory(device, buffer, bufferMemory, 0), "Bind Buffer Memory failed");
 }
 
@@ -458,6 +537,17 @@ VkFence			Vk::CreateFence(bool signaled)
 	return fence;
 }
 
+VkSemaphore		Vk::CreateSemaphore(void)
+{
+	VkDevice				device = VulkanInstance::Get()->GetDevice();
+	VkSemaphore				semaphore;
+	VkSemaphoreCreateInfo	semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	CheckResult(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore), "Failed to create semaphore");
+	return semaphore;
+}
+
 uint64_t		Vk::CreateAccelerationStructure(const VkAccelerationStructureTypeNV type, const uint32_t geometryCount, const VkGeometryNV * geometries, const uint32_t instanceCount)
 {
 	VulkanInstance *			instance = VulkanInstance::Get();
@@ -38,9 +38,13 @@ namespace LWGC
 
 			static void			Initialize(void);
 			static void			Release(void);
-			static VkImageView	CreateImageView(VkImage image, VkFormat format, int mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectFlags);
-			static void			CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arrayCount, int mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+			static VkImageView	CreateImageView(VkImage image, VkFormat format, int mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectFlags, int layerCount = 1);
+			static void			CreateImage(uint32_t width, uint32_t height, uint32_t depth, int arrayCount, int mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
 			static bool			HasStencilComponent(VkFormat format);
+			// Aspects of all the subresources of an image of this format: depth and/or stencil, color otherwise
+			static VkImageAspectFlags	GetImageAspect(VkFormat format) noexcept;
+			// Stages and accesses that can use an image in this layout, for barriers where the other side is unknown
+			static void			GetLayoutStagesAndAccess(VkImageLayout layout, VkPipelineStageFlags & stages, VkAccessFlags & access) noexcept;
 			static void			CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer & buffer, VkDeviceMemory & bufferMemory);
 			static void			CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 			static VkBufferView	CreateBufferView(VkBuffer buffer, VkFormat format, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
@@ -78,6 +82,7 @@ namespace LWGC
 			static void			EndProfilingSample(VkCommandBuffer cmd);
 
 			static VkFence		CreateFence(bool signaled = false);
+			static VkSemaphore	CreateSemaphore(void);
 
 			static uint64_t		CreateAccelerationStructure(const VkAccelerationStructureTypeNV type, const uint32_t geometryCount, const VkGeometryNV * geometries, const uint32_t instanceCount);
 	};
@@ -22,9 +22,10 @@ VulkanInstance *	VulkanInstance::Get(void)
 
 VulkanInstance::VulkanInstance(void) : VulkanInstance("(null)") {}
 
-VulkanInstance::VulkanInstance(const std::string & applicationName) : _applicationName(applicationName), _enableValidationLayers(false)
+VulkanInstance::VulkanInstance(const std::string & applicationName) : _applicationName(applicationName), _enableValidationLayers(false), _headless(false), _maxMultiviewViewCount(1)
 {
 	_instance = VK_NULL_HANDLE;
+	_surface = VK_NULL_HANDLE;
 	_physicalDevice = VK_NULL_HANDLE;
 	_descriptorPool = VK_NULL_HANDLE;
 	_device = VK_NULL_HANDLE;
@@ -74,9 +75,20 @@ void			VulkanInstance::InitializeSurface(VkSurfaceKHR surface)
 	CreateCommandBufferPools();
 	CreateDescriptorPool();
 
-	VkPhysicalDeviceProperties props;
-    vkGetPhysicalDeviceProperties(_physicalDevice, &props);
-	_limits = props.limits;
+	VkPhysicalDeviceMultiviewProperties multiviewProperties = {};
+	multiviewProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 props = {};
+	props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	props.pNext = &multiviewProperties;
+	vkGetPhysicalDeviceProperties2(_physicalDevice, &props);
+	_limits = props.properties.limits;
+	_maxMultiviewViewCount = multiviewProperties.maxMultiviewViewCount;
+}
+
+void			VulkanInstance::InitializeHeadless(void)
+{
+	InitializeSurface(VK_NULL_HANDLE);
 }
 
 void			VulkanInstance::CreateDescriptorPool(void)
@@ -108,6 +120,8 @@ void			VulkanInstance::CreateDescriptorPool(void)
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
 	poolInfo.maxSets = 2000u;
+	// The materials free their sets when the shaders are reloaded
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 	if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS)
 	    throw std::runtime_error("failed to create descriptor pool!");
@@ -198,8 +212,11 @@ bool			VulkanInstance::AreValidationLayerSupported(void) noexcept
 std::vector<const char *>	VulkanInstance::GetRequiredExtensions(void) noexcept
 {
 	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	const char** glfwExtensions = nullptr;
+
+	// GLFW isn't initialized without a window
+	if (!_headless)
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
 	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
@@ -238,7 +255,8 @@ DeviceCapability			VulkanInstance::GetDeviceCapability(VkPhysicalDevice physical
 	for (const auto& queueFamily : queueFamilies)
 	{
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, _surface, &presentSupport);
+		if (_surface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, _surface, &presentSupport);
 
 		auto deviceQueue = DeviceQueue{
 			static_cast<uint32_t>(index),
@@ -265,6 +283,9 @@ DeviceCapability			VulkanInstance::GetDeviceCapability(VkPhysicalDevice physical
 
 void			VulkanInstance::InitSurfaceForPhysicalDevice(VkPhysicalDevice physicalDevice) noexcept
 {
+	if (_surface == VK_NULL_HANDLE)
+		return ;
+
 	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, _surface, &_surfaceCapabilities);
 
 	uint32_t formatCount;
@@ -293,7 +314,7 @@ DeviceCapability			VulkanInstance::IsPhysicalDeviceSuitable(VkPhysicalDevice phy
 	capability.enabledExtensions = AreExtensionsSupportedForPhysicalDevice(physicalDevice);
 
 	InitSurfaceForPhysicalDevice(physicalDevice);
-	capability.supportSurface = !_surfaceFormats.empty() && !_surfacePresentModes.empty();
+	capability.supportSurface = _headless || (!_surfaceFormats.empty() && !_surfacePresentModes.empty());
 
 	VkPhysicalDeviceFeatures supportedFeatures;
 	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
@@ -341,7 +362,7 @@ void			VulkanInstance::ChoosePhysicalDevice(void)
 	// Find the "best" GPU on the machine
 
 	std::sort(deviceCapabilities.begin(), deviceCapabilities.end(), [](const DeviceCapability & c1, const DeviceCapability & c2){
-		return c1.GetGPUScore() < c2.GetGPUScore();
+		return c1.GetGPUScore() > c2.GetGPUScore();
 	});
 
 	auto & bestDevice = deviceCapabilities[0];
@@ -390,11 +411,24 @@ void			VulkanInstance::CreateLogicalDevice(void)
 	deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
 	deviceFeatures.multiViewport = VK_TRUE;
 
+	// Optional features, only enabled when available
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+	_enabledFeatures = deviceFeatures;
+
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
 	createInfo.pEnabledFeatures = &deviceFeatures;
 
+	// Required by Vulkan 1.1, the default vertex shader reads the view index
+	VkPhysicalDeviceMultiviewFeatures multiviewFeatures = {};
+	multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+	multiviewFeatures.multiview = VK_TRUE;
+	createInfo.pNext = &multiviewFeatures;
+
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(_deviceExtensions.size());
 	std::vector< const char * > enabledExtensionsName;
 	for (const auto & n : _deviceExtensions)
@@ -544,6 +578,21 @@ VkFormat		VulkanInstance::FindSupportedFormat(const std::vector< VkFormat > & ca
 	throw std::runtime_error("failed to find supported format!");
 }
 
+bool			VulkanInstance::IsFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features)
+{
+	VkFormatProperties properties;
+
+	// Block compressed formats can't be used without the device feature, even if the format properties says otherwise
+	if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK && !_enabledFeatures.textureCompressionBC)
+		return false;
+
+	vkGetPhysicalDeviceFormatProperties(_physicalDevice, format, &properties);
+
+	if (tiling == VK_IMAGE_TILING_LINEAR)
+		return (properties.linearTilingFeatures & features) == features;
+	return (properties.optimalTilingFeatures & features) == features;
+}
+
 VkFormat		VulkanInstance::FindDepthFormat(void)
 {
 	return FindSupportedFormat(
@@ -569,6 +618,13 @@ void		VulkanInstance::SetInstanceExtensions(const std::vector< std::string > ins
 	_instanceExtensions = instanceExtensions;
 }
 
+void		VulkanInstance::SetHeadless(bool headless) noexcept
+{
+	_headless = headless;
+}
+
+bool		VulkanInstance::IsHeadless(void) const noexcept { return _headless; }
+
 void		VulkanInstance::SetApplicationName(const std::string & applicationName) noexcept
 {
 	_applicationName = applicationName;
@@ -718,7 +774,8 @@ void		VulkanInstance::DestroyDebugUtilsMessengerEXT(VkDebugUtilsMessengerEXT cal
 
 int			DeviceCapability::GetGPUScore(void) const
 {
-	if (!supportedFeatures || !supportSurface || queues.size() <= 1)
+	// Devices with a single queue family (software rasterizers) run the async work on the main queue
+	if (!supportedFeatures || !supportSurface || queues.empty())
 	{
 		std::cout << "supported features: " << supportedFeatures << ", " << supportSurface << ", " << queues.size() << std::endl;
 		return -1;
@@ -735,6 +792,8 @@ int			DeviceCapability::GetGPUScore(void) const
 }
 
 const VkPhysicalDeviceLimits	VulkanInstance::GetLimits(void) const noexcept { return _limits; }
+const VkPhysicalDeviceFeatures	VulkanInstance::GetEnabledFeatures(void) const noexcept { return _enabledFeatures; }
+uint32_t	VulkanInstance::GetMaxMultiviewViewCount(void) const noexcept { return _maxMultiviewViewCount; }
 
 bool VulkanInstance::IsExtensionEnabled(const std::string & extensionName)
 {
@@ -45,10 +45,13 @@ namespace LWGC
 			VkDevice					_device;
 			std::string					_applicationName;
 			bool						_enableValidationLayers;
+			bool						_headless;
 			VkDebugUtilsMessengerEXT	_debugUtilsMessengerCallback;
 			VkDebugReportCallbackEXT	_debugReportCallback;
 			VkDescriptorPool			_descriptorPool;
 			VkPhysicalDeviceLimits		_limits;
+			VkPhysicalDeviceFeatures	_enabledFeatures;
+			uint32_t					_maxMultiviewViewCount;
 
 			VkQueue						_queue;
 
@@ -99,8 +102,13 @@ namespace LWGC
 			void		SetDeviceExtensions(const std::vector< std::string > deviceExtensions) noexcept;
 			void		SetInstanceExtensions(const std::vector< std::string > deviceExtensions) noexcept;
 			void		SetApplicationName(const std::string & applicationName) noexcept;
+			// Must be set before Initialize, the instance doesn't need the window system extensions
+			void		SetHeadless(bool headless) noexcept;
+			bool		IsHeadless(void) const noexcept;
 
 			void		Initialize(void);
+			// Creates the device without a surface, nothing can be presented
+			void		InitializeHeadless(void);
 			void		UpdateSurface(void);
 
 			VkInstance	GetInstance(void) const noexcept;
@@ -125,6 +133,10 @@ namespace LWGC
 			uint32_t	FindMemoryType(const VkMemoryRequirements & memoryRequirements, VkMemoryPropertyFlags memoryProperties);
 			VkFormat	FindSupportedFormat(const std::vector< VkFormat > & candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 			VkFormat	FindDepthFormat(void);
+			bool		IsFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features);
+			const VkPhysicalDeviceFeatures	GetEnabledFeatures(void) const noexcept;
+			// Multiview is always enabled (core in Vulkan 1.1), max number of views of a render pass
+			uint32_t	GetMaxMultiviewViewCount(void) const noexcept;
 			uint32_t	GetAvailableDevceQueueCount(void);
 			void		AllocateDeviceQueue(VkQueue & queue, uint32_t & queueIndex);
 
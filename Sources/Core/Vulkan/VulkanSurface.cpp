@@ -10,7 +10,9 @@ VulkanSurface::VulkanSurface(void)
 
 VulkanSurface::~VulkanSurface(void)
 {
-	vkDestroySurfaceKHR(_instance->GetInstance(), _surface, nullptr);
+	// Never created when the application runs headless
+	if (_surface != VK_NULL_HANDLE)
+		vkDestroySurfaceKHR(_instance->GetInstance(), _surface, nullptr);
 }
 
 void		VulkanSurface::Initialize(GLFWwindow * window)
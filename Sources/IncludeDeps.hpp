@@ -17,6 +17,7 @@
 #define IMGUI_VULKAN_INCLUDE "../Deps/imgui/examples/imgui_impl_vulkan.h"
 #define STB_INCLUDE "../Deps/stb/stb.h"
 #define STB_INCLUDE_IMAGE "../Deps/stb/stb_image.h"
+#define STB_INCLUDE_IMAGE_WRITE "../Deps/stb/stb_image_write.h"
 #define SPIRV_CROSS_INCLUDE "../Deps/SPIRV-Cross/spirv_reflect.hpp"
 #define ASSIMP_IMPORTER_INCLUDE "../Deps/assimp/include/assimp/Importer.hpp"
 #define ASSIMP_SCENE_INCLUDE "../Deps/assimp/include/assimp/scene.h"
@@ -27,8 +28,7 @@
 # define VULKAN_INCLUDE VOLK_INCLUDE
 
 
-// Unusable API
-// #define GLSLANG_INCLUDE "../Deps/glslang/glslang/Public/ShaderLang.h"
-// #define GLSLANG_RESOURCES_INCLUDE "../Deps/glslang/StandAlone/ResourceLimits.h"
-// #define GLSLANG_DIRSTACK_INCLUDE "../Deps/glslang/StandAlone/DirStackFileIncluder.h"
-// #define GLSLANG_SPV_INCLDUE "../Deps/glslang/SPIRV/GlslangToSpv.h"
+#define GLSLANG_INCLUDE "../Deps/glslang/glslang/Public/ShaderLang.h"
+#define GLSLANG_RESOURCES_INCLUDE "../Deps/glslang/StandAlone/ResourceLimits.h"
+#define GLSLANG_DIRSTACK_INCLUDE "../Deps/glslang/StandAlone/DirStackFileIncluder.h"
+#define GLSLANG_SPV_INCLUDE "../Deps/glslang/SPIRV/GlslangToSpv.h"
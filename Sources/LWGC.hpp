@@ -17,17 +17,46 @@
 
 // Pipelines
 #include "Core/Rendering/RenderPipeline.hpp"
+#include "Core/Rendering/RenderGraph.hpp"
+#include "Core/Rendering/FramePacer.hpp"
+#include "Core/Rendering/HeadlessOutput.hpp"
 
 // Rendering
 #include "Core/Rendering/RenderTarget.hpp"
+#include "Core/Rendering/RenderTexturePool.hpp"
+#include "Core/Rendering/CameraCulling.hpp"
+#include "Core/Rendering/LightClusterBinning.hpp"
+#include "Core/Rendering/ClusteredLighting.hpp"
+#include "Core/Rendering/ShadowCascades.hpp"
+#include "Core/Rendering/ShadowMaps.hpp"
+#include "Core/Rendering/DepthPyramid.hpp"
+#include "Core/Rendering/OcclusionCulling.hpp"
 #include "Core/Mesh.hpp"
+#include "Core/MeshSimplifier.hpp"
+#include "Core/MeshCache.hpp"
 #include "Core/PrimitiveType.hpp"
 #include "Core/PrimitiveMeshFactory.hpp"
 #include "Core/Textures/Texture2D.hpp"
 #include "Core/Textures/Texture3D.hpp"
+#include "Core/Textures/BCEncoder.hpp"
+#include "Core/Textures/ImageData.hpp"
+#include "Core/Textures/StreamedTexture.hpp"
+#include "Core/Textures/TextureStreamer.hpp"
+#include "Core/Textures/VirtualTextureLayout.hpp"
+#include "Core/Textures/VirtualTextureFile.hpp"
+#include "Core/Textures/VirtualTexturePageManager.hpp"
+#include "Core/Textures/VirtualTextureFeedbackSimulator.hpp"
+#include "Core/Textures/VirtualTexture.hpp"
+#include "Core/Textures/MultiPageAtlas.hpp"
 #include "Core/Vulkan/Material.hpp"
 #include "Core/Shaders/BuiltinShaders.hpp"
+#include "Core/Shaders/ShaderCompiler.hpp"
+#include "Core/Shaders/SpirVCache.hpp"
+#include "Core/Shaders/ShaderHotReload.hpp"
+#include "Core/Shaders/ShaderKeywords.hpp"
 #include "Core/Vulkan/MaterialStates.hpp"
+#include "Core/Vulkan/GpuProfiler.hpp"
+#include "Core/Vulkan/ReadbackManager.hpp"
 #include "Core/Shaders/ComputeShader.hpp"
 
 // App & core
@@ -37,7 +66,7 @@
 #include "Core/GameObject.hpp"
 #include "Core/Time.hpp"
 #include "Core/Textures/Texture2DAtlas.hpp"
-#include "Core/NodeTree.hpp"
+#include "Core/AtlasAllocator.hpp"
 #include "Core/ModelLoader.hpp"
 
 // Event System
@@ -49,6 +78,7 @@
 #include "Core/Components/MeshRenderer.hpp"
 #include "Core/Components/ProceduralRenderer.hpp"
 #include "Core/Components/Camera.hpp"
+#include "Core/Components/Light.hpp"
 #include "Core/Components/FreeCameraControls.hpp"
 #include "Core/Components/ComputeDispatcher.hpp"
 #include "Core/Components/ImGUIPanel.hpp"
@@ -56,7 +86,9 @@
 #include "Core/Components/Movator.hpp"
 #include "Core/Components/Activator.hpp"
 #include "Core/Components/ProfilerPanel.hpp"
+#include "Core/ProfilerCapture.hpp"
 #include "Core/Components/IndirectRenderer.hpp"
+#include "Core/Components/LODGroup.hpp"
 
 // Gimos & handles
 #include "Core/Gizmos/Line.hpp"
@@ -74,6 +106,9 @@
 #include "Utils/Math.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/Vector.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/ThreadPool.hpp"
+#include "Utils/FileWatcher.hpp"
 
 // ImGUI
 #include IMGUI_INCLUDE
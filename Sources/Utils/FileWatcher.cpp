@@ -0,0 +1,226 @@
+#include "FileWatcher.hpp"
+
+#include <unordered_set>
+#include <chrono>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+# include <sys/inotify.h>
+#endif
+
+using namespace LWGC;
+
+static bool			GetModificationTime(const std::string & file, struct timespec & time)
+{
+	struct stat		st;
+
+	if (stat(file.c_str(), &st) != 0)
+		return false;
+
+#ifdef __APPLE__
+	time = st.st_mtimespec;
+#else
+	time = st.st_mtim;
+#endif
+	return true;
+}
+
+static std::string	GetDirectory(const std::string & file)
+{
+	size_t slash = file.find_last_of('/');
+
+	return (slash == std::string::npos) ? "." : file.substr(0, slash);
+}
+
+FileWatcher::FileWatcher(size_t queueCapacity) : _changes(queueCapacity), _overflow(false), _stop(false), _inotifyFd(-1)
+{
+	_stopPipe[0] = _stopPipe[1] = -1;
+
+#ifdef __linux__
+	if ((_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1)
+		std::cerr << "inotify unavailable, falling back to file polling" << std::endl;
+#endif
+}
+
+FileWatcher::~FileWatcher(void)
+{
+	Stop();
+
+	if (_inotifyFd != -1)
+		close(_inotifyFd);
+}
+
+std::string			FileWatcher::NormalizePath(const std::string & path)
+{
+	char	resolved[PATH_MAX];
+
+	if (realpath(path.c_str(), resolved) == nullptr)
+		return path;
+
+	return resolved;
+}
+
+bool				FileWatcher::Watch(const std::string & file)
+{
+	std::string		path = NormalizePath(file);
+	std::string		directory = GetDirectory(path);
+	struct timespec	time;
+
+	if (!GetModificationTime(path, time))
+		return false;
+
+	std::lock_guard< std::mutex >	lock(_mutex);
+
+	auto & files = _files[directory];
+	for (const auto & watched : files)
+		if (watched == path)
+			return true;
+
+#ifdef __linux__
+	if (files.empty() && _inotifyFd != -1)
+	{
+		// Directories are watched instead of the files: a file replaced by a rename gets a new inode
+		int wd = inotify_add_watch(_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+		if (wd == -1)
+			std::cerr << "Can't watch directory " << directory << std::endl;
+		else
+			_directories[wd] = directory;
+	}
+#endif
+
+	files.push_back(path);
+	_modificationTimes[path] = time;
+
+	return true;
+}
+
+void				FileWatcher::Start(void)
+{
+	if (_thread.joinable())
+		return ;
+
+	_stop = false;
+
+	if (_inotifyFd != -1 && pipe(_stopPipe) == 0)
+		_thread = std::thread(&FileWatcher::WatchLoop, this);
+	else
+		_thread = std::thread(&FileWatcher::PollLoop, this);
+}
+
+void				FileWatcher::Stop(void)
+{
+	if (!_thread.joinable())
+		return ;
+
+	_stop = true;
+
+	// Wake up the watcher thread blocked in poll
+	if (_stopPipe[1] != -1 && write(_stopPipe[1], "", 1) == -1)
+		std::cerr << "Can't wake up the file watcher thread" << std::endl;
+
+	_thread.join();
+
+	for (int & fd : _stopPipe)
+	{
+		if (fd != -1)
+			close(fd);
+		fd = -1;
+	}
+}
+
+void				FileWatcher::PushChange(const std::string & file)
+{
+	std::string		change = file;
+
+	if (!_changes.Push(std::move(change)))
+		_overflow = true;
+}
+
+void				FileWatcher::WatchLoop(void)
+{
+#ifdef __linux__
+	// Aligned for the inotify_event structs, big enough for a burst of saves
+	alignas(struct inotify_event) char	buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+	struct pollfd						fds[2] = {{_inotifyFd, POLLIN, 0}, {_stopPipe[0], POLLIN, 0}};
+
+	while (!_stop)
+	{
+		if (poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+			continue ;
+
+		ssize_t size;
+		while ((size = read(_inotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			std::lock_guard< std::mutex >	lock(_mutex);
+
+			for (char * p = buffer; p < buffer + size; p += sizeof(struct inotify_event) + reinterpret_cast< struct inotify_event * >(p)->len)
+			{
+				auto	event = reinterpret_cast< struct inotify_event * >(p);
+
+				if (event->mask & IN_Q_OVERFLOW)
+					_overflow = true;
+
+				auto directory = _directories.find(event->wd);
+				if (event->len == 0 || directory == _directories.end())
+					continue ;
+
+				// Only report the watched files, not everything written in their directory
+				std::string path = directory->second + "/" + event->name;
+				for (const auto & file : _files[directory->second])
+					if (file == path)
+						PushChange(path);
+			}
+		}
+	}
+#endif
+}
+
+void				FileWatcher::PollLoop(void)
+{
+	while (!_stop)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(PollIntervalMs));
+
+		std::lock_guard< std::mutex >	lock(_mutex);
+
+		for (auto & file : _modificationTimes)
+		{
+			struct timespec	time;
+
+			if (!GetModificationTime(file.first, time))
+				continue ;
+
+			if (time.tv_sec != file.second.tv_sec || time.tv_nsec != file.second.tv_nsec)
+			{
+				file.second = time;
+				PushChange(file.first);
+			}
+		}
+	}
+}
+
+bool				FileWatcher::Poll(std::vector< std::string > & changedFiles)
+{
+	std::unordered_set< std::string >	unique(changedFiles.begin(), changedFiles.end());
+	std::string							file;
+
+	// Editors often produce several events for a single save
+	while (_changes.Pop(file))
+		if (unique.insert(file).second)
+			changedFiles.push_back(file);
+
+	return !_overflow.exchange(false);
+}
+
+std::ostream &	operator<<(std::ostream & o, FileWatcher const & r)
+{
+	o << "tostring of the class" << std::endl;
+	(void)r;
+	return (o);
+}
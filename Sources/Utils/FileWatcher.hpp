@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <time.h>
+
+#include "Utils/LockFreeQueue.tpp"
+
+namespace LWGC
+{
+	// Watch files for modifications on a background thread, the changes are pushed in a lock-free queue drained
+	// with Poll, usually once per frame. On Linux the parent directory of each file is watched with inotify so
+	// editors saving through a temporary file + rename are detected, other platforms fall back to stat polling.
+	class		FileWatcher
+	{
+		private:
+			LockFreeQueue< std::string >					_changes;
+			std::atomic< bool >								_overflow;
+			std::atomic< bool >								_stop;
+			std::thread										_thread;
+			std::mutex										_mutex;
+			// Watched files, by directory
+			std::unordered_map< std::string, std::vector< std::string > >	_files;
+			std::unordered_map< std::string, struct timespec >			_modificationTimes;
+			std::unordered_map< int, std::string >			_directories;	// inotify watch descriptor -> directory
+			int												_inotifyFd;
+			int												_stopPipe[2];
+
+			void			WatchLoop(void);
+			void			PollLoop(void);
+			void			PushChange(const std::string & file);
+
+		public:
+			static const int	PollIntervalMs = 250;
+
+			FileWatcher(size_t queueCapacity = 1024);
+			FileWatcher(const FileWatcher &) = delete;
+			virtual ~FileWatcher(void);
+
+			FileWatcher &	operator=(FileWatcher const & src) = delete;
+
+			// Can be called before or after Start, returns false if the file does not exist
+			bool			Watch(const std::string & file);
+			void			Start(void);
+			void			Stop(void);
+
+			// Append the modified files (normalized with realpath, without duplicates) to changedFiles.
+			// Returns false if events were dropped because the queue was full.
+			bool			Poll(std::vector< std::string > & changedFiles);
+
+			// Absolute path without symlinks, the key used for all the watched files
+			static std::string	NormalizePath(const std::string & path);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, FileWatcher const & r);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <utility>
+
+namespace LWGC
+{
+	// Bounded single producer / single consumer ring buffer. Push must always be called from the same thread,
+	// and Pop from another (or the same) single thread. The capacity is rounded up to a power of two.
+	template< typename T >
+	class		LockFreeQueue
+	{
+		private:
+			std::vector< T >		_slots;
+			size_t					_mask;
+			// The indices are never wrapped, only the slot access is masked. Each side keeps a copy of the
+			// other's index so it only reads the shared one (and its cache line) when the copy says full / empty.
+			alignas(64) std::atomic< size_t >	_head;	// Next slot to read, written by the consumer
+			size_t								_cachedTail;
+			alignas(64) std::atomic< size_t >	_tail;	// Next slot to write, written by the producer
+			size_t								_cachedHead;
+
+			static size_t	RoundUpPowerOfTwo(size_t value) noexcept
+			{
+				size_t result = 1;
+
+				while (result < value)
+					result <<= 1;
+				return result;
+			}
+
+		public:
+			LockFreeQueue(size_t capacity = 1024) : _slots(RoundUpPowerOfTwo(capacity)), _mask(_slots.size() - 1), _head(0), _cachedTail(0), _tail(0), _cachedHead(0) {}
+			LockFreeQueue(const LockFreeQueue &) = delete;
+			virtual ~LockFreeQueue(void) {}
+
+			LockFreeQueue &	operator=(LockFreeQueue const & src) = delete;
+
+			// Returns false when the queue is full, the value is not moved in this case
+			bool	Push(T && value) noexcept
+			{
+				size_t tail = _tail.load(std::memory_order_relaxed);
+
+				if (tail - _cachedHead == _slots.size())
+				{
+					_cachedHead = _head.load(std::memory_order_acquire);
+					if (tail - _cachedHead == _slots.size())
+						return false;
+				}
+
+				_slots[tail & _mask] = std::move(value);
+				_tail.store(tail + 1, std::memory_order_release);
+				return true;
+			}
+
+			bool	Pop(T & value) noexcept
+			{
+				size_t head = _head.load(std::memory_order_relaxed);
+
+				if (head == _cachedTail)
+				{
+					_cachedTail = _tail.load(std::memory_order_acquire);
+					if (head == _cachedTail)
+						return false;
+				}
+
+				value = std::move(_slots[head & _mask]);
+				_head.store(head + 1, std::memory_order_release);
+				return true;
+			}
+
+			bool	IsEmpty(void) const noexcept
+			{
+				return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+			}
+
+			size_t	GetCapacity(void) const noexcept { return _slots.size(); }
+	};
+
+	template< typename T >
+	std::ostream &	operator<<(std::ostream & o, LockFreeQueue<T> const & r)
+	{
+		o << "LockFreeQueue of capacity " << r.GetCapacity() << std::endl;
+		return (o);
+	}
+}
@@ -0,0 +1,67 @@
+#include "Utils/MappedFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace LWGC;
+
+MappedFile::MappedFile(void) : _fd(-1), _data(nullptr), _size(0)
+{
+}
+
+MappedFile::~MappedFile(void)
+{
+	Close();
+}
+
+bool				MappedFile::Open(const std::string & path)
+{
+	struct stat		st;
+
+	Close();
+
+	if ((_fd = open(path.c_str(), O_RDONLY)) == -1)
+		return false;
+
+	if (fstat(_fd, &st) == -1 || st.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void * data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	_data = static_cast< const uint8_t * >(data);
+	_size = st.st_size;
+
+	return true;
+}
+
+void				MappedFile::Close(void) noexcept
+{
+	if (_data != nullptr)
+		munmap(const_cast< uint8_t * >(_data), _size);
+	if (_fd != -1)
+		close(_fd);
+
+	_fd = -1;
+	_data = nullptr;
+	_size = 0;
+}
+
+bool				MappedFile::IsOpen(void) const noexcept { return _data != nullptr; }
+const uint8_t *		MappedFile::GetData(void) const noexcept { return _data; }
+size_t				MappedFile::GetSize(void) const noexcept { return _size; }
+
+std::ostream &	operator<<(std::ostream & o, MappedFile const & r)
+{
+	o << "MappedFile of " << r.GetSize() << " bytes" << std::endl;
+	return (o);
+}
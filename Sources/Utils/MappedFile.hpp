@@ -0,0 +1,33 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+namespace LWGC
+{
+	// Read-only memory mapping of a whole file, unmapped when destroyed
+	class		MappedFile
+	{
+		private:
+			int				_fd;
+			const uint8_t *	_data;
+			size_t			_size;
+
+		public:
+			MappedFile(void);
+			MappedFile(const MappedFile &) = delete;
+			virtual ~MappedFile(void);
+
+			MappedFile &	operator=(MappedFile const & src) = delete;
+
+			bool			Open(const std::string & path);
+			void			Close(void) noexcept;
+
+			bool			IsOpen(void) const noexcept;
+			const uint8_t *	GetData(void) const noexcept;
+			size_t			GetSize(void) const noexcept;
+	};
+
+	std::ostream &	operator<<(std::ostream & o, MappedFile const & r);
+}
@@ -0,0 +1,130 @@
+#include "ThreadPool.hpp"
+
+#include <atomic>
+
+using namespace LWGC;
+
+ThreadPool::ThreadPool(size_t threadCount) : _activeJobs(0), _stop(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	for (size_t i = 0; i < threadCount; i++)
+		_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool(void)
+{
+	{
+		std::lock_guard< std::mutex > lock(_mutex);
+		_stop = true;
+	}
+	_jobCondition.notify_all();
+
+	for (auto & worker : _workers)
+		worker.join();
+}
+
+void			ThreadPool::WorkerLoop(void)
+{
+	while (true)
+	{
+		std::function< void() >	job;
+
+		{
+			std::unique_lock< std::mutex > lock(_mutex);
+			_jobCondition.wait(lock, [this](){ return _stop || !_jobs.empty(); });
+
+			if (_stop && _jobs.empty())
+				return ;
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			_activeJobs++;
+		}
+
+		try {
+			job();
+		} catch (const std::exception & e) {
+			std::cerr << "Uncaught exception in thread pool job: " << e.what() << std::endl;
+		}
+
+		{
+			std::lock_guard< std::mutex > lock(_mutex);
+			_activeJobs--;
+			if (_jobs.empty() && _activeJobs == 0)
+				_idleCondition.notify_all();
+		}
+	}
+}
+
+void			ThreadPool::Enqueue(std::function< void() > job)
+{
+	{
+		std::lock_guard< std::mutex > lock(_mutex);
+		_jobs.push_back(std::move(job));
+	}
+	_jobCondition.notify_one();
+}
+
+void			ThreadPool::WaitIdle(void)
+{
+	std::unique_lock< std::mutex > lock(_mutex);
+	_idleCondition.wait(lock, [this](){ return _jobs.empty() && _activeJobs == 0; });
+}
+
+void			ThreadPool::ParallelFor(size_t count, const std::function< void(size_t) > & function)
+{
+	auto	next = std::make_shared< std::atomic< size_t > >(0);
+	auto	done = std::make_shared< std::atomic< size_t > >(0);
+	auto	error = std::make_shared< std::exception_ptr >();
+	auto	errorMutex = std::make_shared< std::mutex >();
+	size_t	helperCount = std::min(_workers.size(), count);
+	auto	work = [next, done, error, errorMutex, count, &function]()
+	{
+		for (size_t index = (*next)++; index < count; index = (*next)++)
+		{
+			try {
+				function(index);
+			} catch (...) {
+				std::lock_guard< std::mutex > lock(*errorMutex);
+				if (!*error)
+					*error = std::current_exception();
+			}
+			(*done)++;
+		}
+	};
+
+	for (size_t i = 0; i < helperCount; i++)
+		Enqueue(work);
+
+	// The calling thread also consumes indices so this can't deadlock when called from a worker
+	work();
+
+	while (*done < count)
+		std::this_thread::yield();
+
+	if (*error)
+		std::rethrow_exception(*error);
+}
+
+ThreadPool &	ThreadPool::GetShared(void)
+{
+	static ThreadPool	shared;
+
+	return shared;
+}
+
+size_t			ThreadPool::GetThreadCount(void) const noexcept { return _workers.size(); }
+
+size_t			ThreadPool::GetPendingJobCount(void)
+{
+	std::lock_guard< std::mutex > lock(_mutex);
+	return _jobs.size() + _activeJobs;
+}
+
+std::ostream &	operator<<(std::ostream & o, ThreadPool const & r)
+{
+	o << "ThreadPool with " << r.GetThreadCount() << " threads" << std::endl;
+	return (o);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace LWGC
+{
+	// Fixed set of worker threads consuming a FIFO job queue
+	class		ThreadPool
+	{
+		private:
+			std::vector< std::thread >				_workers;
+			std::deque< std::function< void() > >	_jobs;
+			std::mutex								_mutex;
+			std::condition_variable					_jobCondition;
+			std::condition_variable					_idleCondition;
+			size_t									_activeJobs;
+			bool									_stop;
+
+			void			WorkerLoop(void);
+
+		public:
+			// A thread count of 0 uses all the cores but one (left for the main thread)
+			ThreadPool(size_t threadCount = 0);
+			ThreadPool(const ThreadPool &) = delete;
+			virtual ~ThreadPool(void);
+
+			ThreadPool &	operator=(ThreadPool const & src) = delete;
+
+			void			Enqueue(std::function< void() > job);
+
+			template< typename F >
+			auto			Submit(F function) -> std::future< decltype(function()) >
+			{
+				auto task = std::make_shared< std::packaged_task< decltype(function())() > >(function);
+				auto future = task->get_future();
+
+				Enqueue([task](){ (*task)(); });
+				return future;
+			}
+
+			// Block until the queue is empty and all the workers are done
+			void			WaitIdle(void);
+			// Run function(i) for i in [0, count) on the pool and the calling thread, returns when all are done
+			void			ParallelFor(size_t count, const std::function< void(size_t) > & function);
+
+			size_t			GetThreadCount(void) const noexcept;
+			size_t			GetPendingJobCount(void);
+
+			// Pool of all the cores but one shared by the engine systems, created on first use and joined at
+			// exit once its queue is empty. ParallelFor can be called from its own jobs.
+			static ThreadPool &	GetShared(void);
+	};
+
+	std::ostream &	operator<<(std::ostream & o, ThreadPool const & r);
+}
@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <execinfo.h>
+#include <sys/stat.h>
+#include <cerrno>
 
 void LWGC::PrintCallstack(void)
 {
@@ -58,3 +60,18 @@ bool        LWGC::EndsWith(std::string const & value, std::string const & ending
     if (ending.size() > value.size()) return false;
     return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
 }
+
+bool        LWGC::CreateDirectories(const std::string & path)
+{
+    for (size_t i = 1; i <= path.size(); i++)
+    {
+        if (i != path.size() && path[i] != '/')
+            continue ;
+
+        std::string directory = path.substr(0, i);
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+    }
+
+    return true;
+}
@@ -9,4 +9,6 @@ namespace LWGC
     std::string GetFileNameWithoutExtension(const std::string & path);
     std::string GetExtension(const std::string & path);
     bool        EndsWith(std::string const & value, std::string const & ending);
+    // mkdir -p, true when the directory exists at the end
+    bool        CreateDirectories(const std::string & path);
 }
\ No newline at end of file